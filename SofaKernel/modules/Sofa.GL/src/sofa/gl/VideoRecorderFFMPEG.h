@@ -62,6 +62,10 @@ public:
     bool init(const std::string& ffmpeg_exec_filepath, const std::string& filename, int width, int height, unsigned int framerate, unsigned int bitrate, const std::string& codec="");
 
     void addFrame();
+
+    /// Encode a frame already read back from the viewport (RGBA, viewport size, bottom-up rows).
+    /// The frame is only written to the ffmpeg process, so it can be called from another thread than the OpenGL one.
+    void addFrame(const unsigned char* viewportPixels);
     void saveVideo();
     void finishVideo();
 
@@ -235,36 +235,36 @@ void MatrixLinearSolver<Matrix,Vector>::invertSystem()
 template<class Matrix, class Vector>
 bool MatrixLinearSolver<Matrix,Vector>::addJMInvJtLocal(Matrix * /*M*/,ResMatrixType * result,const JMatrixType * J, double fact)
 {
-    for (typename JMatrixType::Index row=0; row<J->rowSize(); row++)
+    // Only the non-empty lines of J need a solve: J usually has one line per constraint of the whole scene,
+    // most of them not involving the degrees of freedom of this solver.
+    const typename JMatrixType::LineConstIterator jitend = J->end();
+    for (typename JMatrixType::LineConstIterator jit1 = J->begin(); jit1 != jitend; ++jit1)
     {
+        const auto row = jit1->first;
+        if (jit1->second.empty())
+            continue;
+
         // STEP 1 : put each line of matrix Jt in the right hand term of the system
-        for (typename JMatrixType::Index i=0; i<J->colSize(); i++) currentGroup->systemRHVector->set(i,J->element(row,i)); // currentGroup->systemMatrix->rowSize()
+        for (typename JMatrixType::Index i=0; i<J->colSize(); i++) currentGroup->systemRHVector->set(i,0.0); // currentGroup->systemMatrix->rowSize()
+        for (typename JMatrixType::LElementConstIterator i1 = jit1->second.begin(), i1end = jit1->second.end(); i1 != i1end; ++i1)
+            currentGroup->systemRHVector->set(i1->first, i1->second);
 
         // STEP 2 : solve the system :
         solveSystem();
 
         // STEP 3 : project the result using matrix J
-        if (const SparseMatrix<Real> * j = dynamic_cast<const SparseMatrix<Real> * >(J))   // optimization for sparse matrix
+        for (typename JMatrixType::LineConstIterator jit = J->begin(); jit != jitend; ++jit)
         {
-            const typename SparseMatrix<Real>::LineConstIterator jitend = j->end();
-            for (typename SparseMatrix<Real>::LineConstIterator jit = j->begin(); jit != jitend; ++jit)
+            auto row2 = jit->first;
+            double acc = 0.0;
+            for (typename JMatrixType::LElementConstIterator i2 = jit->second.begin(), i2end = jit->second.end(); i2 != i2end; ++i2)
             {
-                auto row2 = jit->first;
-                double acc = 0.0;
-                for (typename SparseMatrix<Real>::LElementConstIterator i2 = jit->second.begin(), i2end = jit->second.end(); i2 != i2end; ++i2)
-                {
-                    auto col2 = i2->first;
-                    double val2 = i2->second;
-                    acc += val2 * currentGroup->systemLHVector->element(col2);
-                }
-                acc *= fact;
-                result->add(row2,row,acc);
+                auto col2 = i2->first;
+                double val2 = i2->second;
+                acc += val2 * currentGroup->systemLHVector->element(col2);
             }
-        }
-        else
-        {
-            dmsg_error("MatrixLinearSolver") << "AsyncMatrixLinearSolver::addJMInvJt is only implemented for SparseMatrix<Real>" ;
-            return false;
+            acc *= fact;
+            result->add(row2,row,acc);
         }
     }
 
@@ -110,6 +110,59 @@ TYPED_TEST(MechanicalObject_test, checkThatPositionDefaultValueIsAVectorOfValueI
     TestHelpers::CheckPosition(this->mechanicalObject);
 }
 
+TYPED_TEST(MechanicalObject_test, checkThatVMultiOpIsTheSequenceOfItsLinearCombinations)
+{
+    typedef typename TypeParam::VecCoord VecCoord;
+    typedef typename TypeParam::VecDeriv VecDeriv;
+    typedef typename TypeParam::Real Real;
+    typedef core::behavior::BaseMechanicalState::VMultiOp VMultiOp;
+    typedef core::behavior::BaseMechanicalState::VMultiOpEntry VMultiOpEntry;
+
+    // more entries than in one block of the fused operations
+    const std::size_t n = 2500;
+    this->mechanicalObject.resize(n);
+    {
+        auto x = this->mechanicalObject.writePositions();
+        auto v = this->mechanicalObject.writeVelocities();
+        auto f = this->mechanicalObject.writeForces();
+        for (std::size_t i=0; i<n; ++i)
+            for (std::size_t j=0; j<TypeParam::coord_total_size; ++j)
+            {
+                x[i][j] = Real(i + j);
+                v[i][j] = Real(1) - Real(j);
+                f[i][j] = Real(i) * Real(0.5);
+            }
+    }
+    VecCoord x = this->mechanicalObject.readPositions().ref();
+    VecDeriv v = this->mechanicalObject.readVelocities().ref();
+    const VecDeriv f = this->mechanicalObject.readForces().ref();
+
+    // v = 0.5 v + 0.25 f ; x = x + 0.125 v
+    VMultiOp ops;
+    ops.push_back(VMultiOpEntry(core::VecDerivId::velocity(), core::ConstVecDerivId::velocity(), 0.5, core::ConstVecDerivId::force(), 0.25));
+    ops.push_back(VMultiOpEntry(core::VecCoordId::position(), core::ConstVecCoordId::position(), core::ConstVecDerivId::velocity(), 0.125));
+    this->mechanicalObject.vMultiOp(core::ExecParams::defaultInstance(), ops);
+
+    for (std::size_t i=0; i<n; ++i)
+    {
+        v[i] = v[i]*Real(0.5) + f[i]*Real(0.25);
+        x[i] += v[i]*Real(0.125);
+    }
+    for (std::size_t i=0; i<n; ++i)
+    {
+        EXPECT_LE((v[i] - this->mechanicalObject.readVelocities()[i]).norm(), 1e-9);
+        EXPECT_LE((x[i] - this->mechanicalObject.readPositions()[i]).norm(), 1e-9);
+    }
+
+    // the result is also a later operand: f = v + 2 f
+    ops.clear();
+    ops.push_back(VMultiOpEntry(core::VecDerivId::force(), core::ConstVecDerivId::velocity(), core::ConstVecDerivId::force(), 2.0));
+    this->mechanicalObject.vMultiOp(core::ExecParams::defaultInstance(), ops);
+
+    for (std::size_t i=0; i<n; ++i)
+        EXPECT_LE((v[i] + f[i]*Real(2) - this->mechanicalObject.readForces()[i]).norm(), 1e-9);
+}
+
 } // namespace
 
 } // namespace sofa
@@ -139,6 +139,8 @@ public:
 
     Data< bool >  d_useTopology; ///< Shall this object rely on any active topology to initialize its size and positions
 
+    Data< bool >  d_parallelVectorOperations; ///< Split the fused vector operations (vMultiOp) of large states between the threads of the TaskScheduler
+
     Data< bool >  showObject; ///< Show objects. (default=false)
     Data< float > showObjectScale; ///< Scale for object display. (default=0.1)
     Data< bool >  showIndices; ///< Show indices. (default=false)
@@ -331,6 +333,8 @@ public:
 
     void vOp(const core::ExecParams* params, core::VecId v, core::ConstVecId a = core::ConstVecId::null(), core::ConstVecId b = core::ConstVecId::null(), SReal f=1.0) override;
 
+    /// All the linear combinations of ops are evaluated in a single pass over the vectors, block by block,
+    /// unless they do not apply to vectors of the current size (then they are done by a sequence of vOp).
     void vMultiOp(const core::ExecParams* params, const VMultiOp& ops) override;
 
     void vThreshold(core::VecId a, SReal threshold ) override;
@@ -424,6 +428,41 @@ protected :
     void setVecMatrixDeriv(unsigned int /*index*/, Data< MatrixDeriv> * /*mDeriv*/);
 
 
+    /// @}
+
+    /// @name Fused vector operations
+    /// @{
+
+    /// Operand of a fused vMultiOp: a coordinate or a derivative vector, and its factor
+    struct VMultiOpTerm
+    {
+        const Coord* coord;
+        const Deriv* deriv;
+        Real factor;
+    };
+
+    /// Operation of a fused vMultiOp: the result vector and its range of terms
+    struct VMultiOpStep
+    {
+        Data< VecCoord >* coordData;
+        Data< VecDeriv >* derivData;
+        Coord* coord;
+        Deriv* deriv;
+        std::size_t beginTerm;
+        std::size_t endTerm;
+    };
+
+    /// Apply ops in a single pass, returns false (doing nothing) if they can not be fused
+    bool vMultiOpFused(const VMultiOp& ops);
+
+    /// Apply the compiled steps on the entries [begin,end), seen as arrays of TCoord and TDeriv
+    template<class TCoord, class TDeriv>
+    void vMultiOpRun(std::size_t begin, std::size_t end) const;
+
+    /// Compiled operations of the last vMultiOp, kept to avoid reallocations
+    sofa::helper::vector< VMultiOpStep > m_vMultiOpSteps;
+    sofa::helper::vector< VMultiOpTerm > m_vMultiOpTerms;
+
     /// @}
 
     /**
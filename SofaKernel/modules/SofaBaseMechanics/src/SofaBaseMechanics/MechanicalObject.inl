@@ -31,6 +31,7 @@
 #include <sofa/defaulttype/DataTypeInfo.h>
 #include <sofa/helper/accessor.h>
 #include <sofa/simulation/Node.h>
+#include <sofa/simulation/ParallelForRange.h>
 
 #ifdef SOFA_DUMP_VISITOR_INFO
 #include <sofa/simulation/Visitor.h>
@@ -38,6 +39,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <functional>
+#include <type_traits>
 
 #ifdef SOFA_HAVE_NEW_TOPOLOGYCHANGES
 #include <SofaBaseTopology/TopologyData.inl>
@@ -66,6 +69,54 @@ void renumber(V* v, V* tmp, const sofa::helper::vector< sofa::Index > &index )
 namespace sofa::component::container
 {
 
+namespace vmultiop
+{
+
+/// Number of entries processed by all the operations of a fused vMultiOp before moving to the next ones,
+/// so that the vectors shared between the operations are still in cache
+constexpr std::size_t blockSize = 1024;
+
+/// Minimum number of scalar entries handled by each task of a parallel vMultiOp
+constexpr std::size_t minEntriesPerTask = 16384;
+
+template<class TR>
+inline void setZero(TR* r, std::size_t begin, std::size_t end)
+{
+    for (std::size_t i=begin; i<end; ++i)
+        r[i] = TR();
+}
+
+template<class TR, class Real>
+inline void scale(TR* r, Real f, std::size_t begin, std::size_t end)
+{
+    for (std::size_t i=begin; i<end; ++i)
+        r[i] *= f;
+}
+
+template<class TR, class TA, class Real>
+inline void set(TR* r, const TA* a, Real f, std::size_t begin, std::size_t end)
+{
+    if (f == Real(1))
+        for (std::size_t i=begin; i<end; ++i)
+            r[i] = a[i];
+    else
+        for (std::size_t i=begin; i<end; ++i)
+            r[i] = a[i]*f;
+}
+
+template<class TR, class TA, class Real>
+inline void add(TR* r, const TA* a, Real f, std::size_t begin, std::size_t end)
+{
+    if (f == Real(1))
+        for (std::size_t i=begin; i<end; ++i)
+            r[i] += a[i];
+    else
+        for (std::size_t i=begin; i<end; ++i)
+            r[i] += a[i]*f;
+}
+
+} // namespace vmultiop
+
 template <class DataTypes>
 MechanicalObject<DataTypes>::MechanicalObject()
     : x(initData(&x, "position", "position coordinates of the degrees of freedom"))
@@ -82,6 +133,7 @@ MechanicalObject<DataTypes>::MechanicalObject()
     , reset_velocity(initData(&reset_velocity, "reset_velocity", "reset velocity coordinates of the degrees of freedom"))
     , restScale(initData(&restScale, (SReal)1.0, "restScale", "optional scaling of rest position coordinates (to simulated pre-existing internal tension).(default = 1.0)"))
     , d_useTopology(initData(&d_useTopology, true, "useTopology", "Shall this object rely on any active topology to initialize its size and positions"))
+    , d_parallelVectorOperations(initData(&d_parallelVectorOperations, false, "parallelVectorOperations", "Split the fused vector operations (vMultiOp) of large states between the threads of the TaskScheduler"))
     , showObject(initData(&showObject, (bool) false, "showObject", "Show objects. (default=false)"))
     , showObjectScale(initData(&showObjectScale, (float) 0.1, "showObjectScale", "Scale for object display. (default=0.1)"))
     , showIndices(initData(&showIndices, (bool) false, "showIndices", "Show indices. (default=false)"))
@@ -1240,6 +1292,9 @@ void MechanicalObject<DataTypes>::init()
     if (f_reserve.getValue() > 0)
         reserve(f_reserve.getValue());
 
+    if (d_parallelVectorOperations.getValue())
+        simulation::initTaskScheduler();
+
 }
 
 template <class DataTypes>
@@ -2175,95 +2230,162 @@ void MechanicalObject<DataTypes>::vOp(const core::ExecParams* params, core::VecI
 template <class DataTypes>
 void MechanicalObject<DataTypes>::vMultiOp(const core::ExecParams* params, const VMultiOp& ops)
 {
-    // optimize common integration case: v += a*dt, x += v*dt
-    if (ops.size() == 2
-            && ops[0].second.size() == 2
-            && ops[0].first.getId(this) == ops[0].second[0].first.getId(this)
-            && ops[0].first.getId(this).type == sofa::core::V_DERIV
-            && ops[0].second[1].first.getId(this).type == sofa::core::V_DERIV
-            && ops[1].second.size() == 2
-            && ops[1].first.getId(this) == ops[1].second[0].first.getId(this)
-            && ops[0].first.getId(this) == ops[1].second[1].first.getId(this)
-            && ops[1].first.getId(this).type == sofa::core::V_COORD)
-    {
-        helper::ReadAccessor< Data<VecDeriv> > va( *this->read(core::ConstVecDerivId(ops[0].second[1].first.getId(this))) );
-        helper::WriteAccessor< Data<VecDeriv> >vv( *this->write(core::VecDerivId(ops[0].first.getId(this))) );
-        helper::WriteAccessor< Data<VecCoord> > vx( *this->write(core::VecCoordId(ops[1].first.getId(this))) );
-
-        const auto n = vx.size();
-        const Real f_v_v = (Real)(ops[0].second[0].second);
-        const Real f_v_a = (Real)(ops[0].second[1].second);
-        const Real f_x_x = (Real)(ops[1].second[0].second);
-        const Real f_x_v = (Real)(ops[1].second[1].second);
-
-        if (f_v_v == 1.0 && f_x_x == 1.0) // very common case
-        {
-            if (f_v_a == 1.0) // used by euler implicit and other integrators that directly computes a*dt
-            {
-                for (unsigned int i=0; i<n; ++i)
-                {
-                    vv[i] += va[i];
-                    vx[i] += vv[i]*f_x_v;
-                }
-            }
-            else
-            {
-                for (unsigned int i=0; i<n; ++i)
-                {
-                    vv[i] += va[i]*f_v_a;
-                    vx[i] += vv[i]*f_x_v;
-                }
-            }
+    if (!vMultiOpFused(ops))
+        Inherited::vMultiOp(params, ops);
+}
+
+template <class DataTypes>
+bool MechanicalObject<DataTypes>::vMultiOpFused(const VMultiOp& ops)
+{
+    const std::size_t n = std::size_t(d_size.getValue());
+
+    // only the valid linear combinations of vectors of the current size are fused,
+    // the others are left to the sequence of vOp (which also reports the errors)
+    const auto operandHasSize = [this, n](core::ConstVecId a)
+    {
+        if (a.type == sofa::core::V_COORD)
+            return a.index < vectorsCoord.size() && vectorsCoord[a.index] != nullptr && vectorsCoord[a.index]->getValue().size() == n;
+        if (a.type == sofa::core::V_DERIV)
+            return a.index < vectorsDeriv.size() && vectorsDeriv[a.index] != nullptr && vectorsDeriv[a.index]->getValue().size() == n;
+        return false;
+    };
+    for (const auto& op : ops)
+    {
+        const core::VecId r = op.first.getId(this);
+        if (r.isNull() || (r.type != sofa::core::V_COORD && r.type != sofa::core::V_DERIV))
+            return false;
+        const auto& operands = op.second;
+        for (std::size_t k=0; k<operands.size(); ++k)
+        {
+            const core::ConstVecId a = operands[k].first.getId(this);
+            if (a.isNull() || !operandHasSize(a))
+                return false;
+            if (k == 0 && a.type != r.type)
+                return false;
+            if (k > 0 && r.type == sofa::core::V_DERIV && a.type != sofa::core::V_DERIV)
+                return false;
+            // the result is only allowed as the first operand, where it is updated in place
+            if (k > 0 && a.type == r.type && a.index == r.index)
+                return false;
         }
-        else if (f_x_x == 1.0) // some damping is applied to v
+    }
+
+    // results are resized first, so that the operands are read from their final buffers
+    m_vMultiOpSteps.clear();
+    m_vMultiOpTerms.clear();
+    for (const auto& op : ops)
+    {
+        const core::VecId r = op.first.getId(this);
+        VMultiOpStep step { nullptr, nullptr, nullptr, nullptr, 0, 0 };
+        if (r.type == sofa::core::V_COORD)
         {
-            for (unsigned int i=0; i<n; ++i)
-            {
-                vv[i] *= f_v_v;
-                vv[i] += va[i];
-                vx[i] += vv[i]*f_x_v;
-            }
+            step.coordData = this->write(core::VecCoordId(r));
+            VecCoord& vr = *step.coordData->beginEdit();
+            vr.resize(n);
+            step.coord = vr.data();
         }
-        else // general case
+        else
         {
-            for (unsigned int i=0; i<n; ++i)
-            {
-                vv[i] *= f_v_v;
-                vv[i] += va[i]*f_v_a;
-                vx[i] *= f_x_x;
-                vx[i] += vv[i]*f_x_v;
-            }
+            step.derivData = this->write(core::VecDerivId(r));
+            VecDeriv& vr = *step.derivData->beginEdit();
+            vr.resize(n);
+            step.deriv = vr.data();
         }
+        m_vMultiOpSteps.push_back(step);
     }
-    else if(ops.size()==2 //used in the ExplicitBDF solver only (Electrophysiology)
-            && ops[0].second.size()==1
-            && ops[0].second[0].second == 1.0
-            && ops[1].second.size()==3
-            )
+    for (std::size_t s=0; s<ops.size(); ++s)
     {
-        helper::ReadAccessor< Data<VecCoord> > v11( *this->read(core::ConstVecCoordId(ops[0].second[0].first.getId(this))) );
-        helper::ReadAccessor< Data<VecCoord> > v21( *this->read(core::ConstVecCoordId(ops[1].second[0].first.getId(this))) );
-        helper::ReadAccessor< Data<VecCoord> > v22( *this->read(core::ConstVecCoordId(ops[1].second[1].first.getId(this))) );
-        helper::ReadAccessor< Data<VecDeriv> > v23( *this->read(core::ConstVecDerivId(ops[1].second[2].first.getId(this))) );
+        VMultiOpStep& step = m_vMultiOpSteps[s];
+        step.beginTerm = m_vMultiOpTerms.size();
+        for (const auto& operand : ops[s].second)
+        {
+            const core::ConstVecId a = operand.first.getId(this);
+            VMultiOpTerm term { nullptr, nullptr, (Real)operand.second };
+            if (a.type == sofa::core::V_COORD)
+                term.coord = this->read(core::ConstVecCoordId(a))->getValue().data();
+            else
+                term.deriv = this->read(core::ConstVecDerivId(a))->getValue().data();
+            m_vMultiOpTerms.push_back(term);
+        }
+        step.endTerm = m_vMultiOpTerms.size();
+    }
 
-        helper::WriteAccessor< Data<VecCoord> > previousPos( *this->write(core::VecCoordId(ops[0].first.getId(this))) );
-        helper::WriteAccessor< Data<VecCoord> > newPos( *this->write(core::VecCoordId(ops[1].first.getId(this))) );
+    // vectors of plain scalars are processed as flat arrays, which the compiler vectorizes
+    constexpr bool flat = std::is_same<Coord, Deriv>::value && sizeof(Coord) == sizeof(Real) * DataTypes::coord_total_size;
+    const std::size_t nbEntries = flat ? n * DataTypes::coord_total_size : n;
+    const std::function<void(std::size_t,std::size_t)> run = [this](std::size_t begin, std::size_t end)
+    {
+        if constexpr (flat)
+            vMultiOpRun<Real, Real>(begin, end);
+        else
+            vMultiOpRun<Coord, Deriv>(begin, end);
+    };
+
+    // the minimum size of the tasks is given in scalars
+    simulation::TaskScheduler* taskScheduler = d_parallelVectorOperations.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    const std::size_t minEntriesPerTask = flat ? vmultiop::minEntriesPerTask : vmultiop::minEntriesPerTask / DataTypes::deriv_total_size;
+    simulation::parallelForRange(taskScheduler, 0, nbEntries, minEntriesPerTask, run);
 
-        const auto n = v11.size();
-        const Real f_1 = (Real)(ops[1].second[0].second);
-        const Real f_2 = (Real)(ops[1].second[1].second);
-        const Real f_3 = (Real)(ops[1].second[2].second);
+    for (const VMultiOpStep& step : m_vMultiOpSteps)
+    {
+        if (step.coordData)
+            step.coordData->endEdit();
+        else
+            step.derivData->endEdit();
+    }
+    return true;
+}
 
-        for (unsigned int i=0; i<n; ++i)
+template <class DataTypes>
+template <class TCoord, class TDeriv>
+void MechanicalObject<DataTypes>::vMultiOpRun(std::size_t begin, std::size_t end) const
+{
+    for (std::size_t blockBegin = begin; blockBegin < end; blockBegin += vmultiop::blockSize)
+    {
+        const std::size_t blockEnd = std::min(end, blockBegin + vmultiop::blockSize);
+        for (const VMultiOpStep& step : m_vMultiOpSteps)
         {
-            previousPos[i] = v11[i];
-            newPos[i]  = v21[i]*f_1;
-            newPos[i] += v22[i]*f_2;
-            newPos[i] += v23[i]*f_3;
+            const VMultiOpTerm* term = m_vMultiOpTerms.data() + step.beginTerm;
+            const VMultiOpTerm* termEnd = m_vMultiOpTerms.data() + step.endTerm;
+            if (step.coordData)
+            {
+                TCoord* r = reinterpret_cast<TCoord*>(step.coord);
+                if (term == termEnd)
+                {
+                    vmultiop::setZero(r, blockBegin, blockEnd);
+                    continue;
+                }
+                const TCoord* first = reinterpret_cast<const TCoord*>(term->coord);
+                if (first != r)
+                    vmultiop::set(r, first, term->factor, blockBegin, blockEnd);
+                else if (term->factor != Real(1))
+                    vmultiop::scale(r, term->factor, blockBegin, blockEnd);
+                for (++term; term != termEnd; ++term)
+                {
+                    if (term->coord)
+                        vmultiop::add(r, reinterpret_cast<const TCoord*>(term->coord), term->factor, blockBegin, blockEnd);
+                    else
+                        vmultiop::add(r, reinterpret_cast<const TDeriv*>(term->deriv), term->factor, blockBegin, blockEnd);
+                }
+            }
+            else
+            {
+                TDeriv* r = reinterpret_cast<TDeriv*>(step.deriv);
+                if (term == termEnd)
+                {
+                    vmultiop::setZero(r, blockBegin, blockEnd);
+                    continue;
+                }
+                const TDeriv* first = reinterpret_cast<const TDeriv*>(term->deriv);
+                if (first != r)
+                    vmultiop::set(r, first, term->factor, blockBegin, blockEnd);
+                else if (term->factor != Real(1))
+                    vmultiop::scale(r, term->factor, blockBegin, blockEnd);
+                for (++term; term != termEnd; ++term)
+                    vmultiop::add(r, reinterpret_cast<const TDeriv*>(term->deriv), term->factor, blockBegin, blockEnd);
+            }
         }
     }
-    else // no optimization for now for other cases
-        Inherited::vMultiOp(params, ops);
 }
 
 template <class T> inline void clear( T& t )
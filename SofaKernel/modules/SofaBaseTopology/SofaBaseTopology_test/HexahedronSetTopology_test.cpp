@@ -159,7 +159,7 @@ bool HexahedronSetTopology_test::testQuadBuffers()
     }
 
     // create and check quads
-    const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundQuad >& elemAroundQuads = topoCon->getHexahedraAroundQuadArray();
+    const HexahedronSetTopologyContainer::HexahedraShells& elemAroundQuads = topoCon->getHexahedraAroundQuadArray();
 
     // check only the quad buffer size: Full test on quads are done in QuadSetTopology_test
     EXPECT_EQ(topoCon->getNumberOfQuads(), nbrQuad);
@@ -257,7 +257,7 @@ bool HexahedronSetTopology_test::testEdgeBuffers()
     }
 
     // create and check edges
-    const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundEdge >& elemAroundEdges = topoCon->getHexahedraAroundEdgeArray();
+    const HexahedronSetTopologyContainer::HexahedraShells& elemAroundEdges = topoCon->getHexahedraAroundEdgeArray();
         
     // check only the edge buffer size: Full test on edges are done in EdgeSetTopology_test
     EXPECT_EQ(topoCon->getNumberOfEdges(), nbrEdge);
@@ -352,7 +352,7 @@ bool HexahedronSetTopology_test::testVertexBuffers()
     }
 
     // create and check vertex buffer
-    const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundVertex >& elemAroundVertices = topoCon->getHexahedraAroundVertexArray();
+    const HexahedronSetTopologyContainer::HexahedraShells& elemAroundVertices = topoCon->getHexahedraAroundVertexArray();
 
     //// check only the vertex buffer size: Full test on vertics are done in PointSetTopology_test
     EXPECT_EQ(topoCon->d_initPoints.getValue().size(), nbrVertex);
@@ -128,18 +128,18 @@ bool MeshTopology_test::testHexahedronTopology()
 
 
     //// create and get cross elements buffers
-    const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundQuad >& hexahedraAroundQuad1 = topoCon->getHexahedraAroundQuadArray();
+    const HexahedronSetTopologyContainer::HexahedraShells& hexahedraAroundQuad1 = topoCon->getHexahedraAroundQuadArray();
     const sofa::helper::vector< HexahedronSetTopologyContainer::QuadsInHexahedron > & trianglesInHexahedron1 = topoCon->getQuadsInHexahedronArray();
-    const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundEdge >& hexahedraAroundEdge1 = topoCon->getHexahedraAroundEdgeArray();
+    const HexahedronSetTopologyContainer::HexahedraShells& hexahedraAroundEdge1 = topoCon->getHexahedraAroundEdgeArray();
     const sofa::helper::vector< HexahedronSetTopologyContainer::EdgesInHexahedron > & edgesInHexahedron1 = topoCon->getEdgesInHexahedronArray();
-    const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundVertex >& hexahedraAroundVertex1 = topoCon->getHexahedraAroundVertexArray();
+    const HexahedronSetTopologyContainer::HexahedraShells& hexahedraAroundVertex1 = topoCon->getHexahedraAroundVertexArray();
     const HexahedronSetTopologyContainer::SeqEdges& edges1 = topoCon->getEdges();
 
-    const sofa::helper::vector< BaseMeshTopology::HexahedraAroundQuad > &hexahedraAroundQuad2 = topo->getHexahedraAroundQuadArray();
+    const MeshTopology::HexahedraShells& hexahedraAroundQuad2 = topo->getHexahedraAroundQuadArray();
     const sofa::helper::vector< BaseMeshTopology::QuadsInHexahedron > &trianglesInHexahedron2 = topo->getQuadsInHexahedronArray();
-    const sofa::helper::vector< BaseMeshTopology::HexahedraAroundEdge >& hexahedraAroundEdge2 = topo->getHexahedraAroundEdgeArray();
+    const MeshTopology::HexahedraShells& hexahedraAroundEdge2 = topo->getHexahedraAroundEdgeArray();
     const sofa::helper::vector< BaseMeshTopology::EdgesInHexahedron >& edgesInHexahedron2 = topo->getEdgesInHexahedronArray();
-    const sofa::helper::vector< BaseMeshTopology::HexahedraAroundVertex >& hexahedraAroundVertex2 = topo->getHexahedraAroundVertexArray();
+    const MeshTopology::HexahedraShells& hexahedraAroundVertex2 = topo->getHexahedraAroundVertexArray();
     const BaseMeshTopology::SeqEdges& edges2 = topo->getEdges();
 
     // check all buffers size
@@ -242,18 +242,18 @@ bool MeshTopology_test::testTetrahedronTopology()
 
 
     //// create and get cross elements buffers
-    const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundTriangle >& tetrahedraAroundTriangle1 = topoCon->getTetrahedraAroundTriangleArray();
+    const TetrahedronSetTopologyContainer::TetrahedraShells& tetrahedraAroundTriangle1 = topoCon->getTetrahedraAroundTriangleArray();
     const sofa::helper::vector< TetrahedronSetTopologyContainer::TrianglesInTetrahedron > & trianglesInTetrahedron1 = topoCon->getTrianglesInTetrahedronArray();
-    const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundEdge >& tetrahedraAroundEdge1 = topoCon->getTetrahedraAroundEdgeArray();
+    const TetrahedronSetTopologyContainer::TetrahedraShells& tetrahedraAroundEdge1 = topoCon->getTetrahedraAroundEdgeArray();
     const sofa::helper::vector< TetrahedronSetTopologyContainer::EdgesInTetrahedron > & edgesInTetrahedron1 = topoCon->getEdgesInTetrahedronArray();
-    const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundVertex >& tetrahedraAroundVertex1 = topoCon->getTetrahedraAroundVertexArray();
+    const TetrahedronSetTopologyContainer::TetrahedraShells& tetrahedraAroundVertex1 = topoCon->getTetrahedraAroundVertexArray();
     const TetrahedronSetTopologyContainer::SeqEdges& edges1 = topoCon->getEdges();
 
-    const sofa::helper::vector< BaseMeshTopology::TetrahedraAroundTriangle > &tetrahedraAroundTriangle2 = topo->getTetrahedraAroundTriangleArray();
+    const MeshTopology::TetrahedraShells& tetrahedraAroundTriangle2 = topo->getTetrahedraAroundTriangleArray();
     const sofa::helper::vector< BaseMeshTopology::TrianglesInTetrahedron > &trianglesInTetrahedron2 = topo->getTrianglesInTetrahedronArray();
-    const sofa::helper::vector< BaseMeshTopology::TetrahedraAroundEdge >& tetrahedraAroundEdge2 = topo->getTetrahedraAroundEdgeArray();
+    const MeshTopology::TetrahedraShells& tetrahedraAroundEdge2 = topo->getTetrahedraAroundEdgeArray();
     const sofa::helper::vector< BaseMeshTopology::EdgesInTetrahedron >& edgesInTetrahedron2 = topo->getEdgesInTetrahedronArray();
-    const sofa::helper::vector< BaseMeshTopology::TetrahedraAroundVertex >& tetrahedraAroundVertex2 = topo->getTetrahedraAroundVertexArray();    
+    const MeshTopology::TetrahedraShells& tetrahedraAroundVertex2 = topo->getTetrahedraAroundVertexArray();    
     const BaseMeshTopology::SeqEdges& edges2 = topo->getEdges();
 
     // check all buffers size
@@ -161,7 +161,7 @@ bool TetrahedronSetTopology_test::testTriangleBuffers()
     }
 
     // create and check triangles
-    const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundTriangle >& elemAroundTriangles = topoCon->getTetrahedraAroundTriangleArray();
+    const TetrahedronSetTopologyContainer::TetrahedraShells& elemAroundTriangles = topoCon->getTetrahedraAroundTriangleArray();
 
     // check only the triangle buffer size: Full test on triangles are done in TriangleSetTopology_test
     EXPECT_EQ(topoCon->getNumberOfTriangles(), nbrTriangle);
@@ -257,7 +257,7 @@ bool TetrahedronSetTopology_test::testEdgeBuffers()
     }
 
     // create and check edges
-    const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundEdge >& elemAroundEdges = topoCon->getTetrahedraAroundEdgeArray();
+    const TetrahedronSetTopologyContainer::TetrahedraShells& elemAroundEdges = topoCon->getTetrahedraAroundEdgeArray();
         
     // check only the edge buffer size: Full test on edges are done in EdgeSetTopology_test
     EXPECT_EQ(topoCon->getNumberOfEdges(), nbrEdge);
@@ -354,7 +354,7 @@ bool TetrahedronSetTopology_test::testVertexBuffers()
     }
 
     // create and check vertex buffer
-    const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundVertex >& elemAroundVertices = topoCon->getTetrahedraAroundVertexArray();
+    const TetrahedronSetTopologyContainer::TetrahedraShells& elemAroundVertices = topoCon->getTetrahedraAroundVertexArray();
 
     //// check only the vertex buffer size: Full test on vertics are done in PointSetTopology_test
     EXPECT_EQ(topoCon->d_initPoints.getValue().size(), nbrVertex);
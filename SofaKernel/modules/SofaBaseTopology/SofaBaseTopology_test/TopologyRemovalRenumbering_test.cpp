@@ -0,0 +1,166 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <sofa/testing/BaseTest.h>
+#include <SofaBaseTopology/TopologyRemovalRenumbering.h>
+#include <SofaBaseTopology/TopologySparseData.inl>
+#include <SofaBaseTopology/TriangleSetTopologyContainer.h>
+
+using namespace sofa::component::topology;
+using namespace sofa::testing;
+
+
+class TopologyRemovalRenumbering_test : public BaseTest
+{
+public:
+    /// Removal by successive swaps with the last element, as done by the topology modifiers
+    sofa::helper::vector<int> removeBySwaps(sofa::helper::vector<int> values, const sofa::helper::vector<sofa::Index>& indices)
+    {
+        sofa::Index last = sofa::Index(values.size() - 1);
+        for (const sofa::Index i : indices)
+        {
+            std::swap(values[i], values[last]);
+            --last;
+        }
+        values.resize(values.size() - indices.size());
+        return values;
+    }
+
+    void testRemoval(std::size_t nbElements, const sofa::helper::vector<sofa::Index>& indices)
+    {
+        sofa::helper::vector<int> values(nbElements);
+        for (std::size_t i = 0; i < nbElements; ++i)
+            values[i] = int(i);
+
+        RemovalRenumbering renumbering;
+        renumbering.compute(nbElements, indices);
+        EXPECT_EQ(nbElements - indices.size(), renumbering.getNewSize());
+
+        // the removed elements are the ones found at the removed indices during the successive swaps
+        sofa::helper::vector<int> current = values;
+        sofa::Index last = sofa::Index(nbElements - 1);
+        for (std::size_t i = 0; i < indices.size(); ++i)
+        {
+            EXPECT_EQ(sofa::Index(current[indices[i]]), renumbering.getRemovedElements()[i]);
+            std::swap(current[indices[i]], current[last]);
+            --last;
+        }
+
+        sofa::helper::vector<int> result = values;
+        renumbering.apply(result);
+        EXPECT_EQ(removeBySwaps(values, indices), result);
+
+        // each element is found at its new index, or is one of the removed elements
+        for (std::size_t i = 0; i < nbElements; ++i)
+        {
+            const sofa::Index newIndex = renumbering.getNewIndex(sofa::Index(i));
+            if (newIndex == sofa::InvalidID)
+            {
+                const auto& removed = renumbering.getRemovedElements();
+                EXPECT_NE(removed.end(), std::find(removed.begin(), removed.end(), sofa::Index(i)));
+            }
+            else
+            {
+                ASSERT_LT(newIndex, result.size());
+                EXPECT_EQ(int(i), result[newIndex]);
+            }
+        }
+    }
+};
+
+
+/// Handler recording the calls made during a removal
+class RecordingSparseDataHandler : public TopologyDataHandler<sofa::core::topology::BaseMeshTopology::Triangle, sofa::helper::vector<int> >
+{
+public:
+    using Inherit = TopologyDataHandler<sofa::core::topology::BaseMeshTopology::Triangle, sofa::helper::vector<int> >;
+    using Inherit::Inherit;
+
+    void applyDestroyFunction(sofa::Index, int& value) override { destroyedValues.push_back(value); }
+    void applyRemovalRenumbering(const RemovalRenumbering& renumbering) override { newSize = renumbering.getNewSize(); }
+
+    sofa::helper::vector<int> destroyedValues;
+    std::size_t newSize { 0 };
+};
+
+
+/// Component owning a sparse data on the triangles
+class TriangleSparseDataOwner : public sofa::core::objectmodel::BaseObject
+{
+public:
+    SOFA_CLASS(TriangleSparseDataOwner, sofa::core::objectmodel::BaseObject);
+
+    TriangleSparseData< sofa::helper::vector<int> > d_values;
+
+protected:
+    TriangleSparseDataOwner()
+        : d_values(initData(&d_values, "values", "values on some triangles"))
+    {}
+};
+
+
+TEST_F(TopologyRemovalRenumbering_test, removeNothing)
+{
+    testRemoval(10, {});
+}
+
+TEST_F(TopologyRemovalRenumbering_test, removeAll)
+{
+    testRemoval(4, {0, 0, 0, 0});
+    testRemoval(4, {3, 2, 1, 0});
+}
+
+TEST_F(TopologyRemovalRenumbering_test, removeSortedIndices)
+{
+    testRemoval(20, {18, 12, 7, 3, 0});
+}
+
+TEST_F(TopologyRemovalRenumbering_test, removeUnsortedIndices)
+{
+    // some indices refer to elements moved by the previous removals
+    testRemoval(20, {2, 5, 17, 2, 0, 14, 3});
+    testRemoval(8, {7, 0, 0, 4, 1});
+}
+
+TEST_F(TopologyRemovalRenumbering_test, sparseDataRemoval)
+{
+    const auto topology = sofa::core::objectmodel::New<TriangleSetTopologyContainer>();
+    topology->setNbPoints(8);
+    for (sofa::Index i = 0; i < 6; ++i)
+        topology->addTriangle(i, i + 1, i + 2);
+    topology->init();
+
+    const auto owner = sofa::core::objectmodel::New<TriangleSparseDataOwner>();
+    TriangleSparseData< sofa::helper::vector<int> >& sparseData = owner->d_values;
+    RecordingSparseDataHandler handler(&sparseData, topology.get());
+    sparseData.createTopologyHandler(topology.get(), &handler);
+    sparseData.setValue({10, 30, 50});
+    sparseData.setMap2Elements({1, 3, 5});
+
+    // triangle 5 takes the place of triangle 1, then triangle 4 the place of triangle 0
+    sparseData.remove({1, 0});
+
+    EXPECT_EQ(sofa::helper::vector<int>({30, 50}), sparseData.getValue());
+    EXPECT_EQ(sofa::helper::vector<sofa::Index>({3, 1}), sparseData.getMap2Elements());
+    EXPECT_EQ(sofa::helper::vector<int>({10}), handler.destroyedValues);
+    EXPECT_EQ(4u, handler.newSize);
+}
@@ -0,0 +1,122 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <sofa/testing/BaseTest.h>
+#include <SofaBaseTopology/TopologyShellBuilder.h>
+#include <sofa/core/topology/Topology.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+using namespace sofa::component::topology;
+using namespace sofa::testing;
+using sofa::core::topology::Topology;
+
+
+class TopologyShellBuilder_test : public BaseTest
+{
+public:
+    using Tetrahedron = Topology::Tetrahedron;
+    using TetrahedronID = Topology::TetrahedronID;
+    using Shells = sofa::helper::vector< sofa::helper::vector<TetrahedronID> >;
+    using FlatShells = sofa::core::topology::ElementShells<TetrahedronID>;
+
+    /// Pseudo-random tetrahedra, some vertices being shared by many elements
+    sofa::helper::vector<Tetrahedron> createTetrahedra(std::size_t nbTetrahedra, std::size_t nbPoints)
+    {
+        sofa::helper::vector<Tetrahedron> tetrahedra(nbTetrahedra);
+        unsigned int seed = 12345;
+        for (auto& t : tetrahedra)
+        {
+            for (std::size_t j = 0; j < 4; ++j)
+            {
+                seed = seed * 1103515245u + 12345u;
+                t[j] = sofa::Index((seed >> 8) % nbPoints);
+            }
+        }
+        return tetrahedra;
+    }
+
+    /// Shells built by successive insertions, as done by the topology modifiers
+    Shells createReferenceShells(const sofa::helper::vector<Tetrahedron>& tetrahedra, std::size_t nbPoints)
+    {
+        Shells shells(nbPoints);
+        for (std::size_t i = 0; i < tetrahedra.size(); ++i)
+            for (std::size_t j = 0; j < 4; ++j)
+                shells[tetrahedra[i][j]].push_back(TetrahedronID(i));
+        return shells;
+    }
+
+    void testShells(std::size_t nbTetrahedra, std::size_t nbPoints)
+    {
+        const auto tetrahedra = createTetrahedra(nbTetrahedra, nbPoints);
+
+        Shells shells(3); // previous content must be discarded
+        shells[0].push_back(0);
+        buildElementShells(tetrahedra, nbPoints, shells);
+
+        EXPECT_EQ(createReferenceShells(tetrahedra, nbPoints), shells);
+        for (const auto& shell : shells)
+            EXPECT_EQ(shell.size(), shell.capacity());
+
+        FlatShells flatShells;
+        flatShells.resize(3);
+        flatShells[0].push_back(0);
+        buildElementShells(tetrahedra, nbPoints, flatShells);
+
+        ASSERT_EQ(flatShells.size(), nbPoints);
+        EXPECT_EQ(flatShells.getNbIndices(), 4 * nbTetrahedra);
+        EXPECT_EQ(flatShells.getIndicesCapacity(), 4 * nbTetrahedra);
+        const FlatShells& constFlatShells = flatShells;
+        for (std::size_t v = 0; v < nbPoints; ++v)
+            EXPECT_EQ(constFlatShells[v], shells[v]);
+    }
+};
+
+
+TEST_F(TopologyShellBuilder_test, emptyElements)
+{
+    TopologyShellBuilder_test::Shells shells;
+    buildElementShells(sofa::helper::vector<Tetrahedron>(), 5, shells);
+    ASSERT_EQ(shells.size(), 5u);
+    for (const auto& shell : shells)
+        EXPECT_TRUE(shell.empty());
+
+    TopologyShellBuilder_test::FlatShells flatShells;
+    buildElementShells(sofa::helper::vector<Tetrahedron>(), 5, flatShells);
+    ASSERT_EQ(flatShells.size(), 5u);
+    for (std::size_t v = 0; v < 5; ++v)
+        EXPECT_TRUE(flatShells[v].empty());
+}
+
+TEST_F(TopologyShellBuilder_test, serialShells)
+{
+    testShells(1000, 300);
+}
+
+TEST_F(TopologyShellBuilder_test, parallelShells)
+{
+    sofa::simulation::TaskScheduler* taskScheduler = sofa::simulation::TaskScheduler::getInstance();
+    taskScheduler->init(4);
+
+    // enough incidences to be processed in parallel
+    testShells(shellbuilder::minParallelIncidences, 20000);
+    testShells(shellbuilder::minParallelIncidences / 2 + 1, 7);
+}
@@ -20,6 +20,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseTopology/HexahedronSetTopologyContainer.h>
+#include <SofaBaseTopology/TopologyShellBuilder.h>
 #include <sofa/core/topology/Topology.h>
 #include <sofa/core/topology/TopologyHandler.h>
 
@@ -412,16 +413,7 @@ void HexahedronSetTopologyContainer::createHexahedraAroundVertexArray()
     if (getNbPoints() == 0) // in case only Data have been copied and not going thourgh AddTriangle methods.
         this->setNbPoints(Size(d_initPoints.getValue().size()));
 
-    m_hexahedraAroundVertex.resize( getNbPoints() );
-    helper::ReadAccessor< Data< sofa::helper::vector<Hexahedron> > > m_hexahedron = d_hexahedron;
-
-    for(size_t i=0; i<m_hexahedron.size(); ++i)
-    {
-        HexahedronID hexaID = (HexahedronID)i;
-        // adding vertex i in the vertex shell
-        for(unsigned int j=0; j<8; ++j)
-            m_hexahedraAroundVertex[ m_hexahedron[i][j]  ].push_back(hexaID);
-    }
+    buildElementShells(d_hexahedron.getValue(), getNbPoints(), m_hexahedraAroundVertex);
 }
 
 void HexahedronSetTopologyContainer::createHexahedraAroundEdgeArray ()
@@ -431,16 +423,7 @@ void HexahedronSetTopologyContainer::createHexahedraAroundEdgeArray ()
     if(!hasEdgesInHexahedron())
         createEdgesInHexahedronArray();
 
-    m_hexahedraAroundEdge.resize(getNumberOfEdges());
-    for(size_t i=0; i<getNumberOfHexahedra(); ++i)
-    {
-        HexahedronID hexaID = (HexahedronID)i;
-        // adding edge i in the edge shell
-        for(unsigned int j=0; j<12; ++j)
-        {
-            m_hexahedraAroundEdge[ m_edgesInHexahedron[i][j] ].push_back(hexaID);
-        }
-    }
+    buildElementShells(m_edgesInHexahedron, getNumberOfEdges(), m_hexahedraAroundEdge);
 }
 
 void HexahedronSetTopologyContainer::createHexahedraAroundQuadArray()
@@ -450,16 +433,7 @@ void HexahedronSetTopologyContainer::createHexahedraAroundQuadArray()
     if(!hasQuadsInHexahedron())
         createQuadsInHexahedronArray();
 
-    m_hexahedraAroundQuad.resize( getNumberOfQuads());
-    for(size_t i=0; i<getNumberOfHexahedra(); ++i)
-    {
-        HexahedronID hexaID = (HexahedronID)i;
-        // adding quad i in the edge shell of both points
-        for(unsigned int j=0; j<6; ++j)
-        {
-            m_hexahedraAroundQuad[ m_quadsInHexahedron[i][j] ].push_back(hexaID);
-        }
-    }
+    buildElementShells(m_quadsInHexahedron, getNumberOfQuads(), m_hexahedraAroundQuad);
 }
 
 const sofa::helper::vector<HexahedronSetTopologyContainer::Hexahedron> &HexahedronSetTopologyContainer::getHexahedronArray()
@@ -559,17 +533,17 @@ Size HexahedronSetTopologyContainer::getNumberOfElements() const
 }
 
 
-const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundVertex > &HexahedronSetTopologyContainer::getHexahedraAroundVertexArray()
+const HexahedronSetTopologyContainer::HexahedraShells& HexahedronSetTopologyContainer::getHexahedraAroundVertexArray()
 {
     return m_hexahedraAroundVertex;
 }
 
-const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundEdge > &HexahedronSetTopologyContainer::getHexahedraAroundEdgeArray()
+const HexahedronSetTopologyContainer::HexahedraShells& HexahedronSetTopologyContainer::getHexahedraAroundEdgeArray()
 {
     return m_hexahedraAroundEdge;
 }
 
-const sofa::helper::vector< HexahedronSetTopologyContainer::HexahedraAroundQuad > &HexahedronSetTopologyContainer::getHexahedraAroundQuadArray()
+const HexahedronSetTopologyContainer::HexahedraShells& HexahedronSetTopologyContainer::getHexahedraAroundQuadArray()
 {
     return m_hexahedraAroundQuad;
 }
@@ -654,28 +628,28 @@ const sofa::helper::vector< QuadSetTopologyContainer::QuadsInHexahedron> &Hexahe
     return m_quadsInHexahedron;
 }
 
-const HexahedronSetTopologyContainer::HexahedraAroundVertex &HexahedronSetTopologyContainer::getHexahedraAroundVertex(PointID id)
+HexahedronSetTopologyContainer::HexahedraAroundVertex HexahedronSetTopologyContainer::getHexahedraAroundVertex(PointID id)
 {
     if (id < m_hexahedraAroundVertex.size())
         return m_hexahedraAroundVertex[id];
 
-    return InvalidSet;
+    return HexahedraAroundVertex(InvalidSet);
 }
 
-const HexahedronSetTopologyContainer::HexahedraAroundEdge &HexahedronSetTopologyContainer::getHexahedraAroundEdge(EdgeID id)
+HexahedronSetTopologyContainer::HexahedraAroundEdge HexahedronSetTopologyContainer::getHexahedraAroundEdge(EdgeID id)
 {
     if (id < m_hexahedraAroundEdge.size())
         return m_hexahedraAroundEdge[id];
 
-    return InvalidSet;
+    return HexahedraAroundEdge(InvalidSet);
 }
 
-const HexahedronSetTopologyContainer::HexahedraAroundQuad &HexahedronSetTopologyContainer::getHexahedraAroundQuad(QuadID id)
+HexahedronSetTopologyContainer::HexahedraAroundQuad HexahedronSetTopologyContainer::getHexahedraAroundQuad(QuadID id)
 {
     if (id < m_hexahedraAroundQuad.size())
         return m_hexahedraAroundQuad[id];
 
-    return InvalidSet;
+    return HexahedraAroundQuad(InvalidSet);
 }
 
 const QuadSetTopologyContainer::EdgesInHexahedron &HexahedronSetTopologyContainer::getEdgesInHexahedron(HexaID id)
@@ -766,7 +740,7 @@ int HexahedronSetTopologyContainer::getQuadIndexInHexahedron(const QuadsInHexahe
         return -1;
 }
 
-HexahedronSetTopologyContainer::HexahedraAroundEdge &HexahedronSetTopologyContainer::getHexahedraAroundEdgeForModification(const EdgeID i)
+HexahedronSetTopologyContainer::HexahedraShells::Shell HexahedronSetTopologyContainer::getHexahedraAroundEdgeForModification(const EdgeID i)
 {
     if(!hasHexahedraAroundEdge())
     {
@@ -780,7 +754,7 @@ HexahedronSetTopologyContainer::HexahedraAroundEdge &HexahedronSetTopologyContai
     return m_hexahedraAroundEdge[i];
 }
 
-HexahedronSetTopologyContainer::HexahedraAroundVertex &HexahedronSetTopologyContainer::getHexahedraAroundVertexForModification(const PointID i)
+HexahedronSetTopologyContainer::HexahedraShells::Shell HexahedronSetTopologyContainer::getHexahedraAroundVertexForModification(const PointID i)
 {
     if(!hasHexahedraAroundVertex())
     {
@@ -794,7 +768,7 @@ HexahedronSetTopologyContainer::HexahedraAroundVertex &HexahedronSetTopologyCont
     return m_hexahedraAroundVertex[i];
 }
 
-HexahedronSetTopologyContainer::HexahedraAroundQuad &HexahedronSetTopologyContainer::getHexahedraAroundQuadForModification(const QuadID i)
+HexahedronSetTopologyContainer::HexahedraShells::Shell HexahedronSetTopologyContainer::getHexahedraAroundQuadForModification(const QuadID i)
 {
     if(!hasHexahedraAroundQuad())
     {
@@ -821,7 +795,7 @@ bool HexahedronSetTopologyContainer::checkTopology() const
 	{
 		for (size_t i = 0; i < m_hexahedraAroundVertex.size(); ++i)
 		{
-			const sofa::helper::vector<HexahedronID> &tvs = m_hexahedraAroundVertex[i];
+			const HexahedraAroundVertex tvs = m_hexahedraAroundVertex[i];
 			for (size_t j = 0; j < tvs.size(); ++j)
 			{
 				bool check_hexa_vertex_shell = (m_hexahedron[tvs[j]][0] == i)
@@ -846,7 +820,7 @@ bool HexahedronSetTopologyContainer::checkTopology() const
 	{
 		for (size_t i = 0; i < m_hexahedraAroundEdge.size(); ++i)
 		{
-			const sofa::helper::vector<HexahedronID> &tes = m_hexahedraAroundEdge[i];
+			const HexahedraAroundEdge tes = m_hexahedraAroundEdge[i];
 			for (size_t j = 0; j < tes.size(); ++j)
 			{
 				bool check_hexa_edge_shell = (m_edgesInHexahedron[tes[j]][0] == i)
@@ -874,7 +848,7 @@ bool HexahedronSetTopologyContainer::checkTopology() const
 	{
 		for (size_t i = 0; i < m_hexahedraAroundQuad.size(); ++i)
 		{
-			const sofa::helper::vector<HexahedronID> &tes = m_hexahedraAroundQuad[i];
+			const HexahedraAroundQuad tes = m_hexahedraAroundQuad[i];
 			for (size_t j = 0; j < tes.size(); ++j)
 			{
 				bool check_hexa_quad_shell = (m_quadsInHexahedron[tes[j]][0] == i)
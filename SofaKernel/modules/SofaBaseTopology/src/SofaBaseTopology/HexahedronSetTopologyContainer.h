@@ -71,6 +71,7 @@ public:
     typedef core::topology::BaseMeshTopology::HexahedraAroundVertex		HexahedraAroundVertex;
     typedef core::topology::BaseMeshTopology::HexahedraAroundEdge		HexahedraAroundEdge;
     typedef core::topology::BaseMeshTopology::HexahedraAroundQuad		HexahedraAroundQuad;
+    typedef core::topology::ElementShells<HexaID>				HexahedraShells;
     typedef core::topology::BaseMeshTopology::EdgesInHexahedron		   EdgesInHexahedron;
     typedef core::topology::BaseMeshTopology::QuadsInHexahedron		   QuadsInHexahedron;
 
@@ -153,7 +154,7 @@ public:
      * @param i The index of a vertex.
      * @return A HexahedraAroundVertex containing the indices of the hexahedra this vertex belongs to.
      */
-    const HexahedraAroundVertex& getHexahedraAroundVertex(PointID id) override;
+    HexahedraAroundVertex getHexahedraAroundVertex(PointID id) override;
 
 
     /** \brief Get the hexahedra around an edge.
@@ -161,7 +162,7 @@ public:
      * @param i The index of an edge.
      * @return A HexahedraAroundEdge containing the indices of the hexahedra this edge belongs to.
      */
-    const HexahedraAroundEdge& getHexahedraAroundEdge(EdgeID id) override;
+    HexahedraAroundEdge getHexahedraAroundEdge(EdgeID id) override;
 
 
     /** \brief Get the hexahedra around a quad.
@@ -169,7 +170,7 @@ public:
      * @param i The index of a quad.
      * @return A HexahedraAroundQuad containing the indices of the hexahedra this quad belongs to.
      */
-    const HexahedraAroundQuad& getHexahedraAroundQuad(QuadID id) override;
+    HexahedraAroundQuad getHexahedraAroundQuad(QuadID id) override;
 
 
     /** \brief Get the position of a vertex in a hexahedron from its index.
@@ -284,15 +285,15 @@ public:
 
 
     /** \brief Returns the HexahedraAroundVertex array (i.e. provide the hexahedron indices adjacent to each vertex).*/
-    const sofa::helper::vector< HexahedraAroundVertex > &getHexahedraAroundVertexArray() ;
+    const HexahedraShells& getHexahedraAroundVertexArray() ;
 
 
     /** \brief Returns the HexahedraAroundEdge array (i.e. provide the hexahedron indices adjacent to each edge). */
-    const sofa::helper::vector< HexahedraAroundEdge > &getHexahedraAroundEdgeArray() ;
+    const HexahedraShells& getHexahedraAroundEdgeArray() ;
 
 
     /** \brief Returns the HexahedraAroundQuad array (i.e. provide the hexahedron indices adjacent to each quad). */
-    const sofa::helper::vector< HexahedraAroundQuad > &getHexahedraAroundQuadArray() ;
+    const HexahedraShells& getHexahedraAroundQuadArray() ;
 
 
     bool hasHexahedra() const;
@@ -396,7 +397,7 @@ protected:
      * @return HexahedraAroundVertex lists in non-const.
      * @see getHexahedraAroundVertex()
      */
-    virtual HexahedraAroundVertex& getHexahedraAroundVertexForModification(const PointID vertexIndex);
+    virtual HexahedraShells::Shell getHexahedraAroundVertexForModification(const PointID vertexIndex);
 
 
     /** \brief Returns a non-const list of hexahedron indices around a given edge for subsequent modification.
@@ -404,7 +405,7 @@ protected:
      * @return HexahedraAroundEdge lists in non-const.
      * @see getHexahedraAroundEdge()
      */
-    virtual HexahedraAroundEdge& getHexahedraAroundEdgeForModification(const EdgeID edgeIndex);
+    virtual HexahedraShells::Shell getHexahedraAroundEdgeForModification(const EdgeID edgeIndex);
 
 
     /** \brief Returns a non-const list of hexahedron indices around a given quad for subsequent modification.
@@ -412,7 +413,7 @@ protected:
      * @return HexahedraAroundQuad lists in non-const.
      * @see getHexahedraAroundQuad()
      */
-    virtual HexahedraAroundQuad& getHexahedraAroundQuadForModification(const QuadID quadIndex);
+    virtual HexahedraShells::Shell getHexahedraAroundQuadForModification(const QuadID quadIndex);
 
 
     /// \brief Function creating the data graph linked to d_hexahedron
@@ -440,13 +441,13 @@ protected:
     sofa::helper::vector<QuadsInHexahedron> m_quadsInHexahedron;
 
     /// for each vertex provides the set of hexahedra adjacent to that vertex.
-    sofa::helper::vector< HexahedraAroundVertex > m_hexahedraAroundVertex;
+    HexahedraShells m_hexahedraAroundVertex;
 
     /// for each edge provides the set of hexahedra adjacent to that edge.
-    sofa::helper::vector< HexahedraAroundEdge > m_hexahedraAroundEdge;
+    HexahedraShells m_hexahedraAroundEdge;
 
     /// for each quad provides the set of hexahedra adjacent to that quad.
-    sofa::helper::vector< HexahedraAroundQuad > m_hexahedraAroundQuad;
+    HexahedraShells m_hexahedraAroundQuad;
 
 
     /// Boolean used to know if the topology Data of this container is dirty
@@ -122,7 +122,7 @@ void HexahedronSetTopologyModifier::addHexahedronProcess(Hexahedron t)
         m_container->m_hexahedraAroundVertex.resize(nbrP);
     for(PointID v=0; v<8; ++v)
     {
-        sofa::helper::vector< HexahedronID > &shell = m_container->m_hexahedraAroundVertex[t[v]];
+        auto shell = m_container->m_hexahedraAroundVertex[t[v]];
         shell.push_back( hexahedronIndex );
     }
 
@@ -162,7 +162,7 @@ void HexahedronSetTopologyModifier::addHexahedronProcess(Hexahedron t)
         // update m_hexahedraAroundQuad
         if (m_container->m_hexahedraAroundQuad.size() < m_container->getNbQuads())
             m_container->m_hexahedraAroundQuad.resize(m_container->getNbQuads());
-        sofa::helper::vector< HexahedronID > &shell = m_container->m_hexahedraAroundQuad[quadIndex];
+        auto shell = m_container->m_hexahedraAroundQuad[quadIndex];
         shell.push_back( hexahedronIndex );
     }
 
@@ -207,7 +207,7 @@ void HexahedronSetTopologyModifier::addHexahedronProcess(Hexahedron t)
         if (m_container->m_hexahedraAroundEdge.size() < m_container->getNbEdges())
              m_container->m_hexahedraAroundEdge.resize(m_container->getNbEdges());
 
-        sofa::helper::vector< HexahedronID > &shell = m_container->m_hexahedraAroundEdge[edgeIndex];
+        auto shell = m_container->m_hexahedraAroundEdge[edgeIndex];
         shell.push_back( hexahedronIndex );
     }
 
@@ -305,7 +305,7 @@ void HexahedronSetTopologyModifier::removeHexahedraProcess( const sofa::helper::
         {
             for(PointID v=0; v<8; ++v)
             {
-                sofa::helper::vector< HexahedronID > &shell = m_container->m_hexahedraAroundVertex[ t[v] ];
+                auto shell = m_container->m_hexahedraAroundVertex[ t[v] ];
                 shell.erase(remove(shell.begin(), shell.end(), indices[i]), shell.end());
                 if(removeIsolatedVertices && shell.empty())
                     vertexToBeRemoved.push_back(t[v]);
@@ -316,7 +316,7 @@ void HexahedronSetTopologyModifier::removeHexahedraProcess( const sofa::helper::
         {
             for(EdgeID e=0; e<12; ++e)
             {
-                sofa::helper::vector< HexahedronID > &shell = m_container->m_hexahedraAroundEdge[ m_container->m_edgesInHexahedron[indices[i]][e]];
+                auto shell = m_container->m_hexahedraAroundEdge[ m_container->m_edgesInHexahedron[indices[i]][e]];
                 shell.erase(remove(shell.begin(), shell.end(), indices[i]), shell.end());
                 if(removeIsolatedEdges && shell.empty())
                     edgeToBeRemoved.push_back(m_container->m_edgesInHexahedron[indices[i]][e]);
@@ -327,7 +327,7 @@ void HexahedronSetTopologyModifier::removeHexahedraProcess( const sofa::helper::
         {
             for(QuadID q=0; q<6; ++q)
             {
-                sofa::helper::vector< HexahedronID > &shell = m_container->m_hexahedraAroundQuad[ m_container->m_quadsInHexahedron[indices[i]][q]];
+                auto shell = m_container->m_hexahedraAroundQuad[ m_container->m_quadsInHexahedron[indices[i]][q]];
                 shell.erase(remove(shell.begin(), shell.end(), indices[i]), shell.end());
                 if(removeIsolatedQuads && shell.empty())
                     quadToBeRemoved.push_back(m_container->m_quadsInHexahedron[indices[i]][q]);
@@ -341,7 +341,7 @@ void HexahedronSetTopologyModifier::removeHexahedraProcess( const sofa::helper::
             {
                 for(PointID v=0; v<8; ++v)
                 {
-                    sofa::helper::vector< HexahedronID > &shell = m_container->m_hexahedraAroundVertex[ h[v] ];
+                    auto shell = m_container->m_hexahedraAroundVertex[ h[v] ];
                     replace(shell.begin(), shell.end(), lastHexahedron, indices[i]);
                 }
             }
@@ -350,7 +350,7 @@ void HexahedronSetTopologyModifier::removeHexahedraProcess( const sofa::helper::
             {
                 for(EdgeID e=0; e<12; ++e)
                 {
-                    sofa::helper::vector< HexahedronID > &shell =  m_container->m_hexahedraAroundEdge[ m_container->m_edgesInHexahedron[lastHexahedron][e]];
+                    auto shell = m_container->m_hexahedraAroundEdge[ m_container->m_edgesInHexahedron[lastHexahedron][e]];
                     replace(shell.begin(), shell.end(), lastHexahedron, indices[i]);
                 }
             }
@@ -359,7 +359,7 @@ void HexahedronSetTopologyModifier::removeHexahedraProcess( const sofa::helper::
             {
                 for(QuadID q=0; q<6; ++q)
                 {
-                    sofa::helper::vector< HexahedronID > &shell =  m_container->m_hexahedraAroundQuad[ m_container->m_quadsInHexahedron[lastHexahedron][q]];
+                    auto shell = m_container->m_hexahedraAroundQuad[ m_container->m_quadsInHexahedron[lastHexahedron][q]];
                     replace(shell.begin(), shell.end(), lastHexahedron, indices[i]);
                 }
             }
@@ -465,7 +465,7 @@ void HexahedronSetTopologyModifier::removePointsProcess(const sofa::helper::vect
         {
             // updating the edges connected to the point replacing the removed one:
             // for all edges connected to the last point
-            for(sofa::helper::vector<HexahedronID>::iterator itt=m_container->m_hexahedraAroundVertex[lastPoint].begin();
+            for(auto itt=m_container->m_hexahedraAroundVertex[lastPoint].begin();
                 itt!=m_container->m_hexahedraAroundVertex[lastPoint].end(); ++itt)
             {
                 PointID vertexIndex = m_container->getVertexIndexInHexahedron(m_hexahedron[*itt], lastPoint);
@@ -473,7 +473,7 @@ void HexahedronSetTopologyModifier::removePointsProcess(const sofa::helper::vect
             }
 
             // updating the edge shell itself (change the old index for the new one)
-            m_container->m_hexahedraAroundVertex[ indices[i] ] = m_container->m_hexahedraAroundVertex[ lastPoint ];
+            m_container->m_hexahedraAroundVertex.swap( indices[i], lastPoint );
         }
 
         m_container->m_hexahedraAroundVertex.resize( m_container->m_hexahedraAroundVertex.size() - indices.size() );
@@ -498,7 +498,7 @@ void HexahedronSetTopologyModifier::removeEdgesProcess( const sofa::helper::vect
         EdgeID lastEdge = (EdgeID)m_container->getNumberOfEdges() - 1;
         for(size_t i=0; i<indices.size(); ++i, --lastEdge)
         {
-            for(sofa::helper::vector<HexahedronID>::iterator itt=m_container->m_hexahedraAroundEdge[lastEdge].begin();
+            for(auto itt=m_container->m_hexahedraAroundEdge[lastEdge].begin();
                 itt!=m_container->m_hexahedraAroundEdge[lastEdge].end(); ++itt)
             {
                 EdgeID edgeIndex = m_container->getEdgeIndexInHexahedron(m_container->m_edgesInHexahedron[*itt], lastEdge);
@@ -506,7 +506,7 @@ void HexahedronSetTopologyModifier::removeEdgesProcess( const sofa::helper::vect
             }
 
             // updating the edge shell itself (change the old index for the new one)
-            m_container->m_hexahedraAroundEdge[ indices[i] ] = m_container->m_hexahedraAroundEdge[ lastEdge ];
+            m_container->m_hexahedraAroundEdge.swap( indices[i], lastEdge );
         }
 
         m_container->m_hexahedraAroundEdge.resize( m_container->m_hexahedraAroundEdge.size() - indices.size() );
@@ -531,7 +531,7 @@ void HexahedronSetTopologyModifier::removeQuadsProcess( const sofa::helper::vect
         QuadID lastQuad = (QuadID)m_container->getNumberOfQuads() - 1;
         for(size_t i=0; i<indices.size(); ++i, --lastQuad)
         {
-            for(sofa::helper::vector<HexahedronID>::iterator itt=m_container->m_hexahedraAroundQuad[lastQuad].begin();
+            for(auto itt=m_container->m_hexahedraAroundQuad[lastQuad].begin();
                 itt!=m_container->m_hexahedraAroundQuad[lastQuad].end(); ++itt)
             {
                 QuadID quadIndex=m_container->getQuadIndexInHexahedron(m_container->m_quadsInHexahedron[*itt],lastQuad);
@@ -539,7 +539,7 @@ void HexahedronSetTopologyModifier::removeQuadsProcess( const sofa::helper::vect
             }
 
             // updating the quad shell itself (change the old index for the new one)
-            m_container->m_hexahedraAroundQuad[ indices[i] ] = m_container->m_hexahedraAroundQuad[ lastQuad ];
+            m_container->m_hexahedraAroundQuad.swap( indices[i], lastQuad );
         }
         m_container->m_hexahedraAroundQuad.resize( m_container->m_hexahedraAroundQuad.size() - indices.size() );
     }
@@ -554,11 +554,7 @@ void HexahedronSetTopologyModifier::renumberPointsProcess( const sofa::helper::v
     {
         if(m_container->hasHexahedraAroundVertex())
         {
-            sofa::helper::vector< sofa::helper::vector< HexahedronID > > hexahedraAroundVertex_cp = m_container->m_hexahedraAroundVertex;
-            for(size_t i=0; i<index.size(); ++i)
-            {
-                m_container->m_hexahedraAroundVertex[i] = hexahedraAroundVertex_cp[ index[i] ];
-            }
+            m_container->m_hexahedraAroundVertex.permute(index);
         }
 
         helper::WriteAccessor< Data< sofa::helper::vector<Hexahedron> > > m_hexahedron = m_container->d_hexahedron;
@@ -20,6 +20,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseTopology/MeshTopology.h>
+#include <SofaBaseTopology/TopologyShellBuilder.h>
 
 #include <sofa/core/topology/Topology.h>
 #include <sofa/helper/visual/DrawTool.h>
@@ -943,15 +944,7 @@ void MeshTopology::createEdgesInHexahedronArray ()
 void MeshTopology::createTrianglesAroundVertexArray ()
 {
     const SeqTriangles& triangles = getTriangles(); // do not use seqTriangles directly as it might not be up-to-date
-    m_trianglesAroundVertex.clear();
-    m_trianglesAroundVertex.resize( nbPoints );
-
-    for (unsigned int i = 0; i < triangles.size(); ++i)
-    {
-        // adding triangle i in the triangle shell of all points
-        for (unsigned int j=0; j<3; ++j)
-            m_trianglesAroundVertex[ triangles[i][j]  ].push_back( i );
-    }
+    buildElementShells(triangles, nbPoints, m_trianglesAroundVertex);
 }
 
 void MeshTopology::createOrientedTrianglesAroundVertexArray()
@@ -1149,15 +1142,7 @@ void MeshTopology::createTrianglesInTetrahedronArray ()
 void MeshTopology::createQuadsAroundVertexArray ()
 {
     const SeqQuads& quads = getQuads(); // do not use seqQuads directly as it might not be up-to-date
-    m_quadsAroundVertex.clear();
-    m_quadsAroundVertex.resize( nbPoints );
-
-    for (unsigned int i = 0; i < quads.size(); ++i)
-    {
-        // adding quad i in the quad shell of all points
-        for (unsigned j=0; j<4; ++j)
-            m_quadsAroundVertex[ quads[i][j]  ].push_back( i );
-    }
+    buildElementShells(quads, nbPoints, m_quadsAroundVertex);
 }
 
 void MeshTopology::createOrientedQuadsAroundVertexArray()
@@ -1354,87 +1339,40 @@ void MeshTopology::createQuadsInHexahedronArray ()
 
 void MeshTopology::createTetrahedraAroundVertexArray ()
 {
-    m_tetrahedraAroundVertex.resize( nbPoints );
-    unsigned int j;
-
-    for (unsigned int i = 0; i < seqTetrahedra.getValue().size(); ++i)
-    {
-        for (j=0; j<4; ++j)
-            m_tetrahedraAroundVertex[ seqTetrahedra.getValue()[i][j]  ].push_back( i );
-    }
+    buildElementShells(seqTetrahedra.getValue(), nbPoints, m_tetrahedraAroundVertex);
 }
 
 void MeshTopology::createTetrahedraAroundEdgeArray ()
 {
     if (!m_edgesInTetrahedron.size())
         createEdgesInTetrahedronArray();
-    m_tetrahedraAroundEdge.resize( getNbEdges() );
-    const vector< EdgesInTetrahedron > &tea = m_edgesInTetrahedron;
-    unsigned int j;
-
-    for (unsigned int i = 0; i < seqTetrahedra.getValue().size(); ++i)
-    {
-        for (j=0; j<6; ++j)
-            m_tetrahedraAroundEdge[ tea[i][j] ].push_back( i );
-    }
+    buildElementShells(m_edgesInTetrahedron, getNbEdges(), m_tetrahedraAroundEdge);
 }
 
 void MeshTopology::createTetrahedraAroundTriangleArray ()
 {
     if (!m_trianglesInTetrahedron.size())
         createTrianglesInTetrahedronArray();
-    m_tetrahedraAroundTriangle.resize( getNbTriangles());
-    unsigned int j;
-    const vector< TrianglesInTetrahedron > &tta=m_trianglesInTetrahedron;
-
-    for (unsigned int i = 0; i < seqTetrahedra.getValue().size(); ++i)
-    {
-        for (j=0; j<4; ++j)
-            m_tetrahedraAroundTriangle[ tta[i][j] ].push_back( i );
-    }
+    buildElementShells(m_trianglesInTetrahedron, getNbTriangles(), m_tetrahedraAroundTriangle);
 }
 
 void MeshTopology::createHexahedraAroundVertexArray ()
 {
-    m_hexahedraAroundVertex.resize( nbPoints );
-    unsigned int j;
-
-    for (unsigned int i = 0; i < seqHexahedra.getValue().size(); ++i)
-    {
-        for (j=0; j<8; ++j)
-            m_hexahedraAroundVertex[ seqHexahedra.getValue()[i][j]  ].push_back( i );
-    }
+    buildElementShells(seqHexahedra.getValue(), nbPoints, m_hexahedraAroundVertex);
 }
 
 void MeshTopology::createHexahedraAroundEdgeArray ()
 {
     if (!m_edgesInHexahedron.size())
         createEdgesInHexahedronArray();
-    m_hexahedraAroundEdge.resize(getNbEdges());
-    unsigned int j;
-    const vector< EdgesInHexahedron > &hea=m_edgesInHexahedron;
-
-    for (unsigned int i = 0; i < seqHexahedra.getValue().size(); ++i)
-    {
-        for (j=0; j<12; ++j)
-            m_hexahedraAroundEdge[ hea[i][j] ].push_back( i );
-    }
+    buildElementShells(m_edgesInHexahedron, getNbEdges(), m_hexahedraAroundEdge);
 }
 
 void MeshTopology::createHexahedraAroundQuadArray ()
 {
     if (!m_quadsInHexahedron.size())
         createQuadsInHexahedronArray();
-    m_hexahedraAroundQuad.resize( getNbQuads());
-    unsigned int j;
-    const vector< QuadsInHexahedron > &qha=m_quadsInHexahedron;
-
-    for (unsigned int i = 0; i < seqHexahedra.getValue().size(); ++i)
-    {
-        // adding quad i in the edge shell of both points
-        for (j=0; j<6; ++j)
-            m_hexahedraAroundQuad[ qha[i][j] ].push_back( i );
-    }
+    buildElementShells(m_quadsInHexahedron, getNbQuads(), m_hexahedraAroundQuad);
 }
 
 const MeshTopology::EdgesAroundVertex& MeshTopology::getEdgesAroundVertex(PointID i)
@@ -1603,7 +1541,7 @@ const MeshTopology::QuadsInHexahedron& MeshTopology::getQuadsInHexahedron(HexaID
     return InvalidQuadsInHexahedron;
 }
 
-const MeshTopology::TetrahedraAroundVertex& MeshTopology::getTetrahedraAroundVertex(PointID i)
+MeshTopology::TetrahedraAroundVertex MeshTopology::getTetrahedraAroundVertex(PointID i)
 {
     if (!m_tetrahedraAroundVertex.size() || i > m_tetrahedraAroundVertex.size()-1)
         createTetrahedraAroundVertexArray();
@@ -1611,10 +1549,10 @@ const MeshTopology::TetrahedraAroundVertex& MeshTopology::getTetrahedraAroundVer
     if (i < m_tetrahedraAroundVertex.size())
         return m_tetrahedraAroundVertex[i];
 
-    return InvalidSet;
+    return TetrahedraAroundVertex(InvalidSet);
 }
 
-const MeshTopology::TetrahedraAroundEdge& MeshTopology::getTetrahedraAroundEdge(EdgeID i)
+MeshTopology::TetrahedraAroundEdge MeshTopology::getTetrahedraAroundEdge(EdgeID i)
 {
     if (!m_tetrahedraAroundEdge.size() || i > m_tetrahedraAroundEdge.size()-1)
         createTetrahedraAroundEdgeArray();
@@ -1622,10 +1560,10 @@ const MeshTopology::TetrahedraAroundEdge& MeshTopology::getTetrahedraAroundEdge(
     if (i < m_tetrahedraAroundEdge.size())
         return m_tetrahedraAroundEdge[i];
 
-    return InvalidSet;
+    return TetrahedraAroundEdge(InvalidSet);
 }
 
-const MeshTopology::TetrahedraAroundTriangle& MeshTopology::getTetrahedraAroundTriangle(TriangleID i)
+MeshTopology::TetrahedraAroundTriangle MeshTopology::getTetrahedraAroundTriangle(TriangleID i)
 {
     if (!m_tetrahedraAroundTriangle.size() || i > m_tetrahedraAroundTriangle.size()-1)
         createTetrahedraAroundTriangleArray();
@@ -1633,10 +1571,10 @@ const MeshTopology::TetrahedraAroundTriangle& MeshTopology::getTetrahedraAroundT
     if (i < m_tetrahedraAroundTriangle.size())
         return m_tetrahedraAroundTriangle[i];
 
-    return InvalidSet;
+    return TetrahedraAroundTriangle(InvalidSet);
 }
 
-const MeshTopology::HexahedraAroundVertex& MeshTopology::getHexahedraAroundVertex(PointID i)
+MeshTopology::HexahedraAroundVertex MeshTopology::getHexahedraAroundVertex(PointID i)
 {
     if (!m_hexahedraAroundVertex.size() || i > m_hexahedraAroundVertex.size()-1)
         createHexahedraAroundVertexArray();
@@ -1644,10 +1582,10 @@ const MeshTopology::HexahedraAroundVertex& MeshTopology::getHexahedraAroundVerte
     if (i < m_hexahedraAroundVertex.size())
         return m_hexahedraAroundVertex[i];
 
-    return InvalidSet;
+    return HexahedraAroundVertex(InvalidSet);
 }
 
-const MeshTopology::HexahedraAroundEdge& MeshTopology::getHexahedraAroundEdge(EdgeID i)
+MeshTopology::HexahedraAroundEdge MeshTopology::getHexahedraAroundEdge(EdgeID i)
 {
     if (!m_hexahedraAroundEdge.size() || i > m_hexahedraAroundEdge.size()-1)
         createHexahedraAroundEdgeArray();
@@ -1655,10 +1593,10 @@ const MeshTopology::HexahedraAroundEdge& MeshTopology::getHexahedraAroundEdge(Ed
     if (i < m_hexahedraAroundEdge.size())
         return m_hexahedraAroundEdge[i];
 
-    return InvalidSet;
+    return HexahedraAroundEdge(InvalidSet);
 }
 
-const MeshTopology::HexahedraAroundQuad& MeshTopology::getHexahedraAroundQuad(QuadID i)
+MeshTopology::HexahedraAroundQuad MeshTopology::getHexahedraAroundQuad(QuadID i)
 {
     if (!m_hexahedraAroundQuad.size() || i > m_hexahedraAroundQuad.size()-1)
         createHexahedraAroundQuadArray();
@@ -1666,7 +1604,7 @@ const MeshTopology::HexahedraAroundQuad& MeshTopology::getHexahedraAroundQuad(Qu
     if (i < m_hexahedraAroundQuad.size())
         return m_hexahedraAroundQuad[i];
 
-    return InvalidSet;
+    return HexahedraAroundQuad(InvalidSet);
 }
 
 
@@ -1777,7 +1715,7 @@ const vector< MeshTopology::TrianglesInTetrahedron >& MeshTopology::getTriangles
     return m_trianglesInTetrahedron;
 }
 
-const vector< MeshTopology::TetrahedraAroundVertex >& MeshTopology::getTetrahedraAroundVertexArray()
+const MeshTopology::TetrahedraShells& MeshTopology::getTetrahedraAroundVertexArray()
 {
     if (m_tetrahedraAroundVertex.empty()) // this method should only be called when the array exists.
     {
@@ -1788,7 +1726,7 @@ const vector< MeshTopology::TetrahedraAroundVertex >& MeshTopology::getTetrahedr
     return m_tetrahedraAroundVertex;
 }
 
-const vector< MeshTopology::TetrahedraAroundEdge >& MeshTopology::getTetrahedraAroundEdgeArray()
+const MeshTopology::TetrahedraShells& MeshTopology::getTetrahedraAroundEdgeArray()
 {
     if (m_tetrahedraAroundEdge.empty()) // this method should only be called when the array exists.
     {
@@ -1798,7 +1736,7 @@ const vector< MeshTopology::TetrahedraAroundEdge >& MeshTopology::getTetrahedraA
     return m_tetrahedraAroundEdge;
 }
 
-const vector< MeshTopology::TetrahedraAroundTriangle >& MeshTopology::getTetrahedraAroundTriangleArray()
+const MeshTopology::TetrahedraShells& MeshTopology::getTetrahedraAroundTriangleArray()
 {
     if (m_tetrahedraAroundTriangle.empty()) // this method should only be called when the array exists.
     {
@@ -1834,7 +1772,7 @@ const vector< MeshTopology::QuadsInHexahedron >& MeshTopology::getQuadsInHexahed
     return m_quadsInHexahedron;
 }
 
-const vector< MeshTopology::HexahedraAroundVertex >& MeshTopology::getHexahedraAroundVertexArray()
+const MeshTopology::HexahedraShells& MeshTopology::getHexahedraAroundVertexArray()
 {
     if (m_hexahedraAroundVertex.empty()) // this method should only be called when the array exists.
     {
@@ -1845,7 +1783,7 @@ const vector< MeshTopology::HexahedraAroundVertex >& MeshTopology::getHexahedraA
     return m_hexahedraAroundVertex;
 }
 
-const vector< MeshTopology::HexahedraAroundEdge >& MeshTopology::getHexahedraAroundEdgeArray()
+const MeshTopology::HexahedraShells& MeshTopology::getHexahedraAroundEdgeArray()
 {
     if (m_hexahedraAroundEdge.empty()) // this method should only be called when the array exists.
     {
@@ -1856,7 +1794,7 @@ const vector< MeshTopology::HexahedraAroundEdge >& MeshTopology::getHexahedraAro
     return m_hexahedraAroundEdge;
 }
 
-const vector< MeshTopology::HexahedraAroundQuad >& MeshTopology::getHexahedraAroundQuadArray()
+const MeshTopology::HexahedraShells& MeshTopology::getHexahedraAroundQuadArray()
 {
     if (m_hexahedraAroundQuad.empty()) // this method should only be called when the array exists.
     {
@@ -84,6 +84,10 @@ private:
 protected:
     MeshTopology();
 public:
+    /// flat storage of the tetrahedra and hexahedra shells
+    typedef core::topology::ElementShells<TetraID> TetrahedraShells;
+    typedef core::topology::ElementShells<HexaID> HexahedraShells;
+
     void parse(core::objectmodel::BaseObjectDescription* arg) override;
 
     void init() override;
@@ -172,54 +176,54 @@ public:
     /// @name neighbors queries for Tetrahedron Topology
     /// @{
     /// Returns the set of tetrahedra adjacent to a given vertex.
-    const TetrahedraAroundVertex& getTetrahedraAroundVertex(PointID i) override;
+    TetrahedraAroundVertex getTetrahedraAroundVertex(PointID i) override;
     /** \brief Returns the TetrahedraAroundVertex array (i.e. provide the tetrahedron indices adjacent to each vertex). */
-    const helper::vector< TetrahedraAroundVertex > &getTetrahedraAroundVertexArray();
+    const TetrahedraShells& getTetrahedraAroundVertexArray();
 
     /// Returns the set of edges adjacent to a given tetrahedron.
     const EdgesInTetrahedron& getEdgesInTetrahedron(TetraID i) override;
     /** \brief Returns the EdgesInTetrahedron array (i.e. provide the 6 edge indices for each tetrahedron). */
     const helper::vector< EdgesInTetrahedron > &getEdgesInTetrahedronArray();
     /// Returns the set of tetrahedra adjacent to a given edge.
-    const TetrahedraAroundEdge& getTetrahedraAroundEdge(EdgeID i) override;
+    TetrahedraAroundEdge getTetrahedraAroundEdge(EdgeID i) override;
     /** \brief Returns the TetrahedraAroundEdge array (i.e. provide the tetrahedron indices adjacent to each edge). */
-    const helper::vector< TetrahedraAroundEdge > &getTetrahedraAroundEdgeArray();
+    const TetrahedraShells& getTetrahedraAroundEdgeArray();
 
     /// Returns the set of triangles adjacent to a given tetrahedron.
     const TrianglesInTetrahedron& getTrianglesInTetrahedron(TetraID i) override;
     /** \brief Returns the TrianglesInTetrahedron array (i.e. provide the 4 triangle indices for each tetrahedron). */
     const helper::vector< TrianglesInTetrahedron > &getTrianglesInTetrahedronArray();
     /// Returns the set of tetrahedra adjacent to a given triangle.
-    const TetrahedraAroundTriangle& getTetrahedraAroundTriangle(TriangleID i) override;
+    TetrahedraAroundTriangle getTetrahedraAroundTriangle(TriangleID i) override;
     /** \brief Returns the TetrahedraAroundTriangle array (i.e. provide the tetrahedron indices adjacent to each triangle). */
-    const helper::vector< TetrahedraAroundTriangle > &getTetrahedraAroundTriangleArray();
+    const TetrahedraShells& getTetrahedraAroundTriangleArray();
     /// @}
 
 
     /// @name neighbors queries for Hexhaedron Topology
     /// @{
     /// Returns the set of hexahedra adjacent to a given vertex.
-    const HexahedraAroundVertex& getHexahedraAroundVertex(PointID i) override;
+    HexahedraAroundVertex getHexahedraAroundVertex(PointID i) override;
     /** \brief Returns the HexahedraAroundVertex array (i.e. provide the hexahedron indices adjacent to each vertex).*/
-    const helper::vector< HexahedraAroundVertex > &getHexahedraAroundVertexArray();
+    const HexahedraShells& getHexahedraAroundVertexArray();
 
     /// Returns the set of edges adjacent to a given hexahedron.
     const EdgesInHexahedron& getEdgesInHexahedron(HexaID i) override;
     /** \brief Returns the EdgesInHexahedron array (i.e. provide the 12 edge indices for each hexahedron).	*/
     const helper::vector< EdgesInHexahedron > &getEdgesInHexahedronArray();
     /// Returns the set of hexahedra adjacent to a given edge.
-    const HexahedraAroundEdge& getHexahedraAroundEdge(EdgeID i) override;
+    HexahedraAroundEdge getHexahedraAroundEdge(EdgeID i) override;
     /** \brief Returns the HexahedraAroundEdge array (i.e. provide the hexahedron indices adjacent to each edge). */
-    const helper::vector< HexahedraAroundEdge > &getHexahedraAroundEdgeArray();
+    const HexahedraShells& getHexahedraAroundEdgeArray();
 
     /// Returns the set of quads adjacent to a given hexahedron.
     const QuadsInHexahedron& getQuadsInHexahedron(HexaID i) override;
     /** \brief Returns the QuadsInHexahedron array (i.e. provide the 8 quad indices for each hexahedron).	*/
     const helper::vector< QuadsInHexahedron > &getQuadsInHexahedronArray();
     /// Returns the set of hexahedra adjacent to a given quad.
-    const HexahedraAroundQuad& getHexahedraAroundQuad(QuadID i) override;
+    HexahedraAroundQuad getHexahedraAroundQuad(QuadID i) override;
     /** \brief Returns the HexahedraAroundQuad array (i.e. provide the hexahedron indices adjacent to each quad). */
-    const helper::vector< HexahedraAroundQuad > &getHexahedraAroundQuadArray();
+    const HexahedraShells& getHexahedraAroundQuadArray();
     /// @}
 
 
@@ -364,22 +368,22 @@ protected:
     helper::vector< QuadsInHexahedron > m_quadsInHexahedron;
 
     /// provides the set of tetrahedrons adjacents to each vertex
-    helper::vector< TetrahedraAroundVertex> m_tetrahedraAroundVertex;
+    TetrahedraShells m_tetrahedraAroundVertex;
 
     /// for each edge provides the set of tetrahedra adjacent to that edge
-    helper::vector< TetrahedraAroundEdge > m_tetrahedraAroundEdge;
+    TetrahedraShells m_tetrahedraAroundEdge;
 
     /// for each triangle provides the set of tetrahedrons adjacent to that triangle
-    helper::vector< TetrahedraAroundTriangle > m_tetrahedraAroundTriangle;
+    TetrahedraShells m_tetrahedraAroundTriangle;
 
     /// provides the set of hexahedrons for each vertex
-    helper::vector< HexahedraAroundVertex > m_hexahedraAroundVertex;
+    HexahedraShells m_hexahedraAroundVertex;
 
     /// for each edge provides the set of tetrahedra adjacent to that edge
-    helper::vector< HexahedraAroundEdge > m_hexahedraAroundEdge;
+    HexahedraShells m_hexahedraAroundEdge;
 
     /// for each quad provides the set of hexahedrons adjacent to that quad
-    helper::vector< HexahedraAroundQuad > m_hexahedraAroundQuad;
+    HexahedraShells m_hexahedraAroundQuad;
 
     /** \brief Creates the EdgeSetIndex.
      *
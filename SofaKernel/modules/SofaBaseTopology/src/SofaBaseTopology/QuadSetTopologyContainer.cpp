@@ -20,6 +20,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseTopology/QuadSetTopologyContainer.h>
+#include <SofaBaseTopology/TopologyShellBuilder.h>
 #include <sofa/core/topology/TopologyHandler.h>
 
 #include <sofa/core/ObjectFactory.h>
@@ -111,15 +112,7 @@ void QuadSetTopologyContainer::createQuadsAroundVertexArray()
     if (getNbPoints() == 0) // in case only Data have been copied and not going thourgh AddTriangle methods.
         this->setNbPoints(sofa::Size(d_initPoints.getValue().size()));
 
-    m_quadsAroundVertex.resize(getNbPoints());
-    for (sofa::Index i=0; i<m_quad.size(); ++i)
-    {
-        // adding quad i in the quad shell of all points
-        for (sofa::Index j=0; j<4; ++j)
-        {
-            m_quadsAroundVertex[ m_quad[i][j] ].push_back((QuadID)i);
-        }
-    }
+    buildElementShells(m_quad.ref(), getNbPoints(), m_quadsAroundVertex);
 }
 
 void QuadSetTopologyContainer::createQuadsAroundEdgeArray()
@@ -159,15 +152,7 @@ void QuadSetTopologyContainer::createQuadsAroundEdgeArray()
         return;
     }
 
-    m_quadsAroundEdge.resize(numEdges);
-    for (sofa::Index i=0; i<numQuads; ++i)
-    {
-        // adding quad i in the quad shell of all edges
-        for (sofa::Index j=0; j<4; ++j)
-        {
-            m_quadsAroundEdge[ m_edgesInQuad[i][j] ].push_back((QuadID)i);
-        }
-    }
+    buildElementShells(m_edgesInQuad, numEdges, m_quadsAroundEdge);
 }
 
 void QuadSetTopologyContainer::createEdgeSetArray()
@@ -20,6 +20,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseTopology/TetrahedronSetTopologyContainer.h>
+#include <SofaBaseTopology/TopologyShellBuilder.h>
 #include <sofa/core/topology/TopologyHandler.h>
 
 #include <sofa/core/ObjectFactory.h>
@@ -338,17 +339,7 @@ void TetrahedronSetTopologyContainer::createTetrahedraAroundVertexArray()
     if (getNbPoints() == 0) // in case only Data have been copied and not going thourgh AddTriangle methods.
         this->setNbPoints(sofa::Size(d_initPoints.getValue().size()));
 
-    m_tetrahedraAroundVertex.resize( getNbPoints() );
-    helper::ReadAccessor< Data< sofa::helper::vector<Tetrahedron> > > m_tetrahedron = d_tetrahedron;
-
-    for (size_t i = 0; i < getNumberOfTetrahedra(); ++i)
-    {
-        // adding edge i in the edge shell of both points
-        for (PointID j=0; j<4; ++j)
-        {
-            m_tetrahedraAroundVertex[ m_tetrahedron[i][j]  ].push_back( (TetrahedronID)i );
-        }
-    }
+    buildElementShells(d_tetrahedron.getValue(), getNbPoints(), m_tetrahedraAroundVertex);
 }
 
 void TetrahedronSetTopologyContainer::createTetrahedraAroundEdgeArray ()
@@ -359,15 +350,7 @@ void TetrahedronSetTopologyContainer::createTetrahedraAroundEdgeArray ()
     if(!hasEdgesInTetrahedron())
         createEdgesInTetrahedronArray();
 
-    m_tetrahedraAroundEdge.resize(getNumberOfEdges());
-    for (size_t i=0; i< getNumberOfTetrahedra(); ++i)
-    {
-        // adding edge i in the edge shell of both points
-        for (EdgeID j=0; j<6; ++j)
-        {
-            m_tetrahedraAroundEdge[ m_edgesInTetrahedron[i][j] ].push_back( (TetrahedronID)i );
-        }
-    }
+    buildElementShells(m_edgesInTetrahedron, getNumberOfEdges(), m_tetrahedraAroundEdge);
 }
 
 void TetrahedronSetTopologyContainer::createTetrahedraAroundTriangleArray ()
@@ -408,16 +391,7 @@ void TetrahedronSetTopologyContainer::createTetrahedraAroundTriangleArray ()
         return;
     }
 
-    m_tetrahedraAroundTriangle.resize(numTriangles);
-
-    for (size_t i=0; i<numTetra; ++i)
-    {
-        // adding tetrahedron i in the shell of all neighbors triangles
-        for (TriangleID j=0; j<4; ++j)
-        {
-            m_tetrahedraAroundTriangle[ m_trianglesInTetrahedron[i][j] ].push_back( (TetrahedronID)i );
-        }
-    }
+    buildElementShells(m_trianglesInTetrahedron, numTriangles, m_tetrahedraAroundTriangle);
 }
 
 const sofa::helper::vector<TetrahedronSetTopologyContainer::Tetrahedron> &TetrahedronSetTopologyContainer::getTetrahedronArray()
@@ -490,17 +464,17 @@ Size TetrahedronSetTopologyContainer::getNumberOfElements() const
     return this->getNumberOfTetrahedra();
 }
 
-const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundVertex > &TetrahedronSetTopologyContainer::getTetrahedraAroundVertexArray()
+const TetrahedronSetTopologyContainer::TetrahedraShells& TetrahedronSetTopologyContainer::getTetrahedraAroundVertexArray()
 {
     return m_tetrahedraAroundVertex;
 }
 
-const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundEdge > &TetrahedronSetTopologyContainer::getTetrahedraAroundEdgeArray()
+const TetrahedronSetTopologyContainer::TetrahedraShells& TetrahedronSetTopologyContainer::getTetrahedraAroundEdgeArray()
 {
     return m_tetrahedraAroundEdge;
 }
 
-const sofa::helper::vector< TetrahedronSetTopologyContainer::TetrahedraAroundTriangle > &TetrahedronSetTopologyContainer::getTetrahedraAroundTriangleArray()
+const TetrahedronSetTopologyContainer::TetrahedraShells& TetrahedronSetTopologyContainer::getTetrahedraAroundTriangleArray()
 {
     return m_tetrahedraAroundTriangle;
 }
@@ -529,28 +503,28 @@ const sofa::helper::vector< TetrahedronSetTopologyContainer::TrianglesInTetrahed
     return m_trianglesInTetrahedron;
 }
 
-const TetrahedronSetTopologyContainer::TetrahedraAroundVertex &TetrahedronSetTopologyContainer::getTetrahedraAroundVertex(const PointID id)
+TetrahedronSetTopologyContainer::TetrahedraAroundVertex TetrahedronSetTopologyContainer::getTetrahedraAroundVertex(const PointID id)
 {
     if (id < m_tetrahedraAroundVertex.size())
         return m_tetrahedraAroundVertex[id];
 
-    return InvalidSet;
+    return TetrahedraAroundVertex(InvalidSet);
 }
 
-const TetrahedronSetTopologyContainer::TetrahedraAroundEdge &TetrahedronSetTopologyContainer::getTetrahedraAroundEdge(const EdgeID id)
+TetrahedronSetTopologyContainer::TetrahedraAroundEdge TetrahedronSetTopologyContainer::getTetrahedraAroundEdge(const EdgeID id)
 {
     if (id < m_tetrahedraAroundEdge.size())
         return m_tetrahedraAroundEdge[id];
 
-    return InvalidSet;
+    return TetrahedraAroundEdge(InvalidSet);
 }
 
-const TetrahedronSetTopologyContainer::TetrahedraAroundTriangle &TetrahedronSetTopologyContainer::getTetrahedraAroundTriangle(const TriangleID id)
+TetrahedronSetTopologyContainer::TetrahedraAroundTriangle TetrahedronSetTopologyContainer::getTetrahedraAroundTriangle(const TriangleID id)
 {
     if (id < m_tetrahedraAroundTriangle.size())
         return m_tetrahedraAroundTriangle[id];
 
-    return InvalidSet;
+    return TetrahedraAroundTriangle(InvalidSet);
 }
 
 const TetrahedronSetTopologyContainer::EdgesInTetrahedron &TetrahedronSetTopologyContainer::getEdgesInTetrahedron(const EdgeID id)
@@ -618,7 +592,7 @@ int TetrahedronSetTopologyContainer::getTriangleIndexInTetrahedron(const Triangl
         return -1;
 }
 
-TetrahedronSetTopologyContainer::TetrahedraAroundEdge &TetrahedronSetTopologyContainer::getTetrahedraAroundEdgeForModification(const EdgeID i)
+TetrahedronSetTopologyContainer::TetrahedraShells::Shell TetrahedronSetTopologyContainer::getTetrahedraAroundEdgeForModification(const EdgeID i)
 {
     if (!hasTetrahedraAroundEdge())
     {
@@ -632,7 +606,7 @@ TetrahedronSetTopologyContainer::TetrahedraAroundEdge &TetrahedronSetTopologyCon
     return m_tetrahedraAroundEdge[i];
 }
 
-TetrahedronSetTopologyContainer::TetrahedraAroundVertex &TetrahedronSetTopologyContainer::getTetrahedraAroundVertexForModification(const PointID i)
+TetrahedronSetTopologyContainer::TetrahedraShells::Shell TetrahedronSetTopologyContainer::getTetrahedraAroundVertexForModification(const PointID i)
 {
     if (!hasTetrahedraAroundVertex())
     {
@@ -646,7 +620,7 @@ TetrahedronSetTopologyContainer::TetrahedraAroundVertex &TetrahedronSetTopologyC
     return m_tetrahedraAroundVertex[i];
 }
 
-TetrahedronSetTopologyContainer::TetrahedraAroundTriangle &TetrahedronSetTopologyContainer::getTetrahedraAroundTriangleForModification(const TriangleID i)
+TetrahedronSetTopologyContainer::TetrahedraShells::Shell TetrahedronSetTopologyContainer::getTetrahedraAroundTriangleForModification(const TriangleID i)
 {
     if (!hasTetrahedraAroundTriangle())
     {
@@ -674,7 +648,7 @@ bool TetrahedronSetTopologyContainer::checkTopology() const
         std::set <int> tetrahedronSet;
         for (size_t i = 0; i < m_tetrahedraAroundVertex.size(); ++i)
         {
-            const sofa::helper::vector<TetrahedronID> &tvs = m_tetrahedraAroundVertex[i];
+            const TetrahedraAroundVertex tvs = m_tetrahedraAroundVertex[i];
             for (size_t j = 0; j < tvs.size(); ++j)
             {
                 const Tetrahedron& tetrahedron = m_tetrahedron[tvs[j]];
@@ -736,7 +710,7 @@ bool TetrahedronSetTopologyContainer::checkTopology() const
         std::set <int> tetrahedronSet;
         for (size_t i = 0; i < m_tetrahedraAroundTriangle.size(); ++i)
         {
-            const sofa::helper::vector<TetrahedronID> &tes = m_tetrahedraAroundTriangle[i];
+            const TetrahedraAroundTriangle tes = m_tetrahedraAroundTriangle[i];
             for (size_t j = 0; j < tes.size(); ++j)
             {
                 const TrianglesInTetrahedron& triInTetra = m_trianglesInTetrahedron[tes[j]];
@@ -798,7 +772,7 @@ bool TetrahedronSetTopologyContainer::checkTopology() const
         std::set <int> tetrahedronSet;
         for (size_t i = 0; i < m_tetrahedraAroundEdge.size(); ++i)
         {
-            const sofa::helper::vector<TetrahedronID> &tes = m_tetrahedraAroundEdge[i];
+            const TetrahedraAroundEdge tes = m_tetrahedraAroundEdge[i];
             for (size_t j = 0; j < tes.size(); ++j)
             {
                 const EdgesInTetrahedron& eInTetra = m_edgesInTetrahedron[tes[j]];
@@ -49,6 +49,7 @@ public:
     typedef core::topology::BaseMeshTopology::TetrahedraAroundVertex      TetrahedraAroundVertex;
     typedef core::topology::BaseMeshTopology::TetrahedraAroundEdge        TetrahedraAroundEdge;
     typedef core::topology::BaseMeshTopology::TetrahedraAroundTriangle    TetrahedraAroundTriangle;
+    typedef core::topology::ElementShells<TetraID>                        TetrahedraShells;
     typedef core::topology::BaseMeshTopology::EdgesInTetrahedron          EdgesInTetrahedron;
     typedef core::topology::BaseMeshTopology::TrianglesInTetrahedron      TrianglesInTetrahedron;
 
@@ -126,7 +127,7 @@ public:
      * @param ID of a vertex.
      * @return TetrahedraAroundVertex list around the input vertex.
      */
-    const TetrahedraAroundVertex& getTetrahedraAroundVertex(PointID id) override;
+    TetrahedraAroundVertex getTetrahedraAroundVertex(PointID id) override;
 
 
     /** \brief Returns the set of tetrahedra adjacent to a given edge.
@@ -134,7 +135,7 @@ public:
      * @param ID of an edge.
      * @return TetrahedraAroundVertex list around the input edge.
      */
-    const TetrahedraAroundEdge& getTetrahedraAroundEdge(EdgeID id) override;
+    TetrahedraAroundEdge getTetrahedraAroundEdge(EdgeID id) override;
 
 
     /** \brief Returns the set of tetrahedra adjacent to a given triangle.
@@ -142,7 +143,7 @@ public:
      * @param ID of a triangle.
      * @return TetrahedraAroundVertex list around the input triangle.
      */
-    const TetrahedraAroundTriangle& getTetrahedraAroundTriangle(TriangleID id) override;
+    TetrahedraAroundTriangle getTetrahedraAroundTriangle(TriangleID id) override;
 
 
     /** \brief Returns the index (either 0, 1 ,2 or 3) of the vertex whose global index is vertexIndex.
@@ -258,15 +259,15 @@ public:
 
 
     /** \brief Returns the TetrahedraAroundVertex array (i.e. provide the tetrahedron indices adjacent to each vertex). */
-    const sofa::helper::vector< TetrahedraAroundVertex > &getTetrahedraAroundVertexArray() ;
+    const TetrahedraShells& getTetrahedraAroundVertexArray() ;
 
 
     /** \brief Returns the TetrahedraAroundEdge array (i.e. provide the tetrahedron indices adjacent to each edge). */
-    const sofa::helper::vector< TetrahedraAroundEdge > &getTetrahedraAroundEdgeArray() ;
+    const TetrahedraShells& getTetrahedraAroundEdgeArray() ;
 
 
     /** \brief Returns the TetrahedraAroundTriangle array (i.e. provide the tetrahedron indices adjacent to each triangle). */
-    const sofa::helper::vector< TetrahedraAroundTriangle > &getTetrahedraAroundTriangleArray() ;
+    const TetrahedraShells& getTetrahedraAroundTriangleArray() ;
 
 
     bool hasTetrahedra() const;
@@ -374,7 +375,7 @@ protected:
      * @return TetrahedraAroundVertex lists in non-const.
      * @see getTetrahedraAroundVertex()
      */
-    virtual TetrahedraAroundVertex& getTetrahedraAroundVertexForModification(const PointID vertexIndex);
+    virtual TetrahedraShells::Shell getTetrahedraAroundVertexForModification(const PointID vertexIndex);
 
 
     /** \brief Returns a non-const list of tetrahedron indices around a given edge for subsequent modification.
@@ -382,7 +383,7 @@ protected:
      * @return TetrahedraAroundEdge lists in non-const.
      * @see getTetrahedraAroundEdge()
      */
-    virtual TetrahedraAroundEdge& getTetrahedraAroundEdgeForModification(const EdgeID edgeIndex);
+    virtual TetrahedraShells::Shell getTetrahedraAroundEdgeForModification(const EdgeID edgeIndex);
 
 
     /** \brief Returns a non-const list of tetrahedron indices around a given triangle for subsequent modification.
@@ -390,7 +391,7 @@ protected:
      * @return TetrahedraAroundTriangle lists in non-const.
      * @see getTetrahedraAroundTriangle()
      */
-    virtual TetrahedraAroundTriangle& getTetrahedraAroundTriangleForModification(const TriangleID triangleIndex);
+    virtual TetrahedraShells::Shell getTetrahedraAroundTriangleForModification(const TriangleID triangleIndex);
 
 
     /// \brief Function creating the data graph linked to d_tetrahedron
@@ -417,16 +418,16 @@ protected:
     sofa::helper::vector<TrianglesInTetrahedron> m_trianglesInTetrahedron;
 
     /// for each vertex provides the set of tetrahedra adjacent to that vertex.
-    sofa::helper::vector< TetrahedraAroundVertex > m_tetrahedraAroundVertex;
+    TetrahedraShells m_tetrahedraAroundVertex;
 
     /// for each edge provides the set of tetrahedra adjacent to that edge.
-    sofa::helper::vector< TetrahedraAroundEdge > m_tetrahedraAroundEdge;
+    TetrahedraShells m_tetrahedraAroundEdge;
 
     /// removed tetrahedron index
     sofa::helper::vector<TetrahedronID> m_removedTetraIndex;
 
     /// for each triangle provides the set of tetrahedra adjacent to that triangle.
-    sofa::helper::vector< TetrahedraAroundTriangle > m_tetrahedraAroundTriangle;
+    TetrahedraShells m_tetrahedraAroundTriangle;
 
 
     /// Boolean used to know if the topology Data of this container is dirty
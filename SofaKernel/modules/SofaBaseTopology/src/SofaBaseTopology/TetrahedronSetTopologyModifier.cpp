@@ -129,7 +129,7 @@ void TetrahedronSetTopologyModifier::addTetrahedronProcess(Tetrahedron t)
 
     for (PointID j=0; j<4; ++j)
     {
-        sofa::helper::vector< TetrahedronID > &shell = m_container->m_tetrahedraAroundVertex[t[j]];
+        auto shell = m_container->m_tetrahedraAroundVertex[t[j]];
         shell.push_back( tetrahedronIndex );
     }
 
@@ -169,7 +169,7 @@ void TetrahedronSetTopologyModifier::addTetrahedronProcess(Tetrahedron t)
         if (m_container->m_tetrahedraAroundTriangle.size() < m_container->getNbTriangles())
             m_container->m_tetrahedraAroundTriangle.resize(m_container->getNbTriangles());
 
-        sofa::helper::vector< TetrahedronID > &shell = m_container->m_tetrahedraAroundTriangle[triangleIndex];
+        auto shell = m_container->m_tetrahedraAroundTriangle[triangleIndex];
         shell.push_back( tetrahedronIndex );
     }
 
@@ -226,7 +226,7 @@ void TetrahedronSetTopologyModifier::addTetrahedronProcess(Tetrahedron t)
         if (m_container->m_tetrahedraAroundEdge.size() < m_container->getNbEdges())
             m_container->m_tetrahedraAroundEdge.resize(m_container->getNbEdges());
 
-        sofa::helper::vector< TetrahedronID > &shell = m_container->m_tetrahedraAroundEdge[edgeIndex];
+        auto shell = m_container->m_tetrahedraAroundEdge[edgeIndex];
         shell.push_back( tetrahedronIndex );
     }
 
@@ -322,7 +322,7 @@ void TetrahedronSetTopologyModifier::removeTetrahedraProcess( const sofa::helper
         {
             for(PointID j=0; j<4; ++j)
             {
-                sofa::helper::vector< TetrahedronID > &shell = m_container->m_tetrahedraAroundVertex[ t[j] ];
+                auto shell = m_container->m_tetrahedraAroundVertex[ t[j] ];
                 shell.erase(remove(shell.begin(), shell.end(), indices[i]), shell.end());
                 if(removeIsolatedVertices && shell.empty())
                 {
@@ -335,7 +335,7 @@ void TetrahedronSetTopologyModifier::removeTetrahedraProcess( const sofa::helper
         {
             for(EdgeID j=0; j<6; ++j)
             {
-                sofa::helper::vector< TetrahedronID > &shell = m_container->m_tetrahedraAroundEdge[ m_container->m_edgesInTetrahedron[indices[i]][j]];
+                auto shell = m_container->m_tetrahedraAroundEdge[ m_container->m_edgesInTetrahedron[indices[i]][j]];
                 shell.erase(remove(shell.begin(), shell.end(), indices[i]), shell.end());
                 if(removeIsolatedEdges && shell.empty())
                     edgeToBeRemoved.push_back(m_container->m_edgesInTetrahedron[indices[i]][j]);
@@ -346,7 +346,7 @@ void TetrahedronSetTopologyModifier::removeTetrahedraProcess( const sofa::helper
         {
             for(TriangleID j=0; j<4; ++j)
             {
-                sofa::helper::vector< TetrahedronID > &shell = m_container->m_tetrahedraAroundTriangle[ m_container->m_trianglesInTetrahedron[indices[i]][j]];
+                auto shell = m_container->m_tetrahedraAroundTriangle[ m_container->m_trianglesInTetrahedron[indices[i]][j]];
                 shell.erase(remove(shell.begin(), shell.end(), indices[i]), shell.end());
                 if(removeIsolatedTriangles && shell.empty())
                     triangleToBeRemoved.push_back(m_container->m_trianglesInTetrahedron[indices[i]][j]);
@@ -360,7 +360,7 @@ void TetrahedronSetTopologyModifier::removeTetrahedraProcess( const sofa::helper
             {
                 for(PointID j=0; j<4; ++j)
                 {
-                    sofa::helper::vector< TetrahedronID > &shell = m_container->m_tetrahedraAroundVertex[ h[j] ];
+                    auto shell = m_container->m_tetrahedraAroundVertex[ h[j] ];
                     replace(shell.begin(), shell.end(), lastTetrahedron, indices[i]);
                 }
             }
@@ -369,7 +369,7 @@ void TetrahedronSetTopologyModifier::removeTetrahedraProcess( const sofa::helper
             {
                 for(EdgeID j=0; j<6; ++j)
                 {
-                    sofa::helper::vector< TetrahedronID > &shell =  m_container->m_tetrahedraAroundEdge[ m_container->m_edgesInTetrahedron[lastTetrahedron][j]];
+                    auto shell = m_container->m_tetrahedraAroundEdge[ m_container->m_edgesInTetrahedron[lastTetrahedron][j]];
                     replace(shell.begin(), shell.end(), lastTetrahedron, indices[i]);
                 }
             }
@@ -378,7 +378,7 @@ void TetrahedronSetTopologyModifier::removeTetrahedraProcess( const sofa::helper
             {
                 for(TriangleID j=0; j<4; ++j)
                 {
-                    sofa::helper::vector< TetrahedronID > &shell =  m_container->m_tetrahedraAroundTriangle[ m_container->m_trianglesInTetrahedron[lastTetrahedron][j]];
+                    auto shell = m_container->m_tetrahedraAroundTriangle[ m_container->m_trianglesInTetrahedron[lastTetrahedron][j]];
                     replace(shell.begin(), shell.end(), lastTetrahedron, indices[i]);
                 }
             }
@@ -483,7 +483,7 @@ void TetrahedronSetTopologyModifier::removePointsProcess(const sofa::helper::vec
         {
             // updating the edges connected to the point replacing the removed one:
             // for all edges connected to the last point
-            for (sofa::helper::vector<TetrahedronID>::iterator itt=m_container->m_tetrahedraAroundVertex[lastPoint].begin();
+            for (auto itt=m_container->m_tetrahedraAroundVertex[lastPoint].begin();
                     itt!=m_container->m_tetrahedraAroundVertex[lastPoint].end(); ++itt)
             {
                 PointID vertexIndex = m_container->getVertexIndexInTetrahedron(m_tetrahedron[(*itt)],lastPoint);
@@ -491,7 +491,7 @@ void TetrahedronSetTopologyModifier::removePointsProcess(const sofa::helper::vec
             }
 
             // updating the edge shell itself (change the old index for the new one)
-            m_container->m_tetrahedraAroundVertex[ indices[i] ] = m_container->m_tetrahedraAroundVertex[ lastPoint ];
+            m_container->m_tetrahedraAroundVertex.swap( indices[i], lastPoint );
         }
 
         m_container->m_tetrahedraAroundVertex.resize( m_container->m_tetrahedraAroundVertex.size() - indices.size() );
@@ -516,7 +516,7 @@ void TetrahedronSetTopologyModifier::removeEdgesProcess( const sofa::helper::vec
         EdgeID lastEdge = (EdgeID)m_container->getNumberOfEdges() - 1;
         for (size_t i=0; i<indices.size(); ++i, --lastEdge)
         {
-            for (sofa::helper::vector<TetrahedronID>::iterator itt=m_container->m_tetrahedraAroundEdge[lastEdge].begin();
+            for (auto itt=m_container->m_tetrahedraAroundEdge[lastEdge].begin();
                     itt!=m_container->m_tetrahedraAroundEdge[lastEdge].end(); ++itt)
             {
                 EdgeID edgeIndex=m_container->getEdgeIndexInTetrahedron(m_container->m_edgesInTetrahedron[(*itt)],lastEdge);
@@ -524,7 +524,7 @@ void TetrahedronSetTopologyModifier::removeEdgesProcess( const sofa::helper::vec
             }
 
             // updating the edge shell itself (change the old index for the new one)
-            m_container->m_tetrahedraAroundEdge[ indices[i] ] = m_container->m_tetrahedraAroundEdge[ lastEdge ];
+            m_container->m_tetrahedraAroundEdge.swap( indices[i], lastEdge );
         }
 
         m_container->m_tetrahedraAroundEdge.resize( m_container->m_tetrahedraAroundEdge.size() - indices.size() );
@@ -549,7 +549,7 @@ void TetrahedronSetTopologyModifier::removeTrianglesProcess( const sofa::helper:
         TriangleID lastTriangle = (TriangleID)m_container->m_tetrahedraAroundTriangle.size() - 1;
         for (size_t i = 0; i < indices.size(); ++i, --lastTriangle)
         {
-            for (sofa::helper::vector<TetrahedronID>::iterator itt=m_container->m_tetrahedraAroundTriangle[lastTriangle].begin();
+            for (auto itt=m_container->m_tetrahedraAroundTriangle[lastTriangle].begin();
                     itt!=m_container->m_tetrahedraAroundTriangle[lastTriangle].end(); ++itt)
             {
                 TriangleID triangleIndex=m_container->getTriangleIndexInTetrahedron(m_container->m_trianglesInTetrahedron[(*itt)],lastTriangle);
@@ -557,7 +557,7 @@ void TetrahedronSetTopologyModifier::removeTrianglesProcess( const sofa::helper:
             }
 
             // updating the triangle shell itself (change the old index for the new one)
-            m_container->m_tetrahedraAroundTriangle[ indices[i] ] = m_container->m_tetrahedraAroundTriangle[ lastTriangle ];
+            m_container->m_tetrahedraAroundTriangle.swap( indices[i], lastTriangle );
         }
         m_container->m_tetrahedraAroundTriangle.resize( m_container->m_tetrahedraAroundTriangle.size() - indices.size() );
     }
@@ -575,11 +575,7 @@ void TetrahedronSetTopologyModifier::renumberPointsProcess( const sofa::helper::
         helper::WriteAccessor< Data< sofa::helper::vector<Tetrahedron> > > m_tetrahedron = m_container->d_tetrahedron;
         if(m_container->hasTetrahedraAroundVertex())
         {
-            sofa::helper::vector< sofa::helper::vector< TetrahedronID > > tetrahedraAroundVertex_cp = m_container->m_tetrahedraAroundVertex;
-            for (size_t i = 0; i < index.size(); ++i)
-            {
-                m_container->m_tetrahedraAroundVertex[i] = tetrahedraAroundVertex_cp[ index[i] ];
-            }
+            m_container->m_tetrahedraAroundVertex.permute(index);
         }
 
         for (size_t i=0; i<m_tetrahedron.size(); ++i)
@@ -22,6 +22,7 @@
 #pragma once
 #include <SofaBaseTopology/TopologyData.h>
 #include <SofaBaseTopology/TopologyDataHandler.inl>
+#include <SofaBaseTopology/TopologyRemovalRenumbering.h>
 
 namespace sofa::component::topology
 {
@@ -217,18 +218,23 @@ void TopologyData <TopologyElementType, VecT>::remove(const sofa::helper::vector
     container_type& data = *(this->beginEdit());
     if (data.size() > 0)
     {
-        Index last = Index(data.size() - 1);
+        // the successive swaps with the last element are replaced by a single pass moving the remaining elements
+        RemovalRenumbering renumbering;
+        renumbering.compute(data.size(), index);
 
-        for (std::size_t i = 0; i < index.size(); ++i)
+        if (this->m_topologyHandler)
         {
-            if (this->m_topologyHandler) {
-                this->m_topologyHandler->applyDestroyFunction(index[i], data[index[i]]);
+            const sofa::helper::vector<Index>& removedElements = renumbering.getRemovedElements();
+            for (std::size_t i = 0; i < index.size(); ++i)
+            {
+                this->m_topologyHandler->applyDestroyFunction(index[i], data[removedElements[i]]);
             }
-            this->swap(index[i], last);
-            --last;
         }
 
-        data.resize(data.size() - index.size());
+        renumbering.apply(data);
+
+        if (this->m_topologyHandler)
+            this->m_topologyHandler->applyRemovalRenumbering(renumbering);
     }
     this->endEdit();
 }
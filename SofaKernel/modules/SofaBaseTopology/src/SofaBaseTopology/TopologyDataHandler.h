@@ -26,6 +26,7 @@
 #include <sofa/core/topology/BaseTopologyData.h>
 
 #include <sofa/core/topology/BaseTopology.h>
+#include <SofaBaseTopology/TopologyRemovalRenumbering.h>
 
 #include <sofa/defaulttype/VecTypes.h>
 
@@ -118,6 +119,10 @@ public:
     /// Apply removing current elementType elements
     virtual void applyDestroyFunction(Index, value_type&) {}
 
+    /// Apply the renumbering (old index -> new index) of the remaining elements after a removal,
+    /// called once per removal after the destroy functions, when the Data has been updated
+    virtual void applyRemovalRenumbering(const RemovalRenumbering&) {}
+
     /// Apply adding current elementType elements
     virtual void applyCreateFunction(Index, value_type& t,
         const sofa::helper::vector< Index >&,
@@ -0,0 +1,125 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+#include <SofaBaseTopology/config.h>
+
+#include <sofa/helper/vector.h>
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+
+namespace sofa::component::topology
+{
+
+/** Net effect of the removal of a list of elements, as performed by the topology modifiers:
+ * each element is removed by swapping it with the last one, the index of the i-th removed element being
+ * expressed in the numbering resulting from the previous removals.
+ *
+ * Instead of swapping the values of an array element by element, the removal can be applied in a single
+ * pass: the remaining elements located after the new size are moved into the holes left by the removed
+ * ones, the sources and destinations of these moves being disjoint.
+ */
+class RemovalRenumbering
+{
+public:
+    /// Compute the renumbering resulting from the removal of the elements at the given successive indices
+    void compute(std::size_t nbElements, const sofa::helper::vector<sofa::Index>& indices)
+    {
+        assert(indices.size() <= nbElements);
+
+        m_newSize = nbElements - indices.size();
+        m_removedElements.clear();
+        m_removedElements.reserve(indices.size());
+        m_moves.clear();
+
+        // original index of the element located at a position, for the positions where it changed
+        std::unordered_map<sofa::Index, sofa::Index> elementAt;
+        elementAt.reserve(2 * indices.size());
+        const auto originalElementAt = [&elementAt](sofa::Index position)
+        {
+            const auto it = elementAt.find(position);
+            return it == elementAt.end() ? position : it->second;
+        };
+
+        sofa::Index last = sofa::Index(nbElements - 1);
+        for (const sofa::Index position : indices)
+        {
+            assert(position <= last);
+            m_removedElements.push_back(originalElementAt(position));
+            if (position != last)
+                elementAt[position] = originalElementAt(last);
+            elementAt.erase(last);
+            --last;
+        }
+
+        // all the remaining entries are in [0, newSize), and hold elements coming from [newSize, nbElements)
+        m_moves.reserve(elementAt.size());
+        for (const auto& entry : elementAt)
+            m_moves.emplace_back(entry.second, entry.first);
+        std::sort(m_moves.begin(), m_moves.end());
+
+        m_sortedRemovedElements = m_removedElements;
+        std::sort(m_sortedRemovedElements.begin(), m_sortedRemovedElements.end());
+    }
+
+    /// Number of elements after the removal
+    std::size_t getNewSize() const { return m_newSize; }
+
+    /// Original index of the element removed at each step
+    const sofa::helper::vector<sofa::Index>& getRemovedElements() const { return m_removedElements; }
+
+    /// Moves (original index, new index) of the remaining elements whose index changed, sorted by original index
+    const sofa::helper::vector< std::pair<sofa::Index, sofa::Index> >& getMoves() const { return m_moves; }
+
+    /// New index of the element of the given original index, or sofa::InvalidID if it was removed
+    sofa::Index getNewIndex(sofa::Index originalIndex) const
+    {
+        if (std::binary_search(m_sortedRemovedElements.begin(), m_sortedRemovedElements.end(), originalIndex))
+            return sofa::InvalidID;
+
+        const auto move = std::lower_bound(m_moves.begin(), m_moves.end(), originalIndex,
+            [](const std::pair<sofa::Index, sofa::Index>& m, sofa::Index index) { return m.first < index; });
+        if (move != m_moves.end() && move->first == originalIndex)
+            return move->second;
+        return originalIndex;
+    }
+
+    /// Apply the removal to an array of values indexed by element
+    template<class Container>
+    void apply(Container& values) const
+    {
+        assert(values.size() == m_newSize + m_removedElements.size());
+        for (const auto& move : m_moves)
+            values[move.second] = std::move(values[move.first]);
+        values.resize(m_newSize);
+    }
+
+protected:
+    std::size_t m_newSize { 0 };
+    sofa::helper::vector<sofa::Index> m_removedElements;
+    sofa::helper::vector<sofa::Index> m_sortedRemovedElements;
+    sofa::helper::vector< std::pair<sofa::Index, sofa::Index> > m_moves;
+};
+
+} // namespace sofa::component::topology
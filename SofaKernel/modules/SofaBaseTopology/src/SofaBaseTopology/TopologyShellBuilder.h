@@ -0,0 +1,184 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+#include <SofaBaseTopology/config.h>
+
+#include <sofa/core/topology/ElementShells.h>
+#include <sofa/helper/vector.h>
+#include <sofa/simulation/ParallelForRange.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace sofa::component::topology
+{
+
+namespace shellbuilder
+{
+
+/// Minimal number of element/sub-element incidences to build the shells in parallel
+constexpr std::size_t minParallelIncidences = 1 << 17;
+
+/// Split [0,size) in nbChunks contiguous chunks and call function(chunk, begin, end) on each of them concurrently.
+/// The chunks do not depend on the number of threads, so that successive passes see the same chunks.
+template<class Function>
+void forEachChunk(std::size_t size, std::size_t nbChunks, const Function& function)
+{
+    sofa::simulation::parallelForRange(sofa::simulation::TaskScheduler::getInstance(), 0, nbChunks, 1, [&](std::size_t chunkBegin, std::size_t chunkEnd)
+    {
+        for (std::size_t c = chunkBegin; c < chunkEnd; ++c)
+            function(c, size * c / nbChunks, size * (c + 1) / nbChunks);
+    });
+}
+
+/// Counting sort of the elements into the shells of their sub-elements.
+/// allocate(sizes) allocates the shells at their exact sizes, then shell(v) returns the first element of the shell v.
+template<class ElementID, class ElementArray, class Allocate, class GetShell>
+void countingSort(const ElementArray& elements, std::size_t nbShells, const Allocate& allocate, const GetShell& shell)
+{
+    using Element = typename ElementArray::value_type;
+    constexpr std::size_t nbIndicesPerElement = Element::static_size;
+    const std::size_t nbElements = elements.size();
+
+    std::size_t nbChunks = 1;
+    if (nbElements * nbIndicesPerElement >= minParallelIncidences && sofa::simulation::TaskScheduler::hasInstance())
+    {
+        nbChunks = sofa::simulation::TaskScheduler::getInstance()->getThreadCount();
+    }
+
+    if (nbChunks <= 1)
+    {
+        std::vector<std::size_t> counts(nbShells, 0);
+        for (std::size_t i = 0; i < nbElements; ++i)
+        {
+            for (std::size_t j = 0; j < nbIndicesPerElement; ++j)
+            {
+                assert(std::size_t(elements[i][j]) < nbShells);
+                ++counts[elements[i][j]];
+            }
+        }
+        allocate(counts);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (std::size_t i = 0; i < nbElements; ++i)
+        {
+            for (std::size_t j = 0; j < nbIndicesPerElement; ++j)
+            {
+                const auto v = elements[i][j];
+                shell(v)[counts[v]++] = ElementID(i);
+            }
+        }
+        return;
+    }
+
+    // offsets[c * nbShells + v]: number of incidences of the sub-element v in the chunk c,
+    // then position in the shell v of the first element of the chunk c referencing v
+    std::vector<std::size_t> offsets(nbChunks * nbShells, 0);
+    std::vector<std::size_t> sizes(nbShells, 0);
+
+    forEachChunk(nbElements, nbChunks, [&](std::size_t c, std::size_t begin, std::size_t end)
+    {
+        std::size_t* chunkCounts = offsets.data() + c * nbShells;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            for (std::size_t j = 0; j < nbIndicesPerElement; ++j)
+            {
+                assert(std::size_t(elements[i][j]) < nbShells);
+                ++chunkCounts[elements[i][j]];
+            }
+        }
+    });
+
+    forEachChunk(nbShells, nbChunks, [&](std::size_t, std::size_t begin, std::size_t end)
+    {
+        for (std::size_t v = begin; v < end; ++v)
+        {
+            std::size_t size = 0;
+            for (std::size_t c = 0; c < nbChunks; ++c)
+            {
+                const std::size_t count = offsets[c * nbShells + v];
+                offsets[c * nbShells + v] = size;
+                size += count;
+            }
+            sizes[v] = size;
+        }
+    });
+
+    allocate(sizes);
+
+    forEachChunk(nbElements, nbChunks, [&](std::size_t c, std::size_t begin, std::size_t end)
+    {
+        std::size_t* chunkOffsets = offsets.data() + c * nbShells;
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            for (std::size_t j = 0; j < nbIndicesPerElement; ++j)
+            {
+                const auto v = elements[i][j];
+                shell(v)[chunkOffsets[v]++] = ElementID(i);
+            }
+        }
+    });
+}
+
+} // namespace shellbuilder
+
+/** Build the shells of elements around sub-elements: shells[v] contains, in increasing order, the indices of the
+ * elements referencing the sub-element v (vertex, edge, triangle...), a sub-element being listed once per occurrence.
+ *
+ * The shells are built by counting sort: the incidences are counted first, so that each shell is allocated once at
+ * its exact size, then filled. If a TaskScheduler has been initialized on several threads by the scene, large
+ * meshes are processed in parallel chunks of elements, each chunk filling its own sub-range of each shell.
+ *
+ * This overload builds the shells stored as vectors of vectors (edges, triangles and quads around sub-elements),
+ * each shell keeping its own allocation. The tetrahedra and hexahedra shells use the flat storage below.
+ *
+ * @param elements array of elements (tetrahedra, edges in tetrahedra...), each one being a fixed-size array of sub-element indices
+ * @param nbShells number of sub-elements
+ * @param shells the resulting shells (previous content is discarded)
+ */
+template<class ElementArray, class ElementID>
+void buildElementShells(const ElementArray& elements, std::size_t nbShells, sofa::helper::vector< sofa::helper::vector<ElementID> >& shells)
+{
+    shells.clear();
+    shells.resize(nbShells);
+    shellbuilder::countingSort<ElementID>(elements, nbShells,
+        [&](const std::vector<std::size_t>& sizes)
+        {
+            for (std::size_t v = 0; v < nbShells; ++v)
+                shells[v].resize(sizes[v]);
+        },
+        [&](std::size_t v) { return shells[v].data(); });
+}
+
+/** Build the shells of elements around sub-elements in the flat storage of ElementShells: the shells are stored
+ * contiguously and in order in one index array (compressed sparse rows), shells[v] listing in increasing order the
+ * elements referencing the sub-element v. Same counting sort as above, the index array being allocated once.
+ */
+template<class ElementArray, class ElementID>
+void buildElementShells(const ElementArray& elements, std::size_t nbShells, sofa::core::topology::ElementShells<ElementID>& shells)
+{
+    shellbuilder::countingSort<ElementID>(elements, nbShells,
+        [&](const std::vector<std::size_t>& sizes) { shells.allocate(sizes); },
+        [&](std::size_t v) { return shells.data(v); });
+}
+
+} // namespace sofa::component::topology
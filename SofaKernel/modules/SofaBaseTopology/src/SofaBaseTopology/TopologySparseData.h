@@ -129,6 +129,9 @@ public:
 
 
 protected:
+    /// Number of elements of the topology, before the removal being applied
+    std::size_t getNbTopologyElements() const;
+
     // same size as SparseData but contain id of element link to each data[]
     sofa::helper::vector<Index> m_map2Elements;
 
@@ -24,6 +24,8 @@
 #include <SofaBaseTopology/TopologyData.inl>
 #include <SofaBaseTopology/TopologyDataHandler.inl>
 
+#include <type_traits>
+
 namespace sofa::component::topology
 {
 
@@ -140,35 +142,66 @@ void TopologySparseData <TopologyElementType, VecT>::remove(const sofa::helper::
     // get the sparseData map
     sofa::helper::vector <Index>& keys = this->getMap2Elements();
     container_type& data = *(this->beginEdit());
-    Size last = data.size() - 1;
 
-    // check for each element remove if it concern this sparseData
-    unsigned int cptDone = 0;
-    for (Size i = 0; i < index.size(); ++i)
-    {
-        unsigned int elemId = index[i];
-        unsigned int id = this->indexOfElement(elemId);
+    // the keys are renumbered as the topology elements: the removal is applied in a single pass,
+    // dropping the values of the removed elements and updating the keys of the remaining ones
+    RemovalRenumbering renumbering;
+    renumbering.compute(getNbTopologyElements(), index);
 
-        if (id == sofa::InvalidID)
-            continue;
-
-        cptDone++;
-        if (this->m_topologyHandler)
+    Size nbKept = 0;
+    for (Size id = 0; id < keys.size(); ++id)
+    {
+        const Index newIndex = renumbering.getNewIndex(keys[id]);
+        if (newIndex == sofa::InvalidID)
         {
-            this->m_topologyHandler->applyDestroyFunction(id, data[id]);
+            if (this->m_topologyHandler)
+            {
+                this->m_topologyHandler->applyDestroyFunction(id, data[id]);
+            }
+            continue;
         }
-        this->swap(id, last);
-        --last;
+
+        if (nbKept != id)
+            data[nbKept] = std::move(data[id]);
+        keys[nbKept] = newIndex;
+        ++nbKept;
     }
 
-    data.resize(data.size() - cptDone);
-    keys.resize(keys.size() - cptDone);
-    this->lastElementIndex = last;
+    data.resize(nbKept);
+    keys.resize(nbKept);
+    this->lastElementIndex = Index(renumbering.getNewSize() - 1);
+
+    if (this->m_topologyHandler)
+        this->m_topologyHandler->applyRemovalRenumbering(renumbering);
 
     this->endEdit();
 }
 
 
+template <typename TopologyElementType, typename VecT>
+std::size_t TopologySparseData <TopologyElementType, VecT>::getNbTopologyElements() const
+{
+    using core::topology::BaseMeshTopology;
+
+    // the topology still holds the elements being removed when the data is updated
+    if (this->m_topology == nullptr)
+        return std::size_t(this->lastElementIndex) + 1;
+
+    if constexpr (std::is_same_v<TopologyElementType, BaseMeshTopology::Point>)
+        return this->m_topology->getNbPoints();
+    else if constexpr (std::is_same_v<TopologyElementType, BaseMeshTopology::Edge>)
+        return this->m_topology->getNbEdges();
+    else if constexpr (std::is_same_v<TopologyElementType, BaseMeshTopology::Triangle>)
+        return this->m_topology->getNbTriangles();
+    else if constexpr (std::is_same_v<TopologyElementType, BaseMeshTopology::Quad>)
+        return this->m_topology->getNbQuads();
+    else if constexpr (std::is_same_v<TopologyElementType, BaseMeshTopology::Tetrahedron>)
+        return this->m_topology->getNbTetrahedra();
+    else
+        return this->m_topology->getNbHexahedra();
+}
+
+
 template <typename TopologyElementType, typename VecT>
 void TopologySparseData <TopologyElementType, VecT>::renumber(const sofa::helper::vector<Index>&)
 {
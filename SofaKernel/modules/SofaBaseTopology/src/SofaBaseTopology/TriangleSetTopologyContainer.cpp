@@ -20,6 +20,7 @@
 * Contact information: contact@sofa-framework.org                             *
 ******************************************************************************/
 #include <SofaBaseTopology/TriangleSetTopologyContainer.h>
+#include <SofaBaseTopology/TopologyShellBuilder.h>
 #include <sofa/core/topology/TopologyHandler.h>
 
 #include <sofa/core/ObjectFactory.h>
@@ -119,13 +120,7 @@ void TriangleSetTopologyContainer::createTrianglesAroundVertexArray()
     if (nbPoints == 0) // in case only Data have been copied and not going thourgh AddTriangle methods.
         this->setNbPoints(sofa::Size(d_initPoints.getValue().size()));
 
-    m_trianglesAroundVertex.resize(getNbPoints());
-    for (size_t i = 0; i < m_triangle.size(); ++i)
-    {
-        // adding edge i in the edge shell of both points
-        for (unsigned int j=0; j<3; ++j)
-            m_trianglesAroundVertex[ m_triangle[i][j]  ].push_back( (TriangleID)i );
-    }
+    buildElementShells(m_triangle.ref(), getNbPoints(), m_trianglesAroundVertex);
 }
 
 void TriangleSetTopologyContainer::createTrianglesAroundEdgeArray ()
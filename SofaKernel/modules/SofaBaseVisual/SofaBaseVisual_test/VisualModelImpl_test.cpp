@@ -23,6 +23,7 @@
 #include <gtest/gtest.h>
 #include <SofaBaseVisual/VisualModelImpl.h>
 #include <sofa/defaulttype/VecTypes.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 namespace sofa {
 
@@ -120,4 +121,115 @@ TEST( VisualModelImpl_test , checkThatMembersAreCorrectlyConstructed )
     ASSERT_EQ(1u, visualModel.xforms.size());
 }
 
+/// Fill a model with a bumpy grid of n x n cells, made of triangles in its lower half and of quads in its upper half
+void createGrid(StubVisualModelImpl& visualModel, unsigned int n)
+{
+    using VisualModelImpl = component::visualmodel::VisualModelImpl;
+    helper::WriteAccessor< Data<VisualModelImpl::VecCoord> > positions = visualModel.m_positions;
+    helper::WriteAccessor< Data<VisualModelImpl::VecTexCoord> > texcoords = visualModel.m_vtexcoords;
+    helper::WriteAccessor< Data<VisualModelImpl::VecVisualTriangle> > triangles = visualModel.m_triangles;
+    helper::WriteAccessor< Data<VisualModelImpl::VecVisualQuad> > quads = visualModel.m_quads;
+
+    for (unsigned int j = 0; j <= n; j++)
+    {
+        for (unsigned int i = 0; i <= n; i++)
+        {
+            positions.push_back(VisualModelImpl::Coord(i, j, std::sin(0.3*i) * std::cos(0.7*j)));
+            texcoords.push_back(VisualModelImpl::TexCoord(float(i)/n, float(j)/n));
+        }
+    }
+
+    for (unsigned int j = 0; j < n; j++)
+    {
+        for (unsigned int i = 0; i < n; i++)
+        {
+            const unsigned int p = j*(n+1) + i;
+            if (j < n/2)
+            {
+                triangles.push_back(VisualModelImpl::VisualTriangle(p, p+1, p+n+2));
+                triangles.push_back(VisualModelImpl::VisualTriangle(p, p+n+2, p+n+1));
+            }
+            else
+            {
+                quads.push_back(VisualModelImpl::VisualQuad(p, p+1, p+n+2, p+n+1));
+            }
+        }
+    }
+}
+
+void checkSameVectors(const component::visualmodel::VisualModelImpl::VecCoord& expected, const component::visualmodel::VisualModelImpl::VecCoord& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (std::size_t i = 0; i < expected.size(); i++)
+        for (std::size_t c = 0; c < 3; c++)
+            ASSERT_EQ(expected[i][c], actual[i][c]) << "vertex " << i;
+}
+
+// The parallel and incremental normal updates must give exactly the same normals and tangents as the sequential ones
+TEST( VisualModelImpl_test , checkParallelAndIncrementalNormals )
+{
+    simulation::TaskScheduler* taskScheduler = simulation::TaskScheduler::getInstance();
+    if (taskScheduler->getThreadCount() < 1)
+        taskScheduler->init(4);
+
+    const unsigned int n = 80;
+    StubVisualModelImpl models[4];
+    for (auto& model : models)
+    {
+        createGrid(model, n);
+        model.m_computeTangents.setValue(true);
+    }
+    models[1].d_parallelNormals.setValue(true);
+    models[2].d_incrementalNormals.setValue(true);
+    models[3].d_parallelNormals.setValue(true);
+    models[3].d_incrementalNormals.setValue(true);
+
+    for (unsigned int step = 0; step < 3; step++)
+    {
+        if (step > 0)
+        {
+            // move a few vertices
+            for (auto& model : models)
+            {
+                helper::WriteAccessor< Data<component::visualmodel::VisualModelImpl::VecCoord> > positions = model.m_positions;
+                for (std::size_t i = step; i < positions.size(); i += 97*step)
+                    positions[i][2] += 0.5;
+            }
+        }
+
+        for (auto& model : models)
+        {
+            model.computeNormals();
+            model.computeTangents();
+        }
+
+        for (std::size_t m = 1; m < 4; m++)
+        {
+            checkSameVectors(models[0].m_vnormals.getValue(), models[m].m_vnormals.getValue());
+            checkSameVectors(models[0].m_vtangents.getValue(), models[m].m_vtangents.getValue());
+            checkSameVectors(models[0].m_vbitangents.getValue(), models[m].m_vbitangents.getValue());
+        }
+    }
+
+    // vertices sharing the same normal index
+    for (auto& model : models)
+    {
+        helper::WriteAccessor< Data<helper::vector<component::visualmodel::VisualModelImpl::visual_index_type> > > vertNormIdx = model.m_vertNormIdx;
+        for (std::size_t i = 0; i < model.m_positions.getValue().size(); i++)
+            vertNormIdx.push_back(component::visualmodel::VisualModelImpl::visual_index_type(i/2));
+    }
+    for (unsigned int step = 0; step < 2; step++)
+    {
+        for (auto& model : models)
+        {
+            helper::WriteAccessor< Data<component::visualmodel::VisualModelImpl::VecCoord> > positions = model.m_positions;
+            positions[50+step][2] -= 0.25;
+        }
+        for (auto& model : models)
+            model.computeNormals();
+        for (std::size_t m = 1; m < 4; m++)
+            checkSameVectors(models[0].m_vnormals.getValue(), models[m].m_vnormals.getValue());
+    }
+}
+
 } //sofa
@@ -41,10 +41,12 @@
 #include <sofa/helper/system/FileRepository.h>
 #include <sofa/helper/types/Material.h>
 #include <sofa/helper/AdvancedTimer.h>
+#include <sofa/simulation/ParallelForRange.h>
 
 #include <sstream>
 #include <map>
 #include <memory>
+#include <functional>
 
 namespace sofa::component::visualmodel
 {
@@ -55,6 +57,53 @@ using namespace sofa::defaulttype;
 using namespace sofa::core::topology;
 using helper::vector;
 
+namespace vertexnormals
+{
+
+/// Minimum number of faces (or vertices) handled by each task of the parallel normal computations
+constexpr std::size_t minElementsPerTask = 1024;
+
+/// Apply f on contiguous ranges of [0,n), with the threads of the TaskScheduler if parallel is set
+void forEachRange(bool parallel, std::size_t n, const std::function<void(std::size_t,std::size_t)>& f)
+{
+    simulation::TaskScheduler* taskScheduler = parallel ? simulation::TaskScheduler::getInstance() : nullptr;
+    simulation::parallelForRange(taskScheduler, 0, n, minElementsPerTask, f);
+}
+
+/// Build the list of face entries around each slot (vertex or normal index), in CSR format.
+/// Entries are stored in the order the sequential loops of computeNormals accumulate them,
+/// so that the gathered sums are exactly the same.
+template<class SlotOf>
+void buildFaceAdjacency(std::size_t nbSlots,
+                        const VisualModelImpl::VecVisualTriangle& triangles, const VisualModelImpl::VecVisualQuad& quads, SlotOf slotOf,
+                        vector<VisualModelImpl::visual_index_type>& begin, vector<VisualModelImpl::visual_index_type>& entries)
+{
+    using visual_index_type = VisualModelImpl::visual_index_type;
+    const std::size_t nbTriangles = triangles.size();
+
+    begin.clear();
+    begin.resize(nbSlots+1, 0);
+    for (const auto& t : triangles)
+        for (std::size_t c = 0; c < 3; c++)
+            ++begin[slotOf(t[c])+1];
+    for (const auto& q : quads)
+        for (std::size_t c = 0; c < 4; c++)
+            ++begin[slotOf(q[c])+1];
+    for (std::size_t i = 0; i < nbSlots; i++)
+        begin[i+1] += begin[i];
+
+    entries.resize(begin[nbSlots]);
+    vector<visual_index_type> next(begin.begin(), begin.end()-1);
+    for (std::size_t i = 0; i < nbTriangles; i++)
+        for (std::size_t c = 0; c < 3; c++)
+            entries[next[slotOf(triangles[i][c])]++] = visual_index_type(i);
+    for (std::size_t i = 0; i < quads.size(); i++)
+        for (std::size_t c = 0; c < 4; c++)
+            entries[next[slotOf(quads[i][c])]++] = visual_index_type(nbTriangles + 4*i + c);
+}
+
+} // namespace vertexnormals
+
 Vec3State::Vec3State()
     : m_positions(initData(&m_positions, "position", "Vertices coordinates"))
     , m_restPositions(initData(&m_restPositions, "restPosition", "Vertices rest coordinates"))
@@ -188,6 +237,9 @@ VisualModelImpl::VisualModelImpl() //const std::string &name, std::string filena
     , m_handleDynamicTopology (initData   (&m_handleDynamicTopology, true, "handleDynamicTopology", "True if topological changes should be handled"))
     , m_fixMergedUVSeams (initData   (&m_fixMergedUVSeams, true, "fixMergedUVSeams", "True if UV seams should be handled even when duplicate UVs are merged"))
     , m_keepLines (initData   (&m_keepLines, false, "keepLines", "keep and draw lines (false by default)"))
+    , d_parallelNormals (initData   (&d_parallelNormals, false, "parallelNormals", "True if normals and tangents should be recomputed with the threads of the TaskScheduler"))
+    , d_incrementalNormals (initData   (&d_incrementalNormals, false, "incrementalNormals", "True if only the normals of the vertices close to a moved vertex should be recomputed"))
+    , d_deferNormalsToDraw (initData   (&d_deferNormalsToDraw, false, "deferNormalsToDraw", "True if normals and tangents should be recomputed when the model is drawn rather than at each updateVisual. Several simulation steps between two frames then pay for a single update, but the normals are not up to date until the model is drawn"))
     , m_vertices2       (initData   (&m_vertices2, "vertices", "vertices of the model (only if vertices have multiple normals/texcoords, otherwise positions are used)"))
     , m_vtexcoords      (initData   (&m_vtexcoords, "texcoords", "coordinates of the texture"))
     , m_vtangents       (initData   (&m_vtangents, "tangents", "tangents for normal mapping"))
@@ -197,6 +249,8 @@ VisualModelImpl::VisualModelImpl() //const std::string &name, std::string filena
     , m_quads           (initData   (&m_quads, "quads", "quads of the model"))
     , m_vertPosIdx      (initData   (&m_vertPosIdx, "vertPosIdx", "If vertices have multiple normals/texcoords stores vertices position indices"))
     , m_vertNormIdx     (initData   (&m_vertNormIdx, "vertNormIdx", "If vertices have multiple normals/texcoords stores vertices normal indices"))
+    , m_adjacencyNbVertices(0)
+    , m_normalsOutdated(false)
     , fileMesh          (initData   (&fileMesh, "filename"," Path to an ogl model"))
     , texturename       (initData   (&texturename, "texturename", "Name of the Texture"))
     , m_translation     (initData   (&m_translation, Vec3Real(), "translation", "Initial Translation of the object"))
@@ -213,6 +267,7 @@ VisualModelImpl::VisualModelImpl() //const std::string &name, std::string filena
     , xformsModified(false)
 {
     m_topology = nullptr;
+    std::fill(std::begin(m_adjacencyCounters), std::end(m_adjacencyCounters), -1);
 
     //material.setDisplayed(false);
     addAlias(&fileMesh, "fileMesh");
@@ -280,6 +335,8 @@ bool VisualModelImpl::hasOpaque()
 
 void VisualModelImpl::drawVisual(const core::visual::VisualParams* vparams)
 {
+    updateDeferredNormals();
+
     //Update external buffers (like VBO) if the mesh change AFTER doing the updateVisual() process
     if(m_vertices2.isDirty())
     {
@@ -292,12 +349,14 @@ void VisualModelImpl::drawVisual(const core::visual::VisualParams* vparams)
 
 void VisualModelImpl::drawTransparent(const core::visual::VisualParams* vparams)
 {
+    updateDeferredNormals();
     if (hasTransparent())
         internalDraw(vparams,true);
 }
 
 void VisualModelImpl::drawShadow(const core::visual::VisualParams* vparams)
 {
+    updateDeferredNormals();
     if (hasOpaque() && getCastShadow())
         internalDraw(vparams, false);
 }
@@ -900,6 +959,9 @@ void VisualModelImpl::init()
     m_rotation.setValue(Vec3Real());
     m_scale.setValue(Vec3Real(1,1,1));
 
+    if (d_parallelNormals.getValue())
+        simulation::initTaskScheduler();
+
     VisualModel::init();
     updateVisual();
 }
@@ -910,6 +972,12 @@ void VisualModelImpl::computeNormals()
     //const VecCoord& vertices = m_vertices2.getValue();
     if (vertices.empty() || (!m_updateNormals.getValue() && (m_vnormals.getValue()).size() == (vertices).size())) return;
 
+    if (d_parallelNormals.getValue() || d_incrementalNormals.getValue())
+    {
+        computeNormalsFromAdjacency();
+        return;
+    }
+
     const VecVisualTriangle& triangles = m_triangles.getValue();
     const VecVisualQuad& quads = m_quads.getValue();
     const helper::vector<visual_index_type> &vertNormIdx = m_vertNormIdx.getValue();
@@ -1016,6 +1084,201 @@ void VisualModelImpl::computeNormals()
     }
 }
 
+bool VisualModelImpl::updateNormalAdjacency()
+{
+    const std::size_t nbVertices = getVertices().size();
+    const int counters[3] = { m_triangles.getCounter(), m_quads.getCounter(), m_vertNormIdx.getCounter() };
+    if (std::equal(std::begin(counters), std::end(counters), std::begin(m_adjacencyCounters))
+            && nbVertices == m_adjacencyNbVertices && !m_vertexFacesBegin.empty())
+        return false;
+
+    const VecVisualTriangle& triangles = m_triangles.getValue();
+    const VecVisualQuad& quads = m_quads.getValue();
+    const helper::vector<visual_index_type> &vertNormIdx = m_vertNormIdx.getValue();
+
+    vertexnormals::buildFaceAdjacency(nbVertices, triangles, quads,
+                                      [](visual_index_type v) { return v; },
+                                      m_vertexFacesBegin, m_vertexFaces);
+    if (vertNormIdx.empty())
+    {
+        m_normalFacesBegin.clear();
+        m_normalFaces.clear();
+    }
+    else
+    {
+        std::size_t nbn = 0;
+        for (std::size_t i = 0; i < vertNormIdx.size(); i++)
+        {
+            if (vertNormIdx[i] >= nbn)
+                nbn = vertNormIdx[i]+1;
+        }
+        vertexnormals::buildFaceAdjacency(nbn, triangles, quads,
+                                          [&vertNormIdx](visual_index_type v) { return vertNormIdx[v]; },
+                                          m_normalFacesBegin, m_normalFaces);
+    }
+
+    std::copy(std::begin(counters), std::end(counters), std::begin(m_adjacencyCounters));
+    m_adjacencyNbVertices = nbVertices;
+    return true;
+}
+
+void VisualModelImpl::computeNormalsFromAdjacency()
+{
+    const bool parallel = d_parallelNormals.getValue();
+    const bool incremental = d_incrementalNormals.getValue();
+    bool fullUpdate = updateNormalAdjacency() || !incremental;
+
+    const VecCoord& vertices = getVertices();
+    const VecVisualTriangle& triangles = m_triangles.getValue();
+    const VecVisualQuad& quads = m_quads.getValue();
+    const helper::vector<visual_index_type> &vertNormIdx = m_vertNormIdx.getValue();
+    const std::size_t nbTriangles = triangles.size();
+    const std::size_t nbFaces = nbTriangles + quads.size();
+    const bool useNormIdx = !vertNormIdx.empty();
+    const vector<visual_index_type>& facesBegin = useNormIdx ? m_normalFacesBegin : m_vertexFacesBegin;
+    const vector<visual_index_type>& faces = useNormIdx ? m_normalFaces : m_vertexFaces;
+    const std::size_t nbSlots = facesBegin.size() - 1;
+
+    helper::WriteAccessor< Data<VecDeriv> > vnormals = m_vnormals;
+    if (vnormals.size() != vertices.size() || m_normalsPositions.size() != vertices.size()
+            || (useNormIdx && m_slotNormals.size() != nbSlots))
+        fullUpdate = true;
+    vnormals.resize(vertices.size());
+    if (useNormIdx)
+        m_slotNormals.resize(nbSlots);
+    VecDeriv& slotNormals = useNormIdx ? m_slotNormals : vnormals.wref();
+
+    // normal of a triangle, or of the 4 corners of a quad
+    const auto computeFaceNormal = [&](std::size_t i)
+    {
+        if (i < nbTriangles)
+        {
+            const Coord& v1 = vertices[triangles[i][0]];
+            const Coord& v2 = vertices[triangles[i][1]];
+            const Coord& v3 = vertices[triangles[i][2]];
+            m_faceNormals[i] = cross(v2-v1, v3-v1);
+        }
+        else
+        {
+            const VisualQuad& q = quads[i-nbTriangles];
+            const Coord & v1 = vertices[q[0]];
+            const Coord & v2 = vertices[q[1]];
+            const Coord & v3 = vertices[q[2]];
+            const Coord & v4 = vertices[q[3]];
+            Coord* n = &m_faceNormals[nbTriangles + 4*(i-nbTriangles)];
+            n[0] = cross(v2-v1, v4-v1);
+            n[1] = cross(v3-v2, v1-v2);
+            n[2] = cross(v4-v3, v2-v3);
+            n[3] = cross(v1-v4, v3-v4);
+        }
+    };
+
+    // sum of the normals of the faces around a vertex (or normal index)
+    const auto computeSlotNormal = [&](std::size_t s)
+    {
+        Deriv n;
+        n.clear();
+        for (visual_index_type e = facesBegin[s]; e < facesBegin[s+1]; e++)
+            n += m_faceNormals[faces[e]];
+        n.normalize();
+        slotNormals[s] = n;
+    };
+
+    if (fullUpdate)
+    {
+        m_faceNormals.resize(nbTriangles + 4*quads.size());
+        vertexnormals::forEachRange(parallel, nbFaces, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+                computeFaceNormal(i);
+        });
+        vertexnormals::forEachRange(parallel, nbSlots, [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t s = begin; s < end; s++)
+                computeSlotNormal(s);
+        });
+
+        if (incremental)
+        {
+            m_normalsPositions = vertices;
+            m_faceFlags.clear();
+            m_faceFlags.resize(nbFaces, 0);
+            m_slotFlags.clear();
+            m_slotFlags.resize(nbSlots, 0);
+        }
+        else
+        {
+            m_normalsPositions.clear();
+        }
+    }
+    else
+    {
+        // faces around the vertices which moved since the last update
+        m_dirtyFaces.clear();
+        for (std::size_t i = 0; i < vertices.size(); i++)
+        {
+            const Coord& p = vertices[i];
+            Coord& lastP = m_normalsPositions[i];
+            if (p[0] == lastP[0] && p[1] == lastP[1] && p[2] == lastP[2])
+                continue;
+            lastP = p;
+            for (visual_index_type e = m_vertexFacesBegin[i]; e < m_vertexFacesBegin[i+1]; e++)
+            {
+                const visual_index_type entry = m_vertexFaces[e];
+                const visual_index_type f = (entry < nbTriangles) ? entry : visual_index_type(nbTriangles + (entry-nbTriangles)/4);
+                if (!m_faceFlags[f])
+                {
+                    m_faceFlags[f] = 1;
+                    m_dirtyFaces.push_back(f);
+                }
+            }
+        }
+        if (m_dirtyFaces.empty())
+            return;
+
+        // vertices (or normal indices) touching these faces
+        m_dirtySlots.clear();
+        for (const visual_index_type f : m_dirtyFaces)
+        {
+            m_faceFlags[f] = 0;
+            const std::size_t nbCorners = (f < nbTriangles) ? 3 : 4;
+            const visual_index_type* corners = (f < nbTriangles) ? triangles[f].data() : quads[f-nbTriangles].data();
+            for (std::size_t c = 0; c < nbCorners; c++)
+            {
+                const visual_index_type s = useNormIdx ? vertNormIdx[corners[c]] : corners[c];
+                if (!m_slotFlags[s])
+                {
+                    m_slotFlags[s] = 1;
+                    m_dirtySlots.push_back(s);
+                }
+            }
+        }
+
+        vertexnormals::forEachRange(parallel, m_dirtyFaces.size(), [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+                computeFaceNormal(m_dirtyFaces[i]);
+        });
+        vertexnormals::forEachRange(parallel, m_dirtySlots.size(), [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+            {
+                computeSlotNormal(m_dirtySlots[i]);
+                m_slotFlags[m_dirtySlots[i]] = 0;
+            }
+        });
+    }
+
+    if (useNormIdx)
+    {
+        vertexnormals::forEachRange(parallel, vertices.size(), [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t i = begin; i < end; i++)
+                vnormals[i] = m_slotNormals[vertNormIdx[i]];
+        });
+    }
+}
+
 VisualModelImpl::Coord VisualModelImpl::computeTangent(const Coord &v1, const Coord &v2, const Coord &v3,
                                                        const TexCoord &t1, const TexCoord &t2, const TexCoord &t3)
 {
@@ -1036,6 +1299,12 @@ void VisualModelImpl::computeTangents()
 {
     if (!m_computeTangents.getValue() || !m_vtexcoords.getValue().size()) return;
 
+    if (d_parallelNormals.getValue())
+    {
+        computeTangentsFromAdjacency();
+        return;
+    }
+
     const VecVisualTriangle& triangles = m_triangles.getValue();
     const VecVisualQuad& quads = m_quads.getValue();
     const VecCoord& vertices = getVertices();
@@ -1126,6 +1395,88 @@ void VisualModelImpl::computeTangents()
     m_vbitangents.endEdit();
 }
 
+void VisualModelImpl::computeTangentsFromAdjacency()
+{
+    updateNormalAdjacency();
+
+    const VecVisualTriangle& triangles = m_triangles.getValue();
+    const VecVisualQuad& quads = m_quads.getValue();
+    const VecCoord& vertices = getVertices();
+    const VecTexCoord& texcoords = m_vtexcoords.getValue();
+    const VecCoord& normals = m_vnormals.getValue();
+    helper::WriteOnlyAccessor< Data<VecCoord> > tangents = m_vtangents;
+    helper::WriteOnlyAccessor< Data<VecCoord> > bitangents = m_vbitangents;
+    const std::size_t nbTriangles = triangles.size();
+    const bool fixMergedUVSeams = m_fixMergedUVSeams.getValue();
+
+    tangents.resize(vertices.size());
+    bitangents.resize(vertices.size());
+
+    // tangents of each triangle and of each quad corner. The accumulated bitangents are
+    // overwritten by the orthogonalization below, so they are not computed here.
+    m_faceTangents.resize(nbTriangles + 4*quads.size());
+    vertexnormals::forEachRange(true, nbTriangles + quads.size(), [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            if (i < nbTriangles)
+            {
+                const VisualTriangle& tri = triangles[i];
+                TexCoord t1 = texcoords[tri[0]];
+                TexCoord t2 = texcoords[tri[1]];
+                TexCoord t3 = texcoords[tri[2]];
+                if (fixMergedUVSeams)
+                {
+                    for (Size j=0; j<t1.size(); ++j)
+                    {
+                        t2[j] += helper::rnear(t1[j]-t2[j]);
+                        t3[j] += helper::rnear(t1[j]-t3[j]);
+                    }
+                }
+                m_faceTangents[i] = computeTangent(vertices[tri[0]], vertices[tri[1]], vertices[tri[2]], t1, t2, t3);
+            }
+            else
+            {
+                const VisualQuad& q = quads[i-nbTriangles];
+                const Coord & v1 = vertices[q[0]];
+                const Coord & v2 = vertices[q[1]];
+                const Coord & v3 = vertices[q[2]];
+                const Coord & v4 = vertices[q[3]];
+                const TexCoord t1 = texcoords[q[0]];
+                const TexCoord t2 = texcoords[q[1]];
+                const TexCoord t3 = texcoords[q[2]];
+                const TexCoord t4 = texcoords[q[3]];
+
+                Coord t123 = computeTangent(v1, v2, v3, t1, t2, t3);
+                Coord t234 = computeTangent(v2, v3, v4, t2, t3, t4);
+                Coord t341 = computeTangent(v3, v4, v1, t3, t4, t1);
+                Coord t412 = computeTangent(v4, v1, v2, t4, t1, t2);
+
+                Coord* t = &m_faceTangents[nbTriangles + 4*(i-nbTriangles)];
+                t[0] = t123        + t341 + t412;
+                t[1] = t123 + t234        + t412;
+                t[2] = t123 + t234 + t341;
+                t[3] =        t234 + t341 + t412;
+            }
+        }
+    });
+
+    vertexnormals::forEachRange(true, vertices.size(), [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; i++)
+        {
+            Coord t;
+            t.clear();
+            for (visual_index_type e = m_vertexFacesBegin[i]; e < m_vertexFacesBegin[i+1]; e++)
+                t += m_faceTangents[m_vertexFaces[e]];
+
+            const Coord& n = normals[i];
+            bitangents[i] = sofa::defaulttype::cross(n, t.normalized());
+            tangents[i] = sofa::defaulttype::cross(bitangents[i], n);
+        }
+    });
+}
+
 void VisualModelImpl::computeBBox(const core::ExecParams*, bool)
 {
     const VecCoord& x = getVertices(); //m_vertices.getValue();
@@ -1279,19 +1630,27 @@ void VisualModelImpl::updateVisual()
         computePositions();
         sofa::helper::AdvancedTimer::stepEnd("VisualModelImpl::computePositions");
 
-        sofa::helper::AdvancedTimer::stepBegin("VisualModelImpl::updateBuffers");
-        updateBuffers();
-        sofa::helper::AdvancedTimer::stepEnd("VisualModelImpl::updateBuffers");
-
-        sofa::helper::AdvancedTimer::stepBegin("VisualModelImpl::computeNormals");
-        computeNormals();
-        sofa::helper::AdvancedTimer::stepEnd("VisualModelImpl::computeNormals");
-        
-        if (m_updateTangents.getValue())
+        if (d_deferNormalsToDraw.getValue())
         {
-            sofa::helper::AdvancedTimer::stepBegin("VisualModelImpl::computeTangents");
-            computeTangents();
-            sofa::helper::AdvancedTimer::stepEnd("VisualModelImpl::computeTangents");
+            // normals, tangents and buffers are updated by the next draw
+            m_normalsOutdated = true;
+        }
+        else
+        {
+            sofa::helper::AdvancedTimer::stepBegin("VisualModelImpl::updateBuffers");
+            updateBuffers();
+            sofa::helper::AdvancedTimer::stepEnd("VisualModelImpl::updateBuffers");
+
+            sofa::helper::AdvancedTimer::stepBegin("VisualModelImpl::computeNormals");
+            computeNormals();
+            sofa::helper::AdvancedTimer::stepEnd("VisualModelImpl::computeNormals");
+
+            if (m_updateTangents.getValue())
+            {
+                sofa::helper::AdvancedTimer::stepBegin("VisualModelImpl::computeTangents");
+                computeTangents();
+                sofa::helper::AdvancedTimer::stepEnd("VisualModelImpl::computeTangents");
+            }
         }
         modified = false;
 
@@ -1313,6 +1672,28 @@ void VisualModelImpl::updateVisual()
 }
 
 
+void VisualModelImpl::updateDeferredNormals()
+{
+    if (!m_normalsOutdated)
+        return;
+    m_normalsOutdated = false;
+
+    sofa::helper::AdvancedTimer::stepBegin("VisualModelImpl::computeNormals");
+    computeNormals();
+    sofa::helper::AdvancedTimer::stepEnd("VisualModelImpl::computeNormals");
+
+    if (m_updateTangents.getValue())
+    {
+        sofa::helper::AdvancedTimer::stepBegin("VisualModelImpl::computeTangents");
+        computeTangents();
+        sofa::helper::AdvancedTimer::stepEnd("VisualModelImpl::computeTangents");
+    }
+
+    sofa::helper::AdvancedTimer::stepBegin("VisualModelImpl::updateBuffers");
+    updateBuffers();
+    sofa::helper::AdvancedTimer::stepEnd("VisualModelImpl::updateBuffers");
+}
+
 void VisualModelImpl::computePositions()
 {
     const helper::vector<visual_index_type> &vertPosIdx = m_vertPosIdx.getValue();
@@ -1854,6 +2235,8 @@ void VisualModelImpl::initVisual()
 
 void VisualModelImpl::exportOBJ(std::string name, std::ostream* out, std::ostream* mtl, Index& vindex, Index& nindex, Index& tindex, int& count)
 {
+    updateDeferredNormals();
+
     *out << "g "<<name<<"\n";
 
     if (mtl != nullptr) // && !material.name.empty())
@@ -113,6 +113,9 @@ public:
     Data<bool> m_handleDynamicTopology; ///< True if topological changes should be handled
     Data<bool> m_fixMergedUVSeams; ///< True if UV seams should be handled even when duplicate UVs are merged
     Data<bool> m_keepLines; ///< keep and draw lines (false by default)
+    Data<bool> d_parallelNormals; ///< True if normals and tangents should be recomputed with the threads of the TaskScheduler
+    Data<bool> d_incrementalNormals; ///< True if only the normals of the vertices close to a moved vertex should be recomputed
+    Data<bool> d_deferNormalsToDraw; ///< True if normals and tangents should be recomputed when the model is drawn rather than at each updateVisual
 
     Data< VecCoord > m_vertices2; ///< vertices of the model (only if vertices have multiple normals/texcoords, otherwise positions are used)
     topology::PointData< VecTexCoord > m_vtexcoords; ///< coordinates of the texture
@@ -134,6 +137,37 @@ public:
     /// Rendering method.
     virtual void internalDraw(const core::visual::VisualParams* /*vparams*/, bool /*transparent*/) {}
 
+protected:
+    /// Rebuild the vertex-to-face adjacency if the faces or the number of vertices changed. Return true if it was rebuilt.
+    bool updateNormalAdjacency();
+    /// Gather the normals of each vertex from the adjacency, only around moved vertices if d_incrementalNormals is set
+    void computeNormalsFromAdjacency();
+    /// Gather the tangents of each vertex from the adjacency with the threads of the TaskScheduler
+    void computeTangentsFromAdjacency();
+    /// Recompute the normals and tangents postponed by updateVisual when d_deferNormalsToDraw is set
+    void updateDeferredNormals();
+
+    /// Faces around each vertex, in CSR format. An entry is the index of a triangle t, or nbTriangles+4*q+c for the corner c of a quad q.
+    helper::vector<visual_index_type> m_vertexFacesBegin;
+    helper::vector<visual_index_type> m_vertexFaces;
+    /// Faces around each normal index of m_vertNormIdx, in the same format (only used if m_vertNormIdx is not empty)
+    helper::vector<visual_index_type> m_normalFacesBegin;
+    helper::vector<visual_index_type> m_normalFaces;
+    /// Counters of m_triangles, m_quads and m_vertNormIdx, and number of vertices, when the adjacency was built
+    int m_adjacencyCounters[3];
+    std::size_t m_adjacencyNbVertices;
+
+    VecCoord m_faceNormals; ///< Normal of each adjacency entry
+    VecCoord m_faceTangents; ///< Tangent of each adjacency entry
+    VecCoord m_normalsPositions; ///< Positions of the vertices at the last incremental normal update
+    VecCoord m_slotNormals; ///< Normals per index of m_vertNormIdx
+    helper::vector<visual_index_type> m_dirtyFaces; ///< Faces around the vertices moved since the last incremental update
+    helper::vector<visual_index_type> m_dirtySlots; ///< Vertices (or normal indices) touching these faces
+    helper::vector<char> m_faceFlags; ///< Set for the faces in m_dirtyFaces during an incremental update
+    helper::vector<char> m_slotFlags; ///< Set for the slots in m_dirtySlots during an incremental update
+    bool m_normalsOutdated; ///< True if the normals update of updateVisual was deferred to the next draw
+
+public:
     template<class VecType>
     void addTopoHandler(topology::PointData<VecType>* data, int algo = 0);
 
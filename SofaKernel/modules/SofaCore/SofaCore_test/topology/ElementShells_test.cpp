@@ -0,0 +1,144 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/core/topology/ElementShells.h>
+
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest;
+
+#include <algorithm>
+
+namespace
+{
+
+using sofa::core::topology::ElementShells;
+using Shells = ElementShells<sofa::Index>;
+using Reference = sofa::helper::vector< sofa::helper::vector<sofa::Index> >;
+
+class ElementShells_test : public BaseTest
+{
+public:
+    Shells m_shells;
+    Reference m_reference;
+
+    void checkShells()
+    {
+        const Shells& shells = m_shells;
+        ASSERT_EQ(shells.size(), m_reference.size());
+        std::size_t nbIndices = 0;
+        for (std::size_t i = 0; i < shells.size(); ++i)
+        {
+            EXPECT_EQ(shells[i], m_reference[i]) << "shell " << i;
+            nbIndices += m_reference[i].size();
+        }
+        EXPECT_EQ(shells.getNbIndices(), nbIndices);
+    }
+};
+
+TEST_F(ElementShells_test, allocate)
+{
+    m_shells.allocate(sofa::helper::vector<std::size_t>{2, 0, 3});
+    std::copy_n(sofa::helper::vector<sofa::Index>{4, 7}.begin(), 2, m_shells.data(0));
+    std::copy_n(sofa::helper::vector<sofa::Index>{1, 2, 3}.begin(), 3, m_shells.data(2));
+    m_reference = Reference{{4, 7}, {}, {1, 2, 3}};
+
+    checkShells();
+    EXPECT_EQ(m_shells.getIndicesCapacity(), 5u);
+}
+
+TEST_F(ElementShells_test, edit)
+{
+    m_shells.allocate(sofa::helper::vector<std::size_t>{1, 1, 1});
+    m_reference = Reference{{0}, {0}, {0}};
+    for (std::size_t i = 0; i < 3; ++i)
+        m_shells.data(i)[0] = 0;
+
+    // the shells grow by moving to the end of the index array
+    for (sofa::Index e = 1; e < 50; ++e)
+    {
+        const std::size_t i = e % 3;
+        m_shells[i].push_back(e);
+        m_reference[i].push_back(e);
+    }
+    checkShells();
+
+    auto shell = m_shells[1];
+    shell.erase(std::find(shell.begin(), shell.end(), 25));
+    m_reference[1].erase(std::find(m_reference[1].begin(), m_reference[1].end(), 25));
+    shell.erase(std::remove(shell.begin(), shell.end(), 1), shell.end());
+    m_reference[1].erase(std::remove(m_reference[1].begin(), m_reference[1].end(), 1), m_reference[1].end());
+    std::replace(shell.begin(), shell.end(), 4, 100);
+    std::replace(m_reference[1].begin(), m_reference[1].end(), 4, 100);
+    checkShells();
+
+    // assignment from another shell of the same storage
+    m_shells[0] = m_shells[2];
+    m_reference[0] = m_reference[2];
+    m_shells[2] = sofa::helper::vector<sofa::Index>{8};
+    m_reference[2] = sofa::helper::vector<sofa::Index>{8};
+    checkShells();
+
+    m_shells.resize(5);
+    m_reference.resize(5);
+    m_shells[4].push_back(3);
+    m_reference[4].push_back(3);
+    m_shells.push_back(sofa::helper::vector<sofa::Index>{5, 6});
+    m_reference.push_back({5, 6});
+    checkShells();
+}
+
+TEST_F(ElementShells_test, compact)
+{
+    m_shells.allocate(sofa::helper::vector<std::size_t>{1, 10});
+    m_shells.data(0)[0] = 3;
+    m_shells.resize(1);
+
+    // the entries of the removed shell are reclaimed when the first one grows
+    m_shells[0].push_back(4);
+    m_reference = Reference{{3, 4}};
+    checkShells();
+    EXPECT_EQ(m_shells.getIndicesCapacity(), 4u);
+}
+
+TEST_F(ElementShells_test, reorder)
+{
+    m_shells.allocate(sofa::helper::vector<std::size_t>{1, 2, 3});
+    m_reference = Reference{{0}, {1, 2}, {3, 4, 5}};
+    sofa::Index e = 0;
+    for (std::size_t i = 0; i < 3; ++i)
+        for (std::size_t j = 0; j < m_reference[i].size(); ++j)
+            m_shells.data(i)[j] = e++;
+
+    m_shells.swap(0, 2);
+    std::swap(m_reference[0], m_reference[2]);
+    checkShells();
+
+    m_shells.permute(sofa::helper::vector<sofa::Index>{1, 2, 0});
+    m_reference = Reference{m_reference[1], m_reference[2], m_reference[0]};
+    checkShells();
+
+    // removal of the last shells, as done by the topology modifiers
+    m_shells.resize(1);
+    m_reference.resize(1);
+    checkShells();
+}
+
+} // namespace
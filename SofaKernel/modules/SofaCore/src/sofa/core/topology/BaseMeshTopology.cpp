@@ -140,45 +140,45 @@ const BaseMeshTopology::QuadsInHexahedron& BaseMeshTopology::getQuadsInHexahedro
 }
 
 /// Returns the set of tetrahedra adjacent to a given vertex.
-const BaseMeshTopology::TetrahedraAroundVertex& BaseMeshTopology::getTetrahedraAroundVertex(PointID)
+BaseMeshTopology::TetrahedraAroundVertex BaseMeshTopology::getTetrahedraAroundVertex(PointID)
 {
     if (getNbTetrahedra()) msg_error() << "getTetrahedraAroundVertex unsupported.";
-    return InvalidSet;
+    return TetrahedraAroundVertex(InvalidSet);
 }
 
 /// Returns the set of tetrahedra adjacent to a given edge.
-const BaseMeshTopology::TetrahedraAroundEdge& BaseMeshTopology::getTetrahedraAroundEdge(EdgeID)
+BaseMeshTopology::TetrahedraAroundEdge BaseMeshTopology::getTetrahedraAroundEdge(EdgeID)
 {
     if (getNbTetrahedra()) msg_error() << "getTetrahedraAroundEdge unsupported.";
-    return InvalidSet;
+    return TetrahedraAroundEdge(InvalidSet);
 }
 
 /// Returns the set of tetrahedra adjacent to a given triangle.
-const BaseMeshTopology::TetrahedraAroundTriangle& BaseMeshTopology::getTetrahedraAroundTriangle(TriangleID)
+BaseMeshTopology::TetrahedraAroundTriangle BaseMeshTopology::getTetrahedraAroundTriangle(TriangleID)
 {
     if (getNbTetrahedra()) msg_error() << "getTetrahedraAroundTriangle unsupported.";
-    return InvalidSet;
+    return TetrahedraAroundTriangle(InvalidSet);
 }
 
 /// Returns the set of hexahedra adjacent to a given vertex.
-const BaseMeshTopology::HexahedraAroundVertex& BaseMeshTopology::getHexahedraAroundVertex(PointID)
+BaseMeshTopology::HexahedraAroundVertex BaseMeshTopology::getHexahedraAroundVertex(PointID)
 {
     if (getNbHexahedra()) msg_error() << "getHexahedraAroundVertex unsupported.";
-    return InvalidSet;
+    return HexahedraAroundVertex(InvalidSet);
 }
 
 /// Returns the set of hexahedra adjacent to a given edge.
-const BaseMeshTopology::HexahedraAroundEdge& BaseMeshTopology::getHexahedraAroundEdge(EdgeID)
+BaseMeshTopology::HexahedraAroundEdge BaseMeshTopology::getHexahedraAroundEdge(EdgeID)
 {
     if (getNbHexahedra()) msg_error() << "getHexahedraAroundEdge unsupported.";
-    return InvalidSet;
+    return HexahedraAroundEdge(InvalidSet);
 }
 
 /// Returns the set of hexahedra adjacent to a given quad.
-const BaseMeshTopology::HexahedraAroundQuad& BaseMeshTopology::getHexahedraAroundQuad(QuadID)
+BaseMeshTopology::HexahedraAroundQuad BaseMeshTopology::getHexahedraAroundQuad(QuadID)
 {
     if (getNbHexahedra()) msg_error() << "getHexahedraAroundQuad unsupported.";
-    return InvalidSet;
+    return HexahedraAroundQuad(InvalidSet);
 }
 
 
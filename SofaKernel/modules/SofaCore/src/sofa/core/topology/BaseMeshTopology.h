@@ -24,6 +24,7 @@
 
 #include <sofa/core/fwd.h>
 #include <sofa/core/topology/Topology.h>
+#include <sofa/core/topology/ElementShells.h>
 #include <sofa/core/objectmodel/DataFileName.h>
 
 namespace sofa
@@ -75,19 +76,21 @@ public:
     /// @}
 
     /// dynamic-size neighbors arrays
+    /// The tetrahedra and hexahedra shells are views on the flat storage of the containers (see ElementShells),
+    /// invalidated by the next topological change.
     /// @{
     typedef sofa::helper::vector<PointID>		    VerticesAroundVertex;
     typedef sofa::helper::vector<EdgeID>			EdgesAroundVertex;
     typedef sofa::helper::vector<TriangleID>	    TrianglesAroundVertex;
     typedef sofa::helper::vector<QuadID>			QuadsAroundVertex;
-    typedef sofa::helper::vector<TetraID>		    TetrahedraAroundVertex;
-    typedef sofa::helper::vector<HexaID>			HexahedraAroundVertex;
+    typedef ShellSpan<const TetraID>		    TetrahedraAroundVertex;
+    typedef ShellSpan<const HexaID>			HexahedraAroundVertex;
     typedef sofa::helper::vector<TriangleID>	    TrianglesAroundEdge;
     typedef sofa::helper::vector<QuadID>			QuadsAroundEdge;
-    typedef sofa::helper::vector<TetraID>		    TetrahedraAroundEdge;
-    typedef sofa::helper::vector<HexaID>			HexahedraAroundEdge;
-    typedef sofa::helper::vector<TetraID>		    TetrahedraAroundTriangle;
-    typedef sofa::helper::vector<HexaID>			HexahedraAroundQuad;
+    typedef ShellSpan<const TetraID>		    TetrahedraAroundEdge;
+    typedef ShellSpan<const HexaID>			HexahedraAroundEdge;
+    typedef ShellSpan<const TetraID>		    TetrahedraAroundTriangle;
+    typedef ShellSpan<const HexaID>			HexahedraAroundQuad;
     /// @}
 protected:
     BaseMeshTopology()	;
@@ -168,17 +171,17 @@ public:
     /// Returns the set of quads adjacent to a given hexahedron.
     virtual const QuadsInHexahedron& getQuadsInHexahedron(HexaID i);
     /// Returns the set of tetrahedra adjacent to a given vertex.
-    virtual const TetrahedraAroundVertex& getTetrahedraAroundVertex(PointID i);
+    virtual TetrahedraAroundVertex getTetrahedraAroundVertex(PointID i);
     /// Returns the set of tetrahedra adjacent to a given edge.
-    virtual const TetrahedraAroundEdge& getTetrahedraAroundEdge(EdgeID i);
+    virtual TetrahedraAroundEdge getTetrahedraAroundEdge(EdgeID i);
     /// Returns the set of tetrahedra adjacent to a given triangle.
-    virtual const TetrahedraAroundTriangle& getTetrahedraAroundTriangle(TriangleID i);
+    virtual TetrahedraAroundTriangle getTetrahedraAroundTriangle(TriangleID i);
     /// Returns the set of hexahedra adjacent to a given vertex.
-    virtual const HexahedraAroundVertex& getHexahedraAroundVertex(PointID i);
+    virtual HexahedraAroundVertex getHexahedraAroundVertex(PointID i);
     /// Returns the set of hexahedra adjacent to a given edge.
-    virtual const HexahedraAroundEdge& getHexahedraAroundEdge(EdgeID i);
+    virtual HexahedraAroundEdge getHexahedraAroundEdge(EdgeID i);
     /// Returns the set of hexahedra adjacent to a given quad.
-    virtual const HexahedraAroundQuad& getHexahedraAroundQuad(QuadID i);
+    virtual HexahedraAroundQuad getHexahedraAroundQuad(QuadID i);
 
     /// Returns the set of vertices adjacent to a given vertex (i.e. sharing an edge)
     virtual const VerticesAroundVertex getVerticesAroundVertex(PointID i);
@@ -0,0 +1,368 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+
+#include <sofa/core/config.h>
+#include <sofa/helper/vector.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+namespace sofa::core::topology
+{
+
+/// View on a contiguous array of element indices, such as one shell of ElementShells.
+/// It does not own the indices: any change of the shells it comes from may invalidate it.
+template<class T>
+class ShellSpan
+{
+public:
+    typedef std::remove_const_t<T> value_type;
+    typedef std::size_t size_type;
+    typedef T& reference;
+    typedef const value_type& const_reference;
+    typedef T* iterator;
+    typedef const value_type* const_iterator;
+
+    ShellSpan() = default;
+    ShellSpan(T* data, size_type size) : m_data(data), m_size(size) {}
+
+    /// View on all the indices of a vector, which must outlive the view.
+    template<class U = T, class = std::enable_if_t<std::is_const_v<U>>>
+    explicit ShellSpan(const sofa::helper::vector<value_type>& v) : m_data(v.data()), m_size(v.size()) {}
+
+    size_type size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    T* data() const { return m_data; }
+
+    iterator begin() const { return m_data; }
+    iterator end() const { return m_data + m_size; }
+
+    reference operator[](size_type i) const { assert(i < m_size); return m_data[i]; }
+    reference front() const { assert(m_size > 0); return m_data[0]; }
+    reference back() const { assert(m_size > 0); return m_data[m_size - 1]; }
+
+    operator ShellSpan<const value_type>() const { return ShellSpan<const value_type>(m_data, m_size); }
+
+    /// Copy of the indices, for the code storing or editing its own list of elements.
+    operator sofa::helper::vector<value_type>() const { return sofa::helper::vector<value_type>(std::vector<value_type>(begin(), end())); }
+
+    /// Same output as sofa::helper::vector
+    friend std::ostream& operator<<(std::ostream& os, const ShellSpan& s)
+    {
+        for (size_type i = 0; i < s.m_size; ++i)
+        {
+            if (i) os << ' ';
+            os << s.m_data[i];
+        }
+        return os;
+    }
+
+private:
+    T* m_data { nullptr };
+    size_type m_size { 0 };
+};
+
+template<class T, class U>
+bool operator==(const ShellSpan<T>& a, const ShellSpan<U>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template<class T>
+bool operator==(const ShellSpan<T>& a, const sofa::helper::vector<std::remove_const_t<T>>& b)
+{
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+template<class T>
+bool operator==(const sofa::helper::vector<std::remove_const_t<T>>& a, const ShellSpan<T>& b)
+{
+    return b == a;
+}
+
+template<class T, class U>
+bool operator!=(const ShellSpan<T>& a, const ShellSpan<U>& b) { return !(a == b); }
+
+template<class T>
+bool operator!=(const ShellSpan<T>& a, const sofa::helper::vector<std::remove_const_t<T>>& b) { return !(a == b); }
+
+template<class T>
+bool operator!=(const sofa::helper::vector<std::remove_const_t<T>>& a, const ShellSpan<T>& b) { return !(a == b); }
+
+
+/** Shells of elements around sub-elements (tetrahedra around vertices...), stored in one flat index array:
+ * each shell is a range of this array, given by its offset, its size and its capacity.
+ *
+ * Built from element counts (see allocate()), the shells are contiguous, in order and without unused entries, as
+ * compressed sparse rows. The topology modifiers then edit them in place: removing an element of a shell leaves an
+ * unused entry at its end, adding an element to a full shell moves it to the end of the array with twice its
+ * capacity, and the array is compacted once more than half of it is unused.
+ *
+ * Any change may move the indices, so that it invalidates the spans previously returned.
+ */
+template<class ID>
+class ElementShells
+{
+public:
+    typedef ShellSpan<const ID> ConstShell;
+
+    /// Reference to one shell, with the subset of the std::vector interface used to edit the shells
+    class Shell
+    {
+    public:
+        typedef ID value_type;
+        typedef std::size_t size_type;
+        typedef ID* iterator;
+        typedef const ID* const_iterator;
+
+        Shell(ElementShells* shells, std::size_t index) : m_shells(shells), m_index(index) {}
+        Shell(const Shell&) = default;
+
+        size_type size() const { return m_shells->m_sizes[m_index]; }
+        bool empty() const { return size() == 0; }
+        ID* data() const { return m_shells->data(m_index); }
+
+        iterator begin() const { return data(); }
+        iterator end() const { return data() + size(); }
+
+        ID& operator[](size_type i) const { assert(i < size()); return data()[i]; }
+        ID& front() const { return (*this)[0]; }
+        ID& back() const { return (*this)[size() - 1]; }
+
+        void push_back(ID id) { m_shells->push_back(m_index, id); }
+        iterator erase(iterator position)
+        {
+            const std::size_t i = std::size_t(position - begin());
+            m_shells->erase(m_index, i);
+            return begin() + i;
+        }
+        iterator erase(iterator first, iterator last)
+        {
+            const std::size_t i = std::size_t(first - begin());
+            m_shells->erase(m_index, i, std::size_t(last - first));
+            return begin() + i;
+        }
+        void clear() { m_shells->m_sizes[m_index] = 0; }
+
+        /// Assignments copy the elements into the referenced shell
+        /// @{
+        Shell& operator=(ConstShell elements) { m_shells->assign(m_index, elements); return *this; }
+        Shell& operator=(const Shell& other) { return *this = ConstShell(other); }
+        Shell& operator=(const sofa::helper::vector<ID>& elements) { return *this = ConstShell(elements); }
+        /// @}
+
+        operator ConstShell() const { return ConstShell(data(), size()); }
+        operator sofa::helper::vector<ID>() const { return sofa::helper::vector<ID>(std::vector<ID>(begin(), end())); }
+
+        friend std::ostream& operator<<(std::ostream& os, const Shell& s) { return os << ConstShell(s); }
+
+    private:
+        ElementShells* m_shells;
+        std::size_t m_index;
+    };
+
+    /// Number of shells
+    std::size_t size() const { return m_offsets.size(); }
+    bool empty() const { return m_offsets.empty(); }
+
+    ConstShell operator[](std::size_t i) const { assert(i < size()); return ConstShell(data(i), m_sizes[i]); }
+    Shell operator[](std::size_t i) { assert(i < size()); return Shell(this, i); }
+
+    const ID* data(std::size_t i) const { return m_indices.data() + m_offsets[i]; }
+    ID* data(std::size_t i) { return m_indices.data() + m_offsets[i]; }
+
+    void clear()
+    {
+        m_indices.clear();
+        m_offsets.clear();
+        m_sizes.clear();
+        m_capacities.clear();
+        m_nbUnused = 0;
+    }
+
+    /// Change the number of shells: the new shells are empty.
+    void resize(std::size_t nbShells)
+    {
+        for (std::size_t i = nbShells; i < size(); ++i)
+            m_nbUnused += m_capacities[i];
+        m_offsets.resize(nbShells, m_indices.size());
+        m_sizes.resize(nbShells, 0);
+        m_capacities.resize(nbShells, 0);
+    }
+
+    /// Replace the shells by sizes.size() shells of the given sizes, stored contiguously and in order.
+    /// The elements are left to be written through data(i).
+    template<class SizeArray>
+    void allocate(const SizeArray& sizes)
+    {
+        const std::size_t nbShells = sizes.size();
+        m_offsets.resize(nbShells);
+        m_sizes.resize(nbShells);
+        m_capacities.resize(nbShells);
+        std::size_t offset = 0;
+        for (std::size_t i = 0; i < nbShells; ++i)
+        {
+            m_offsets[i] = offset;
+            m_sizes[i] = m_capacities[i] = std::size_t(sizes[i]);
+            offset += m_sizes[i];
+        }
+        m_indices.clear();
+        m_indices.resize(offset);
+        m_nbUnused = 0;
+    }
+
+    /// Add a shell, copy of the given elements.
+    void push_back(ConstShell elements)
+    {
+        const std::size_t i = size();
+        resize(i + 1);
+        assign(i, elements);
+    }
+
+    void push_back(const sofa::helper::vector<ID>& elements) { push_back(ConstShell(elements)); }
+
+    /// Exchange the shells i and j, without copying their elements.
+    void swap(std::size_t i, std::size_t j)
+    {
+        std::swap(m_offsets[i], m_offsets[j]);
+        std::swap(m_sizes[i], m_sizes[j]);
+        std::swap(m_capacities[i], m_capacities[j]);
+    }
+
+    /// Reorder the shells: the shell i becomes the former shell permutation[i], without copying their elements.
+    template<class IndexArray>
+    void permute(const IndexArray& permutation)
+    {
+        assert(permutation.size() == size());
+        sofa::helper::vector<std::size_t> offsets(size()), sizes(size()), capacities(size());
+        for (std::size_t i = 0; i < size(); ++i)
+        {
+            offsets[i] = m_offsets[permutation[i]];
+            sizes[i] = m_sizes[permutation[i]];
+            capacities[i] = m_capacities[permutation[i]];
+        }
+        m_offsets.swap(offsets);
+        m_sizes.swap(sizes);
+        m_capacities.swap(capacities);
+    }
+
+    /// Total number of elements in the shells
+    std::size_t getNbIndices() const { return m_indices.size() - m_nbUnused - unusedCapacity(); }
+
+    /// Size of the flat index array, including the unused entries
+    std::size_t getIndicesCapacity() const { return m_indices.size(); }
+
+    void push_back(std::size_t i, ID id)
+    {
+        if (m_sizes[i] == m_capacities[i])
+            reserve(i, std::max<std::size_t>(2 * m_capacities[i], 4));
+        m_indices[m_offsets[i] + m_sizes[i]++] = id;
+    }
+
+    /// Remove count elements of the shell i, from the given position
+    void erase(std::size_t i, std::size_t position, std::size_t count = 1)
+    {
+        assert(position + count <= m_sizes[i]);
+        ID* shell = data(i);
+        std::copy(shell + position + count, shell + m_sizes[i], shell + position);
+        m_sizes[i] -= count;
+    }
+
+    void assign(std::size_t i, ConstShell elements)
+    {
+        if (elements.data() == data(i) && elements.size() == m_sizes[i])
+            return;
+        if (!m_indices.empty() && elements.data() >= m_indices.data() && elements.data() < m_indices.data() + m_indices.size())
+        {
+            // the elements come from these shells, which may move
+            const std::vector<ID> copy(elements.begin(), elements.end());
+            assign(i, ConstShell(copy.data(), copy.size()));
+            return;
+        }
+        if (elements.size() > m_capacities[i])
+            reserve(i, elements.size());
+        std::copy(elements.begin(), elements.end(), data(i));
+        m_sizes[i] = elements.size();
+    }
+
+private:
+    std::size_t unusedCapacity() const
+    {
+        std::size_t unused = 0;
+        for (std::size_t i = 0; i < size(); ++i)
+            unused += m_capacities[i] - m_sizes[i];
+        return unused;
+    }
+
+    /// Give the shell i a capacity of at least capacity elements, moving it to the end of the index array if needed
+    void reserve(std::size_t i, std::size_t capacity)
+    {
+        if (capacity <= m_capacities[i])
+            return;
+        if (2 * m_nbUnused > m_indices.size())
+            compact();
+        if (m_offsets[i] + m_capacities[i] == m_indices.size())
+        {
+            // last shell of the array: grow it in place
+            m_indices.resize(m_offsets[i] + capacity);
+        }
+        else
+        {
+            const std::size_t offset = m_indices.size();
+            m_indices.resize(offset + capacity);
+            std::copy(m_indices.begin() + m_offsets[i], m_indices.begin() + m_offsets[i] + m_sizes[i], m_indices.begin() + offset);
+            m_nbUnused += m_capacities[i];
+            m_offsets[i] = offset;
+        }
+        m_capacities[i] = capacity;
+    }
+
+    /// Store the shells contiguously and in order, without unused entries
+    void compact()
+    {
+        sofa::helper::vector<ID> indices;
+        indices.reserve(m_indices.size() - m_nbUnused);
+        for (std::size_t i = 0; i < size(); ++i)
+        {
+            const std::size_t offset = indices.size();
+            indices.insert(indices.end(), m_indices.begin() + m_offsets[i], m_indices.begin() + m_offsets[i] + m_sizes[i]);
+            m_offsets[i] = offset;
+            m_capacities[i] = m_sizes[i];
+        }
+        m_indices.swap(indices);
+        m_nbUnused = 0;
+    }
+
+    sofa::helper::vector<ID> m_indices;
+    sofa::helper::vector<std::size_t> m_offsets;
+    sofa::helper::vector<std::size_t> m_sizes;
+    sofa::helper::vector<std::size_t> m_capacities;
+    /// number of entries of m_indices which are not in the capacity of any shell
+    std::size_t m_nbUnused { 0 };
+};
+
+} // namespace sofa::core::topology
@@ -25,6 +25,7 @@
 #include <SofaBaseLinearSolver/CGLinearSolver.h>
 
 #include <SofaSimpleFem_test/ForceFieldTestCreation.h>
+#include <sofa/helper/RandomGenerator.h>
 
 namespace sofa {
 
@@ -287,4 +288,80 @@ TYPED_TEST( StiffSpringForceField_test , extension_in_parent_and_child )
 }
 
 
+/// Compare the batched (structure-of-arrays) evaluation of the springs to the spring-by-spring one
+struct StiffSpringForceFieldBatch_test : public BaseSimulationTest
+{
+    typedef defaulttype::Vec3Types DataTypes;
+    typedef DataTypes::VecCoord VecCoord;
+    typedef DataTypes::VecDeriv VecDeriv;
+    typedef component::interactionforcefield::StiffSpringForceField<DataTypes> StiffSpringForceField;
+    typedef component::container::MechanicalObject<DataTypes> DOF;
+
+    /// Random positions and velocities, with springs between close particles of a grid
+    VecCoord x;
+    VecDeriv v, dx;
+    helper::vector<StiffSpringForceField::Spring> springs;
+
+    void createNetwork()
+    {
+        sofa::helper::RandomGenerator random(42);
+        const int n = 12;
+        auto index = [n](int i, int j, int k) { return sofa::Index((k*n + j)*n + i); };
+        for (int k=0; k<n; ++k)
+            for (int j=0; j<n; ++j)
+                for (int i=0; i<n; ++i)
+                {
+                    x.push_back(DataTypes::Coord(i + random.random<SReal>(-0.2, 0.2), j + random.random<SReal>(-0.2, 0.2), k + random.random<SReal>(-0.2, 0.2)));
+                    v.push_back(DataTypes::Deriv(random.random<SReal>(-1, 1), random.random<SReal>(-1, 1), random.random<SReal>(-1, 1)));
+                    dx.push_back(DataTypes::Deriv(random.random<SReal>(-1, 1), random.random<SReal>(-1, 1), random.random<SReal>(-1, 1)));
+                    if (i+1 < n) springs.emplace_back(index(i,j,k), index(i+1,j,k), 10, 0.1, 1);
+                    if (j+1 < n) springs.emplace_back(index(i,j,k), index(i,j+1,k), 10, 0.1, 1);
+                    if (k+1 < n) springs.emplace_back(index(i,j,k), index(i,j,k+1), 10, 0.1, 1);
+                    if (i+1 < n && j+1 < n) springs.emplace_back(index(i,j,k), index(i+1,j+1,k), 5, 0.1, std::sqrt(2.0), true);
+                }
+        springs[3].enabled = false;
+    }
+
+    /// f and df computed by a spring force field, with the given options
+    std::pair<VecDeriv, VecDeriv> compute(bool batch, bool parallel)
+    {
+        simulation::Node::SPtr root = simulation::getSimulation()->createNewGraph("root");
+        DOF::SPtr dof = modeling::addNew<DOF>(root);
+        dof->resize(sofa::Size(x.size()));
+        StiffSpringForceField::SPtr ff = sofa::core::objectmodel::New<StiffSpringForceField>(dof.get(), dof.get());
+        ff->d_batchSprings.setValue(batch);
+        ff->d_parallelSprings.setValue(parallel);
+        ff->springs.setValue(springs);
+        root->addObject(ff);
+        sofa::simulation::getSimulation()->init(root.get());
+
+        core::objectmodel::Data<VecCoord> dataX; dataX.setValue(x);
+        core::objectmodel::Data<VecDeriv> dataV; dataV.setValue(v);
+        core::objectmodel::Data<VecDeriv> dataDx; dataDx.setValue(dx);
+        core::objectmodel::Data<VecDeriv> dataF; dataF.setValue(VecDeriv(x.size()));
+        core::objectmodel::Data<VecDeriv> dataDf; dataDf.setValue(VecDeriv(x.size()));
+
+        core::MechanicalParams mparams;
+        mparams.setKFactor(1.0);
+        ff->addForce(&mparams, dataF, dataF, dataX, dataX, dataV, dataV);
+        ff->addDForce(&mparams, dataDf, dataDf, dataDx, dataDx);
+        return { dataF.getValue(), dataDf.getValue() };
+    }
+};
+
+TEST_F(StiffSpringForceFieldBatch_test, batchMatchesSpringBySpring)
+{
+    createNetwork();
+    const auto reference = compute(false, false);
+    for (bool parallel : {false, true})
+    {
+        const auto batched = compute(true, parallel);
+        for (std::size_t i=0; i<x.size(); ++i)
+        {
+            EXPECT_LT((batched.first[i] - reference.first[i]).norm(), 1e-12) << "force, particle " << i << ", parallel " << parallel;
+            EXPECT_LT((batched.second[i] - reference.second[i]).norm(), 1e-12) << "dforce, particle " << i << ", parallel " << parallel;
+        }
+    }
+}
+
 } // namespace sofa
@@ -26,6 +26,7 @@
 #include <sofa/defaulttype/Mat.h>
 #include <SofaBaseTopology/TopologySubsetData.h>
 #include <SofaBaseTopology/TopologySubsetData.inl> 
+#include <functional>
 
 namespace sofa::component::interactionforcefield
 {
@@ -65,9 +66,36 @@ public:
     SetIndex d_indices2; ///< Indices of the fixed points on the second model
 
     core::objectmodel::Data<SReal> d_length;
+    core::objectmodel::Data<bool> d_batchSprings; ///< Evaluate the springs by blocks, from a structure-of-arrays copy of their parameters
+    core::objectmodel::Data<bool> d_parallelSprings; ///< With batchSprings, process the springs of each color in parallel with the TaskScheduler
 protected:
     sofa::helper::vector<Mat>  dfdx;
 
+    /// Structure-of-arrays copy of the springs used by batchSprings.
+    /// With parallelSprings, the springs are sorted by color: two springs of the same color do not share any particle.
+    struct SpringArrays
+    {
+        sofa::helper::vector<sofa::Index> index; ///< index of the spring in the springs Data, i.e. in dfdx
+        sofa::helper::vector<sofa::Index> m1, m2;
+        sofa::helper::vector<Real> ks, kd, initpos;
+        sofa::helper::vector<unsigned char> elongationOnly, enabled;
+        sofa::helper::vector<std::size_t> colorBegin; ///< springs of color c are in [colorBegin[c], colorBegin[c+1])
+        bool lastColorIsShared { false }; ///< the last color gathers the springs that did not fit in the others, it is processed sequentially
+        int springsCounter { -1 };
+        bool colored { false };
+    };
+    SpringArrays m_springArrays;
+    sofa::helper::vector<Real> m_springEnergy;
+
+    /// Update the structure-of-arrays copy if the springs or the parallelSprings flag changed
+    void updateSpringArrays();
+
+    /// Call f on ranges of the springs of each color, in parallel if parallelSprings is set
+    void forEachSpringRange(const std::function<void(std::size_t, std::size_t)>& f);
+
+    /// Batched version of addSpringForce, for the springs [begin,end) of the structure of arrays
+    void addSpringForceBlock(VecDeriv& f1, const VecCoord& p1, const VecDeriv& v1, VecDeriv& f2, const VecCoord& p2, const VecDeriv& v2, std::size_t begin, std::size_t end);
+
     /// Accumulate the spring force and compute and store its stiffness
     void addSpringForce(Real& potentialEnergy, VecDeriv& f1,const  VecCoord& p1,const VecDeriv& v1, VecDeriv& f2,const  VecCoord& p2,const  VecDeriv& v2, sofa::Index i, const Spring& spring) override;
 
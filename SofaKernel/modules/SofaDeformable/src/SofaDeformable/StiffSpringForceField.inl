@@ -28,10 +28,24 @@
 
 #include <sofa/core/visual/VisualParams.h>
 #include <SofaBaseTopology/TopologySubsetData.inl>
+#include <sofa/simulation/ParallelForRange.h>
+#include <algorithm>
+#include <cmath>
 
 namespace sofa::component::interactionforcefield
 {
 
+namespace stiffspring
+{
+
+/// Number of springs gathered, computed and scattered together by the batched evaluation
+constexpr std::size_t blockSize = 64;
+
+/// Minimum number of springs of a color handled by each parallel task
+constexpr std::size_t minSpringsPerTask = 2048;
+
+} // namespace stiffspring
+
 template<class DataTypes>
 StiffSpringForceField<DataTypes>::StiffSpringForceField(double ks, double kd)
     : StiffSpringForceField<DataTypes>(nullptr, nullptr, ks, kd)
@@ -44,6 +58,8 @@ StiffSpringForceField<DataTypes>::StiffSpringForceField(MechanicalState* object1
     , d_indices1(initData(&d_indices1, "indices1", "Indices of the source points on the first model"))
     , d_indices2(initData(&d_indices2, "indices2", "Indices of the fixed points on the second model"))
     , d_length(initData(&d_length, 0.0, "length", "uniform length of all springs"))
+    , d_batchSprings(initData(&d_batchSprings, false, "batchSprings", "Evaluate the springs by blocks, from a structure-of-arrays copy of their parameters"))
+    , d_parallelSprings(initData(&d_parallelSprings, false, "parallelSprings", "With batchSprings, color the springs so that the springs of a color share no particle, and process each color in parallel with the TaskScheduler"))
 {
     this->addUpdateCallback("updateSprings", { &d_indices1, &d_indices2, &d_length, &this->ks, &this->kd}, [this](const core::DataTracker& t)
     {
@@ -65,6 +81,9 @@ void StiffSpringForceField<DataTypes>::init()
     }
     this->SpringForceField<DataTypes>::init();
 
+    if (d_batchSprings.getValue() && d_parallelSprings.getValue())
+        simulation::initTaskScheduler();
+
     this->d_componentState.setValue(sofa::core::objectmodel::ComponentState::Valid);
 }
 
@@ -162,6 +181,201 @@ void StiffSpringForceField<DataTypes>::addSpringForce(
     }
 }
 
+template<class DataTypes>
+void StiffSpringForceField<DataTypes>::updateSpringArrays()
+{
+    const bool colored = d_parallelSprings.getValue();
+    if (m_springArrays.springsCounter == this->springs.getCounter() && m_springArrays.colored == colored)
+        return;
+
+    const helper::vector<Spring>& springs = this->springs.getValue();
+    const std::size_t nbSprings = springs.size();
+    SpringArrays& sa = m_springArrays;
+    sa.springsCounter = this->springs.getCounter();
+    sa.colored = colored;
+    sa.lastColorIsShared = false;
+
+    // order of the springs in the arrays
+    sa.index.resize(nbSprings);
+    if (!colored)
+    {
+        for (std::size_t i=0; i<nbSprings; i++)
+            sa.index[i] = sofa::Index(i);
+        sa.colorBegin.resize(2);
+        sa.colorBegin[0] = 0;
+        sa.colorBegin[1] = nbSprings;
+    }
+    else
+    {
+        // greedy coloring: each spring takes the first color used by none of its two particles.
+        // The springs that find no free color among the first ones go in a last, shared color.
+        constexpr unsigned int maxColors = 63;
+        const bool sameState = (this->mstate1 == this->mstate2);
+        std::size_t nbParticles1 = 0, nbParticles2 = 0;
+        for (const Spring& s : springs)
+        {
+            nbParticles1 = std::max<std::size_t>(nbParticles1, s.m1+1);
+            nbParticles2 = std::max<std::size_t>(nbParticles2, s.m2+1);
+        }
+        if (sameState)
+            nbParticles1 = nbParticles2 = std::max(nbParticles1, nbParticles2);
+        helper::vector<uint64_t> usedColors1(nbParticles1, 0), usedColors2Storage(sameState ? 0 : nbParticles2, 0);
+        helper::vector<uint64_t>& usedColors2 = sameState ? usedColors1 : usedColors2Storage;
+
+        helper::vector<unsigned int> color(nbSprings);
+        helper::vector<std::size_t> colorSize;
+        colorSize.resize(maxColors+1, 0);
+        for (std::size_t i=0; i<nbSprings; i++)
+        {
+            const Spring& s = springs[i];
+            const uint64_t used = usedColors1[s.m1] | usedColors2[s.m2];
+            unsigned int c = 0;
+            while (c < maxColors && (used & (uint64_t(1) << c)))
+                c++;
+            if (c < maxColors)
+            {
+                usedColors1[s.m1] |= (uint64_t(1) << c);
+                usedColors2[s.m2] |= (uint64_t(1) << c);
+            }
+            color[i] = c;
+            colorSize[c]++;
+        }
+
+        unsigned int nbColors = maxColors;
+        while (nbColors > 0 && colorSize[nbColors-1] == 0)
+            nbColors--;
+        sa.lastColorIsShared = (colorSize[maxColors] > 0);
+        if (sa.lastColorIsShared)
+        {
+            colorSize[nbColors] = colorSize[maxColors];
+            for (auto& c : color)
+                if (c == maxColors) c = nbColors;
+            nbColors++;
+        }
+
+        sa.colorBegin.assign(nbColors+1, 0);
+        for (unsigned int c=0; c<nbColors; c++)
+            sa.colorBegin[c+1] = sa.colorBegin[c] + colorSize[c];
+        helper::vector<std::size_t> next(sa.colorBegin.begin(), sa.colorBegin.end()-1);
+        for (std::size_t i=0; i<nbSprings; i++)
+            sa.index[next[color[i]]++] = sofa::Index(i);
+    }
+
+    sa.m1.resize(nbSprings);
+    sa.m2.resize(nbSprings);
+    sa.ks.resize(nbSprings);
+    sa.kd.resize(nbSprings);
+    sa.initpos.resize(nbSprings);
+    sa.elongationOnly.resize(nbSprings);
+    sa.enabled.resize(nbSprings);
+    for (std::size_t k=0; k<nbSprings; k++)
+    {
+        const Spring& s = springs[sa.index[k]];
+        sa.m1[k] = s.m1;
+        sa.m2[k] = s.m2;
+        sa.ks[k] = s.ks;
+        sa.kd[k] = s.kd;
+        sa.initpos[k] = s.initpos;
+        sa.elongationOnly[k] = s.elongationOnly;
+        sa.enabled[k] = s.enabled;
+    }
+}
+
+template<class DataTypes>
+void StiffSpringForceField<DataTypes>::forEachSpringRange(const std::function<void(std::size_t, std::size_t)>& f)
+{
+    const SpringArrays& sa = m_springArrays;
+    simulation::TaskScheduler* taskScheduler = d_parallelSprings.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    const std::size_t nbColors = sa.colorBegin.size()-1;
+    for (std::size_t c=0; c<nbColors; c++)
+    {
+        const std::size_t begin = sa.colorBegin[c];
+        const std::size_t end = sa.colorBegin[c+1];
+        const bool shared = sa.lastColorIsShared && c+1 == nbColors;
+        // the springs of the shared color may write the same points: they are processed sequentially
+        simulation::parallelForRange(shared ? nullptr : taskScheduler, begin, end, stiffspring::minSpringsPerTask, f);
+    }
+}
+
+template<class DataTypes>
+void StiffSpringForceField<DataTypes>::addSpringForceBlock(VecDeriv& f1, const VecCoord& p1, const VecDeriv& v1, VecDeriv& f2, const VecCoord& p2, const VecDeriv& v2, std::size_t begin, std::size_t end)
+{
+    constexpr std::size_t B = stiffspring::blockSize;
+    const SpringArrays& sa = m_springArrays;
+
+    // positional and velocity differences of a block, one array per component
+    Real u[N][B], dv[N][B];
+    Real intensity[B], stiffness[B], tangent[B];
+
+    for (std::size_t blockBegin = begin; blockBegin < end; blockBegin += B)
+    {
+        const std::size_t n = std::min(B, end - blockBegin);
+        const sofa::Index* m1 = &sa.m1[blockBegin];
+        const sofa::Index* m2 = &sa.m2[blockBegin];
+
+        // gather
+        for (std::size_t k=0; k<n; k++)
+        {
+            const typename DataTypes::CPos du = DataTypes::getCPos(p2[m2[k]]) - DataTypes::getCPos(p1[m1[k]]);
+            const typename DataTypes::DPos dvel = DataTypes::getDPos(v2[m2[k]]) - DataTypes::getDPos(v1[m1[k]]);
+            for (sofa::Index j=0; j<N; j++)
+            {
+                u[j][k] = du[j];
+                dv[j][k] = dvel[j];
+            }
+        }
+
+        // same computation as addSpringForce, on contiguous arrays
+        const Real* ks = &sa.ks[blockBegin];
+        const Real* kd = &sa.kd[blockBegin];
+        const Real* initpos = &sa.initpos[blockBegin];
+        const unsigned char* elongationOnly = &sa.elongationOnly[blockBegin];
+        const unsigned char* enabled = &sa.enabled[blockBegin];
+        Real* energy = &m_springEnergy[blockBegin];
+        for (std::size_t k=0; k<n; k++)
+        {
+            Real d2 = 0;
+            for (sofa::Index j=0; j<N; j++)
+                d2 += u[j][k]*u[j][k];
+            const Real d = std::sqrt(d2);
+            const bool active = enabled[k] && d>1.0e-9 && (!elongationOnly[k] || d>initpos[k]);
+            const Real inverseLength = active ? Real(1.0f/d) : Real(0);
+            Real elongationVelocity = 0;
+            for (sofa::Index j=0; j<N; j++)
+            {
+                u[j][k] *= inverseLength;
+                elongationVelocity += u[j][k]*dv[j][k];
+            }
+            const Real elongation = d - initpos[k];
+            const Real forceIntensity = ks[k]*elongation + kd[k]*elongationVelocity;
+            energy[k] = active ? elongation * elongation * ks[k] / 2 : Real(0);
+            intensity[k] = active ? forceIntensity : Real(0);
+            stiffness[k] = active ? ks[k] : Real(0);
+            tangent[k] = intensity[k] * inverseLength;
+        }
+
+        // scatter the forces and the stiffness matrices
+        for (std::size_t k=0; k<n; k++)
+        {
+            typename DataTypes::DPos force;
+            for (sofa::Index j=0; j<N; j++)
+                force[j] = u[j][k]*intensity[k];
+            DataTypes::setDPos( f1[m1[k]], DataTypes::getDPos(f1[m1[k]]) + force ) ;
+            DataTypes::setDPos( f2[m2[k]], DataTypes::getDPos(f2[m2[k]]) - force ) ;
+
+            Mat& m = this->dfdx[sa.index[blockBegin + k]];
+            for(sofa::Index j=0; j<N; ++j )
+            {
+                for(sofa::Index l=0; l<N; ++l )
+                {
+                    m[j][l] = (stiffness[k]-tangent[k]) * u[j][k] * u[l][k];
+                }
+                m[j][j] += tangent[k];
+            }
+        }
+    }
+}
+
 template<class DataTypes>
 void StiffSpringForceField<DataTypes>::addSpringDForce(VecDeriv& df1,const  VecDeriv& dx1, VecDeriv& df2,const  VecDeriv& dx2, sofa::Index i, const Spring& spring, double kFactor, double /*bFactor*/)
 {
@@ -191,9 +405,23 @@ void StiffSpringForceField<DataTypes>::addForce(const core::MechanicalParams* /*
     f1.resize(x1.size());
     f2.resize(x2.size());
     this->m_potentialEnergy = 0;
-    for (sofa::Index i=0; i<springs.size(); i++)
+    if (d_batchSprings.getValue())
     {
-        this->addSpringForce(this->m_potentialEnergy,f1,x1,v1,f2,x2,v2, i, springs[i]);
+        updateSpringArrays();
+        m_springEnergy.resize(springs.size());
+        forEachSpringRange([&](std::size_t begin, std::size_t end)
+        {
+            addSpringForceBlock(f1,x1,v1,f2,x2,v2, begin, end);
+        });
+        for (const Real e : m_springEnergy)
+            this->m_potentialEnergy += e;
+    }
+    else
+    {
+        for (sofa::Index i=0; i<springs.size(); i++)
+        {
+            this->addSpringForce(this->m_potentialEnergy,f1,x1,v1,f2,x2,v2, i, springs[i]);
+        }
     }
     data_f1.endEdit();
     data_f2.endEdit();
@@ -213,9 +441,27 @@ void StiffSpringForceField<DataTypes>::addDForce(const core::MechanicalParams* m
     df1.resize(dx1.size());
     df2.resize(dx2.size());
 
-    for (sofa::Index i=0; i<springs.size(); i++)
+    if (d_batchSprings.getValue() && m_springArrays.index.size() == springs.size() && this->dfdx.size() == springs.size())
     {
-        this->addSpringDForce(df1,dx1,df2,dx2, i, springs[i], kFactor, bFactor);
+        const SpringArrays& sa = m_springArrays;
+        forEachSpringRange([&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t k=begin; k<end; k++)
+            {
+                const typename DataTypes::CPos d = DataTypes::getDPos(dx2[sa.m2[k]]) - DataTypes::getDPos(dx1[sa.m1[k]]);
+                typename DataTypes::DPos dforce = this->dfdx[sa.index[k]]*d;
+                dforce *= kFactor;
+                DataTypes::setDPos( df1[sa.m1[k]], DataTypes::getDPos(df1[sa.m1[k]]) + dforce ) ;
+                DataTypes::setDPos( df2[sa.m2[k]], DataTypes::getDPos(df2[sa.m2[k]]) - dforce ) ;
+            }
+        });
+    }
+    else
+    {
+        for (sofa::Index i=0; i<springs.size(); i++)
+        {
+            this->addSpringDForce(df1,dx1,df2,dx2, i, springs[i], kFactor, bFactor);
+        }
     }
 
     data_df1.endEdit();
@@ -0,0 +1,126 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/testing/BaseSimulationTest.h>
+using sofa::testing::BaseSimulationTest;
+
+#include <SceneCreator/SceneCreator.h>
+
+#include <sofa/simulation/Simulation.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <sofa/simulation/Node.h>
+#include <sofa/simulation/LumpedMassOperations.h>
+
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaBaseMechanics/UniformMass.h>
+#include <SofaDeformable/RestShapeSpringsForceField.h>
+#include <SofaBoundaryCondition/FixedConstraint.h>
+#include <SofaExplicitOdeSolver/EulerSolver.h>
+
+namespace sofa {
+
+using namespace component;
+using namespace defaulttype;
+using namespace modeling;
+
+/** Check that the direct path of EulerExplicitSolver, used when the solver node holds a single
+ unmapped mechanical state with a mass, gives the same trajectory as the visitor-based path.
+ */
+struct EulerExplicitSolverDirectLumpedMass_test : public BaseSimulationTest
+{
+    typedef container::MechanicalObject<Vec3Types> MechanicalObject3;
+
+    simulation::Node::SPtr root;
+    MechanicalObject3::SPtr dofs;
+
+    void createScene(bool direct, bool symplectic)
+    {
+        sofa::simulation::setSimulation(new sofa::simulation::graph::DAGSimulation());
+        root = simulation::getSimulation()->createNewGraph("root");
+        root->setGravity(Vec3(0,-10,0));
+
+        auto solver = addNew<odesolver::EulerExplicitSolver>(root);
+        solver->d_directLumpedMass.setValue(direct);
+        solver->d_symplectic.setValue(symplectic);
+
+        dofs = addNew<MechanicalObject3>(root);
+        dofs->findData("position")->read("0 0 0  1 0.2 0  2 -0.1 0.3  3 0 -0.2");
+        dofs->findData("rest_position")->read("0 0 0  1 0 0  2 0 0  3 0 0");
+
+        auto mass = addNew<mass::UniformMass<Vec3Types, SReal> >(root);
+        mass->d_vertexMass.setValue(0.5);
+
+        auto springs = addNew<forcefield::RestShapeSpringsForceField<Vec3Types> >(root);
+        springs->d_stiffness.setValue({100});
+
+        auto fixed = addNew<projectiveconstraintset::FixedConstraint<Vec3Types> >(root);
+        fixed->d_indices.setValue({0});
+
+        sofa::simulation::getSimulation()->init(root.get());
+    }
+
+    helper::vector<Vec3> simulate(bool direct, bool symplectic)
+    {
+        createScene(direct, symplectic);
+        for (int i = 0; i < 200; ++i)
+            sofa::simulation::getSimulation()->animate(root.get(), 0.001);
+        return dofs->read(core::ConstVecCoordId::position())->getValue();
+    }
+
+    void compareDirectToVisitors(bool symplectic)
+    {
+        const helper::vector<Vec3> visitors = simulate(false, symplectic);
+        const helper::vector<Vec3> direct = simulate(true, symplectic);
+
+        ASSERT_EQ(visitors.size(), direct.size());
+        EXPECT_EQ(direct[0], Vec3(0,0,0));
+        for (std::size_t i = 0; i < visitors.size(); ++i)
+        {
+            EXPECT_LT((visitors[i] - direct[i]).norm(), 1e-12) << "particle " << i;
+        }
+    }
+};
+
+TEST_F(EulerExplicitSolverDirectLumpedMass_test, collectSingleNode)
+{
+    createScene(true, true);
+    simulation::common::LumpedMassOperations lumpedMass;
+    EXPECT_TRUE(lumpedMass.collect(root.get()));
+    EXPECT_EQ(lumpedMass.getMechanicalState(), dofs.get());
+
+    // a mechanical state in a child node requires the visitors
+    simulation::Node::SPtr child = root->createChild("child");
+    MechanicalObject3::SPtr childDofs = addNew<MechanicalObject3>(child);
+    ASSERT_NE(childDofs, nullptr);
+    EXPECT_FALSE(lumpedMass.collect(root.get()));
+}
+
+TEST_F(EulerExplicitSolverDirectLumpedMass_test, symplectic)
+{
+    compareDirectToVisitors(true);
+}
+
+TEST_F(EulerExplicitSolverDirectLumpedMass_test, nonSymplectic)
+{
+    compareDirectToVisitors(false);
+}
+
+} // namespace sofa
@@ -50,6 +50,7 @@ EulerExplicitSolver::EulerExplicitSolver()
     : d_symplectic( initData( &d_symplectic, true, "symplectic", "If true, the velocities are updated before the positions and the method is symplectic (more robust). If false, the positions are updated before the velocities (standard Euler, less robust).") )
     , d_optimizedForDiagonalMatrix(initData(&d_optimizedForDiagonalMatrix, true, "optimizedForDiagonalMatrix", "If true, solution to the system Ax=b can be directly found by computing x = f/m. Must be set to false if M is sparse."))
     , d_threadSafeVisitor(initData(&d_threadSafeVisitor, false, "threadSafeVisitor", "If true, do not use realloc and free visitors in fwdInteractionForceField."))
+    , d_directLumpedMass(initData(&d_directLumpedMass, true, "directLumpedMass", "If true and the solver subtree holds a single unmapped mechanical state with a mass, the components are called directly instead of through visitors. Requires optimizedForDiagonalMatrix."))
 {
 }
 
@@ -66,11 +67,25 @@ void EulerExplicitSolver::solve(const core::ExecParams* params, SReal dt, sofa::
     MultiVecDeriv newVel(&vop, vResult /*core::VecDerivId::velocity()*/ );
     MultiVecDeriv acc(&vop, core::VecDerivId::dx());
 
-    acc.realloc(&vop, !d_threadSafeVisitor.getValue(), true); // dx is no longer allocated by default (but it will be deleted automatically by the mechanical objects)
+    // A single unmapped state with a mass: the force, acceleration and update are computed
+    // by calling the components directly, without one graph traversal per operation
+    const bool direct = d_optimizedForDiagonalMatrix.getValue() && d_directLumpedMass.getValue()
+            && m_lumpedMass.collect(this->getContext());
 
+    if (direct)
+    {
+        m_lumpedMass.realloc(params, acc);
+        m_lumpedMass.addSeparateGravity(mop, dt, vel); // v += dt*g . Used if mass wants to add G separately from the other forces to v.
+
+        sofa::helper::AdvancedTimer::stepBegin("ComputeAcc");
+        m_lumpedMass.computeAcc(mop, f, acc);
+        sofa::helper::AdvancedTimer::stepEnd("ComputeAcc");
+    }
     // Mass matrix is diagonal, solution can thus be found by computing acc = f/m
-    if(d_optimizedForDiagonalMatrix.getValue())
+    else if(d_optimizedForDiagonalMatrix.getValue())
     {
+        acc.realloc(&vop, !d_threadSafeVisitor.getValue(), true); // dx is no longer allocated by default (but it will be deleted automatically by the mechanical objects)
+
         mop.addSeparateGravity(dt); // v += dt*g . Used if mass wants to add G separately from the other forces to v.
         sofa::helper::AdvancedTimer::stepBegin("ComputeForce");
         mop.computeForce(f);
@@ -87,6 +102,7 @@ void EulerExplicitSolver::solve(const core::ExecParams* params, SReal dt, sofa::
     }
     else
     {
+        acc.realloc(&vop, !d_threadSafeVisitor.getValue(), true);
         x.realloc(&vop, !d_threadSafeVisitor.getValue(), true);
 
         mop.addSeparateGravity(dt); // v += dt*g . Used if mass wants to added G separately from the other forces to v.
@@ -143,10 +159,18 @@ void EulerExplicitSolver::solve(const core::ExecParams* params, SReal dt, sofa::
         ops[op_pos].second.push_back(std::make_pair(pos.id(),1.0));
         ops[op_pos].second.push_back(std::make_pair(newVel.id(),dt));
 
-        vop.v_multiop(ops);
-
-        mop.solveConstraint(newVel,core::ConstraintParams::VEL);
-        mop.solveConstraint(newPos,core::ConstraintParams::POS);
+        if (direct)
+        {
+            // no constraint solver in the subtree, see LumpedMassOperations::collect
+            m_lumpedMass.vMultiOp(params, ops);
+        }
+        else
+        {
+            vop.v_multiop(ops);
+
+            mop.solveConstraint(newVel,core::ConstraintParams::VEL);
+            mop.solveConstraint(newPos,core::ConstraintParams::POS);
+        }
     }
 #endif
 }
@@ -23,6 +23,7 @@
 #include <SofaExplicitOdeSolver/config.h>
 
 #include <sofa/core/behavior/OdeSolver.h>
+#include <sofa/simulation/LumpedMassOperations.h>
 
 namespace sofa::component::odesolver
 {
@@ -44,6 +45,7 @@ public:
     Data<bool> d_symplectic; ///< If true, the velocities are updated before the positions and the method is symplectic (more robust). If false, the positions are updated before the velocities (standard Euler, less robust).
     Data<bool> d_optimizedForDiagonalMatrix; ///< If M matrix is sparse (MeshMatrixMass), must be set to false (function addMDx() will compute the mass). Else, if true, solution to the system Ax=b can be directly found by computing x = f/m. The function accFromF() in the mass API will be used.
     Data<bool> d_threadSafeVisitor;
+    Data<bool> d_directLumpedMass; ///< If true and the solver subtree holds a single unmapped mechanical state with a mass, the components are called directly instead of through visitors. Requires optimizedForDiagonalMatrix.
 
     /// Given an input derivative order (0 for position, 1 for velocity, 2 for acceleration),
     /// how much will it affect the output derivative of the given order.
@@ -59,6 +61,9 @@ public:
 protected:
     /// the solution vector is stored for warm-start
     core::behavior::MultiVecDeriv x;
+
+    /// components of the subtree, when the visitors can be skipped
+    simulation::common::LumpedMassOperations m_lumpedMass;
 };
 
 } // namespace namespace sofa::component::odesolver
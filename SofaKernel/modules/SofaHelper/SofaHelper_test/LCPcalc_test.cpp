@@ -0,0 +1,193 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/helper/LCPcalc.h>
+
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest ;
+
+#include <sofa/helper/random.h>
+
+
+namespace sofa {
+
+using namespace sofa::helper;
+
+/// Frictional contact problems between rigid-like bodies: each contact couples two of the bodies,
+/// so that W = J.J^T has a sparse block structure with positive normal couplings between neighbour contacts.
+struct LCPcalcTest: public BaseTest
+{
+    int dim;
+    std::vector<double> dfree;
+    std::vector< std::vector<double> > Wdata;
+    std::vector<double*> W;
+
+    void buildProblem(int numContacts, int numBodies)
+    {
+        dim = 3*numContacts;
+        std::vector< std::vector<double> > J(dim, std::vector<double>(3*numBodies, 0.0));
+        for (int c=0; c<numContacts; c++)
+        {
+            const int b1 = c % numBodies;
+            const int b2 = (b1 + 1 + c / numBodies) % numBodies;
+            for (int i=0; i<3; i++)
+                for (int k=0; k<3; k++)
+                {
+                    J[3*c+i][3*b1+k] = helper::drand(0.5);
+                    J[3*c+i][3*b2+k] = helper::drand(0.5);
+                }
+        }
+
+        Wdata.assign(dim, std::vector<double>(dim, 0.0));
+        W.resize(dim);
+        for (int i=0; i<dim; i++)
+        {
+            for (int j=0; j<dim; j++)
+                for (int k=0; k<3*numBodies; k++)
+                    Wdata[i][j] += J[i][k]*J[j][k];
+            Wdata[i][i] += 1e-3;
+            W[i] = Wdata[i].data();
+        }
+
+        dfree.resize(dim);
+        for (int i=0; i<dim; i++)
+            dfree[i] = helper::drand(1.0);
+    }
+
+    static void sequentialFor(int nbItems, const std::function<void(int,int)>& f) { f(0, nbItems); }
+};
+
+TEST_F(LCPcalcTest, coloringSeparatesCoupledContacts)
+{
+    buildProblem(60, 20);
+
+    NLCPBlockColoring coloring;
+    coloring.build(dim, W.data());
+
+    ASSERT_GT(coloring.getNbColors(), 1);
+    ASSERT_EQ((int)coloring.contactsByColor.size(), dim/3);
+    for (int col=0; col<coloring.getNbColors(); col++)
+    {
+        for (int i=coloring.colorBegin[col]; i<coloring.colorBegin[col+1]; i++)
+        {
+            const int c1 = coloring.contactsByColor[i];
+            for (int c2 : coloring.coupledContacts[c1])
+            {
+                if (c2 == c1) continue;
+                for (int j=coloring.colorBegin[col]; j<coloring.colorBegin[col+1]; j++)
+                    EXPECT_NE(coloring.contactsByColor[j], c2) << "contacts " << c1 << " and " << c2 << " are coupled and share color " << col;
+            }
+        }
+    }
+}
+
+TEST_F(LCPcalcTest, coloringIsOnlyRebuiltWhenTheCouplingChanges)
+{
+    buildProblem(60, 20);
+
+    NLCPBlockColoring coloring;
+    ASSERT_TRUE(coloring.update(dim, W.data()));
+    const std::vector<int> contactsByColor = coloring.contactsByColor;
+
+    // new values with the same coupling: the coloring is kept
+    for (int i=0; i<dim; i++)
+        for (int j=0; j<dim; j++)
+            Wdata[i][j] *= 2.0;
+    EXPECT_FALSE(coloring.update(dim, W.data()));
+    EXPECT_EQ(coloring.contactsByColor, contactsByColor);
+
+    // two uncoupled contacts become coupled
+    int c2 = 1;
+    while (coloring.hasCoupling(dim, W.data()) && c2 < dim/3)
+    {
+        if (Wdata[0][3*c2] == 0.0)
+            Wdata[0][3*c2] = Wdata[3*c2][0] = 1e-3;
+        else
+            ++c2;
+    }
+    ASSERT_LT(c2, dim/3);
+    EXPECT_TRUE(coloring.update(dim, W.data()));
+    EXPECT_TRUE(coloring.hasCoupling(dim, W.data()));
+
+    // fewer contacts
+    EXPECT_TRUE(coloring.update(dim-3, W.data()));
+    EXPECT_EQ((int)coloring.contactsByColor.size(), dim/3-1);
+}
+
+TEST_F(LCPcalcTest, coloredGaussSeidelMatchesGaussSeidel)
+{
+    buildProblem(60, 20);
+    const double mu = 0.5;
+
+    std::vector<double> f(dim, 0.0), fColored(dim, 0.0);
+    ASSERT_EQ(nlcp_gaussseidel(dim, dfree.data(), W.data(), f.data(), mu, 1e-10, 5000, false), 1);
+
+    NLCPBlockColoring coloring;
+    coloring.build(dim, W.data());
+    ASSERT_EQ(nlcp_gaussseidel_colored(dim, dfree.data(), W.data(), fColored.data(), mu, 1e-10, 5000, false, coloring, sequentialFor), 1);
+
+    for (int i=0; i<dim; i++)
+        EXPECT_NEAR(f[i], fColored[i], 1e-6);
+}
+
+TEST_F(LCPcalcTest, multiGridConvergesToGaussSeidelSolution)
+{
+    const int numContacts = 60;
+    buildProblem(numContacts, 20);
+    const double mu = 0.5;
+
+    std::vector<double> f(dim, 0.0), fMultiGrid(dim, 0.0);
+    ASSERT_EQ(nlcp_gaussseidel(dim, dfree.data(), W.data(), f.data(), mu, 1e-10, 5000, false), 1);
+
+    // two coarse levels: groups of 4 contacts, then groups of 3 of these groups
+    std::vector< std::vector<int> > contactGroups(2), constraintGroups(2);
+    std::vector< std::vector<double> > constraintFacts(2);
+    std::vector<unsigned int> numGroups { numContacts/4, numContacts/12 };
+    for (int level=0; level<2; level++)
+    {
+        const int numItems = (level == 0) ? numContacts : numContacts/4;
+        const int groupSize = (level == 0) ? 4 : 3;
+        for (int c=0; c<numItems; c++)
+        {
+            contactGroups[level].push_back(c/groupSize);
+            for (int i=0; i<3; i++)
+            {
+                constraintGroups[level].push_back(3*(c/groupSize)+i);
+                constraintFacts[level].push_back(1.0);
+            }
+        }
+    }
+
+    ASSERT_EQ(nlcp_multiGrid_Nlevels(dim, dfree.data(), W.data(), fMultiGrid.data(), mu, 1e-10, 5000, false,
+                                     contactGroups, numGroups, constraintGroups, constraintFacts, false), 1);
+
+    for (int i=0; i<dim; i++)
+        EXPECT_NEAR(f[i], fMultiGrid[i], 1e-6);
+
+    // the prolongated forces stay in the friction cone
+    for (int c=0; c<numContacts; c++)
+    {
+        EXPECT_GE(fMultiGrid[3*c], 0.0);
+        EXPECT_LE(std::hypot(fMultiGrid[3*c+1], fMultiGrid[3*c+2]), mu*fMultiGrid[3*c] + 1e-8);
+    }
+}
+
+} // namespace sofa
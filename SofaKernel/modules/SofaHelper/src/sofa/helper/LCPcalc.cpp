@@ -29,6 +29,7 @@
 #include <fstream>
 #include <cstring>
 #include <iomanip>
+#include <memory>
 
 namespace sofa
 {
@@ -39,17 +40,22 @@ namespace helper
 using namespace std;
 using namespace sofa::helper::system::thread;
 
-LCP::LCP() : maxConst(0), tol(0.00001), numItMax(1000), useInitialF(true), mu(0.0), dim(0)
+LCP::LCP() : maxConst(0), dfree(nullptr), W(nullptr), f(nullptr), f_1(nullptr), d(nullptr), ownsData(false), tol(0.00001), numItMax(1000), useInitialF(true), mu(0.0), dim(0)
 {
 
 }
 
 LCP::~LCP()
 {
-    delete [] dfree;
     delete [] d;
-    delete [] f;
     delete [] f_1;
+
+    // dfree, W and f given through setLCP belong to the caller
+    if (!ownsData)
+        return;
+
+    delete [] dfree;
+    delete [] f;
     for (int i = 0; i < maxConst; i++)
     {
         delete [] W[i];
@@ -76,6 +82,7 @@ void LCP::reset(void)
 void LCP::allocate (unsigned int input_maxConst)
 {
     this->maxConst = input_maxConst;
+    ownsData = true;
 
     W = new double*[maxConst];
     for (int i = 0; i < (int)maxConst; i++)
@@ -104,7 +111,10 @@ void LCP::setLCP(unsigned int input_dim, double *input_dfree, double **input_W,
     tol = input_tol;
     mu = input_mu;
     maxConst = dim;
+    ownsData = false;
 
+    delete [] d;
+    delete [] f_1;
     d = new double[maxConst];
     f_1= new double[maxConst];
     memset(d, 0, maxConst * sizeof(double));
@@ -875,7 +885,7 @@ void projection(LCP &fineLevel, LCP &coarseLevel, int nbContactsCoarse, const st
     {
         if (!group_has_projection[g])
         {
-            dmsg_error("LCPcalc") <<"NO PROJECTION FOR GROUP "<<g<<" projection of the closest contact" ;
+            dmsg_info("LCPcalc") <<"no active contact in group "<<g<<": projection of the closest contact" ;
 
             double dmin = 0.0;
             int projected_contact=-1;
@@ -885,12 +895,12 @@ void projection(LCP &fineLevel, LCP &coarseLevel, int nbContactsCoarse, const st
                 {
                     dmin = fineLevel.getD()[3*c1];
                     projected_contact = c1;
-                    contact_is_projected[c1]= true;
                 }
 
             }
             if (projected_contact >=0)
             {
+                contact_is_projected[projected_contact]= true;
                 group_has_projection[g]=true;
                 size_of_group[g] +=1;
             }
@@ -978,9 +988,21 @@ void prolongation(LCP &fineLevel, LCP &coarseLevel, const std::vector<int> &proj
             fineLevel.getF()[3*c1+1]  +=  ( coarseLevel.getF()[g_t_id] - coarseLevel.getF_1()[g_t_id] ) * g_t_f;
             fineLevel.getF()[3*c1+2]  +=  ( coarseLevel.getF()[g_s_id] - coarseLevel.getF_1()[g_s_id] ) * g_s_f;
 
-            if ( fineLevel.getF()[3*c1  ] < 0)
+            double* fc = fineLevel.getF() + 3*c1;
+            if (fc[0] < 0)
+            {
+                fc[0]=0;  fc[1]=0;  fc[2]=0;
+            }
+            else
             {
-                fineLevel.getF()[3*c1  ]=0;  fineLevel.getF()[3*c1+1]=0;  fineLevel.getF()[3*c1+2]=0;
+                // the interpolated force must stay in the friction cone
+                const double normFt = sqrt(fc[1]*fc[1] + fc[2]*fc[2]);
+                const double maxFt = fineLevel.getMu()*fc[0];
+                if (normFt > maxFt)
+                {
+                    fc[1] *= maxFt/normFt;
+                    fc[2] *= maxFt/normFt;
+                }
             }
         }
     }
@@ -995,7 +1017,7 @@ int nlcp_multiGrid_2levels(int dim, double *dfree, double**W, double *f, double
         bool verbose, std::vector<double>* residuals1, std::vector<double>* residuals2)
 {
 
-    LCP *fineLevel = new LCP();
+    std::unique_ptr<LCP> fineLevel(new LCP());
     fineLevel->setLCP(dim,dfree, W, f, mu,tol,numItMax);
 
 
@@ -1009,13 +1031,14 @@ int nlcp_multiGrid_2levels(int dim, double *dfree, double**W, double *f, double
     if (residuals1 && residuals2) while (residuals2->size() < residuals1->size()) residuals2->push_back(pow(10.0,0.0));
 
     // projection step & construction of the coarse LCP
-    LCP *coarseLevel = new LCP();
+    std::unique_ptr<LCP> coarseLevel(new LCP());
 
     if(verbose)
         msg_info("LCPcalc") <<"allocation of size"<<num_group<<" at coarse level" ;
 
     coarseLevel->allocate(3*num_group); // allocation of the memory for the coarse LCP
     coarseLevel->setDim(3*num_group);
+    coarseLevel->getMu() = mu;
 
     std::vector<bool> contact_is_projected;
     projection((*fineLevel), (*coarseLevel), num_group, contact_group, constraint_group, constraint_group_fact, contact_is_projected, verbose);
@@ -1057,7 +1080,7 @@ int nlcp_multiGrid_2levels(int dim, double *dfree, double**W, double *f, double
 }
 
 
-int nlcp_multiGrid_Nlevels(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, std::vector< std::vector< int> > &contact_group_hierarchy, std::vector<unsigned int> Tab_num_group, std::vector< std::vector< int> > &constraint_group_hierarchy, std::vector< std::vector< double> > &constraint_group_fact_hierarchy, bool verbose, std::vector<double> *residualsN, std::vector<double> *residualLevels, std::vector<double> *violations)
+int nlcp_multiGrid_Nlevels(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, std::vector< std::vector< int> > &contact_group_hierarchy, std::vector<unsigned int> Tab_num_group, std::vector< std::vector< int> > &constraint_group_hierarchy, std::vector< std::vector< double> > &constraint_group_fact_hierarchy, bool verbose, std::vector<double> *residualsN, std::vector<double> *residualLevels, std::vector<double> *violations, bool solveFinestLevel)
 {
     if (dim == 0) return 1; // nothing to do
     std::size_t num_hierarchies = Tab_num_group.size();
@@ -1077,10 +1100,13 @@ int nlcp_multiGrid_Nlevels(int dim, double *dfree, double**W, double *f, double
         return 0;
     }
 
-    std::vector<LCP *> hierarchicalLevels;
+    // number of iterations done at each level before the projection on the coarser one
+    const int numItPreSmoothing = 2;
+
+    std::vector< std::unique_ptr<LCP> > hierarchicalLevels;
     hierarchicalLevels.resize(num_hierarchies+1);
 
-    hierarchicalLevels[0] = new LCP(); // finest level !
+    hierarchicalLevels[0].reset(new LCP()); // finest level !
     hierarchicalLevels[0]->setLCP(dim,dfree, W, f, mu,tol,numItMax);
 
     if (!useInitialF)
@@ -1098,7 +1124,7 @@ int nlcp_multiGrid_Nlevels(int dim, double *dfree, double**W, double *f, double
     {
         // iterations at the fine Level (no test of convergence)
 
-        hierarchicalLevels[h]->setNumItMax(0);
+        hierarchicalLevels[h]->setNumItMax(numItPreSmoothing);
         hierarchicalLevels[h]->solveNLCP(convergenceTest, residualsN, violations);
 
         if (residualsN && residualLevels)
@@ -1106,12 +1132,13 @@ int nlcp_multiGrid_Nlevels(int dim, double *dfree, double**W, double *f, double
                 residualLevels->push_back(pow(10.0,(double)h));
 
         // projection step & construction of the coarse LCP
-        hierarchicalLevels[h+1] = new LCP();
+        hierarchicalLevels[h+1].reset(new LCP());
 
         dmsg_info_when(verbose, "LCPCalc") << "Hierarchical level "<<h<<": allocation of size"<<Tab_num_group[h]<<" at coarse level" ;
 
         hierarchicalLevels[h+1]->allocate(3*Tab_num_group[h]); // allocation of the memory for the coarse LCP
         hierarchicalLevels[h+1]->setDim(3*Tab_num_group[h]);
+        hierarchicalLevels[h+1]->getMu() = mu;
 
         // call to projection function
         projection((*hierarchicalLevels[h]), (*hierarchicalLevels[h+1]), Tab_num_group[h], contact_group_hierarchy[h], constraint_group_hierarchy[h], constraint_group_fact_hierarchy[h], contact_is_projected[h], verbose);
@@ -1143,6 +1170,10 @@ int nlcp_multiGrid_Nlevels(int dim, double *dfree, double**W, double *f, double
         // prolongation (interpolation) at the fine level
         prolongation((*hierarchicalLevels[h]), (*hierarchicalLevels[h+1]), contact_group_hierarchy[h], constraint_group_hierarchy[h], constraint_group_fact_hierarchy[h], contact_is_projected[h], verbose);
 
+        // the caller may solve the finest level with its own solver
+        if (h == 0 && !solveFinestLevel)
+            break;
+
         // iterations at the fine level (till convergence)
         convergenceTest = true;
         hierarchicalLevels[h]->setNumItMax(numItMax);
@@ -1715,6 +1746,241 @@ int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, do
 
 }
 
+namespace
+{
+
+/// True if the block of W between the contacts c1 and c2 is not null (a contact is always coupled with itself)
+bool areContactsCoupled(double** W, int c1, int c2)
+{
+    bool coupled = (c1 == c2);
+    for (int i=0; i<3 && !coupled; i++)
+        for (int j=0; j<3 && !coupled; j++)
+            coupled = (W[3*c1+i][3*c2+j] != 0.0);
+    return coupled;
+}
+
+} // namespace
+
+bool NLCPBlockColoring::update(int dim, double** W)
+{
+    if (hasCoupling(dim, W))
+        return false;
+    build(dim, W);
+    return true;
+}
+
+bool NLCPBlockColoring::hasCoupling(int dim, double** W) const
+{
+    const int numContacts = dim/3;
+    if (int(coupledContacts.size()) != numContacts || int(contactsByColor.size()) != numContacts)
+        return false;
+
+    for (int c1=0; c1<numContacts; c1++)
+    {
+        auto listed = coupledContacts[c1].begin();
+        const auto listEnd = coupledContacts[c1].end();
+        for (int c2=0; c2<numContacts; c2++)
+        {
+            const bool isListed = (listed != listEnd && *listed == c2);
+            if (areContactsCoupled(W, c1, c2) != isListed)
+                return false;
+            if (isListed)
+                ++listed;
+        }
+    }
+    return true;
+}
+
+void NLCPBlockColoring::build(int dim, double** W)
+{
+    const int numContacts = dim/3;
+
+    coupledContacts.clear();
+    coupledContacts.resize(numContacts);
+    for (int c1=0; c1<numContacts; c1++)
+    {
+        for (int c2=0; c2<numContacts; c2++)
+        {
+            if (areContactsCoupled(W, c1, c2))
+                coupledContacts[c1].push_back(c2);
+        }
+    }
+
+    // greedy coloring: each contact takes the first color not used by an already colored coupled contact
+    std::vector<int> color(numContacts, -1);
+    std::vector<int> colorUsedBy; // last contact which marked each color as unavailable
+    int nbColors = 0;
+    for (int c1=0; c1<numContacts; c1++)
+    {
+        for (int c2 : coupledContacts[c1])
+        {
+            if (color[c2] >= 0)
+                colorUsedBy[color[c2]] = c1;
+        }
+        int col = 0;
+        while (col < nbColors && colorUsedBy[col] == c1)
+            ++col;
+        if (col == nbColors)
+        {
+            colorUsedBy.push_back(-1);
+            ++nbColors;
+        }
+        color[c1] = col;
+    }
+
+    colorBegin.assign(nbColors+1, 0);
+    for (int c1=0; c1<numContacts; c1++)
+        ++colorBegin[color[c1]+1];
+    for (int col=0; col<nbColors; col++)
+        colorBegin[col+1] += colorBegin[col];
+
+    contactsByColor.resize(numContacts);
+    std::vector<int> next(colorBegin.begin(), colorBegin.end()-1);
+    for (int c1=0; c1<numContacts; c1++)
+        contactsByColor[next[color[c1]]++] = c1;
+}
+
+int nlcp_gaussseidel_colored(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF,
+        const NLCPBlockColoring& coloring, const NLCPParallelFor& parallelFor, double minW, double maxF, std::vector<double>* residuals, std::vector<double>* violations)
+{
+    const int numContacts = dim/3;
+
+    if (dim % 3)
+    {
+        dmsg_info("LCPcalc") << "dim should be dividable by 3 in nlcp_gaussseidel_colored" ;
+        return 0;
+    }
+    if ((int)coloring.coupledContacts.size() != numContacts)
+    {
+        dmsg_error("LCPcalc") << "the coloring does not match the size of the system in nlcp_gaussseidel_colored" ;
+        return 0;
+    }
+
+    // put the vector force to zero
+    if (!useInitialF)
+        memset(f, 0, dim*sizeof(double));
+
+    // inverted systems 3x3 and error of each contact (summed after each sweep, to keep it independent from the threads)
+    std::vector<LocalBlock33> W33(numContacts);
+    std::vector<double> contactError(numContacts, 0.0);
+
+    // contacts with a too small compliance are not solved
+    if (minW != 0.0)
+    {
+        for (int c1=0; c1<numContacts; c1++)
+        {
+            if (fabs(W[3*c1][3*c1]) <= minW)
+            {
+                std::stringstream tmpmsg;
+                tmpmsg << "Compliance too small for contact " << c1 << ": |" << std::scientific << W[3*c1][3*c1] << "| < " << minW << std::fixed ;
+                dmsg_warning("LCPcalc") << tmpmsg.str() ;
+            }
+        }
+    }
+
+    // update of one contact: only reads the forces of the coupled contacts, which never share its color
+    auto solveContact = [&](int c1)
+    {
+        const double f_1[3] = { f[3*c1], f[3*c1+1], f[3*c1+2] };
+        set3Dof(f,c1,0.0,0.0,0.0);
+
+        // computation of actual d due to contribution of other contacts
+        double dn=dfree[3*c1], dt=dfree[3*c1+1], ds=dfree[3*c1+2];
+        for (int c2 : coloring.coupledContacts[c1])
+        {
+            for (int j=0; j<3; j++)
+            {
+                const double fj = f[3*c2+j];
+                dn += W[3*c1  ][3*c2+j]*fj;
+                dt += W[3*c1+1][3*c2+j]*fj;
+                ds += W[3*c1+2][3*c2+j]*fj;
+            }
+        }
+        double d_1[3];
+        d_1[0] = dn + W[3*c1  ][3*c1  ]*f_1[0]+W[3*c1  ][3*c1+1]*f_1[1]+W[3*c1  ][3*c1+2]*f_1[2];
+        d_1[1] = dt + W[3*c1+1][3*c1  ]*f_1[0]+W[3*c1+1][3*c1+1]*f_1[1]+W[3*c1+1][3*c1+2]*f_1[2];
+        d_1[2] = ds + W[3*c1+2][3*c1  ]*f_1[0]+W[3*c1+2][3*c1+1]*f_1[1]+W[3*c1+2][3*c1+2]*f_1[2];
+
+        double fn=0, ft=0, fs=0;
+        if (minW == 0.0 || fabs(W[3*c1][3*c1]) > minW)
+        {
+            LocalBlock33& block = W33[c1];
+            if (block.computed==false)
+            {
+                block.compute(W[3*c1][3*c1],W[3*c1][3*c1+1],W[3*c1][3*c1+2],
+                        W[3*c1+1][3*c1+1], W[3*c1+1][3*c1+2],W[3*c1+2][3*c1+2]);
+            }
+
+            fn=f_1[0]; ft=f_1[1]; fs=f_1[2];
+            double contactMu = mu;
+            block.GS_State(contactMu,dn,dt,ds,fn,ft,fs);
+        }
+        contactError[c1] = absError(dn,dt,ds,d_1[0],d_1[1],d_1[2]);
+        set3Dof(f,c1,fn,ft,fs);
+    };
+
+    const int nbColors = coloring.getNbColors();
+    double error = 0;
+    int it;
+    for (it=0; it<numItMax; it++)
+    {
+        for (int col=0; col<nbColors; col++)
+        {
+            const int* colorContacts = coloring.contactsByColor.data() + coloring.colorBegin[col];
+            parallelFor(coloring.colorBegin[col+1] - coloring.colorBegin[col], [&](int begin, int end)
+            {
+                for (int i=begin; i<end; i++)
+                    solveContact(colorContacts[i]);
+            });
+        }
+
+        error = 0;
+        for (int c1=0; c1<numContacts; c1++)
+            error += contactError[c1];
+
+        if (residuals) residuals->push_back(error);
+        if (violations)
+        {
+            double sum_d = 0;
+            for (int c1=0; c1<numContacts; c1++)
+            {
+                double dn = dfree[3*c1];
+                for (int c2 : coloring.coupledContacts[c1])
+                {
+                    for (int j=0; j<3; j++)
+                        dn += W[3*c1][3*c2+j]*f[3*c2+j];
+                }
+                if (dn < 0)
+                    sum_d += -dn;
+            }
+            violations->push_back(sum_d);
+        }
+
+        if (error < tol*(numContacts+1))
+        {
+            if (maxF != 0.0)
+            {
+                for (int c1=0; c1<numContacts; c1++)
+                {
+                    if (fabs(f[3*c1]) >= maxF)
+                    {
+                        // constraint force is too large
+                        std::stringstream tmp ;
+                        tmp <<"Force too large for contact " << c1 << " : |" << std::scientific << f[3*c1] << "| > " << maxF << std::fixed ;
+                        dmsg_info("LCPcalc") << tmp.str() ;
+                        set3Dof(f,c1,0.0,0.0,0.0);
+                    }
+                }
+            }
+            sofa::helper::AdvancedTimer::valSet("GS iterations", it+1);
+            return 1;
+        }
+    }
+    sofa::helper::AdvancedTimer::valSet("GS iterations", it);
+
+    return 0;
+}
+
 int nlcp_gaussseidelTimed(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, double timeout, bool verbose)
 {
     double test = dim/3;
@@ -28,6 +28,7 @@
 #include <sofa/helper/system/thread/CTime.h>
 #include <vector>
 #include <ostream>
+#include <functional>
 
 
 namespace sofa
@@ -48,6 +49,7 @@ private:
     double** W;
     double* f, *f_1;
     double* d;
+    bool ownsData; // dfree, W and f were allocated by this LCP (allocate) and not given by setLCP
     double tol;
     int numItMax;
     bool useInitialF;
@@ -149,10 +151,37 @@ SOFA_HELPER_API int nlcp_multiGrid(int dim, double *dfree, double**W, double *f,
 SOFA_HELPER_API int nlcp_multiGrid_2levels(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF,
         std::vector< int> &contact_group, unsigned int num_group, std::vector< int> &constraint_group, std::vector<double> &constraint_group_fact, bool verbose, std::vector<double>* residuals1 = nullptr, std::vector<double>* residuals2 = nullptr);
 SOFA_HELPER_API int nlcp_multiGrid_Nlevels(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF,
-        std::vector< std::vector< int> > &contact_group_hierarchy, std::vector<unsigned int> Tab_num_group, std::vector< std::vector< int> > &constraint_group_hierarchy, std::vector< std::vector< double> > &constraint_group_fact_hierarchy, bool verbose, std::vector<double> *residualsN = nullptr, std::vector<double> *residualLevels = nullptr, std::vector<double> *violations = nullptr);
+        std::vector< std::vector< int> > &contact_group_hierarchy, std::vector<unsigned int> Tab_num_group, std::vector< std::vector< int> > &constraint_group_hierarchy, std::vector< std::vector< double> > &constraint_group_fact_hierarchy, bool verbose, std::vector<double> *residualsN = nullptr, std::vector<double> *residualLevels = nullptr, std::vector<double> *violations = nullptr, bool solveFinestLevel = true);
 
 // Gauss-Seidel like algorithm for contacts
 SOFA_HELPER_API int nlcp_gaussseidel(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF, bool verbose = false, double minW=0.0, double maxF=0.0, std::vector<double>* residuals = nullptr, std::vector<double>* violations = nullptr);
+
+/// Coupling structure between the contacts (3x3 blocks) of a dense compliance matrix W.
+/// Two contacts are coupled when their block in W is not null. Contacts are then colored so that two contacts of the
+/// same color are never coupled: within a Gauss-Seidel sweep they can be updated in any order, or concurrently.
+class SOFA_HELPER_API NLCPBlockColoring
+{
+public:
+    void build(int dim, double** W);
+    /// Rebuild the coloring only if the coupling of the contacts in W is not the one it was built from. Return true if it was rebuilt
+    bool update(int dim, double** W);
+    /// True if coupledContacts is the coupling of the contacts in W
+    bool hasCoupling(int dim, double** W) const;
+
+    int getNbColors() const { return colorBegin.empty() ? 0 : int(colorBegin.size()) - 1; }
+
+    std::vector< std::vector<int> > coupledContacts; ///< for each contact, the contacts coupled with it (itself included)
+    std::vector<int> contactsByColor; ///< contacts sorted by color
+    std::vector<int> colorBegin; ///< for each color, its first index in contactsByColor (nbColors+1 values)
+};
+
+/// Function running rangeFunction(begin,end) over the range [0,nbItems), possibly splitting it between several threads
+typedef std::function< void(int nbItems, const std::function<void(int,int)>& rangeFunction) > NLCPParallelFor;
+
+// Gauss-Seidel like algorithm for contacts, the contacts of each color being updated through parallelFor.
+// The products with W are restricted to the coupled contacts. Same convergence criterion as nlcp_gaussseidel.
+SOFA_HELPER_API int nlcp_gaussseidel_colored(int dim, double *dfree, double**W, double *f, double mu, double tol, int numItMax, bool useInitialF,
+        const NLCPBlockColoring& coloring, const NLCPParallelFor& parallelFor, double minW=0.0, double maxF=0.0, std::vector<double>* residuals = nullptr, std::vector<double>* violations = nullptr);
 // Timed Gauss-Seidel like algorithm for contacts
 SOFA_HELPER_API int nlcp_gaussseidelTimed(int, double *, double**, double *, double, double, int, bool, double timeout, bool verbose=false);
 } // namespace helper
@@ -79,7 +79,7 @@ struct EulerImplicitDynamic_test : public BaseSimulationTest
 
     
     /// Create the context for the scene
-    void createScene(double K, double m, double l0, double rm = 0, double rk=0)
+    void createScene(double K, double m, double l0, double rm = 0, double rk=0, bool adaptive = false, double adaptiveTolerance = 1e-3)
     { 
         // Init simulation
         sofa::simulation::setSimulation(simulation = new sofa::simulation::graph::DAGSimulation());
@@ -92,6 +92,8 @@ struct EulerImplicitDynamic_test : public BaseSimulationTest
         EulerImplicitSolver::SPtr eulerSolver = addNew<EulerImplicitSolver> (root);
         eulerSolver->f_rayleighStiffness.setValue(rk);
         eulerSolver->f_rayleighMass.setValue(rm);
+        eulerSolver->d_adaptiveTimeStep.setValue(adaptive);
+        eulerSolver->d_adaptiveTolerance.setValue(adaptiveTolerance);
 
         CGLinearSolver::SPtr cgLinearSolver = addNew<CGLinearSolver>   (root);
         cgLinearSolver->d_maxIter.setValue(3000);
@@ -192,6 +194,40 @@ struct EulerImplicitDynamic_test : public BaseSimulationTest
         return true;
     }
 
+    /// After simulation compare the positions of points to the exact solution of the undamped oscillation
+    /// x(t) = x_eq + (m g / K) cos(w t), starting at rest from the spring rest length
+    bool compareSimulatedToAnalyticalPositions(double tolerance, double h, double K, double m, double g)
+    {
+        sofa::simulation::getSimulation()->init(root.get());
+
+        simulation::Node::SPtr massNode = root->getChild("MassNode");
+        typename MechanicalObject::SPtr dofs = massNode->get<MechanicalObject>(root->SearchDown);
+
+        const double amplitude = m * g / K;
+        const double pulsation = sqrt(K / m);
+        const double z0 = dofs.get()->read(sofa::core::ConstVecCoordId::position())->getValue()[0][1];
+
+        double time = root->getTime();
+        while (time < 2)
+        {
+            sofa::simulation::getSimulation()->animate(root.get(),h);
+            time = root->getTime();
+
+            Coord p0=dofs.get()->read(sofa::core::ConstVecCoordId::position())->getValue()[0];
+            const double expected = z0 - amplitude + amplitude * cos(pulsation * time);
+            const double absoluteError = fabs(p0[1]-expected);
+            if( absoluteError > tolerance )
+            {
+                ADD_FAILURE() << "Position of mass at time " << time << " is wrong: "  << std::endl
+                    <<" expected Position is " << expected << std::endl
+                    <<" actual Position is   " << p0[1] << std::endl
+                    << "absolute error     = " << absoluteError << std::endl;
+                return false;
+            }
+        }
+        return true;
+    }
+
 };
 
 // Define the list of DataTypes to instanciate
@@ -235,4 +271,11 @@ TYPED_TEST( EulerImplicitDynamic_test , eulerImplicitSolverDynamicTest_small_dt_
    this-> compareSimulatedToTheoreticalPositions(5e-16,0.001);
 }
 
+// Test case: h=0.1 k=100 m=10, adaptive sub-steps keep the error well below the fixed step one (about 0.62)
+TYPED_TEST( EulerImplicitDynamic_test , eulerImplicitSolverDynamicTest_high_dt_adaptive)
+{
+   this->createScene(100,10,1,0,0,true,1e-5); // k,m,l0,rm,rk,adaptive,tolerance
+   this->compareSimulatedToAnalyticalPositions(0.15,0.1,100,10,10);
+}
+
 } // namespace sofa
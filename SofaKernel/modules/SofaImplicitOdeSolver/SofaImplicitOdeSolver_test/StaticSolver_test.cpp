@@ -22,6 +22,7 @@
 #include <sofa/testing/BaseTest.h>
 #include <sofa/simulation/Node.h>
 #include <SofaImplicitOdeSolver/StaticSolver.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
 #include <SofaSimulationGraph/DAGSimulation.h>
 #include <SofaSimulationGraph/SimpleApi.h>
 
@@ -66,7 +67,7 @@ public:
         createObject(root, "RequiredPlugin", {{"pluginName", "SofaBoundaryCondition SofaEngine SofaMiscFem SofaImplicitOdeSolver SofaSparseSolver SofaTopologyMapping"}});
         createObject(root, "RegularGridTopology", {{"name", "grid"}, {"min", "-7.5 -7.5 0"}, {"max", "7.5 7.5 80"}, {"n", "3 3 9"}});
         auto s = createObject(root, "StaticSolver", {{"newton_iterations", "10"}});
-        createObject(root, "SparseLDLSolver");
+        createObject(root, "SparseLDLSolver", {{"name", "linear_solver"}});
         createObject(root, "MechanicalObject", {{"name", "mo"}, {"src", "@grid"}});
         createObject(root, "TetrahedronSetTopologyContainer", {{"name", "mechanical_topology"}});
         createObject(root, "TetrahedronSetTopologyModifier");
@@ -90,6 +91,27 @@ public:
         getSimulation()->unload(root);
     }
 
+    /// Set the convergence criteria to an absolute residual threshold only
+    void useAbsoluteResidualCriterion(unsigned newton_iterations, double threshold) {
+        using namespace sofa::core::objectmodel;
+        dynamic_cast< Data<unsigned> * > ( this->solver->findData("newton_iterations") )->setValue(newton_iterations);
+        dynamic_cast< Data<double> *   > ( this->solver->findData("absolute_correction_tolerance_threshold") )->setValue(-1);
+        dynamic_cast< Data<double> *   > ( this->solver->findData("relative_correction_tolerance_threshold") )->setValue(-1);
+        dynamic_cast< Data<double> *   > ( this->solver->findData("absolute_residual_tolerance_threshold")   )->setValue(threshold);
+        dynamic_cast< Data<double> *   > ( this->solver->findData("relative_residual_tolerance_threshold")   )->setValue(-1);
+        dynamic_cast< Data<bool> *     > ( this->solver->findData("should_diverge_when_residual_is_growing") )->setValue(false);
+    }
+
+    /// Current positions of the beam nodes
+    auto positions() -> std::vector<SReal> {
+        auto * mo = dynamic_cast<sofa::core::behavior::BaseMechanicalState *> (root->getObject("mo"));
+        std::vector<SReal> p;
+        for (sofa::Index i = 0; i < mo->getSize(); ++i) {
+            p.insert(p.end(), {mo->getPX(i), mo->getPY(i), mo->getPZ(i)});
+        }
+        return p;
+    }
+
     auto execute() -> std::pair<std::vector<double>, std::vector<double>> {
         using namespace std;
         getSimulation()->init(root.get());
@@ -256,4 +278,90 @@ TEST_F(StaticSolverTest, AbsoluteIncrements) {
     std::vector<double> actual_increment_norms = this->execute().second;
     EXPECT_EQ(actual_increment_norms.size(), 7)
     << "The static ODE solver is supposed to converge after 7 Newton steps when using a relative correction threshold of 1e-5.";
-}
\ No newline at end of file
+}
+
+TEST_F(StaticSolverTest, LineSearchKeepsNewtonSteps) {
+    using namespace sofa::core::objectmodel;
+    // Disable all convergence criteria BUT the absolute residual
+    dynamic_cast< Data<unsigned> * > ( this->solver->findData("newton_iterations") )->setValue(10);
+    dynamic_cast< Data<double> *   > ( this->solver->findData("absolute_correction_tolerance_threshold") )->setValue(-1);
+    dynamic_cast< Data<double> *   > ( this->solver->findData("relative_correction_tolerance_threshold") )->setValue(-1);
+    dynamic_cast< Data<double> *   > ( this->solver->findData("absolute_residual_tolerance_threshold")   )->setValue(1e-5);
+    dynamic_cast< Data<double> *   > ( this->solver->findData("relative_residual_tolerance_threshold")   )->setValue(-1);
+    dynamic_cast< Data<bool> *     > ( this->solver->findData("should_diverge_when_residual_is_growing") )->setValue(false);
+    dynamic_cast< Data<bool> *     > ( this->solver->findData("line_search") )->setValue(true);
+
+    // Every full Newton step decreases the residual enough, the line search must not change the iterations
+    std::vector<double> actual_force_residual_norms = this->execute().first;
+    EXPECT_EQ(actual_force_residual_norms.size(), 8)
+    << "The line search is not supposed to modify Newton steps which already decrease the residual.";
+    EXPECT_EQ(this->solver->number_of_jacobian_updates(), 8);
+}
+
+TEST_F(StaticSolverTest, JacobianReuse) {
+    using namespace sofa::core::objectmodel;
+    for (const std::string update : {"chord", "bfgs"})
+    {
+        // Disable all convergence criteria BUT the absolute residual
+        dynamic_cast< Data<unsigned> * > ( this->solver->findData("newton_iterations") )->setValue(50);
+        dynamic_cast< Data<double> *   > ( this->solver->findData("absolute_correction_tolerance_threshold") )->setValue(-1);
+        dynamic_cast< Data<double> *   > ( this->solver->findData("relative_correction_tolerance_threshold") )->setValue(-1);
+        dynamic_cast< Data<double> *   > ( this->solver->findData("absolute_residual_tolerance_threshold")   )->setValue(1e-5);
+        dynamic_cast< Data<double> *   > ( this->solver->findData("relative_residual_tolerance_threshold")   )->setValue(-1);
+        dynamic_cast< Data<bool> *     > ( this->solver->findData("should_diverge_when_residual_is_growing") )->setValue(false);
+        this->solver->findData("jacobian_update")->read(update);
+        this->solver->findData("line_search")->read("true");
+
+        std::vector<double> actual_force_residual_norms = this->execute().first;
+        ASSERT_FALSE(actual_force_residual_norms.empty());
+        EXPECT_LT(actual_force_residual_norms.back(), 1e-5)
+        << "The static ODE solver is supposed to converge with " << update << " updates of the system matrix.";
+        EXPECT_LT(this->solver->number_of_jacobian_updates(), actual_force_residual_norms.size())
+        << "The system matrix is supposed to be reused with " << update << " updates.";
+
+        getSimulation()->unload(root);
+        onSetUp();
+    }
+}
+
+TEST_F(StaticSolverTest, ChordMatchesFullNewton) {
+    // Reference solution, the system matrix being assembled at every Newton iteration
+    useAbsoluteResidualCriterion(10, 1e-5);
+    this->execute();
+    const auto full_positions = positions();
+    const auto full_updates = this->solver->number_of_jacobian_updates();
+
+    getSimulation()->unload(root);
+    onSetUp();
+
+    // Same load increment with the factorized matrix of the direct solver reused between iterations
+    useAbsoluteResidualCriterion(50, 1e-5);
+    this->solver->findData("jacobian_update")->read("chord");
+    this->execute();
+    const auto chord_positions = positions();
+
+    EXPECT_LT(this->solver->number_of_jacobian_updates(), full_updates)
+    << "The chord updates are supposed to assemble and factorize the system matrix less often.";
+    ASSERT_EQ(chord_positions.size(), full_positions.size());
+    for (std::size_t i = 0; i < full_positions.size(); ++i) {
+        EXPECT_NEAR(chord_positions[i], full_positions[i], 1e-4)
+        << "The chord updates are supposed to converge to the same solution.";
+    }
+}
+
+TEST_F(StaticSolverTest, JacobianReuseNeedsAssembledMatrix) {
+    // Replace the direct solver by an iterative one working on non-assembled matrices
+    root->removeObject(root->getObject("linear_solver"));
+    createObject(root, "CGLinearSolver", {{"iterations", "1000"}, {"tolerance", "1e-15"}, {"threshold", "1e-15"}});
+
+    useAbsoluteResidualCriterion(10, 1e-5);
+    this->solver->findData("jacobian_update")->read("chord");
+    {
+        EXPECT_MSG_EMIT(Warning);
+        this->execute();
+    }
+
+    EXPECT_EQ(this->solver->findData("jacobian_update")->getValueString(), "full")
+    << "The static ODE solver is supposed to fall back to full updates without an assembled matrix.";
+    EXPECT_EQ(this->solver->number_of_jacobian_updates(), this->solver->squared_residual_norms().size());
+}
@@ -28,6 +28,9 @@
 #include <sofa/core/ObjectFactory.h>
 #include <sofa/core/behavior/MultiMatrix.h>
 
+#include <algorithm>
+#include <cmath>
+
 
 namespace sofa::component::odesolver
 {
@@ -43,6 +46,9 @@ EulerImplicitSolver::EulerImplicitSolver()
     , d_trapezoidalScheme( initData(&d_trapezoidalScheme,false,"trapezoidalScheme","Optional: use the trapezoidal scheme instead of the implicit Euler scheme and get second order accuracy in time") )
     , f_solveConstraint( initData(&f_solveConstraint,false,"solveConstraint","Apply ConstraintSolver (requires a ConstraintSolver in the same node as this solver, disabled by by default for now)") )
     , d_threadSafeVisitor(initData(&d_threadSafeVisitor, false, "threadSafeVisitor", "If true, do not use realloc and free visitors in fwdInteractionForceField."))
+    , d_adaptiveTimeStep(initData(&d_adaptiveTimeStep, false, "adaptiveTimeStep", "Subdivide the time step according to an estimation of the local integration error (difference between the implicit Euler and trapezoidal schemes)"))
+    , d_adaptiveTolerance(initData(&d_adaptiveTolerance, (SReal)1e-3, "adaptiveTolerance", "Maximum local position error accepted for a sub-step in adaptive mode"))
+    , d_minTimeStep(initData(&d_minTimeStep, (SReal)0.0, "minTimeStep", "Smallest sub-step used in adaptive mode (0 means dt/1000)"))
 {
 }
 
@@ -64,22 +70,130 @@ void EulerImplicitSolver::cleanup()
     // free the locally created vector x (including eventual external mechanical states linked by an InteractionForceField)
     sofa::simulation::common::VectorOperations vop( core::execparams::defaultInstance(), this->getContext() );
     vop.v_free(x.id(), !d_threadSafeVisitor.getValue(), true);
+    vop.v_free(m_subStepPosition.id(), !d_threadSafeVisitor.getValue(), true);
+    vop.v_free(m_subStepVelocity.id(), !d_threadSafeVisitor.getValue(), true);
+    vop.v_free(m_errorVelocity.id(), !d_threadSafeVisitor.getValue(), true);
 }
 
 void EulerImplicitSolver::solve(const core::ExecParams* params, SReal dt, sofa::core::MultiVecCoordId xResult, sofa::core::MultiVecDerivId vResult)
+{
+    if (d_adaptiveTimeStep.getValue())
+        solveAdaptive(params, dt, xResult, vResult);
+    else
+        integrate(params, dt, d_trapezoidalScheme.getValue(), core::VecCoordId::position(), core::VecDerivId::velocity(), xResult, vResult);
+}
+
+void EulerImplicitSolver::solveAdaptive(const core::ExecParams* params, SReal dt, sofa::core::MultiVecCoordId xResult, sofa::core::MultiVecDerivId vResult)
+{
+    sofa::simulation::common::VectorOperations vop( params, this->getContext() );
+    sofa::simulation::common::MechanicalOperations mop( params, this->getContext() );
+    MultiVecCoord pos(&vop, core::VecCoordId::position() );
+    MultiVecDeriv vel(&vop, core::VecDerivId::velocity() );
+    MultiVecCoord newPos(&vop, xResult );
+    MultiVecDeriv newVel(&vop, vResult );
+
+    m_subStepPosition.realloc(&vop, !d_threadSafeVisitor.getValue(), true);
+    m_subStepVelocity.realloc(&vop, !d_threadSafeVisitor.getValue(), true);
+    m_errorVelocity.realloc(&vop, !d_threadSafeVisitor.getValue(), true);
+
+    // the sub-steps are computed in place in the result vectors
+    if (newPos.id().getDefaultId() != pos.id().getDefaultId())
+        newPos.eq(pos);
+    if (newVel.id().getDefaultId() != vel.id().getDefaultId())
+        newVel.eq(vel);
+
+    const bool trapezoidal = d_trapezoidalScheme.getValue();
+    const SReal tolerance = d_adaptiveTolerance.getValue();
+    const SReal minStep = (d_minTimeStep.getValue() > 0) ? std::min(d_minTimeStep.getValue(), dt) : dt * 1e-3;
+    const SReal safety = 0.9;
+    const SReal minFactor = 0.2;
+    const SReal maxFactor = 2.0;
+
+    // the error of both schemes over a sub-step is O(h^2), hence the square root in the size update
+    auto stepFactor = [&](SReal error)
+    {
+        if (error <= 0)
+            return maxFactor;
+        return std::clamp(safety * std::sqrt(tolerance / error), minFactor, maxFactor);
+    };
+
+    SReal h = (m_subStep > 0) ? std::min(m_subStep, dt) : dt;
+    SReal time = 0;
+    unsigned int nbAccepted = 0;
+    unsigned int nbRejected = 0;
+
+    sofa::helper::AdvancedTimer::stepBegin("AdaptiveTimeStep");
+    while (dt - time > minStep * 1e-3)
+    {
+        const SReal step = std::min(h, dt - time);
+
+        m_subStepPosition.eq(newPos);
+        m_subStepVelocity.eq(newVel);
+
+        // error estimation: the other scheme is computed first from the same state...
+        integrate(params, step, !trapezoidal, xResult, vResult, xResult, vResult);
+        m_errorVelocity.eq(newVel);
+
+        newPos.eq(m_subStepPosition);
+        newVel.eq(m_subStepVelocity);
+        mop.propagateXAndV(newPos, newVel);
+
+        // ... so that the result vectors hold the selected scheme at the end of an accepted sub-step
+        integrate(params, step, trapezoidal, xResult, vResult, xResult, vResult);
+        m_errorVelocity.peq(newVel, -1.0);
+        const SReal error = step * m_errorVelocity.norm(0);
+
+        if (error > tolerance && step > minStep)
+        {
+            ++nbRejected;
+            h = std::max(minStep, step * stepFactor(error));
+            newPos.eq(m_subStepPosition);
+            newVel.eq(m_subStepVelocity);
+            mop.propagateXAndV(newPos, newVel);
+            continue;
+        }
+
+        ++nbAccepted;
+        time += step;
+        // a sub-step shortened to reach the end of the time step does not constrain the next size
+        h = (step < h) ? std::max(h, step * stepFactor(error)) : step * stepFactor(error);
+        h = std::min(h, dt);
+
+        if (dt - time > minStep * 1e-3)
+        {
+            mop.projectPosition(newPos);
+            mop.projectVelocity(newVel);
+            mop.propagateXAndV(newPos, newVel);
+        }
+    }
+    sofa::helper::AdvancedTimer::stepEnd("AdaptiveTimeStep");
+
+    m_subStep = h;
+
+    msg_info() << "EulerImplicitSolver, adaptive time step: " << nbAccepted << " sub-steps accepted, "
+               << nbRejected << " rejected, next sub-step " << m_subStep;
+}
+
+void EulerImplicitSolver::integrate(const core::ExecParams* params, SReal h, bool optTrapezoidal,
+                                    sofa::core::MultiVecCoordId xStart, sofa::core::MultiVecDerivId vStart,
+                                    sofa::core::MultiVecCoordId xResult, sofa::core::MultiVecDerivId vResult)
 {
 #ifdef SOFA_DUMP_VISITOR_INFO
     sofa::simulation::Visitor::printNode("SolverVectorAllocation");
 #endif
     sofa::simulation::common::VectorOperations vop( params, this->getContext() );
     sofa::simulation::common::MechanicalOperations mop( params, this->getContext() );
-    MultiVecCoord pos(&vop, core::VecCoordId::position() );
-    MultiVecDeriv vel(&vop, core::VecDerivId::velocity() );
+    MultiVecCoord pos(&vop, xStart );
+    MultiVecDeriv vel(&vop, vStart );
     MultiVecDeriv f(&vop, core::VecDerivId::force() );
     MultiVecDeriv b(&vop);
     MultiVecCoord newPos(&vop, xResult );
     MultiVecDeriv newVel(&vop, vResult );
 
+    /// forces and matrices are evaluated at the start state of the step
+    mop->setX(xStart);
+    mop->setV(vStart);
+
     /// inform the constraint parameters about the position and velocity id
     mop.cparams.setX(xResult);
     mop.cparams.setV(vResult);
@@ -96,11 +210,9 @@ void EulerImplicitSolver::solve(const core::ExecParams* params, SReal dt, sofa::
 #endif
 
 
-    const SReal& h = dt;
     const bool firstOrder = f_firstOrder.getValue();
 
     // the only difference for the trapezoidal rule is the factor tr = 0.5 for some usages of h
-    const bool optTrapezoidal = d_trapezoidalScheme.getValue();
     SReal tr;
     if (optTrapezoidal)
         tr = 0.5;
@@ -271,7 +383,7 @@ void EulerImplicitSolver::solve(const core::ExecParams* params, SReal dt, sofa::
     }
 #endif
 
-    mop.addSeparateGravity(dt, newVel);	// v += dt*g . Used if mass wants to add G separately from the other forces to v
+    mop.addSeparateGravity(h, newVel);	// v += h*g . Used if mass wants to add G separately from the other forces to v
 
     if (f_velocityDamping.getValue()!=0.0)
         newVel *= exp(-h*f_velocityDamping.getValue());
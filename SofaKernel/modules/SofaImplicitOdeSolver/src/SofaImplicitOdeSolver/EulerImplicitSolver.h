@@ -92,6 +92,15 @@ namespace sofa::component::odesolver
  *
  *   \f$ ( M + h/2 K ) v_{t+h} = f_ext \f$
  *
+ *** Adaptive time stepping ***
+ *
+ * When adaptiveTimeStep is set, the time step dt is covered by a sequence of sub-steps.
+ * Each sub-step is computed with both the implicit Euler and the trapezoidal schemes from the same state,
+ * and the distance between the two new positions \f$ h |v^{E}_{t+h} - v^{T}_{t+h}| \f$ estimates the local error.
+ * A sub-step whose error exceeds adaptiveTolerance is rejected and retried with a smaller size, otherwise it is
+ * accepted (with the scheme selected by trapezoidalScheme) and the next sub-step size is adjusted accordingly.
+ * The last accepted sub-step size is kept from one time step to the next.
+ *
  */
 class SOFA_SOFAIMPLICITODESOLVER_API EulerImplicitSolver : public sofa::core::behavior::OdeSolver
 {
@@ -105,6 +114,9 @@ public:
     Data<bool> d_trapezoidalScheme; ///< Optional: use the trapezoidal scheme instead of the implicit Euler scheme and get second order accuracy in time
     Data<bool> f_solveConstraint; ///< Apply ConstraintSolver (requires a ConstraintSolver in the same node as this solver, disabled by by default for now)
     Data<bool> d_threadSafeVisitor;
+    Data<bool> d_adaptiveTimeStep; ///< Subdivide the time step according to an estimation of the local integration error
+    Data<SReal> d_adaptiveTolerance; ///< Maximum local position error accepted for a sub-step in adaptive mode
+    Data<SReal> d_minTimeStep; ///< Smallest sub-step used in adaptive mode (0 means dt/1000)
 
 protected:
     EulerImplicitSolver();
@@ -156,9 +168,25 @@ public:
 
 protected:
 
+    /// Advance the state (xStart, vStart) by one step of size h and store the result in (xResult, vResult)
+    void integrate(const core::ExecParams* params, SReal h, bool trapezoidal,
+                   core::MultiVecCoordId xStart, core::MultiVecDerivId vStart,
+                   core::MultiVecCoordId xResult, core::MultiVecDerivId vResult);
+
+    /// Cover the time step dt with sub-steps whose size is controlled by the local error estimation
+    void solveAdaptive(const core::ExecParams* params, SReal dt, core::MultiVecCoordId xResult, core::MultiVecDerivId vResult);
+
     /// the solution vector is stored for warm-start
     core::behavior::MultiVecDeriv x;
 
+    /// @name Adaptive time stepping
+    /// @{
+    core::behavior::MultiVecCoord m_subStepPosition; ///< position at the beginning of the current sub-step
+    core::behavior::MultiVecDeriv m_subStepVelocity; ///< velocity at the beginning of the current sub-step
+    core::behavior::MultiVecDeriv m_errorVelocity;   ///< velocity given by the error estimation scheme
+    SReal m_subStep { 0 };                           ///< sub-step size proposed for the next time step
+    /// @}
+
 };
 
 } // namespace sofa::component::odesolver
@@ -26,11 +26,13 @@
 #include <sofa/simulation/MechanicalOperations.h>
 #include <sofa/simulation/VectorOperations.h>
 #include <sofa/core/behavior/MultiMatrix.h>
+#include <sofa/core/behavior/LinearSolver.h>
 #include <sofa/simulation/Node.h>
 #include <sofa/simulation/mechanicalvisitor/MechanicalPropagateOnlyPositionAndVelocityVisitor.h>
 
 #include <iomanip>
 #include <chrono>
+#include <list>
 #include <memory>
 
 using sofa::simulation::mechanicalvisitor::MechanicalPropagateOnlyPositionAndVelocityVisitor;
@@ -69,7 +71,32 @@ StaticSolver::StaticSolver()
             false,
             "should_diverge_when_residual_is_growing",
             "Divergence criterion: The newton iterations will stop when the residual is greater than the one from the previous iteration."))
-{}
+    , d_jacobian_update( initData(&d_jacobian_update,
+            "jacobian_update",
+            "How the system matrix is updated between the Newton iterations of a load increment. "
+            "full: assembled at every iteration (Newton-Raphson). "
+            "chord: the matrix of the first iteration is reused (modified Newton). "
+            "bfgs: the reused matrix is corrected by the BFGS updates of the previous iterations. "
+            "chord and bfgs need a direct linear solver, which assembles and factorizes the matrix; "
+            "with an iterative solver on non-assembled matrices (e.g. CGLinearSolver), full is used."))
+    , d_jacobian_refresh_ratio( initData(&d_jacobian_refresh_ratio,
+            (double) 0.5,
+            "jacobian_refresh_ratio",
+            "With chord or bfgs updates, the system matrix is assembled again at the next iteration when the ratio "
+            "|R|/|R_previous| is greater than this threshold."))
+    , d_line_search( initData(&d_line_search,
+            false,
+            "line_search",
+            "Scale the increments by a backtracking line search until the residual norm decreases sufficiently."))
+    , d_line_search_iterations( initData(&d_line_search_iterations,
+            (unsigned) 10,
+            "line_search_iterations",
+            "Maximum number of step length reductions (halving) of the line search."))
+{
+    sofa::helper::OptionsGroup jacobian_update(3, "full", "chord", "bfgs");
+    jacobian_update.setSelectedItem(0);
+    d_jacobian_update.setValue(jacobian_update);
+}
 
 void StaticSolver::parse(sofa::core::objectmodel::BaseObjectDescription* arg)
 {
@@ -155,6 +182,15 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
     U.clear();
     dx.clear();
 
+    // Strategy used to update the system matrix between Newton iterations
+    enum JacobianUpdate : unsigned { FULL = 0, CHORD = 1, BFGS = 2 };
+    auto jacobian_update = static_cast<JacobianUpdate>(d_jacobian_update.getValue().getSelectedId());
+    if (jacobian_update == BFGS)
+    {
+        p_bfgs_rhs.realloc( &vop );
+        p_previous_force.realloc( &vop );
+    }
+
     // Set the multi-vector identifier inside the mechanical parameters.
     sofa::core::MechanicalParams mechanical_parameters (*params);
     mechanical_parameters.setX(xResult);
@@ -175,6 +211,9 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
     const auto & absolute_residual_tolerance_threshold = d_absolute_residual_tolerance_threshold.getValue();
     const auto & max_number_of_newton_iterations = d_newton_iterations.getValue();
     const auto & should_diverge_when_residual_is_growing = d_should_diverge_when_residual_is_growing.getValue();
+    const auto & jacobian_refresh_ratio = d_jacobian_refresh_ratio.getValue();
+    const auto & line_search = d_line_search.getValue();
+    const auto & max_number_of_line_search_iterations = d_line_search_iterations.getValue();
     const auto & print_log = f_printLog.getValue();
     auto info = MessageDispatcher::info(Message::Runtime, std::make_shared<ComponentInfo>(this->getClassName()), SOFA_FILE_INFO);
 
@@ -185,9 +224,18 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
     const auto relative_squared_residual_tolerance_threshold = relative_residual_tolerance_threshold*relative_residual_tolerance_threshold;
     const auto absolute_squared_correction_threshold = absolute_correction_tolerance_threshold*absolute_correction_tolerance_threshold;
     const auto relative_squared_correction_threshold = relative_correction_tolerance_threshold*relative_correction_tolerance_threshold;
+    double R_start_squared_norm = 0;
     bool converged = false, diverged = false;
     steady_clock::time_point t;
 
+    // The system matrix is always assembled at the first iteration of a load increment
+    bool must_update_jacobian = true;
+    p_number_of_jacobian_updates = 0;
+
+    // BFGS pairs (s_i, y_i, 1/(y_i.s_i)) gathered since the last assembly of the system matrix
+    std::list<MultiVecDeriv> bfgs_s, bfgs_y;
+    std::vector<SReal> bfgs_rho;
+
     // Reset the list of residual norms for this time step
     p_squared_residual_norms.clear();
     p_squared_residual_norms.reserve(max_number_of_newton_iterations);
@@ -206,6 +254,8 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
         info << "Residual tolerance (rel)   : " << relative_residual_tolerance_threshold << "\n";
         info << "Correction tolerance (abs) : " << absolute_correction_tolerance_threshold << "\n";
         info << "Correction tolerance (rel) : " << relative_correction_tolerance_threshold << "\n";
+        info << "Jacobian update            : " << d_jacobian_update.getValue().getSelectedItem() << "\n";
+        info << "Line search                : " << (line_search ? "yes" : "no") << "\n";
     }
 
     // Start the advanced timer
@@ -257,8 +307,18 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
         ScopedAdvancedTimer step_timer ("NewtonStep");
         t = steady_clock::now();
 
+        // Residual at the beginning of the iteration
+        R_start_squared_norm = R_squared_norm;
+        if (jacobian_update == BFGS)
+        {
+            p_previous_force.eq(force);
+        }
+
         // Part I. Assemble the system matrix.
+        // With chord or bfgs updates, the previous matrix (and its factorization for direct linear solvers) is
+        // kept by the linear solver as long as setSystemMBKMatrix is not called.
         MultiMatrix<MechanicalOperations> matrix(&mop);
+        if (jacobian_update == FULL || must_update_jacobian)
         {
             ScopedAdvancedTimer _t_("MBKBuild");
             // 1. The MechanicalMatrix::K is a simple structure that stores three floats called factors: m, b and k.
@@ -273,6 +333,28 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
             //       FixedConstraint. In this case, it will set to 0 every column (_, i) and row (i, _) of the assembled
             //       matrix for the ith degree of freedom.
             matrix = MechanicalMatrix::K * -1.0;
+
+            // Chord and bfgs updates reuse the matrix kept by the linear solver, which does not exist for
+            // linear solvers working on non-assembled matrices (case A above)
+            if (jacobian_update != FULL)
+            {
+                auto * linear_solver = context->get<sofa::core::behavior::LinearSolver>(context->getTags(), sofa::core::objectmodel::BaseContext::SearchDown);
+                if (! linear_solver || ! linear_solver->getSystemBaseMatrix())
+                {
+                    msg_warning() << "jacobian_update=\"" << d_jacobian_update.getValue().getSelectedItem() << "\" requires a "
+                                  << "linear solver assembling and factorizing the system matrix (a direct solver). "
+                                  << "Falling back to jacobian_update=\"full\".";
+                    sofa::helper::WriteAccessor<Data<sofa::helper::OptionsGroup>> jacobian_update_option = d_jacobian_update;
+                    jacobian_update_option->setSelectedItem(FULL);
+                    jacobian_update = FULL;
+                }
+            }
+
+            ++p_number_of_jacobian_updates;
+            must_update_jacobian = false;
+            bfgs_s.clear();
+            bfgs_y.clear();
+            bfgs_rho.clear();
         }
 
         // Part II. Solve the unknown increment.
@@ -281,7 +363,34 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
             // Calls methods "setSystemRHVector", "setSystemLHVector" and "solveSystem" of the LinearSolver component
             // for CG: calls iteratively addDForce, mapped:  [applyJ, addDForce, applyJt(vec)]+
             // for Direct: solves the system, everything's already assembled
-            matrix.solve(dx, force);
+            if (bfgs_rho.empty())
+            {
+                matrix.solve(dx, force);
+            }
+            else
+            {
+                // L-BFGS two-loop recursion where the last assembled matrix is the initial inverse approximation
+                std::vector<SReal> bfgs_alpha(bfgs_rho.size());
+                p_bfgs_rhs.eq(force);
+
+                auto s_it = bfgs_s.rbegin();
+                auto y_it = bfgs_y.rbegin();
+                for (std::size_t i = bfgs_rho.size(); i-- > 0; ++s_it, ++y_it)
+                {
+                    bfgs_alpha[i] = bfgs_rho[i] * s_it->dot(p_bfgs_rhs);
+                    p_bfgs_rhs.peq(*y_it, -bfgs_alpha[i]);
+                }
+
+                matrix.solve(dx, p_bfgs_rhs);
+
+                auto s_fwd = bfgs_s.begin();
+                auto y_fwd = bfgs_y.begin();
+                for (std::size_t i = 0; i < bfgs_rho.size(); ++i, ++s_fwd, ++y_fwd)
+                {
+                    const SReal beta = bfgs_rho[i] * y_fwd->dot(dx);
+                    dx.peq(*s_fwd, bfgs_alpha[i] - beta);
+                }
+            }
         }
 
         // Part III. Propagate the solution increment and update geometry.
@@ -299,6 +408,51 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
             MechanicalPropagateOnlyPositionAndVelocityVisitor(&mechanical_parameters).execute(context);
         }
 
+        // Part III bis. Backtracking line search on the residual norm.
+        // The step length is halved until the Armijo condition |R(x + a.dx)|^2 <= (1 - 2ca) |R(x)|^2 is met.
+        bool force_is_updated = false;
+        if (line_search)
+        {
+            ScopedAdvancedTimer _t_("LineSearch");
+            static constexpr double sufficient_decrease = 1e-4;
+
+            mop.computeForce(force);
+            mop.projectResponse(force);
+            R_squared_norm = force.dot(force);
+
+            double step_length = 1;
+            unsigned n_ls = 0;
+            while (R_squared_norm > (1 - 2 * sufficient_decrease * step_length) * R_start_squared_norm
+                   && n_ls < max_number_of_line_search_iterations)
+            {
+                step_length *= 0.5;
+                x.peq(dx, -step_length); // x := x_start + step_length * dx
+                mop.solveConstraint(x, sofa::core::ConstraintParams::POS);
+                MechanicalPropagateOnlyPositionAndVelocityVisitor(&mechanical_parameters).execute(context);
+
+                mop.computeForce(force);
+                mop.projectResponse(force);
+                R_squared_norm = force.dot(force);
+                ++n_ls;
+            }
+
+            if (step_length < 1)
+            {
+                dx.teq(step_length);
+
+                // A reused matrix which does not provide a descent direction has to be assembled again
+                if (R_squared_norm > R_start_squared_norm)
+                    must_update_jacobian = true;
+            }
+
+            if (print_log && n_ls > 0)
+            {
+                info << "Line search: step length reduced to " << step_length << " after " << n_ls << " iterations.\n";
+            }
+
+            force_is_updated = true;
+        }
+
         // At this point, we completed one iteration, increment the counter.
         // The rest is only for convergence tests and logging.
         n_it++;
@@ -313,7 +467,8 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
             break;
         }
 
-        // Part IV. Update the force vector.
+        // Part IV. Update the force vector (already done by the line search).
+        if (! force_is_updated)
         {
             ScopedAdvancedTimer _t_("UpdateForce");
 
@@ -344,6 +499,37 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
             p_squared_increment_norms.emplace_back(dx_squared_norm);
         }
 
+        // Part V bis. Matrix update strategy for the next iteration.
+        if (jacobian_update != FULL)
+        {
+            // A slow convergence rate means that the reused matrix is too far from the current tangent
+            if (R_squared_norm > jacobian_refresh_ratio*jacobian_refresh_ratio*R_start_squared_norm)
+            {
+                must_update_jacobian = true;
+            }
+            else if (jacobian_update == BFGS)
+            {
+                // s = x_{i+1} - x_i and y = F(x_{i+1}) - F(x_i), where the residual F is the opposite of the force
+                bfgs_s.emplace_back(&vop);
+                bfgs_y.emplace_back(&vop);
+                bfgs_s.back().eq(dx);
+                bfgs_y.back().eq(p_previous_force);
+                bfgs_y.back().peq(force, -1.0);
+
+                const SReal sy = bfgs_s.back().dot(bfgs_y.back());
+                if (sy > epsilon * std::sqrt(dx_squared_norm * bfgs_y.back().dot(bfgs_y.back())))
+                {
+                    bfgs_rho.emplace_back(1. / sy);
+                }
+                else
+                {
+                    // The curvature condition is not met, the pair would break the positive definiteness
+                    bfgs_s.pop_back();
+                    bfgs_y.pop_back();
+                }
+            }
+        }
+
         // Part VI. Stop timers and print step information.
         {
             auto iteration_time = duration_cast<nanoseconds>(steady_clock::now() - t).count();
@@ -455,6 +641,7 @@ void StaticSolver::solve(const sofa::core::ExecParams* params, double dt, sofa::
     sofa::helper::AdvancedTimer::valSet("nb_iterations", n_it+1);
     sofa::helper::AdvancedTimer::valSet("residual", std::sqrt(R_squared_norm));
     sofa::helper::AdvancedTimer::valSet("correction", std::sqrt(dx_squared_norm));
+    sofa::helper::AdvancedTimer::valSet("jacobian_updates", p_number_of_jacobian_updates);
 }
 
 
@@ -24,6 +24,7 @@
 
 #include <sofa/core/behavior/OdeSolver.h>
 #include <sofa/core/behavior/MultiVec.h>
+#include <sofa/helper/OptionsGroup.h>
 
 namespace sofa::component::odesolver
 {
@@ -55,6 +56,17 @@ using sofa::core::objectmodel::Data;
  *     \mat{K}(\vec{x}_{n+1}^i) \left [ \Delta \vec{x}_{n+1}^{i+1} \right ] &= - \vec{F}(\vec{x}_{n+1}^i) \\
  *     \vec{x}_{n+1}^{i+1} &= \vec{x}_{n+1}^{i} + \Delta \vec{x}_{n+1}^{i+1}
  * \f}
+ *
+ * By default, the tangent stiffness matrix \f$\mat{K}\f$ is assembled (and factorized by direct linear solvers) at
+ * every Newton iteration. With jacobian_update="chord", the matrix of the first iteration of the load increment is
+ * reused for the following iterations (modified Newton). With jacobian_update="bfgs", the reused matrix is further
+ * corrected with the BFGS updates of the previous iterations. In both cases, the matrix is reassembled as soon as the
+ * ratio \f$|\vec{F}^{i+1}| / |\vec{F}^{i}|\f$ exceeds jacobian_refresh_ratio. These two modes need a direct linear
+ * solver which keeps the assembled and factorized matrix; with a linear solver working on non-assembled matrices
+ * (e.g. CGLinearSolver), the solver falls back to jacobian_update="full".
+ *
+ * When line_search is enabled, the increment \f$\Delta \vec{x}_{n+1}^{i+1}\f$ is scaled by a step length
+ * \f$\alpha\f$ which is halved until the residual norm decreases sufficiently (Armijo backtracking).
  */
 class SOFA_SOFAIMPLICITODESOLVER_API StaticSolver : public sofa::core::behavior::OdeSolver
 {
@@ -71,6 +83,9 @@ public:
     /** The list of squared correction increment norms (dx.dot(dx) = ||dx||^2) of every newton iterations of the last solve call. */
     auto squared_increment_norms() const -> const std::vector<SReal> & { return p_squared_increment_norms; }
 
+    /** The number of times the system matrix was assembled during the last solve call. */
+    auto number_of_jacobian_updates() const -> unsigned { return p_number_of_jacobian_updates; }
+
     /// Given a displacement as computed by the linear system inversion, how much will it affect the velocity
     ///
     /// This method is used to compute the compliance for contact corrections
@@ -154,16 +169,29 @@ protected:
     Data<double> d_absolute_residual_tolerance_threshold; ///< Convergence criterion: The newton iterations will stop when the norm of the residual |R| is smaller than this threshold. Use a negative value to disable this criterion.
     Data<double> d_relative_residual_tolerance_threshold; ///< Convergence criterion: The newton iterations will stop when the ratio |R|/|R0| is smaller than this threshold. Use a negative value to disable this criterion.
     Data<bool> d_should_diverge_when_residual_is_growing; ///< Divergence criterion: The newton iterations will stop when the residual is greater than the one from the previous iteration.
+    Data<sofa::helper::OptionsGroup> d_jacobian_update; ///< How the system matrix is updated between the Newton iterations of a load increment (full, chord or bfgs). chord and bfgs need a direct (factorizing) linear solver.
+    Data<double> d_jacobian_refresh_ratio; ///< With chord or bfgs updates, the system matrix is reassembled when the ratio |R|/|R_previous| is greater than this threshold.
+    Data<bool> d_line_search; ///< Scale the increments by a backtracking line search on the residual norm.
+    Data<unsigned> d_line_search_iterations; ///< Maximum number of step length reductions of the line search.
 
 private:
     /// Sum of displacement increments since the beginning of the time step
     sofa::core::behavior::MultiVecDeriv U;
 
+    /// Right-hand side of the BFGS two-loop recursion
+    sofa::core::behavior::MultiVecDeriv p_bfgs_rhs;
+
+    /// Force vector at the beginning of the current newton iteration (BFGS updates only)
+    sofa::core::behavior::MultiVecDeriv p_previous_force;
+
     /// List of squared residual norms (r.dot(R) = ||r||^2) of every newton iterations of the last solve call.
     std::vector<SReal> p_squared_residual_norms;
 
     /// List of squared correction increment norms (dx.dot(dx) = ||dx||^2) of every newton iterations of the last solve call.
     std::vector<SReal> p_squared_increment_norms;
+
+    /// Number of system matrix assemblies of the last solve call.
+    unsigned p_number_of_jacobian_updates = 0;
 };
 
 } // namespace sofa::component::odesolver
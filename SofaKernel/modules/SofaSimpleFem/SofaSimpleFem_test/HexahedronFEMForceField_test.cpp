@@ -21,6 +21,7 @@
 ******************************************************************************/
 
 #include <SofaSimpleFem/HexahedronFEMForceField.h>
+#include <SofaBaseTopology/RegularGridTopology.h>
 
 #include "ForceFieldTestCreation.h"
 
@@ -151,4 +152,102 @@ TYPED_TEST( HexahedronFEMForceField_test, test_computeBBox )
     ASSERT_NO_THROW(this->test_computeBBox()) ;
 }
 
+/**  Check that sharing the element stiffness on a regular grid gives the same forces and
+  *  force derivatives as the per-element stiffness matrices
+  */
+struct HexahedronFEMForceFieldSharedStiffness_test : public sofa::testing::BaseSimulationTest
+{
+    typedef defaulttype::Vec3Types DataTypes;
+    typedef DataTypes::VecCoord VecCoord;
+    typedef DataTypes::VecDeriv VecDeriv;
+    typedef DataTypes::Coord Coord;
+    typedef DataTypes::Deriv Deriv;
+    typedef component::forcefield::HexahedronFEMForceField<DataTypes> ForceField;
+    typedef component::container::MechanicalObject<DataTypes> DOF;
+
+    /// compute the force and its derivative on a deformed grid, and return whether per-element stiffness matrices are stored
+    bool computeForces(const std::string& method, bool shareElementStiffness, VecDeriv& f, VecDeriv& df)
+    {
+        simulation::Node::SPtr root = simulation::getSimulation()->createNewGraph("root");
+        component::topology::RegularGridTopology::SPtr grid = core::objectmodel::New<component::topology::RegularGridTopology>(5, 4, 6);
+        grid->setPos(0, 4, 0, 3, 0, 5);
+        root->addObject(grid);
+        DOF::SPtr dofs = core::objectmodel::New<DOF>();
+        root->addObject(dofs);
+        ForceField::SPtr ff = core::objectmodel::New<ForceField>();
+        ff->f_method.setValue(method);
+        ff->setYoungModulus(1000);
+        ff->setPoissonRatio(0.3);
+        ff->d_shareElementStiffness.setValue(shareElementStiffness);
+        root->addObject(ff);
+        simulation::getSimulation()->init(root.get());
+
+        const std::size_t n = dofs->getSize();
+        Data<VecCoord>& x = *dofs->write(core::VecCoordId::position());
+        {
+            helper::WriteAccessor< Data<VecCoord> > wx = x;
+            for (std::size_t i=0; i<n; ++i)
+                wx[i] += Coord(0.1*std::sin(i), 0.05*std::cos(3.0*i), 0.02*(i%7)) + Coord(0, 0, 0.01*wx[i][0]*wx[i][1]);
+        }
+        Data<VecDeriv> v; v.setValue(VecDeriv(n, Deriv()));
+        Data<VecDeriv> dfData; dfData.setValue(VecDeriv(n, Deriv()));
+        Data<VecDeriv> fData; fData.setValue(VecDeriv(n, Deriv()));
+        Data<VecDeriv> dx;
+        {
+            helper::WriteAccessor< Data<VecDeriv> > wdx = dx;
+            wdx.resize(n);
+            for (std::size_t i=0; i<n; ++i)
+                wdx[i] = Deriv(std::cos(2.0*i), std::sin(5.0*i), 0.3);
+        }
+
+        core::MechanicalParams mparams;
+        mparams.setKFactor(1.0);
+        ff->addForce(&mparams, fData, x, v);
+        ff->addDForce(&mparams, dfData, dx);
+        f = fData.getValue();
+        df = dfData.getValue();
+
+        const bool hasStiffnessMatrices = !ff->findData("stiffnessMatrices")->getValueString().empty();
+        simulation::getSimulation()->unload(root);
+        return hasStiffnessMatrices;
+    }
+
+    void checkMethod(const std::string& method)
+    {
+        VecDeriv f0, df0, f1, df1;
+        EXPECT_TRUE(computeForces(method, false, f0, df0));
+        EXPECT_FALSE(computeForces(method, true, f1, df1));
+
+        ASSERT_EQ(f0.size(), f1.size());
+        SReal maxF = 0, maxDF = 0;
+        for (std::size_t i=0; i<f0.size(); ++i)
+        {
+            maxF = std::max(maxF, f0[i].norm());
+            maxDF = std::max(maxDF, df0[i].norm());
+        }
+        ASSERT_GT(maxF, 0);
+        ASSERT_GT(maxDF, 0);
+        for (std::size_t i=0; i<f0.size(); ++i)
+        {
+            EXPECT_LT((f0[i]-f1[i]).norm(), 1e-10*maxF) << method << " force " << i;
+            EXPECT_LT((df0[i]-df1[i]).norm(), 1e-10*maxDF) << method << " dforce " << i;
+        }
+    }
+};
+
+TEST_F( HexahedronFEMForceFieldSharedStiffness_test, large )
+{
+    this->checkMethod("large");
+}
+
+TEST_F( HexahedronFEMForceFieldSharedStiffness_test, polar )
+{
+    this->checkMethod("polar");
+}
+
+TEST_F( HexahedronFEMForceFieldSharedStiffness_test, small )
+{
+    this->checkMethod("small");
+}
+
 } // namespace sofa
@@ -118,6 +118,7 @@ public:
     Data<Real> f_youngModulus;
     Data<bool> f_updateStiffnessMatrix;
     Data<bool> f_assembling;
+    Data<bool> d_shareElementStiffness; ///< Store a single reference stiffness matrix when all the elements are translated copies of each other
     Data< sofa::helper::OptionsGroup > _gatherPt; ///< use in GPU version
     Data< sofa::helper::OptionsGroup > _gatherBsize; ///< use in GPU version
     Data<bool> f_drawing; ///<  draw the forcefield if true
@@ -203,6 +204,14 @@ protected:
 
     void computeForce( Displacement &F, const Displacement &Depl, const ElementStiffness &K );
 
+    ////////////// shared element stiffness (regular and sparse grids)
+    bool m_useSharedStiffness;                      ///< true if m_sharedStiffness replaces _elementStiffnesses
+    ElementStiffness m_sharedStiffness;             ///< stiffness of any element, computed with a stiffness coefficient of 1
+    helper::vector<Real> m_elementStiffnessFactors; ///< per element scaling of m_sharedStiffness (sparse grid stiffness coefficients)
+    bool canShareElementStiffness();
+    void computeElementForce( Displacement &F, const Displacement &Depl, sofa::Index i );
+    void addDForceSharedStiffness( WDataRefVecDeriv &df, RDataRefVecCoord &dx, Real kFactor );
+
 
     ////////////// large displacements method
     helper::vector<helper::fixed_array<Coord,8> > _rotatedInitialElements;   ///< The initials positions in its frame
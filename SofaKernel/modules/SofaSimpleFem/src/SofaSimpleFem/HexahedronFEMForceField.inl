@@ -52,6 +52,7 @@ HexahedronFEMForceField<DataTypes>::HexahedronFEMForceField()
     , f_youngModulus(initData(&f_youngModulus,(Real)5000,"youngModulus",""))
     , f_updateStiffnessMatrix(initData(&f_updateStiffnessMatrix,false,"updateStiffnessMatrix",""))
     , f_assembling(initData(&f_assembling,false,"assembling",""))
+    , d_shareElementStiffness(initData(&d_shareElementStiffness,false,"shareElementStiffness","Store a single reference stiffness matrix, scaled per element, when all the elements are translated copies of each other (regular and sparse grids). stiffnessMatrices is then left empty"))
     , _gatherPt(initData(&_gatherPt,"gatherPt","number of dof accumulated per threads during the gather operation (Only use in GPU version)"))
     , _gatherBsize(initData(&_gatherBsize,"gatherBsize","number of dof accumulated per threads during the gather operation (Only use in GPU version)"))
     , f_drawing(initData(&f_drawing,true,"drawing"," draw the forcefield if true"))
@@ -63,6 +64,7 @@ HexahedronFEMForceField<DataTypes>::HexahedronFEMForceField()
     , _sparseGrid(nullptr)
     , _initialPoints(initData(&_initialPoints,"initialPoints", "Initial Position"))
     , data(new HexahedronFEMForceFieldInternalData<DataTypes>())
+    , m_useSharedStiffness(false)
 {
     data->initPtrData(this);
     _coef[0][0]=-1;
@@ -155,6 +157,18 @@ void HexahedronFEMForceField<DataTypes>::reinit()
     else if (f_method.getValue() == "small")
         this->setMethod(SMALL);
 
+    m_useSharedStiffness = canShareElementStiffness();
+    if (m_useSharedStiffness)
+    {
+        VecElementStiffness().swap(*_elementStiffnesses.beginEdit());
+        _elementStiffnesses.endEdit();
+        m_elementStiffnessFactors.resize( this->getIndexedElements()->size() );
+    }
+    else
+    {
+        m_elementStiffnessFactors.clear();
+    }
+
     switch(method)
     {
     case LARGE :
@@ -191,6 +205,40 @@ void HexahedronFEMForceField<DataTypes>::reinit()
         break;
     }
     }
+
+    if (m_useSharedStiffness)
+        computeElementStiffness( m_sharedStiffness, _materialsStiffnesses[0], _rotatedInitialElements[0], 0, 1.0 );
+}
+
+template <class DataTypes>
+bool HexahedronFEMForceField<DataTypes>::canShareElementStiffness()
+{
+    if (!d_shareElementStiffness.getValue() || f_updateStiffnessMatrix.getValue())
+        return false;
+
+    const VecElement& elements = *this->getIndexedElements();
+    const VecCoord& p = _initialPoints.getValue();
+    if (elements.empty())
+        return false;
+
+    // the rotations and the stiffness only depend on the edges of the rest element:
+    // they are the same for all the elements if these are translated copies of the first one
+    const Element& first = elements[0];
+    const Real tolerance = (p[first[6]]-p[first[0]]).norm() * (Real)1e-6;
+    for (const Element& elem : elements)
+    {
+        for (int w=1; w<8; ++w)
+        {
+            const Coord edge = p[elem[w]]-p[elem[0]];
+            const Coord firstEdge = p[first[w]]-p[first[0]];
+            if ((edge-firstEdge).norm() > tolerance)
+            {
+                msg_info() << "The elements do not have the same rest shape: the stiffness matrices are not shared.";
+                return false;
+            }
+        }
+    }
+    return true;
 }
 
 
@@ -210,7 +258,7 @@ void HexahedronFEMForceField<DataTypes>::addForce (const core::MechanicalParams*
 
     _f.resize(_p.size());
 
-    if (needUpdateTopology)
+    if (needUpdateTopology || (m_useSharedStiffness && f_updateStiffnessMatrix.getValue()))
     {
         reinit();
         needUpdateTopology = false;
@@ -264,6 +312,12 @@ void HexahedronFEMForceField<DataTypes>::addDForce (const core::MechanicalParams
     if (_df.size() != _dx.size())
         _df.resize(_dx.size());
 
+    if (m_useSharedStiffness)
+    {
+        addDForceSharedStiffness( _df, _dx, kFactor );
+        return;
+    }
+
     unsigned int i = 0;
     typename VecElement::const_iterator it;
 
@@ -294,6 +348,60 @@ void HexahedronFEMForceField<DataTypes>::addDForce (const core::MechanicalParams
     }
 }
 
+template<class DataTypes>
+void HexahedronFEMForceField<DataTypes>::addDForceSharedStiffness( WDataRefVecDeriv &df, RDataRefVecCoord &dx, Real kFactor )
+{
+    // the elements are processed by blocks, the rotated displacements of a block being stored column-wise:
+    // the product with the shared stiffness then vectorizes across the elements of the block
+    constexpr std::size_t blockSize = 8;
+    const VecElement& elements = *this->getIndexedElements();
+    const std::size_t nbElements = elements.size();
+
+    Real X[24][blockSize];
+    Real F[24][blockSize];
+    for (std::size_t begin=0; begin<nbElements; begin+=blockSize)
+    {
+        const std::size_t nb = std::min(blockSize, nbElements-begin);
+        for (std::size_t b=0; b<nb; ++b)
+        {
+            const Element& elem = elements[begin+b];
+            for(int w=0; w<8; ++w)
+            {
+                const Coord x_2 = _rotations[begin+b] * dx[elem[w]];
+                X[w*3][b] = x_2[0];
+                X[w*3+1][b] = x_2[1];
+                X[w*3+2][b] = x_2[2];
+            }
+        }
+        for (std::size_t b=nb; b<blockSize; ++b)
+            for (int r=0; r<24; ++r)
+                X[r][b] = 0;
+
+        for (int r=0; r<24; ++r)
+        {
+            Real acc[blockSize] = {};
+            for (int c=0; c<24; ++c)
+            {
+                const Real k = m_sharedStiffness[r][c];
+                for (std::size_t b=0; b<blockSize; ++b)
+                    acc[b] += k * X[c][b];
+            }
+            for (std::size_t b=0; b<blockSize; ++b)
+                F[r][b] = acc[b];
+        }
+
+        for (std::size_t b=0; b<nb; ++b)
+        {
+            const Element& elem = elements[begin+b];
+            const Real factor = m_elementStiffnessFactors[begin+b] * kFactor;
+            for(int w=0; w<8; ++w)
+            {
+                df[elem[w]] -= _rotations[begin+b].multTranspose(Deriv(F[w*3][b], F[w*3+1][b], F[w*3+2][b])) * factor;
+            }
+        }
+    }
+}
+
 template <class DataTypes>
 const typename HexahedronFEMForceField<DataTypes>::Transformation& HexahedronFEMForceField<DataTypes>::getElementRotation(const sofa::Index elemidx)
 {
@@ -718,6 +826,20 @@ void HexahedronFEMForceField<DataTypes>::computeForce( Displacement &F, const Di
     F = K*Depl;
 }
 
+template<class DataTypes>
+void HexahedronFEMForceField<DataTypes>::computeElementForce( Displacement &F, const Displacement &Depl, sofa::Index i )
+{
+    if (m_useSharedStiffness)
+    {
+        computeForce( F, Depl, m_sharedStiffness );
+        F *= m_elementStiffnessFactors[i];
+    }
+    else
+    {
+        computeForce( F, Depl, _elementStiffnesses.getValue()[i] );
+    }
+}
+
 
 /////////////////////////////////////////////////
 /////////////////////////////////////////////////
@@ -734,6 +856,12 @@ void HexahedronFEMForceField<DataTypes>::initSmall(int i, const Element &elem)
     for(int w=0; w<8; ++w)
         _rotatedInitialElements[i][w] =  _rotations[i]*_initialPoints.getValue()[elem[w]];
 
+    if (m_useSharedStiffness)
+    {
+        m_elementStiffnessFactors[i] = (Real)(_sparseGrid?_sparseGrid->getStiffnessCoef(i):1.0);
+        return;
+    }
+
     if( _elementStiffnesses.getValue().size() <= (unsigned)i )
     {
         _elementStiffnesses.beginEdit()->resize( _elementStiffnesses.getValue().size()+1 );
@@ -767,7 +895,7 @@ void HexahedronFEMForceField<DataTypes>::accumulateForceSmall ( WDataRefVecDeriv
         computeElementStiffness( (*_elementStiffnesses.beginEdit())[i], _materialsStiffnesses[i], deformed, i, _sparseGrid?_sparseGrid->getStiffnessCoef(i):1.0 );
 
     Displacement F; //forces
-    computeForce( F, D, _elementStiffnesses.getValue()[i] ); // compute force on element
+    computeElementForce( F, D, i ); // compute force on element
 
     for(int w=0; w<8; ++w)
         f[elem[w]] += Deriv( F[w*3],  F[w*3+1],   F[w*3+2]  ) ;
@@ -806,6 +934,12 @@ void HexahedronFEMForceField<DataTypes>::initLarge(int i, const Element &elem)
     for(int w=0; w<8; ++w)
         _rotatedInitialElements[i][w] =  _rotations[i]*_initialPoints.getValue()[elem[w]];
 
+    if (m_useSharedStiffness)
+    {
+        m_elementStiffnessFactors[i] = (Real)(_sparseGrid?_sparseGrid->getStiffnessCoef(i):1.0);
+        return;
+    }
+
     if( _elementStiffnesses.getValue().size() <= (unsigned)i )
     {
         _elementStiffnesses.beginEdit()->resize( _elementStiffnesses.getValue().size()+1 );
@@ -872,7 +1006,7 @@ void HexahedronFEMForceField<DataTypes>::accumulateForceLarge( WDataRefVecDeriv
         computeElementStiffness( (*_elementStiffnesses.beginEdit())[i], _materialsStiffnesses[i], deformed, i, _sparseGrid?_sparseGrid->getStiffnessCoef(i):1.0 );
 
     Displacement F; //forces
-    computeForce( F, D, _elementStiffnesses.getValue()[i] ); // compute force on element
+    computeElementForce( F, D, i ); // compute force on element
 
     for(int w=0; w<8; ++w)
         f[elem[w]] += _rotations[i].multTranspose( Deriv( F[w*3],  F[w*3+1],   F[w*3+2]  ) );
@@ -908,6 +1042,12 @@ void HexahedronFEMForceField<DataTypes>::initPolar(int i, const Element& elem)
         _rotatedInitialElements[i][j] =  _rotations[i] * nodes[j];
     }
 
+    if (m_useSharedStiffness)
+    {
+        m_elementStiffnessFactors[i] = (Real)(_sparseGrid?_sparseGrid->getStiffnessCoef(i):1.0);
+        return;
+    }
+
     if( _elementStiffnesses.getValue().size() <= (unsigned)i )
     {
         _elementStiffnesses.beginEdit()->resize( _elementStiffnesses.getValue().size()+1 );
@@ -1069,7 +1209,7 @@ void HexahedronFEMForceField<DataTypes>::accumulateForcePolar( WDataRefVecDeriv
 
 
     // compute force on element
-    computeForce( F, D, _elementStiffnesses.getValue()[i] );
+    computeElementForce( F, D, i );
 
 
     for(int j=0; j<8; ++j)
@@ -1126,9 +1266,12 @@ void HexahedronFEMForceField<DataTypes>::addKToMatrix(const core::MechanicalPara
 
     sofa::core::behavior::MultiMatrixAccessor::MatrixRef r = matrix->getMatrix(this->mstate);
 
+    ElementStiffness sharedKe;
     for(it = this->getIndexedElements()->begin(), e=0 ; it != this->getIndexedElements()->end() ; ++it,++e)
     {
-        const ElementStiffness &Ke = _elementStiffnesses.getValue()[e];
+        if (m_useSharedStiffness)
+            sharedKe = m_sharedStiffness * m_elementStiffnessFactors[e];
+        const ElementStiffness &Ke = m_useSharedStiffness ? sharedKe : _elementStiffnesses.getValue()[e];
 
         Transformation Rot = getElementRotation(e);
 
@@ -238,6 +238,9 @@ public:
     Transformation getActualTetraRotation(Index index);
     Transformation getInitialTetraRotation(Index index);
 
+    /// Tetrahedra of the force field (the tetrahedra of the topology, or its hexahedra split in 6)
+    const VecElement& getIndexedElements() const { return *_indexedElements; }
+
     void setMethod(std::string methodName);
     void setMethod(int val);
 
@@ -0,0 +1,58 @@
+#include <sofa/simulation/ParallelForRange.h>
+#include <sofa/simulation/DefaultTaskScheduler.h>
+#include <sofa/testing/BaseTest.h>
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace sofa
+{
+    // every element of the range is visited once, by contiguous ranges of at least minRangeSize elements
+    static void checkRanges(simulation::TaskScheduler* scheduler, std::size_t begin, std::size_t end, std::size_t minRangeSize)
+    {
+        std::vector<std::atomic<int> > visits(end);
+        for (auto& v : visits)
+            v = 0;
+        std::mutex mutex;
+        std::vector<std::pair<std::size_t,std::size_t> > ranges;
+
+        simulation::parallelForRange(scheduler, begin, end, minRangeSize, [&](std::size_t b, std::size_t e)
+        {
+            for (std::size_t i=b; i<e; i++)
+                visits[i]++;
+            std::lock_guard<std::mutex> lock(mutex);
+            ranges.emplace_back(b, e);
+        });
+
+        for (std::size_t i=0; i<end; i++)
+            EXPECT_EQ(visits[i], i < begin ? 0 : 1) << "element " << i;
+        const std::size_t nbThreads = scheduler ? scheduler->getThreadCount() : 1;
+        EXPECT_LE(ranges.size(), std::max<std::size_t>(nbThreads, 1));
+        if (ranges.size() > 1)
+        {
+            for (const auto& r : ranges)
+                EXPECT_GE(r.second - r.first, minRangeSize);
+        }
+    }
+
+    TEST(ParallelForRangeTests, Sequential)
+    {
+        checkRanges(nullptr, 0, 1000, 10);
+        checkRanges(nullptr, 5, 5, 10);
+    }
+
+    TEST(ParallelForRangeTests, Parallel)
+    {
+        simulation::TaskScheduler* scheduler = simulation::TaskScheduler::create(simulation::DefaultTaskScheduler::name());
+        scheduler->init(4);
+
+        checkRanges(scheduler, 0, 100000, 100);
+        checkRanges(scheduler, 37, 10001, 1000);
+        checkRanges(scheduler, 0, 50, 100); // too small to be split
+        checkRanges(scheduler, 3, 7, 1);
+
+        scheduler->stop();
+    }
+
+} // namespace sofa
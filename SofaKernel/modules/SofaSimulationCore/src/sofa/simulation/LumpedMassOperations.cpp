@@ -0,0 +1,125 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/simulation/LumpedMassOperations.h>
+#include <sofa/simulation/MechanicalOperations.h>
+#include <sofa/simulation/Node.h>
+#include <sofa/core/behavior/BaseMass.h>
+#include <sofa/core/behavior/BaseForceField.h>
+#include <sofa/core/behavior/BaseProjectiveConstraintSet.h>
+
+namespace sofa::simulation::common
+{
+
+namespace
+{
+
+/// true if the node and its descendants do not hold any mechanical component
+bool hasNoMechanicalComponent(const simulation::Node* node)
+{
+    if (node->mechanicalState != nullptr || !node->mechanicalMapping.empty() || node->mass != nullptr
+        || !node->forceField.empty() || !node->interactionForceField.empty()
+        || !node->projectiveConstraintSet.empty() || !node->constraintSet.empty()
+        || !node->solver.empty() || !node->constraintSolver.empty())
+        return false;
+
+    for (const auto& child : node->child)
+    {
+        if (!hasNoMechanicalComponent(child.get()))
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+bool LumpedMassOperations::collect(core::objectmodel::BaseContext* ctx)
+{
+    m_mstate = nullptr;
+    m_mass = nullptr;
+    m_forceFields.clear();
+    m_projectiveConstraints.clear();
+
+    const simulation::Node* node = dynamic_cast<const simulation::Node*>(ctx);
+    if (node == nullptr || node->mechanicalState == nullptr || node->mass == nullptr
+        || !node->mechanicalMapping.empty() || !node->interactionForceField.empty()
+        || !node->constraintSolver.empty())
+        return false;
+
+    for (const auto& child : node->child)
+    {
+        if (!hasNoMechanicalComponent(child.get()))
+            return false;
+    }
+
+    m_mstate = node->mechanicalState;
+    m_mass = node->mass;
+    for (auto* ff : node->forceField)
+        m_forceFields.push_back(ff);
+    for (auto* pc : node->projectiveConstraintSet)
+        m_projectiveConstraints.push_back(pc);
+    return true;
+}
+
+void LumpedMassOperations::realloc(const core::ExecParams* params, core::MultiVecDerivId v)
+{
+    m_mstate->vRealloc(params, v.getId(m_mstate));
+}
+
+void LumpedMassOperations::addSeparateGravity(MechanicalOperations& mop, SReal dt, core::MultiVecDerivId v)
+{
+    if (v.getDefaultId().isNull()) v.setDefaultId(core::VecDerivId::velocity());
+    mop.mparams.setDt(dt);
+    mop.mparams.setV(v);
+    if (m_mass->m_separateGravity.getValue())
+        m_mass->addGravityToV(&mop.mparams, v);
+}
+
+void LumpedMassOperations::computeAcc(MechanicalOperations& mop, core::MultiVecDerivId f, core::MultiVecDerivId a)
+{
+    if (f.getDefaultId().isNull()) f.setDefaultId(core::VecDerivId::force());
+    if (a.getDefaultId().isNull()) a.setDefaultId(core::VecDerivId::dx());
+    core::MechanicalParams* mparams = &mop.mparams;
+    mparams->setF(f);
+    mparams->setDx(a);
+
+    // same calls as MechanicalResetForceVisitor and MechanicalComputeForceVisitor
+    m_mstate->resetForce(mparams, f.getId(m_mstate));
+    m_mstate->accumulateForce(mparams, f.getId(m_mstate));
+    for (auto* ff : m_forceFields)
+    {
+        if (!ff->isCompliance.getValue()) ff->addForce(mparams, f);
+        else ff->updateForceMask();
+    }
+    m_mstate->forceMask.activate(false);
+
+    // same calls as MechanicalAccFromFVisitor and MechanicalApplyConstraintsVisitor
+    m_mass->accFromF(mparams, a);
+    for (auto* pc : m_projectiveConstraints)
+        pc->projectResponse(mparams, a);
+}
+
+void LumpedMassOperations::vMultiOp(const core::ExecParams* params, const VMultiOp& ops)
+{
+    m_mstate->vMultiOp(params, ops);
+}
+
+} // namespace sofa::simulation::common
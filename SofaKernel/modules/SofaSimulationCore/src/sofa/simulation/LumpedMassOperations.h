@@ -0,0 +1,79 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+
+#include <sofa/simulation/config.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
+#include <sofa/core/MultiVecId.h>
+#include <sofa/helper/vector.h>
+
+namespace sofa::core::behavior
+{
+class BaseMass;
+class BaseForceField;
+class BaseProjectiveConstraintSet;
+}
+
+namespace sofa::simulation::common
+{
+
+class MechanicalOperations;
+
+/** Visitor-free version of the operations performed by explicit solvers with a lumped mass.
+ *
+ * When the subtree of a solver holds a single, unmapped mechanical state with a mass, its force
+ * fields and projective constraints, the acceleration a = M^-1 f can be obtained by calling the
+ * components directly instead of traversing the graph with one visitor per operation. collect()
+ * checks these conditions; the generic MechanicalOperations must be used when it returns false.
+ */
+class SOFA_SIMULATION_CORE_API LumpedMassOperations
+{
+public:
+    typedef core::behavior::BaseMechanicalState::VMultiOp VMultiOp;
+
+    /// Gather the components of the subtree rooted at the given context.
+    /// Returns false if the subtree contains mappings, interaction force fields, several
+    /// mechanical states or a constraint solver.
+    bool collect(core::objectmodel::BaseContext* ctx);
+
+    /// Make sure the given vector is allocated in the collected mechanical state
+    void realloc(const core::ExecParams* params, core::MultiVecDerivId v);
+
+    /// v += dt*g, for masses adding the gravity separately
+    void addSeparateGravity(MechanicalOperations& mop, SReal dt, core::MultiVecDerivId v);
+
+    /// f = sum of the forces, a = M^-1 f projected to the constrained space
+    void computeAcc(MechanicalOperations& mop, core::MultiVecDerivId f, core::MultiVecDerivId a);
+
+    /// Apply the given linear combinations to the collected mechanical state
+    void vMultiOp(const core::ExecParams* params, const VMultiOp& ops);
+
+    core::behavior::BaseMechanicalState* getMechanicalState() const { return m_mstate; }
+
+protected:
+    core::behavior::BaseMechanicalState* m_mstate { nullptr };
+    core::behavior::BaseMass* m_mass { nullptr };
+    helper::vector<core::behavior::BaseForceField*> m_forceFields;
+    helper::vector<core::behavior::BaseProjectiveConstraintSet*> m_projectiveConstraints;
+};
+
+} // namespace sofa::simulation::common
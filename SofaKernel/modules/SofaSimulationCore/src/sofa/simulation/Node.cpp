@@ -870,6 +870,16 @@ void Node::updateVisualContext()
         msg_info()<<"Node::updateVisualContext, node = "<<getName()<<", updated context = "<< *static_cast<core::objectmodel::Context*>(this) ;
 }
 
+VisitorScheduler* Node::getVisitorScheduler() const
+{
+    for (const Node* node = this; node != nullptr; node = static_cast<const Node*>(node->getFirstParent()))
+    {
+        if (node->visitorScheduler)
+            return node->visitorScheduler;
+    }
+    return nullptr;
+}
+
 /// Execute a recursive action starting from this node
 void Node::executeVisitor(Visitor* action, bool precomputedOrder)
 {
@@ -890,7 +900,11 @@ void Node::executeVisitor(Visitor* action, bool precomputedOrder)
         ++level;
     }
 
-    doExecuteVisitor(action, precomputedOrder);
+    VisitorScheduler* scheduler = precomputedOrder ? nullptr : getVisitorScheduler();
+    if (scheduler)
+        scheduler->executeVisitor(this, action);
+    else
+        doExecuteVisitor(action, precomputedOrder);
 
     if(DEBUG_VISITOR)
     {
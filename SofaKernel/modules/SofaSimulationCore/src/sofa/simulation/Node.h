@@ -182,8 +182,14 @@ public:
     virtual void doExecuteVisitor(Visitor* action, bool precomputedOrder=false)=0;
 
     /// Execute a recursive action starting from this node
+    /// If a VisitorScheduler is attached to this node or to one of its ancestors, the execution is delegated to it
     void executeVisitor(Visitor* action, bool precomputedOrder=false) override;
 
+    /// Set the scheduler used to execute the visitors started from this node and its descendants
+    void setVisitorScheduler(VisitorScheduler* scheduler) { visitorScheduler = scheduler; }
+    /// Get the scheduler attached to this node or to its closest ancestor (nullptr if none)
+    VisitorScheduler* getVisitorScheduler() const;
+
     /// Execute a recursive action starting from this node
     void execute(Visitor& action, bool precomputedOrder=false)
     {
@@ -533,6 +539,9 @@ protected:
     virtual void doMoveObject(sofa::core::objectmodel::BaseObject::SPtr sobj, Node* prev_parent);
 
     std::stack<Visitor*> actionStack;
+
+    /// Custom scheduler of the visitors started from this node (nullptr to use doExecuteVisitor)
+    VisitorScheduler* visitorScheduler { nullptr };
 private:    
     virtual void notifyBeginAddChild(Node::SPtr parent, Node::SPtr child) const;
     virtual void notifyBeginRemoveChild(Node::SPtr parent, Node::SPtr child) const;
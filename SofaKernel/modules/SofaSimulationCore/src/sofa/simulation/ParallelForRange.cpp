@@ -0,0 +1,89 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <sofa/simulation/ParallelForRange.h>
+#include <sofa/simulation/CpuTask.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace sofa::simulation
+{
+
+namespace
+{
+
+/// Apply a function on a contiguous range
+class RangeTask : public CpuTask
+{
+public:
+    RangeTask(CpuTask::Status* status, const std::function<void(std::size_t,std::size_t)>& f, std::size_t begin, std::size_t end)
+        : CpuTask(status), m_f(f), m_begin(begin), m_end(end) {}
+    ~RangeTask() override {}
+
+    MemoryAlloc run() final
+    {
+        m_f(m_begin, m_end);
+        return MemoryAlloc::Stack;
+    }
+
+private:
+    const std::function<void(std::size_t,std::size_t)>& m_f;
+    std::size_t m_begin;
+    std::size_t m_end;
+};
+
+} // namespace
+
+TaskScheduler* initTaskScheduler()
+{
+    TaskScheduler* taskScheduler = TaskScheduler::getInstance();
+    if (taskScheduler->getThreadCount() < 1)
+        taskScheduler->init(0);
+    return taskScheduler;
+}
+
+void parallelForRange(TaskScheduler* taskScheduler, std::size_t begin, std::size_t end, std::size_t minRangeSize,
+                      const std::function<void(std::size_t,std::size_t)>& f)
+{
+    if (end <= begin)
+        return;
+
+    const std::size_t n = end - begin;
+    const std::size_t nbTasks = taskScheduler ? std::min<std::size_t>(taskScheduler->getThreadCount(), n / std::max<std::size_t>(minRangeSize, 1)) : 1;
+    if (nbTasks <= 1)
+    {
+        f(begin, end);
+        return;
+    }
+
+    CpuTask::Status status;
+    std::vector<RangeTask> tasks;
+    tasks.reserve(nbTasks);
+    for (std::size_t t=0; t<nbTasks; t++)
+    {
+        tasks.emplace_back(&status, f, begin + n * t / nbTasks, begin + n * (t+1) / nbTasks);
+        taskScheduler->addTask(&tasks.back());
+    }
+    taskScheduler->workUntilDone(&status);
+}
+
+} // namespace sofa::simulation
@@ -0,0 +1,47 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+
+#include <sofa/simulation/config.h>
+
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <functional>
+
+namespace sofa::simulation
+{
+
+/// Get the TaskScheduler instance, initialized with one thread per core if it has no thread yet
+SOFA_SIMULATION_CORE_API TaskScheduler* initTaskScheduler();
+
+/**
+ * Apply f(rangeBegin, rangeEnd) on contiguous ranges covering [begin, end).
+ *
+ * The ranges are processed by the threads of the TaskScheduler, with at most one range per thread,
+ * and at least minRangeSize elements per range. f is called once on the whole range, in the calling
+ * thread, if the TaskScheduler is null or if the range is too small to be split.
+ * It returns when all the ranges are processed.
+ */
+SOFA_SIMULATION_CORE_API void parallelForRange(TaskScheduler* taskScheduler, std::size_t begin, std::size_t end, std::size_t minRangeSize,
+                                               const std::function<void(std::size_t,std::size_t)>& f);
+
+} // namespace sofa::simulation
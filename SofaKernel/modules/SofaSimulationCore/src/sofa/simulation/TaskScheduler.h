@@ -79,6 +79,12 @@ namespace sofa
              */
             static TaskScheduler* getInstance();
 
+            /**
+             * Check if a TaskScheduler instance has already been created, without creating one.
+             * @return true if getInstance() or create() has already been called
+             */
+            static bool hasInstance() { return _currentScheduler != nullptr; }
+
             /**
              * Get the name of the current TaskScheduler instance
              * @return The name of the current TaskScheduler instance
@@ -34,6 +34,21 @@ void VisitorScheduler::doExecuteVisitor(simulation::Node* node, Visitor* act)
     node->doExecuteVisitor(act);
 }
 
+bool VisitorScheduler::insertInNode( sofa::core::objectmodel::BaseNode* node )
+{
+    if (Node* n = dynamic_cast<Node*>(node))
+        n->setVisitorScheduler(this);
+    return Inherit1::insertInNode(node);
+}
+
+bool VisitorScheduler::removeInNode( sofa::core::objectmodel::BaseNode* node )
+{
+    Node* n = dynamic_cast<Node*>(node);
+    if (n && n->visitorScheduler == this)
+        n->setVisitorScheduler(nullptr);
+    return Inherit1::removeInNode(node);
+}
+
 } // namespace simulation
 
 } // namespace sofa
@@ -45,6 +45,10 @@ public:
     /// Specify whether this scheduler is multi-threaded.
     virtual bool isMultiThreaded() const { return false; }
 
+    /// Register this scheduler in the node, so that the visitors started from it are executed by the scheduler
+    bool insertInNode( sofa::core::objectmodel::BaseNode* node ) override;
+    bool removeInNode( sofa::core::objectmodel::BaseNode* node ) override;
+
 protected:
 
     VisitorScheduler() {}
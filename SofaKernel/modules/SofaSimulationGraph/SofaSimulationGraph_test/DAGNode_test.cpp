@@ -91,7 +91,43 @@ struct DAGNode_test : public BaseTest
         commonParent = node11->findCommonParent(static_cast<simulation::Node*>(node23.get()));
         EXPECT_STREQ(node2->getName().c_str(), commonParent->getName().c_str());
     }
+
+    void test_computeIndependentChildGroups()
+    {
+        DAGNode::SPtr root = core::objectmodel::New<DAGNode>("root");
+        DAGNode::SPtr node1 = core::objectmodel::New<DAGNode>("node1");
+        DAGNode::SPtr node2 = core::objectmodel::New<DAGNode>("node2");
+        DAGNode::SPtr node3 = core::objectmodel::New<DAGNode>("node3");
+        DAGNode::SPtr node4 = core::objectmodel::New<DAGNode>("node4");
+        DAGNode::SPtr node11 = core::objectmodel::New<DAGNode>("node11");
+        DAGNode::SPtr node31 = core::objectmodel::New<DAGNode>("node31");
+
+        root->addChild(node1);
+        root->addChild(node2);
+        root->addChild(node3);
+        root->addChild(node4);
+
+        // node11 is shared by node1 and node3
+        node1->addChild(node11);
+        node3->addChild(node11);
+        node3->addChild(node31);
+
+        std::vector<DAGNode::ChildGroup> groups;
+        root->computeIndependentChildGroups(groups);
+
+        ASSERT_EQ(3u, groups.size());
+        EXPECT_EQ(DAGNode::ChildGroup({node1.get(), node3.get()}), groups[0]);
+        EXPECT_EQ(DAGNode::ChildGroup({node2.get()}), groups[1]);
+        EXPECT_EQ(DAGNode::ChildGroup({node4.get()}), groups[2]);
+
+        node3->computeIndependentChildGroups(groups);
+        EXPECT_EQ(2u, groups.size());
+
+        node11->computeIndependentChildGroups(groups);
+        EXPECT_TRUE(groups.empty());
+    }
 };
 
 TEST_F(DAGNode_test, test_findCommonParent) { test_findCommonParent(); }
 TEST_F(DAGNode_test, test_findCommonParent_MultipleParents) { test_findCommonParent_MultipleParents(); }
+TEST_F(DAGNode_test, test_computeIndependentChildGroups) { test_computeIndependentChildGroups(); }
@@ -23,6 +23,10 @@
 #include <SofaSimulationCommon/xml/NodeElement.h>
 #include <sofa/helper/Factory.inl>
 #include <sofa/core/Mapping.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
+
+#include <numeric>
+#include <unordered_map>
 
 namespace sofa::simulation::graph
 {
@@ -701,6 +705,92 @@ void DAGNode::executeVisitorTopDown(simulation::Visitor* action, NodeList& execu
 }
 
 
+void DAGNode::computeIndependentChildGroups( std::vector<ChildGroup>& groups )
+{
+    groups.clear();
+    updateDescendancy();
+
+    // union-find structure on the child indices, two children are merged as soon as their sub-graphs share a resource
+    std::vector<std::size_t> groupOf( child.size() );
+    std::iota( groupOf.begin(), groupOf.end(), 0 );
+    const auto findGroup = [&groupOf]( std::size_t i )
+    {
+        while( groupOf[i] != i )
+        {
+            groupOf[i] = groupOf[groupOf[i]];
+            i = groupOf[i];
+        }
+        return i;
+    };
+
+    // first child claiming each node or mechanical state
+    std::unordered_map<const void*, std::size_t> owner;
+    const auto claim = [&owner, &groupOf, &findGroup]( const void* resource, std::size_t childIndex )
+    {
+        if( resource == nullptr ) return;
+        const auto inserted = owner.emplace( resource, childIndex );
+        if( !inserted.second )
+        {
+            const std::size_t a = findGroup( inserted.first->second );
+            const std::size_t b = findGroup( childIndex );
+            if( a != b ) groupOf[b] = a;
+        }
+    };
+    const auto claimNode = [&claim]( DAGNode* node, std::size_t childIndex )
+    {
+        claim( node, childIndex );
+        claim( node->mechanicalState.get(), childIndex );
+        for( const auto& obj : node->object )
+        {
+            for( const core::objectmodel::BaseLink* link : obj->getLinks() )
+            {
+                for( std::size_t i = 0; i < link->getSize(); ++i )
+                    claim( dynamic_cast<core::behavior::BaseMechanicalState*>( link->getLinkedBase(i) ), childIndex );
+            }
+        }
+    };
+
+    for( std::size_t i = 0; i < child.size(); ++i )
+    {
+        DAGNode* dagnode = static_cast<DAGNode*>( child[i].get() );
+        claimNode( dagnode, i );
+        for( DAGNode* descendant : dagnode->_descendancy )
+            claimNode( descendant, i );
+    }
+
+    // gather the children of each group, keeping the children order
+    std::vector<std::size_t> groupIndex( child.size(), child.size() );
+    for( std::size_t i = 0; i < child.size(); ++i )
+    {
+        const std::size_t g = findGroup( i );
+        if( groupIndex[g] == child.size() )
+        {
+            groupIndex[g] = groups.size();
+            groups.emplace_back();
+        }
+        groups[groupIndex[g]].push_back( static_cast<DAGNode*>( child[i].get() ) );
+    }
+}
+
+
+void DAGNode::executeVisitorOnChildGroup( simulation::Visitor* action, const ChildGroup& group )
+{
+    // the traversal infos are local to the group, as several groups can be traversed simultaneously
+    NodeList executedNodes;
+    {
+        StatusMap statusMap;
+        statusMap[this] = VISITED;
+        if( action->childOrderReversed(this) )
+            for( auto it = group.rbegin(), itend = group.rend(); it != itend; ++it )
+                (*it)->executeVisitorTopDown( action, executedNodes, statusMap, this );
+        else
+            for( DAGNode* dagnode : group )
+                dagnode->executeVisitorTopDown( action, executedNodes, statusMap, this );
+    }
+    executeVisitorBottomUp( action, executedNodes );
+}
+
+
 // warning nodes that are dynamically created during the traversal, but that have not been traversed during the top-down, won't be traversed during the bottom-up
 // TODO is it what we want?
 // otherwise it is possible to restart from top, go to leaves and running bottom-up action while going up
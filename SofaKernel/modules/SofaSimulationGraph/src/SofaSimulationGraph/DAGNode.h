@@ -134,6 +134,23 @@ public:
 
     virtual void moveChild(BaseNode::SPtr node) override;
 
+    /// @name Concurrent traversal of independent sub-graphs
+    /// @{
+
+    /// a group of child nodes
+    typedef std::vector<DAGNode*> ChildGroup;
+
+    /// Partition the child nodes in groups, such that the sub-graphs of two different groups share neither a node nor a mechanical state.
+    /// The mechanical states of a sub-graph are the ones it contains and the ones linked by its components (mapping inputs, interaction models...).
+    /// A mechanical visitor can then traverse the sub-graphs of different groups concurrently.
+    void computeIndependentChildGroups( std::vector<ChildGroup>& groups );
+
+    /// Execute the DAG traversal (top-down then bottom-up) of the sub-graphs of a group of child nodes.
+    /// This node must already have been processed top-down by the visitor, its bottom-up processing is left to the caller.
+    void executeVisitorOnChildGroup( simulation::Visitor* action, const ChildGroup& group );
+
+    /// @}
+
 protected:
 
     /// bottom-up traversal, returning the first node which have a descendancy containing both node1 & node2
@@ -112,7 +112,7 @@ void ManifoldTetrahedronSetTopologyContainer::createTetrahedraAroundEdgeArray ()
     for (unsigned int edgeIndex =0; edgeIndex<edges.size(); edgeIndex++)
     {
 
-        auto &shell = getTetrahedraAroundEdgeForModification (edgeIndex);
+        auto shell = getTetrahedraAroundEdgeForModification (edgeIndex);
         sofa::helper::vector < sofa::helper::vector <Index> > vertexTofind;
         sofa::helper::vector <Index> goodShell;
         unsigned int firstVertex =0;
@@ -252,7 +252,7 @@ void ManifoldTetrahedronSetTopologyContainer::createTetrahedraAroundTriangleArra
 
     for (unsigned int triangleIndex = 0; triangleIndex < m_tetrahedraAroundTriangle.size(); triangleIndex++)
     {
-        auto &shell = getTetrahedraAroundTriangleForModification (triangleIndex);
+        auto shell = getTetrahedraAroundTriangleForModification (triangleIndex);
 
         if (shell.size() == 1)
         {
@@ -0,0 +1,322 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <MultiThreading/DataEngineParallelScheduler.h>
+
+#include <sofa/core/DataEngine.h>
+#include <sofa/core/ObjectFactory.h>
+#include <sofa/core/objectmodel/DataCallback.h>
+#include <sofa/simulation/AnimateBeginEvent.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/helper/ScopedAdvancedTimer.h>
+
+#include <set>
+
+namespace sofa::simulation
+{
+
+using sofa::helper::ScopedAdvancedTimer;
+
+int DataEngineParallelSchedulerClass = core::RegisterObject("Update the independent dirty DataEngines of a sub-graph in parallel")
+        .add< DataEngineParallelScheduler >()
+;
+
+DataEngineParallelScheduler::DataEngineParallelScheduler()
+    : d_updateAtInit(initData(&d_updateAtInit, true, "updateAtInit", "Update the dirty engines at the end of the initialization"))
+    , d_updateAtBeginStep(initData(&d_updateAtBeginStep, true, "updateAtBeginStep", "Update the dirty engines at the beginning of each time step"))
+{
+    this->f_listening.setValue(true);
+}
+
+void DataEngineParallelScheduler::init()
+{
+    Inherit1::init();
+
+    // initialize the thread pool
+
+    auto* taskScheduler = TaskScheduler::getInstance();
+    assert(taskScheduler != nullptr);
+    if (taskScheduler->getThreadCount() < 1)
+    {
+        taskScheduler->init(0);
+        msg_info() << "Task scheduler initialized on " << taskScheduler->getThreadCount() << " threads";
+    }
+    else
+    {
+        msg_info() << "Task scheduler already initialized on " << taskScheduler->getThreadCount() << " threads";
+    }
+}
+
+void DataEngineParallelScheduler::bwdInit()
+{
+    if (d_updateAtInit.getValue())
+    {
+        updateEngines();
+    }
+}
+
+void DataEngineParallelScheduler::handleEvent(core::objectmodel::Event* event)
+{
+    if (AnimateBeginEvent::checkEventType(event) && d_updateAtBeginStep.getValue())
+    {
+        updateEngines();
+    }
+}
+
+void DataEngineParallelScheduler::updateEngines()
+{
+    ScopedAdvancedTimer timer("DataEngineParallelScheduler::updateEngines");
+
+    std::vector<core::DataEngine*> engines;
+    this->getContext()->get<core::DataEngine>(&engines, core::objectmodel::BaseContext::SearchDown);
+
+    std::vector<core::DataEngine*> dirtyEngines;
+    dirtyEngines.reserve(engines.size());
+    for (auto* engine : engines)
+    {
+        if (engine->isDirty())
+        {
+            dirtyEngines.push_back(engine);
+        }
+    }
+
+    if (dirtyEngines.empty())
+    {
+        return;
+    }
+
+    std::vector<EngineLevel> levels;
+    computeLevels(dirtyEngines, levels);
+
+    for (const auto& level : levels)
+    {
+        updateLevel(level);
+    }
+}
+
+void DataEngineParallelScheduler::findDependencies(core::DataEngine* engine,
+                                                   const std::map<core::DataEngine*, int>& dirtyEngines,
+                                                   std::vector<core::DataEngine*>& dependencies) const
+{
+    // Depth-first traversal of the dirty part of the data dependency graph, upstream of the engine.
+    // The traversal stops on the engines to update: they are the dependencies.
+    std::set<core::objectmodel::DDGNode*> visited;
+    std::vector<core::objectmodel::DDGNode*> stack(engine->getInputs().begin(), engine->getInputs().end());
+
+    while (!stack.empty())
+    {
+        core::objectmodel::DDGNode* node = stack.back();
+        stack.pop_back();
+
+        if (!node->isDirty() || !visited.insert(node).second)
+        {
+            continue;
+        }
+
+        auto* upstreamEngine = dynamic_cast<core::DataEngine*>(node);
+        if (upstreamEngine != nullptr && dirtyEngines.find(upstreamEngine) != dirtyEngines.end())
+        {
+            dependencies.push_back(upstreamEngine);
+            continue;
+        }
+
+        for (auto* input : node->getInputs())
+        {
+            stack.push_back(input);
+        }
+    }
+}
+
+void DataEngineParallelScheduler::computeLevels(const std::vector<core::DataEngine*>& dirtyEngines, std::vector<EngineLevel>& levels) const
+{
+    std::map<core::DataEngine*, int> engineLevel;
+    for (auto* engine : dirtyEngines)
+    {
+        engineLevel[engine] = -1;
+    }
+
+    std::map<core::DataEngine*, std::vector<core::DataEngine*> > dependencies;
+    for (auto* engine : dirtyEngines)
+    {
+        findDependencies(engine, engineLevel, dependencies[engine]);
+    }
+
+    // The level of an engine is one more than the highest level of its dependencies.
+    // The data dependency graph is acyclic, so the iterative traversal terminates.
+    for (auto* engine : dirtyEngines)
+    {
+        std::vector<core::DataEngine*> stack { engine };
+        while (!stack.empty())
+        {
+            core::DataEngine* current = stack.back();
+            if (engineLevel[current] >= 0)
+            {
+                stack.pop_back();
+                continue;
+            }
+
+            int level = 0;
+            bool resolved = true;
+            for (auto* dependency : dependencies[current])
+            {
+                const int dependencyLevel = engineLevel[dependency];
+                if (dependencyLevel < 0)
+                {
+                    stack.push_back(dependency);
+                    resolved = false;
+                }
+                else
+                {
+                    level = std::max(level, dependencyLevel + 1);
+                }
+            }
+
+            if (resolved)
+            {
+                engineLevel[current] = level;
+                stack.pop_back();
+            }
+        }
+    }
+
+    for (auto* engine : dirtyEngines)
+    {
+        const auto level = static_cast<std::size_t>(engineLevel[engine]);
+        if (level >= levels.size())
+        {
+            levels.resize(level + 1);
+        }
+        levels[level].push_back(engine);
+    }
+}
+
+bool DataEngineParallelScheduler::hasDownstreamCallback(core::DataEngine* engine) const
+{
+    // Writing an output notifies the whole downstream graph (DDGNode::notifyEndEdit):
+    // the only nodes reacting to this notification are the DataCallbacks.
+    const auto& outputs = engine->core::objectmodel::DDGNode::getOutputs();
+    std::set<core::objectmodel::DDGNode*> visited;
+    std::vector<core::objectmodel::DDGNode*> stack(outputs.begin(), outputs.end());
+
+    while (!stack.empty())
+    {
+        core::objectmodel::DDGNode* node = stack.back();
+        stack.pop_back();
+
+        if (!visited.insert(node).second)
+        {
+            continue;
+        }
+
+        if (dynamic_cast<core::objectmodel::DataCallback*>(node) != nullptr)
+        {
+            return true;
+        }
+
+        for (auto* output : node->getOutputs())
+        {
+            stack.push_back(output);
+        }
+    }
+    return false;
+}
+
+void DataEngineParallelScheduler::updateLevel(const EngineLevel& level)
+{
+    // Inputs which are not outputs of the engines to update (links to other Data, engines outside
+    // of the sub-graph...) may be shared among the engines of the level: they are updated sequentially
+    // so that the parallel tasks only read clean inputs.
+    for (auto* engine : level)
+    {
+        for (auto* input : engine->getInputs())
+        {
+            input->updateIfDirty();
+        }
+    }
+
+    auto* taskScheduler = TaskScheduler::getInstance();
+    if (level.size() < 2 || taskScheduler == nullptr || taskScheduler->getThreadCount() < 2)
+    {
+        for (auto* engine : level)
+        {
+            engine->updateIfDirty();
+        }
+        return;
+    }
+
+    // The dirty flags of the DDG nodes are not atomic: all the writes to flags which may be shared
+    // among the engines of the level are performed here, sequentially, before the parallel update.
+    // - Cleaning an engine resets the dirtyOutputs flag of its inputs.
+    // - The dirtiness of the outputs is propagated downstream: when an output is written during the
+    //   update, the propagation stops on the output itself.
+    // Engines notifying a DataCallback when writing their outputs are updated sequentially.
+    EngineLevel sequentialEngines;
+
+    CpuTask::Status status;
+
+    m_tasks.clear();
+    m_tasks.reserve(level.size());
+    for (auto* engine : level)
+    {
+        if (!engine->isDirty())
+        {
+            continue;
+        }
+        if (hasDownstreamCallback(engine))
+        {
+            sequentialEngines.push_back(engine);
+            continue;
+        }
+
+        engine->cleanDirty();
+        for (auto* output : engine->core::objectmodel::DDGNode::getOutputs())
+        {
+            output->setDirtyOutputs();
+        }
+        m_tasks.emplace_back(&status, engine);
+    }
+
+    for (auto& task : m_tasks)
+    {
+        taskScheduler->addTask(&task);
+    }
+    taskScheduler->workUntilDone(&status);
+    m_tasks.clear();
+
+    for (auto* engine : sequentialEngines)
+    {
+        engine->updateIfDirty();
+    }
+}
+
+DataEngineUpdateTask::DataEngineUpdateTask(CpuTask::Status* status, core::DataEngine* engine)
+    : CpuTask(status)
+    , m_engine(engine)
+{}
+
+Task::MemoryAlloc DataEngineUpdateTask::run()
+{
+    // the engine has already been cleaned by the scheduler: updateIfDirty would skip it
+    m_engine->update();
+    return MemoryAlloc::Stack;
+}
+
+} // namespace sofa::simulation
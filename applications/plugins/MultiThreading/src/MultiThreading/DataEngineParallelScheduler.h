@@ -0,0 +1,108 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+
+#include <MultiThreading/config.h>
+
+#include <sofa/core/objectmodel/BaseObject.h>
+#include <sofa/simulation/CpuTask.h>
+
+#include <map>
+#include <vector>
+
+namespace sofa::core
+{
+    class DataEngine;
+}
+
+namespace sofa::simulation
+{
+
+class DataEngineUpdateTask;
+
+/**
+ * @brief Updates the dirty DataEngines of a sub-graph in parallel
+ *
+ * DataEngines are usually updated lazily, one after the other, when one of their outputs is read.
+ * This component collects the dirty engines located in its node and below, extracts the dependency
+ * graph between them, and updates the engines level by level: engines from the same level do not
+ * depend on each other and are updated concurrently using the global TaskScheduler.
+ * The update is performed at the end of the initialization and at the beginning of each time step.
+ */
+class SOFA_MULTITHREADING_PLUGIN_API DataEngineParallelScheduler : public core::objectmodel::BaseObject
+{
+public:
+    SOFA_CLASS(DataEngineParallelScheduler, core::objectmodel::BaseObject);
+
+    Data<bool> d_updateAtInit; ///< Update the dirty engines at the end of the initialization
+    Data<bool> d_updateAtBeginStep; ///< Update the dirty engines at the beginning of each time step
+
+    void init() override;
+    void bwdInit() override;
+    void handleEvent(core::objectmodel::Event* event) override;
+
+    /// Collect the dirty engines, sort them by dependency level and update them
+    void updateEngines();
+
+protected:
+    DataEngineParallelScheduler();
+    ~DataEngineParallelScheduler() override = default;
+
+    using EngineLevel = std::vector<core::DataEngine*>;
+
+    /// Sort the dirty engines found in the context by dependency level.
+    /// Engines of level i only depend on engines of levels < i.
+    void computeLevels(const std::vector<core::DataEngine*>& dirtyEngines, std::vector<EngineLevel>& levels) const;
+
+    /// Find the dirty engines (belonging to the set of engines to update) on which an engine depends
+    void findDependencies(core::DataEngine* engine,
+                          const std::map<core::DataEngine*, int>& dirtyEngines,
+                          std::vector<core::DataEngine*>& dependencies) const;
+
+    /// Check if writing the outputs of an engine triggers a DataCallback
+    bool hasDownstreamCallback(core::DataEngine* engine) const;
+
+    /// Update all the engines of a level. Engines are independent from each other.
+    void updateLevel(const EngineLevel& level);
+
+    /// List of tasks executed in parallel.
+    /// They are created for each level, but the memory is not freed
+    std::vector<DataEngineUpdateTask> m_tasks;
+};
+
+/**
+ * @brief Task updating a single DataEngine
+ *
+ * The dirty flags of the engine are handled by the scheduler before the task is run.
+ */
+class SOFA_MULTITHREADING_PLUGIN_API DataEngineUpdateTask : public CpuTask
+{
+public:
+    DataEngineUpdateTask(CpuTask::Status* status, core::DataEngine* engine);
+    ~DataEngineUpdateTask() override = default;
+    Task::MemoryAlloc run() final;
+
+private:
+    core::DataEngine* m_engine { nullptr };
+};
+
+} // namespace sofa::simulation
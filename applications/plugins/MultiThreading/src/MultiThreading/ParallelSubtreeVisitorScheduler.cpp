@@ -0,0 +1,248 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <MultiThreading/ParallelSubtreeVisitorScheduler.h>
+
+#include <sofa/core/ObjectFactory.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalAddMBKdxVisitor.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalComputeDfVisitor.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalComputeForceVisitor.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalResetForceVisitor.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalVMultiOpVisitor.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalVOpVisitor.h>
+#include <sofa/simulation/CpuTask.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/helper/ScopedAdvancedTimer.h>
+#include <sofa/helper/cast.h>
+
+namespace sofa::simulation
+{
+
+int ParallelSubtreeVisitorSchedulerClass = core::RegisterObject("Execute the mechanical visitors on the independent sub-graphs in parallel")
+        .add< ParallelSubtreeVisitorScheduler >()
+;
+
+namespace
+{
+
+/// Set while a thread is executing a parallel traversal: the visitors started
+/// during this traversal (by a component for instance) are executed serially
+thread_local bool insideParallelTraversal = false;
+
+/// The visitors executed in parallel: the operations on the state vectors and the accumulation of the
+/// forces and of their derivatives, which only write in the mechanical states of the visited sub-graph.
+/// The other visitors (matrix dimension and assembly, constraint matrix, energy, reductions...) accumulate
+/// a result in a shared object and are executed serially.
+bool isParallelVisitor(const Visitor* action)
+{
+    using namespace mechanicalvisitor;
+    return dynamic_cast<const MechanicalVOpVisitor*>(action) != nullptr
+        || dynamic_cast<const MechanicalVMultiOpVisitor*>(action) != nullptr
+        || dynamic_cast<const MechanicalResetForceVisitor*>(action) != nullptr
+        || dynamic_cast<const MechanicalComputeForceVisitor*>(action) != nullptr
+        || dynamic_cast<const MechanicalComputeDfVisitor*>(action) != nullptr
+        || dynamic_cast<const MechanicalAddMBKdxVisitor*>(action) != nullptr;
+}
+
+/// Task traversing the sub-graphs of a group of child nodes
+class ChildGroupVisitorTask : public CpuTask
+{
+public:
+    ChildGroupVisitorTask(CpuTask::Status* status, graph::DAGNode* node, const graph::DAGNode::ChildGroup* group, Visitor* action)
+        : CpuTask(status), m_node(node), m_group(group), m_action(action)
+    {}
+    ~ChildGroupVisitorTask() override = default;
+
+    MemoryAlloc run() final
+    {
+        const bool wasInside = insideParallelTraversal;
+        insideParallelTraversal = true;
+        m_node->executeVisitorOnChildGroup(m_action, *m_group);
+        insideParallelTraversal = wasInside;
+        return MemoryAlloc::Stack;
+    }
+
+private:
+    graph::DAGNode* m_node { nullptr };
+    const graph::DAGNode::ChildGroup* m_group { nullptr };
+    Visitor* m_action { nullptr };
+};
+
+} // anonymous namespace
+
+ParallelSubtreeVisitorScheduler::ParallelSubtreeVisitorScheduler()
+    : ParallelVisitorScheduler(false)
+{
+}
+
+void ParallelSubtreeVisitorScheduler::init()
+{
+    Inherit1::init();
+
+    // initialize the thread pool
+
+    auto* taskScheduler = TaskScheduler::getInstance();
+    assert(taskScheduler != nullptr);
+    if (taskScheduler->getThreadCount() < 1)
+    {
+        taskScheduler->init(0);
+        msg_info() << "Task scheduler initialized on " << taskScheduler->getThreadCount() << " threads";
+    }
+    else
+    {
+        msg_info() << "Task scheduler already initialized on " << taskScheduler->getThreadCount() << " threads";
+    }
+
+    if (m_listenedRoot == nullptr)
+    {
+        m_listenedRoot = down_cast<Node>(this->getContext()->getRootContext()->toBaseNode());
+        m_listenedRoot->addListener(this);
+    }
+
+    if (dynamic_cast<graph::DAGNode*>(this->getContext()) == nullptr)
+    {
+        msg_warning() << "This scheduler requires a DAG scene graph: the visitors will be executed serially";
+    }
+
+    clearChildGroups();
+}
+
+void ParallelSubtreeVisitorScheduler::reinit()
+{
+    clearChildGroups();
+}
+
+void ParallelSubtreeVisitorScheduler::cleanup()
+{
+    if (m_listenedRoot != nullptr)
+    {
+        m_listenedRoot->removeListener(this);
+        m_listenedRoot = nullptr;
+    }
+    clearChildGroups();
+    Inherit1::cleanup();
+}
+
+void ParallelSubtreeVisitorScheduler::onEndAddChild(Node*, Node*)
+{
+    clearChildGroups();
+}
+
+void ParallelSubtreeVisitorScheduler::onEndRemoveChild(Node*, Node*)
+{
+    clearChildGroups();
+}
+
+void ParallelSubtreeVisitorScheduler::onEndAddObject(Node*, core::objectmodel::BaseObject*)
+{
+    clearChildGroups();
+}
+
+void ParallelSubtreeVisitorScheduler::onEndRemoveObject(Node*, core::objectmodel::BaseObject*)
+{
+    clearChildGroups();
+}
+
+void ParallelSubtreeVisitorScheduler::clearChildGroups()
+{
+    m_childGroups.clear();
+}
+
+ParallelVisitorScheduler* ParallelSubtreeVisitorScheduler::clone()
+{
+    return new ParallelSubtreeVisitorScheduler();
+}
+
+void ParallelSubtreeVisitorScheduler::executeParallelVisitor(Node* node, Visitor* action)
+{
+    auto* dagNode = dynamic_cast<graph::DAGNode*>(node);
+
+    if (!isParallelVisitor(action) || dagNode == nullptr
+        || insideParallelTraversal || TaskScheduler::getInstance()->getThreadCount() < 2)
+    {
+        doExecuteVisitor(node, action);
+        return;
+    }
+
+    insideParallelTraversal = true;
+    executeOnSubGraph(dagNode, action);
+    insideParallelTraversal = false;
+}
+
+void ParallelSubtreeVisitorScheduler::executeOnSubGraph(graph::DAGNode* node, Visitor* action)
+{
+    if (action->processNodeTopDown(node) == Visitor::RESULT_PRUNE)
+    {
+        // the sub-graph is pruned
+        action->processNodeBottomUp(node);
+        return;
+    }
+
+    const auto& groups = getChildGroups(node);
+
+    if (groups.size() == 1 && groups.front().size() == 1)
+    {
+        // a single child: go down until the graph splits into independent sub-graphs
+        graph::DAGNode* child = groups.front().front();
+        if (child->getNbParents() == 1 && child->isActive() && (!child->isSleeping() || action->canAccessSleepingNode))
+        {
+            executeOnSubGraph(child, action);
+        }
+        else
+        {
+            node->executeVisitorOnChildGroup(action, groups.front());
+        }
+    }
+    else if (groups.size() == 1)
+    {
+        node->executeVisitorOnChildGroup(action, groups.front());
+    }
+    else if (groups.size() > 1)
+    {
+        CpuTask::Status status;
+        std::vector<ChildGroupVisitorTask> tasks;
+        tasks.reserve(groups.size());
+
+        auto* taskScheduler = TaskScheduler::getInstance();
+        for (const auto& group : groups)
+        {
+            tasks.emplace_back(&status, node, &group, action);
+            taskScheduler->addTask(&tasks.back());
+        }
+        taskScheduler->workUntilDone(&status);
+    }
+
+    action->processNodeBottomUp(node);
+}
+
+const std::vector<graph::DAGNode::ChildGroup>& ParallelSubtreeVisitorScheduler::getChildGroups(graph::DAGNode* node)
+{
+    auto it = m_childGroups.find(node);
+    if (it == m_childGroups.end())
+    {
+        sofa::helper::ScopedAdvancedTimer timer("ParallelSubtreeVisitorScheduler::computeIndependentChildGroups");
+        it = m_childGroups.emplace(node, std::vector<graph::DAGNode::ChildGroup>()).first;
+        node->computeIndependentChildGroups(it->second);
+    }
+    return it->second;
+}
+
+} // namespace sofa::simulation
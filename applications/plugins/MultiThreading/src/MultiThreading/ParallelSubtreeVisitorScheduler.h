@@ -0,0 +1,87 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+
+#include <MultiThreading/config.h>
+
+#include <sofa/simulation/ParallelVisitorScheduler.h>
+#include <sofa/simulation/MutationListener.h>
+#include <SofaSimulationGraph/DAGNode.h>
+
+#include <map>
+#include <vector>
+
+namespace sofa::simulation
+{
+
+/**
+ * @brief Executes the mechanical visitors on independent sub-graphs in parallel
+ *
+ * The visitors started from the node of this component, or from one of its descendants, are
+ * executed by this scheduler. The child nodes of a visited node are partitioned in groups whose
+ * sub-graphs share neither a node nor a mechanical state (see DAGNode::computeIndependentChildGroups).
+ * The groups are then traversed concurrently using the global TaskScheduler, each group following
+ * the usual DAG traversal order.
+ *
+ * Only the operations on the state vectors and the accumulation of the forces and of their derivatives
+ * are executed in parallel. The other visitors, reducing a value over the graph (dot products, norms,
+ * energy...) or filling a shared object (matrix dimension and assembly, constraint matrix...), are
+ * executed serially.
+ * The partition is computed on the first traversal and cached until the graph is modified.
+ */
+class SOFA_MULTITHREADING_PLUGIN_API ParallelSubtreeVisitorScheduler : public ParallelVisitorScheduler, public MutationListener
+{
+public:
+    SOFA_CLASS(ParallelSubtreeVisitorScheduler, ParallelVisitorScheduler);
+
+    void init() override;
+    void reinit() override;
+    void cleanup() override;
+
+    void onEndAddChild(Node* parent, Node* child) override;
+    void onEndRemoveChild(Node* parent, Node* child) override;
+    void onEndAddObject(Node* parent, core::objectmodel::BaseObject* object) override;
+    void onEndRemoveObject(Node* parent, core::objectmodel::BaseObject* object) override;
+
+protected:
+    ParallelSubtreeVisitorScheduler();
+    ~ParallelSubtreeVisitorScheduler() override = default;
+
+    ParallelVisitorScheduler* clone() override;
+    void executeParallelVisitor(Node* node, Visitor* action) override;
+
+    /// Execute the visitor on a node and its sub-graph, the independent groups of child nodes being traversed in parallel
+    void executeOnSubGraph(graph::DAGNode* node, Visitor* action);
+
+    /// Independent groups of child nodes of a node, computed on demand
+    const std::vector<graph::DAGNode::ChildGroup>& getChildGroups(graph::DAGNode* node);
+
+    /// Forget the cached groups, after a modification of the graph
+    void clearChildGroups();
+
+    std::map<graph::DAGNode*, std::vector<graph::DAGNode::ChildGroup> > m_childGroups;
+
+    /// Node where this scheduler listens to the graph modifications
+    Node* m_listenedRoot { nullptr };
+};
+
+} // namespace sofa::simulation
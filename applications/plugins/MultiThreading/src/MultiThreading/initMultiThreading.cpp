@@ -66,7 +66,7 @@ const char* getModuleDescription()
 
 const char* getModuleComponentList()
 {
-    return "DataExchange, AnimationLoopParallelScheduler ";
+    return "DataExchange, AnimationLoopParallelScheduler, DataEngineParallelScheduler, ParallelSubtreeVisitorScheduler ";
 }
 
 } // namespace component
@@ -0,0 +1,204 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <MultiThreading/DataEngineParallelScheduler.h>
+
+#include <sofa/core/DataEngine.h>
+#include <sofa/core/objectmodel/DataCallback.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/Node.h>
+#include <SofaSimulationGraph/SimpleApi.h>
+
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest;
+
+namespace sofa
+{
+
+namespace
+{
+
+/// Engine computing the sum of its two inputs, counting its updates
+class SumEngine : public core::DataEngine
+{
+public:
+    SOFA_CLASS(SumEngine, core::DataEngine);
+
+    Data<int> d_a;
+    Data<int> d_b;
+    Data<int> d_sum;
+
+    int m_nbUpdates { 0 };
+
+    void doUpdate() override
+    {
+        ++m_nbUpdates;
+        d_sum.setValue(d_a.getValue() + d_b.getValue());
+    }
+
+protected:
+    SumEngine()
+        : d_a(initData(&d_a, 0, "a", "first term"))
+        , d_b(initData(&d_b, 0, "b", "second term"))
+        , d_sum(initData(&d_sum, 0, "sum", "sum of the terms"))
+    {
+        addInput(&d_a);
+        addInput(&d_b);
+        addOutput(&d_sum);
+    }
+};
+
+struct DataEngineParallelScheduler_test : public BaseTest
+{
+    static constexpr std::size_t nbIntermediateEngines = 16;
+
+    simulation::Node::SPtr m_root;
+    simulation::DataEngineParallelScheduler::SPtr m_scheduler;
+
+    /// Level 0: a single source engine
+    SumEngine::SPtr m_source;
+    /// Level 1: engines sharing the output of the source as input
+    std::vector<SumEngine::SPtr> m_intermediate;
+    /// Level 2: engines summing two consecutive intermediate engines
+    std::vector<SumEngine::SPtr> m_final;
+
+    void onSetUp() override
+    {
+        simulation::TaskScheduler::getInstance()->init(4);
+
+        m_root = simpleapi::createRootNode(simpleapi::createSimulation("DAG"), "root");
+
+        m_scheduler = core::objectmodel::New<simulation::DataEngineParallelScheduler>();
+        m_scheduler->d_updateAtInit.setValue(false);
+        m_scheduler->d_updateAtBeginStep.setValue(false);
+        m_root->addObject(m_scheduler);
+
+        m_source = core::objectmodel::New<SumEngine>();
+        m_source->d_a.setValue(1);
+        m_source->d_b.setValue(2);
+        m_root->addObject(m_source);
+
+        for (std::size_t i = 0; i < nbIntermediateEngines; ++i)
+        {
+            auto engine = core::objectmodel::New<SumEngine>();
+            engine->d_a.setParent(&m_source->d_sum);
+            engine->d_b.setValue(static_cast<int>(i));
+            m_root->addObject(engine);
+            m_intermediate.push_back(engine);
+        }
+
+        for (std::size_t i = 0; i < nbIntermediateEngines; i += 2)
+        {
+            auto engine = core::objectmodel::New<SumEngine>();
+            engine->d_a.setParent(&m_intermediate[i]->d_sum);
+            engine->d_b.setParent(&m_intermediate[i + 1]->d_sum);
+            m_root->addObject(engine);
+            m_final.push_back(engine);
+        }
+    }
+
+    void onTearDown() override
+    {
+        simulation::TaskScheduler::getInstance()->stop();
+    }
+
+    void checkEngines(int source, int expectedNbUpdates)
+    {
+        EXPECT_FALSE(m_source->isDirty());
+        EXPECT_EQ(m_source->m_nbUpdates, expectedNbUpdates);
+        EXPECT_EQ(m_source->d_sum.getValue(), source);
+
+        for (std::size_t i = 0; i < nbIntermediateEngines; ++i)
+        {
+            EXPECT_FALSE(m_intermediate[i]->isDirty());
+            EXPECT_EQ(m_intermediate[i]->m_nbUpdates, expectedNbUpdates);
+            EXPECT_EQ(m_intermediate[i]->d_sum.getValue(), source + static_cast<int>(i));
+        }
+
+        for (std::size_t i = 0; i < m_final.size(); ++i)
+        {
+            EXPECT_FALSE(m_final[i]->isDirty());
+            EXPECT_EQ(m_final[i]->m_nbUpdates, expectedNbUpdates);
+            EXPECT_EQ(m_final[i]->d_sum.getValue(), 2 * source + static_cast<int>(4 * i + 1));
+        }
+    }
+};
+
+TEST_F(DataEngineParallelScheduler_test, updateLevels)
+{
+    m_scheduler->updateEngines();
+    checkEngines(3, 1);
+
+    // the engines are clean: a second update does nothing
+    m_scheduler->updateEngines();
+    checkEngines(3, 1);
+}
+
+TEST_F(DataEngineParallelScheduler_test, propagateDirtiness)
+{
+    m_scheduler->updateEngines();
+
+    // the dirtiness of the source is propagated to all the downstream engines
+    m_source->d_a.setValue(10);
+    EXPECT_TRUE(m_source->isDirty());
+    for (const auto& engine : m_intermediate)
+    {
+        EXPECT_TRUE(engine->isDirty());
+    }
+    for (const auto& engine : m_final)
+    {
+        EXPECT_TRUE(engine->isDirty());
+    }
+
+    m_scheduler->updateEngines();
+    checkEngines(12, 2);
+
+    // only the downstream engines of a modified input are updated
+    m_intermediate[0]->d_b.setValue(100);
+    EXPECT_FALSE(m_source->isDirty());
+    EXPECT_TRUE(m_intermediate[0]->isDirty());
+    EXPECT_FALSE(m_intermediate[1]->isDirty());
+    EXPECT_TRUE(m_final[0]->isDirty());
+    EXPECT_FALSE(m_final[1]->isDirty());
+
+    m_scheduler->updateEngines();
+    EXPECT_EQ(m_intermediate[0]->m_nbUpdates, 3);
+    EXPECT_EQ(m_intermediate[1]->m_nbUpdates, 2);
+    EXPECT_EQ(m_final[0]->m_nbUpdates, 3);
+    EXPECT_EQ(m_final[1]->m_nbUpdates, 2);
+    EXPECT_EQ(m_final[0]->d_sum.getValue(), 12 + 100 + 12 + 1);
+}
+
+TEST_F(DataEngineParallelScheduler_test, downstreamCallback)
+{
+    int nbCallbacks = 0;
+    core::objectmodel::DataCallback callback;
+    callback.addInputs({ &m_final[0]->d_sum, &m_final[1]->d_sum });
+    callback.addCallback([&nbCallbacks]() { ++nbCallbacks; });
+
+    m_scheduler->updateEngines();
+    checkEngines(3, 1);
+    EXPECT_GT(nbCallbacks, 0);
+}
+
+} // namespace
+
+} // namespace sofa
@@ -0,0 +1,245 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <MultiThreading/ParallelSubtreeVisitorScheduler.h>
+
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaBaseMechanics/UniformMass.h>
+#include <SofaBaseLinearSolver/DefaultMultiMatrixAccessor.h>
+#include <SofaBaseLinearSolver/FullMatrix.h>
+#include <sofa/simulation/MechanicalOperations.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalComputeEnergyVisitor.h>
+#include <sofa/simulation/mechanicalvisitor/MechanicalGetDimensionVisitor.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/Node.h>
+#include <sofa/core/MechanicalParams.h>
+#include <SofaSimulationGraph/SimpleApi.h>
+
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest;
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace sofa
+{
+
+namespace
+{
+
+using MechanicalObject3 = component::container::MechanicalObject<defaulttype::Vec3Types>;
+using UniformMass3 = component::mass::UniformMass<defaulttype::Vec3Types, SReal>;
+
+/// Mass counting how many masses compute a contribution at the same time.
+/// Each mass waits a little for the others, so that the contributions computed concurrently overlap.
+class RecordingMass : public UniformMass3
+{
+public:
+    SOFA_CLASS(RecordingMass, UniformMass3);
+
+    void addForce(const core::MechanicalParams* mparams, DataVecDeriv& f, const DataVecCoord& x, const DataVecDeriv& v) override
+    {
+        meet();
+        Inherit1::addForce(mparams, f, x, v);
+    }
+
+    void addMToMatrix(const core::MechanicalParams* mparams, const core::behavior::MultiMatrixAccessor* matrix) override
+    {
+        meet();
+        Inherit1::addMToMatrix(mparams, matrix);
+    }
+
+    SReal getKineticEnergy(const core::MechanicalParams* mparams, const DataVecDeriv& v) const override
+    {
+        meet();
+        return Inherit1::getKineticEnergy(mparams, v);
+    }
+
+    /// Maximum number of masses computing a contribution at the same time, since the last reset
+    static int maxOverlap()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        return s_maxInside;
+    }
+
+    static void resetOverlap()
+    {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        s_maxInside = 0;
+    }
+
+private:
+    static void meet()
+    {
+        std::unique_lock<std::mutex> lock(s_mutex);
+        s_maxInside = std::max(s_maxInside, ++s_nbInside);
+        s_condition.notify_all();
+        s_condition.wait_for(lock, std::chrono::milliseconds(100), [] { return s_maxInside > 1; });
+        --s_nbInside;
+    }
+
+    static inline std::mutex s_mutex;
+    static inline std::condition_variable s_condition;
+    static inline int s_nbInside { 0 };
+    static inline int s_maxInside { 0 };
+};
+
+struct ParallelSubtreeVisitorScheduler_test : public BaseTest
+{
+    simulation::Simulation::SPtr m_simulation;
+
+    void onSetUp() override
+    {
+        simulation::TaskScheduler::getInstance()->init(4);
+        m_simulation = simpleapi::createSimulation("DAG");
+    }
+
+    void onTearDown() override
+    {
+        simulation::TaskScheduler::getInstance()->stop();
+    }
+
+    /// Sub-graph made of a mechanical state and of its mass
+    static void addSubGraph(simulation::Node* parent, const std::string& name, std::size_t nbParticles, SReal totalMass)
+    {
+        auto node = parent->createChild(name);
+
+        auto dofs = core::objectmodel::New<MechanicalObject3>();
+        dofs->resize(nbParticles);
+        {
+            auto v = sofa::helper::getWriteOnlyAccessor(*dofs->write(core::VecDerivId::velocity()));
+            for (std::size_t i = 0; i < nbParticles; ++i)
+                v[i] = defaulttype::Vec3Types::Deriv(SReal(i), totalMass, 1);
+        }
+        node->addObject(dofs);
+
+        auto mass = core::objectmodel::New<RecordingMass>();
+        mass->d_totalMass.setValue(totalMass);
+        node->addObject(mass);
+    }
+
+    /// Root node with two independent sub-graphs, of different sizes and masses
+    simulation::Node::SPtr createScene(bool parallel)
+    {
+        auto root = simpleapi::createRootNode(m_simulation, "root");
+        root->setGravity(defaulttype::Vec3Types::Deriv(0, -10, 0));
+        if (parallel)
+            root->addObject(core::objectmodel::New<simulation::ParallelSubtreeVisitorScheduler>());
+
+        addSubGraph(root.get(), "A", 5, 1);
+        addSubGraph(root.get(), "B", 3, 6);
+
+        m_simulation->init(root.get());
+        return root;
+    }
+
+    /// Assemble the mass matrix of the scene
+    static void assemble(simulation::Node* root, component::linearsolver::FullMatrix<SReal>& matrix, sofa::Size& nbRow, sofa::Size& nbCol)
+    {
+        core::MechanicalParams mparams;
+        simulation::common::MechanicalOperations mops(&mparams, root);
+
+        component::linearsolver::DefaultMultiMatrixAccessor accessor;
+        accessor.setGlobalMatrix(&matrix);
+        nbRow = nbCol = 0;
+        mops.getMatrixDimension(&nbRow, &nbCol, &accessor);
+        accessor.setupMatrices();
+        matrix.resize(accessor.getGlobalDimension(), accessor.getGlobalDimension());
+        matrix.clear();
+        mops.addMBK_ToMatrix(&accessor, 1, 0, 0);
+        accessor.computeGlobalMatrix();
+    }
+};
+
+TEST_F(ParallelSubtreeVisitorScheduler_test, matrixAssembly)
+{
+    const auto serial = createScene(false);
+    sofa::Size serialNbRow, serialNbCol;
+    component::linearsolver::FullMatrix<SReal> serialMatrix;
+    assemble(serial.get(), serialMatrix, serialNbRow, serialNbCol);
+    ASSERT_EQ(serialNbRow, 24u);
+    ASSERT_EQ(serialNbCol, 24u);
+
+    const auto parallel = createScene(true);
+    RecordingMass::resetOverlap();
+    for (int it = 0; it < 5; ++it)
+    {
+        SReal dimension = 0;
+        simulation::mechanicalvisitor::MechanicalGetDimensionVisitor(core::mechanicalparams::defaultInstance(), &dimension).execute(parallel.get());
+        EXPECT_EQ(dimension, SReal(24));
+
+        sofa::Size nbRow, nbCol;
+        component::linearsolver::FullMatrix<SReal> matrix;
+        assemble(parallel.get(), matrix, nbRow, nbCol);
+        EXPECT_EQ(nbRow, serialNbRow);
+        EXPECT_EQ(nbCol, serialNbCol);
+        ASSERT_EQ(matrix.rowSize(), serialMatrix.rowSize());
+        for (int i = 0; i < matrix.rowSize(); ++i)
+            for (int j = 0; j < matrix.colSize(); ++j)
+                EXPECT_EQ(matrix.element(i, j), serialMatrix.element(i, j)) << "(" << i << ", " << j << ")";
+    }
+
+    // the assembly fills a shared matrix: the sub-graphs are not traversed concurrently
+    EXPECT_EQ(RecordingMass::maxOverlap(), 1);
+}
+
+TEST_F(ParallelSubtreeVisitorScheduler_test, energyAndForces)
+{
+    const auto serial = createScene(false);
+    const auto parallel = createScene(true);
+
+    simulation::mechanicalvisitor::MechanicalComputeEnergyVisitor serialEnergy(core::mechanicalparams::defaultInstance());
+    serialEnergy.execute(serial.get());
+    EXPECT_GT(serialEnergy.getKineticEnergy(), 0);
+
+    RecordingMass::resetOverlap();
+    for (int it = 0; it < 5; ++it)
+    {
+        simulation::mechanicalvisitor::MechanicalComputeEnergyVisitor energy(core::mechanicalparams::defaultInstance());
+        energy.execute(parallel.get());
+        EXPECT_DOUBLE_EQ(energy.getKineticEnergy(), serialEnergy.getKineticEnergy());
+        EXPECT_DOUBLE_EQ(energy.getPotentialEnergy(), serialEnergy.getPotentialEnergy());
+    }
+
+    // the energy is reduced over the graph: the sub-graphs are not traversed concurrently
+    EXPECT_EQ(RecordingMass::maxOverlap(), 1);
+
+    // the forces are accumulated in parallel, each mass adding its weight to its own state
+    core::MechanicalParams mparams;
+    simulation::common::MechanicalOperations mops(&mparams, parallel.get());
+    RecordingMass::resetOverlap();
+    mops.computeForce(core::VecDerivId::force());
+    EXPECT_EQ(RecordingMass::maxOverlap(), 2);
+
+    for (const auto& [name, totalMass] : { std::make_pair("A", SReal(1)), std::make_pair("B", SReal(6)) })
+    {
+        auto* dofs = dynamic_cast<MechanicalObject3*>(parallel->getChild(name)->getMechanicalState());
+        ASSERT_NE(dofs, nullptr);
+        const auto& f = dofs->read(core::ConstVecDerivId::force())->getValue();
+        for (const auto& fi : f)
+            EXPECT_DOUBLE_EQ(fi[1], -10 * totalMass / SReal(f.size()));
+    }
+}
+
+} // namespace
+
+} // namespace sofa
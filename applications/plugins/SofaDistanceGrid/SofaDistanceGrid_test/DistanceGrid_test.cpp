@@ -27,6 +27,12 @@ using sofa::Sofa_test ;
 #include <SofaDistanceGrid/DistanceGrid.h>
 using sofa::component::container::DistanceGrid ;
 
+#include <sofa/helper/system/FileRepository.h>
+using sofa::helper::system::DataRepository ;
+
+#include <sofa/simulation/TaskScheduler.h>
+using sofa::simulation::TaskScheduler ;
+
 namespace sofa
 {
 namespace component
@@ -74,6 +80,104 @@ struct DistanceGrid_test : public Sofa_test<SReal>
                           DistanceGrid::Coord(mx,my,mz),
                           DistanceGrid::Coord(ex,ey,ez)) ;
     }
+
+    void checkCubeFromMesh(SReal narrowBand){
+        std::string filename = "mesh/cube.obj";
+        ASSERT_TRUE(DataRepository.findFile(filename)) ;
+
+        DistanceGrid* grid = DistanceGrid::load(filename, 1.0, 0.0, 32, 32, 32,
+                                                DistanceGrid::Coord(), DistanceGrid::Coord(), narrowBand) ;
+        ASSERT_NE(grid, nullptr) ;
+
+        const SReal tolerance = 1.5*grid->getCellWidth()[0] ;
+
+        // center of the cube
+        EXPECT_NEAR(grid->interp(Vector3(0,0,0)),
+                    narrowBand > 0 ? std::max(-1.0, -narrowBand) : -1.0, tolerance) ;
+        // close to the faces
+        EXPECT_NEAR(grid->interp(Vector3(0.8,0,0)), -0.2, tolerance) ;
+        EXPECT_NEAR(grid->interp(Vector3(0,1.1,0)), 0.1, tolerance) ;
+        EXPECT_NEAR(grid->interp(Vector3(0,0,-1.15)), 0.15, tolerance) ;
+        // the gradient points outside
+        EXPECT_GT(grid->grad(Vector3(0.9,0,0))[0], 0.0) ;
+        EXPECT_LT(grid->grad(Vector3(0,-0.9,0))[1], 0.0) ;
+
+        grid->release() ;
+    }
+
+    void checkNarrowBandMemory(){
+        // the grid of "#cube" only has a small margin around the cube: a thin band leaves its inside and outside blocks as tiles
+        DistanceGrid* dense = DistanceGrid::load("#cube", 1.0, 0.0, 128, 128, 128) ;
+        DistanceGrid* sparse = DistanceGrid::load("#cube", 1.0, 0.0, 128, 128, 128,
+                                                  DistanceGrid::Coord(), DistanceGrid::Coord(), 0.05) ;
+        ASSERT_NE(dense, nullptr) ;
+        ASSERT_NE(sparse, nullptr) ;
+
+        EXPECT_LT(sparse->getMemorySize(), dense->getMemorySize()/2) ;
+
+        // values inside of the band are unchanged, the other ones are clamped
+        EXPECT_NEAR(sparse->interp(Vector3(0.98,0,0)), dense->interp(Vector3(0.98,0,0)), 1e-6) ;
+        EXPECT_NEAR(sparse->interp(Vector3(0,1.02,0)), dense->interp(Vector3(0,1.02,0)), 1e-6) ;
+        EXPECT_NEAR(sparse->interp(Vector3(0,0,0)), -0.05, 1e-6) ;
+        EXPECT_NEAR(sparse->interp(Vector3(1.15,1.15,1.15)), 0.05, 1e-6) ;
+
+        dense->release() ;
+        sparse->release() ;
+    }
+
+    void checkMeshNarrowBandMemory(){
+        std::string filename = "mesh/cube.obj";
+        ASSERT_TRUE(DataRepository.findFile(filename)) ;
+
+        DistanceGrid* sparse = DistanceGrid::load(filename, 1.0, 0.0, 128, 128, 128,
+                                                  DistanceGrid::Coord(), DistanceGrid::Coord(), 0.05) ;
+        DistanceGrid* sampled = DistanceGrid::load(filename, 1.0, -2.0, 128, 128, 128,
+                                                   DistanceGrid::Coord(), DistanceGrid::Coord(), 0.05) ;
+        ASSERT_NE(sparse, nullptr) ;
+        ASSERT_NE(sampled, nullptr) ;
+
+        const std::size_t sparseMemory = sparse->getMemorySize() ;
+        EXPECT_LT(sparseMemory, 128*128*128*sizeof(SReal)/2) ;
+
+        // sampling the surface reads the grid without allocating the compressed blocks
+        EXPECT_FALSE(sampled->meshPts.empty()) ;
+        EXPECT_EQ(sampled->getMemorySize(), sparseMemory) ;
+        sparse->sampleSurface(0.1) ;
+        EXPECT_EQ(sparse->getMemorySize(), sparseMemory) ;
+
+        sparse->release() ;
+        sampled->release() ;
+    }
+
+    static std::vector<SReal> sampleGrid(DistanceGrid* grid){
+        std::vector<SReal> values ;
+        for (SReal x=-1.2; x<=1.2; x+=0.15)
+            for (SReal y=-1.2; y<=1.2; y+=0.15)
+                for (SReal z=-1.2; z<=1.2; z+=0.15)
+                    values.push_back(grid->interp(Vector3(x,y,z))) ;
+        return values ;
+    }
+
+    void checkParallelSweeping(){
+        std::string filename = "mesh/cube.obj";
+        ASSERT_TRUE(DataRepository.findFile(filename)) ;
+
+        // the loaded grids are shared: the serial one is released before loading the parallel one
+        DistanceGrid* serial = DistanceGrid::load(filename, 1.0, 0.0, 64, 64, 64) ;
+        ASSERT_NE(serial, nullptr) ;
+        const std::vector<SReal> serialValues = sampleGrid(serial) ;
+        serial->release() ;
+
+        TaskScheduler::getInstance()->init(4) ;
+        DistanceGrid* parallel = DistanceGrid::load(filename, 1.0, 0.0, 64, 64, 64) ;
+        ASSERT_NE(parallel, nullptr) ;
+        const std::vector<SReal> parallelValues = sampleGrid(parallel) ;
+        parallel->release() ;
+        TaskScheduler::getInstance()->stop() ;
+
+        // the blocks of a color are independent: the result does not depend on the threads
+        EXPECT_EQ(serialValues, parallelValues) ;
+    }
 };
 
 TEST_F(DistanceGrid_test, chekcValidConstructorsCube) {
@@ -97,6 +201,25 @@ TEST_F(DistanceGrid_test, chekcInvalidConstructorsCube) {
     }
 }
 
+TEST_F(DistanceGrid_test, checkCubeFromMesh) {
+    ASSERT_NO_THROW(this->checkCubeFromMesh(0.0)) ;
+}
+
+TEST_F(DistanceGrid_test, checkCubeFromMeshNarrowBand) {
+    ASSERT_NO_THROW(this->checkCubeFromMesh(0.3)) ;
+}
+
+TEST_F(DistanceGrid_test, checkNarrowBandMemory) {
+    ASSERT_NO_THROW(this->checkNarrowBandMemory()) ;
+}
+
+TEST_F(DistanceGrid_test, checkMeshNarrowBandMemory) {
+    ASSERT_NO_THROW(this->checkMeshNarrowBandMemory()) ;
+}
+
+TEST_F(DistanceGrid_test, checkParallelSweeping) {
+    ASSERT_NO_THROW(this->checkParallelSweeping()) ;
+}
 
 } // __distance_grid__
 } // container
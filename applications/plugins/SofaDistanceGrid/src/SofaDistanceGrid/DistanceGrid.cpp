@@ -32,10 +32,11 @@
 
 #include <fstream>
 #include <sstream>
+#include <deque>
+#include <atomic>
 
 #include <sofa/helper/logging/Messaging.h>
-
-#define FMM_VERBOSE false
+#include <sofa/simulation/ParallelForRange.h>
 
 namespace sofa
 {
@@ -84,7 +85,8 @@ DistanceGrid::DistanceGrid(int nx, int ny, int nz, Coord pmin, Coord pmax)
     , m_nbRef(1)
     , m_nx(validateDim(nx)), m_ny(validateDim(ny)), m_nz(validateDim(nz))
     , m_nxny(m_nx*m_ny), m_nxnynz(m_nx*m_ny*m_nz)
-    , m_dists(m_nx*m_ny*m_nz)
+    , m_dists(m_nx, m_ny, m_nz)
+    , m_narrowBand(0)
     , m_pmin(pmin), m_pmax(pmax)
     , m_cellWidth   (calcCellWidth(m_nx,m_ny,m_nz,pmin,pmax))
     , m_invCellWidth(calcInvCellWidth(m_nx,m_ny,m_nz,pmin,pmax))
@@ -120,7 +122,8 @@ bool DistanceGrid::release()
 //todo(dmarchal) we should make a loader for that...
 DistanceGrid* DistanceGrid::load(const std::string& filename,
                                  double scale, double sampling,
-                                 int nx, int ny, int nz, Coord pmin, Coord pmax)
+                                 int nx, int ny, int nz, Coord pmin, Coord pmax,
+                                 SReal narrowBand)
 {
     double absscale=fabs(scale);
     if (filename == "#cube")
@@ -146,6 +149,7 @@ DistanceGrid* DistanceGrid::load(const std::string& filename,
         }
         DistanceGrid* grid = new DistanceGrid(nx, ny, nz, pmin, pmax);
         grid->calcCubeDistance(dim, np);
+        grid->compress(narrowBand);
         if (sampling)
             grid->sampleSurface(sampling);
         return grid;
@@ -154,12 +158,15 @@ DistanceGrid* DistanceGrid::load(const std::string& filename,
     {
         DistanceGrid* grid = new DistanceGrid(nx, ny, nz, pmin, pmax);
         std::ifstream in(filename.c_str(), std::ios::in | std::ios::binary);
-        in.read((char*)&(grid->m_dists[0]), grid->m_nxnynz*sizeof(SReal));
+        VecSReal values(grid->m_nxnynz);
+        in.read((char*)&(values[0]), grid->m_nxnynz*sizeof(SReal));
         if (scale != 1.0)
         {
             for (int i=0; i< grid->m_nxnynz; i++)
-                grid->m_dists[i] *= (float)scale;
+                values[i] *= (float)scale;
         }
+        grid->setValues(values);
+        grid->compress(narrowBand);
         grid->computeBBox();
         if (sampling)
             grid->sampleSurface(sampling);
@@ -167,7 +174,10 @@ DistanceGrid* DistanceGrid::load(const std::string& filename,
     }
     else if (filename.length()>4 && filename.substr(filename.length()-4) == ".vtk")
     {
-        return loadVTKFile(filename, scale, sampling);
+        DistanceGrid* grid = loadVTKFile(filename, scale, sampling);
+        if (grid)
+            grid->compress(narrowBand);
+        return grid;
     }
     else if (filename.length()>6 && filename.substr(filename.length()-6) == ".fmesh")
     {
@@ -193,7 +203,8 @@ DistanceGrid* DistanceGrid::load(const std::string& filename,
         pmax = Coord(fpmax.ptr());
         DistanceGrid* grid = new DistanceGrid(nx, ny, nz, pmin, pmax);
         for (int i=0; i< grid->m_nxnynz; i++)
-            grid->m_dists[i] = mesh.distmap->data[i]*scale;
+            (*grid)[i] = mesh.distmap->data[i]*scale;
+        grid->compress(narrowBand);
         if (sampling)
             grid->sampleSurface(sampling);
         else if (mesh.getAttrib(flowvr::render::Mesh::MESH_POINTS_GROUP))
@@ -270,6 +281,7 @@ DistanceGrid* DistanceGrid::load(const std::string& filename,
             }
         }
         DistanceGrid* grid = new DistanceGrid(nx, ny, nz, pmin, pmax);
+        grid->setNarrowBand(narrowBand);
         grid->calcDistance(mesh, scale);
         if (sampling)
             grid->sampleSurface(sampling);
@@ -296,7 +308,12 @@ bool DistanceGrid::save(const std::string& filename)
     if (filename.length()>4 && filename.substr(filename.length()-4) == ".raw")
     {
         std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
-        out.write((char*)&(m_dists[0]), m_nxnynz*sizeof(SReal));
+        VecSReal values(m_nxnynz);
+        for (int z=0, i=0; z<m_nz; z++)
+            for (int y=0; y<m_ny; y++)
+                for (int x=0; x<m_nx; x++, i++)
+                    values[i] = m_dists.get(x,y,z);
+        out.write((char*)&(values[0]), m_nxnynz*sizeof(SReal));
     }
     else
     {
@@ -423,17 +440,18 @@ DistanceGrid* DistanceGrid::loadVTKFile(const std::string& filename, double scal
             std::getline(inVTKFile, line); // lookup_table, ignore
             msg_info("DistanceGrid")<< "Loading " << nx<<"x"<<ny<<"x"<<nz << " volume...";
             DistanceGrid* grid = new DistanceGrid(nx, ny, nz, origin, origin + Coord(spacing[0] * nx, spacing[1] * ny, spacing[2]*nz));
+            VecSReal values(dataSize);
             bool ok = true;
-            if (typestr == "char") ok = readData<char>(inVTKFile, dataSize, binary, grid->m_dists, scale);
-            else if (typestr == "unsigned_char") ok = readData<unsigned char>(inVTKFile, dataSize, binary, grid->m_dists, scale);
-            else if (typestr == "short") ok = readData<short>(inVTKFile, dataSize, binary, grid->m_dists, scale);
-            else if (typestr == "unsigned_short") ok = readData<unsigned short>(inVTKFile, dataSize, binary, grid->m_dists, scale);
-            else if (typestr == "int") ok = readData<int>(inVTKFile, dataSize, binary, grid->m_dists, scale);
-            else if (typestr == "unsigned_int") ok = readData<unsigned int>(inVTKFile, dataSize, binary, grid->m_dists, scale);
-            else if (typestr == "long") ok = readData<long long>(inVTKFile, dataSize, binary, grid->m_dists, scale);
-            else if (typestr == "unsigned_long") ok = readData<unsigned long long>(inVTKFile, dataSize, binary, grid->m_dists, scale);
-            else if (typestr == "float") ok = readData<float>(inVTKFile, dataSize, binary, grid->m_dists, scale);
-            else if (typestr == "double") ok = readData<double>(inVTKFile, dataSize, binary, grid->m_dists, scale);
+            if (typestr == "char") ok = readData<char>(inVTKFile, dataSize, binary, values, scale);
+            else if (typestr == "unsigned_char") ok = readData<unsigned char>(inVTKFile, dataSize, binary, values, scale);
+            else if (typestr == "short") ok = readData<short>(inVTKFile, dataSize, binary, values, scale);
+            else if (typestr == "unsigned_short") ok = readData<unsigned short>(inVTKFile, dataSize, binary, values, scale);
+            else if (typestr == "int") ok = readData<int>(inVTKFile, dataSize, binary, values, scale);
+            else if (typestr == "unsigned_int") ok = readData<unsigned int>(inVTKFile, dataSize, binary, values, scale);
+            else if (typestr == "long") ok = readData<long long>(inVTKFile, dataSize, binary, values, scale);
+            else if (typestr == "unsigned_long") ok = readData<unsigned long long>(inVTKFile, dataSize, binary, values, scale);
+            else if (typestr == "float") ok = readData<float>(inVTKFile, dataSize, binary, values, scale);
+            else if (typestr == "double") ok = readData<double>(inVTKFile, dataSize, binary, values, scale);
             else
             {
                 msg_error("DistanceGrid")<< "Invalid type " << typestr;
@@ -444,6 +462,8 @@ DistanceGrid* DistanceGrid::loadVTKFile(const std::string& filename, double scal
                 delete grid;
                 return NULL;
             }
+            values.resize(grid->m_nxnynz);
+            grid->setValues(values);
             msg_info("DistanceGrid")<< "Volume data loading OK.";
             grid->computeBBox();
             if (sampling)
@@ -572,9 +592,9 @@ void DistanceGrid::calcCubeDistance(SReal dim, int np)
 
     SReal dim2 = dim; //*0.75f; // add some 'roundness' to the cubes corner
 
-    for (int i=0,z=0; z<m_nz; z++)
+    for (int z=0; z<m_nz; z++)
         for (int y=0; y<m_ny; y++)
-            for (int x=0; x<m_nx; x++,i++)
+            for (int x=0; x<m_nx; x++)
             {
                 Coord p = coord(x,y,z);
                 Coord s = p;
@@ -589,28 +609,124 @@ void DistanceGrid::calcCubeDistance(SReal dim, int np)
                     d = (p - s).norm();
                 else
                     d = rmax(rmax(rabs(s[0]),rabs(s[1])),rabs(s[2])) - dim2;
-                m_dists[i] = d - (dim-dim2);
+                m_dists.ref(x,y,z) = d - (dim-dim2);
             }
     m_bbmin = Coord(-dim,-dim,-dim);
     m_bbmax = Coord( dim, dim, dim);
 }
 
+void DistanceGrid::setValues(const VecSReal& values)
+{
+    for (int z=0, i=0; z<m_nz; z++)
+        for (int y=0; y<m_ny; y++)
+            for (int x=0; x<m_nx; x++, i++)
+                m_dists.ref(x,y,z) = values[i];
+}
+
+void DistanceGrid::compress(SReal narrowBand)
+{
+    m_narrowBand = narrowBand;
+    if (narrowBand <= 0)
+        return;
+
+    const std::size_t memBefore = m_dists.getMemorySize();
+    const int nbBlocks = m_dists.getNbBlocks();
+    for (int b=0; b<nbBlocks; ++b)
+    {
+        if (!m_dists.isAllocated(b))
+        {
+            const SReal tile = m_dists.getTile(b);
+            if (tile < -narrowBand) m_dists.setTile(b, -narrowBand);
+            else if (tile > narrowBand) m_dists.setTile(b, narrowBand);
+            continue;
+        }
+        SReal* values = m_dists.getBlockData(b);
+        bool allIn = true, allOut = true;
+        for (int i=0; i<SparseBlockGrid<SReal>::BlockVolume; ++i)
+        {
+            if (values[i] <= -narrowBand) { values[i] = -narrowBand; allOut = false; }
+            else if (values[i] >= narrowBand) { values[i] = narrowBand; allIn = false; }
+            else { allIn = false; allOut = false; }
+        }
+        if (allIn) m_dists.setTile(b, -narrowBand);
+        else if (allOut) m_dists.setTile(b, narrowBand);
+    }
+    m_dists.compact();
+    msg_info("DistanceGrid")<< "Narrow band " << narrowBand << ": " << m_dists.getNbAllocatedBlocks() << "/" << nbBlocks
+                            << " blocks allocated, memory " << memBefore << " -> " << m_dists.getMemorySize() << " bytes.";
+}
+
+namespace
+{
+
+bool pointInTriangleAxis(int axis, const Coord& p, const Coord& p0, const Coord& p1, const Coord& p2)
+{
+    switch (axis)
+    {
+    case 0: return pointInTriangle<1,2>(p,p0,p1,p2);
+    case 1: return pointInTriangle<2,0>(p,p0,p1,p2);
+    default: return pointInTriangle<0,1>(p,p0,p1,p2);
+    }
+}
+
+} // namespace
+
 /// Compute distance field from given mesh
 void DistanceGrid::calcDistance(sofa::helper::io::Mesh* mesh, double scale)
 {
-    m_fmm_status.resize(m_nxnynz);
-    m_fmm_heap.resize(m_nxnynz);
-    m_fmm_heap_size = 0;
-    dmsg_info("DistanceGrid")<< "FMM: Init.";
+    dmsg_info("DistanceGrid")<< "FSM: Init.";
 
-    std::fill(m_fmm_status.begin(), m_fmm_status.end(), FMM_FAR);
-    std::fill(m_dists.begin(), m_dists.end(), maxDist());
+    m_dists.fill(maxDist());
+    m_fsm_status.resize(m_nx, m_ny, m_nz, FSM_FAR);
 
     const auto& vertices = mesh->getVertices();
     const auto& facets = mesh->getFacets();
 
+    // Allocate the blocks of the grid: all of them, or only the ones close to the surface
+    if (m_narrowBand > 0)
+    {
+        const Coord margin(m_narrowBand + 2*m_cellWidth[0], m_narrowBand + 2*m_cellWidth[1], m_narrowBand + 2*m_cellWidth[2]);
+        for (unsigned int i=0; i<facets.size(); i++)
+        {
+            const auto& pts = facets[i][0];
+            if (pts.empty()) continue;
+            Coord bbmin = vertices[pts[0]]*scale, bbmax = bbmin;
+            for (unsigned int p=1; p<pts.size(); p++)
+            {
+                const Coord v = vertices[pts[p]]*scale;
+                for (int c=0; c<3; c++)
+                    if (v[c] < bbmin[c]) bbmin[c] = v[c];
+                    else if (v[c] > bbmax[c]) bbmax[c] = v[c];
+            }
+            bbmin = clamp(bbmin - margin);
+            bbmax = clamp(bbmax + margin);
+            const int bx0 = std::max(ix(bbmin), 0) >> SparseBlockGrid<SReal>::BlockBits;
+            const int by0 = std::max(iy(bbmin), 0) >> SparseBlockGrid<SReal>::BlockBits;
+            const int bz0 = std::max(iz(bbmin), 0) >> SparseBlockGrid<SReal>::BlockBits;
+            const int bx1 = std::min(ix(bbmax), m_nx-1) >> SparseBlockGrid<SReal>::BlockBits;
+            const int by1 = std::min(iy(bbmax), m_ny-1) >> SparseBlockGrid<SReal>::BlockBits;
+            const int bz1 = std::min(iz(bbmax), m_nz-1) >> SparseBlockGrid<SReal>::BlockBits;
+            for (int bz=bz0; bz<=bz1; bz++)
+                for (int by=by0; by<=by1; by++)
+                    for (int bx=bx0; bx<=bx1; bx++)
+                    {
+                        const int b = bx + m_dists.getNbBlocksX()*(by + m_dists.getNbBlocksY()*bz);
+                        m_dists.allocateBlock(b);
+                        m_fsm_status.allocateBlock(b);
+                    }
+        }
+    }
+    else
+    {
+        for (int b=0; b<m_dists.getNbBlocks(); ++b)
+        {
+            m_dists.allocateBlock(b);
+            m_fsm_status.allocateBlock(b);
+        }
+    }
+
     // Initialize distance of edges crossing triangles
-    dmsg_info("DistanceGrid")<< "FMM: Initialize distance of edges crossing triangles.";
+    dmsg_info("DistanceGrid")<< "FSM: Initialize distance of edges crossing triangles.";
 
     for (unsigned int i=0; i<facets.size(); i++)
     {
@@ -633,7 +749,6 @@ void DistanceGrid::calcDistance(sofa::helper::io::Mesh* mesh, double scale)
             Coord normal = (p1-p0).cross(p2-p0);
             normal.normalize();
             SReal d = -(p0*normal);
-            int nedges = 0;
             int ix0 = ix(bbmin)-1; if (ix0 < 0) ix0 = 0;
             int iy0 = iy(bbmin)-1; if (iy0 < 0) iy0 = 0;
             int iz0 = iz(bbmin)-1; if (iz0 < 0) iz0 = 0;
@@ -645,504 +760,258 @@ void DistanceGrid::calcDistance(sofa::helper::io::Mesh* mesh, double scale)
                     for (int x=ix0; x<ix1; x++)
                     {
                         Coord pos = coord(x,y,z);
-                        int ind = index(x,y,z);
                         SReal dist = pos*normal + d;
-                        //if (rabs(dist) > cellWidth) continue; // no edge from this point can cross the plane
-
-                        // X edge
-                        if (rabs(normal[0]) > 1e-6)
+                        for (int axis=0; axis<3; axis++)
                         {
-                            SReal dist1 = -dist / normal[0];
-                            int ind2 = ind+1;
-                            if (dist1 >= -0.01*m_cellWidth[0] && dist1 <= 1.01*m_cellWidth[0])
+                            if (rabs(normal[axis]) <= 1e-6) continue;
+                            SReal dist1 = -dist / normal[axis];
+                            if (dist1 < -0.01*m_cellWidth[axis] || dist1 > 1.01*m_cellWidth[axis]) continue; // edge does not cross the plane
+                            if (!pointInTriangleAxis(axis,pos,p0,p1,p2)) continue;
+
+                            // edge crossed triangle
+                            SReal dist2 = m_cellWidth[axis] - dist1;
+                            const int x2 = (axis==0) ? x+1 : x;
+                            const int y2 = (axis==1) ? y+1 : y;
+                            const int z2 = (axis==2) ? z+1 : z;
+                            if (normal[axis]<0)
                             {
-                                // edge crossed plane
-                                if (pointInTriangle<1,2>(pos,p0,p1,p2))
-                                {
-                                    // edge crossed triangle
-                                    ++nedges;
-                                    SReal dist2 = m_cellWidth[0] - dist1;
-                                    if (normal[0]<0)
-                                    {
-                                        // p1 is in outside, p2 inside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_OUT;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_IN;
-                                        }
-                                    }
-                                    else
-                                    {
-                                        // p1 is in inside, p2 outside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_IN;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_OUT;
-                                        }
-                                    }
-                                }
+                                // p1 is in outside, p2 inside
+                                fsm_seed(x,y,z,dist1,FSM_OUT);
+                                fsm_seed(x2,y2,z2,dist2,FSM_IN);
                             }
-                        }
-
-                        // Y edge
-                        if (rabs(normal[1]) > 1e-6)
-                        {
-                            SReal dist1 = -dist / normal[1];
-                            int ind2 = ind+m_nx;
-                            if (dist1 >= -0.01*m_cellWidth[1] && dist1 <= 1.01*m_cellWidth[1])
+                            else
                             {
-                                // edge crossed plane
-                                if (pointInTriangle<2,0>(pos,p0,p1,p2))
-                                {
-                                    // edge crossed triangle
-                                    ++nedges;
-                                    SReal dist2 = m_cellWidth[1] - dist1;
-                                    if (normal[1]<0)
-                                    {
-                                        // p1 is in outside, p2 inside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_OUT;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_IN;
-                                        }
-                                    }
-                                    else
-                                    {
-                                        // p1 is in inside, p2 outside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_IN;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_OUT;
-                                        }
-                                    }
-                                }
-                            }
-                        }
-
-                        // Z edge
-                        if (rabs(normal[2]) > 1e-6)
-                        {
-                            SReal dist1 = -dist / normal[2];
-                            int ind2 = ind+m_nxny;
-                            if (dist1 >= -0.01*m_cellWidth[2] && dist1 <= 1.01*m_cellWidth[2])
-                            {
-                                // edge crossed plane
-                                if (pointInTriangle<0,1>(pos,p0,p1,p2))
-                                {
-                                    // edge crossed triangle
-                                    ++nedges;
-                                    SReal dist2 = m_cellWidth[2] - dist1;
-                                    if (normal[2]<0)
-                                    {
-                                        // p1 is in outside, p2 inside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_OUT;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_IN;
-                                        }
-                                    }
-                                    else
-                                    {
-                                        // p1 is in inside, p2 outside
-                                        if (dist1 < (m_dists[ind]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind] = dist1;
-                                            m_fmm_status[ind] = FMM_KNOWN_IN;
-                                        }
-                                        if (dist2 < (m_dists[ind2]))
-                                        {
-                                            // nearest triangle
-                                            m_dists[ind2] = dist2;
-                                            m_fmm_status[ind2] = FMM_KNOWN_OUT;
-                                        }
-                                    }
-                                }
+                                // p1 is in inside, p2 outside
+                                fsm_seed(x,y,z,dist1,FSM_IN);
+                                fsm_seed(x2,y2,z2,dist2,FSM_OUT);
                             }
                         }
                     }
-         }
+        }
     }
 
-    // Update known points neighbors
-    for (int z=0, ind=0; z<m_nz; z++)
-        for (int y=0; y<m_ny; y++)
-            for (int x=0; x<m_nx; x++, ind++)
+    // Propagate the distances to the rest of the grid
+    dmsg_info("DistanceGrid")<< "FSM: Sweeping.";
+    fsm_propagate();
+
+    // Finalize distances
+    int nbin = 0;
+    const int nbBlocks = m_dists.getNbBlocks();
+    for (int b=0; b<nbBlocks; ++b)
+    {
+        if (!m_dists.isAllocated(b)) continue;
+        SReal* values = m_dists.getBlockData(b);
+        const char* status = m_fsm_status.getBlockData(b);
+        for (int i=0; i<SparseBlockGrid<SReal>::BlockVolume; ++i)
+        {
+            if (status[i] & FSM_IN)
             {
-                if (m_fmm_status[ind] < FMM_FAR)
+                values[i] = -values[i];
+                ++nbin;
+            }
+        }
+    }
+
+    // Blocks which are not allocated take the sign of the closest allocated blocks
+    if (m_narrowBand > 0)
+    {
+        const int nbx = m_dists.getNbBlocksX(), nby = m_dists.getNbBlocksY(), nbz = m_dists.getNbBlocksZ();
+        const int bs = SparseBlockGrid<SReal>::BlockSize;
+        helper::vector<int> sign(nbBlocks, 0);
+        std::deque<int> queue;
+        for (int bz=0, b=0; bz<nbz; bz++)
+            for (int by=0; by<nby; by++)
+                for (int bx=0; bx<nbx; bx++, b++)
                 {
-                    int ind2;
-                    SReal dist1 = m_dists[ind];
-                    SReal dist2 = dist1+m_cellWidth[0];
-                    // X-1
-                    if (x>0)
-                    {
-                        ind2 = ind-1;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
+                    if (m_dists.isAllocated(b)) continue;
+                    // sum the signs of the cells of the allocated neighbor blocks, along the shared faces
+                    SReal sum = 0;
+                    for (int axis=0; axis<3; axis++)
+                        for (int side=-1; side<=1; side+=2)
                         {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
-                    }
-                    // X+1
-                    if (x<m_nx-1)
-                    {
-                        ind2 = ind+1;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
-                    }
-                    dist2 = dist1+m_cellWidth[1];
-                    // Y-1
-                    if (y>0)
-                    {
-                        ind2 = ind-m_nx;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
-                    }
-                    // Y+1
-                    if (y<m_ny-1)
-                    {
-                        ind2 = ind+m_nx;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
-                    }
-                    dist2 = dist1+m_cellWidth[2];
-                    // Z-1
-                    if (z>0)
-                    {
-                        ind2 = ind-m_nxny;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
+                            int nb[3] = { bx, by, bz };
+                            nb[axis] += side;
+                            if (nb[axis] < 0 || nb[0] >= nbx || nb[1] >= nby || nb[2] >= nbz) continue;
+                            if (!m_dists.isAllocated(nb[0] + nbx*(nb[1] + nby*nb[2]))) continue;
+                            const int u = (axis+1)%3, v = (axis+2)%3;
+                            int c[3];
+                            c[axis] = (side < 0) ? nb[axis]*bs + bs-1 : nb[axis]*bs;
+                            for (int i=0; i<bs; i++)
+                                for (int j=0; j<bs; j++)
+                                {
+                                    c[u] = nb[u]*bs + i;
+                                    c[v] = nb[v]*bs + j;
+                                    if (c[0] >= m_nx || c[1] >= m_ny || c[2] >= m_nz) continue;
+                                    const SReal value = m_dists.get(c[0],c[1],c[2]);
+                                    if (value < maxDist() && value > -maxDist())
+                                        sum += (value < 0) ? -1 : 1;
+                                }
                         }
-                    }
-                    // Z+1
-                    if (z<m_nz-1)
+                    if (sum != 0)
                     {
-                        ind2 = ind+m_nxny;
-                        if (x>0 && m_fmm_status[ind2] >= FMM_FAR && (m_dists[ind2]) > dist2)
-                        {
-                            m_dists[ind2] = dist2;
-                            fmm_push(ind2);
-                        }
+                        sign[b] = (sum < 0) ? -1 : 1;
+                        queue.push_back(b);
                     }
                 }
-            }
-
-    // March through the heap
-    while (m_fmm_heap_size > 0)
-    {
-        int ind = fmm_pop();
-        int nbin = 0, nbout = 0;
-        int x = ind%m_nx;
-        int y = (ind/m_nx)%m_ny;
-        int z = ind/m_nxny;
-
-        int ind2;
-        SReal dist1 = m_dists[ind];
-        SReal dist2 = dist1+m_cellWidth[0];
-        // X-1
-        if (x>0)
+        while (!queue.empty())
         {
-            ind2 = ind-1;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
+            const int b = queue.front();
+            queue.pop_front();
+            const int bx = b%nbx, by = (b/nbx)%nby, bz = b/(nbx*nby);
+            const int neighbors[6][3] = { {bx-1,by,bz}, {bx+1,by,bz}, {bx,by-1,bz}, {bx,by+1,bz}, {bx,by,bz-1}, {bx,by,bz+1} };
+            for (const auto& nb : neighbors)
             {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
+                if (nb[0] < 0 || nb[1] < 0 || nb[2] < 0 || nb[0] >= nbx || nb[1] >= nby || nb[2] >= nbz) continue;
+                const int b2 = nb[0] + nbx*(nb[1] + nby*nb[2]);
+                if (m_dists.isAllocated(b2) || sign[b2] != 0) continue;
+                sign[b2] = sign[b];
+                queue.push_back(b2);
             }
         }
-        // X+1
-        if (x<m_nx-1)
+        for (int b=0; b<nbBlocks; ++b)
         {
-            ind2 = ind+1;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
-            }
+            if (sign[b] != 0)
+                m_dists.setTile(b, sign[b]*m_narrowBand);
         }
-        dist2 = dist1+m_cellWidth[1];
-        // Y-1
-        if (y>0)
-        {
-            ind2 = ind-m_nx;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
-            }
-        }
-        // Y+1
-        if (y<m_ny-1)
-        {
-            ind2 = ind+m_nx;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
-            }
-        }
-        dist2 = dist1+m_cellWidth[2];
-        // Z-1
-        if (z>0)
-        {
-            ind2 = ind-m_nxny;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
-            }
-        }
-        // Z+1
-        if (z<m_nz-1)
-        {
-            ind2 = ind+m_nxny;
-            if (m_fmm_status[ind2] < FMM_FAR)
-            {
-                if (m_fmm_status[ind2] == FMM_KNOWN_IN) ++nbin; else ++nbout;
-            }
-            else if ((m_dists[ind2]) > dist2)
-            {
-                m_dists[ind2] = dist2;
-                fmm_push(ind2); // create or update the corresponding entry in the heap
-            }
-        }
-        if (nbin && nbout)
-        {
-            msg_warning("DistanceGrid")<< "FMM WARNING: in/out conflict at cell "<<x<<" "<<y<<" "<<z<<" ( "<<nbin<<" in, "<<nbout<<" out), dist = "<<m_dists[ind];
-        }
-        if (nbin > nbout)
-            m_fmm_status[ind] = FMM_KNOWN_IN;
-        else
-            m_fmm_status[ind] = FMM_KNOWN_OUT;
+        compress(m_narrowBand);
     }
 
-    // Finalize distances
-    int nbin = 0;
-    for (int z=0, ind=0; z<m_nz; z++)
-        for (int y=0; y<m_ny; y++)
-            for (int x=0; x<m_nx; x++, ind++)
-            {
-                if (m_fmm_status[ind] == FMM_KNOWN_IN)
-                {
-                    m_dists[ind] = -m_dists[ind];
-                    ++nbin;
-                }
-                else if (m_fmm_status[ind] != FMM_KNOWN_OUT)
-                {
-                }
-            }
-    msg_info("DistanceGrid")<< "FMM: DONE. "<< nbin << " points inside ( " << (nbin*100)/size() <<" % )";
+    m_fsm_status.resize(0, 0, 0);
+    msg_info("DistanceGrid")<< "FSM: DONE. "<< nbin << " points inside ( " << (size() ? (nbin*100)/size() : 0) <<" % )";
 }
 
-inline void DistanceGrid::fmm_swap(int entry1, int entry2)
+void DistanceGrid::fsm_seed(int x, int y, int z, SReal dist, Status status)
 {
-    int ind1 = m_fmm_heap[entry1];
-    int ind2 = m_fmm_heap[entry2];
-    m_fmm_heap[entry1] = ind2;
-    m_fmm_heap[entry2] = ind1;
-    m_fmm_status[ind1] = entry2 + FMM_FRONT0;
-    m_fmm_status[ind2] = entry1 + FMM_FRONT0;
+    SReal& d = m_dists.ref(x,y,z);
+    if (dist < d)
+    {
+        // nearest triangle
+        d = dist;
+        m_fsm_status.ref(x,y,z) = (char)(status | FSM_FROZEN);
+    }
 }
 
-int DistanceGrid::fmm_pop()
+bool DistanceGrid::fsm_update(int x, int y, int z)
 {
-
-    int res = m_fmm_heap[0];
-
-    if(FMM_VERBOSE)
-        msg_info("DistanceGrid")<< "fmm_pop -> <"<<(res%m_nx)<<','<<((res/m_nx)%m_ny)<<','<<(res/m_nxny)<<">="<<m_dists[res];
-
-    --m_fmm_heap_size;
-    if (m_fmm_heap_size>0)
+    // smallest neighbor value along each axis
+    SReal a[3];
+    char s[3];
+    const int n[3] = { m_nx, m_ny, m_nz };
+    for (int c=0; c<3; c++)
     {
-        fmm_swap(0, m_fmm_heap_size);
-        int i=0;
-        SReal phi = (m_dists[m_fmm_heap[i]]);
-        while (i*2+1 < m_fmm_heap_size)
+        a[c] = maxDist();
+        s[c] = FSM_FAR;
+        for (int side=-1; side<=1; side+=2)
         {
-            SReal phi1 = (m_dists[m_fmm_heap[i*2+1]]);
-            if (i*2+2 < m_fmm_heap_size)
-            {
-                SReal phi2 = (m_dists[m_fmm_heap[i*2+2]]);
-                if (phi1 < phi)
-                {
-                    if (phi1 < phi2)
-                    {
-                        fmm_swap(i, i*2+1);
-                        i = i*2+1;
-                    }
-                    else
-                    {
-                        fmm_swap(i, i*2+2);
-                        i = i*2+2;
-                    }
-                }
-                else if (phi2 < phi)
-                {
-                    fmm_swap(i, i*2+2);
-                    i = i*2+2;
-                }
-                else break;
-            }
-            else if (phi1 < phi)
+            int p[3] = { x, y, z };
+            p[c] += side;
+            if (p[c] < 0 || p[c] >= n[c]) continue;
+            const SReal value = m_dists.get(p[0],p[1],p[2]);
+            if (value < a[c])
             {
-                fmm_swap(i, i*2+1);
-                i = i*2+1;
+                a[c] = value;
+                s[c] = m_fsm_status.get(p[0],p[1],p[2]);
             }
-            else break;
         }
     }
 
-    if(FMM_VERBOSE){
-        std::stringstream tmp;
-        tmp << "fmm_heap = [";
-        for (int i=0; i<m_fmm_heap_size; i++)
-            tmp << " <"<<(m_fmm_heap[i]%m_nx)<<','<<((m_fmm_heap[i]/m_nx)%m_ny)<<','<<(m_fmm_heap[i]/m_nxny)<<">="<<m_dists[m_fmm_heap[i]];
-        msg_info("DistanceGrid") << tmp.str() ;
+    // sort the axis by increasing neighbor value
+    int order[3] = { 0, 1, 2 };
+    if (a[order[1]] < a[order[0]]) std::swap(order[0], order[1]);
+    if (a[order[2]] < a[order[1]]) std::swap(order[1], order[2]);
+    if (a[order[1]] < a[order[0]]) std::swap(order[0], order[1]);
+
+    const SReal a0 = a[order[0]];
+    if (a0 >= maxDist())
+        return false; // no known neighbor
+
+    // Godunov upwind discretization of |grad d| = 1, solved with an increasing number of axis
+    SReal u = a0 + m_cellWidth[order[0]];
+    SReal sumW = 0, sumWA = 0, sumWA2 = 0;
+    for (int k=0; k<3; k++)
+    {
+        const int c = order[k];
+        if (k > 0 && u <= a[c]) break;
+        const SReal w = m_invCellWidth[c]*m_invCellWidth[c];
+        sumW += w;
+        sumWA += w*a[c];
+        sumWA2 += w*a[c]*a[c];
+        if (k > 0)
+        {
+            const SReal delta = sumWA*sumWA - sumW*(sumWA2-1);
+            if (delta < 0) break;
+            u = (sumWA + helper::rsqrt(delta))/sumW;
+        }
     }
 
-    return res;
+    SReal& d = m_dists.ref(x,y,z);
+    if (u >= d - 1e-6*m_cellWidth[0])
+        return false;
+    d = u;
+    m_fsm_status.ref(x,y,z) = (char)(s[order[0]] & (FSM_IN|FSM_OUT));
+    return true;
 }
 
-void DistanceGrid::fmm_push(int index)
+bool DistanceGrid::fsm_sweepBlock(int block)
 {
-    SReal phi = (m_dists[index]);
-    int i;
-    if (m_fmm_status[index] >= FMM_FRONT0)
+    const int bs = SparseBlockGrid<SReal>::BlockSize;
+    const int nbx = m_dists.getNbBlocksX(), nby = m_dists.getNbBlocksY();
+    const int x0 = (block%nbx)*bs, y0 = ((block/nbx)%nby)*bs, z0 = (block/(nbx*nby))*bs;
+    const int x1 = std::min(x0+bs, m_nx), y1 = std::min(y0+bs, m_ny), z1 = std::min(z0+bs, m_nz);
+    const char* status = m_fsm_status.getBlockData(block);
+
+    bool changed = false;
+    for (int sweep=0; sweep<8; sweep++)
     {
-        i = m_fmm_status[index] - FMM_FRONT0;
-
-        if(FMM_VERBOSE)
-           dmsg_info("DistanceGrid") << "fmm update <"<<(index%m_nx)<<','<<((index/m_nx)%m_ny)<<','<<(index/m_nxny)<<">="<<m_dists[index]<<" from entry "<<i ;
-
-        while (i>0 && phi < (m_dists[m_fmm_heap[(i-1)/2]]))
-        {
-            fmm_swap(i,(i-1)/2);
-            i = (i-1)/2;
-        }
-        while (i*2+1 < m_fmm_heap_size)
-        {
-            SReal phi1 = (m_dists[m_fmm_heap[i*2+1]]);
-            if (i*2+2 < m_fmm_heap_size)
-            {
-                SReal phi2 = (m_dists[m_fmm_heap[i*2+2]]);
-                if (phi1 < phi)
-                {
-                    if (phi1 < phi2)
-                    {
-                        fmm_swap(i, i*2+1);
-                        i = i*2+1;
-                    }
-                    else
-                    {
-                        fmm_swap(i, i*2+2);
-                        i = i*2+2;
-                    }
-                }
-                else if (phi2 < phi)
+        const int sx = (sweep&1) ? -1 : 1, sy = (sweep&2) ? -1 : 1, sz = (sweep&4) ? -1 : 1;
+        for (int z = (sz>0 ? z0 : z1-1); z>=z0 && z<z1; z+=sz)
+            for (int y = (sy>0 ? y0 : y1-1); y>=y0 && y<y1; y+=sy)
+                for (int x = (sx>0 ? x0 : x1-1); x>=x0 && x<x1; x+=sx)
                 {
-                    fmm_swap(i, i*2+2);
-                    i = i*2+2;
+                    if (status[SparseBlockGrid<char>::cellIndex(x,y,z)] & FSM_FROZEN) continue;
+                    changed |= fsm_update(x,y,z);
                 }
-                else break;
-            }
-            else if (phi1 < phi)
-            {
-                fmm_swap(i, i*2+1);
-                i = i*2+1;
-            }
-            else break;
-        }
     }
-    else
+    return changed;
+}
+
+void DistanceGrid::fsm_propagate()
+{
+    // Blocks are sorted in 8 colors such that two blocks of the same color never share a face.
+    // Sweeping a block only reads the values of its face neighbors, so the blocks of a color
+    // can be swept in parallel.
+    const int nbx = m_dists.getNbBlocksX(), nby = m_dists.getNbBlocksY(), nbz = m_dists.getNbBlocksZ();
+    helper::vector<int> colors[8];
+    for (int bz=0, b=0; bz<nbz; bz++)
+        for (int by=0; by<nby; by++)
+            for (int bx=0; bx<nbx; bx++, b++)
+                if (m_dists.isAllocated(b))
+                    colors[(bx&1) + 2*(by&1) + 4*(bz&1)].push_back(b);
+
+    // the blocks are swept in parallel only if the TaskScheduler was given threads
+    simulation::TaskScheduler* taskScheduler = simulation::TaskScheduler::getInstance();
+
+    const int maxIterations = 2*(nbx+nby+nbz) + 2;
+    int it = 0;
+    bool changed = true;
+    while (changed && it < maxIterations)
     {
-        if(FMM_VERBOSE)
-           dmsg_info("DistanceGrid") << "fmm push <"<<(index%m_nx)<<','<<((index/m_nx)%m_ny)<<','<<(index/m_nxny)<<">="<<m_dists[index] ;
-
-        i = m_fmm_heap_size;
-        ++m_fmm_heap_size;
-        m_fmm_heap[i] = index;
-        m_fmm_status[index] = i;
-        while (i>0 && phi < (m_dists[m_fmm_heap[(i-1)/2]]))
+        std::atomic<bool> sweepChanged { false };
+        ++it;
+        for (const auto& blocks : colors)
         {
-            fmm_swap(i,(i-1)/2);
-            i = (i-1)/2;
+            simulation::parallelForRange(taskScheduler, 0, blocks.size(), 1, [&](std::size_t begin, std::size_t end)
+            {
+                bool rangeChanged = false;
+                for (std::size_t i=begin; i<end; ++i)
+                    rangeChanged |= fsm_sweepBlock(blocks[i]);
+                if (rangeChanged)
+                    sweepChanged = true;
+            });
         }
+        changed = sweepChanged;
     }
-
-    if(FMM_VERBOSE){
-        std::stringstream tmp;
-        tmp << "fmm_heap = [";
-        for (int i=0; i<m_fmm_heap_size; i++)
-            tmp << " <"<<(m_fmm_heap[i]%m_nx)<<','<<((m_fmm_heap[i]/m_nx)%m_ny)<<','<<(m_fmm_heap[i]/m_nxny)<<">="<<m_dists[m_fmm_heap[i]];
-        msg_info("DistanceGrid") << tmp.str() ;
-    }
+    dmsg_info("DistanceGrid")<< "FSM: converged after " << it << " iterations.";
 }
 
 /// Sample the surface with points approximately separated by the given sampling distance (expressed in voxels if the value is negative)
@@ -1161,7 +1030,7 @@ void DistanceGrid::sampleSurface(double sampling)
             for (int y=1; y<m_ny-1; y+=stepY)
                 for (int x=1; x<m_nx-1; x+=stepX)
                 {
-                    SReal d = m_dists[index(x,y,z)];
+                    SReal d = m_dists.get(x,y,z);
                     if (rabs(d) > maxD) continue;
 
                     Vector3 pos = coord(x,y,z);
@@ -1182,7 +1051,7 @@ void DistanceGrid::sampleSurface(double sampling)
                     {
                         msg_warning("DistanceGrid")
                                 << "Failed to converge at ("<<x<<","<<y<<","<<z<<"):"
-                                << " pos0 = " << coord(x,y,z) << " d0 = " << m_dists[index(x,y,z)] << " grad0 = " << grad(index(x,y,z), Coord())
+                                << " pos0 = " << coord(x,y,z) << " d0 = " << m_dists.get(x,y,z) << " grad0 = " << grad(index(x,y,z), Coord())
                                 << " pos = " << pos << " d = " << d << " grad = " << n;
                         continue;
                     }
@@ -1224,7 +1093,7 @@ void DistanceGrid::sampleSurface(double sampling)
                     if (it == 10 && rabs(d) > 0.1f*maxD)
                     {
                         msg_warning("DistanceGrid")<< "Failed to converge at ("<<x<<","<<y<<","<<z<<"):"
-                                << " pos0 = " << coord(x,y,z) << " d0 = " << m_dists[index(x,y,z)] << " grad0 = " << grad(index(x,y,z), Coord())
+                                << " pos0 = " << coord(x,y,z) << " d0 = " << m_dists.get(x,y,z) << " grad0 = " << grad(index(x,y,z), Coord())
                                 << " pos = " << pos << " d = " << d << " grad = " << n;
                         continue;
                     }
@@ -1240,7 +1109,8 @@ void DistanceGrid::sampleSurface(double sampling)
 
 
 DistanceGrid* DistanceGrid::loadShared(const std::string& filename,
-                                       double scale, double sampling, int nx, int ny, int nz, Coord pmin, Coord pmax)
+                                       double scale, double sampling, int nx, int ny, int nz, Coord pmin, Coord pmax,
+                                       SReal narrowBand)
 {
     DistanceGridParams params;
     params.filename = filename;
@@ -1251,13 +1121,14 @@ DistanceGrid* DistanceGrid::loadShared(const std::string& filename,
     params.nz = nz;
     params.pmin = pmin;
     params.pmax = pmax;
+    params.narrowBand = narrowBand;
     std::map<DistanceGridParams, DistanceGrid*>& shared = getShared();
     std::map<DistanceGridParams, DistanceGrid*>::iterator it = shared.find(params);
     if (it != shared.end())
         return it->second->addRef();
     else
     {
-        return shared[params] = load(filename, scale, sampling, nx, ny, nz, pmin, pmax);
+        return shared[params] = load(filename, scale, sampling, nx, ny, nz, pmin, pmax, narrowBand);
     }
 }
 
@@ -1267,12 +1138,12 @@ SReal DistanceGrid::quickeval(const Coord& x) const
     SReal d;
     if (inGrid(x))
     {
-        d = m_dists[index(x)] - m_cellWidth[0]; // we underestimate the distance
+        d = (*this)[index(x)] - m_cellWidth[0]; // we underestimate the distance
     }
     else
     {
         Coord xclamp = clamp(x);
-        d = m_dists[index(xclamp)] - m_cellWidth[0]; // we underestimate the distance
+        d = (*this)[index(xclamp)] - m_cellWidth[0]; // we underestimate the distance
         d = helper::rsqrt((x-xclamp).norm2() + d*d);
     }
     return d;
@@ -1300,13 +1171,13 @@ SReal DistanceGrid::quickeval2(const Coord& x) const
     SReal d2;
     if (inGrid(x))
     {
-        SReal d = m_dists[index(x)] - m_cellWidth[0]; // we underestimate the distance
+        SReal d = (*this)[index(x)] - m_cellWidth[0]; // we underestimate the distance
         d2 = d*d;
     }
     else
     {
         Coord xclamp = clamp(x);
-        SReal d = m_dists[index(xclamp)] - m_cellWidth[0]; // we underestimate the distance
+        SReal d = (*this)[index(xclamp)] - m_cellWidth[0]; // we underestimate the distance
         d2 = ((x-xclamp).norm2() + d*d);
     }
     return d2;
@@ -1314,10 +1185,12 @@ SReal DistanceGrid::quickeval2(const Coord& x) const
 
 SReal DistanceGrid::interp(int index, const Coord& coefs) const
 {
-    return interp(coefs[2],interp(coefs[1],interp(coefs[0],m_dists[index          ],m_dists[index+1        ]),
-            interp(coefs[0],m_dists[index  +m_nx     ],m_dists[index+1+m_nx     ])),
-            interp(coefs[1],interp(coefs[0],m_dists[index     +m_nxny],m_dists[index+1   +m_nxny]),
-                    interp(coefs[0],m_dists[index  +m_nx+m_nxny],m_dists[index+1+m_nx+m_nxny])));
+    int x, y, z;
+    cellCoord(index, x, y, z);
+    return interp(coefs[2],interp(coefs[1],interp(coefs[0],m_dists.get(x,y  ,z  ),m_dists.get(x+1,y  ,z  )),
+            interp(coefs[0],m_dists.get(x,y+1,z  ),m_dists.get(x+1,y+1,z  ))),
+            interp(coefs[1],interp(coefs[0],m_dists.get(x,y  ,z+1),m_dists.get(x+1,y  ,z+1)),
+                    interp(coefs[0],m_dists.get(x,y+1,z+1),m_dists.get(x+1,y+1,z+1))));
 }
 
 
@@ -1342,14 +1215,16 @@ Coord DistanceGrid::grad(int index, const Coord& coefs) const
     //           + (dist[1][1][0]-dist[0][1][0]) * (  y) * (1-z)
     //           + (dist[1][0][1]-dist[0][0][1]) * (1-y) * (  z)
     //           + (dist[1][1][1]-dist[0][1][1]) * (  y) * (  z)
-    const SReal dist000 = m_dists[index          ];
-    const SReal dist100 = m_dists[index+1        ];
-    const SReal dist010 = m_dists[index  +m_nx     ];
-    const SReal dist110 = m_dists[index+1+m_nx     ];
-    const SReal dist001 = m_dists[index     +m_nxny];
-    const SReal dist101 = m_dists[index+1   +m_nxny];
-    const SReal dist011 = m_dists[index  +m_nx+m_nxny];
-    const SReal dist111 = m_dists[index+1+m_nx+m_nxny];
+    int x, y, z;
+    cellCoord(index, x, y, z);
+    const SReal dist000 = m_dists.get(x  ,y  ,z  );
+    const SReal dist100 = m_dists.get(x+1,y  ,z  );
+    const SReal dist010 = m_dists.get(x  ,y+1,z  );
+    const SReal dist110 = m_dists.get(x+1,y+1,z  );
+    const SReal dist001 = m_dists.get(x  ,y  ,z+1);
+    const SReal dist101 = m_dists.get(x+1,y  ,z+1);
+    const SReal dist011 = m_dists.get(x  ,y+1,z+1);
+    const SReal dist111 = m_dists.get(x+1,y+1,z+1);
     return Coord(
             interp(coefs[2],interp(coefs[1],dist100-dist000,dist110-dist010),interp(coefs[1],dist101-dist001,dist111-dist011)), //*invCellWidth[0],
             interp(coefs[2],interp(coefs[0],dist010-dist000,dist110-dist100),interp(coefs[0],dist011-dist001,dist111-dist101)), //*invCellWidth[1],
@@ -1393,6 +1268,7 @@ bool DistanceGrid::DistanceGridParams::operator==(const DistanceGridParams& v) c
     if (!(pmax[0]  == v.pmax[0] )) return false;
     if (!(pmax[1]  == v.pmax[1] )) return false;
     if (!(pmax[2]  == v.pmax[2] )) return false;
+    if (!(narrowBand == v.narrowBand)) return false;
     return true;
 }
 
@@ -1422,6 +1298,8 @@ bool DistanceGrid::DistanceGridParams::operator<(const DistanceGridParams& v) co
     if (pmax[1]  > v.pmax[1] ) return true;
     if (pmax[2]  < v.pmax[2] ) return false;
     if (pmax[2]  > v.pmax[2] ) return true;
+    if (narrowBand < v.narrowBand) return false;
+    if (narrowBand > v.narrowBand) return true;
     return false;
 }
 
@@ -1451,6 +1329,8 @@ bool DistanceGrid::DistanceGridParams::operator>(const DistanceGridParams& v) co
     if (pmax[1]  < v.pmax[1] ) return true;
     if (pmax[2]  > v.pmax[2] ) return false;
     if (pmax[2]  < v.pmax[2] ) return true;
+    if (narrowBand > v.narrowBand) return false;
+    if (narrowBand < v.narrowBand) return true;
     return false;
 }
 
@@ -22,6 +22,7 @@
 #ifndef SOFA_SOFADISTANCEGRID_DISTANCEGRID_H
 #define SOFA_SOFADISTANCEGRID_DISTANCEGRID_H
 #include <SofaDistanceGrid/config.h>
+#include <SofaDistanceGrid/SparseBlockGrid.h>
 
 #include <sofa/defaulttype/VecTypes.h>
 #include <sofa/helper/rmath.h>
@@ -70,11 +71,14 @@ public:
     ~DistanceGrid();
 
 public:
-    /// Load a distance grid
+    /// Load a distance grid.
+    /// If narrowBand is not zero, only the values closer to the surface than narrowBand are stored,
+    /// the other ones being clamped to +/-narrowBand.
     static DistanceGrid* load(const std::string& filename,
                               double scale=1.0, double sampling=0.0,
                               int m_nx=64, int m_ny=64, int m_nz=64,
-                              Coord m_pmin = Coord(), Coord m_pmax = Coord());
+                              Coord m_pmin = Coord(), Coord m_pmax = Coord(),
+                              SReal narrowBand = 0);
 
     static DistanceGrid* loadVTKFile(const std::string& filename,
                                      double scale=1.0, double sampling=0.0);
@@ -83,7 +87,8 @@ public:
     static DistanceGrid* loadShared(const std::string& filename,
                                     double scale=1.0, double sampling=0.0,
                                     int m_nx=64, int m_ny=64, int m_nz=64,
-                                    Coord m_pmin = Coord(), Coord m_pmax = Coord());
+                                    Coord m_pmin = Coord(), Coord m_pmax = Coord(),
+                                    SReal narrowBand = 0);
 
     /// Add one reference to this grid. Note that loadShared already does this.
     DistanceGrid* addRef();
@@ -94,9 +99,21 @@ public:
     /// Save current grid
     bool save(const std::string& filename);
 
-    /// Compute distance field from given mesh
+    /// Compute distance field from given mesh.
+    /// The distances are propagated from the surface using a parallel fast sweeping method.
+    /// If a narrow band is set, only the blocks of the grid close to the surface are allocated.
     void calcDistance(Mesh* mesh, double scale=1.0);
 
+    /// Clamp the distances to [-narrowBand, narrowBand] and release the blocks of the grid
+    /// located outside of this band. A value of zero keeps the full grid.
+    void compress(SReal narrowBand);
+
+    inline SReal getNarrowBand() const { return m_narrowBand; }
+    inline void setNarrowBand(SReal narrowBand) { m_narrowBand = narrowBand; }
+
+    /// Approximate memory used by the distance values, in bytes
+    inline std::size_t getMemorySize() const { return m_dists.getMemorySize(); }
+
     /// Compute distance field for a cube of the given half-size.
     /// Also create a mesh of points using np points per axis
     void calcCubeDistance(SReal dim=1, int np=5);
@@ -178,18 +195,30 @@ public:
         return index(p, coefs);
     }
 
-    int index(int x, int y, int z)
+    int index(int x, int y, int z) const
     {
         return x+m_nx*(y+m_ny*(z));
     }
 
-    Coord coord(int x, int y, int z)
+    Coord coord(int x, int y, int z) const
     {
         return m_pmin+Coord(x*m_cellWidth[0], y*m_cellWidth[1], z*m_cellWidth[2]);
     }
 
-    SReal operator[](int index) const { return m_dists[index]; }
-    SReal& operator[](int index) { return m_dists[index]; }
+    SReal operator[](int index) const
+    {
+        int x, y, z;
+        cellCoord(index, x, y, z);
+        return m_dists.get(x, y, z);
+    }
+
+    /// Allocates the block of the cell if it is not stored yet: only use it to write values.
+    SReal& operator[](int index)
+    {
+        int x, y, z;
+        cellCoord(index, x, y, z);
+        return m_dists.ref(x, y, z);
+    }
 
     static SReal interp(SReal coef, SReal a, SReal b)
     {
@@ -227,25 +256,40 @@ public:
     VecCoord meshPts;
 
 protected:
+    inline void cellCoord(int index, int& x, int& y, int& z) const
+    {
+        x = index%m_nx;
+        const int yz = index/m_nx;
+        y = yz%m_ny;
+        z = yz/m_ny;
+    }
+
+    /// Copy values stored in a dense array, ordered as given by index(x,y,z)
+    void setValues(const VecSReal& values);
+
     int m_nbRef;
     const int m_nx,m_ny,m_nz;
     const int m_nxny, m_nxnynz;
-    VecSReal m_dists;
+    SparseBlockGrid<SReal> m_dists;
+    SReal m_narrowBand; ///< Distances are only stored in [-m_narrowBand, m_narrowBand] (0 to store all of them)
     const Coord m_pmin, m_pmax;
     const Coord m_cellWidth, m_invCellWidth;
     Coord m_bbmin, m_bbmax; ///< bounding box of the object, smaller than the grid
 
     SReal m_cubeDim; ///< Cube dimension (!=0 if this is actually a cube
 
-    /// Fast Marching Method Update
-    enum Status { FMM_FRONT0 = 0, FMM_FAR = -1, FMM_KNOWN_OUT = -2, FMM_KNOWN_IN = -3 };
-    helper::vector<int> m_fmm_status;
-    helper::vector<int> m_fmm_heap;
-    int m_fmm_heap_size;
+    /// Fast Sweeping Method
+    enum Status : char { FSM_FAR = 0, FSM_IN = 1, FSM_OUT = 2, FSM_FROZEN = 4 };
+    SparseBlockGrid<char> m_fsm_status;
 
-    int fmm_pop();
-    void fmm_push(int index);
-    void fmm_swap(int entry1, int entry2);
+    /// Set the distance of a cell crossed by the surface
+    void fsm_seed(int x, int y, int z, SReal dist, Status status);
+    /// Sweep the cells of a block in the 8 diagonal directions. Returns true if a value changed.
+    bool fsm_sweepBlock(int block);
+    /// Update the distance of a cell from its neighbors. Returns true if the value changed.
+    bool fsm_update(int x, int y, int z);
+    /// Sweep all the allocated blocks until convergence, in parallel if possible
+    void fsm_propagate();
 
     /// Grid shared resources
     struct DistanceGridParams
@@ -255,6 +299,7 @@ protected:
         double sampling;
         int nx,ny,nz;
         Coord pmin,pmax;
+        SReal narrowBand;
         bool operator==(const DistanceGridParams& v) const ;
         bool operator<(const DistanceGridParams& v) const ;
         bool operator>(const DistanceGridParams& v) const ;
@@ -0,0 +1,185 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_SOFADISTANCEGRID_SPARSEBLOCKGRID_H
+#define SOFA_SOFADISTANCEGRID_SPARSEBLOCKGRID_H
+#include <SofaDistanceGrid/config.h>
+
+#include <sofa/helper/vector.h>
+
+#include <cstdint>
+
+namespace sofa
+{
+namespace component
+{
+namespace container
+{
+namespace _distancegrid_
+{
+
+/**
+ * \brief Regular grid of values stored in blocks of 8x8x8 cells, allocated on demand.
+ *
+ * A block which is not allocated is a "tile": all its cells share the same value.
+ * This allows to store only a narrow band of values around a surface, the remaining
+ * of the grid being described by a few constant tiles.
+ *
+ * Reading a value never allocates memory, writing a value through ref() allocates
+ * the block containing the cell if it is a tile. References returned by ref() are
+ * invalidated when a new block is allocated.
+ */
+template<class T>
+class SparseBlockGrid
+{
+public:
+    static constexpr int BlockBits = 3;
+    static constexpr int BlockSize = 1 << BlockBits;
+    static constexpr int BlockMask = BlockSize - 1;
+    static constexpr int BlockVolume = BlockSize*BlockSize*BlockSize;
+
+    SparseBlockGrid(int nx = 0, int ny = 0, int nz = 0, T background = T())
+    {
+        resize(nx, ny, nz, background);
+    }
+
+    /// Resize the grid. All the blocks are released and become tiles of the given value
+    void resize(int nx, int ny, int nz, T background = T())
+    {
+        m_nx = nx; m_ny = ny; m_nz = nz;
+        m_nbx = (nx + BlockMask) >> BlockBits;
+        m_nby = (ny + BlockMask) >> BlockBits;
+        m_nbz = (nz + BlockMask) >> BlockBits;
+        m_blockOffset.clear();
+        m_blockOffset.resize(m_nbx*m_nby*m_nbz, -1);
+        m_tiles.clear();
+        m_tiles.resize(m_nbx*m_nby*m_nbz, background);
+        m_data.clear();
+    }
+
+    /// Release all the blocks and set all the values of the grid
+    void fill(T value)
+    {
+        resize(m_nx, m_ny, m_nz, value);
+    }
+
+    inline int getNbBlocksX() const { return m_nbx; }
+    inline int getNbBlocksY() const { return m_nby; }
+    inline int getNbBlocksZ() const { return m_nbz; }
+    inline int getNbBlocks() const { return (int)m_blockOffset.size(); }
+
+    inline int blockIndex(int x, int y, int z) const
+    {
+        return (x >> BlockBits) + m_nbx*((y >> BlockBits) + m_nby*(z >> BlockBits));
+    }
+
+    static inline int cellIndex(int x, int y, int z)
+    {
+        return (x & BlockMask) + BlockSize*((y & BlockMask) + BlockSize*(z & BlockMask));
+    }
+
+    inline bool isAllocated(int block) const { return m_blockOffset[block] >= 0; }
+
+    inline T get(int x, int y, int z) const
+    {
+        const int block = blockIndex(x, y, z);
+        const std::int64_t offset = m_blockOffset[block];
+        return (offset < 0) ? m_tiles[block] : m_data[offset + cellIndex(x, y, z)];
+    }
+
+    inline T& ref(int x, int y, int z)
+    {
+        const int block = blockIndex(x, y, z);
+        if (m_blockOffset[block] < 0)
+            allocateBlock(block);
+        return m_data[m_blockOffset[block] + cellIndex(x, y, z)];
+    }
+
+    /// Allocate a block, initializing its values with the value of its tile
+    void allocateBlock(int block)
+    {
+        if (m_blockOffset[block] >= 0)
+            return;
+        m_blockOffset[block] = (std::int64_t)m_data.size();
+        m_data.resize(m_data.size() + BlockVolume, m_tiles[block]);
+    }
+
+    /// Values of an allocated block, ordered as given by cellIndex()
+    T* getBlockData(int block) { return &m_data[m_blockOffset[block]]; }
+    const T* getBlockData(int block) const { return &m_data[m_blockOffset[block]]; }
+
+    /// Value of a block which is not allocated
+    T getTile(int block) const { return m_tiles[block]; }
+
+    /// Turn a block into a tile of the given value.
+    /// Its memory is reclaimed by the next call to compact()
+    void setTile(int block, T value)
+    {
+        m_blockOffset[block] = -1;
+        m_tiles[block] = value;
+    }
+
+    /// Release the memory of the blocks turned into tiles
+    void compact()
+    {
+        helper::vector<T> data;
+        data.reserve(getNbAllocatedBlocks()*BlockVolume);
+        for (std::size_t b = 0; b < m_blockOffset.size(); ++b)
+        {
+            if (m_blockOffset[b] < 0) continue;
+            const std::int64_t offset = (std::int64_t)data.size();
+            data.insert(data.end(), m_data.begin() + m_blockOffset[b], m_data.begin() + m_blockOffset[b] + BlockVolume);
+            m_blockOffset[b] = offset;
+        }
+        m_data.swap(data);
+    }
+
+    std::size_t getNbAllocatedBlocks() const
+    {
+        std::size_t nb = 0;
+        for (const auto offset : m_blockOffset)
+            if (offset >= 0) ++nb;
+        return nb;
+    }
+
+    /// Approximate memory used by the grid, in bytes
+    std::size_t getMemorySize() const
+    {
+        return m_blockOffset.size()*(sizeof(std::int64_t)+sizeof(T)) + m_data.size()*sizeof(T);
+    }
+
+protected:
+    int m_nx {0}, m_ny {0}, m_nz {0};
+    int m_nbx {0}, m_nby {0}, m_nbz {0};
+    helper::vector<std::int64_t> m_blockOffset; ///< offset of each block in m_data, or -1 for tiles
+    helper::vector<T> m_tiles; ///< value of each block when it is not allocated
+    helper::vector<T> m_data; ///< values of the allocated blocks
+};
+
+} // namespace _distancegrid_
+
+} // namespace container
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
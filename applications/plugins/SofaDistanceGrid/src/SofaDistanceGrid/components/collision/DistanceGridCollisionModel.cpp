@@ -76,6 +76,7 @@ RigidDistanceGridCollisionModel::RigidDistanceGridCollisionModel()
     , nx( initData( &nx, 64, "nx", "number of values on X axis") )
     , ny( initData( &ny, 64, "ny", "number of values on Y axis") )
     , nz( initData( &nz, 64, "nz", "number of values on Z axis") )
+    , narrowBand( initData( &narrowBand, 0.0, "narrowBand", "if not zero: only store the distances closer to the surface than this value, the grid is clamped to +/-narrowBand elsewhere") )
     , dumpfilename( initData( &dumpfilename, "dumpfilename","write distance grid to specified file"))
     , usePoints( initData( &usePoints, true, "usePoints", "use mesh vertices for collision detection"))
     , flipNormals( initData( &flipNormals, false, "flipNormals", "reverse surface direction, i.e. points are considered in collision if they move outside of the object instead of inside"))
@@ -114,8 +115,9 @@ void RigidDistanceGridCollisionModel::init()
     if (scale.getValue()!=1.0) sout<<" scale="<<scale.getValue();
     if (sampling.getValue()!=0.0) sout<<" sampling="<<sampling.getValue();
     if (box.getValue()[0][0]<box.getValue()[1][0]) sout<<" bbox=<"<<box.getValue()[0]<<">-<"<<box.getValue()[0]<<">";
+    if (narrowBand.getValue()!=0.0) sout<<" narrowBand="<<narrowBand.getValue();
     sout << sendl;
-    grid = DistanceGrid::loadShared(fileRigidDistanceGrid.getFullPath(), scale.getValue(), sampling.getValue(), nx.getValue(),ny.getValue(),nz.getValue(),box.getValue()[0],box.getValue()[1]);
+    grid = DistanceGrid::loadShared(fileRigidDistanceGrid.getFullPath(), scale.getValue(), sampling.getValue(), nx.getValue(),ny.getValue(),nz.getValue(),box.getValue()[0],box.getValue()[1],narrowBand.getValue());
     if (grid->getNx() != this->nx.getValue())
         this->nx.setValue(grid->getNx());
     if (grid->getNy() != this->ny.getValue())
@@ -300,7 +302,7 @@ void RigidDistanceGridCollisionModel::draw(const core::visual::VisualParams* ,In
         sofa::gl::glMultMatrix(m.ptr());
     }
 
-    DistanceGrid* grid = getGrid(index);
+    const DistanceGrid* grid = getGrid(index);
     DistanceGrid::Coord corners[8];
     for(unsigned int i=0; i<8; i++)
         corners[i] = grid->getCorner(i);
@@ -133,6 +133,7 @@ public:
     Data< int > nx; ///< number of values on X axis
     Data< int > ny; ///< number of values on Y axis
     Data< int > nz; ///< number of values on Z axis
+    Data< double > narrowBand; ///< if not zero: only store the distances closer to the surface than this value, the grid is clamped to +/-narrowBand elsewhere
     sofa::core::objectmodel::DataFileName dumpfilename;
 
     Data< bool > usePoints; ///< use mesh vertices for collision detection
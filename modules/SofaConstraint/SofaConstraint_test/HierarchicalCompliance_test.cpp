@@ -0,0 +1,149 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaConstraint/HierarchicalCompliance.h>
+using sofa::component::constraintset::HierarchicalCompliance;
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <sstream>
+
+namespace
+{
+
+typedef sofa::defaulttype::Vec3d Vec3;
+
+/// Smooth kernel coupling the nodes, similar to the decay of the compliance of an elastic body
+struct KernelMatrix
+{
+    const std::vector<Vec3>& positions;
+    unsigned int blockSize;
+    bool coupledComponents = true; ///< otherwise the matrix is made of blockSize decoupled parts
+
+    double operator()(unsigned int row, unsigned int col) const
+    {
+        const unsigned int i = row / blockSize, j = col / blockSize;
+        const unsigned int di = row % blockSize, dj = col % blockSize;
+        const Vec3 d = positions[i] - positions[j];
+        const double r2 = d.norm2() + 0.01;
+        const double coupling = coupledComponents ? d[di % 3] * d[dj % 3] / (r2 * std::sqrt(r2)) : 0.0;
+        return (di == dj ? 1.0 / std::sqrt(r2) : 0.0) + coupling;
+    }
+};
+
+std::vector<Vec3> gridPositions(unsigned int n)
+{
+    std::vector<Vec3> positions;
+    for (unsigned int i = 0; i < n; ++i)
+        for (unsigned int j = 0; j < n; ++j)
+            for (unsigned int k = 0; k < n; ++k)
+                positions.push_back(Vec3(i, j, k) * (1.0 / n));
+
+    // the input order must not matter
+    std::shuffle(positions.begin(), positions.end(), std::mt19937(42));
+    return positions;
+}
+
+double maxRelativeError(const HierarchicalCompliance<double>& compressed, const KernelMatrix& matrix)
+{
+    const unsigned int bs = matrix.blockSize;
+    std::vector<double> block(bs * bs);
+    double maxError = 0, maxValue = 0;
+    for (unsigned int i = 0; i < matrix.positions.size(); ++i)
+    {
+        for (unsigned int j = 0; j < matrix.positions.size(); ++j)
+        {
+            compressed.getBlock(i, j, block.data());
+            for (unsigned int a = 0; a < bs; ++a)
+            {
+                for (unsigned int b = 0; b < bs; ++b)
+                {
+                    const double expected = matrix(i * bs + a, j * bs + b);
+                    maxValue = std::max(maxValue, std::abs(expected));
+                    maxError = std::max(maxError, std::abs(expected - block[a * bs + b]));
+                }
+            }
+        }
+    }
+    return maxError / maxValue;
+}
+
+TEST(HierarchicalCompliance, compressesSmoothKernel)
+{
+    const std::vector<Vec3> positions = gridPositions(12);
+    const KernelMatrix matrix { positions, 3 };
+
+    HierarchicalCompliance<double> compressed;
+    compressed.build(positions, 3, matrix, 1e-4);
+
+    EXPECT_EQ(compressed.getNbNodes(), positions.size());
+    EXPECT_LT(compressed.getStorageSize(), 0.8 * 9 * positions.size() * positions.size());
+    EXPECT_LT(maxRelativeError(compressed, matrix), 1e-3);
+}
+
+TEST(HierarchicalCompliance, decoupledComponents)
+{
+    // the pivots of a component never reach the other ones: the reference rows must detect them
+    const std::vector<Vec3> positions = gridPositions(10);
+    const KernelMatrix matrix { positions, 3, false };
+
+    HierarchicalCompliance<double> compressed;
+    compressed.build(positions, 3, matrix, 1e-4);
+
+    EXPECT_LT(compressed.getStorageSize(), 0.9 * 9 * positions.size() * positions.size());
+    EXPECT_LT(maxRelativeError(compressed, matrix), 1e-3);
+}
+
+TEST(HierarchicalCompliance, smallMatrixIsExact)
+{
+    const std::vector<Vec3> positions = gridPositions(2);
+    const KernelMatrix matrix { positions, 1 };
+
+    HierarchicalCompliance<double> compressed;
+    compressed.build(positions, 1, matrix, 1e-6);
+
+    EXPECT_EQ(compressed.getStorageSize(), positions.size() * positions.size());
+    EXPECT_EQ(maxRelativeError(compressed, matrix), 0.0);
+}
+
+TEST(HierarchicalCompliance, writeAndRead)
+{
+    const std::vector<Vec3> positions = gridPositions(6);
+    const KernelMatrix matrix { positions, 3 };
+
+    HierarchicalCompliance<double> compressed;
+    compressed.build(positions, 3, matrix, 1e-6, 8);
+
+    std::stringstream stream;
+    compressed.write(stream);
+
+    HierarchicalCompliance<double> loaded;
+    ASSERT_TRUE(loaded.read(stream));
+    EXPECT_EQ(loaded.getStorageSize(), compressed.getStorageSize());
+    EXPECT_EQ(loaded.getBlockSize(), 3u);
+    EXPECT_LT(maxRelativeError(loaded, matrix), 1e-5);
+
+    std::stringstream invalid("not a compressed compliance");
+    EXPECT_FALSE(loaded.read(invalid));
+}
+
+}
@@ -0,0 +1,576 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+#include <SofaConstraint/config.h>
+
+#include <sofa/defaulttype/Vec.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <numeric>
+#include <ostream>
+#include <vector>
+
+namespace sofa::component::constraintset
+{
+
+/**
+ *  \brief Hierarchical (H-matrix) storage of a dense matrix made of blockSize x blockSize blocks coupling nodes.
+ *
+ *  The nodes are clustered by recursive bisection of their positions. The sub-matrix coupling two clusters
+ *  that are far enough from each other is stored as a low-rank product U.V^T, computed by adaptive cross
+ *  approximation (ACA) from a few of its rows and columns. Only the near field sub-matrices are stored dense.
+ *  For smooth kernels like the compliance of an elastic body, the storage grows as O(n log n) instead of O(n^2).
+ */
+template<class TReal>
+class HierarchicalCompliance
+{
+public:
+    typedef TReal Real;
+    typedef sofa::defaulttype::Vec3d Vec3;
+
+    /**
+     * @brief Builds the compressed representation of the square matrix of size positions.size()*blockSize.
+     *
+     * @param entry function returning the scalar entry (row, col) of the matrix to compress.
+     * @param tolerance relative accuracy of the low-rank sub-matrices.
+     * @param leafSize maximum number of nodes in a cluster which is not subdivided.
+     * @param admissibility two clusters are far from each other if the smallest diameter is lower than
+     *        admissibility times their distance.
+     */
+    template<class EntryFunction>
+    void build(const std::vector<Vec3>& positions, unsigned int blockSize, const EntryFunction& entry,
+               Real tolerance, unsigned int leafSize = 16, Real admissibility = 1);
+
+    /// Writes the blockSize x blockSize block (row-major) coupling the nodes row and col.
+    void getBlock(unsigned int row, unsigned int col, Real* block) const;
+
+    unsigned int getNbNodes() const { return (unsigned int)m_inversePermutation.size(); }
+    unsigned int getBlockSize() const { return m_blockSize; }
+
+    /// Number of stored scalars, to be compared to (getNbNodes()*getBlockSize())^2 for the dense matrix.
+    std::size_t getStorageSize() const { return m_values.size(); }
+
+    void write(std::ostream& out) const;
+    bool read(std::istream& in);
+
+protected:
+    enum BlockType : std::int32_t { SPLIT = 0, DENSE = 1, LOWRANK = 2 };
+
+    /// Range of permuted node indices, children are stored at firstChild and firstChild+1
+    struct Cluster
+    {
+        std::uint32_t begin, end;
+        std::int32_t firstChild;
+    };
+
+    /// Sub-matrix coupling two clusters, its 4 children (if SPLIT) are stored from firstChild
+    struct Block
+    {
+        std::int32_t rowCluster, colCluster;
+        std::int32_t type, firstChild;
+        std::uint64_t rank, offset;
+    };
+
+    struct BoundingBox
+    {
+        Vec3 min, max;
+    };
+
+    std::size_t size(const Cluster& c) const { return std::size_t(c.end - c.begin) * m_blockSize; }
+
+    /// Scalar index in the original matrix of the local scalar index i in the cluster c
+    unsigned int globalIndex(const Cluster& c, std::size_t i) const
+    {
+        return m_permutation[c.begin + i / m_blockSize] * m_blockSize + (unsigned int)(i % m_blockSize);
+    }
+
+    void buildCluster(const std::vector<Vec3>& positions, int index, unsigned int leafSize);
+
+    template<class EntryFunction>
+    void buildBlock(int block, const EntryFunction& entry, Real tolerance, Real admissibility);
+
+    template<class EntryFunction>
+    bool computeLowRank(const Cluster& s, const Cluster& t, const EntryFunction& entry, Real tolerance,
+                        std::vector< std::vector<Real> >& u, std::vector< std::vector<Real> >& v) const;
+
+    bool isAdmissible(int s, int t, Real admissibility) const;
+
+    unsigned int m_blockSize {0};
+    std::vector<unsigned int> m_permutation;        ///< permuted index -> node
+    std::vector<unsigned int> m_inversePermutation; ///< node -> permuted index
+    std::vector<Cluster> m_clusters;
+    std::vector<BoundingBox> m_boxes; ///< only used during the build
+    std::vector<Block> m_blocks;
+    std::vector<Real> m_values;
+};
+
+
+template<class TReal>
+template<class EntryFunction>
+void HierarchicalCompliance<TReal>::build(const std::vector<Vec3>& positions, unsigned int blockSize, const EntryFunction& entry,
+                                          Real tolerance, unsigned int leafSize, Real admissibility)
+{
+    const unsigned int nbNodes = (unsigned int)positions.size();
+    m_blockSize = blockSize;
+    m_permutation.resize(nbNodes);
+    std::iota(m_permutation.begin(), m_permutation.end(), 0u);
+    m_clusters.clear();
+    m_boxes.clear();
+    m_blocks.clear();
+    m_values.clear();
+
+    if (nbNodes == 0)
+    {
+        m_inversePermutation.clear();
+        return;
+    }
+
+    m_clusters.push_back({0, nbNodes, -1});
+    m_boxes.resize(1);
+    buildCluster(positions, 0, std::max(leafSize, 1u));
+
+    m_inversePermutation.resize(nbNodes);
+    for (unsigned int i = 0; i < nbNodes; ++i)
+        m_inversePermutation[m_permutation[i]] = i;
+
+    m_blocks.push_back({0, 0, SPLIT, -1, 0, 0});
+    buildBlock(0, entry, tolerance, admissibility);
+
+    m_boxes.clear();
+    m_boxes.shrink_to_fit();
+    m_values.shrink_to_fit();
+}
+
+template<class TReal>
+void HierarchicalCompliance<TReal>::buildCluster(const std::vector<Vec3>& positions, int index, unsigned int leafSize)
+{
+    const unsigned int begin = m_clusters[index].begin;
+    const unsigned int end = m_clusters[index].end;
+
+    BoundingBox& box = m_boxes[index];
+    box.min = box.max = positions[m_permutation[begin]];
+    for (unsigned int i = begin + 1; i < end; ++i)
+    {
+        const Vec3& p = positions[m_permutation[i]];
+        for (unsigned int d = 0; d < 3; ++d)
+        {
+            box.min[d] = std::min(box.min[d], p[d]);
+            box.max[d] = std::max(box.max[d], p[d]);
+        }
+    }
+
+    if (end - begin <= leafSize)
+        return;
+
+    // geometric bisection of the largest dimension of the bounding box, so that the children are well
+    // separated, falling back to the median when all the nodes are on one side
+    const Vec3 extent = box.max - box.min;
+    const unsigned int axis = (extent[0] >= extent[1] && extent[0] >= extent[2]) ? 0 : (extent[1] >= extent[2] ? 1 : 2);
+    const double split = 0.5 * (box.min[axis] + box.max[axis]);
+    unsigned int middle = (unsigned int)(std::partition(m_permutation.begin() + begin, m_permutation.begin() + end,
+                                                        [&positions, axis, split](unsigned int a) { return positions[a][axis] < split; })
+                                         - m_permutation.begin());
+    if (middle == begin || middle == end)
+    {
+        middle = begin + (end - begin) / 2;
+        std::nth_element(m_permutation.begin() + begin, m_permutation.begin() + middle, m_permutation.begin() + end,
+                         [&positions, axis](unsigned int a, unsigned int b) { return positions[a][axis] < positions[b][axis]; });
+    }
+
+    const int firstChild = (int)m_clusters.size();
+    m_clusters[index].firstChild = firstChild;
+    m_clusters.push_back({begin, middle, -1});
+    m_clusters.push_back({middle, end, -1});
+    m_boxes.resize(m_clusters.size());
+
+    buildCluster(positions, firstChild, leafSize);
+    buildCluster(positions, firstChild + 1, leafSize);
+}
+
+template<class TReal>
+bool HierarchicalCompliance<TReal>::isAdmissible(int s, int t, Real admissibility) const
+{
+    const BoundingBox& a = m_boxes[s];
+    const BoundingBox& b = m_boxes[t];
+
+    double distance2 = 0;
+    for (unsigned int d = 0; d < 3; ++d)
+    {
+        const double gap = std::max({0.0, a.min[d] - b.max[d], b.min[d] - a.max[d]});
+        distance2 += gap * gap;
+    }
+    if (distance2 <= 0)
+        return false;
+
+    const double diameter = std::min((a.max - a.min).norm(), (b.max - b.min).norm());
+    return diameter <= admissibility * std::sqrt(distance2);
+}
+
+template<class TReal>
+template<class EntryFunction>
+void HierarchicalCompliance<TReal>::buildBlock(int block, const EntryFunction& entry, Real tolerance, Real admissibility)
+{
+    const int s = m_blocks[block].rowCluster;
+    const int t = m_blocks[block].colCluster;
+    const Cluster rows = m_clusters[s];
+    const Cluster cols = m_clusters[t];
+    const std::size_t m = size(rows);
+    const std::size_t n = size(cols);
+    const bool leaf = rows.firstChild < 0 || cols.firstChild < 0;
+
+    if (isAdmissible(s, t, admissibility))
+    {
+        std::vector< std::vector<Real> > u, v;
+        if (computeLowRank(rows, cols, entry, tolerance, u, v))
+        {
+            const std::size_t rank = u.size();
+            Block& b = m_blocks[block];
+            b.type = LOWRANK;
+            b.rank = rank;
+            b.offset = m_values.size();
+
+            // U and V are stored row-major so that an entry is the dot product of two contiguous rows
+            m_values.resize(m_values.size() + (m + n) * rank);
+            Real* U = m_values.data() + b.offset;
+            Real* V = U + m * rank;
+            for (std::size_t k = 0; k < rank; ++k)
+            {
+                for (std::size_t i = 0; i < m; ++i)
+                    U[i * rank + k] = u[k][i];
+                for (std::size_t j = 0; j < n; ++j)
+                    V[j * rank + k] = v[k][j];
+            }
+            return;
+        }
+    }
+
+    if (leaf)
+    {
+        Block& b = m_blocks[block];
+        b.type = DENSE;
+        b.offset = m_values.size();
+        m_values.resize(m_values.size() + m * n);
+        Real* values = m_values.data() + b.offset;
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            const unsigned int gi = globalIndex(rows, i);
+            for (std::size_t j = 0; j < n; ++j)
+                values[i * n + j] = entry(gi, globalIndex(cols, j));
+        }
+        return;
+    }
+
+    const int firstChild = (int)m_blocks.size();
+    m_blocks[block].type = SPLIT;
+    m_blocks[block].firstChild = firstChild;
+    for (int i = 0; i < 2; ++i)
+        for (int j = 0; j < 2; ++j)
+            m_blocks.push_back({rows.firstChild + i, cols.firstChild + j, SPLIT, -1, 0, 0});
+
+    for (int c = 0; c < 4; ++c)
+        buildBlock(firstChild + c, entry, tolerance, admissibility);
+}
+
+template<class TReal>
+template<class EntryFunction>
+bool HierarchicalCompliance<TReal>::computeLowRank(const Cluster& s, const Cluster& t, const EntryFunction& entry, Real tolerance,
+                                                   std::vector< std::vector<Real> >& u, std::vector< std::vector<Real> >& v) const
+{
+    const std::size_t m = size(s);
+    const std::size_t n = size(t);
+
+    // beyond this rank, the low-rank storage is larger than the dense one
+    const std::size_t maxRank = (m * n) / (m + n);
+
+    std::vector<Real> row(n), col(m);
+    std::vector<char> usedRow(m, 0);
+    std::size_t pivotRow = 0;
+    double approximationNorm2 = 0;
+
+    const auto rowResidual = [&](std::size_t i, std::vector<Real>& r)
+    {
+        const unsigned int gi = globalIndex(s, i);
+        for (std::size_t j = 0; j < n; ++j)
+        {
+            Real e = entry(gi, globalIndex(t, j));
+            for (std::size_t k = 0; k < u.size(); ++k)
+                e -= u[k][i] * v[k][j];
+            r[j] = e;
+        }
+    };
+
+    // The partial pivoting can stop too early on matrices made of decoupled parts (for instance the
+    // components of a node block). One unused reference row per component is kept up to date with the
+    // approximation: the convergence also requires their residuals to be small, and a reference row
+    // whose residual is not becomes the next pivot (as in ACA+).
+    struct ReferenceRow
+    {
+        std::size_t index;
+        std::vector<Real> residual;
+        double norm2;
+    };
+    std::vector<ReferenceRow> references(std::min<std::size_t>(m_blockSize, m));
+    const auto selectReference = [&](std::size_t c, ReferenceRow& reference)
+    {
+        // the unused row of the component c following the middle of the cluster
+        const std::size_t nbRows = (m - c + m_blockSize - 1) / m_blockSize;
+        reference.index = m;
+        reference.norm2 = 0;
+        for (std::size_t r = 0; r < nbRows && reference.index == m; ++r)
+        {
+            const std::size_t i = c + ((nbRows / 2 + r) % nbRows) * m_blockSize;
+            if (!usedRow[i])
+                reference.index = i;
+        }
+        if (reference.index == m)
+            return;
+        reference.residual.resize(n);
+        rowResidual(reference.index, reference.residual);
+        for (std::size_t j = 0; j < n; ++j)
+            reference.norm2 += double(reference.residual[j]) * reference.residual[j];
+    };
+    const auto largestReference = [&]()
+    {
+        const ReferenceRow* largest = nullptr;
+        for (const ReferenceRow& reference : references)
+            if (reference.index < m && (largest == nullptr || reference.norm2 > largest->norm2))
+                largest = &reference;
+        return largest;
+    };
+
+    usedRow[pivotRow] = 1;
+    for (std::size_t c = 0; c < references.size(); ++c)
+        selectReference(c, references[c]);
+
+    while (u.size() < maxRank)
+    {
+        usedRow[pivotRow] = 1;
+        for (std::size_t c = 0; c < references.size(); ++c)
+            if (references[c].index < m && usedRow[references[c].index])
+                selectReference(c, references[c]);
+
+        // residual of the pivot row
+        rowResidual(pivotRow, row);
+
+        std::size_t pivotCol = 0;
+        for (std::size_t j = 1; j < n; ++j)
+            if (std::abs(row[j]) > std::abs(row[pivotCol]))
+                pivotCol = j;
+
+        if (std::abs(row[pivotCol]) <= std::numeric_limits<Real>::min())
+        {
+            // this row is already exactly approximated, continue from the largest reference row
+            const ReferenceRow* largest = largestReference();
+            if (largest == nullptr || largest->norm2 == 0)
+                return true;
+            pivotRow = largest->index;
+            continue;
+        }
+
+        const Real invPivot = Real(1) / row[pivotCol];
+        for (std::size_t j = 0; j < n; ++j)
+            row[j] *= invPivot;
+
+        // residual of the pivot column
+        const unsigned int gj = globalIndex(t, pivotCol);
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            Real r = entry(globalIndex(s, i), gj);
+            for (std::size_t k = 0; k < u.size(); ++k)
+                r -= u[k][i] * v[k][pivotCol];
+            col[i] = r;
+        }
+
+        // update of the Frobenius norm of the approximation
+        double normU2 = 0, normV2 = 0;
+        for (std::size_t i = 0; i < m; ++i)
+            normU2 += double(col[i]) * col[i];
+        for (std::size_t j = 0; j < n; ++j)
+            normV2 += double(row[j]) * row[j];
+
+        double cross = 0;
+        for (std::size_t k = 0; k < u.size(); ++k)
+        {
+            double uu = 0, vv = 0;
+            for (std::size_t i = 0; i < m; ++i)
+                uu += double(u[k][i]) * col[i];
+            for (std::size_t j = 0; j < n; ++j)
+                vv += double(v[k][j]) * row[j];
+            cross += uu * vv;
+        }
+        approximationNorm2 += normU2 * normV2 + 2 * cross;
+
+        for (ReferenceRow& reference : references)
+        {
+            if (reference.index == m)
+                continue;
+            reference.norm2 = 0;
+            for (std::size_t j = 0; j < n; ++j)
+            {
+                reference.residual[j] -= col[reference.index] * row[j];
+                reference.norm2 += double(reference.residual[j]) * reference.residual[j];
+            }
+        }
+
+        u.push_back(col);
+        v.push_back(row);
+
+        // next pivot row: largest entry of the new column among the unused rows
+        bool found = false;
+        for (std::size_t i = 0; i < m; ++i)
+        {
+            if (!usedRow[i] && (!found || std::abs(col[i]) > std::abs(col[pivotRow])))
+            {
+                pivotRow = i;
+                found = true;
+            }
+        }
+        if (!found)
+            return true;
+
+        // the norm of the last rank-1 term estimates the norm of the residual, the reference rows
+        // estimate it on the parts of the matrix which the pivots have not reached
+        const double tolerance2 = double(tolerance) * tolerance * approximationNorm2;
+        if (normU2 * normV2 <= tolerance2)
+        {
+            const ReferenceRow* largest = largestReference();
+            if (largest == nullptr || double(m) * largest->norm2 <= tolerance2)
+                return true;
+            pivotRow = largest->index;
+        }
+    }
+
+    return false;
+}
+
+template<class TReal>
+void HierarchicalCompliance<TReal>::getBlock(unsigned int row, unsigned int col, Real* block) const
+{
+    const unsigned int pr = m_inversePermutation[row];
+    const unsigned int pc = m_inversePermutation[col];
+
+    const Block* b = &m_blocks[0];
+    while (b->type == SPLIT)
+    {
+        const Cluster& firstRowChild = m_clusters[m_clusters[b->rowCluster].firstChild];
+        const Cluster& firstColChild = m_clusters[m_clusters[b->colCluster].firstChild];
+        const int child = (pr < firstRowChild.end ? 0 : 2) + (pc < firstColChild.end ? 0 : 1);
+        b = &m_blocks[b->firstChild + child];
+    }
+
+    const Cluster& rows = m_clusters[b->rowCluster];
+    const Cluster& cols = m_clusters[b->colCluster];
+    const std::size_t i0 = std::size_t(pr - rows.begin) * m_blockSize;
+    const std::size_t j0 = std::size_t(pc - cols.begin) * m_blockSize;
+    const Real* values = m_values.data() + b->offset;
+
+    if (b->type == DENSE)
+    {
+        const std::size_t n = size(cols);
+        for (unsigned int i = 0; i < m_blockSize; ++i)
+            for (unsigned int j = 0; j < m_blockSize; ++j)
+                block[i * m_blockSize + j] = values[(i0 + i) * n + j0 + j];
+    }
+    else
+    {
+        const std::size_t rank = b->rank;
+        const Real* U = values;
+        const Real* V = values + size(rows) * rank;
+        for (unsigned int i = 0; i < m_blockSize; ++i)
+        {
+            const Real* ui = U + (i0 + i) * rank;
+            for (unsigned int j = 0; j < m_blockSize; ++j)
+            {
+                const Real* vj = V + (j0 + j) * rank;
+                Real sum = 0;
+                for (std::size_t k = 0; k < rank; ++k)
+                    sum += ui[k] * vj[k];
+                block[i * m_blockSize + j] = sum;
+            }
+        }
+    }
+}
+
+namespace hierarchicalcompliance
+{
+inline constexpr char fileTag[8] = {'S', 'O', 'F', 'A', 'H', 'C', 'M', '1'};
+
+template<class T>
+void writeArray(std::ostream& out, const std::vector<T>& array)
+{
+    const std::uint64_t size = array.size();
+    out.write((const char*)&size, sizeof(size));
+    out.write((const char*)array.data(), std::streamsize(size * sizeof(T)));
+}
+
+template<class T>
+bool readArray(std::istream& in, std::vector<T>& array)
+{
+    std::uint64_t size = 0;
+    if (!in.read((char*)&size, sizeof(size)))
+        return false;
+    array.resize(size);
+    return bool(in.read((char*)array.data(), std::streamsize(size * sizeof(T))));
+}
+} // namespace hierarchicalcompliance
+
+template<class TReal>
+void HierarchicalCompliance<TReal>::write(std::ostream& out) const
+{
+    using namespace hierarchicalcompliance;
+    const std::uint32_t header[2] = { m_blockSize, (std::uint32_t)sizeof(Real) };
+    out.write(fileTag, sizeof(fileTag));
+    out.write((const char*)header, sizeof(header));
+    writeArray(out, m_permutation);
+    writeArray(out, m_clusters);
+    writeArray(out, m_blocks);
+    writeArray(out, m_values);
+}
+
+template<class TReal>
+bool HierarchicalCompliance<TReal>::read(std::istream& in)
+{
+    using namespace hierarchicalcompliance;
+    char tag[sizeof(fileTag)];
+    std::uint32_t header[2];
+    if (!in.read(tag, sizeof(tag)) || std::memcmp(tag, fileTag, sizeof(tag)) != 0
+        || !in.read((char*)header, sizeof(header)) || header[1] != sizeof(Real))
+        return false;
+
+    m_blockSize = header[0];
+    if (!readArray(in, m_permutation) || !readArray(in, m_clusters) || !readArray(in, m_blocks) || !readArray(in, m_values)
+        || m_blocks.empty() || m_clusters.empty())
+        return false;
+
+    m_inversePermutation.resize(m_permutation.size());
+    for (unsigned int i = 0; i < m_permutation.size(); ++i)
+        m_inversePermutation[m_permutation[i]] = i;
+
+    return true;
+}
+
+} //namespace sofa::component::constraintset
@@ -29,6 +29,8 @@
 
 #include <sofa/core/ObjectFactory.h>
 
+#include <sofa/simulation/ParallelForRange.h>
+
 #include <sofa/simulation/mechanicalvisitor/MechanicalVOpVisitor.h>
 using sofa::simulation::mechanicalvisitor::MechanicalVOpVisitor;
 
@@ -43,6 +45,14 @@ using sofa::core::VecId;
 namespace sofa::component::constraintset
 {
 
+namespace
+{
+
+/// Below this number of contacts per task, the contacts of a color are updated by the calling thread
+constexpr std::size_t minContactsPerTask = 16;
+
+} // namespace
+
 void LCPConstraintProblem::solveTimed(double tolerance, int maxIt, double timeout)
 {
     helper::nlcp_gaussseidelTimed(dimension, getDfree(), getW(), getF(), mu, tolerance, maxIt, true, timeout);
@@ -136,9 +146,15 @@ bool LCPConstraintSolver::solveSystem(const core::ConstraintParams * /*cParams*/
 
                 sofa::helper::AdvancedTimer::stepBegin("NLCP MultiGrid");
                 helper::nlcp_multiGrid_Nlevels(_numConstraints, _dFree->ptr(), _W->lptr(), _result->ptr(), _mu, _tol, _maxIt, initial_guess.getValue(),
-                        hierarchy_contact_group, hierarchy_num_group, hierarchy_constraint_group, hierarchy_constraint_group_fact,  notMuted(), &graph_residuals, &graph_levels, &graph_violations);
+                        hierarchy_contact_group, hierarchy_num_group, hierarchy_constraint_group, hierarchy_constraint_group_fact,  notMuted(), &graph_residuals, &graph_levels, &graph_violations, false);
                 sofa::helper::AdvancedTimer::stepEnd("NLCP MultiGrid");
 
+                // the finest level is solved from the prolongated forces
+                sofa::helper::AdvancedTimer::stepBegin("NLCP GaussSeidel");
+                nlcp_gaussseidel_colored(_tol, _maxIt, true, &graph_residuals, &graph_violations);
+                sofa::helper::AdvancedTimer::stepEnd("NLCP GaussSeidel");
+                graph_levels.resize(graph_residuals.size(), 1.0);
+
             }
             else
             {
@@ -147,8 +163,11 @@ bool LCPConstraintSolver::solveSystem(const core::ConstraintParams * /*cParams*/
                 sofa::helper::vector<double>& graph_violations = graph["Violation"];
                 graph_violations.clear();
                 sofa::helper::AdvancedTimer::stepBegin("NLCP GaussSeidel");
-                helper::nlcp_gaussseidel(_numConstraints, _dFree->ptr(), _W->lptr(), _result->ptr(), _mu, _tol, _maxIt, initial_guess.getValue(),
-                        notMuted(), _minW, _maxF, &graph_error, &graph_violations);
+                if (d_parallelGaussSeidel.getValue())
+                    nlcp_gaussseidel_colored(_tol, _maxIt, initial_guess.getValue(), &graph_error, &graph_violations);
+                else
+                    helper::nlcp_gaussseidel(_numConstraints, _dFree->ptr(), _W->lptr(), _result->ptr(), _mu, _tol, _maxIt, initial_guess.getValue(),
+                            notMuted(), _minW, _maxF, &graph_error, &graph_violations);
                 sofa::helper::AdvancedTimer::stepEnd("NLCP GaussSeidel");
              }
         }
@@ -234,11 +253,12 @@ LCPConstraintSolver::LCPConstraintSolver()
     , mu( initData(&mu, 0.6, "mu", "Friction coefficient"))
     , minW( initData(&minW, 0.0, "minW", "If not zero, constraints whose self-compliance (i.e. the corresponding value on the diagonal of W) is smaller than this threshold will be ignored"))
     , maxF( initData(&maxF, 0.0, "maxF", "If not zero, constraints whose response force becomes larger than this threshold will be ignored"))
-    , multi_grid(initData(&multi_grid, false, "multi_grid","activate multi_grid resolution (NOT STABLE YET)"))
+    , multi_grid(initData(&multi_grid, false, "multi_grid","activate multi_grid resolution"))
     , multi_grid_levels(initData(&multi_grid_levels, 2, "multi_grid_levels","if multi_grid is active: how many levels to create (>=2)"))
     , merge_method( initData(&merge_method, 0, "merge_method","if multi_grid is active: which method to use to merge constraints (0 = compliance-based, 1 = spatial coordinates)"))
     , merge_spatial_step( initData(&merge_spatial_step, 2, "merge_spatial_step", "if merge_method is 1: grid size reduction between multigrid levels"))
     , merge_local_levels( initData(&merge_local_levels, 2, "merge_local_levels", "if merge_method is 1: up to the specified level of the multigrid, constraints are grouped locally, i.e. separately within each contact pairs, while on upper levels they are grouped globally independently of contact pairs."))
+    , d_parallelGaussSeidel( initData(&d_parallelGaussSeidel, false, "parallel_gauss_seidel", "update the uncoupled contacts (same color in the contact coupling graph) in parallel during the Gauss-Seidel iterations"))
     , constraintGroups( initData(&constraintGroups, "group", "list of ID of groups of constraints to be handled by this solver."))
     , f_graph( initData(&f_graph,"graph","Graph of residuals at each iteration"))
     , showLevels( initData(&showLevels,0,"showLevels","Number of constraint levels to display"))
@@ -289,6 +309,9 @@ void LCPConstraintSolver::init()
         constraintCorrections[i]->addConstraintSolver(this);
 
     context = getContext();
+
+    if (d_parallelGaussSeidel.getValue())
+        simulation::initTaskScheduler();
 }
 
 void LCPConstraintSolver::cleanup()
@@ -413,52 +436,98 @@ void LCPConstraintSolver::MultigridConstraintsMerge()
 
 void LCPConstraintSolver::MultigridConstraintsMerge_Compliance()
 {
-    double criterion=0.0;
-    int numContacts = _numConstraints/3;
-
-    hierarchy_contact_group.resize(1);
-    hierarchy_constraint_group.resize(1);
-    hierarchy_constraint_group_fact.resize(1);
-    hierarchy_num_group.resize(1);
-    std::vector<int> group_lead;
-    std::vector<int>& contact_group = hierarchy_contact_group[0];
-    std::vector<int>& constraint_group = hierarchy_constraint_group[0];
-    std::vector<double>& constraint_group_fact = hierarchy_constraint_group_fact[0];
-    unsigned int& num_group = hierarchy_num_group[0];
-    contact_group.clear();
-    contact_group.resize(numContacts);
-    group_lead.clear();
-    constraint_group.clear();
-    constraint_group.resize(_numConstraints);
-    constraint_group_fact.clear();
-    constraint_group_fact.resize(_numConstraints);
-
-    for (int c=0; c<numContacts; c++)
+    const int numContacts = _numConstraints/3;
+    const int nLevels = std::max(2, multi_grid_levels.getValue());
+    double** W = _W->lptr();
+
+    hierarchy_contact_group.clear();
+    hierarchy_constraint_group.clear();
+    hierarchy_constraint_group_fact.clear();
+    hierarchy_num_group.clear();
+
+    // coupling along the normals of two contacts, normalized by their self-compliances (1 for contacts moving together)
+    auto normalCoupling = [W](int c1, int c2)
     {
-        bool new_group = true;
-        for(int g=0; g<(int)group_lead.size() ; g++)
+        const double w11 = W[3*c1][3*c1];
+        const double w22 = W[3*c2][3*c2];
+        return (w11 > 0 && w22 > 0) ? W[3*c1][3*c2] / sqrt(w11*w22) : 0.0;
+    };
+
+    // coupling of the contacts of the current level, the coupling of two groups being the one of their closest contacts
+    int numItems = numContacts;
+    std::vector<double> coupling((std::size_t)numItems*numItems);
+    for (int c1=0; c1<numItems; c1++)
+        for (int c2=0; c2<numItems; c2++)
+            coupling[(std::size_t)c1*numItems+c2] = std::max(0.0, normalCoupling(c1, c2));
+
+    // the coupling needed to merge two groups is halved at each coarser level
+    double criterion = 0.5;
+    std::vector<double> groupCoupling;
+    for (int level=0; level<nLevels-1; level++, criterion *= 0.5)
+    {
+        std::vector<int> contact_group(numItems);
+        int numGroups = 0;
+
+        for (int c=0; c<numItems; c++)
         {
-            if (_W->lptr()[3*c][3*group_lead[g]] > criterion * (_W->lptr()[3*c][3*c] +_W->lptr()[3*group_lead[g]][3*group_lead[g]]) )  // on regarde les couplages selon la normale...
+            // coupling with the groups built so far, from the items already gathered in them
+            const double* row = &coupling[(std::size_t)c*numItems];
+            groupCoupling.assign(numGroups, 0.0);
+            for (int i=0; i<c; i++)
+                groupCoupling[contact_group[i]] = std::max(groupCoupling[contact_group[i]], row[i]);
+
+            // join the group with the strongest coupling
+            int group = -1;
+            double bestCoupling = criterion;
+            for (int g=0; g<numGroups; g++)
             {
-                new_group =false;
-                contact_group[c] = g;
+                if (groupCoupling[g] > bestCoupling)
+                {
+                    group = g;
+                    bestCoupling = groupCoupling[g];
+                }
             }
+            if (group < 0)
+                group = numGroups++;
+            contact_group[c] = group;
         }
-        if (new_group)
+
+        // no coarser level when nothing could be merged
+        if (level > 0 && numGroups == numItems)
+            break;
+
+        std::vector<int> constraint_group(3*numItems);
+        std::vector<double> constraint_group_fact(3*numItems, 1.0);
+        for (int c=0; c<numItems; c++)
         {
-            contact_group[c]=group_lead.size();
-            group_lead.push_back(c);
+            constraint_group[3*c  ] = 3*contact_group[c]  ;
+            constraint_group[3*c+1] = 3*contact_group[c]+1;
+            constraint_group[3*c+2] = 3*contact_group[c]+2;
         }
-    }
-    num_group = group_lead.size();
-    dmsg_info() << "contacts merged in "<<num_group<<" list(s)" ;
 
-    for (int c=0; c<numContacts; c++)
-    {
-        constraint_group[3*c  ] = 3*contact_group[c]  ; constraint_group_fact[3*c  ] = 1.0;
-        constraint_group[3*c+1] = 3*contact_group[c]+1; constraint_group_fact[3*c+1] = 1.0;
-        constraint_group[3*c+2] = 3*contact_group[c]+2; constraint_group_fact[3*c+2] = 1.0;
+        hierarchy_contact_group.push_back(contact_group);
+        hierarchy_constraint_group.push_back(constraint_group);
+        hierarchy_constraint_group_fact.push_back(constraint_group_fact);
+        hierarchy_num_group.push_back((unsigned int)numGroups);
+
+        // coupling of the groups, in one pass over the couplings of the current level
+        if (level+1 < nLevels-1)
+        {
+            std::vector<double> coarseCoupling((std::size_t)numGroups*numGroups, 0.0);
+            for (int i=0; i<numItems; i++)
+            {
+                double* coarseRow = &coarseCoupling[(std::size_t)contact_group[i]*numGroups];
+                const double* row = &coupling[(std::size_t)i*numItems];
+                for (int j=0; j<numItems; j++)
+                    coarseRow[contact_group[j]] = std::max(coarseRow[contact_group[j]], row[j]);
+            }
+            coupling.swap(coarseCoupling);
+            numItems = numGroups;
+        }
     }
+
+    dmsg_info() << "contacts merged in " << hierarchy_num_group.size() << " level(s), with "
+                << hierarchy_num_group.back() << " list(s) at the coarsest level" ;
 }
 
 void LCPConstraintSolver::MultigridConstraintsMerge_Spatial()
@@ -830,6 +899,24 @@ void LCPConstraintSolver::keepContactForcesValue()
 }
 
 
+int LCPConstraintSolver::nlcp_gaussseidel_colored(double tol, int maxIt, bool useInitialF, std::vector<double>* residuals, std::vector<double>* violations)
+{
+    // the coloring is only rebuilt when the coupling of the contacts changed since the previous call
+    sofa::helper::AdvancedTimer::stepBegin("ContactColoring");
+    contactColoring.update(_numConstraints, _W->lptr());
+    sofa::helper::AdvancedTimer::stepEnd("ContactColoring");
+
+    simulation::TaskScheduler* taskScheduler = d_parallelGaussSeidel.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    const helper::NLCPParallelFor parallelFor = [taskScheduler](int nbContacts, const std::function<void(int,int)>& f)
+    {
+        simulation::parallelForRange(taskScheduler, 0, std::size_t(nbContacts), minContactsPerTask,
+                                     [&f](std::size_t begin, std::size_t end) { f(int(begin), int(end)); });
+    };
+
+    return helper::nlcp_gaussseidel_colored(_numConstraints, _dFree->ptr(), _W->lptr(), _result->ptr(), _mu, tol, maxIt, useInitialF,
+            contactColoring, parallelFor, minW.getValue(), maxF.getValue(), residuals, violations);
+}
+
 int LCPConstraintSolver::nlcp_gaussseidel_unbuilt(double *dfree, double *f, std::vector<double>* residuals)
 {
     if(!_numConstraints)
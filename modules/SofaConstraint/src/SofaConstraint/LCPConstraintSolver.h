@@ -139,11 +139,12 @@ public:
     Data<double> mu; ///< Friction coefficient
     Data<double> minW; ///< If not zero, constraints whose self-compliance (i.e. the corresponding value on the diagonal of W) is smaller than this threshold will be ignored
     Data<double> maxF; ///< If not zero, constraints whose response force becomes larger than this threshold will be ignored
-    Data<bool> multi_grid; ///< activate multi_grid resolution (NOT STABLE YET)
+    Data<bool> multi_grid; ///< activate multi_grid resolution
     Data<int> multi_grid_levels; ///< if multi_grid is active: how many levels to create (>=2)
     Data<int> merge_method; ///< if multi_grid is active: which method to use to merge constraints (0 = compliance-based, 1 = spatial coordinates)
     Data<int> merge_spatial_step; ///< if merge_method is 1: grid size reduction between multigrid levels
     Data<int> merge_local_levels; ///< if merge_method is 1: up to the specified level of the multigrid, constraints are grouped locally, i.e. separately within each contact pairs, while on upper levels they are grouped globally independently of contact pairs.
+    Data<bool> d_parallelGaussSeidel; ///< update the uncoupled contacts (same color in the contact coupling graph) in parallel during the Gauss-Seidel iterations
 
     Data < std::set<int> > constraintGroups; ///< list of ID of groups of constraints to be handled by this solver.
 
@@ -186,6 +187,10 @@ public:
     std::vector< std::vector< double > > hierarchy_constraint_group_fact;
     std::vector< unsigned int > hierarchy_num_group;
 
+    /// colored Gauss-Seidel, used by the parallel resolution and at the finest multigrid level ///
+    int nlcp_gaussseidel_colored(double tol, int maxIt, bool useInitialF, std::vector<double>* residuals, std::vector<double>* violations);
+    helper::NLCPBlockColoring contactColoring;
+
 
     /// common built-unbuilt
     sofa::core::objectmodel::BaseContext *context;
@@ -21,6 +21,7 @@
 ******************************************************************************/
 #pragma once
 #include <SofaConstraint/config.h>
+#include <SofaConstraint/HierarchicalCompliance.h>
 
 #include <sofa/core/behavior/ConstraintCorrection.h>
 #include <sofa/core/objectmodel/DataFileName.h>
@@ -65,6 +66,8 @@ public:
 	Data<double> debugViewFrameScale; ///< Scale on computed node's frame
 	sofa::core::objectmodel::DataFileName f_fileCompliance; ///< Precomputed compliance matrix data file
 	Data<std::string> fileDir; ///< If not empty, the compliance will be saved in this repertory
+    Data<double> d_compressionTolerance; ///< If not zero, the compliance is stored as a hierarchical matrix with this relative accuracy
+    Data<bool> d_memoryMapped; ///< If true, the compliance file is mapped in memory and read on demand instead of being loaded
     
 protected:
     PrecomputedConstraintCorrection(sofa::core::behavior::MechanicalState<DataTypes> *mm = nullptr);
@@ -121,7 +124,9 @@ public:
     {
         Real* data;
         int nbref;
-        InverseStorage() : data(nullptr), nbref(0) {}
+        std::size_t mappedSize; ///< if not zero, data is a read-only mapping of the compliance file
+        HierarchicalCompliance<Real>* compressed;
+        InverseStorage() : data(nullptr), nbref(0), mappedSize(0), compressed(nullptr) {}
     };
 
     std::string invName;
@@ -139,6 +144,9 @@ public:
 
     static void releaseInverse(std::string name, InverseStorage* inv);
 
+    /// Frees the dense compliance, allocated or mapped in memory.
+    static void releaseDenseInverse(InverseStorage* inv);
+
     unsigned int nbRows, nbCols, dof_on_node, nbNodes;
     helper::vector<int> _indexNodeSparseCompliance;
     helper::vector<Deriv> _sparseCompliance;
@@ -176,10 +184,35 @@ protected:
     bool loadCompliance(std::string fileName);
 
     /**
-     * @brief Save compliance matrix into a file.
+     * @brief Save compliance matrix into a file, in its compressed format if it is compressed.
      */
     void saveCompliance(const std::string& fileName);
 
+    /**
+     * @brief Looks for a compliance file in fileDir or in the data repository.
+     *
+     * @return true if found, fileName being then replaced by its full path.
+     */
+    bool findComplianceFile(std::string& fileName);
+
+    /**
+     * @brief Maps the dense compliance file in memory, the pages being read by the system when accessed.
+     */
+    bool mapCompliance(const std::string& filePath);
+
+    /**
+     * @brief Replaces the dense compliance by its hierarchical compressed representation.
+     */
+    void compressCompliance();
+
+    /**
+     * @brief Copies the dof_on_node x dof_on_node compliance block (row-major) coupling the nodes row and col.
+     */
+    void getComplianceBlock(unsigned int row, unsigned int col, Real* block) const;
+
+    /// Number of values of a compliance block, to size the buffers given to getComplianceBlock
+    static constexpr std::size_t complianceBlockSize = DataTypes::deriv_total_size * DataTypes::deriv_total_size;
+
     /**
      * @brief Builds the compliance file name using the SOFA component internal data.
      */
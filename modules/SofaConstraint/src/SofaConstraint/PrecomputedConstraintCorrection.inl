@@ -45,6 +45,14 @@
 #include <sstream>
 #include <list>
 #include <iomanip>
+#include <type_traits>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 //#define NEW_METHOD_UNBUILT
 
@@ -60,6 +68,8 @@ PrecomputedConstraintCorrection<DataTypes>::PrecomputedConstraintCorrection(sofa
     , debugViewFrameScale(initData(&debugViewFrameScale, 1.0, "debugViewFrameScale", "Scale on computed node's frame"))
     , f_fileCompliance(initData(&f_fileCompliance, "fileCompliance", "Precomputed compliance matrix data file"))
     , fileDir(initData(&fileDir, "fileDir", "If not empty, the compliance will be saved in this repertory"))
+    , d_compressionTolerance(initData(&d_compressionTolerance, 0.0, "compressionTolerance", "If not zero, the compliance is stored as a hierarchical matrix whose far field blocks are low-rank approximations with this relative accuracy"))
+    , d_memoryMapped(initData(&d_memoryMapped, false, "memoryMapped", "If true, the dense compliance file is mapped in memory and read on demand instead of being loaded"))
     , invM(nullptr)
     , appCompliance(nullptr)
     , nbRows(0), nbCols(0), dof_on_node(0), nbNodes(0)
@@ -95,11 +105,26 @@ void PrecomputedConstraintCorrection<DataTypes>::releaseInverse(std::string name
     std::map< std::string, InverseStorage >& registry = getInverseMap();
     if (--inv->nbref == 0)
     {
-        if (inv->data) delete[] inv->data;
+        releaseDenseInverse(inv);
+        delete inv->compressed;
         registry.erase(name);
     }
 }
 
+template<class DataTypes>
+void PrecomputedConstraintCorrection<DataTypes>::releaseDenseInverse(InverseStorage* inv)
+{
+    if (inv->data == nullptr) return;
+#ifndef WIN32
+    if (inv->mappedSize)
+        munmap(inv->data, inv->mappedSize);
+    else
+#endif
+        delete[] inv->data;
+    inv->data = nullptr;
+    inv->mappedSize = 0;
+}
+
 
 struct ConstraintActivation { bool acc, vel, pos; };
 
@@ -118,6 +143,63 @@ std::string PrecomputedConstraintCorrection<DataTypes>::buildFileName()
 
 
 
+template<class DataTypes>
+bool PrecomputedConstraintCorrection<DataTypes>::findComplianceFile(std::string& fileName)
+{
+    std::string dir = fileDir.getValue();
+    if (!dir.empty())
+    {
+        fileName = dir + "/" + fileName;
+        return std::ifstream(fileName.c_str(), std::ifstream::binary).is_open();
+    }
+    else if (recompute.getValue() == false)
+    {
+        return sofa::helper::system::DataRepository.findFile(fileName, "", nullptr);
+    }
+
+    return false;
+}
+
+
+
+template<class DataTypes>
+bool PrecomputedConstraintCorrection<DataTypes>::mapCompliance(const std::string& filePath)
+{
+#ifndef WIN32
+    // the file stores doubles, it can only be used as is for double precision
+    if (!std::is_same<Real, double>::value)
+        return false;
+
+    const std::size_t size = std::size_t(nbRows) * nbCols * sizeof(double);
+
+    const int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStatus;
+    void* mapping = MAP_FAILED;
+    if (fstat(fd, &fileStatus) == 0 && std::size_t(fileStatus.st_size) >= size)
+        mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        msg_warning() << "File " << filePath << " can not be mapped in memory, it is loaded instead";
+        return false;
+    }
+
+    invM->data = static_cast<Real*>(mapping);
+    invM->mappedSize = size;
+    return true;
+#else
+    SOFA_UNUSED(filePath);
+    msg_warning() << "memoryMapped is not supported on this platform, the compliance is loaded instead";
+    return false;
+#endif
+}
+
+
+
 template<class DataTypes>
 bool PrecomputedConstraintCorrection<DataTypes>::loadCompliance(std::string fileName)
 {
@@ -127,48 +209,45 @@ bool PrecomputedConstraintCorrection<DataTypes>::loadCompliance(std::string file
     invM = getInverse(fileName);
     dimensionAppCompliance = nbRows;
 
-    if (invM->data == nullptr)
-    {
-        // Try to load from file
-        msg_info() << "Try to load compliance from : " << fileName ;
-
-        std::string dir = fileDir.getValue();
-        if (!dir.empty())
-        {
-            std::ifstream compFileIn((dir + "/" + fileName).c_str(), std::ifstream::binary);
-            if (compFileIn.is_open())
-            {
-                invM->data = new Real[nbRows * nbCols];
+    if (invM->data != nullptr || invM->compressed != nullptr)
+        return true;
 
-                msg_info() << "File " << dir + "/" + fileName << " found. Loading..." ;
+    // Try to load from file
+    msg_info() << "Try to load compliance from : " << fileName ;
 
-                compFileIn.read((char*)invM->data, nbCols * nbRows * sizeof(double));
-                compFileIn.close();
+    if (d_compressionTolerance.getValue() > 0)
+    {
+        std::string compressedFileName = fileName + ".hmat";
+        if (findComplianceFile(compressedFileName))
+        {
+            msg_info() << "File " << compressedFileName << " found. Loading..." ;
 
+            std::ifstream compFileIn(compressedFileName.c_str(), std::ifstream::binary);
+            auto* compressed = new HierarchicalCompliance<Real>();
+            if (compressed->read(compFileIn) && compressed->getNbNodes() == nbNodes && compressed->getBlockSize() == dof_on_node)
+            {
+                invM->compressed = compressed;
                 return true;
             }
-            else
-                return false;
+
+            msg_warning() << "File " << compressedFileName << " does not match this object, it is ignored";
+            delete compressed;
         }
-        else if (recompute.getValue() == false)
-        {
-            if(sofa::helper::system::DataRepository.findFile(fileName))
-            {
-                invM->data = new Real[nbRows * nbCols];
+    }
 
-                std::ifstream compFileIn(fileName.c_str(), std::ifstream::binary);
+    if (!findComplianceFile(fileName))
+        return false;
 
-                msg_info() << "File " << fileName << " found. Loading..." ;
+    msg_info() << "File " << fileName << " found. Loading..." ;
 
-                compFileIn.read((char*)invM->data, nbCols * nbRows * sizeof(double));
-                compFileIn.close();
+    if (d_memoryMapped.getValue() && mapCompliance(fileName))
+        return true;
 
-                return true;
-            }
-        }
+    invM->data = new Real[nbRows * nbCols];
 
-        return false;
-    }
+    std::ifstream compFileIn(fileName.c_str(), std::ifstream::binary);
+    compFileIn.read((char*)invM->data, nbCols * nbRows * sizeof(double));
+    compFileIn.close();
 
     return true;
 }
@@ -187,6 +266,13 @@ void PrecomputedConstraintCorrection<DataTypes>::saveCompliance(const std::strin
     else
         filePathInSofaShare  = sofa::helper::system::DataRepository.getFirstPath() + "/" + fileName;
 
+    if (invM->compressed)
+    {
+        std::ofstream compFileOut((filePathInSofaShare + ".hmat").c_str(), std::fstream::out | std::fstream::binary);
+        invM->compressed->write(compFileOut);
+        return;
+    }
+
     std::ofstream compFileOut(filePathInSofaShare.c_str(), std::fstream::out | std::fstream::binary);
     compFileOut.write((char*)invM->data, nbCols * nbRows * sizeof(double));
     compFileOut.close();
@@ -194,6 +280,54 @@ void PrecomputedConstraintCorrection<DataTypes>::saveCompliance(const std::strin
 
 
 
+template<class DataTypes>
+void PrecomputedConstraintCorrection<DataTypes>::compressCompliance()
+{
+    const VecCoord& x0 = this->mstate->read(core::ConstVecCoordId::restPosition())->getValue();
+
+    std::vector<defaulttype::Vec3d> positions(nbNodes);
+    for (unsigned int i = 0; i < nbNodes && i < x0.size(); ++i)
+    {
+        double x, y, z;
+        DataTypes::get(x, y, z, x0[i]);
+        positions[i] = defaulttype::Vec3d(x, y, z);
+    }
+
+    const Real* dense = invM->data;
+    const std::size_t stride = nbCols;
+    auto* compressed = new HierarchicalCompliance<Real>();
+    compressed->build(positions, dof_on_node,
+                      [dense, stride](unsigned int row, unsigned int col) { return dense[row * stride + col]; },
+                      (Real)d_compressionTolerance.getValue());
+
+    msg_info() << "Compliance compressed to " << compressed->getStorageSize() << " values instead of "
+               << std::size_t(nbRows) * nbCols;
+
+    releaseDenseInverse(invM);
+    invM->compressed = compressed;
+}
+
+
+
+template<class DataTypes>
+void PrecomputedConstraintCorrection<DataTypes>::getComplianceBlock(unsigned int row, unsigned int col, Real* block) const
+{
+    assert(std::size_t(dof_on_node) * dof_on_node <= complianceBlockSize);
+    if (appCompliance)
+    {
+        const Real* values = appCompliance + dof_on_node * (row * nbCols + col);
+        for (unsigned int i = 0; i < dof_on_node; ++i)
+            for (unsigned int j = 0; j < dof_on_node; ++j)
+                block[i * dof_on_node + j] = values[i * nbCols + j];
+    }
+    else
+    {
+        invM->compressed->getBlock(row, col, block);
+    }
+}
+
+
+
 template<class DataTypes>
 void PrecomputedConstraintCorrection<DataTypes>::bwdInit()
 {
@@ -355,7 +489,10 @@ void PrecomputedConstraintCorrection<DataTypes>::bwdInit()
         if (linearSolver)
             linearSolver->freezeSystemMatrix();
 
-        saveCompliance(invName);
+        // the dense compliance is saved unless it is replaced by its compressed form below,
+        // which is not done when the compliance is shared with another component
+        if (d_compressionTolerance.getValue() <= 0 || invM->nbref > 1)
+            saveCompliance(invName);
 
         // Restore gravity
         this->getContext()->setGravity(gravity);
@@ -380,13 +517,26 @@ void PrecomputedConstraintCorrection<DataTypes>::bwdInit()
             pos[i] = prev_pos[i];
     }
 
+    if (d_compressionTolerance.getValue() > 0 && invM->compressed == nullptr && invM->data != nullptr)
+    {
+        if (invM->nbref > 1)
+        {
+            msg_info() << "Compliance shared with another component, it is kept dense";
+        }
+        else
+        {
+            compressCompliance();
+            saveCompliance(invName);
+        }
+    }
+
     appCompliance = invM->data;
 
     // Optimisation for the computation of W
     _indexNodeSparseCompliance.resize(v0.size());
 
     //  Print 400 first row and column of the matrix
-    if (this->notMuted())
+    if (this->notMuted() && appCompliance)
     {
         msg_info() << "Matrix compliance : nbCols = " << nbCols << "  nbRows =" << nbRows;
 
@@ -468,7 +618,7 @@ void PrecomputedConstraintCorrection< DataTypes >::addComplianceInConstraintSpac
     m_activeDofs.sort();
     m_activeDofs.unique();
 
-    unsigned int offset, offset2;
+    Real block[complianceBlockSize];
     unsigned int ii,jj, it;
     Deriv Vbuf;
     it = 0;
@@ -491,15 +641,13 @@ void PrecomputedConstraintCorrection< DataTypes >::addComplianceInConstraintSpac
             for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != colItEnd; ++colIt)
             {
                 const Deriv n2 = colIt.val();
-                offset = dof_on_node * (NodeIdx * nbCols +  colIt.index());
+                getComplianceBlock(NodeIdx, colIt.index(), block);
 
                 for (ii = 0; ii < dof_on_node; ii++)
                 {
-                    offset2 = offset + ii * nbCols;
-
                     for (jj = 0; jj < dof_on_node; jj++)
                     {
-                        Vbuf[ii] += appCompliance[offset2 + jj] * n2[jj];
+                        Vbuf[ii] += block[ii * dof_on_node + jj] * n2[jj];
                     }
                 }
             }
@@ -558,7 +706,8 @@ void PrecomputedConstraintCorrection<DataTypes>::computeDx(Data<VecDeriv>& dx_d
     dx.resize(force.size());
 
     std::list<int>::const_iterator IterateurListe;
-    unsigned int i, offset, offset2;
+    unsigned int i;
+    Real block[complianceBlockSize];
 
     for (IterateurListe = activeDofs.begin(); IterateurListe != activeDofs.end(); ++IterateurListe)
     {
@@ -571,15 +720,14 @@ void PrecomputedConstraintCorrection<DataTypes>::computeDx(Data<VecDeriv>& dx_d
 
         for (unsigned int v = 0 ; v < dx.size() ; v++)
         {
-            offset =  v * dof_on_node * nbCols + f * dof_on_node;
+            getComplianceBlock(v, f, block);
             for (unsigned int j = 0; j < dof_on_node; j++)
             {
-                offset2 = offset + j * nbCols;
                 DXbuf = 0.0;
 
                 for (i = 0; i < dof_on_node; i++)
                 {
-                    DXbuf += appCompliance[ offset2 + i ] * Fbuf[i];
+                    DXbuf += block[j * dof_on_node + i] * Fbuf[i];
                 }
 
                 dx[v][j] += DXbuf;
@@ -727,7 +875,7 @@ void PrecomputedConstraintCorrection<DataTypes>::applyContactForce(const default
 
     std::list<int>::iterator IterateurListe;
     unsigned int i;
-    unsigned int offset, offset2;
+    Real block[complianceBlockSize];
     for (IterateurListe = activeDof.begin(); IterateurListe != activeDof.end(); ++IterateurListe)
     {
         int f = (*IterateurListe);
@@ -739,14 +887,13 @@ void PrecomputedConstraintCorrection<DataTypes>::applyContactForce(const default
 
         for(unsigned int v = 0 ; v < dx.size() ; v++)
         {
-            offset =  v * dof_on_node * nbCols + f*dof_on_node;
+            getComplianceBlock(v, f, block);
             for (unsigned int j=0; j< dof_on_node; j++)
             {
-                offset2 = offset+ j*nbCols;
                 DXbuf=0.0;
                 for (i = 0; i < dof_on_node; i++)
                 {
-                    DXbuf += appCompliance[ offset2 + i ] * Fbuf[i];
+                    DXbuf += block[j * dof_on_node + i] * Fbuf[i];
                 }
                 dx[v][j]+=DXbuf;
             }
@@ -775,11 +922,15 @@ void PrecomputedConstraintCorrection<DataTypes>::getComplianceMatrix(defaulttype
 {
     m->resize(dimensionAppCompliance,dimensionAppCompliance);
 
-    for (unsigned int l = 0; l < dimensionAppCompliance; ++l)
+    Real block[complianceBlockSize];
+    for (unsigned int l = 0; l < nbNodes; ++l)
     {
-        for (unsigned int c = 0; c < dimensionAppCompliance; ++c)
+        for (unsigned int c = 0; c < nbNodes; ++c)
         {
-            m->set(l, c, appCompliance[l * dimensionAppCompliance + c]);
+            getComplianceBlock(l, c, block);
+            for (unsigned int i = 0; i < dof_on_node; ++i)
+                for (unsigned int j = 0; j < dof_on_node; ++j)
+                    m->set(l * dof_on_node + i, c * dof_on_node + j, block[i * dof_on_node + j]);
         }
     }
 }
@@ -1075,7 +1226,7 @@ void PrecomputedConstraintCorrection<DataTypes>::resetForUnbuiltResolution(doubl
 
 #ifndef NEW_METHOD_UNBUILT
 
-    unsigned int offset, offset2;
+    Real block[complianceBlockSize];
     Deriv Vbuf;
     unsigned int it = 0;
 
@@ -1096,15 +1247,13 @@ void PrecomputedConstraintCorrection<DataTypes>::resetForUnbuiltResolution(doubl
 
             for (MatrixDerivColConstIterator colIt = rowIt.begin(); colIt != colItEnd; ++colIt)
             {
-                offset = dof_on_node * (NodeIdx * nbCols +  colIt.index());
+                getComplianceBlock(NodeIdx, colIt.index(), block);
 
                 for (unsigned int ii = 0; ii < dof_on_node; ii++)
                 {
-                    offset2 = offset + ii *nbCols;
-
                     for (unsigned int jj = 0; jj < dof_on_node; jj++)
                     {
-                        Vbuf[ii] += appCompliance[offset2 + jj] * colIt.val()[jj];
+                        Vbuf[ii] += block[ii * dof_on_node + jj] * colIt.val()[jj];
                     }
                 }
             }
@@ -1221,7 +1370,7 @@ void PrecomputedConstraintCorrection<DataTypes>::setConstraintDForce(double * /*
     if (!update)
         return;
 
-    unsigned int offset, offset2;
+    Real block[complianceBlockSize];
 
     for (int i = begin; i <= end; i++)
     {
@@ -1250,15 +1399,14 @@ void PrecomputedConstraintCorrection<DataTypes>::setConstraintDForce(double * /*
                 for (std::list< int >::const_iterator dofsIt = constraint_dofs.begin(); dofsIt != dofsItEnd; ++dofsIt)
                 {
                     int dof2 = *dofsIt;
-                    offset = dof2 * dof_on_node * nbCols + dof * dof_on_node;
+                    getComplianceBlock(dof2, dof, block);
 
                     for (unsigned int j = 0; j < dof_on_node; j++)
                     {
-                        offset2 = offset + j * nbCols;
                         DXbuf = 0.0;
                         for (unsigned int k = 0; k < dof_on_node; k++)
                         {
-                            DXbuf += appCompliance[ offset2 + k ] * Fbuf[k];
+                            DXbuf += block[j * dof_on_node + k] * Fbuf[k];
                         }
 
                         constraint_D[dof2][j] += DXbuf;
@@ -1315,7 +1463,7 @@ void PrecomputedConstraintCorrection<DataTypes>::getBlockDiagonalCompliance(defa
     localActiveDof.sort();
     localActiveDof.unique();
 
-    unsigned int offset, offset2;
+    Real block[complianceBlockSize];
     Deriv Vbuf;
     int it = 0;
     int it_localActiveDof = 0;
@@ -1346,15 +1494,13 @@ void PrecomputedConstraintCorrection<DataTypes>::getBlockDiagonalCompliance(defa
                 {
                     const Deriv n2 = colIt.val();
 
-                    offset = dof_on_node * (dof1 * nbCols +  colIt.index());
+                    getComplianceBlock(dof1, colIt.index(), block);
 
                     for (unsigned int ii = 0; ii < dof_on_node; ii++)
                     {
-                        offset2 = offset + ii * nbCols;
-
                         for (unsigned int jj = 0; jj < dof_on_node; jj++)
                         {
-                            Vbuf[ii] += appCompliance[offset2 + jj] * n2[jj];
+                            Vbuf[ii] += block[ii * dof_on_node + jj] * n2[jj];
                         }
                     }
                 }
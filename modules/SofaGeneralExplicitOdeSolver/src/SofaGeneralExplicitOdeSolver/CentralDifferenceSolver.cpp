@@ -35,6 +35,7 @@ using namespace core::behavior;
 CentralDifferenceSolver::CentralDifferenceSolver()
     : f_rayleighMass( initData(&f_rayleighMass,(SReal)0.0,"rayleighMass","Rayleigh damping coefficient related to mass"))
     , d_threadSafeVisitor(initData(&d_threadSafeVisitor, false, "threadSafeVisitor", "If true, do not use realloc and free visitors in fwdInteractionForceField."))
+    , d_directLumpedMass(initData(&d_directLumpedMass, true, "directLumpedMass", "If true and the solver subtree holds a single unmapped mechanical state with a mass, the components are called directly instead of through visitors."))
 {
 }
 
@@ -82,22 +83,37 @@ void CentralDifferenceSolver::solve(const core::ExecParams* params, SReal dt, so
     MultiVecDeriv vel(&vop, core::VecDerivId::velocity() );
     MultiVecCoord pos2(&vop, xResult /*core::VecCoordId::position()*/ );
     MultiVecDeriv vel2(&vop, vResult /*core::VecDerivId::velocity()*/ );
-    MultiVecDeriv dx(&vop, core::VecDerivId::dx()); dx.realloc(&vop, !d_threadSafeVisitor.getValue(), true);
+    MultiVecDeriv dx(&vop, core::VecDerivId::dx());
     MultiVecDeriv f  (&vop, core::VecDerivId::force() );
 
     const SReal r = f_rayleighMass.getValue();
 
-    mop.addSeparateGravity(dt);                // v += dt*g . Used if mass wants to added G separately from the other forces to v.
+    // A single unmapped state with a mass: the force, acceleration and update are computed
+    // by calling the components directly, without one graph traversal per operation
+    const bool direct = d_directLumpedMass.getValue() && m_lumpedMass.collect(this->getContext());
 
-    //projectVelocity(vel);                  // initial velocities are projected to the constrained space
+    if (direct)
+    {
+        m_lumpedMass.realloc(params, dx);
+        m_lumpedMass.addSeparateGravity(mop, dt, vel); // v += dt*g . Used if mass wants to added G separately from the other forces to v.
+        m_lumpedMass.computeAcc(mop, f, dx);           // dx = M^{-1} ( P_n - K u_n ), projected to the constrained space
+    }
+    else
+    {
+        dx.realloc(&vop, !d_threadSafeVisitor.getValue(), true);
+
+        mop.addSeparateGravity(dt);                // v += dt*g . Used if mass wants to added G separately from the other forces to v.
 
-    // compute the current force
-    mop.computeForce(f);                       // f = P_n - K u_n
+        //projectVelocity(vel);                  // initial velocities are projected to the constrained space
 
-    mop.accFromF(dx, f);                       // dx = M^{-1} ( P_n - K u_n )
-    mop.projectResponse(dx);                    // dx is projected to the constrained space
+        // compute the current force
+        mop.computeForce(f);                       // f = P_n - K u_n
 
-    mop.solveConstraint(dx, core::ConstraintParams::ACC);
+        mop.accFromF(dx, f);                       // dx = M^{-1} ( P_n - K u_n )
+        mop.projectResponse(dx);                    // dx is projected to the constrained space
+
+        mop.solveConstraint(dx, core::ConstraintParams::ACC);
+    }
     // apply the solution
     if (r==0)
     {
@@ -121,10 +137,18 @@ void CentralDifferenceSolver::solve(const core::ExecParams* params, SReal dt, so
         ops[1].second.push_back(std::make_pair(pos.id(),1.0));
         ops[1].second.push_back(std::make_pair(vel2.id(),dt));
 
-        vop.v_multiop(ops);
-
-        mop.solveConstraint(vel2,core::ConstraintParams::VEL);
-        mop.solveConstraint(pos2,core::ConstraintParams::POS);
+        if (direct)
+        {
+            // no constraint solver in the subtree, see LumpedMassOperations::collect
+            m_lumpedMass.vMultiOp(params, ops);
+        }
+        else
+        {
+            vop.v_multiop(ops);
+
+            mop.solveConstraint(vel2,core::ConstraintParams::VEL);
+            mop.solveConstraint(pos2,core::ConstraintParams::POS);
+        }
 #endif
     }
     else
@@ -147,10 +171,18 @@ void CentralDifferenceSolver::solve(const core::ExecParams* params, SReal dt, so
         ops[1].second.push_back(std::make_pair(pos.id(),1.0));
         ops[1].second.push_back(std::make_pair(vel2.id(),dt));
 
-        vop.v_multiop(ops);
-
-        mop.solveConstraint(vel2,core::ConstraintParams::VEL);
-        mop.solveConstraint(pos2,core::ConstraintParams::POS);
+        if (direct)
+        {
+            // no constraint solver in the subtree, see LumpedMassOperations::collect
+            m_lumpedMass.vMultiOp(params, ops);
+        }
+        else
+        {
+            vop.v_multiop(ops);
+
+            mop.solveConstraint(vel2,core::ConstraintParams::VEL);
+            mop.solveConstraint(pos2,core::ConstraintParams::POS);
+        }
 #endif
     }
 
@@ -23,6 +23,7 @@
 #include <SofaGeneralExplicitOdeSolver/config.h>
 
 #include <sofa/core/behavior/OdeSolver.h>
+#include <sofa/simulation/LumpedMassOperations.h>
 
 namespace sofa::component::odesolver
 {
@@ -44,6 +45,7 @@ public:
 
     Data<SReal> f_rayleighMass; ///< Rayleigh damping coefficient related to mass
     Data<bool> d_threadSafeVisitor;
+    Data<bool> d_directLumpedMass; ///< If true and the solver subtree holds a single unmapped mechanical state with a mass, the components are called directly instead of through visitors.
 
     /// Given an input derivative order (0 for position, 1 for velocity, 2 for acceleration),
     /// how much will it affect the output derivative of the given order.
@@ -74,6 +76,10 @@ public:
         else
             return vect[outputDerivative];
     }
+
+protected:
+    /// components of the subtree, when the visitors can be skipped
+    simulation::common::LumpedMassOperations m_lumpedMass;
 };
 
 } //namespace sofa::component::odesolver
@@ -0,0 +1,227 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaGeneralLinearSolver/AMGLinearSolver.h>
+
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaSimulationGraph/SimpleApi.h>
+#include <sofa/simulation/Node.h>
+
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest;
+
+#include <cmath>
+
+namespace
+{
+
+using namespace sofa::component::linearsolver;
+using sofa::defaulttype::Vec3d;
+
+using ScalarMatrix = CompressedRowSparseMatrix<double>;
+using BlockMatrix = CompressedRowSparseMatrix<sofa::defaulttype::Mat<3,3,double> >;
+using Vector = FullVector<double>;
+
+class AMGLinearSolver_test : public BaseTest
+{
+public:
+    /// Laplacian of a regular grid of n^3 nodes (7-point stencil) with Dirichlet boundary conditions
+    static void laplacian(ScalarMatrix& M, int n)
+    {
+        M.resize(n*n*n, n*n*n);
+        for (int z=0; z<n; ++z)
+            for (int y=0; y<n; ++y)
+                for (int x=0; x<n; ++x)
+                {
+                    const int i = x + n*(y + n*z);
+                    M.add(i, i, 6.0);
+                    if (x > 0)   M.add(i, i-1, -1.0);
+                    if (x < n-1) M.add(i, i+1, -1.0);
+                    if (y > 0)   M.add(i, i-n, -1.0);
+                    if (y < n-1) M.add(i, i+n, -1.0);
+                    if (z > 0)   M.add(i, i-n*n, -1.0);
+                    if (z < n-1) M.add(i, i+n*n, -1.0);
+                }
+        M.compress();
+    }
+
+    /// Stiffness matrix of a lattice of springs (edges, face and body diagonals of the cells) forming a bar along x,
+    /// clamped at x=0. The matrix is assembled both by 3x3 blocks and by scalars.
+    static void springBar(int nx, int ny, int nz, BlockMatrix& K, ScalarMatrix& check, sofa::helper::vector<Vec3d>& positions)
+    {
+        const int n = nx*ny*nz;
+        auto index = [&](int x, int y, int z) { return x + nx*(y + ny*z); };
+        positions.resize(n);
+        for (int z=0; z<nz; ++z)
+            for (int y=0; y<ny; ++y)
+                for (int x=0; x<nx; ++x)
+                    positions[index(x,y,z)] = Vec3d(x, y, z);
+
+        K.resize(3*n, 3*n);
+        check.resize(3*n, 3*n);
+        auto add = [&](int i, int j, double v)
+        {
+            K.add(i, j, v);
+            check.add(i, j, v);
+        };
+        auto fixed = [&](int i) { return i % nx == 0; };
+
+        for (int i=0; i<n; ++i)
+            if (fixed(i))
+                for (int c=0; c<3; ++c)
+                    add(3*i+c, 3*i+c, 1.0);
+
+        for (int z=0; z<nz; ++z)
+            for (int y=0; y<ny; ++y)
+                for (int x=0; x<nx; ++x)
+                    for (int dz=-1; dz<=1; ++dz)
+                        for (int dy=-1; dy<=1; ++dy)
+                            for (int dx=0; dx<=1; ++dx)
+                            {
+                                // each spring is visited once: dx > 0, or dx == 0 and (dy,dz) positive
+                                if (dx == 0 && (dy < 0 || (dy == 0 && dz <= 0))) continue;
+                                const int x2 = x+dx, y2 = y+dy, z2 = z+dz;
+                                if (x2 >= nx || y2 < 0 || y2 >= ny || z2 < 0 || z2 >= nz) continue;
+                                const int i = index(x,y,z), j = index(x2,y2,z2);
+                                Vec3d u = positions[j] - positions[i];
+                                u.normalize();
+                                for (int a=0; a<3; ++a)
+                                    for (int b=0; b<3; ++b)
+                                    {
+                                        const double k = 100.0 * u[a] * u[b];
+                                        if (!fixed(i)) add(3*i+a, 3*i+b, k);
+                                        if (!fixed(j)) add(3*j+a, 3*j+b, k);
+                                        if (!fixed(i) && !fixed(j))
+                                        {
+                                            add(3*i+a, 3*j+b, -k);
+                                            add(3*j+a, 3*i+b, -k);
+                                        }
+                                    }
+                            }
+        K.compress();
+        check.compress();
+    }
+
+    static void rightHandSide(Vector& b, int n)
+    {
+        b.resize(n);
+        for (int i=0; i<n; ++i)
+            b[i] = 1.0 + 0.5*std::sin(double(i));
+    }
+
+    /// Relative residual ||b - Mx|| / ||b||
+    static double residual(const ScalarMatrix& M, const Vector& b, const Vector& x)
+    {
+        Vector r(b.size());
+        M.mul(r, x);
+        double rr = 0, bb = 0;
+        for (Vector::Index i=0; i<b.size(); ++i)
+        {
+            rr += (b[i] - r[i]) * (b[i] - r[i]);
+            bb += b[i] * b[i];
+        }
+        return std::sqrt(rr / bb);
+    }
+
+    template<class Matrix>
+    static double solve(AMGLinearSolver<Matrix, Vector>* solver, Matrix& M, const ScalarMatrix& check, Vector& b)
+    {
+        solver->invert(M);
+        Vector x(b.size());
+        solver->solve(M, x, b);
+        return residual(check, b, x);
+    }
+};
+
+TEST_F(AMGLinearSolver_test, poissonConvergence)
+{
+    // the number of iterations does not depend on the size of the problem
+    for (int n : { 8, 24 })
+    {
+        ScalarMatrix M;
+        laplacian(M, n);
+        Vector b;
+        rightHandSide(b, M.rowSize());
+
+        auto solver = sofa::core::objectmodel::New< AMGLinearSolver<ScalarMatrix, Vector> >();
+        solver->d_coarseSize.setValue(50);
+        solver->d_maxIter.setValue(15);
+        solver->d_tolerance.setValue(1e-8);
+        solver->init();
+        EXPECT_LT(solve(solver.get(), M, M, b), 1e-8) << "n = " << n;
+    }
+}
+
+TEST_F(AMGLinearSolver_test, iterativeCoarseSolve)
+{
+    ScalarMatrix M;
+    laplacian(M, 16);
+    Vector b;
+    rightHandSide(b, M.rowSize());
+
+    auto solver = sofa::core::objectmodel::New< AMGLinearSolver<ScalarMatrix, Vector> >();
+    solver->d_maxLevels.setValue(2);
+    solver->d_maxDirectSize.setValue(100);
+    
+    solver->d_maxIter.setValue(30);
+    solver->d_tolerance.setValue(1e-8);
+    solver->init();
+    EXPECT_LT(solve(solver.get(), M, M, b), 1e-8);
+}
+
+TEST_F(AMGLinearSolver_test, elasticityRotations)
+{
+    BlockMatrix K;
+    ScalarMatrix check;
+    sofa::helper::vector<Vec3d> positions;
+    springBar(40, 4, 4, K, check, positions);
+    Vector b;
+    rightHandSide(b, K.rowSize());
+
+    // the rotations of the near null space are computed from the positions of the mechanical state of the context
+    auto simulation = sofa::simpleapi::createSimulation("DAG");
+    auto root = sofa::simpleapi::createRootNode(simulation, "root");
+    auto mstate = sofa::core::objectmodel::New< sofa::component::container::MechanicalObject<sofa::defaulttype::Vec3Types> >();
+    root->addObject(mstate);
+    mstate->resize(positions.size());
+    mstate->x.setValue(positions);
+
+    double residuals[2];
+    for (bool rotations : { false, true })
+    {
+        auto solver = sofa::core::objectmodel::New< AMGLinearSolver<BlockMatrix, Vector> >();
+        root->addObject(solver);
+
+        solver->d_rotations.setValue(rotations);
+        solver->d_coarseSize.setValue(60);
+        solver->d_maxIter.setValue(20);
+        solver->d_tolerance.setValue(1e-12);
+        solver->init();
+        residuals[rotations] = solve(solver.get(), K, check, b);
+        root->removeObject(solver);
+    }
+
+    // the bending modes of the bar are captured by the rotations: the convergence is much faster
+    EXPECT_LT(residuals[1], 1e-6);
+    EXPECT_LT(residuals[1], 0.01 * residuals[0]);
+}
+
+} // namespace
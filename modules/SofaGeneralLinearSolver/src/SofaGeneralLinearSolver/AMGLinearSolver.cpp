@@ -0,0 +1,41 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#define SOFA_COMPONENT_LINEARSOLVER_AMGLINEARSOLVER_CPP
+#include <SofaGeneralLinearSolver/AMGLinearSolver.inl>
+
+#include <sofa/core/ObjectFactory.h>
+
+namespace sofa::component::linearsolver
+{
+
+using namespace sofa::defaulttype;
+
+int AMGLinearSolverClass = core::RegisterObject("Linear system solver / preconditioner based on smoothed aggregation algebraic multigrid")
+        .add< AMGLinearSolver< CompressedRowSparseMatrix<Mat<3,3,double> >, FullVector<double> > >(true)
+        .add< AMGLinearSolver< CompressedRowSparseMatrix<double>, FullVector<double> > >()
+        .addAlias("AMGSolver")
+        ;
+
+template class SOFA_SOFAGENERALLINEARSOLVER_API AMGLinearSolver< CompressedRowSparseMatrix<double>, FullVector<double> >;
+template class SOFA_SOFAGENERALLINEARSOLVER_API AMGLinearSolver< CompressedRowSparseMatrix<Mat<3,3,double> >, FullVector<double> >;
+
+} //namespace sofa::component::linearsolver
@@ -0,0 +1,161 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+#include <SofaGeneralLinearSolver/config.h>
+
+#include <SofaBaseLinearSolver/MatrixLinearSolver.h>
+#include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
+#include <SofaBaseLinearSolver/FullVector.h>
+#include <sofa/helper/vector.h>
+
+#include <functional>
+
+namespace sofa::component::linearsolver
+{
+
+/// Linear system solver / preconditioner based on smoothed aggregation algebraic multigrid (AMG)
+///
+/// The hierarchy of coarser systems is built from the matrix: the nodes (blocks of the matrix) are grouped into
+/// aggregates following the strong connections of the matrix, the tentative prolongator interpolates the near null space
+/// of each aggregate and is smoothed with one damped Jacobi iteration, and the coarse matrices are the Galerkin
+/// products P^T A P. The near null space contains the translations of the nodes and, for 3D elasticity, their rigid
+/// rotations, computed from the positions of the mechanical state of the context when the hierarchy is built.
+/// The aggregates and the sparsity patterns of the hierarchy are kept as long as the pattern of the matrix does not
+/// change, so that only the numerical values are recomputed at each step.
+/// Each level uses a Chebyshev polynomial smoother, which only requires matrix-vector products and can be parallelized.
+///
+/// With cg enabled, the V-cycle preconditions a conjugate gradient. To be used as a preconditioner of another solver
+/// (e.g. ShewchukPCGLinearSolver), disable cg and set iterations to 1 so that a single V-cycle is applied.
+template<class TMatrix, class TVector>
+class AMGLinearSolver : public sofa::component::linearsolver::MatrixLinearSolver<TMatrix, TVector>
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE2(AMGLinearSolver,TMatrix,TVector),SOFA_TEMPLATE2(sofa::component::linearsolver::MatrixLinearSolver,TMatrix,TVector));
+
+    typedef TMatrix Matrix;
+    typedef TVector Vector;
+    typedef typename Matrix::Index Index;
+    typedef sofa::component::linearsolver::MatrixLinearSolver<TMatrix,TVector> Inherit;
+
+    Data<unsigned> d_maxIter; ///< maximum number of iterations (conjugate gradient iterations if cg is enabled, V-cycles otherwise)
+    Data<double> d_tolerance; ///< desired precision of the solution (ratio of the residual norm over the right-hand side norm)
+    Data<bool> d_useCG; ///< use the V-cycle as the preconditioner of a conjugate gradient
+    Data<unsigned> d_maxLevels; ///< maximum number of levels of the hierarchy
+    Data<unsigned> d_coarseSize; ///< size of the system below which it is solved with a direct solver
+    Data<unsigned> d_maxDirectSize; ///< maximum size of the coarsest system solved with a dense direct solver, larger systems are solved iteratively
+    Data<double> d_strengthThreshold; ///< threshold on the normalized strength of connection between two nodes to aggregate them
+    Data<unsigned> d_smootherDegree; ///< degree of the Chebyshev polynomial smoother
+    Data<bool> d_smoothProlongation; ///< smooth the tentative prolongator with a damped Jacobi iteration
+    Data<bool> d_rotations; ///< add the rigid rotations of the nodes to the near null space (3 dofs per node, positions of the mechanical state)
+    Data<bool> d_multithreading; ///< parallelize the smoothers and the numerical setup of the hierarchy
+
+protected:
+    AMGLinearSolver();
+
+public:
+    void init() override;
+
+    /// Build or update the hierarchy from the matrix
+    void invert(Matrix& M) override;
+
+    /// Solve Mx=b
+    void solve (Matrix& M, Vector& x, Vector& b) override;
+
+protected:
+
+    /// Scalar sparse matrix stored by rows with sorted columns, used for each level of the hierarchy
+    class LevelMatrix
+    {
+    public:
+        Index nRow = 0;
+        Index nCol = 0;
+        helper::vector<Index> rowBegin;
+        helper::vector<Index> colsIndex;
+        helper::vector<double> values;
+    };
+
+    /// One level of the multigrid hierarchy
+    class Level
+    {
+    public:
+        LevelMatrix A;
+        helper::vector<double> invDiag;
+        double rho = 1.0; ///< estimation of the spectral radius of D^-1 A
+
+        helper::vector<Index> nodeBegin; ///< first row of each node, the rows of a node being contiguous
+        helper::vector<double> nullSpace; ///< near null space vectors, stored by rows
+
+        helper::vector<Index> aggregate; ///< aggregate of each node (-1 for isolated nodes)
+        Index nbAggregates = 0;
+        helper::vector<Index> coarseBegin; ///< first row of each aggregate in the next level
+        LevelMatrix T; ///< tentative prolongator from the next level
+
+        LevelMatrix P; ///< prolongator from the next level
+        LevelMatrix R; ///< restriction to the next level (P^T)
+        helper::vector<Index> rEntry; ///< entry of P corresponding to each entry of R
+        LevelMatrix AP; ///< A * P
+
+        helper::vector<double> x, b, r, d, t; ///< work vectors
+    };
+
+    void parallelFor(Index n, const std::function<void(Index,Index)>& f);
+
+    void multiply(const LevelMatrix& A, const helper::vector<double>& x, helper::vector<double>& y);
+    static void multiplySymbolic(const LevelMatrix& A, const LevelMatrix& B, LevelMatrix& C);
+    void multiplyNumeric(const LevelMatrix& A, const LevelMatrix& B, LevelMatrix& C);
+
+    void setupSmoother(Level& level);
+    /// Nodes and near null space of the finest level
+    void computeNullSpace(Level& level);
+    void computeAggregates(Level& level);
+    /// Orthonormalize the near null space on each aggregate: Q is the tentative prolongator, R the coarse near null space
+    void computeTentative(Level& level, helper::vector<double>& coarseNullSpace);
+    void prolongationSymbolic(Level& level);
+    void prolongationNumeric(Level& level);
+    void factorizeCoarse(const LevelMatrix& A);
+    void solveCoarse(Level& level);
+
+    void smooth(Level& level);
+    void vcycle(std::size_t l);
+    /// Apply the preconditioner on the finest level: x = V(b)
+    void applyPreconditioner(const helper::vector<double>& b, helper::vector<double>& x);
+
+    helper::vector<Level> m_levels;
+    Index m_nullSpaceSize = 0; ///< number of near null space vectors
+    bool m_coarseIterative = false; ///< the coarsest system is too large for the dense direct solver
+    helper::vector<double> m_coarseLU;
+    helper::vector<Index> m_coarsePivots;
+
+    /// pattern of the matrix used to build the hierarchy
+    typename Matrix::VecIndex m_rowIndex, m_rowBegin, m_colsIndex;
+    /// scalar position in the values of the matrix of each entry of the finest level
+    helper::vector<Index> m_source;
+
+    helper::vector<double> m_x, m_r, m_z, m_p, m_q;
+};
+
+#if !defined(SOFA_COMPONENT_LINEARSOLVER_AMGLINEARSOLVER_CPP)
+extern template class SOFA_SOFAGENERALLINEARSOLVER_API AMGLinearSolver< CompressedRowSparseMatrix<double>, FullVector<double> >;
+extern template class SOFA_SOFAGENERALLINEARSOLVER_API AMGLinearSolver< CompressedRowSparseMatrix<defaulttype::Mat<3,3,double> >, FullVector<double> >;
+#endif
+
+} //namespace sofa::component::linearsolver
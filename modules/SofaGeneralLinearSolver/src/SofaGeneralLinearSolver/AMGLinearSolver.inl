@@ -0,0 +1,969 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+#include <SofaGeneralLinearSolver/AMGLinearSolver.h>
+#include <sofa/simulation/ParallelForRange.h>
+#include <sofa/core/behavior/BaseMechanicalState.h>
+#include <sofa/helper/AdvancedTimer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace sofa::component::linearsolver
+{
+
+namespace amg
+{
+
+inline double dot(const helper::vector<double>& a, const helper::vector<double>& b)
+{
+    double s = 0.0;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        s += a[i] * b[i];
+    return s;
+}
+
+/// Relative tolerance of the conjugate gradient solving the coarsest system when it is too large for the direct solver
+constexpr double coarseTolerance = 1e-10;
+
+} // namespace amg
+
+template<class TMatrix, class TVector>
+AMGLinearSolver<TMatrix,TVector>::AMGLinearSolver()
+    : d_maxIter( initData(&d_maxIter,(unsigned)25,"iterations","maximum number of iterations (conjugate gradient iterations if cg is enabled, V-cycles otherwise)") )
+    , d_tolerance( initData(&d_tolerance,1e-5,"tolerance","desired precision of the solution (ratio of the residual norm over the right-hand side norm)") )
+    , d_useCG( initData(&d_useCG,true,"cg","use the V-cycle as the preconditioner of a conjugate gradient") )
+    , d_maxLevels( initData(&d_maxLevels,(unsigned)10,"maxLevels","maximum number of levels of the hierarchy") )
+    , d_coarseSize( initData(&d_coarseSize,(unsigned)300,"coarseSize","size of the system below which it is solved with a direct solver") )
+    , d_maxDirectSize( initData(&d_maxDirectSize,(unsigned)5000,"maxDirectSize","maximum size of the coarsest system solved with a dense direct solver, larger systems are solved iteratively") )
+    , d_strengthThreshold( initData(&d_strengthThreshold,0.08,"strengthThreshold","threshold on the normalized strength of connection between two nodes to aggregate them") )
+    , d_smootherDegree( initData(&d_smootherDegree,(unsigned)2,"smootherDegree","degree of the Chebyshev polynomial smoother") )
+    , d_smoothProlongation( initData(&d_smoothProlongation,true,"smoothProlongation","smooth the tentative prolongator with a damped Jacobi iteration") )
+    , d_rotations( initData(&d_rotations,true,"rotations","add the rigid rotations of the nodes to the near null space (3 dofs per node, positions of the mechanical state)") )
+    , d_multithreading( initData(&d_multithreading,false,"multithreading","parallelize the smoothers and the numerical setup of the hierarchy") )
+{
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::init()
+{
+    Inherit::init();
+    if (d_multithreading.getValue())
+        simulation::initTaskScheduler();
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::parallelFor(Index n, const std::function<void(Index,Index)>& f)
+{
+    simulation::TaskScheduler* taskScheduler = d_multithreading.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    simulation::parallelForRange(taskScheduler, 0, std::size_t(n), 1024, [&f](std::size_t begin, std::size_t end)
+    {
+        f(Index(begin), Index(end));
+    });
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::multiply(const LevelMatrix& A, const helper::vector<double>& x, helper::vector<double>& y)
+{
+    y.resize(A.nRow);
+    parallelFor(A.nRow, [&](Index begin, Index end)
+    {
+        for (Index i = begin; i < end; ++i)
+        {
+            double s = 0.0;
+            for (Index p = A.rowBegin[i]; p < A.rowBegin[i+1]; ++p)
+                s += A.values[p] * x[A.colsIndex[p]];
+            y[i] = s;
+        }
+    });
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::multiplySymbolic(const LevelMatrix& A, const LevelMatrix& B, LevelMatrix& C)
+{
+    C.nRow = A.nRow;
+    C.nCol = B.nCol;
+    C.rowBegin.resize(A.nRow + 1);
+    C.colsIndex.clear();
+
+    helper::vector<Index> marker(B.nCol, -1);
+    helper::vector<Index> row;
+    for (Index i = 0; i < A.nRow; ++i)
+    {
+        row.clear();
+        for (Index p = A.rowBegin[i]; p < A.rowBegin[i+1]; ++p)
+        {
+            const Index k = A.colsIndex[p];
+            for (Index q = B.rowBegin[k]; q < B.rowBegin[k+1]; ++q)
+            {
+                const Index j = B.colsIndex[q];
+                if (marker[j] != i)
+                {
+                    marker[j] = i;
+                    row.push_back(j);
+                }
+            }
+        }
+        std::sort(row.begin(), row.end());
+        C.rowBegin[i] = Index(C.colsIndex.size());
+        C.colsIndex.insert(C.colsIndex.end(), row.begin(), row.end());
+    }
+    C.rowBegin[A.nRow] = Index(C.colsIndex.size());
+    C.values.resize(C.colsIndex.size());
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::multiplyNumeric(const LevelMatrix& A, const LevelMatrix& B, LevelMatrix& C)
+{
+    parallelFor(C.nRow, [&](Index begin, Index end)
+    {
+        for (Index i = begin; i < end; ++i)
+        {
+            std::fill(C.values.begin() + C.rowBegin[i], C.values.begin() + C.rowBegin[i+1], 0.0);
+            for (Index p = A.rowBegin[i]; p < A.rowBegin[i+1]; ++p)
+            {
+                const double a = A.values[p];
+                const Index k = A.colsIndex[p];
+                // the columns of the rows of B and C are sorted, the entries of C are found by a linear scan
+                Index c = C.rowBegin[i];
+                for (Index q = B.rowBegin[k]; q < B.rowBegin[k+1]; ++q)
+                {
+                    while (C.colsIndex[c] < B.colsIndex[q]) ++c;
+                    C.values[c] += a * B.values[q];
+                }
+            }
+        }
+    });
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::setupSmoother(Level& level)
+{
+    const LevelMatrix& A = level.A;
+    const Index n = A.nRow;
+
+    level.invDiag.assign(n, 0.0);
+    for (Index i = 0; i < n; ++i)
+        for (Index p = A.rowBegin[i]; p < A.rowBegin[i+1]; ++p)
+            if (A.colsIndex[p] == i && A.values[p] != 0)
+                level.invDiag[i] = 1.0 / A.values[p];
+
+    level.x.resize(n);
+    level.b.resize(n);
+    level.r.resize(n);
+    level.d.resize(n);
+    level.t.resize(n);
+
+    // Gershgorin bound of the spectral radius of D^-1 A
+    double bound = 0.0;
+    for (Index i = 0; i < n; ++i)
+    {
+        double s = 0.0;
+        for (Index p = A.rowBegin[i]; p < A.rowBegin[i+1]; ++p)
+            s += std::abs(A.values[p]);
+        bound = std::max(bound, s * std::abs(level.invDiag[i]));
+    }
+
+    // estimation of the spectral radius of D^-1 A using a few power iterations, started from a pseudo-random
+    // vector: a smooth one is nearly orthogonal to the oscillating modes and underestimates the largest eigenvalue
+    helper::vector<double>& v = level.d;
+    helper::vector<double>& w = level.t;
+    std::minstd_rand generator(12345);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+    for (Index i = 0; i < n; ++i)
+        v[i] = distribution(generator);
+    double rho = 0.0;
+    for (int it = 0; it < 20; ++it)
+    {
+        multiply(A, v, w);
+        for (Index i = 0; i < n; ++i)
+            w[i] *= level.invDiag[i];
+        const double normV = std::sqrt(amg::dot(v, v));
+        const double normW = std::sqrt(amg::dot(w, w));
+        if (normV == 0 || normW == 0) break;
+        rho = normW / normV;
+        for (Index i = 0; i < n; ++i)
+            v[i] = w[i] / normW;
+    }
+    // the Chebyshev smoother diverges on the eigenvalues above its interval: the estimation is enlarged, up to the bound
+    level.rho = (rho > 0) ? std::min(1.1 * rho, bound) : 1.0;
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::computeNullSpace(Level& level)
+{
+    const Index n = level.A.nRow;
+
+    // the rotations require the positions of the nodes, each node having 3 dofs
+    const core::behavior::BaseMechanicalState* mstate = d_rotations.getValue() ? this->getContext()->getMechanicalState() : nullptr;
+    const bool rotations = mstate != nullptr && mstate->getDerivDimension() == 3 && Index(mstate->getSize()) * 3 == n;
+    if (d_rotations.getValue() && !rotations)
+        msg_info() << "The positions of the nodes are not available, only the translations are used as near null space.";
+
+    const Index bs = rotations ? 3 : Index(Matrix::NL);
+    const Index nNodes = (n + bs - 1) / bs;
+    level.nodeBegin.resize(nNodes + 1);
+    for (Index I = 0; I < nNodes; ++I)
+        level.nodeBegin[I] = I * bs;
+    level.nodeBegin[nNodes] = n;
+
+    const Index k = rotations ? 6 : bs;
+    m_nullSpaceSize = k;
+    level.nullSpace.assign(std::size_t(n) * k, 0.0);
+    for (Index i = 0; i < n; ++i)
+        level.nullSpace[std::size_t(i)*k + i%bs] = 1.0;
+    if (!rotations)
+        return;
+
+    // rotations around the center of the nodes: (e_c x p) for each axis c
+    double center[3] = { 0.0, 0.0, 0.0 };
+    for (Index I = 0; I < nNodes; ++I)
+    {
+        center[0] += mstate->getPX(I);
+        center[1] += mstate->getPY(I);
+        center[2] += mstate->getPZ(I);
+    }
+    for (double& c : center)
+        c /= double(std::max(nNodes, Index(1)));
+
+    for (Index I = 0; I < nNodes; ++I)
+    {
+        const double x = mstate->getPX(I) - center[0];
+        const double y = mstate->getPY(I) - center[1];
+        const double z = mstate->getPZ(I) - center[2];
+        double* row = &level.nullSpace[std::size_t(3*I)*k];
+        row[3]     = 0.0; row[4]     =   z; row[5]     =  -y;
+        row[k+3]   =  -z; row[k+4]   = 0.0; row[k+5]   =   x;
+        row[2*k+3] =   y; row[2*k+4] =  -x; row[2*k+5] = 0.0;
+    }
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::computeAggregates(Level& level)
+{
+    const LevelMatrix& A = level.A;
+    const helper::vector<Index>& nodeBegin = level.nodeBegin;
+    const Index nNodes = Index(nodeBegin.size()) - 1;
+    const double theta2 = d_strengthThreshold.getValue() * d_strengthThreshold.getValue();
+
+    helper::vector<Index> rowNode(A.nRow);
+    for (Index I = 0; I < nNodes; ++I)
+        for (Index i = nodeBegin[I]; i < nodeBegin[I+1]; ++i)
+            rowNode[i] = I;
+
+    // squared Frobenius norms of the diagonal blocks
+    helper::vector<double> diagNorm(nNodes, 0.0);
+    for (Index i = 0; i < A.nRow; ++i)
+        for (Index p = A.rowBegin[i]; p < A.rowBegin[i+1]; ++p)
+            if (rowNode[A.colsIndex[p]] == rowNode[i])
+                diagNorm[rowNode[i]] += A.values[p] * A.values[p];
+
+    // strong connections: ||A_IJ|| >= theta sqrt(||A_II|| ||A_JJ||)
+    helper::vector<Index> strongBegin(nNodes + 1);
+    helper::vector<Index> strong;
+    helper::vector<double> weight(nNodes, 0.0);
+    helper::vector<Index> marker(nNodes, -1);
+    helper::vector<Index> neighbors;
+    for (Index I = 0; I < nNodes; ++I)
+    {
+        neighbors.clear();
+        for (Index i = nodeBegin[I]; i < nodeBegin[I+1]; ++i)
+        {
+            for (Index p = A.rowBegin[i]; p < A.rowBegin[i+1]; ++p)
+            {
+                const Index J = rowNode[A.colsIndex[p]];
+                if (J == I) continue;
+                if (marker[J] != I)
+                {
+                    marker[J] = I;
+                    weight[J] = 0.0;
+                    neighbors.push_back(J);
+                }
+                weight[J] += A.values[p] * A.values[p];
+            }
+        }
+        strongBegin[I] = Index(strong.size());
+        for (Index J : neighbors)
+            if (weight[J] > 0 && weight[J] >= theta2 * std::sqrt(diagNorm[I] * diagNorm[J]))
+                strong.push_back(J);
+    }
+    strongBegin[nNodes] = Index(strong.size());
+    helper::vector<Index>& aggregate = level.aggregate;
+    aggregate.assign(nNodes, -1);
+    Index nbAggregates = 0;
+    auto isolated = [&](Index I) { return strongBegin[I] == strongBegin[I+1]; };
+
+    // first pass: nodes whose strong neighborhood is free form a new aggregate with it
+    for (Index I = 0; I < nNodes; ++I)
+    {
+        if (aggregate[I] != -1 || isolated(I)) continue;
+        bool free = true;
+        for (Index s = strongBegin[I]; s < strongBegin[I+1] && free; ++s)
+            free = (aggregate[strong[s]] == -1);
+        if (!free) continue;
+        aggregate[I] = nbAggregates;
+        for (Index s = strongBegin[I]; s < strongBegin[I+1]; ++s)
+            aggregate[strong[s]] = nbAggregates;
+        ++nbAggregates;
+    }
+
+    // second pass: remaining nodes join an aggregate of the first pass they are strongly connected to
+    const helper::vector<Index> firstPass = aggregate;
+    for (Index I = 0; I < nNodes; ++I)
+    {
+        if (aggregate[I] != -1 || isolated(I)) continue;
+        for (Index s = strongBegin[I]; s < strongBegin[I+1]; ++s)
+        {
+            if (firstPass[strong[s]] != -1)
+            {
+                aggregate[I] = firstPass[strong[s]];
+                break;
+            }
+        }
+    }
+
+    // last pass: left over nodes (only possible with non symmetric connections) form new aggregates
+    for (Index I = 0; I < nNodes; ++I)
+    {
+        if (aggregate[I] != -1 || isolated(I)) continue;
+        aggregate[I] = nbAggregates;
+        for (Index s = strongBegin[I]; s < strongBegin[I+1]; ++s)
+            if (aggregate[strong[s]] == -1)
+                aggregate[strong[s]] = nbAggregates;
+        ++nbAggregates;
+    }
+    level.nbAggregates = nbAggregates;
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::computeTentative(Level& level, helper::vector<double>& coarseNullSpace)
+{
+    const Index k = m_nullSpaceSize;
+    const Index n = level.A.nRow;
+    const Index nNodes = Index(level.nodeBegin.size()) - 1;
+    const Index nbAggregates = level.nbAggregates;
+
+    // rows of each aggregate
+    helper::vector<Index> aggregateBegin(nbAggregates + 1, 0);
+    for (Index I = 0; I < nNodes; ++I)
+        if (level.aggregate[I] >= 0)
+            aggregateBegin[level.aggregate[I] + 1] += level.nodeBegin[I+1] - level.nodeBegin[I];
+    for (Index a = 0; a < nbAggregates; ++a)
+        aggregateBegin[a+1] += aggregateBegin[a];
+    helper::vector<Index> aggregateRows(aggregateBegin[nbAggregates]);
+    {
+        helper::vector<Index> pos(aggregateBegin.begin(), aggregateBegin.end() - 1);
+        for (Index I = 0; I < nNodes; ++I)
+            if (level.aggregate[I] >= 0)
+                for (Index i = level.nodeBegin[I]; i < level.nodeBegin[I+1]; ++i)
+                    aggregateRows[pos[level.aggregate[I]]++] = i;
+    }
+
+    // modified Gram-Schmidt on each aggregate, dropping the vectors which are linearly dependent on the previous ones
+    // (e.g. the rotation around the axis of an aggregate of aligned nodes)
+    helper::vector<Index> rowCols(n, 0); // number of columns of the tentative prolongator on each row
+    helper::vector<double> rowValues(std::size_t(n) * k, 0.0);
+    helper::vector<double> q, r;
+    level.coarseBegin.resize(nbAggregates + 1);
+    coarseNullSpace.clear();
+    Index nCoarse = 0;
+    for (Index a = 0; a < nbAggregates; ++a)
+    {
+        const Index m = aggregateBegin[a+1] - aggregateBegin[a];
+        const Index* rows = aggregateRows.data() + aggregateBegin[a];
+        q.assign(std::size_t(m) * k, 0.0); // kept vectors, by columns
+        r.assign(std::size_t(k) * k, 0.0);
+        Index kept = 0;
+        for (Index c = 0; c < k; ++c)
+        {
+            double* v = &q[std::size_t(kept) * m];
+            for (Index i = 0; i < m; ++i)
+                v[i] = level.nullSpace[std::size_t(rows[i])*k + c];
+            const double norm0 = std::sqrt(std::inner_product(v, v + m, v, 0.0));
+            if (norm0 == 0) continue;
+            for (int pass = 0; pass < 2; ++pass)
+            {
+                for (Index j = 0; j < kept; ++j)
+                {
+                    const double* qj = &q[std::size_t(j) * m];
+                    const double rjc = std::inner_product(qj, qj + m, v, 0.0);
+                    r[std::size_t(j)*k + c] += rjc;
+                    for (Index i = 0; i < m; ++i)
+                        v[i] -= rjc * qj[i];
+                }
+            }
+            const double norm = std::sqrt(std::inner_product(v, v + m, v, 0.0));
+            if (norm <= 1e-8 * norm0) continue;
+            for (Index i = 0; i < m; ++i)
+                v[i] /= norm;
+            r[std::size_t(kept)*k + c] = norm;
+            ++kept;
+        }
+
+        level.coarseBegin[a] = nCoarse;
+        nCoarse += kept;
+        coarseNullSpace.insert(coarseNullSpace.end(), r.begin(), r.begin() + std::size_t(kept) * k);
+        for (Index i = 0; i < m; ++i)
+        {
+            rowCols[rows[i]] = kept;
+            for (Index j = 0; j < kept; ++j)
+                rowValues[std::size_t(rows[i])*k + j] = q[std::size_t(j)*m + i];
+        }
+    }
+    level.coarseBegin[nbAggregates] = nCoarse;
+
+    LevelMatrix& T = level.T;
+    T.nRow = n;
+    T.nCol = nCoarse;
+    T.rowBegin.resize(n + 1);
+    T.rowBegin[0] = 0;
+    for (Index i = 0; i < n; ++i)
+        T.rowBegin[i+1] = T.rowBegin[i] + rowCols[i];
+    T.colsIndex.resize(T.rowBegin[n]);
+    T.values.resize(T.rowBegin[n]);
+    for (Index I = 0; I < nNodes; ++I)
+    {
+        const Index a = level.aggregate[I];
+        if (a < 0) continue;
+        for (Index i = level.nodeBegin[I]; i < level.nodeBegin[I+1]; ++i)
+        {
+            for (Index j = 0; j < rowCols[i]; ++j)
+            {
+                T.colsIndex[T.rowBegin[i] + j] = level.coarseBegin[a] + j;
+                T.values[T.rowBegin[i] + j] = rowValues[std::size_t(i)*k + j];
+            }
+        }
+    }
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::prolongationSymbolic(Level& level)
+{
+    const LevelMatrix& A = level.A;
+    const LevelMatrix& T = level.T;
+    const bool smoothed = d_smoothProlongation.getValue();
+
+    // pattern of P = (I - omega D^-1 A) T
+    LevelMatrix& P = level.P;
+    P.nRow = A.nRow;
+    P.nCol = T.nCol;
+    P.rowBegin.resize(A.nRow + 1);
+    P.colsIndex.clear();
+    helper::vector<Index> marker(P.nCol, -1);
+    helper::vector<Index> row;
+    auto addRowOfT = [&](Index i, Index j)
+    {
+        for (Index q = T.rowBegin[j]; q < T.rowBegin[j+1]; ++q)
+        {
+            const Index c = T.colsIndex[q];
+            if (marker[c] != i)
+            {
+                marker[c] = i;
+                row.push_back(c);
+            }
+        }
+    };
+    for (Index i = 0; i < A.nRow; ++i)
+    {
+        row.clear();
+        addRowOfT(i, i);
+        if (smoothed)
+            for (Index p = A.rowBegin[i]; p < A.rowBegin[i+1]; ++p)
+                addRowOfT(i, A.colsIndex[p]);
+        std::sort(row.begin(), row.end());
+        P.rowBegin[i] = Index(P.colsIndex.size());
+        P.colsIndex.insert(P.colsIndex.end(), row.begin(), row.end());
+    }
+    P.rowBegin[A.nRow] = Index(P.colsIndex.size());
+    P.values.resize(P.colsIndex.size());
+    // restriction R = P^T
+    LevelMatrix& R = level.R;
+    R.nRow = P.nCol;
+    R.nCol = P.nRow;
+    R.rowBegin.assign(R.nRow + 1, 0);
+    for (Index c : P.colsIndex)
+        ++R.rowBegin[c+1];
+    for (Index i = 0; i < R.nRow; ++i)
+        R.rowBegin[i+1] += R.rowBegin[i];
+    R.colsIndex.resize(P.colsIndex.size());
+    R.values.resize(P.colsIndex.size());
+    level.rEntry.resize(P.colsIndex.size());
+    helper::vector<Index> pos(R.rowBegin.begin(), R.rowBegin.end() - 1);
+    for (Index i = 0; i < P.nRow; ++i)
+    {
+        for (Index p = P.rowBegin[i]; p < P.rowBegin[i+1]; ++p)
+        {
+            const Index q = pos[P.colsIndex[p]]++;
+            R.colsIndex[q] = i;
+            level.rEntry[q] = p;
+        }
+    }
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::prolongationNumeric(Level& level)
+{
+    const LevelMatrix& A = level.A;
+    const LevelMatrix& T = level.T;
+    LevelMatrix& P = level.P;
+    const bool smoothed = d_smoothProlongation.getValue();
+    const double omega = 4.0 / (3.0 * level.rho);
+
+    // P = (I - omega D^-1 A) T
+    parallelFor(P.nRow, [&](Index begin, Index end)
+    {
+        for (Index i = begin; i < end; ++i)
+        {
+            auto rowBegin = P.colsIndex.begin() + P.rowBegin[i];
+            auto rowEnd = P.colsIndex.begin() + P.rowBegin[i+1];
+            std::fill(P.values.begin() + P.rowBegin[i], P.values.begin() + P.rowBegin[i+1], 0.0);
+            for (Index q = T.rowBegin[i]; q < T.rowBegin[i+1]; ++q)
+                P.values[std::lower_bound(rowBegin, rowEnd, T.colsIndex[q]) - P.colsIndex.begin()] += T.values[q];
+            if (!smoothed) continue;
+            const double w = omega * level.invDiag[i];
+            for (Index p = A.rowBegin[i]; p < A.rowBegin[i+1]; ++p)
+            {
+                const Index j = A.colsIndex[p];
+                for (Index q = T.rowBegin[j]; q < T.rowBegin[j+1]; ++q)
+                    P.values[std::lower_bound(rowBegin, rowEnd, T.colsIndex[q]) - P.colsIndex.begin()] -= w * A.values[p] * T.values[q];
+            }
+        }
+    });
+
+    LevelMatrix& R = level.R;
+    for (std::size_t q = 0; q < R.values.size(); ++q)
+        R.values[q] = P.values[level.rEntry[q]];
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::factorizeCoarse(const LevelMatrix& A)
+{
+    const Index n = A.nRow;
+    m_coarseIterative = (n > Index(d_maxDirectSize.getValue()));
+    if (m_coarseIterative)
+    {
+        // the dense factorization would require n^2 values
+        m_coarseLU.clear();
+        m_coarsePivots.clear();
+        return;
+    }
+
+    // dense LU factorization with partial pivoting
+    m_coarseLU.assign(std::size_t(n) * n, 0.0);
+    m_coarsePivots.resize(n);
+    for (Index i = 0; i < n; ++i)
+        for (Index p = A.rowBegin[i]; p < A.rowBegin[i+1]; ++p)
+            m_coarseLU[std::size_t(i)*n + A.colsIndex[p]] = A.values[p];
+
+    unsigned int nbSingular = 0;
+    for (Index k = 0; k < n; ++k)
+    {
+        Index pivot = k;
+        for (Index i = k+1; i < n; ++i)
+            if (std::fabs(m_coarseLU[std::size_t(i)*n + k]) > std::fabs(m_coarseLU[std::size_t(pivot)*n + k]))
+                pivot = i;
+        m_coarsePivots[k] = pivot;
+        if (pivot != k)
+            std::swap_ranges(m_coarseLU.begin() + std::size_t(k)*n, m_coarseLU.begin() + std::size_t(k+1)*n, m_coarseLU.begin() + std::size_t(pivot)*n);
+
+        double& d = m_coarseLU[std::size_t(k)*n + k];
+        if (d == 0)
+        {
+            // singular coarse system (e.g. unconstrained dofs): the corresponding component is left to the smoother
+            ++nbSingular;
+            d = 1.0;
+            continue;
+        }
+        for (Index i = k+1; i < n; ++i)
+        {
+            double& l = m_coarseLU[std::size_t(i)*n + k];
+            if (l == 0) continue;
+            l /= d;
+            for (Index j = k+1; j < n; ++j)
+                m_coarseLU[std::size_t(i)*n + j] -= l * m_coarseLU[std::size_t(k)*n + j];
+        }
+    }
+    if (nbSingular > 0)
+        msg_warning() << "Coarsest system is singular (" << nbSingular << " null pivots).";
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::solveCoarse(Level& level)
+{
+    helper::vector<double>& x = level.x;
+    const helper::vector<double>& b = level.b;
+    const Index n = level.A.nRow;
+
+    if (m_coarseIterative)
+    {
+        // conjugate gradient preconditioned by the diagonal, solved accurately so that the V-cycle stays
+        // close to a fixed linear operator
+        helper::vector<double>& r = level.r;
+        helper::vector<double>& p = level.d;
+        helper::vector<double>& q = level.t;
+        std::fill(x.begin(), x.end(), 0.0);
+        r = b;
+        for (Index i = 0; i < n; ++i)
+            p[i] = level.invDiag[i] * r[i];
+        double rz = 0.0;
+        for (Index i = 0; i < n; ++i)
+            rz += r[i] * p[i];
+        const double normB = std::sqrt(amg::dot(b, b));
+        for (Index it = 0; it < n && std::sqrt(amg::dot(r, r)) > amg::coarseTolerance * normB; ++it)
+        {
+            multiply(level.A, p, q);
+            const double pq = amg::dot(p, q);
+            if (pq <= 0) break;
+            const double alpha = rz / pq;
+            double rzNew = 0.0;
+            for (Index i = 0; i < n; ++i)
+            {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * q[i];
+                rzNew += level.invDiag[i] * r[i] * r[i];
+            }
+            const double beta = rzNew / rz;
+            for (Index i = 0; i < n; ++i)
+                p[i] = level.invDiag[i] * r[i] + beta * p[i];
+            rz = rzNew;
+        }
+        return;
+    }
+
+    x = b;
+    for (Index k = 0; k < n; ++k)
+        if (m_coarsePivots[k] != k)
+            std::swap(x[k], x[m_coarsePivots[k]]);
+    for (Index i = 0; i < n; ++i)
+        for (Index j = 0; j < i; ++j)
+            x[i] -= m_coarseLU[std::size_t(i)*n + j] * x[j];
+    for (Index i = n-1; i >= 0; --i)
+    {
+        for (Index j = i+1; j < n; ++j)
+            x[i] -= m_coarseLU[std::size_t(i)*n + j] * x[j];
+        x[i] /= m_coarseLU[std::size_t(i)*n + i];
+    }
+}
+
+/// Chebyshev smoothing of level.x for the system A x = b, preconditioned by the diagonal
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::smooth(Level& level)
+{
+    const unsigned degree = d_smootherDegree.getValue();
+    if (degree == 0) return;
+
+    const Index n = level.A.nRow;
+    helper::vector<double>& x = level.x;
+    helper::vector<double>& r = level.r;
+    helper::vector<double>& d = level.d;
+    helper::vector<double>& t = level.t;
+
+    // the eigenvalues of D^-1 A targeted by the smoother
+    const double upper = level.rho;
+    const double lower = level.rho / 30.0;
+    const double theta = 0.5 * (upper + lower);
+    const double delta = 0.5 * (upper - lower);
+    const double sigma = theta / delta;
+    double rhoK = 1.0 / sigma;
+
+    multiply(level.A, x, t);
+    parallelFor(n, [&](Index begin, Index end)
+    {
+        for (Index i = begin; i < end; ++i)
+        {
+            r[i] = level.invDiag[i] * (level.b[i] - t[i]);
+            d[i] = r[i] / theta;
+        }
+    });
+
+    for (unsigned k = 0; k < degree; ++k)
+    {
+        for (Index i = 0; i < n; ++i)
+            x[i] += d[i];
+        if (k + 1 == degree) break;
+
+        multiply(level.A, d, t);
+        const double rhoNew = 1.0 / (2.0 * sigma - rhoK);
+        const double c1 = rhoNew * rhoK;
+        const double c2 = 2.0 * rhoNew / delta;
+        parallelFor(n, [&](Index begin, Index end)
+        {
+            for (Index i = begin; i < end; ++i)
+            {
+                r[i] -= level.invDiag[i] * t[i];
+                d[i] = c1 * d[i] + c2 * r[i];
+            }
+        });
+        rhoK = rhoNew;
+    }
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::vcycle(std::size_t l)
+{
+    Level& level = m_levels[l];
+    if (l + 1 == m_levels.size())
+    {
+        solveCoarse(level);
+        return;
+    }
+
+    std::fill(level.x.begin(), level.x.end(), 0.0);
+    smooth(level);
+
+    // restriction of the residual
+    multiply(level.A, level.x, level.t);
+    for (Index i = 0; i < level.A.nRow; ++i)
+        level.r[i] = level.b[i] - level.t[i];
+    Level& coarse = m_levels[l+1];
+    multiply(level.R, level.r, coarse.b);
+
+    vcycle(l + 1);
+
+    // coarse correction
+    multiply(level.P, coarse.x, level.t);
+    for (Index i = 0; i < level.A.nRow; ++i)
+        level.x[i] += level.t[i];
+    smooth(level);
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::applyPreconditioner(const helper::vector<double>& b, helper::vector<double>& x)
+{
+    m_levels[0].b = b;
+    vcycle(0);
+    x = m_levels[0].x;
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::invert(Matrix& M)
+{
+    enum { NL = Matrix::NL, NC = Matrix::NC };
+    typedef typename Matrix::traits traits;
+
+    M.compress();
+    const Index n = M.rowSize();
+    const bool rebuild = m_levels.empty() || m_levels[0].A.nRow != n
+            || m_rowIndex != M.getRowIndex() || m_rowBegin != M.getRowBegin() || m_colsIndex != M.getColsIndex();
+
+    sofa::helper::ScopedAdvancedTimer timer(rebuild ? "AMGSetup" : "AMGUpdate");
+
+    if (rebuild)
+    {
+        const typename Matrix::VecIndex& rowIndex = M.getRowIndex();
+        const typename Matrix::VecIndex& rowBegin = M.getRowBegin();
+        const typename Matrix::VecIndex& colsIndex = M.getColsIndex();
+        m_rowIndex = rowIndex;
+        m_rowBegin = rowBegin;
+        m_colsIndex = colsIndex;
+
+        m_levels.clear();
+        m_levels.reserve(std::max(1u, d_maxLevels.getValue()));
+        m_levels.resize(1);
+        m_levels[0].A.nRow = n;
+        computeNullSpace(m_levels[0]);
+
+        // scalar pattern of the finest level
+        LevelMatrix& A = m_levels[0].A;
+        A.nRow = n;
+        A.nCol = M.colSize();
+        A.rowBegin.assign(n + 1, 0);
+        for (std::size_t xi = 0; xi < rowIndex.size(); ++xi)
+            for (Index li = 0; li < NL && Index(rowIndex[xi])*NL + li < n; ++li)
+                A.rowBegin[rowIndex[xi]*NL + li + 1] = Index(rowBegin[xi+1] - rowBegin[xi]) * NC;
+        for (Index i = 0; i < n; ++i)
+            A.rowBegin[i+1] += A.rowBegin[i];
+        A.colsIndex.resize(A.rowBegin[n]);
+        A.values.resize(A.rowBegin[n]);
+        m_source.resize(A.rowBegin[n]);
+        for (std::size_t xi = 0; xi < rowIndex.size(); ++xi)
+        {
+            for (Index li = 0; li < NL && Index(rowIndex[xi])*NL + li < n; ++li)
+            {
+                Index p = A.rowBegin[rowIndex[xi]*NL + li];
+                for (Index k = Index(rowBegin[xi]); k < Index(rowBegin[xi+1]); ++k)
+                {
+                    for (Index lj = 0; lj < NC; ++lj, ++p)
+                    {
+                        A.colsIndex[p] = colsIndex[k]*NC + lj;
+                        m_source[p] = k*NL*NC + li*NC + lj;
+                    }
+                }
+            }
+        }
+    }
+
+    {
+        LevelMatrix& A = m_levels[0].A;
+        const typename Matrix::VecBloc& colsValue = M.getColsValue();
+        parallelFor(Index(A.values.size()), [&](Index begin, Index end)
+        {
+            for (Index p = begin; p < end; ++p)
+            {
+                const Index s = m_source[p];
+                const Index r = s % (NL*NC);
+                A.values[p] = (double)traits::v(colsValue[s / (NL*NC)], r / NC, r % NC);
+            }
+        });
+    }
+
+    const Index coarseSize = Index(d_coarseSize.getValue());
+    const std::size_t maxLevels = std::max(1u, d_maxLevels.getValue());
+    for (std::size_t l = 0; ; ++l)
+    {
+        Level& level = m_levels[l];
+        setupSmoother(level);
+
+        bool last = (l + 1 == m_levels.size());
+        if (rebuild)
+        {
+            last = (level.A.nRow <= coarseSize || l + 1 >= maxLevels);
+            helper::vector<double> coarseNullSpace;
+            if (!last)
+            {
+                computeAggregates(level);
+                computeTentative(level, coarseNullSpace);
+                // stop when the aggregation does not reduce the size of the system anymore
+                last = (level.nbAggregates == 0 || level.T.nCol * 10 > level.A.nRow * 9);
+            }
+            if (!last)
+            {
+                prolongationSymbolic(level);
+                multiplySymbolic(level.A, level.P, level.AP);
+                m_levels.emplace_back();
+                Level& coarse = m_levels[l+1];
+                coarse.nodeBegin = level.coarseBegin;
+                coarse.nullSpace.swap(coarseNullSpace);
+                multiplySymbolic(level.R, level.AP, coarse.A);
+            }
+        }
+
+        if (last)
+        {
+            factorizeCoarse(level.A);
+            if (rebuild && m_coarseIterative)
+                msg_warning() << "The coarsest level has " << level.A.nRow << " rows, more than maxDirectSize (" << d_maxDirectSize.getValue()
+                              << "): it is solved iteratively. Consider increasing maxLevels.";
+            break;
+        }
+
+        prolongationNumeric(level);
+        multiplyNumeric(level.A, level.P, level.AP);
+        multiplyNumeric(level.R, level.AP, m_levels[l+1].A);
+    }
+
+    if (rebuild && this->notMuted())
+    {
+        std::ostringstream out;
+        for (std::size_t l = 0; l < m_levels.size(); ++l)
+            out << " " << m_levels[l].A.nRow << " (" << m_levels[l].A.colsIndex.size() << ")";
+        msg_info() << "Hierarchy of " << m_levels.size() << " levels, rows (entries):" << out.str();
+    }
+}
+
+template<class TMatrix, class TVector>
+void AMGLinearSolver<TMatrix,TVector>::solve(Matrix& M, Vector& x, Vector& b)
+{
+    if (m_levels.empty())
+    {
+        msg_error() << "The hierarchy is not built, invert should be called before solve.";
+        return;
+    }
+
+    sofa::helper::ScopedAdvancedTimer timer("AMGSolve");
+
+    const Index n = M.rowSize();
+    const LevelMatrix& A = m_levels[0].A;
+    const double tol = d_tolerance.getValue();
+    const unsigned maxIter = std::max(1u, d_maxIter.getValue());
+
+    m_r.resize(n);
+    for (Index i = 0; i < n; ++i)
+        m_r[i] = b[i];
+    const double normB = std::sqrt(amg::dot(m_r, m_r));
+    m_x.assign(n, 0.0);
+    if (normB == 0)
+    {
+        for (Index i = 0; i < n; ++i)
+            x[i] = 0.0;
+        return;
+    }
+
+    unsigned nbIter = 0;
+    double normR = normB;
+    if (d_useCG.getValue())
+    {
+        // conjugate gradient preconditioned by a V-cycle
+        applyPreconditioner(m_r, m_z);
+        m_p = m_z;
+        double rz = amg::dot(m_r, m_z);
+        while (nbIter < maxIter)
+        {
+            ++nbIter;
+            multiply(A, m_p, m_q);
+            const double pq = amg::dot(m_p, m_q);
+            if (pq == 0) break;
+            const double alpha = rz / pq;
+            for (Index i = 0; i < n; ++i)
+            {
+                m_x[i] += alpha * m_p[i];
+                m_r[i] -= alpha * m_q[i];
+            }
+            normR = std::sqrt(amg::dot(m_r, m_r));
+            if (normR <= tol * normB || nbIter == maxIter) break;
+
+            applyPreconditioner(m_r, m_z);
+            const double rzNew = amg::dot(m_r, m_z);
+            const double beta = rzNew / rz;
+            for (Index i = 0; i < n; ++i)
+                m_p[i] = m_z[i] + beta * m_p[i];
+            rz = rzNew;
+        }
+    }
+    else
+    {
+        // stationary iterations of V-cycles
+        while (nbIter < maxIter)
+        {
+            ++nbIter;
+            applyPreconditioner(m_r, m_z);
+            for (Index i = 0; i < n; ++i)
+                m_x[i] += m_z[i];
+            if (nbIter == maxIter) break;
+
+            multiply(A, m_x, m_q);
+            for (Index i = 0; i < n; ++i)
+                m_r[i] = b[i] - m_q[i];
+            normR = std::sqrt(amg::dot(m_r, m_r));
+            if (normR <= tol * normB) break;
+        }
+    }
+
+    for (Index i = 0; i < n; ++i)
+        x[i] = m_x[i];
+
+    msg_info() << nbIter << " iterations, relative residual " << normR / normB;
+}
+
+} //namespace sofa::component::linearsolver
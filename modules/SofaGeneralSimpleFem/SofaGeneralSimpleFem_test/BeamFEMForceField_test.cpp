@@ -0,0 +1,211 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaGeneralSimpleFem/BeamFEMForceField.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaBaseTopology/EdgeSetTopologyContainer.h>
+#include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
+#include <SofaBaseLinearSolver/DefaultMultiMatrixAccessor.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/Node.h>
+#include <sofa/core/MechanicalParams.h>
+#include <SofaSimulationGraph/SimpleApi.h>
+
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest;
+
+#include <cmath>
+
+namespace
+{
+
+using namespace sofa;
+using DataTypes = defaulttype::Rigid3Types;
+using Coord = DataTypes::Coord;
+using Deriv = DataTypes::Deriv;
+using Quat = DataTypes::Quat;
+using VecCoord = DataTypes::VecCoord;
+using VecDeriv = DataTypes::VecDeriv;
+using MechanicalObject = component::container::MechanicalObject<DataTypes>;
+using BeamFEMForceField = component::forcefield::BeamFEMForceField<DataTypes>;
+using EdgeSetTopologyContainer = component::topology::EdgeSetTopologyContainer;
+using Matrix = component::linearsolver::CompressedRowSparseMatrix<SReal>;
+
+/// Comb of beams: a spine with a branch of several beams at each of its nodes.
+/// The beams of the spine and of the branches are interleaved, so that the nodes of the spine are shared by three beams
+/// and the greedy coloring of the force field needs more than the two colors of a chain.
+constexpr unsigned int spineLength = 200;
+constexpr unsigned int branchLength = 8;
+constexpr SReal beamLength = 0.1;
+
+struct BeamFEMForceField_test : public BaseTest
+{
+    simulation::Simulation::SPtr m_simulation;
+    simulation::Node::SPtr m_root;
+
+    void onSetUp() override
+    {
+        simulation::TaskScheduler::getInstance()->init(4);
+        m_simulation = simpleapi::createSimulation("DAG");
+        m_root = simpleapi::createRootNode(m_simulation, "root");
+    }
+
+    void onTearDown() override
+    {
+        simulation::TaskScheduler::getInstance()->stop();
+    }
+
+    struct Beams
+    {
+        MechanicalObject::SPtr dofs;
+        BeamFEMForceField::SPtr forceField;
+    };
+
+    Beams createBeams(const std::string& name, bool parallel)
+    {
+        auto node = m_root->createChild(name);
+
+        auto topology = core::objectmodel::New<EdgeSetTopologyContainer>();
+        VecCoord x0;
+        for (unsigned int i=0; i<=spineLength; ++i)
+            x0.push_back(Coord(DataTypes::CPos(i*beamLength, 0, 0), Quat()));
+        for (unsigned int i=0; i<=spineLength; ++i)
+        {
+            // the branches alternate on both sides of the spine, their beams going away from it
+            const SReal side = (i % 2) ? 1 : -1;
+            for (unsigned int k=0; k<branchLength; ++k)
+                x0.push_back(Coord(DataTypes::CPos(i*beamLength, side*(k+1)*beamLength, 0), Quat()));
+        }
+        topology->setNbPoints(x0.size());
+        for (unsigned int i=0; i<=spineLength; ++i)
+        {
+            if (i < spineLength)
+                topology->addEdge(i, i+1);
+            const unsigned int branch = spineLength + 1 + i*branchLength;
+            topology->addEdge(i, branch);
+            for (unsigned int k=0; k+1<branchLength; ++k)
+                topology->addEdge(branch+k, branch+k+1);
+        }
+        node->addObject(topology);
+
+        Beams beams;
+        beams.dofs = core::objectmodel::New<MechanicalObject>();
+        beams.dofs->resize(x0.size());
+        beams.dofs->x.setValue(x0);
+        beams.dofs->x0.setValue(x0);
+        node->addObject(beams.dofs);
+
+        beams.forceField = core::objectmodel::New<BeamFEMForceField>();
+        beams.forceField->d_youngModulus.setValue(1e5);
+        beams.forceField->d_poissonRatio.setValue(0.3);
+        beams.forceField->d_radius.setValue(0.01);
+        beams.forceField->d_parallelComputation.setValue(parallel);
+        node->addObject(beams.forceField);
+
+        return beams;
+    }
+
+    /// Rotate and move the nodes away from their rest positions
+    static void deform(MechanicalObject& dofs)
+    {
+        auto x = helper::getWriteAccessor(dofs.x);
+        for (std::size_t i=0; i<x.size(); ++i)
+        {
+            const SReal s = SReal(i);
+            x[i].getCenter() += DataTypes::CPos(0.01*std::sin(s), 0.02*std::cos(1.3*s), 0.01*std::sin(0.7*s));
+            DataTypes::CPos axis(1, std::sin(s), std::cos(s));
+            axis.normalize();
+            x[i].getOrientation() = Quat(axis, 0.05*std::sin(0.9*s));
+        }
+    }
+
+    static void expectNear(const VecDeriv& serial, const VecDeriv& parallel)
+    {
+        ASSERT_EQ(serial.size(), parallel.size());
+        for (std::size_t i=0; i<serial.size(); ++i)
+            for (std::size_t k=0; k<Deriv::total_size; ++k)
+                EXPECT_NEAR(serial[i][k], parallel[i][k], 1e-10 * (1 + std::abs(serial[i][k]))) << "node " << i << ", component " << k;
+    }
+
+    static VecDeriv addForce(Beams& beams)
+    {
+        core::MechanicalParams mparams;
+        Data<VecDeriv> f(VecDeriv(std::size_t(beams.dofs->getSize())));
+        beams.forceField->addForce(&mparams, f, beams.dofs->x, beams.dofs->v);
+        return f.getValue();
+    }
+
+    static VecDeriv addDForce(Beams& beams, const VecDeriv& dx)
+    {
+        core::MechanicalParams mparams;
+        mparams.setKFactor(0.7);
+        Data<VecDeriv> df(VecDeriv(std::size_t(beams.dofs->getSize())));
+        Data<VecDeriv> dxData(dx);
+        beams.forceField->addDForce(&mparams, df, dxData);
+        return df.getValue();
+    }
+
+    static void addKToMatrix(Beams& beams, Matrix& matrix)
+    {
+        core::MechanicalParams mparams;
+        mparams.setKFactor(0.7);
+        component::linearsolver::DefaultMultiMatrixAccessor accessor;
+        accessor.addMechanicalState(beams.dofs.get());
+        accessor.setGlobalMatrix(&matrix);
+        accessor.setupMatrices();
+        matrix.resize(accessor.getGlobalDimension(), accessor.getGlobalDimension());
+        beams.forceField->addKToMatrix(&mparams, &accessor);
+        matrix.compress();
+    }
+};
+
+TEST_F(BeamFEMForceField_test, parallelComputationOnBranchedBeams)
+{
+    Beams serial = createBeams("serial", false);
+    Beams parallel = createBeams("parallel", true);
+    m_simulation->init(m_root.get());
+    deform(*serial.dofs);
+    deform(*parallel.dofs);
+
+    const VecDeriv serialForce = addForce(serial);
+    SReal norm = 0;
+    for (const Deriv& f : serialForce)
+        norm += f.norm();
+    ASSERT_GT(norm, 0);
+    expectNear(serialForce, addForce(parallel));
+
+    VecDeriv dx(serial.dofs->getSize());
+    for (std::size_t i=0; i<dx.size(); ++i)
+        for (std::size_t k=0; k<Deriv::total_size; ++k)
+            dx[i][k] = 1e-3 * std::sin(SReal(7*i + k));
+    expectNear(addDForce(serial, dx), addDForce(parallel, dx));
+
+    Matrix serialMatrix, parallelMatrix;
+    addKToMatrix(serial, serialMatrix);
+    addKToMatrix(parallel, parallelMatrix);
+    ASSERT_GT(serialMatrix.getColsValue().size(), 0u);
+    EXPECT_EQ(serialMatrix.getRowIndex(), parallelMatrix.getRowIndex());
+    EXPECT_EQ(serialMatrix.getRowBegin(), parallelMatrix.getRowBegin());
+    EXPECT_EQ(serialMatrix.getColsIndex(), parallelMatrix.getColsIndex());
+    EXPECT_EQ(serialMatrix.getColsValue(), parallelMatrix.getColsValue());
+}
+
+} // namespace
@@ -0,0 +1,172 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaGeneralSimpleFem/TriangularFEMForceFieldOptim.inl>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaBaseTopology/TriangleSetTopologyContainer.h>
+#include <sofa/simulation/TaskScheduler.h>
+#include <sofa/simulation/Node.h>
+#include <sofa/core/MechanicalParams.h>
+#include <SofaSimulationGraph/SimpleApi.h>
+
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest;
+
+#include <cmath>
+
+namespace
+{
+
+using namespace sofa;
+using DataTypes = defaulttype::Vec3Types;
+using Coord = DataTypes::Coord;
+using Deriv = DataTypes::Deriv;
+using VecCoord = DataTypes::VecCoord;
+using VecDeriv = DataTypes::VecDeriv;
+using MechanicalObject = component::container::MechanicalObject<DataTypes>;
+using TriangularFEMForceFieldOptim = component::forcefield::TriangularFEMForceFieldOptim<DataTypes>;
+using TriangleSetTopologyContainer = component::topology::TriangleSetTopologyContainer;
+
+/// Regular grid of nx x ny cells split in two triangles, which gives more triangles than trianglefemoptim::minElementsPerTask
+constexpr unsigned int nx = 48;
+constexpr unsigned int ny = 24;
+constexpr SReal cellSize = 0.1;
+
+struct TriangularFEMForceFieldOptim_test : public BaseTest
+{
+    simulation::Simulation::SPtr m_simulation;
+    simulation::Node::SPtr m_root;
+
+    void onSetUp() override
+    {
+        simulation::TaskScheduler::getInstance()->init(4);
+        m_simulation = simpleapi::createSimulation("DAG");
+        m_root = simpleapi::createRootNode(m_simulation, "root");
+    }
+
+    void onTearDown() override
+    {
+        simulation::TaskScheduler::getInstance()->stop();
+    }
+
+    struct Membrane
+    {
+        MechanicalObject::SPtr dofs;
+        TriangularFEMForceFieldOptim::SPtr forceField;
+    };
+
+    Membrane createMembrane(const std::string& name, bool parallel)
+    {
+        auto node = m_root->createChild(name);
+
+        auto topology = core::objectmodel::New<TriangleSetTopologyContainer>();
+        VecCoord x0;
+        for (unsigned int j=0; j<=ny; ++j)
+            for (unsigned int i=0; i<=nx; ++i)
+                x0.push_back(Coord(i*cellSize, j*cellSize, 0));
+        topology->setNbPoints(x0.size());
+        for (unsigned int j=0; j<ny; ++j)
+            for (unsigned int i=0; i<nx; ++i)
+            {
+                const unsigned int p = j*(nx+1) + i;
+                topology->addTriangle(p, p+1, p+nx+2);
+                topology->addTriangle(p, p+nx+2, p+nx+1);
+            }
+        node->addObject(topology);
+
+        Membrane membrane;
+        membrane.dofs = core::objectmodel::New<MechanicalObject>();
+        membrane.dofs->resize(x0.size());
+        membrane.dofs->x.setValue(x0);
+        membrane.dofs->x0.setValue(x0);
+        node->addObject(membrane.dofs);
+
+        membrane.forceField = core::objectmodel::New<TriangularFEMForceFieldOptim>();
+        membrane.forceField->d_young.setValue(1e4);
+        membrane.forceField->d_poisson.setValue(0.3);
+        membrane.forceField->d_parallelComputation.setValue(parallel);
+        node->addObject(membrane.forceField);
+
+        return membrane;
+    }
+
+    /// Stretch and bend the membrane away from its rest positions
+    static void deform(MechanicalObject& dofs)
+    {
+        auto x = helper::getWriteAccessor(dofs.x);
+        for (std::size_t i=0; i<x.size(); ++i)
+        {
+            const SReal s = SReal(i);
+            x[i] += Coord(0.01*std::sin(s), 0.02*std::cos(1.3*s), 0.03*std::sin(0.7*s));
+        }
+    }
+
+    static void expectNear(const VecDeriv& serial, const VecDeriv& parallel)
+    {
+        ASSERT_EQ(serial.size(), parallel.size());
+        for (std::size_t i=0; i<serial.size(); ++i)
+            for (std::size_t k=0; k<Deriv::total_size; ++k)
+                EXPECT_NEAR(serial[i][k], parallel[i][k], 1e-10 * (1 + std::abs(serial[i][k]))) << "node " << i << ", component " << k;
+    }
+
+    static VecDeriv addForce(Membrane& membrane)
+    {
+        core::MechanicalParams mparams;
+        Data<VecDeriv> f(VecDeriv(std::size_t(membrane.dofs->getSize())));
+        membrane.forceField->addForce(&mparams, f, membrane.dofs->x, membrane.dofs->v);
+        return f.getValue();
+    }
+
+    static VecDeriv addDForce(Membrane& membrane, const VecDeriv& dx)
+    {
+        core::MechanicalParams mparams;
+        mparams.setKFactor(0.7);
+        Data<VecDeriv> df(VecDeriv(std::size_t(membrane.dofs->getSize())));
+        Data<VecDeriv> dxData(dx);
+        membrane.forceField->addDForce(&mparams, df, dxData);
+        return df.getValue();
+    }
+};
+
+TEST_F(TriangularFEMForceFieldOptim_test, parallelComputationOnGrid)
+{
+    Membrane serial = createMembrane("serial", false);
+    Membrane parallel = createMembrane("parallel", true);
+    m_simulation->init(m_root.get());
+    ASSERT_GT(std::size_t(2*nx*ny), component::forcefield::trianglefemoptim::minElementsPerTask);
+    deform(*serial.dofs);
+    deform(*parallel.dofs);
+
+    const VecDeriv serialForce = addForce(serial);
+    SReal norm = 0;
+    for (const Deriv& f : serialForce)
+        norm += f.norm();
+    ASSERT_GT(norm, 0);
+    expectNear(serialForce, addForce(parallel));
+
+    VecDeriv dx(serial.dofs->getSize());
+    for (std::size_t i=0; i<dx.size(); ++i)
+        for (std::size_t k=0; k<Deriv::total_size; ++k)
+            dx[i][k] = 1e-3 * std::sin(SReal(7*i + k));
+    expectNear(addDForce(serial, dx), addDForce(parallel, dx));
+}
+
+} // namespace
@@ -25,6 +25,8 @@
 
 #include <SofaGeneralSimpleFem/config.h>
 
+#include <functional>
+
 namespace  sofa::component::forcefield
 {
 
@@ -164,6 +166,7 @@ public:
     Data<Real> d_radiusInner; ///< inner radius of the section for hollow beams
     Data< BaseMeshTopology::SetIndex > d_listSegment; ///< apply the forcefield to a subset list of beam segments. If no segment defined, forcefield applies to the whole topology
     Data< bool> d_useSymmetricAssembly; ///< use symmetric assembly of the matrix K
+    Data< bool> d_parallelComputation; ///< Compute the beam elements with the threads of the TaskScheduler, one color of elements at a time
 
     /// Link to be set to the topology container in the component graph.
     SingleLink<BeamFEMForceField<DataTypes>, sofa::core::topology::BaseMeshTopology, BaseLink::FLAG_STOREPATH | BaseLink::FLAG_STRONGLINK> l_topology;
@@ -176,6 +179,27 @@ public:
 
     Quat& beamQuat(int i);
 
+    /// rest configuration of a beam, expressed in the frame of its first node
+    struct RestFrame
+    {
+        Vec3 P1P2; ///< vector from the first to the second node
+        Quat dQ;   ///< rotation from the first to the second node
+    };
+    helper::vector<RestFrame> m_restFrames; ///< indexed as the edges of the topology
+    int m_restFramesCounter;
+    int m_restFramesRevision;
+
+    /// elements handled by the force field, in the order of the sequential loops
+    helper::vector<Index> m_elements;
+    /// m_elements grouped by color (CSR layout): two elements of the same color never share a node
+    helper::vector<Index> m_colorElements;
+    helper::vector<std::size_t> m_colorBegin;
+    int m_elementsCounter;
+    int m_elementsRevision;
+
+    /// rotated stiffness of each element of m_elements, computed in parallel by addKToMatrix
+    helper::vector<StiffnessMatrix> m_elementStiffness;
+
     BaseMeshTopology* m_topology;
     BeamFFEdgeHandler* m_edgeHandler;
 
@@ -207,11 +231,20 @@ protected:
     Real pseudoDeterminantForCoef ( const Mat<2, 3, Real>&  M );
     void computeStiffness(int i, Index a, Index b);
 
+    void updateRestFrames();
+    void updateElements();
+
+    /// apply f on ranges of elements, color by color with the threads of the TaskScheduler if d_parallelComputation is set
+    void forEachElement(const std::function<void(const Index*,const Index*)>& f);
+    /// apply f on contiguous ranges of [0,n), with the threads of the TaskScheduler if d_parallelComputation is set
+    void forEachRange(std::size_t n, const std::function<void(std::size_t,std::size_t)>& f);
+
     /// Large displacements method
     helper::vector<Transformation> _nodeRotations;
     void initLarge(int i, Index a, Index b);
-    void accumulateForceLarge( VecDeriv& f, const VecCoord& x, int i, Index a, Index b);
-    void applyStiffnessLarge( VecDeriv& f, const VecDeriv& x, int i, Index a, Index b, double fact=1.0);
+    void accumulateForceLarge( VecDeriv& f, const VecCoord& x, BeamInfo& beam, const RestFrame& restFrame, Index a, Index b);
+    void applyStiffnessLarge( VecDeriv& f, const VecDeriv& x, BeamInfo& beam, Index a, Index b, double fact=1.0);
+    void computeElementStiffness( StiffnessMatrix& K, BeamInfo& beam, bool exploitSymmetry);
 };
 
 #if  !defined(SOFA_COMPONENT_FORCEFIELD_BEAMFEMFORCEFIELD_CPP)
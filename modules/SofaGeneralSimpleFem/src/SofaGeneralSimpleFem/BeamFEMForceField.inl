@@ -28,11 +28,13 @@
 #include <cassert>
 #include <iostream>
 #include <set>
+#include <algorithm>
 #include <sofa/core/behavior/MechanicalState.h>
 #include <sofa/core/behavior/MultiMatrixAccessor.h>
 #include <sofa/defaulttype/VecTypes.h>
 #include <sofa/core/behavior/MultiMatrixAccessor.h>
 #include <sofa/defaulttype/RigidTypes.h>
+#include <sofa/simulation/ParallelForRange.h>
 
 #include "BeamFEMForceField.h"
 
@@ -43,6 +45,22 @@ namespace sofa::component::forcefield::_beamfemforcefield_
 using core::objectmodel::BaseContext;
 using defaulttype::Quat;
 
+/// Minimum number of beams handled by each task of the parallel computations
+constexpr std::size_t minElementsPerTask = 128;
+
+inline defaulttype::Quat qDiff(defaulttype::Quat a, const defaulttype::Quat& b)
+{
+    if (a[0]*b[0]+a[1]*b[1]+a[2]*b[2]+a[3]*b[3]<0)
+    {
+        a[0] = -a[0];
+        a[1] = -a[1];
+        a[2] = -a[2];
+        a[3] = -a[3];
+    }
+    defaulttype::Quat q = b.inverse() * a;
+    return q;
+}
+
 template<class DataTypes>
 BeamFEMForceField<DataTypes>::BeamFEMForceField()
     : m_beamsData(initData(&m_beamsData, "beamsData", "Internal element data"))
@@ -53,9 +71,14 @@ BeamFEMForceField<DataTypes>::BeamFEMForceField()
     , d_radiusInner(initData(&d_radiusInner,(Real)0.0,"radiusInner","inner radius of the section for hollow beams"))
     , d_listSegment(initData(&d_listSegment,"listSegment", "apply the forcefield to a subset list of beam segments. If no segment defined, forcefield applies to the whole topology"))
     , d_useSymmetricAssembly(initData(&d_useSymmetricAssembly,false,"useSymmetricAssembly","use symmetric assembly of the matrix K"))
+    , d_parallelComputation(initData(&d_parallelComputation,false,"parallelComputation","Compute the beam elements with the threads of the TaskScheduler, one color of elements at a time"))
     , m_partialListSegment(false)
     , m_updateStiffnessMatrix(true)
     , m_assembling(false)
+    , m_restFramesCounter(-1)
+    , m_restFramesRevision(-1)
+    , m_elementsCounter(-1)
+    , m_elementsRevision(-1)
     , m_edgeHandler(nullptr)
 {
     m_edgeHandler = new BeamFFEdgeHandler(this, &m_beamsData);
@@ -74,10 +97,15 @@ BeamFEMForceField<DataTypes>::BeamFEMForceField(Real poissonRatio, Real youngMod
     , d_radiusInner(initData(&d_radiusInner,(Real)radiusInner,"radiusInner","inner radius of the section for hollow beams"))
     , d_listSegment(initData(&d_listSegment,"listSegment", "apply the forcefield to a subset list of beam segments. If no segment defined, forcefield applies to the whole topology"))
     , d_useSymmetricAssembly(initData(&d_useSymmetricAssembly,false,"useSymmetricAssembly","use symmetric assembly of the matrix K"))
+    , d_parallelComputation(initData(&d_parallelComputation,false,"parallelComputation","Compute the beam elements with the threads of the TaskScheduler, one color of elements at a time"))
     , l_topology(initLink("topology", "link to the topology container"))
     , m_partialListSegment(false)
     , m_updateStiffnessMatrix(true)
     , m_assembling(false)
+    , m_restFramesCounter(-1)
+    , m_restFramesRevision(-1)
+    , m_elementsCounter(-1)
+    , m_elementsRevision(-1)
     , m_edgeHandler(nullptr)
 {
     m_edgeHandler = new BeamFFEdgeHandler(this, &m_beamsData);
@@ -154,6 +182,9 @@ void BeamFEMForceField<DataTypes>::init()
     m_beamsData.createTopologyHandler(m_topology,m_edgeHandler);
     m_beamsData.registerTopologicalData();
 
+    if (d_parallelComputation.getValue())
+        simulation::initTaskScheduler();
+
     reinit();
 }
 
@@ -213,6 +244,116 @@ Quat& BeamFEMForceField<DataTypes>::beamQuat(int i)
     return bd[i].quat;
 }
 
+template<class DataTypes>
+void BeamFEMForceField<DataTypes>::updateRestFrames()
+{
+    const Data<VecCoord>* restPosition = this->mstate->read(core::ConstVecCoordId::restPosition());
+    if (m_restFramesCounter == restPosition->getCounter()
+        && m_restFramesRevision == m_topology->getRevision()
+        && m_restFrames.size() == m_indexedElements->size())
+        return;
+
+    const VecCoord& x0 = restPosition->getValue();
+    m_restFrames.resize(m_indexedElements->size());
+    for (std::size_t i=0; i<m_indexedElements->size(); ++i)
+    {
+        Index a = (*m_indexedElements)[i][0];
+        Index b = (*m_indexedElements)[i][1];
+        RestFrame& frame = m_restFrames[i];
+
+        frame.P1P2 = x0[b].getCenter() - x0[a].getCenter();
+        frame.P1P2 = x0[a].getOrientation().inverseRotate(frame.P1P2);
+
+        frame.dQ = qDiff(x0[b].getOrientation(), x0[a].getOrientation());
+        frame.dQ.normalize();
+    }
+    m_restFramesCounter = restPosition->getCounter();
+    m_restFramesRevision = m_topology->getRevision();
+}
+
+template<class DataTypes>
+void BeamFEMForceField<DataTypes>::updateElements()
+{
+    if (m_elementsCounter == d_listSegment.getCounter()
+        && m_elementsRevision == m_topology->getRevision()
+        && (m_partialListSegment || m_elements.size() == m_indexedElements->size()))
+        return;
+
+    m_elements.clear();
+    if (m_partialListSegment)
+    {
+        for (unsigned int j=0; j<d_listSegment.getValue().size(); j++)
+            m_elements.push_back(d_listSegment.getValue()[j]);
+    }
+    else
+    {
+        for (unsigned int i=0; i<m_indexedElements->size(); ++i)
+            m_elements.push_back(i);
+    }
+
+    // Greedy coloring in the order of the elements: each beam takes the first color not used yet
+    // at its two nodes. A chain of beams numbered along the chain is thus split in even and odd elements.
+    std::vector< helper::vector<unsigned int> > nodeColors(this->mstate->getSize());
+    helper::vector<unsigned int> elementColor(m_elements.size());
+    unsigned int nbColors = 0;
+    for (std::size_t j=0; j<m_elements.size(); ++j)
+    {
+        const Element& edge = (*m_indexedElements)[m_elements[j]];
+        unsigned int color = 0;
+        while (std::find(nodeColors[edge[0]].begin(), nodeColors[edge[0]].end(), color) != nodeColors[edge[0]].end()
+               || std::find(nodeColors[edge[1]].begin(), nodeColors[edge[1]].end(), color) != nodeColors[edge[1]].end())
+            ++color;
+        nodeColors[edge[0]].push_back(color);
+        nodeColors[edge[1]].push_back(color);
+        elementColor[j] = color;
+        nbColors = std::max(nbColors, color+1);
+    }
+
+    m_colorBegin.clear();
+    m_colorBegin.resize(nbColors+1, 0);
+    for (std::size_t j=0; j<m_elements.size(); ++j)
+        ++m_colorBegin[elementColor[j]+1];
+    for (unsigned int c=0; c<nbColors; ++c)
+        m_colorBegin[c+1] += m_colorBegin[c];
+
+    std::vector<std::size_t> next(m_colorBegin.begin(), m_colorBegin.end()-1);
+    m_colorElements.resize(m_elements.size());
+    for (std::size_t j=0; j<m_elements.size(); ++j)
+        m_colorElements[next[elementColor[j]]++] = m_elements[j];
+
+    m_elementsCounter = d_listSegment.getCounter();
+    m_elementsRevision = m_topology->getRevision();
+}
+
+template<class DataTypes>
+void BeamFEMForceField<DataTypes>::forEachRange(std::size_t n, const std::function<void(std::size_t,std::size_t)>& f)
+{
+    simulation::TaskScheduler* taskScheduler = d_parallelComputation.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    simulation::parallelForRange(taskScheduler, 0, n, minElementsPerTask, f);
+}
+
+template<class DataTypes>
+void BeamFEMForceField<DataTypes>::forEachElement(const std::function<void(const Index*,const Index*)>& f)
+{
+    updateElements();
+
+    if (!d_parallelComputation.getValue())
+    {
+        f(m_elements.data(), m_elements.data() + m_elements.size());
+        return;
+    }
+
+    // the elements of a color do not share any node, so they can accumulate their forces concurrently
+    for (std::size_t c=0; c+1<m_colorBegin.size(); ++c)
+    {
+        const Index* colorElements = m_colorElements.data() + m_colorBegin[c];
+        forEachRange(m_colorBegin[c+1] - m_colorBegin[c], [&](std::size_t begin, std::size_t end)
+        {
+            f(colorElements + begin, colorElements + end);
+        });
+    }
+}
+
 template<class DataTypes>
 void BeamFEMForceField<DataTypes>::addForce(const sofa::core::MechanicalParams* mparams,
                                             DataVecDeriv &  dataF,
@@ -226,35 +367,18 @@ void BeamFEMForceField<DataTypes>::addForce(const sofa::core::MechanicalParams*
     const VecCoord& p=dataX.getValue();
     f.resize(p.size());
 
-    //// First compute each node rotation
-    typename VecElement::const_iterator it;
+    updateRestFrames();
 
-    if (m_partialListSegment)
-    {
-
-        for (unsigned int j=0; j<d_listSegment.getValue().size(); j++)
-        {
-            unsigned int i = d_listSegment.getValue()[j];
-            Element edge= (*m_indexedElements)[i];
-            Index a = edge[0];
-            Index b = edge[1];
-            initLarge(i,a,b);
-            accumulateForceLarge( f, p, i, a, b );
-        }
-    }
-    else
+    helper::vector<BeamInfo>& beams = *(m_beamsData.beginEdit());
+    forEachElement([&](const Index* begin, const Index* end)
     {
-        unsigned int i;
-        for(it=m_indexedElements->begin(),i=0; it!=m_indexedElements->end(); ++it,++i)
+        for (const Index* it = begin; it != end; ++it)
         {
-
-            Index a = (*it)[0];
-            Index b = (*it)[1];
-
-            initLarge(i,a,b);
-            accumulateForceLarge( f, p, i, a, b );
+            const Element& edge = (*m_indexedElements)[*it];
+            accumulateForceLarge( f, p, beams[*it], m_restFrames[*it], edge[0], edge[1] );
         }
-    }
+    });
+    m_beamsData.endEdit();
 
     dataF.endEdit();
 }
@@ -268,30 +392,16 @@ void BeamFEMForceField<DataTypes>::addDForce(const sofa::core::MechanicalParams
 
     df.resize(dx.size());
 
-    if (m_partialListSegment)
+    helper::vector<BeamInfo>& beams = *(m_beamsData.beginEdit());
+    forEachElement([&](const Index* begin, const Index* end)
     {
-        for (unsigned int j=0; j<d_listSegment.getValue().size(); j++)
+        for (const Index* it = begin; it != end; ++it)
         {
-            unsigned int i = d_listSegment.getValue()[j];
-            Element edge= (*m_indexedElements)[i];
-            Index a = edge[0];
-            Index b = edge[1];
-
-            applyStiffnessLarge(df, dx, i, a, b, kFactor);
+            const Element& edge = (*m_indexedElements)[*it];
+            applyStiffnessLarge(df, dx, beams[*it], edge[0], edge[1], kFactor);
         }
-    }
-    else
-    {
-        typename VecElement::const_iterator it;
-        unsigned int i = 0;
-        for(it = m_indexedElements->begin() ; it != m_indexedElements->end() ; ++it, ++i)
-        {
-            Index a = (*it)[0];
-            Index b = (*it)[1];
-
-            applyStiffnessLarge(df, dx, i, a, b, kFactor);
-        }
-    }
+    });
+    m_beamsData.endEdit();
 
     datadF.endEdit();
 }
@@ -366,19 +476,6 @@ void BeamFEMForceField<DataTypes>::computeStiffness(int i, Index , Index )
     m_beamsData.endEdit();
 }
 
-inline defaulttype::Quat qDiff(defaulttype::Quat a, const defaulttype::Quat& b)
-{
-    if (a[0]*b[0]+a[1]*b[1]+a[2]*b[2]+a[3]*b[3]<0)
-    {
-        a[0] = -a[0];
-        a[1] = -a[1];
-        a[2] = -a[2];
-        a[3] = -a[3];
-    }
-    defaulttype::Quat q = b.inverse() * a;
-    return q;
-}
-
 ////////////// large displacements method
 template<class DataTypes>
 void BeamFEMForceField<DataTypes>::initLarge(int i, Index a, Index b)
@@ -421,40 +518,32 @@ void BeamFEMForceField<DataTypes>::initLarge(int i, Index a, Index b)
 }
 
 template<class DataTypes>
-void BeamFEMForceField<DataTypes>::accumulateForceLarge( VecDeriv& f, const VecCoord & x, int i, Index a, Index b )
+void BeamFEMForceField<DataTypes>::accumulateForceLarge( VecDeriv& f, const VecCoord & x, BeamInfo& beam, const RestFrame& restFrame, Index a, Index b )
 {
-    const VecCoord& x0 = this->mstate->read(core::ConstVecCoordId::restPosition())->getValue();
+    beam.quat = x[a].getOrientation();
+    beam.quat.normalize();
 
-    beamQuat(i)= x[a].getOrientation();
-    beamQuat(i).normalize();
-
-    m_beamsData.endEdit();
-
-    defaulttype::Vec<3,Real> u, P1P2, P1P2_0;
+    defaulttype::Vec<3,Real> u, P1P2;
 
     // local displacement
     Displacement depl;
 
     // translations //
-    P1P2_0 = x0[b].getCenter() - x0[a].getCenter();
-    P1P2_0 = x0[a].getOrientation().inverseRotate(P1P2_0);
     P1P2 = x[b].getCenter() - x[a].getCenter();
     P1P2 = x[a].getOrientation().inverseRotate(P1P2);
-    u = P1P2 - P1P2_0;
+    u = P1P2 - restFrame.P1P2;
 
     depl[0] = 0.0; 	depl[1] = 0.0; 	depl[2] = 0.0;
     depl[6] = u[0]; depl[7] = u[1]; depl[8] = u[2];
 
     // rotations //
-    defaulttype::Quat dQ0, dQ;
+    defaulttype::Quat dQ;
 
-    dQ0 = qDiff(x0[b].getOrientation(), x0[a].getOrientation());
     dQ =  qDiff(x[b].getOrientation(), x[a].getOrientation());
 
-    dQ0.normalize();
     dQ.normalize();
 
-    defaulttype::Quat tmpQ = qDiff(dQ,dQ0);
+    defaulttype::Quat tmpQ = qDiff(dQ,restFrame.dQ);
     tmpQ.normalize();
 
     u = tmpQ.quatToRotationVector();// TODO(e.coevoet) remove before v20:
@@ -470,7 +559,7 @@ void BeamFEMForceField<DataTypes>::accumulateForceLarge( VecDeriv& f, const VecC
     depl[9] = u[0]; depl[10]= u[1]; depl[11]= u[2];
 
     // this computation can be optimised: (we know that half of "depl" is null)
-    Displacement force = m_beamsData.getValue()[i]._k_loc * depl;
+    Displacement force = beam._k_loc * depl;
 
 
     // Apply lambda transpose (we use the rotation value of point a for the beam)
@@ -486,11 +575,11 @@ void BeamFEMForceField<DataTypes>::accumulateForceLarge( VecDeriv& f, const VecC
 }
 
 template<class DataTypes>
-void BeamFEMForceField<DataTypes>::applyStiffnessLarge(VecDeriv& df, const VecDeriv& dx, int i, Index a, Index b, double fact)
+void BeamFEMForceField<DataTypes>::applyStiffnessLarge(VecDeriv& df, const VecDeriv& dx, BeamInfo& beam, Index a, Index b, double fact)
 {
     Displacement local_depl;
     defaulttype::Vec<3,Real> u;
-    defaulttype::Quat& q = beamQuat(i);
+    defaulttype::Quat& q = beam.quat;
     q.normalize();
 
     u = q.inverseRotate(getVCenter(dx[a]));
@@ -513,7 +602,7 @@ void BeamFEMForceField<DataTypes>::applyStiffnessLarge(VecDeriv& df, const VecDe
     local_depl[10] = u[1];
     local_depl[11] = u[2];
 
-    Displacement local_force = m_beamsData.getValue()[i]._k_loc * local_depl;
+    Displacement local_force = beam._k_loc * local_depl;
 
     Vec3 fa1 = q.rotate(defaulttype::Vec3d(local_force[0],local_force[1] ,local_force[2] ));
     Vec3 fa2 = q.rotate(defaulttype::Vec3d(local_force[3],local_force[4] ,local_force[5] ));
@@ -525,6 +614,50 @@ void BeamFEMForceField<DataTypes>::applyStiffnessLarge(VecDeriv& df, const VecDe
     df[b] += Deriv(-fb1,-fb2) * fact;
 }
 
+template<class DataTypes>
+void BeamFEMForceField<DataTypes>::computeElementStiffness(StiffnessMatrix& K, BeamInfo& beam, bool exploitSymmetry)
+{
+    defaulttype::Quat& q = beam.quat;
+    q.normalize();
+    Transformation R,Rt;
+    q.toMatrix(R);
+    Rt.transpose(R);
+    const StiffnessMatrix& K0 = beam._k_loc;
+    K.clear();
+
+    if (exploitSymmetry) {
+        for (int x1=0; x1<12; x1+=3) {
+            for (int y1=x1; y1<12; y1+=3)
+            {
+                defaulttype::Mat<3,3,Real> m;
+                K0.getsub(x1,y1, m);
+                m = R*m*Rt;
+
+                for (int i=0; i<3; i++)
+                    for (int j=0; j<3; j++) {
+                        K.elems[i+x1][j+y1] += m[i][j];
+                        K.elems[j+y1][i+x1] += m[i][j];
+                    }
+                if (x1 == y1)
+                    for (int i=0; i<3; i++)
+                        for (int j=0; j<3; j++)
+                            K.elems[i+x1][j+y1] *= double(0.5);
+
+            }
+        }
+    } else  {
+        for (int x1=0; x1<12; x1+=3) {
+            for (int y1=0; y1<12; y1+=3)
+            {
+                defaulttype::Mat<3,3,Real> m;
+                K0.getsub(x1,y1, m);
+                m = R*m*Rt;
+                K.setsub(x1,y1, m);
+            }
+        }
+    }
+}
+
 template<class DataTypes>
 void BeamFEMForceField<DataTypes>::addKToMatrix(const sofa::core::MechanicalParams* mparams, const sofa::core::behavior::MultiMatrixAccessor* matrix )
 {
@@ -534,109 +667,39 @@ void BeamFEMForceField<DataTypes>::addKToMatrix(const sofa::core::MechanicalPara
 
     if (r)
     {
-        unsigned int i=0;
-
         unsigned int &offset = r.offset;
 
-        if (m_partialListSegment)
-        {
+        // the symmetric assembly is only available when the force field applies to the whole topology
+        const bool exploitSymmetry = !m_partialListSegment && d_useSymmetricAssembly.getValue();
 
-            for (unsigned int j=0; j<d_listSegment.getValue().size(); j++)
-            {
-
-                i = d_listSegment.getValue()[j];
-                Element edge= (*m_indexedElements)[i];
-                Index a = edge[0];
-                Index b = edge[1];
-
-                defaulttype::Quat& q = beamQuat(i);
-                q.normalize();
-                Transformation R,Rt;
-                q.toMatrix(R);
-                Rt.transpose(R);
-                const StiffnessMatrix& K0 = m_beamsData.getValue()[i]._k_loc;
-                StiffnessMatrix K;
-                for (int x1=0; x1<12; x1+=3)
-                    for (int y1=0; y1<12; y1+=3)
-                    {
-                        defaulttype::Mat<3,3,Real> m;
-                        K0.getsub(x1,y1, m);
-                        m = R*m*Rt;
-                        K.setsub(x1,y1, m);
-                    }
-                int index[12];
-                for (int x1=0; x1<6; x1++)
-                    index[x1] = offset+a*6+x1;
-                for (int x1=0; x1<6; x1++)
-                    index[6+x1] = offset+b*6+x1;
-                for (int x1=0; x1<12; ++x1)
-                    for (int y1=0; y1<12; ++y1)
-                        mat->add(index[x1], index[y1], - K(x1,y1)*k);
+        updateElements();
+        m_elementStiffness.resize(m_elements.size());
 
-            }
-
-        }
-        else
+        // the element matrices are independent: they are computed in parallel, then added in the order of the elements
+        helper::vector<BeamInfo>& beams = *(m_beamsData.beginEdit());
+        forEachRange(m_elements.size(), [&](std::size_t begin, std::size_t end)
         {
-            typename VecElement::const_iterator it;
-            for(it = m_indexedElements->begin() ; it != m_indexedElements->end() ; ++it, ++i)
-            {
-                Index a = (*it)[0];
-                Index b = (*it)[1];
-
-                defaulttype::Quat& q = beamQuat(i);
-                q.normalize();
-                Transformation R,Rt;
-                q.toMatrix(R);
-                Rt.transpose(R);
-                const StiffnessMatrix& K0 = m_beamsData.getValue()[i]._k_loc;
-                StiffnessMatrix K;
-                bool exploitSymmetry = d_useSymmetricAssembly.getValue();
-
-                if (exploitSymmetry) {
-                    for (int x1=0; x1<12; x1+=3) {
-                        for (int y1=x1; y1<12; y1+=3)
-                        {
-                            defaulttype::Mat<3,3,Real> m;
-                            K0.getsub(x1,y1, m);
-                            m = R*m*Rt;
-
-                            for (int i=0; i<3; i++)
-                                for (int j=0; j<3; j++) {
-                                    K.elems[i+x1][j+y1] += m[i][j];
-                                    K.elems[j+y1][i+x1] += m[i][j];
-                                }
-                            if (x1 == y1)
-                                for (int i=0; i<3; i++)
-                                    for (int j=0; j<3; j++)
-                                        K.elems[i+x1][j+y1] *= double(0.5);
-
-                        }
-                    }
-                } else  {
-                    for (int x1=0; x1<12; x1+=3) {
-                        for (int y1=0; y1<12; y1+=3)
-                        {
-                            defaulttype::Mat<3,3,Real> m;
-                            K0.getsub(x1,y1, m);
-                            m = R*m*Rt;
-                            K.setsub(x1,y1, m);
-                        }
-                    }
-                }
+            for (std::size_t j=begin; j<end; ++j)
+                computeElementStiffness(m_elementStiffness[j], beams[m_elements[j]], exploitSymmetry);
+        });
+        m_beamsData.endEdit();
 
-                int index[12];
-                for (int x1=0; x1<6; x1++)
-                    index[x1] = offset+a*6+x1;
-                for (int x1=0; x1<6; x1++)
-                    index[6+x1] = offset+b*6+x1;
-                for (int x1=0; x1<12; ++x1)
-                    for (int y1=0; y1<12; ++y1)
-                        mat->add(index[x1], index[y1], - K(x1,y1)*k);
-
-            }
+        for (std::size_t j=0; j<m_elements.size(); ++j)
+        {
+            const Element& edge = (*m_indexedElements)[m_elements[j]];
+            Index a = edge[0];
+            Index b = edge[1];
+            const StiffnessMatrix& K = m_elementStiffness[j];
+
+            int index[12];
+            for (int x1=0; x1<6; x1++)
+                index[x1] = offset+a*6+x1;
+            for (int x1=0; x1<6; x1++)
+                index[6+x1] = offset+b*6+x1;
+            for (int x1=0; x1<12; ++x1)
+                for (int y1=0; y1<12; ++y1)
+                    mat->add(index[x1], index[y1], - K(x1,y1)*k);
         }
-
     }
 
 }
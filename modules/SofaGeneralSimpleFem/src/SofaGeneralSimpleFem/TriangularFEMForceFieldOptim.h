@@ -32,6 +32,7 @@
 
 #include <map>
 #include <sofa/helper/map.h>
+#include <functional>
 
 namespace sofa::component::forcefield
 {
@@ -265,6 +266,7 @@ public:
                 const Triangle & t,
                 const sofa::helper::vector< Index > &,
                 const sofa::helper::vector< double > &);
+        void applyDestroyFunction(Index triangleIndex, TriangleState& ) override;
 
     protected:
         TriangularFEMForceFieldOptim<DataTypes>* ff;
@@ -273,6 +275,31 @@ public:
     template<class MatrixWriter>
     void addKToMatrixT(const core::MechanicalParams* mparams, MatrixWriter m);
 
+    /// compute the rotation, the stress and the nodal forces of the triangles [begin,end)
+    /// The forces are added to f, or written in m_triangleForces when storeForces is set.
+    template<bool storeForces>
+    void computeTrianglesForce(VecDeriv& f, const VecCoord& x, VecTriangleState& triState, const VecTriangleInfo& triInfo,
+                               std::size_t begin, std::size_t end);
+    /// compute the force variations of the triangles [begin,end), with the rotation and the stress of the last addForce
+    /// The variations are added to df, or written (negated) in m_triangleForces when storeForces is set.
+    template<bool storeForces>
+    void computeTrianglesDForce(VecDeriv& df, const VecDeriv& dx, const VecTriangleState& triState, const VecTriangleInfo& triInfo,
+                                Real kFactor, std::size_t begin, std::size_t end);
+
+    /// apply f on contiguous ranges of [0,n), with the threads of the TaskScheduler if d_parallelComputation is set
+    void forEachRange(std::size_t n, const std::function<void(std::size_t,std::size_t)>& f);
+    void updateVertexTriangles();
+    /// add m_triangleForces to f, each vertex summing its contributions in the order of the triangles
+    void accumulateTriangleForces(VecDeriv& f);
+
+    /// nodal forces of each triangle (3 per triangle), used by the parallel computations
+    helper::vector<Deriv> m_triangleForces;
+    /// triangles around each vertex, as 3*triangleIndex+localVertex, sorted by triangle (CSR layout)
+    helper::vector<Index> m_vertexTrianglesBegin;
+    helper::vector<Index> m_vertexTriangles;
+    int m_vertexTrianglesRevision;
+    bool m_vertexTrianglesDirty;
+
     void getTriangleVonMisesStress(Index i, Real& stressValue);
     void getTrianglePrincipalStress(Index i, Real& stressValue, Deriv& stressDirection, Real& stressValue2, Deriv& stressDirection2);
 
@@ -283,6 +310,7 @@ public:
     Data<Real> d_young; ///< Young modulus in Hooke's law
     Data<Real> d_damping; ///< Ratio damping/stiffness
     Data<Real> d_restScale; ///< Scale factor applied to rest positions (to simulate pre-stretched materials)
+    Data<bool> d_parallelComputation; ///< Compute the triangles with the threads of the TaskScheduler
 
     /// Display parameters
     Data<bool> d_showStressValue;
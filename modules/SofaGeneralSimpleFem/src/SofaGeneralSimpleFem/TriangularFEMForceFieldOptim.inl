@@ -29,12 +29,22 @@
 
 #include <SofaBaseTopology/TopologyData.inl>
 
+#include <sofa/simulation/ParallelForRange.h>
+
 #include <limits>
 
 
 namespace sofa::component::forcefield
 {
 
+namespace trianglefemoptim
+{
+
+/// Minimum number of triangles (or vertices) handled by each task of the parallel computations
+constexpr std::size_t minElementsPerTask = 1024;
+
+} // namespace trianglefemoptim
+
 // --------------------------------------------------------------------------------------
 // ---  Topology Creation/Destruction functions
 // --------------------------------------------------------------------------------------
@@ -54,6 +64,16 @@ void TriangularFEMForceFieldOptim<DataTypes>::TFEMFFOTriangleStateHandler::apply
     if (ff)
     {
         ff->initTriangleState(triangleIndex,ti,t, ff->mstate->read(core::ConstVecCoordId::position())->getValue());
+        ff->m_vertexTrianglesDirty = true;
+    }
+}
+
+template< class DataTypes>
+void TriangularFEMForceFieldOptim<DataTypes>::TFEMFFOTriangleStateHandler::applyDestroyFunction(Index, TriangleState &)
+{
+    if (ff)
+    {
+        ff->m_vertexTrianglesDirty = true;
     }
 }
 
@@ -67,10 +87,13 @@ TriangularFEMForceFieldOptim<DataTypes>::TriangularFEMForceFieldOptim()
     , d_triangleState(initData(&d_triangleState, "triangleState", "Internal triangle data (time-dependent)"))
     , d_vertexInfo(initData(&d_vertexInfo, "vertexInfo", "Internal point data"))
     , d_edgeInfo(initData(&d_edgeInfo, "edgeInfo", "Internal edge data"))
+    , m_vertexTrianglesRevision(-1)
+    , m_vertexTrianglesDirty(true)
     , d_poisson(initData(&d_poisson,(Real)(0.45),"poissonRatio","Poisson ratio in Hooke's law"))
     , d_young(initData(&d_young,(Real)(1000.0),"youngModulus","Young modulus in Hooke's law"))
     , d_damping(initData(&d_damping,(Real)0.,"damping","Ratio damping/stiffness"))
     , d_restScale(initData(&d_restScale,(Real)1.,"restScale","Scale factor applied to rest positions (to simulate pre-stretched materials)"))
+    , d_parallelComputation(initData(&d_parallelComputation,false,"parallelComputation","Compute the triangles with the threads of the TaskScheduler"))
     , d_showStressVector(initData(&d_showStressVector,false,"showStressVector","Flag activating rendering of stress directions within each triangle"))
     , d_showStressMaxValue(initData(&d_showStressMaxValue,(Real)0.0,"showStressMaxValue","Max value for rendering of stress values"))
     , l_topology(initLink("topology", "link to the topology container"))
@@ -135,6 +158,9 @@ void TriangularFEMForceFieldOptim<DataTypes>::init()
         msg_warning() << "The topology only contains quads while this forcefield only supports triangles."<<msgendl;
     }
 
+    if (d_parallelComputation.getValue())
+        simulation::initTaskScheduler();
+
     reinit();
 }
 
@@ -261,24 +287,70 @@ SReal TriangularFEMForceFieldOptim<DataTypes>::getPotentialEnergy(const core::Me
 
 
 // --------------------------------------------------------------------------------------
-// --- AddForce and AddDForce methods
+// --- Parallel computations
 // --------------------------------------------------------------------------------------
 template <class DataTypes>
-void TriangularFEMForceFieldOptim<DataTypes>::addForce(const core::MechanicalParams* /* mparams */, DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& /* d_v */)
+void TriangularFEMForceFieldOptim<DataTypes>::forEachRange(std::size_t n, const std::function<void(std::size_t,std::size_t)>& f)
 {
-    sofa::helper::WriteAccessor< core::objectmodel::Data< VecDeriv > > f = d_f;
-    sofa::helper::ReadAccessor< core::objectmodel::Data< VecCoord > > x = d_x;
-    sofa::helper::WriteAccessor< core::objectmodel::Data< VecTriangleState > > triState = d_triangleState;
-    sofa::helper::ReadAccessor< core::objectmodel::Data< VecTriangleInfo > > triInfo = d_triangleInfo;
+    simulation::TaskScheduler* taskScheduler = d_parallelComputation.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    simulation::parallelForRange(taskScheduler, 0, n, trianglefemoptim::minElementsPerTask, f);
+}
 
+template <class DataTypes>
+void TriangularFEMForceFieldOptim<DataTypes>::updateVertexTriangles()
+{
+    const unsigned int nbPoints = this->mstate->getSize();
     const unsigned int nbTriangles = m_topology->getNbTriangles();
+    if (!m_vertexTrianglesDirty
+        && m_vertexTrianglesRevision == m_topology->getRevision()
+        && m_vertexTrianglesBegin.size() == nbPoints+1
+        && m_vertexTriangles.size() == 3*nbTriangles)
+        return;
+
+    const VecElement& triangles = m_topology->getTriangles();
+    m_vertexTrianglesBegin.resize(nbPoints+1);
+    std::fill(m_vertexTrianglesBegin.begin(), m_vertexTrianglesBegin.end(), 0);
+    for (unsigned int i=0; i<nbTriangles; ++i)
+        for (unsigned int j=0; j<3; ++j)
+            ++m_vertexTrianglesBegin[triangles[i][j]+1];
+    for (unsigned int v=0; v<nbPoints; ++v)
+        m_vertexTrianglesBegin[v+1] += m_vertexTrianglesBegin[v];
+
+    // filled in the order of the triangles, so that each vertex sums its contributions in that order
+    std::vector<Index> next(m_vertexTrianglesBegin.begin(), m_vertexTrianglesBegin.end()-1);
+    m_vertexTriangles.resize(3*nbTriangles);
+    for (unsigned int i=0; i<nbTriangles; ++i)
+        for (unsigned int j=0; j<3; ++j)
+            m_vertexTriangles[next[triangles[i][j]]++] = 3*i+j;
+
+    m_vertexTrianglesRevision = m_topology->getRevision();
+    m_vertexTrianglesDirty = false;
+}
+
+template <class DataTypes>
+void TriangularFEMForceFieldOptim<DataTypes>::accumulateTriangleForces(VecDeriv& f)
+{
+    forEachRange(m_vertexTrianglesBegin.size()-1, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t v=begin; v<end; ++v)
+            for (Index k=m_vertexTrianglesBegin[v]; k<m_vertexTrianglesBegin[v+1]; ++k)
+                f[v] += m_triangleForces[m_vertexTriangles[k]];
+    });
+}
+
+// --------------------------------------------------------------------------------------
+// --- AddForce and AddDForce methods
+// --------------------------------------------------------------------------------------
+template <class DataTypes>
+template <bool storeForces>
+void TriangularFEMForceFieldOptim<DataTypes>::computeTrianglesForce(VecDeriv& f, const VecCoord& x, VecTriangleState& triState, const VecTriangleInfo& triInfo,
+                                                                    std::size_t begin, std::size_t end)
+{
     const VecElement& triangles = m_topology->getTriangles();
     const Real gamma = this->gamma;
     const Real mu = this->mu;
 
-    f.resize(x.size());
-
-    for ( Index i=0; i<nbTriangles; i+=1)
+    for ( std::size_t i=begin; i<end; i+=1)
     {
         Triangle t = triangles[i];
         const TriangleInfo& ti = triInfo[i];
@@ -311,32 +383,62 @@ void TriangularFEMForceFieldOptim<DataTypes>::addForce(const core::MechanicalPar
         Deriv fc = ts.frame[0] * (ti.bx * stress[2])                      // ( 0,   0,  bx) * stress
                 + ts.frame[1] * (ti.bx * stress[1]);                     // ( 0,  bx,   0) * stress
         Deriv fa = -fb-fc;
-        f[t[0]] += fa;
-        f[t[1]] += fb;
-        f[t[2]] += fc;
+        if constexpr (storeForces)
+        {
+            m_triangleForces[3*i] = fa;
+            m_triangleForces[3*i+1] = fb;
+            m_triangleForces[3*i+2] = fc;
+        }
+        else
+        {
+            f[t[0]] += fa;
+            f[t[1]] += fb;
+            f[t[2]] += fc;
+        }
     }
 }
 
-// --------------------------------------------------------------------------------------
-// ---
-// --------------------------------------------------------------------------------------
 template <class DataTypes>
-void TriangularFEMForceFieldOptim<DataTypes>::addDForce(const core::MechanicalParams* mparams, DataVecDeriv& d_df, const DataVecDeriv& d_dx)
+void TriangularFEMForceFieldOptim<DataTypes>::addForce(const core::MechanicalParams* /* mparams */, DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& /* d_v */)
 {
-    sofa::helper::WriteAccessor< core::objectmodel::Data< VecDeriv > > df = d_df;
-    sofa::helper::ReadAccessor< core::objectmodel::Data< VecCoord > > dx = d_dx;
-    sofa::helper::ReadAccessor< core::objectmodel::Data< VecTriangleState > > triState = d_triangleState;
+    sofa::helper::WriteAccessor< core::objectmodel::Data< VecDeriv > > f = d_f;
+    sofa::helper::ReadAccessor< core::objectmodel::Data< VecCoord > > x = d_x;
+    sofa::helper::WriteAccessor< core::objectmodel::Data< VecTriangleState > > triState = d_triangleState;
     sofa::helper::ReadAccessor< core::objectmodel::Data< VecTriangleInfo > > triInfo = d_triangleInfo;
 
     const unsigned int nbTriangles = m_topology->getNbTriangles();
+
+    f.resize(x.size());
+
+    if (!d_parallelComputation.getValue())
+    {
+        computeTrianglesForce<false>(f.wref(), x.ref(), triState.wref(), triInfo.ref(), 0, nbTriangles);
+        return;
+    }
+
+    // the triangles write their own forces, which are then gathered per vertex
+    updateVertexTriangles();
+    m_triangleForces.resize(3*nbTriangles);
+    forEachRange(nbTriangles, [&](std::size_t begin, std::size_t end)
+    {
+        computeTrianglesForce<true>(f.wref(), x.ref(), triState.wref(), triInfo.ref(), begin, end);
+    });
+    accumulateTriangleForces(f.wref());
+}
+
+// --------------------------------------------------------------------------------------
+// ---
+// --------------------------------------------------------------------------------------
+template <class DataTypes>
+template <bool storeForces>
+void TriangularFEMForceFieldOptim<DataTypes>::computeTrianglesDForce(VecDeriv& df, const VecDeriv& dx, const VecTriangleState& triState, const VecTriangleInfo& triInfo,
+                                                                     Real kFactor, std::size_t begin, std::size_t end)
+{
     const VecElement& triangles = m_topology->getTriangles();
     const Real gamma = this->gamma;
     const Real mu = this->mu;
-    const Real kFactor = (Real)sofa::core::mechanicalparams::kFactorIncludingRayleighDamping(mparams, this->rayleighStiffness.getValue());
 
-    df.resize(dx.size());
-
-    for ( Index i=0; i<nbTriangles; i+=1)
+    for ( std::size_t i=begin; i<end; i+=1)
     {
         Triangle t = triangles[i];
         const TriangleInfo& ti = triInfo[i];
@@ -367,12 +469,50 @@ void TriangularFEMForceFieldOptim<DataTypes>::addDForce(const core::MechanicalPa
         Deriv dfc = ts.frame[0] * (ti.bx * dstress[2])                       // ( 0,   0,  bx) * dstress
                 + ts.frame[1] * (ti.bx * dstress[1]);                      // ( 0,  bx,   0) * dstress
         Deriv dfa = -dfb-dfc;
-        df[t[0]] -= dfa;
-        df[t[1]] -= dfb;
-        df[t[2]] -= dfc;
+        if constexpr (storeForces)
+        {
+            // negated: adding them gives the same values as the subtractions below
+            m_triangleForces[3*i] = -dfa;
+            m_triangleForces[3*i+1] = -dfb;
+            m_triangleForces[3*i+2] = -dfc;
+        }
+        else
+        {
+            df[t[0]] -= dfa;
+            df[t[1]] -= dfb;
+            df[t[2]] -= dfc;
+        }
     }
 }
 
+template <class DataTypes>
+void TriangularFEMForceFieldOptim<DataTypes>::addDForce(const core::MechanicalParams* mparams, DataVecDeriv& d_df, const DataVecDeriv& d_dx)
+{
+    sofa::helper::WriteAccessor< core::objectmodel::Data< VecDeriv > > df = d_df;
+    sofa::helper::ReadAccessor< core::objectmodel::Data< VecCoord > > dx = d_dx;
+    sofa::helper::ReadAccessor< core::objectmodel::Data< VecTriangleState > > triState = d_triangleState;
+    sofa::helper::ReadAccessor< core::objectmodel::Data< VecTriangleInfo > > triInfo = d_triangleInfo;
+
+    const unsigned int nbTriangles = m_topology->getNbTriangles();
+    const Real kFactor = (Real)sofa::core::mechanicalparams::kFactorIncludingRayleighDamping(mparams, this->rayleighStiffness.getValue());
+
+    df.resize(dx.size());
+
+    if (!d_parallelComputation.getValue())
+    {
+        computeTrianglesDForce<false>(df.wref(), dx.ref(), triState.ref(), triInfo.ref(), kFactor, 0, nbTriangles);
+        return;
+    }
+
+    updateVertexTriangles();
+    m_triangleForces.resize(3*nbTriangles);
+    forEachRange(nbTriangles, [&](std::size_t begin, std::size_t end)
+    {
+        computeTrianglesDForce<true>(df.wref(), dx.ref(), triState.ref(), triInfo.ref(), kFactor, begin, end);
+    });
+    accumulateTriangleForces(df.wref());
+}
+
 
 // --------------------------------------------------------------------------------------
 // ---
@@ -33,6 +33,7 @@ using sofa::helper::system::SetDirectory;
 #include <sofa/gui/ArgumentParser.h>
 #include <thread>
 #include <chrono>
+#include <cstring>
 
 namespace sofa::gui::hRecorder
 {
@@ -49,6 +50,7 @@ bool HeadlessRecorder::recordUntilStopAnimate = false;
 std::string HeadlessRecorder::recordTypeRaw = "wallclocktime";
 RecordMode HeadlessRecorder::recordType = RecordMode::wallclocktime;
 float HeadlessRecorder::skipTime = 0;
+unsigned int HeadlessRecorder::asyncFrames = 3;
 
 using namespace sofa::defaulttype;
 using sofa::simulation::getSimulation;
@@ -81,6 +83,9 @@ HeadlessRecorder::HeadlessRecorder()
 
 HeadlessRecorder::~HeadlessRecorder()
 {
+    finishAsyncCapture();
+    if (!m_pbos.empty())
+        glDeleteBuffers(static_cast<GLsizei>(m_pbos.size()), m_pbos.data());
     glDeleteFramebuffers(1, &fbo);
     glDeleteRenderbuffers(1, &rbo_color);
     glDeleteRenderbuffers(1, &rbo_depth);
@@ -130,6 +135,8 @@ int HeadlessRecorder::RegisterGUIParameters(ArgumentParser* argumentParser)
                                 "recordUntilEndAnimate", "(only HeadLessRecorder) recording until the end of animation does not care how many seconds have been set");
     argumentParser->addArgument(boost::program_options::value<std::string>(&recordTypeRaw)->default_value("wallclocktime"),
                                 "recordingmode", "(only HeadLessRecorder) define how the recording should be made; either \"simulationtime\" (records as if it was simulating in real time and skips frames accordingly), \"wallclocktime\" (records a frame for each time step) or an arbitrary interval time between each frame as a float.");
+    argumentParser->addArgument(boost::program_options::value<unsigned int>(&asyncFrames)->default_value(3),
+                                "asyncFrames", "(only HeadLessRecorder) number of frames read back asynchronously (pixel buffer objects) and encoded in a separate thread; 0 reads back and encodes each frame synchronously");
     return 0;
 }
 
@@ -366,6 +373,7 @@ int HeadlessRecorder::mainLoop()
             std::this_thread::sleep_for(std::chrono::seconds(10));
         }
     }
+    finishAsyncCapture();
     msg_info("HeadlessRecorder") << "Recording time: " << recordTimeInSeconds << " seconds at: " << fps << " fps.";
     return 0;
 }
@@ -597,6 +605,12 @@ void HeadlessRecorder::setViewerResolution(int width, int height)
 // -----------------------------------------------------------------
 void HeadlessRecorder::record()
 {
+    if (asyncFrames > 0)
+    {
+        recordAsync();
+        return;
+    }
+
     if (saveAsScreenShot)
     {
         std::stringstream ss;
@@ -619,6 +633,170 @@ void HeadlessRecorder::record()
     }
 }
 
+void HeadlessRecorder::recordAsync()
+{
+    if (!saveAsScreenShot && saveAsVideo && requestVideoRecorderInit)
+        initVideoRecorder();
+    if (!m_encoderThread.joinable())
+        initAsyncCapture();
+
+    // same frames as the synchronous capture: the video stops with the recording time
+    if (saveAsScreenShot || canRecord())
+        readFrameAsync();
+}
+
+void HeadlessRecorder::initAsyncCapture()
+{
+    // pictures are saved in RGB like sofa::gl::Capture, the video recorder expects RGBA
+    m_pixelFormat = saveAsScreenShot ? GL_RGB : GL_RGBA;
+    m_frameSize = static_cast<std::size_t>(s_width) * static_cast<std::size_t>(s_height) * (saveAsScreenShot ? 3 : 4);
+
+    if (m_pbos.empty())
+    {
+        m_pbos.resize(asyncFrames);
+        m_pboFrameIndex.resize(asyncFrames, 0);
+        glGenBuffers(static_cast<GLsizei>(m_pbos.size()), m_pbos.data());
+        for (const GLuint pbo : m_pbos)
+        {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(m_frameSize), nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    m_nIssuedFrames = 0;
+    m_stopEncoder = false;
+    m_encoderThread = std::thread(&HeadlessRecorder::encoderLoop, this);
+}
+
+void HeadlessRecorder::readFrameAsync()
+{
+    const auto slot = static_cast<unsigned int>(m_nIssuedFrames % m_pbos.size());
+
+    // the transfer into this buffer was issued asyncFrames frames ago, it is complete by now
+    if (m_nIssuedFrames >= m_pbos.size())
+        collectFrame(slot);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[slot]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, s_width, s_height, m_pixelFormat, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    m_pboFrameIndex[slot] = m_nFrames;
+    ++m_nIssuedFrames;
+}
+
+void HeadlessRecorder::collectFrame(unsigned int slot)
+{
+    CapturedFrame frame;
+    frame.index = m_pboFrameIndex[slot];
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (!m_freeBuffers.empty())
+        {
+            frame.pixels = std::move(m_freeBuffers.back());
+            m_freeBuffers.pop_back();
+        }
+    }
+    frame.pixels.resize(m_frameSize);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pbos[slot]);
+    const auto* data = static_cast<const unsigned char*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+    if (data)
+    {
+        std::memcpy(frame.pixels.data(), data, m_frameSize);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (!data)
+    {
+        msg_error("HeadlessRecorder") << "Failed to map the pixel buffer of frame " << frame.index;
+        return;
+    }
+
+    // bounded queue: the render thread only waits when the encoder is far behind
+    const std::size_t maxQueuedFrames = 2 * m_pbos.size();
+    std::unique_lock<std::mutex> lock(m_queueMutex);
+    m_queueCondition.wait(lock, [this, maxQueuedFrames] { return m_frameQueue.size() < maxQueuedFrames; });
+    m_frameQueue.push_back(std::move(frame));
+    lock.unlock();
+    m_queueCondition.notify_all();
+}
+
+void HeadlessRecorder::finishAsyncCapture()
+{
+    if (!m_encoderThread.joinable())
+        return;
+
+    // collect the frames still in flight, oldest first
+    const auto nbBuffers = static_cast<unsigned int>(m_pbos.size());
+    const unsigned int first = (m_nIssuedFrames > nbBuffers) ? m_nIssuedFrames - nbBuffers : 0;
+    for (unsigned int i = first; i < m_nIssuedFrames; ++i)
+        collectFrame(i % nbBuffers);
+    m_nIssuedFrames = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_stopEncoder = true;
+    }
+    m_queueCondition.notify_all();
+    m_encoderThread.join();
+
+    if (!saveAsScreenShot && !requestVideoRecorderInit)
+    {
+        m_videorecorder.finishVideo();
+        requestVideoRecorderInit = true;
+    }
+}
+
+void HeadlessRecorder::encoderLoop()
+{
+    while (true)
+    {
+        CapturedFrame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_queueMutex);
+            m_queueCondition.wait(lock, [this] { return m_stopEncoder || !m_frameQueue.empty(); });
+            if (m_frameQueue.empty())
+                break; // stop requested and every frame encoded
+            frame = std::move(m_frameQueue.front());
+            m_frameQueue.pop_front();
+        }
+        m_queueCondition.notify_all();
+
+        encodeFrame(frame);
+
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        m_freeBuffers.push_back(std::move(frame.pixels));
+    }
+}
+
+void HeadlessRecorder::encodeFrame(const CapturedFrame& frame)
+{
+    if (saveAsScreenShot)
+    {
+        std::stringstream ss;
+        ss << std::setw(8) << std::setfill('0') << frame.index;
+        const std::string pngFilename = fileName + ss.str() + ".png";
+
+        std::unique_ptr<helper::io::Image> img(helper::io::Image::FactoryImage::getInstance()->createObject("png", ""));
+        if (!img)
+        {
+            msg_error("HeadlessRecorder") << "Could not write png image format (no support found)";
+            return;
+        }
+        img->init(s_width, s_height, 1, 1, helper::io::Image::UNORM8, helper::io::Image::RGB);
+        std::memcpy(img->getPixels(), frame.pixels.data(), frame.pixels.size());
+        if (!img->save(pngFilename, 0))
+            msg_error("HeadlessRecorder") << "Unknown error while saving screen image to " << pngFilename;
+    }
+    else
+    {
+        m_videorecorder.addFrame(frame.pixels.data());
+    }
+}
+
 // See also GLBackend::initRecorder
 void HeadlessRecorder::initVideoRecorder()
 {
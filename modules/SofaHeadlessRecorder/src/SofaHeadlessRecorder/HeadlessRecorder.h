@@ -37,6 +37,11 @@
 #include <ctime>
 #include <iomanip>
 #include <memory>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 // OPENGL
 #define GL_GLEXT_PROTOTYPES 1
@@ -100,6 +105,39 @@ private:
 
     void initVideoRecorder();
 
+    /// @name Asynchronous capture
+    /// The frames are read back into a ring of pixel buffer objects, so that glReadPixels returns immediately.
+    /// A buffer is mapped asyncFrames frames later, once its transfer is complete, and its pixels are queued
+    /// to an encoder thread which writes the video or the pictures.
+    /// @{
+    struct CapturedFrame
+    {
+        std::vector<unsigned char> pixels;
+        int index {0};
+    };
+
+    void recordAsync();
+    void initAsyncCapture();
+    void readFrameAsync();
+    void collectFrame(unsigned int slot);
+    void finishAsyncCapture();
+    void encoderLoop();
+    void encodeFrame(const CapturedFrame& frame);
+
+    std::vector<GLuint> m_pbos;
+    std::vector<int> m_pboFrameIndex;
+    unsigned int m_nIssuedFrames {0};
+    GLenum m_pixelFormat {GL_RGBA};
+    std::size_t m_frameSize {0};
+
+    std::thread m_encoderThread;
+    std::mutex m_queueMutex;
+    std::condition_variable m_queueCondition;
+    std::deque<CapturedFrame> m_frameQueue;
+    std::vector<std::vector<unsigned char> > m_freeBuffers;
+    bool m_stopEncoder {false};
+    /// @}
+
     VisualParams* vparams;
     DrawToolGL   drawTool;
 
@@ -128,6 +166,7 @@ private:
     static std::string recordTypeRaw;
     static RecordMode recordType;
     static float skipTime;
+    static unsigned int asyncFrames;
 };
 
 } // namespace sofa
@@ -0,0 +1,204 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaMiscFem/ProperOrthogonalDecomposition.h>
+#include <SofaMiscFem/TetrahedronECSWSampling.h>
+#include <SofaSimpleFem/TetrahedronFEMForceField.h>
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <SofaBaseTopology/TetrahedronSetTopologyContainer.h>
+
+#include <sofa/testing/BaseSimulationTest.h>
+using sofa::testing::BaseSimulationTest;
+
+#include <sofa/simulation/Node.h>
+using sofa::simulation::Node ;
+
+#include <SofaSimulationCommon/SceneLoaderXML.h>
+using sofa::simulation::SceneLoaderXML ;
+
+#include <SofaBase/initSofaBase.h>
+
+#include <filesystem>
+#include <fstream>
+
+namespace sofa {
+
+using namespace sofa::defaulttype;
+using sofa::component::engine::ProperOrthogonalDecomposition;
+using sofa::component::engine::TetrahedronECSWSampling;
+using sofa::component::forcefield::TetrahedronFEMForceField;
+
+/// Reduction of a corotational beam from snapshots of two deformations: the sampled tetrahedra
+/// must reproduce the forces of the full mesh projected on the basis.
+struct TetrahedronECSWSampling_test : public BaseSimulationTest
+{
+    typedef Vec3Types::VecCoord VecCoord;
+    typedef Vec3Types::VecDeriv VecDeriv;
+    typedef TetrahedronFEMForceField<Vec3Types> FEMForceField;
+
+    std::string filename;
+
+    void SetUp() override
+    {
+        sofa::component::initSofaBase();
+        filename = (std::filesystem::temp_directory_path() / "TetrahedronECSWSampling_test.txt").string();
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove(filename);
+    }
+
+    /// Writes the snapshots in the format of WriteState
+    void writeSnapshots(const VecCoord& x0)
+    {
+        std::ofstream file(filename.c_str());
+        const SReal amplitudes[6][2] = { {0.1,0}, {0,0.1}, {0.2,0.1}, {-0.1,0.2}, {0.3,-0.2}, {0.05,0.3} };
+        for (unsigned s=0; s<6; s++)
+        {
+            file << "T= " << s << "\n  X= ";
+            for (const auto& p : x0)
+            {
+                // bending along x, and twisting around x
+                const Vec3Types::Coord u(0, amplitudes[s][0]*p[0]*p[0], amplitudes[s][1]*p[0]*p[1]);
+                file << p + u << " ";
+            }
+            file << "\n";
+        }
+    }
+
+    /// Forces of the force field at the given positions, projected on the modes of the basis restricted to the given points
+    static helper::vector<SReal> reducedForce(FEMForceField* ff, const VecCoord& x, const VecDeriv& basis, std::size_t nbModes, const helper::vector<unsigned>& indices)
+    {
+        Data<VecCoord> xData;
+        Data<VecDeriv> vData, fData;
+        xData.setValue(x);
+        vData.setValue(VecDeriv(x.size()));
+        fData.setValue(VecDeriv(x.size()));
+        ff->addForce(core::mechanicalparams::defaultInstance(), fData, xData, vData);
+
+        const std::size_t nbPoints = basis.size() / nbModes;
+        helper::vector<SReal> r(nbModes, 0);
+        for (std::size_t k=0; k<nbModes; k++)
+            for (std::size_t i=0; i<x.size(); i++)
+                r[k] += dot(basis[k*nbPoints + indices[i]], fData.getValue()[i]);
+        return r;
+    }
+
+    void checkReducedForces()
+    {
+        const std::string scene =
+                "<?xml version='1.0'?>"
+                "<Node name='root'>"
+                "    <Node name='full'>"
+                "        <RegularGridTopology name='grid' n='7 3 3' min='0 0 0' max='3 1 1' />"
+                "        <MechanicalObject name='dofs' />"
+                "        <TetrahedronFEMForceField name='fem' youngModulus='1000' poissonRatio='0.3' method='large' />"
+                "    </Node>"
+                "</Node>";
+        Node::SPtr root = SceneLoaderXML::loadFromMemory("checkReducedForces", scene.c_str(), unsigned(scene.size()));
+        ASSERT_NE(root.get(), nullptr);
+        root->init(sofa::core::execparams::defaultInstance());
+
+        FEMForceField* full = root->getTreeObject<FEMForceField>();
+        ASSERT_NE(full, nullptr);
+        const VecCoord x0 = full->_initialPoints.getValue();
+        writeSnapshots(x0);
+
+        // basis
+        ProperOrthogonalDecomposition<Vec3Types>::SPtr pod = core::objectmodel::New<ProperOrthogonalDecomposition<Vec3Types> >();
+        root->addObject(pod);
+        pod->d_filename.setValue(filename);
+        pod->d_position.setValue(x0);
+        pod->init();
+        const VecDeriv basis = pod->d_basis.getValue();
+        ASSERT_EQ(basis.size(), 2*x0.size()); // two independent deformations
+        const std::size_t nbModes = 2;
+
+        // sampling
+        TetrahedronECSWSampling<Vec3Types>::SPtr ecsw = core::objectmodel::New<TetrahedronECSWSampling<Vec3Types> >();
+        root->addObject(ecsw);
+        ecsw->l_forceField.set(full);
+        ecsw->d_filename.setValue(filename);
+        ecsw->d_basis.setValue(basis);
+        ecsw->d_tolerance.setValue(0.01);
+        ecsw->init();
+        const helper::vector<sofa::Index>& elements = ecsw->d_elements.getValue();
+        const helper::vector<unsigned>& indices = ecsw->d_indices.getValue();
+        ASSERT_FALSE(elements.empty());
+        EXPECT_LT(elements.size(), full->getIndexedElements().size());
+        ASSERT_EQ(ecsw->d_weights.getValue().size(), elements.size());
+        ASSERT_EQ(ecsw->d_position.getValue().size(), indices.size());
+
+        // the force field of the full mesh is left as it was
+        EXPECT_TRUE(full->_localStiffnessFactor.getValue().empty());
+
+        // online force field on the sampled mesh, weighted by the stiffness factors
+        Node::SPtr sampledNode = root->createChild("sampled");
+        component::container::MechanicalObject<Vec3Types>::SPtr sampledDofs = core::objectmodel::New<component::container::MechanicalObject<Vec3Types> >();
+        sampledNode->addObject(sampledDofs);
+        sampledDofs->x.setValue(ecsw->d_position.getValue());
+        core::objectmodel::BaseObject::SPtr topology = sofa::core::objectmodel::New<component::topology::TetrahedronSetTopologyContainer>();
+        sampledNode->addObject(topology);
+        topology->findData("tetrahedra")->copyValueFrom(&ecsw->d_tetrahedra);
+        FEMForceField::SPtr sampled = core::objectmodel::New<FEMForceField>();
+        sampledNode->addObject(sampled);
+        sampled->setYoungModulus(1000);
+        sampled->setPoissonRatio(0.3);
+        sampled->setMethod(FEMForceField::LARGE);
+        sampled->_localStiffnessFactor.setValue(ecsw->d_weights.getValue());
+        sampledNode->init(sofa::core::execparams::defaultInstance());
+
+        helper::vector<unsigned> all(x0.size());
+        for (unsigned i=0; i<all.size(); i++)
+            all[i] = i;
+
+        // the tolerance bounds the root mean square of the relative errors of the snapshots
+        SReal squaredErrors = 0;
+        helper::vector<VecCoord> snapshots;
+        ASSERT_TRUE(ProperOrthogonalDecomposition<Vec3Types>::readSnapshots(filename, x0.size(), snapshots));
+        for (const VecCoord& x : snapshots)
+        {
+            VecCoord xs(indices.size());
+            for (std::size_t i=0; i<indices.size(); i++)
+                xs[i] = x[indices[i]];
+
+            const helper::vector<SReal> expected = reducedForce(full, x, basis, nbModes, all);
+            const helper::vector<SReal> actual = reducedForce(sampled.get(), xs, basis, nbModes, indices);
+            SReal norm = 0, error = 0;
+            for (std::size_t k=0; k<nbModes; k++)
+            {
+                norm += expected[k]*expected[k];
+                error += (actual[k]-expected[k])*(actual[k]-expected[k]);
+            }
+            ASSERT_GT(norm, 0);
+            squaredErrors += error / norm;
+        }
+        EXPECT_LE(std::sqrt(squaredErrors / snapshots.size()), 0.01);
+    }
+};
+
+TEST_F(TetrahedronECSWSampling_test, checkReducedForces)
+{
+    this->checkReducedForces();
+}
+
+} // namespace sofa
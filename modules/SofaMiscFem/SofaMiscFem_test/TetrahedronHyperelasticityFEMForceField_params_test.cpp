@@ -36,6 +36,7 @@ using sofa::testing::BaseSimulationTest;
 #include <SofaEngine/initSofaEngine.h>
 
 #include <sofa/defaulttype/Vec.h>
+#include <sofa/simulation/TaskScheduler.h>
 
 #include <iostream>
 #include <fstream>
@@ -142,6 +143,45 @@ struct TetrahedronHyperelasticityFEMForceField_params_test : public BaseSimulati
         sofa::core::objectmodel::BaseObject* hefem = root->getTreeNode("Hyperelastic-Liver")->getObject("FEM") ;
         EXPECT_NE(hefem, nullptr) ;
     }
+
+    /// Simulate a few steps with the given material and return the final positions
+    VecCoord simulate_material(const std::string& materialName, const sofa::helper::vector<Real>& param_vector, bool parallel)
+    {
+        this->scene_load();
+
+        typename TetrahedronHyperelasticityFEMForceField::SPtr FF = sofa::core::objectmodel::New< TetrahedronHyperelasticityFEMForceField >();
+        hyperelasticNode->addObject(FF);
+        FF->setName("FEM");
+        FF->setMaterialName(materialName);
+        FF->setparameter(param_vector);
+        FF->findData("parallelComputation")->read(parallel ? "true" : "false");
+
+        sofa::simulation::getSimulation()->init(this->root.get());
+        for (unsigned int stepId = 0; stepId < 5; ++stepId)
+            sofa::simulation::getSimulation()->animate(this->root.get(), timeStep);
+
+        dof = hyperelasticNode->template get<DOF>();
+        VecCoord x = dof->readPositions().ref();
+        sofa::simulation::getSimulation()->unload(this->root);
+        return x;
+    }
+
+    /// The parallel evaluation accumulates in the same order as the sequential one: the results must be identical
+    void run_test_parallel_computation(const std::string& materialName, const sofa::helper::vector<Real>& param_vector)
+    {
+        simulation::TaskScheduler* taskScheduler = simulation::TaskScheduler::getInstance();
+        if (taskScheduler->getThreadCount() < 2)
+            taskScheduler->init(4);
+
+        const VecCoord sequentialX = simulate_material(materialName, param_vector, false);
+        const VecCoord parallelX = simulate_material(materialName, param_vector, true);
+
+        ASSERT_EQ(sequentialX.size(), parallelX.size());
+        ASSERT_FALSE(sequentialX.empty());
+        for (std::size_t i = 0; i < sequentialX.size(); ++i)
+            for (unsigned int c = 0; c < 3; ++c)
+                EXPECT_EQ(sequentialX[i][c], parallelX[i][c]) << "point " << i;
+    }
 };
 
 
@@ -163,6 +203,15 @@ TYPED_TEST( TetrahedronHyperelasticityFEMForceField_params_test , extension )
     this->run_test_params_mooney_case();
 }
 
+TYPED_TEST( TetrahedronHyperelasticityFEMForceField_params_test , parallelComputation )
+{
+    EXPECT_MSG_NOEMIT(Error) ;
+
+    this->run_test_parallel_computation("MooneyRivlin", { 151065.460, 101709.668, 1e07 });
+    this->run_test_parallel_computation("NeoHookean", { 1e5, 1e7 });
+    this->run_test_parallel_computation("StVenantKirchhoff", { 1e5, 1e6 });
+}
+
 
 } // namespace sofa
 
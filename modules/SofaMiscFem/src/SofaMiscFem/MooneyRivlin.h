@@ -50,6 +50,8 @@ class MooneyRivlin : public HyperelasticMaterial<DataTypes>{
   typedef defaulttype::Mat<6,6,Real> Matrix6;
   typedef defaulttype::MatSym<3,Real> MatrixSym;
  
+public:
+
   virtual Real getStrainEnergy(StrainInformation<DataTypes> *sinfo, const MaterialParameters<DataTypes> &param) {
 	  MatrixSym inversematrix;
 		MatrixSym C=sinfo->deformationTensor;
@@ -0,0 +1,84 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+#include <SofaMiscFem/config.h>
+
+#include <sofa/core/DataEngine.h>
+#include <sofa/core/objectmodel/DataFileName.h>
+#include <sofa/defaulttype/VecTypes.h>
+
+
+namespace sofa::component::engine
+{
+
+/**
+ * Reduced basis of a deformable object, computed offline from simulation snapshots.
+ *
+ * The snapshots are the positions recorded by a WriteState component during a
+ * full-resolution simulation. The modes are the left singular vectors of the
+ * matrix of the snapshot displacements (x - position), computed by the method
+ * of snapshots. They are sorted by decreasing singular value, and truncated to
+ * nbModes, or to the modes needed to capture all the snapshot energy but the
+ * given tolerance.
+ *
+ * The basis is the input of ReducedBasisMapping.
+ */
+template <class DataTypes>
+class ProperOrthogonalDecomposition : public core::DataEngine
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE(ProperOrthogonalDecomposition,DataTypes),core::DataEngine);
+    typedef typename DataTypes::Real Real;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::VecDeriv VecDeriv;
+
+protected:
+
+    ProperOrthogonalDecomposition();
+
+    ~ProperOrthogonalDecomposition() override {}
+public:
+    void init() override;
+
+    void reinit() override;
+
+    void doUpdate() override;
+
+    /// Read the positions ("X=" lines) of a file written by WriteState, each with nbPoints values
+    /// @return false if the file can not be read or a line has not the expected size
+    static bool readSnapshots(const std::string& filename, std::size_t nbPoints, helper::vector<VecCoord>& snapshots);
+
+    core::objectmodel::DataFileName d_filename; ///< positions recorded by WriteState
+    Data<VecCoord> d_position; ///< reference positions, the snapshot displacements are computed from
+    Data<unsigned int> d_nbModes; ///< maximum number of modes
+    Data<Real> d_tolerance; ///< fraction of the snapshot energy the modes may leave out
+    Data<VecDeriv> d_basis; ///< modes, stored one after the other (mode k of point i at k*nbPoints+i)
+    Data<helper::vector<Real> > d_singularValues; ///< singular values of the kept modes
+};
+
+#if  !defined(SOFA_COMPONENT_ENGINE_PROPERORTHOGONALDECOMPOSITION_CPP)
+extern template class SOFA_SOFAMISCFEM_API ProperOrthogonalDecomposition<defaulttype::Vec3Types>;
+#endif
+
+} //namespace sofa::component::engine
@@ -0,0 +1,167 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+#include <SofaMiscFem/ProperOrthogonalDecomposition.h>
+
+#include <Eigen/Dense>
+
+#include <fstream>
+#include <sstream>
+
+namespace sofa::component::engine
+{
+
+template <class DataTypes>
+ProperOrthogonalDecomposition<DataTypes>::ProperOrthogonalDecomposition()
+    : d_filename( initData(&d_filename, "filename", "positions recorded by WriteState (uncompressed)") )
+    , d_position( initData(&d_position, "position", "reference positions, the snapshot displacements are computed from") )
+    , d_nbModes( initData(&d_nbModes, 10u, "nbModes", "maximum number of modes") )
+    , d_tolerance( initData(&d_tolerance, Real(1e-4), "tolerance", "fraction of the snapshot energy the modes may leave out") )
+    , d_basis( initData(&d_basis, "basis", "modes, stored one after the other (mode k of point i at k*nbPoints+i)") )
+    , d_singularValues( initData(&d_singularValues, "singularValues", "singular values of the kept modes") )
+{
+}
+
+template <class DataTypes>
+void ProperOrthogonalDecomposition<DataTypes>::init()
+{
+    addInput(&d_filename);
+    addInput(&d_position);
+    addInput(&d_nbModes);
+    addInput(&d_tolerance);
+    addOutput(&d_basis);
+    addOutput(&d_singularValues);
+    setDirtyValue();
+}
+
+template <class DataTypes>
+void ProperOrthogonalDecomposition<DataTypes>::reinit()
+{
+    update();
+}
+
+template <class DataTypes>
+bool ProperOrthogonalDecomposition<DataTypes>::readSnapshots(const std::string& filename, std::size_t nbPoints, helper::vector<VecCoord>& snapshots)
+{
+    std::ifstream file(filename.c_str());
+    if (!file.is_open())
+        return false;
+
+    std::string line, cmd;
+    while (std::getline(file, line))
+    {
+        std::istringstream str(line);
+        str >> cmd;
+        if (cmd != "X=")
+            continue;
+
+        VecCoord x;
+        x.reserve(nbPoints);
+        Coord c;
+        while (str >> c)
+            x.push_back(c);
+        if (x.size() != nbPoints)
+            return false;
+        snapshots.push_back(x);
+    }
+    return true;
+}
+
+template <class DataTypes>
+void ProperOrthogonalDecomposition<DataTypes>::doUpdate()
+{
+    typedef Eigen::Matrix<Real, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+
+    const VecCoord& position = d_position.getValue();
+    const std::size_t nbPoints = position.size();
+    const std::size_t size = nbPoints * DataTypes::deriv_total_size;
+
+    helper::WriteOnlyAccessor<Data<VecDeriv> > basis = d_basis;
+    helper::WriteOnlyAccessor<Data<helper::vector<Real> > > singularValues = d_singularValues;
+    basis.clear();
+    singularValues.clear();
+
+    helper::vector<VecCoord> snapshots;
+    if (!readSnapshots(d_filename.getFullPath(), nbPoints, snapshots))
+    {
+        msg_error() << "Can not read the snapshots of " << nbPoints << " points in '" << d_filename.getFullPath() << "'";
+        return;
+    }
+    if (snapshots.empty())
+    {
+        msg_warning() << "No snapshot in '" << d_filename.getFullPath() << "'";
+        return;
+    }
+
+    // snapshot displacements, one per column
+    const std::size_t nbSnapshots = snapshots.size();
+    Matrix U(size, nbSnapshots);
+    for (std::size_t s=0; s<nbSnapshots; s++)
+        for (std::size_t i=0; i<nbPoints; i++)
+        {
+            const Deriv u = snapshots[s][i] - position[i];
+            for (std::size_t c=0; c<DataTypes::deriv_total_size; c++)
+                U(i*DataTypes::deriv_total_size+c, s) = u[c];
+        }
+
+    // method of snapshots: the eigenvectors of U^T U give the right singular vectors,
+    // much cheaper than a SVD of U as there are far fewer snapshots than coordinates
+    const Matrix C = U.transpose() * U;
+    Eigen::SelfAdjointEigenSolver<Matrix> eigen(C);
+    const auto& lambda = eigen.eigenvalues(); // increasing order
+
+    Real energy = 0;
+    for (Eigen::Index k=0; k<lambda.size(); k++)
+        energy += std::max(lambda(k), Real(0));
+    if (energy <= 0)
+    {
+        msg_warning() << "The snapshots do not move from the reference positions";
+        return;
+    }
+
+    const std::size_t maxModes = std::min<std::size_t>(d_nbModes.getValue(), nbSnapshots);
+    const Real tolerance = d_tolerance.getValue();
+    Real captured = 0;
+    for (std::size_t k=0; k<maxModes && captured < (1-tolerance)*energy; k++)
+    {
+        const Eigen::Index col = lambda.size()-1-Eigen::Index(k);
+        const Real sigma = std::sqrt(std::max(lambda(col), Real(0)));
+        if (sigma <= std::numeric_limits<Real>::epsilon() * std::sqrt(energy))
+            break;
+        captured += lambda(col);
+
+        const Matrix phi = U * eigen.eigenvectors().col(col) / sigma;
+        for (std::size_t i=0; i<nbPoints; i++)
+        {
+            Deriv v;
+            for (std::size_t c=0; c<DataTypes::deriv_total_size; c++)
+                v[c] = phi(i*DataTypes::deriv_total_size+c, 0);
+            basis.push_back(v);
+        }
+        singularValues.push_back(sigma);
+    }
+
+    msg_info() << singularValues.size() << " modes from " << nbSnapshots << " snapshots, capturing "
+               << captured / energy << " of the snapshot energy";
+}
+
+} //namespace sofa::component::engine
@@ -0,0 +1,101 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+#include <SofaMiscFem/config.h>
+
+#include <sofa/core/DataEngine.h>
+#include <sofa/core/objectmodel/DataFileName.h>
+#include <sofa/core/topology/BaseMeshTopology.h>
+#include <sofa/defaulttype/VecTypes.h>
+#include <SofaSimpleFem/TetrahedronFEMForceField.h>
+
+
+namespace sofa::component::engine
+{
+
+/**
+ * Hyper-reduction of a TetrahedronFEMForceField by Energy Conserving Sampling and Weighting (ECSW).
+ *
+ * Given a reduced basis and the snapshots it was built from, it selects a small
+ * set of tetrahedra and positive weights such that, for every snapshot, the
+ * weighted forces of the selected tetrahedra projected on the basis match the
+ * projected forces of the whole mesh (root mean square of the relative errors below the tolerance).
+ * The weights are the non-negative least squares solution, computed by the
+ * active set method of Lawson and Hanson, which adds one tetrahedron at a time.
+ *
+ * The projected forces are stored in a dense matrix of nbSnapshots*nbModes rows and one
+ * column per tetrahedron of the full mesh: 1000 rows on 100k tetrahedra take 800 MB in double
+ * precision. A warning is emitted before allocating more than 512 MB.
+ *
+ * The forces of each tetrahedron are evaluated by the linked force field itself,
+ * on groups of tetrahedra without common points, by cancelling the stiffness of
+ * the other tetrahedra through its localStiffnessFactor.
+ *
+ * The outputs describe the sampled mesh: the online scene maps the reduced
+ * coordinates to its points with a ReducedBasisMapping (indices), and evaluates a
+ * TetrahedronFEMForceField on its tetrahedra, with the youngModulus of the linked
+ * force field and the weights as localStiffnessFactor.
+ */
+template <class DataTypes>
+class TetrahedronECSWSampling : public core::DataEngine
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE(TetrahedronECSWSampling,DataTypes),core::DataEngine);
+    typedef typename DataTypes::Real Real;
+    typedef typename DataTypes::Coord Coord;
+    typedef typename DataTypes::Deriv Deriv;
+    typedef typename DataTypes::VecCoord VecCoord;
+    typedef typename DataTypes::VecDeriv VecDeriv;
+    typedef sofa::core::topology::BaseMeshTopology::SeqTetrahedra SeqTetrahedra;
+    typedef forcefield::TetrahedronFEMForceField<DataTypes> FEMForceField;
+
+protected:
+
+    TetrahedronECSWSampling();
+
+    ~TetrahedronECSWSampling() override {}
+public:
+    void init() override;
+
+    void reinit() override;
+
+    void doUpdate() override;
+
+    core::objectmodel::DataFileName d_filename; ///< positions recorded by WriteState
+    Data<VecDeriv> d_basis; ///< modes, stored one after the other (mode k of point i at k*nbPoints+i)
+    Data<Real> d_tolerance; ///< relative error allowed on the projected forces (root mean square over the snapshots)
+    Data<unsigned int> d_maxElements; ///< maximum number of sampled tetrahedra (0 for no limit)
+    Data<helper::vector<sofa::Index> > d_elements; ///< sampled tetrahedra, as indices in the force field
+    Data<helper::vector<Real> > d_weights; ///< stiffness factors of the sampled tetrahedra
+    Data<helper::vector<unsigned> > d_indices; ///< points of the sampled tetrahedra
+    Data<SeqTetrahedra> d_tetrahedra; ///< sampled tetrahedra, on the sampled points
+    Data<VecCoord> d_position; ///< rest positions of the sampled points
+
+    /// Link to the force field of the full mesh.
+    SingleLink<TetrahedronECSWSampling<DataTypes>, FEMForceField, BaseLink::FLAG_STOREPATH|BaseLink::FLAG_STRONGLINK> l_forceField;
+};
+
+#if  !defined(SOFA_COMPONENT_ENGINE_TETRAHEDRONECSWSAMPLING_CPP)
+extern template class SOFA_SOFAMISCFEM_API TetrahedronECSWSampling<defaulttype::Vec3Types>;
+#endif
+
+} //namespace sofa::component::engine
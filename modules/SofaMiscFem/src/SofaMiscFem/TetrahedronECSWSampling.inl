@@ -0,0 +1,294 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+#include <SofaMiscFem/TetrahedronECSWSampling.h>
+#include <SofaMiscFem/ProperOrthogonalDecomposition.h>
+#include <sofa/core/MechanicalParams.h>
+
+#include <Eigen/Dense>
+
+namespace sofa::component::engine
+{
+
+namespace ecswsampling
+{
+/// Above this size of the dense matrix of the projected forces, a warning is emitted before allocating it
+constexpr std::size_t largeMatrixBytes = std::size_t(512) << 20;
+} // namespace ecswsampling
+
+template <class DataTypes>
+TetrahedronECSWSampling<DataTypes>::TetrahedronECSWSampling()
+    : d_filename( initData(&d_filename, "filename", "positions recorded by WriteState (uncompressed), the basis was computed from") )
+    , d_basis( initData(&d_basis, "basis", "modes, stored one after the other (mode k of point i at k*nbPoints+i)") )
+    , d_tolerance( initData(&d_tolerance, Real(0.01), "tolerance", "relative error allowed on the projected forces (root mean square over the snapshots)") )
+    , d_maxElements( initData(&d_maxElements, 0u, "maxElements", "maximum number of sampled tetrahedra (0 for no limit)") )
+    , d_elements( initData(&d_elements, "elements", "sampled tetrahedra, as indices in the force field") )
+    , d_weights( initData(&d_weights, "weights", "stiffness factors of the sampled tetrahedra, relative to the first youngModulus of the force field") )
+    , d_indices( initData(&d_indices, "indices", "points of the sampled tetrahedra") )
+    , d_tetrahedra( initData(&d_tetrahedra, "tetrahedra", "sampled tetrahedra, on the sampled points") )
+    , d_position( initData(&d_position, "position", "rest positions of the sampled points") )
+    , l_forceField( initLink("forceField", "TetrahedronFEMForceField of the full mesh") )
+{
+}
+
+template <class DataTypes>
+void TetrahedronECSWSampling<DataTypes>::init()
+{
+    addInput(&d_filename);
+    addInput(&d_basis);
+    addInput(&d_tolerance);
+    addInput(&d_maxElements);
+    addOutput(&d_elements);
+    addOutput(&d_weights);
+    addOutput(&d_indices);
+    addOutput(&d_tetrahedra);
+    addOutput(&d_position);
+    setDirtyValue();
+}
+
+template <class DataTypes>
+void TetrahedronECSWSampling<DataTypes>::reinit()
+{
+    update();
+}
+
+template <class DataTypes>
+void TetrahedronECSWSampling<DataTypes>::doUpdate()
+{
+    typedef Eigen::Matrix<Real, Eigen::Dynamic, Eigen::Dynamic> Matrix;
+    typedef Eigen::Matrix<Real, Eigen::Dynamic, 1> Vector;
+    typedef typename FEMForceField::VecReal VecReal;
+
+    helper::WriteOnlyAccessor<Data<helper::vector<sofa::Index> > > sampledElements = d_elements;
+    helper::WriteOnlyAccessor<Data<helper::vector<Real> > > weights = d_weights;
+    helper::WriteOnlyAccessor<Data<helper::vector<unsigned> > > indices = d_indices;
+    helper::WriteOnlyAccessor<Data<SeqTetrahedra> > tetrahedra = d_tetrahedra;
+    helper::WriteOnlyAccessor<Data<VecCoord> > position = d_position;
+    sampledElements.clear();
+    weights.clear();
+    indices.clear();
+    tetrahedra.clear();
+    position.clear();
+
+    FEMForceField* ff = l_forceField.get();
+    if (ff == nullptr || ff->d_componentState.getValue() == core::objectmodel::ComponentState::Invalid)
+    {
+        msg_error() << "A valid TetrahedronFEMForceField is required (forceField link)";
+        return;
+    }
+
+    const SeqTetrahedra elements = ff->getIndexedElements();
+    const VecCoord x0 = ff->_initialPoints.getValue();
+    const std::size_t nbElements = elements.size();
+    const std::size_t nbPoints = x0.size();
+    const VecDeriv& basis = d_basis.getValue();
+    if (nbElements == 0 || nbPoints == 0 || basis.empty() || basis.size() % nbPoints != 0)
+    {
+        msg_error() << "The basis (" << basis.size() << " values) does not match the " << nbPoints << " points of the force field";
+        return;
+    }
+    const std::size_t nbModes = basis.size() / nbPoints;
+
+    helper::vector<VecCoord> snapshots;
+    if (!ProperOrthogonalDecomposition<DataTypes>::readSnapshots(d_filename.getFullPath(), nbPoints, snapshots))
+    {
+        msg_error() << "Can not read the snapshots of " << nbPoints << " points in '" << d_filename.getFullPath() << "'";
+        return;
+    }
+    if (snapshots.empty())
+    {
+        msg_warning() << "No snapshot in '" << d_filename.getFullPath() << "'";
+        return;
+    }
+    const std::size_t nbSnapshots = snapshots.size();
+
+    // stiffness of each tetrahedron relative to the first young modulus, to be restored and scaled by the weights
+    const VecReal factors = ff->_localStiffnessFactor.getValue();
+    const VecReal& youngModulus = ff->_youngModulus.getValue();
+    VecReal stiffness(nbElements, Real(1));
+    for (std::size_t e=0; e<nbElements; e++)
+    {
+        if (!factors.empty())
+            stiffness[e] = factors[e*factors.size()/nbElements];
+        if (youngModulus.size() == nbElements && youngModulus[0] != 0)
+            stiffness[e] *= youngModulus[e] / youngModulus[0];
+    }
+
+    // groups of tetrahedra without common points, so that the force on a point comes from one tetrahedron
+    helper::vector<unsigned> color(nbElements, std::numeric_limits<unsigned>::max());
+    unsigned nbColors = 0;
+    for (std::size_t nbColored = 0; nbColored < nbElements; nbColors++)
+    {
+        helper::vector<bool> used(nbPoints, false);
+        for (std::size_t e=0; e<nbElements; e++)
+        {
+            const auto& t = elements[e];
+            if (color[e] != std::numeric_limits<unsigned>::max() || used[t[0]] || used[t[1]] || used[t[2]] || used[t[3]])
+                continue;
+            color[e] = nbColors;
+            used[t[0]] = used[t[1]] = used[t[2]] = used[t[3]] = true;
+            nbColored++;
+        }
+    }
+
+    // G(s*nbModes+k, e): force of tetrahedron e in snapshot s, projected on mode k
+    const std::size_t matrixBytes = nbSnapshots * nbModes * nbElements * sizeof(typename Matrix::Scalar);
+    msg_warning_when(matrixBytes > ecswsampling::largeMatrixBytes)
+            << "The projected forces of the " << nbElements << " tetrahedra in the " << nbSnapshots << " snapshots on the "
+            << nbModes << " modes need a dense matrix of " << (matrixBytes >> 20) << " MB. "
+            << "Consider recording fewer snapshots or sampling a coarser mesh.";
+    Matrix G = Matrix::Zero(nbSnapshots*nbModes, nbElements);
+    Data<VecCoord> xData;
+    Data<VecDeriv> vData, fData;
+    vData.setValue(VecDeriv(nbPoints));
+    for (unsigned c=0; c<nbColors; c++)
+    {
+        VecReal mask(nbElements, Real(0));
+        for (std::size_t e=0; e<nbElements; e++)
+            if (color[e] == c)
+                mask[e] = factors.empty() ? Real(1) : factors[e*factors.size()/nbElements];
+        ff->_localStiffnessFactor.setValue(mask);
+        ff->reinit();
+
+        for (std::size_t s=0; s<nbSnapshots; s++)
+        {
+            xData.setValue(snapshots[s]);
+            fData.setValue(VecDeriv(nbPoints, Deriv()));
+            ff->addForce(core::mechanicalparams::defaultInstance(), fData, xData, vData);
+            const VecDeriv& f = fData.getValue();
+            for (std::size_t e=0; e<nbElements; e++)
+            {
+                if (color[e] != c)
+                    continue;
+                for (std::size_t k=0; k<nbModes; k++)
+                {
+                    Real v = 0;
+                    for (const auto p : elements[e])
+                        v += dot(basis[k*nbPoints+p], f[p]);
+                    G(s*nbModes+k, e) = v;
+                }
+            }
+        }
+    }
+    ff->_localStiffnessFactor.setValue(factors);
+    ff->reinit();
+
+    // the full mesh gives the weight 1 to every tetrahedron; each snapshot is normalized so that they count equally
+    Vector b = G.rowwise().sum();
+    for (std::size_t s=0; s<nbSnapshots; s++)
+    {
+        const Real norm = b.segment(s*nbModes, nbModes).norm();
+        if (norm > 0)
+        {
+            G.middleRows(s*nbModes, nbModes) /= norm;
+            b.segment(s*nbModes, nbModes) /= norm;
+        }
+    }
+    const Real bNorm = b.norm();
+    if (bNorm <= 0)
+    {
+        msg_warning() << "The snapshots do not load the reduced basis";
+        return;
+    }
+
+    // non-negative least squares, active set method of Lawson and Hanson
+    const Real target = d_tolerance.getValue() * bNorm;
+    const std::size_t maxElements = d_maxElements.getValue() ? std::min<std::size_t>(d_maxElements.getValue(), nbElements) : nbElements;
+    Vector w = Vector::Zero(nbElements);
+    helper::vector<Eigen::Index> active;
+    Vector residual = b;
+    for (std::size_t it=0; it<3*nbElements && residual.norm() > target && active.size() < maxElements; it++)
+    {
+        const Vector gradient = G.transpose() * residual;
+        Eigen::Index best = -1;
+        for (Eigen::Index e=0; e<Eigen::Index(nbElements); e++)
+            if (w(e) == 0 && std::find(active.begin(), active.end(), e) == active.end() && gradient(e) > 0 && (best < 0 || gradient(e) > gradient(best)))
+                best = e;
+        if (best < 0)
+            break;
+        active.push_back(best);
+
+        for (;;)
+        {
+            Matrix Gp(G.rows(), Eigen::Index(active.size()));
+            for (std::size_t j=0; j<active.size(); j++)
+                Gp.col(j) = G.col(active[j]);
+            const Vector z = Gp.colPivHouseholderQr().solve(b);
+
+            if (z.minCoeff() > 0)
+            {
+                for (std::size_t j=0; j<active.size(); j++)
+                    w(active[j]) = z(j);
+                break;
+            }
+
+            // move towards z until a weight vanishes, and release it
+            Real alpha = 1;
+            for (std::size_t j=0; j<active.size(); j++)
+                if (z(j) <= 0)
+                    alpha = std::min(alpha, w(active[j]) / (w(active[j]) - z(j)));
+            helper::vector<Eigen::Index> kept;
+            for (std::size_t j=0; j<active.size(); j++)
+            {
+                Real& wj = w(active[j]);
+                wj += alpha * (z(j) - wj);
+                if (wj > std::numeric_limits<Real>::epsilon())
+                    kept.push_back(active[j]);
+                else
+                    wj = 0;
+            }
+            active.swap(kept);
+            if (active.empty())
+                break;
+        }
+        residual = b - G * w;
+    }
+
+    // sampled mesh
+    helper::vector<int> pointIndex(nbPoints, -1);
+    for (std::size_t e=0; e<nbElements; e++)
+    {
+        if (w(e) <= 0)
+            continue;
+        sampledElements.push_back(sofa::Index(e));
+        weights.push_back(w(e) * stiffness[e]);
+        for (const auto p : elements[e])
+            pointIndex[p] = 0;
+    }
+    for (std::size_t p=0; p<nbPoints; p++)
+        if (pointIndex[p] == 0)
+        {
+            pointIndex[p] = int(indices.size());
+            indices.push_back(unsigned(p));
+            position.push_back(x0[p]);
+        }
+    for (const auto e : sampledElements)
+    {
+        const auto& t = elements[e];
+        tetrahedra.push_back(core::topology::BaseMeshTopology::Tetra(pointIndex[t[0]], pointIndex[t[1]], pointIndex[t[2]], pointIndex[t[3]]));
+    }
+
+    msg_info() << sampledElements.size() << " tetrahedra out of " << nbElements << " sampled with " << nbSnapshots
+               << " snapshots, root mean square relative error " << residual.norm() / bNorm;
+}
+
+} //namespace sofa::component::engine
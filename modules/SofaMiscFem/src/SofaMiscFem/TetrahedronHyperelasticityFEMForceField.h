@@ -34,6 +34,7 @@
 #include <SofaBaseTopology/TopologyData.h>
 #include <string>
 #include <map>
+#include <functional>
 
 namespace sofa::component::forcefield
 {
@@ -149,6 +150,7 @@ public :
     Data<std::string> d_materialName; ///< the name of the material
     Data<SetParameterArray> d_parameterSet; ///< The global parameters specifying the material
     Data<SetAnisotropyDirectionArray> d_anisotropySet; ///< The global directions of anisotropy of the material
+    Data<bool> d_parallelComputation; ///< Evaluate the material and assemble the edge stiffness with the threads of the TaskScheduler
 
     TetrahedronData<sofa::helper::vector<TetrahedronRestInformation> > m_tetrahedronInfo; ///< Internal tetrahedron data
     EdgeData<sofa::helper::vector<EdgeInformation> > m_edgeInfo; ///< Internal edge data
@@ -216,6 +218,40 @@ public:
     fem::HyperelasticMaterial<DataTypes> *m_myMaterial;
     TetrahedronHandler* m_tetrahedronHandler;
 
+    /// concrete type of m_myMaterial, used to call the material without virtual dispatch in the element loops
+    enum class MaterialType { Generic, BoyceAndArruda, STVenantKirchhoff, NeoHookean, MooneyRivlin, VerondaWestman, Costa, Ogden };
+    MaterialType m_materialType;
+
+    /// nodal forces of each tetrahedron (4 per tetrahedron), accumulated in the order of the tetrahedra
+    helper::vector<Deriv> m_tetrahedronForces;
+    /// stiffness of the 6 edges of each tetrahedron, summed per edge by updateTangentMatrix
+    helper::vector<MatrixList> m_tetrahedronEdgeStiffness;
+    /// bit j is set when the local edge j of the tetrahedron is oriented opposite to the global edge
+    helper::vector<unsigned char> m_tetrahedronEdgeOrientation;
+    /// tetrahedra around each edge, as 6*tetrahedronIndex+localEdge, sorted by tetrahedron (CSR layout)
+    helper::vector<Index> m_edgeTetrahedraBegin;
+    helper::vector<Index> m_edgeTetrahedra;
+    int m_edgeTetrahedraRevision;
+
+    /// call kernel with m_myMaterial cast to its concrete type
+    template<class Kernel>
+    void dispatchMaterial(const Kernel& kernel);
+
+    /// compute the deformation, the stress and the nodal forces of the tetrahedra [begin,end)
+    template<class Material>
+    void computeTetrahedraForces(Material* material, helper::vector<TetrahedronRestInformation>& tetrahedronInf,
+                                 const VecElement& tetrahedronArray, const VecCoord& x, std::size_t begin, std::size_t end);
+
+    /// compute the stiffness of the edges of the tetrahedra [begin,end)
+    template<class Material>
+    void computeTetrahedraEdgeStiffness(Material* material, helper::vector<TetrahedronRestInformation>& tetrahedronInf,
+                                        std::size_t begin, std::size_t end);
+
+    /// apply f on contiguous ranges of [0,n), with the threads of the TaskScheduler if d_parallelComputation is set
+    void forEachRange(std::size_t n, const std::function<void(std::size_t,std::size_t)>& f);
+
+    void updateEdgeTetrahedra();
+
     void testDerivatives();
     void saveMesh( const char *filename );
 
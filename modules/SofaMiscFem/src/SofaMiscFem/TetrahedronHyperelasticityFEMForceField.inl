@@ -40,8 +40,10 @@
 #include <iostream> //for debugging
 #include <sofa/core/behavior/ForceField.inl>
 #include <SofaBaseTopology/TopologyData.inl>
+#include <sofa/simulation/ParallelForRange.h>
 #include <algorithm>
 #include <iterator>
+#include <type_traits>
 namespace sofa
 {
 namespace component
@@ -52,6 +54,14 @@ using namespace sofa::defaulttype;
 using namespace	sofa::component::topology;
 using namespace core::topology;
 
+namespace hyperelasticity
+{
+
+/// Minimum number of tetrahedra (or edges) handled by each task of the parallel computations
+constexpr std::size_t minElementsPerTask = 256;
+
+} // namespace hyperelasticity
+
 
 template< class DataTypes >
 void TetrahedronHyperelasticityFEMForceField<DataTypes>::TetrahedronHandler::applyCreateFunction(Index tetrahedronIndex,
@@ -116,10 +126,14 @@ template <class DataTypes> TetrahedronHyperelasticityFEMForceField<DataTypes>::T
     , d_materialName(initData(&d_materialName,std::string("ArrudaBoyce"),"materialName","the name of the material to be used"))
     , d_parameterSet(initData(&d_parameterSet,"ParameterSet","The global parameters specifying the material"))
     , d_anisotropySet(initData(&d_anisotropySet,"AnisotropyDirections","The global directions of anisotropy of the material"))
+    , d_parallelComputation(initData(&d_parallelComputation, false, "parallelComputation", "Evaluate the material and assemble the edge stiffness with the threads of the TaskScheduler"))
     , m_tetrahedronInfo(initData(&m_tetrahedronInfo, "tetrahedronInfo", "Internal tetrahedron data"))
     , m_edgeInfo(initData(&m_edgeInfo, "edgeInfo", "Internal edge data"))
     , l_topology(initLink("topology", "link to the topology container"))
+    , m_myMaterial(nullptr)
     , m_tetrahedronHandler(nullptr)
+    , m_materialType(MaterialType::Generic)
+    , m_edgeTetrahedraRevision(-1)
 {
     m_tetrahedronHandler = new TetrahedronHandler(this,&m_tetrahedronInfo);
 }
@@ -171,42 +185,49 @@ template <class DataTypes> void TetrahedronHyperelasticityFEMForceField<DataType
     {
         fem::BoyceAndArruda<DataTypes> *BoyceAndArrudaMaterial = new fem::BoyceAndArruda<DataTypes>;
         m_myMaterial = BoyceAndArrudaMaterial;
+        m_materialType = MaterialType::BoyceAndArruda;
         msg_info() << "The model is " << material;
     }
     else if (material=="StVenantKirchhoff")
     {
         fem::STVenantKirchhoff<DataTypes> *STVenantKirchhoffMaterial = new fem::STVenantKirchhoff<DataTypes>;
         m_myMaterial = STVenantKirchhoffMaterial;
+        m_materialType = MaterialType::STVenantKirchhoff;
         msg_info() << "The model is " << material;
     }
     else if (material=="NeoHookean")
     {
         fem::NeoHookean<DataTypes> *NeoHookeanMaterial = new fem::NeoHookean<DataTypes>;
         m_myMaterial = NeoHookeanMaterial;
+        m_materialType = MaterialType::NeoHookean;
         msg_info() << "The model is " << material;
     }
     else if (material=="MooneyRivlin")
     {
         fem::MooneyRivlin<DataTypes> *MooneyRivlinMaterial = new fem::MooneyRivlin<DataTypes>;
         m_myMaterial = MooneyRivlinMaterial;
+        m_materialType = MaterialType::MooneyRivlin;
         msg_info() << "The model is " << material;
     }
     else if (material=="VerondaWestman")
     {
         fem::VerondaWestman<DataTypes> *VerondaWestmanMaterial = new fem::VerondaWestman<DataTypes>;
         m_myMaterial = VerondaWestmanMaterial;
+        m_materialType = MaterialType::VerondaWestman;
         msg_info() << "The model is " << material;
     }
     else if (material=="Costa")
     {
         fem::Costa<DataTypes> *CostaMaterial = new fem::Costa<DataTypes>;
         m_myMaterial = CostaMaterial;
+        m_materialType = MaterialType::Costa;
         msg_info() << "The model is " << material;
     }
     else if (material=="Ogden")
     {
         fem::Ogden<DataTypes> *OgdenMaterial = new fem::Ogden<DataTypes>;
         m_myMaterial = OgdenMaterial;
+        m_materialType = MaterialType::Ogden;
         msg_info() << "The model is " << material;
     }
     else
@@ -255,41 +276,66 @@ template <class DataTypes> void TetrahedronHyperelasticityFEMForceField<DataType
     m_tetrahedronInfo.registerTopologicalData();
 
     m_tetrahedronInfo.endEdit();
+
+    if (d_parallelComputation.getValue())
+        simulation::initTaskScheduler();
     //testDerivatives();
 
 }
 
-template <class DataTypes> 
-void TetrahedronHyperelasticityFEMForceField<DataTypes>::addForce(const core::MechanicalParams* /* mparams */ /* PARAMS FIRST */, DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& /* d_v */)
+template <class DataTypes>
+template <class Kernel>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::dispatchMaterial(const Kernel& kernel)
 {
-    VecDeriv& f = *d_f.beginEdit();
-    const VecCoord& x = d_x.getValue();
-
-
-    const bool printLog = this->f_printLog.getValue();
-    if (printLog && !m_meshSaved)
+    switch (m_materialType)
     {
-        saveMesh( "D:/Steph/sofa-result.stl" );
-        printf( "Mesh saved.\n" );
-        m_meshSaved = true;
+    case MaterialType::BoyceAndArruda:
+        kernel(static_cast<fem::BoyceAndArruda<DataTypes>*>(m_myMaterial));
+        break;
+    case MaterialType::STVenantKirchhoff:
+        kernel(static_cast<fem::STVenantKirchhoff<DataTypes>*>(m_myMaterial));
+        break;
+    case MaterialType::NeoHookean:
+        kernel(static_cast<fem::NeoHookean<DataTypes>*>(m_myMaterial));
+        break;
+    case MaterialType::MooneyRivlin:
+        kernel(static_cast<fem::MooneyRivlin<DataTypes>*>(m_myMaterial));
+        break;
+    case MaterialType::VerondaWestman:
+        kernel(static_cast<fem::VerondaWestman<DataTypes>*>(m_myMaterial));
+        break;
+    case MaterialType::Costa:
+        kernel(static_cast<fem::Costa<DataTypes>*>(m_myMaterial));
+        break;
+    case MaterialType::Ogden:
+        kernel(static_cast<fem::Ogden<DataTypes>*>(m_myMaterial));
+        break;
+    default:
+        kernel(m_myMaterial);
+        break;
     }
-    unsigned int i=0,j=0,k=0,l=0;
-    unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
-
-    helper::vector<TetrahedronRestInformation>& tetrahedronInf = *(m_tetrahedronInfo.beginEdit());
+}
 
+template <class DataTypes>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::forEachRange(std::size_t n, const std::function<void(std::size_t,std::size_t)>& f)
+{
+    simulation::TaskScheduler* taskScheduler = d_parallelComputation.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    simulation::parallelForRange(taskScheduler, 0, n, hyperelasticity::minElementsPerTask, f);
+}
 
+template <class DataTypes>
+template <class Material>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::computeTetrahedraForces(Material* material, helper::vector<TetrahedronRestInformation>& tetrahedronInf,
+                                                                                 const VecElement& tetrahedronArray, const VecCoord& x, std::size_t begin, std::size_t end)
+{
+    unsigned int j=0,k=0,l=0;
     TetrahedronRestInformation *tetInfo;
-
-    assert(this->mstate);
-
     Coord dp[3],x0,sv;
 
-
-    for(i=0; i<nbTetrahedra; i++ )
+    for(std::size_t i=begin; i<end; i++ )
     {
         tetInfo=&tetrahedronInf[i];
-        const Tetrahedron &ta= m_topology->getTetrahedron(i);
+        const Tetrahedron &ta= tetrahedronArray[i];
 
         x0=x[ta[0]];
 
@@ -334,10 +380,56 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::addForce(const core::Me
         tetInfo->J = dot( areaVec, dp[0] ) * tetInfo->m_volScale;
         tetInfo->trC = (Real)( tetInfo->deformationTensor(0,0) + tetInfo->deformationTensor(1,1) + tetInfo->deformationTensor(2,2));
         tetInfo->m_SPKTensorGeneral.clear();
-        m_myMaterial->deriveSPKTensor(tetInfo,globalParameters,tetInfo->m_SPKTensorGeneral);
+        // the qualified call on the concrete material avoids the virtual dispatch and lets the compiler inline it
+        if constexpr (std::is_same<Material, fem::HyperelasticMaterial<DataTypes> >::value)
+            material->deriveSPKTensor(tetInfo,globalParameters,tetInfo->m_SPKTensorGeneral);
+        else
+            material->Material::deriveSPKTensor(tetInfo,globalParameters,tetInfo->m_SPKTensorGeneral);
         for(l=0;l<4;++l)
         {
-            f[ta[l]]-=tetInfo->m_deformationGradient*(tetInfo->m_SPKTensorGeneral*tetInfo->m_shapeVector[l])*tetInfo->m_restVolume;
+            m_tetrahedronForces[4*i+l]=tetInfo->m_deformationGradient*(tetInfo->m_SPKTensorGeneral*tetInfo->m_shapeVector[l])*tetInfo->m_restVolume;
+        }
+    }
+}
+
+template <class DataTypes> 
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::addForce(const core::MechanicalParams* /* mparams */ /* PARAMS FIRST */, DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& /* d_v */)
+{
+    VecDeriv& f = *d_f.beginEdit();
+    const VecCoord& x = d_x.getValue();
+
+
+    const bool printLog = this->f_printLog.getValue();
+    if (printLog && !m_meshSaved)
+    {
+        saveMesh( "D:/Steph/sofa-result.stl" );
+        printf( "Mesh saved.\n" );
+        m_meshSaved = true;
+    }
+    unsigned int i=0,l=0;
+    unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
+    const VecElement& tetrahedronArray=m_topology->getTetrahedra();
+
+    helper::vector<TetrahedronRestInformation>& tetrahedronInf = *(m_tetrahedronInfo.beginEdit());
+
+    assert(this->mstate);
+
+    m_tetrahedronForces.resize(4*nbTetrahedra);
+    dispatchMaterial([&](auto* material)
+    {
+        forEachRange(nbTetrahedra, [&](std::size_t begin, std::size_t end)
+        {
+            computeTetrahedraForces(material, tetrahedronInf, tetrahedronArray, x, begin, end);
+        });
+    });
+
+    // accumulated in the order of the tetrahedra, whatever the number of threads
+    for(i=0; i<nbTetrahedra; i++ )
+    {
+        const Tetrahedron &ta= tetrahedronArray[i];
+        for(l=0;l<4;++l)
+        {
+            f[ta[l]]-=m_tetrahedronForces[4*i+l];
         }
     }
 
@@ -350,42 +442,75 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::addForce(const core::Me
 }
 
 template <class DataTypes>
-void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateEdgeTetrahedra()
 {
-    unsigned int i=0,j=0,k=0,l=0;
-    unsigned int nbEdges=m_topology->getNbEdges();
+    const unsigned int nbEdges=m_topology->getNbEdges();
+    const unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
+    if (m_edgeTetrahedraRevision == m_topology->getRevision()
+        && m_edgeTetrahedraBegin.size() == nbEdges+1
+        && m_edgeTetrahedra.size() == 6*nbTetrahedra)
+        return;
+
     const helper::vector< Edge> &edgeArray=m_topology->getEdges() ;
+    const VecElement& tetrahedronArray=m_topology->getTetrahedra();
 
-    helper::vector<EdgeInformation>& edgeInf = *(m_edgeInfo.beginEdit());
-    helper::vector<TetrahedronRestInformation>& tetrahedronInf = *(m_tetrahedronInfo.beginEdit());
+    m_tetrahedronEdgeOrientation.resize(nbTetrahedra);
+    m_edgeTetrahedraBegin.resize(nbEdges+1);
+    std::fill(m_edgeTetrahedraBegin.begin(), m_edgeTetrahedraBegin.end(), 0);
+    for (unsigned int i=0; i<nbTetrahedra; i++)
+    {
+        const Tetrahedron &ta= tetrahedronArray[i];
+        BaseMeshTopology::EdgesInTetrahedron te=m_topology->getEdgesInTetrahedron(i);
+        unsigned char orientation = 0;
+        for (unsigned int j=0; j<6; j++)
+        {
+            Edge e=m_topology->getLocalEdgesInTetrahedron(j);
+            if (edgeArray[te[j]][0]!=ta[e[0]])
+                orientation |= (unsigned char)(1 << j);
+            ++m_edgeTetrahedraBegin[te[j]+1];
+        }
+        m_tetrahedronEdgeOrientation[i] = orientation;
+    }
+    for (unsigned int e=0; e<nbEdges; e++)
+        m_edgeTetrahedraBegin[e+1] += m_edgeTetrahedraBegin[e];
 
-    EdgeInformation *einfo;
+    // filled in the order of the tetrahedra, so that each edge sums its contributions in that order
+    std::vector<Index> next(m_edgeTetrahedraBegin.begin(), m_edgeTetrahedraBegin.end()-1);
+    m_edgeTetrahedra.resize(6*nbTetrahedra);
+    for (unsigned int i=0; i<nbTetrahedra; i++)
+    {
+        BaseMeshTopology::EdgesInTetrahedron te=m_topology->getEdgesInTetrahedron(i);
+        for (unsigned int j=0; j<6; j++)
+            m_edgeTetrahedra[next[te[j]]++] = 6*i+j;
+    }
+    m_edgeTetrahedraRevision = m_topology->getRevision();
+}
+
+template <class DataTypes>
+template <class Material>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::computeTetrahedraEdgeStiffness(Material* material, helper::vector<TetrahedronRestInformation>& tetrahedronInf,
+                                                                                        std::size_t begin, std::size_t end)
+{
+    unsigned int j=0,k=0,l=0;
     TetrahedronRestInformation *tetInfo;
-    unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
-    const std::vector< Tetrahedron> &tetrahedronArray=m_topology->getTetrahedra() ;
 
-    for(l=0; l<nbEdges; l++ )edgeInf[l].DfDx.clear();
-    for(i=0; i<nbTetrahedra; i++ )
+    Edge localEdges[6];
+    for(j=0;j<6;j++)
+        localEdges[j]=m_topology->getLocalEdgesInTetrahedron(j);
+
+    for(std::size_t i=begin; i<end; i++ )
     {
         tetInfo=&tetrahedronInf[i];
         Matrix3 &df=tetInfo->m_deformationGradient;
-//			Matrix3 Tdf=df.transposed();
-        BaseMeshTopology::EdgesInTetrahedron te=m_topology->getEdgesInTetrahedron(i);
+        const unsigned char orientation=m_tetrahedronEdgeOrientation[i];
 
-        /// describe the jth vertex index of triangle no i
-        const Tetrahedron &ta= tetrahedronArray[i];
         for(j=0;j<6;j++) {
-            einfo= &edgeInf[te[j]];
-            Edge e=m_topology->getLocalEdgesInTetrahedron(j);
-
-            k=e[0];
-            l=e[1];
-            if (edgeArray[te[j]][0]!=ta[k]) {
-                k=e[1];
-                l=e[0];
+            k=localEdges[j][0];
+            l=localEdges[j][1];
+            if (orientation & (1 << j)) {
+                k=localEdges[j][1];
+                l=localEdges[j][0];
             }
-            Matrix3 &edgeDfDx = einfo->DfDx;
-
 
             Coord svl=tetInfo->m_shapeVector[l];
             Coord svk=tetInfo->m_shapeVector[k];
@@ -393,9 +518,7 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
             Matrix3  M, N;
             MatrixSym outputTensor;
             N.clear();
-            helper::vector<MatrixSym> inputTensor;
-            inputTensor.resize(3);
-            //	MatrixSym input1,input2,input3,outputTensor;
+            MatrixSym inputTensor[3];
             for(int m=0; m<3;m++){
                 for (int n=m;n<3;n++){
                     inputTensor[0](m,n)=svl[m]*df[0][n]+df[0][m]*svl[n];
@@ -406,10 +529,12 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
 
             for(int m=0; m<3; m++){
 
-                m_myMaterial->applyElasticityTensor(tetInfo,globalParameters,inputTensor[m],outputTensor);
+                if constexpr (std::is_same<Material, fem::HyperelasticMaterial<DataTypes> >::value)
+                    material->applyElasticityTensor(tetInfo,globalParameters,inputTensor[m],outputTensor);
+                else
+                    material->Material::applyElasticityTensor(tetInfo,globalParameters,inputTensor[m],outputTensor);
                 Coord vectortemp=df*(outputTensor*svk);
                 Matrix3 Nv;
-                //Nv.clear();
                 for(int u=0; u<3;u++){
                     Nv[u][m]=vectortemp[u];
                 }
@@ -425,14 +550,49 @@ void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
             M[0][1]=M[0][2]=M[1][0]=M[1][2]=M[2][0]=M[2][1]=0;
             M[0][0]=M[1][1]=M[2][2]=(Real)productSD;
 
-            edgeDfDx += (M+N)*tetInfo->m_restVolume;
-
+            m_tetrahedronEdgeStiffness[i].data[j] = (M+N)*tetInfo->m_restVolume;
 
         }// end of for j
     }//end of for i
-    m_updateMatrix=false;
 }
 
+template <class DataTypes>
+void TetrahedronHyperelasticityFEMForceField<DataTypes>::updateTangentMatrix()
+{
+    unsigned int nbEdges=m_topology->getNbEdges();
+    unsigned int nbTetrahedra=m_topology->getNbTetrahedra();
+
+    helper::vector<EdgeInformation>& edgeInf = *(m_edgeInfo.beginEdit());
+    helper::vector<TetrahedronRestInformation>& tetrahedronInf = *(m_tetrahedronInfo.beginEdit());
+
+    updateEdgeTetrahedra();
+
+    m_tetrahedronEdgeStiffness.resize(nbTetrahedra);
+    dispatchMaterial([&](auto* material)
+    {
+        forEachRange(nbTetrahedra, [&](std::size_t begin, std::size_t end)
+        {
+            computeTetrahedraEdgeStiffness(material, tetrahedronInf, begin, end);
+        });
+    });
+
+    // each edge gathers the stiffness of its tetrahedra in their order, whatever the number of threads
+    forEachRange(nbEdges, [&](std::size_t begin, std::size_t end)
+    {
+        for(std::size_t e=begin; e<end; e++ )
+        {
+            Matrix3 edgeDfDx;
+            edgeDfDx.clear();
+            for (Index k=m_edgeTetrahedraBegin[e]; k<m_edgeTetrahedraBegin[e+1]; k++)
+            {
+                const Index tj = m_edgeTetrahedra[k];
+                edgeDfDx += m_tetrahedronEdgeStiffness[tj/6].data[tj%6];
+            }
+            edgeInf[e].DfDx = edgeDfDx;
+        }
+    });
+    m_updateMatrix=false;
+}
 
 template <class DataTypes> 
 void TetrahedronHyperelasticityFEMForceField<DataTypes>::addDForce(const core::MechanicalParams* mparams /* PARAMS FIRST */, DataVecDeriv& d_df, const DataVecDeriv& d_dx)
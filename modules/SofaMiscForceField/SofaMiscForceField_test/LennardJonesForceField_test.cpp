@@ -0,0 +1,160 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaMiscForceField/LennardJonesForceField.h>
+
+#include <sofa/testing/BaseSimulationTest.h>
+using sofa::testing::BaseSimulationTest;
+
+#include <SofaBaseMechanics/MechanicalObject.h>
+#include <sofa/simulation/Node.h>
+#include <sofa/simulation/Simulation.h>
+#include <SofaSimulationGraph/DAGSimulation.h>
+#include <sofa/helper/RandomGenerator.h>
+
+#include <limits>
+
+using namespace sofa::defaulttype;
+using sofa::core::objectmodel::New;
+using sofa::component::forcefield::LennardJonesForceField;
+using sofa::component::container::MechanicalObject;
+
+namespace sofa {
+
+/// Compare the forces computed with the neighbor list to the ones of the full double loop
+class LennardJonesForceField_test : public BaseSimulationTest
+{
+public:
+    typedef Vec3Types DataTypes;
+    typedef DataTypes::VecCoord VecCoord;
+    typedef DataTypes::VecDeriv VecDeriv;
+    typedef LennardJonesForceField<DataTypes> ForceField;
+
+    simulation::Node::SPtr root;
+    MechanicalObject<DataTypes>::SPtr mstate;
+    ForceField::SPtr forceField;
+
+    void SetUp() override
+    {
+        simulation::setSimulation(new simulation::graph::DAGSimulation());
+        root = simulation::getSimulation()->createNewGraph("root");
+        mstate = New<MechanicalObject<DataTypes> >();
+        root->addObject(mstate);
+    }
+
+    /// Particles in a cube, with an average spacing close to d0
+    void createParticles(std::size_t n, SReal size)
+    {
+        sofa::helper::RandomGenerator random(42);
+        VecCoord x(n);
+        for (auto& p : x)
+            p = Vec3(random.random<SReal>(0, size), random.random<SReal>(0, size), random.random<SReal>(0, size));
+        mstate->resize(n);
+        mstate->x.setValue(x);
+    }
+
+    void createForceField(bool useNeighborList, bool parallel, SReal dmax = 2)
+    {
+        if (forceField)
+            root->removeObject(forceField);
+        forceField = New<ForceField>();
+        forceField->findData("useNeighborList")->read(useNeighborList ? "1" : "0");
+        dynamic_cast< core::objectmodel::Data<SReal>* >(forceField->findData("dmax"))->setValue(dmax);
+        forceField->findData("parallelForces")->read(parallel ? "1" : "0");
+        forceField->findData("damping")->read("0.1");
+        root->addObject(forceField);
+        forceField->init();
+    }
+
+    VecDeriv computeForce(const VecCoord& x)
+    {
+        core::objectmodel::Data<VecCoord> dx;
+        dx.setValue(x);
+        core::objectmodel::Data<VecDeriv> dv;
+        dv.setValue(VecDeriv(x.size(), Vec3(0.1, 0, 0)));
+        core::objectmodel::Data<VecDeriv> df;
+        df.setValue(VecDeriv(x.size()));
+        forceField->addForce(core::mechanicalparams::defaultInstance(), df, dx, dv);
+        return df.getValue();
+    }
+
+    void compareToFullLoop(bool parallel)
+    {
+        createParticles(3000, 14);
+        VecCoord x = mstate->x.getValue();
+
+        // successive positions: small moves keep the neighbor list, the last one rebuilds it
+        std::vector<VecCoord> positions;
+        sofa::helper::RandomGenerator random(7);
+        for (SReal amplitude : {0.0, 0.02, 0.03, 0.5})
+        {
+            for (auto& p : x)
+                p += Vec3(random.random<SReal>(-amplitude, amplitude), random.random<SReal>(-amplitude, amplitude), random.random<SReal>(-amplitude, amplitude));
+            positions.push_back(x);
+        }
+
+        createForceField(false, false);
+        std::vector<VecDeriv> reference;
+        for (const auto& p : positions)
+            reference.push_back(computeForce(p));
+
+        createForceField(true, parallel);
+        for (std::size_t s = 0; s < positions.size(); ++s)
+        {
+            const VecDeriv f = computeForce(positions[s]);
+            ASSERT_EQ(f.size(), reference[s].size());
+
+            // same pairs accumulated in the same order: the forces are identical
+            for (std::size_t i = 0; i < f.size(); ++i)
+                for (std::size_t c = 0; c < 3; ++c)
+                {
+                    ASSERT_EQ(f[i][c], reference[s][i][c]) << "step " << s << ", particle " << i;
+                }
+        }
+    }
+};
+
+TEST_F(LennardJonesForceField_test, neighborListMatchesFullLoop)
+{
+    compareToFullLoop(false);
+}
+
+TEST_F(LennardJonesForceField_test, parallelNeighborListMatchesFullLoop)
+{
+    compareToFullLoop(true);
+}
+
+TEST_F(LennardJonesForceField_test, invalidNeighborListRadius)
+{
+    createParticles(100, 5);
+    for (const SReal dmax : {SReal(-1), std::numeric_limits<SReal>::quiet_NaN()})
+    {
+        {
+            EXPECT_MSG_EMIT(Warning);
+            createForceField(true, false, dmax);
+        }
+        EXPECT_FALSE(forceField->findData("useNeighborList")->getValueString() == "1")
+            << "the neighbor list is disabled for dmax=" << dmax;
+        computeForce(mstate->x.getValue());
+    }
+}
+
+} // namespace sofa
@@ -1283,6 +1283,72 @@ TEST_F(MeshMatrixMass3_test, singleHexahedron)
             expectedMass);
 }
 
+TEST_F(MeshMatrixMass3_test, consistentMassProducts_Tetra)
+{
+    typedef Vec3Types::Deriv Deriv;
+    typedef Vec3Types::VecDeriv VecDeriv;
+
+    VecCoord positions;
+    positions.push_back(Coord(0.0f, 0.0f, 0.0f));
+    positions.push_back(Coord(1.0f, 0.0f, 0.0f));
+    positions.push_back(Coord(0.0f, 1.0f, 0.0f));
+    positions.push_back(Coord(0.0f, 0.0f, 1.0f));
+    positions.push_back(Coord(1.0f, 1.0f, 1.0f));
+
+    TetrahedronSetTopologyContainer::SPtr topologyContainer = New<TetrahedronSetTopologyContainer>();
+    topologyContainer->addTetra(0, 1, 2, 3);
+    topologyContainer->addTetra(1, 2, 3, 4);
+
+    TetrahedronSetGeometryAlgorithms<Vec3Types>::SPtr geometryAlgorithms
+        = New<TetrahedronSetGeometryAlgorithms<Vec3Types> >();
+
+    createSceneGraph(positions, topologyContainer, geometryAlgorithms);
+    simulation::getSimulation()->init(root.get());
+
+    const VecMass& vertexMass = mass->d_vertexMassInfo.getValue();
+    const VecMass& edgeMass = mass->d_edgeMassInfo.getValue();
+
+    VecDeriv dx(5);
+    for (size_t i = 0 ; i < dx.size() ; i++)
+        dx[i] = Deriv(1.0 + i, 0.5 - i, 0.25 * i);
+
+    // reference product, vertex by vertex then edge by edge
+    VecDeriv expected(5);
+    for (size_t i = 0 ; i < dx.size() ; i++)
+        expected[i] += dx[i] * vertexMass[i] * MassType(2.0);
+    for (size_t j = 0 ; j < topologyContainer->getNbEdges() ; j++)
+    {
+        const auto& e = topologyContainer->getEdge(j);
+        expected[e[0]] += dx[e[1]] * (edgeMass[j] * MassType(2.0));
+        expected[e[1]] += dx[e[0]] * (edgeMass[j] * MassType(2.0));
+    }
+
+    core::objectmodel::Data<VecDeriv> res(VecDeriv(5)), vdx(dx);
+    mass->addMDx(core::mechanicalparams::defaultInstance(), res, vdx, 2.0);
+    for (size_t i = 0 ; i < dx.size() ; i++)
+        for (size_t c = 0 ; c < 3 ; c++)
+            EXPECT_DOUBLE_EQ(expected[i][c], res.getValue()[i][c]);
+
+    // accFromF solves M a = f with the consistent mass
+    core::objectmodel::Data<VecDeriv> acc, f(dx), ma(VecDeriv(5));
+    {
+        EXPECT_MSG_NOEMIT(Warning);
+        mass->accFromF(core::mechanicalparams::defaultInstance(), acc, f);
+    }
+    ASSERT_EQ(dx.size(), acc.getValue().size());
+    mass->addMDx(core::mechanicalparams::defaultInstance(), ma, acc, 1.0);
+    for (size_t i = 0 ; i < dx.size() ; i++)
+        for (size_t c = 0 ; c < 3 ; c++)
+            EXPECT_NEAR(dx[i][c], ma.getValue()[i][c], 1e-8);
+
+    // the solve stopped by accFromFIterations before converging is reported
+    mass->d_accFromFIterations.setValue(1);
+    {
+        EXPECT_MSG_EMIT(Warning);
+        mass->accFromF(core::mechanicalparams::defaultInstance(), acc, f);
+    }
+}
+
 TEST_F(MeshMatrixMass3_test, check_DefaultAttributes_Hexa){
     check_DefaultAttributes_Hexa() ;
 }
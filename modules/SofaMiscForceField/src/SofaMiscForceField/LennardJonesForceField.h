@@ -26,6 +26,7 @@
 #include <sofa/core/behavior/ForceField.h>
 #include <sofa/core/behavior/MechanicalState.h>
 #include <vector>
+#include <utility>
 
 
 namespace sofa::component::forcefield
@@ -57,6 +58,9 @@ protected:
     Data<Real> d0; ///< d0
     Data<Real> p0; ///< p0
     Data<Real> damping; ///< Damping
+    Data<bool> d_useNeighborList; ///< Only consider the pairs found by a uniform grid, instead of all the pairs of particles
+    Data<Real> d_skin; ///< Distance added to dmax when building the neighbor list, which is rebuilt once a particle moved more than half of it
+    Data<bool> d_parallelForces; ///< Compute the pair forces with the threads of the TaskScheduler
 
     struct DForce
     {
@@ -66,6 +70,42 @@ protected:
 
     sofa::helper::vector<DForce> dforces;
 
+    /// Parameters of the interaction, read once per call to addForce
+    struct PairParameters
+    {
+        Real a, b, alpha, beta, fmax;
+        bool gravitational; ///< aInit is set: the attraction decreases as 1/d^2
+
+        /// Distance, force intensity and stiffness factor between two particles at squared distance d2
+        void compute(Real d2, Real& d, Real& forceIntensity, Real& df) const;
+    };
+
+    PairParameters getPairParameters() const;
+
+    /// Candidate pairs (a<b) closer than dmax+skin when the neighbor list was built, sorted by (b,a) as in the full double loop
+    sofa::helper::vector< std::pair<unsigned int, unsigned int> > m_neighborPairs;
+    /// Positions and radius used to build the neighbor list
+    VecCoord m_neighborListPositions;
+    Real m_neighborListRadius { 0 };
+    /// Uniform grid of the particles, stored as a list of particles sorted by cell
+    sofa::helper::vector<unsigned int> m_particleCells;
+    sofa::helper::vector<unsigned int> m_cellStart;
+    sofa::helper::vector<unsigned int> m_cellParticles;
+
+    struct PairForce
+    {
+        Deriv force;
+        Real df;
+        bool active;
+    };
+    sofa::helper::vector<PairForce> m_pairForces;
+
+    /// Cell size of the neighbor list, dmax+skin, which must be positive
+    Real getNeighborListRadius() const;
+
+    /// Rebuild the neighbor list if a particle moved by more than half of the skin since the last build
+    void updateNeighborList(const VecCoord& x);
+
     LennardJonesForceField();
 public:
 
@@ -23,12 +23,23 @@
 
 #include <SofaMiscForceField/LennardJonesForceField.h>
 #include <sofa/core/visual/VisualParams.h>
+#include <sofa/simulation/ParallelForRange.h>
+#include <algorithm>
 #include <cmath>
+#include <functional>
 #include <iostream>
 
 namespace sofa::component::forcefield
 {
 
+namespace lennardjones
+{
+
+/// Minimum number of candidate pairs handled by each task of the parallel force computation
+constexpr std::size_t minPairsPerTask = 4096;
+
+} // namespace lennardjones
+
 template<class DataTypes>
 LennardJonesForceField<DataTypes>::LennardJonesForceField()
     : a(1)
@@ -41,6 +52,9 @@ LennardJonesForceField<DataTypes>::LennardJonesForceField()
     , d0     (initData(&d0     ,Real(1), "d0"     ,"d0"))
     , p0     (initData(&p0     ,Real(1), "p0"     ,"p0"))
     , damping(initData(&damping,Real(0), "damping","Damping"))
+    , d_useNeighborList(initData(&d_useNeighborList, true, "useNeighborList", "Only consider the pairs found by a uniform grid of cells larger than dmax+skin, instead of all the pairs of particles"))
+    , d_skin(initData(&d_skin, Real(0.2), "skin", "Distance added to dmax when building the neighbor list. The list is rebuilt once a particle moved by more than half of it"))
+    , d_parallelForces(initData(&d_parallelForces, false, "parallelForces", "Compute the pair forces with the threads of the TaskScheduler"))
 {
 }
 
@@ -51,6 +65,16 @@ void LennardJonesForceField<DataTypes>::init()
 
     assert( this->mstate );
 
+    m_neighborListPositions.clear();
+    if (d_useNeighborList.getValue() && !(getNeighborListRadius() > 0))
+    {
+        msg_warning() << "useNeighborList requires dmax+skin to be positive (" << getNeighborListRadius()
+                      << "), all the pairs of particles are considered instead.";
+        d_useNeighborList.setValue(false);
+    }
+    if (d_parallelForces.getValue())
+        simulation::initTaskScheduler();
+
     if(aInit.getValue()!=0)
         a = aInit.getValue();
     else
@@ -80,6 +104,164 @@ void LennardJonesForceField<DataTypes>::init()
     }
 }
 
+template<class DataTypes>
+typename LennardJonesForceField<DataTypes>::PairParameters LennardJonesForceField<DataTypes>::getPairParameters() const
+{
+    PairParameters params;
+    params.a = a;
+    params.b = b;
+    params.alpha = alpha.getValue();
+    params.beta = beta.getValue();
+    params.fmax = fmax.getValue();
+    params.gravitational = (aInit.getValue() != 0);
+    return params;
+}
+
+template<class DataTypes>
+void LennardJonesForceField<DataTypes>::PairParameters::compute(Real d2, Real& d, Real& forceIntensity, Real& df) const
+{
+    d = (Real)sqrt(d2);
+
+    Real fa ;
+    if(gravitational)
+        fa = a*alpha*(1.f/d2);
+    else
+        fa = a*alpha*(Real)pow(d,-alpha-1);
+
+    const Real fb = b*beta*(Real)pow(d,-beta-1);
+
+    if(beta > 0)
+        forceIntensity = fa - fb;
+    else
+        forceIntensity = fa;
+
+    if (forceIntensity > fmax)
+    {
+        forceIntensity = fmax;
+        df = 0;
+    }
+    else
+    {
+        if(beta > 0)
+            df = ((-alpha-1)*fa - (-beta-1)*fb)/(d*d2);
+        else
+            df = ((-alpha-1)*fa)/(d*d2);
+    }
+}
+
+template<class DataTypes>
+typename LennardJonesForceField<DataTypes>::Real LennardJonesForceField<DataTypes>::getNeighborListRadius() const
+{
+    return dmax.getValue() + std::max(d_skin.getValue(), Real(0));
+}
+
+template<class DataTypes>
+void LennardJonesForceField<DataTypes>::updateNeighborList(const VecCoord& x)
+{
+    const std::size_t n = x.size();
+    const Real skin = std::max(d_skin.getValue(), Real(0));
+    const Real radius = getNeighborListRadius();
+
+    bool rebuild = (n != m_neighborListPositions.size() || radius != m_neighborListRadius);
+    const Real maxDisplacement2 = skin*skin/4;
+    for (std::size_t i=0; i<n && !rebuild; i++)
+        rebuild = (x[i]-m_neighborListPositions[i]).norm2() > maxDisplacement2;
+    if (!rebuild)
+        return;
+
+    m_neighborListPositions = x;
+    m_neighborListRadius = radius;
+    m_neighborPairs.clear();
+    if (n < 2)
+        return;
+
+    // bounding box of the particles
+    Real minP[3], maxP[3];
+    DataTypes::get(minP[0], minP[1], minP[2], x[0]);
+    DataTypes::get(maxP[0], maxP[1], maxP[2], x[0]);
+    for (std::size_t i=1; i<n; i++)
+    {
+        Real p[3];
+        DataTypes::get(p[0], p[1], p[2], x[i]);
+        for (int c=0; c<3; c++)
+        {
+            minP[c] = std::min(minP[c], p[c]);
+            maxP[c] = std::max(maxP[c], p[c]);
+        }
+    }
+
+    // cells at least as large as the radius, so that the neighbors are in the 27 surrounding cells,
+    // and no more cells than particles
+    Real cellSize = radius;
+    std::size_t dims[3];
+    for (;;)
+    {
+        std::size_t nbCells = 1;
+        for (int c=0; c<3; c++)
+        {
+            dims[c] = std::size_t((maxP[c]-minP[c]) / cellSize) + 1;
+            nbCells *= dims[c];
+        }
+        if (nbCells <= 2*n)
+            break;
+        cellSize *= 2;
+    }
+    const std::size_t nbCells = dims[0]*dims[1]*dims[2];
+
+    // sort the particles by cell
+    auto cellCoord = [&](std::size_t i, std::size_t cell[3])
+    {
+        Real p[3];
+        DataTypes::get(p[0], p[1], p[2], x[i]);
+        for (int c=0; c<3; c++)
+            cell[c] = std::min(dims[c]-1, std::size_t((p[c]-minP[c]) / cellSize));
+    };
+    m_particleCells.resize(n);
+    m_cellStart.assign(nbCells+1, 0);
+    for (std::size_t i=0; i<n; i++)
+    {
+        std::size_t cell[3];
+        cellCoord(i, cell);
+        m_particleCells[i] = (unsigned int)((cell[2]*dims[1] + cell[1])*dims[0] + cell[0]);
+        m_cellStart[m_particleCells[i]+1]++;
+    }
+    for (std::size_t c=0; c<nbCells; c++)
+        m_cellStart[c+1] += m_cellStart[c];
+    m_cellParticles.resize(n);
+    {
+        sofa::helper::vector<unsigned int> next(m_cellStart.begin(), m_cellStart.end()-1);
+        for (std::size_t i=0; i<n; i++)
+            m_cellParticles[next[m_particleCells[i]]++] = (unsigned int)i;
+    }
+
+    // pairs (a<b) closer than the radius
+    const Real radius2 = radius*radius;
+    for (std::size_t ia=0; ia<n; ia++)
+    {
+        std::size_t cell[3];
+        cellCoord(ia, cell);
+        const Coord pa = x[ia];
+        for (std::size_t cz = (cell[2] > 0 ? cell[2]-1 : 0); cz <= std::min(cell[2]+1, dims[2]-1); cz++)
+            for (std::size_t cy = (cell[1] > 0 ? cell[1]-1 : 0); cy <= std::min(cell[1]+1, dims[1]-1); cy++)
+                for (std::size_t cx = (cell[0] > 0 ? cell[0]-1 : 0); cx <= std::min(cell[0]+1, dims[0]-1); cx++)
+                {
+                    const std::size_t c = (cz*dims[1] + cy)*dims[0] + cx;
+                    for (unsigned int k=m_cellStart[c]; k<m_cellStart[c+1]; k++)
+                    {
+                        const unsigned int ib = m_cellParticles[k];
+                        if (ib > ia && (x[ib]-pa).norm2() < radius2)
+                            m_neighborPairs.emplace_back((unsigned int)ia, ib);
+                    }
+                }
+    }
+
+    // sorted by (b,a) as visited by the full double loop, so that the forces are accumulated in the same order
+    std::sort(m_neighborPairs.begin(), m_neighborPairs.end(), [](const auto& p, const auto& q)
+    {
+        return p.second < q.second || (p.second == q.second && p.first < q.first);
+    });
+}
+
 template<class DataTypes>
 void LennardJonesForceField<DataTypes>::addForce(const core::MechanicalParams* /* mparams */, DataVecDeriv& d_f, const DataVecCoord& d_x, const DataVecDeriv& d_v)
 {
@@ -87,9 +269,59 @@ void LennardJonesForceField<DataTypes>::addForce(const core::MechanicalParams* /
     const VecCoord& p1 = d_x.getValue();
     const VecDeriv& v1 = d_v.getValue();
 
+    const PairParameters params = getPairParameters();
+    const Real damp = damping.getValue();
     Real dmax2 = dmax.getValue()*dmax.getValue();
     this->dforces.clear();
     f1.resize(p1.size());
+
+    // the neighbor list is skipped if dmax was changed to an invalid value since init
+    if (d_useNeighborList.getValue() && getNeighborListRadius() > 0)
+    {
+        updateNeighborList(p1);
+
+        const std::size_t nbPairs = m_neighborPairs.size();
+        m_pairForces.resize(nbPairs);
+        const std::function<void(std::size_t,std::size_t)> computePairs = [&](std::size_t begin, std::size_t end)
+        {
+            for (std::size_t k=begin; k<end; k++)
+            {
+                const unsigned int ia = m_neighborPairs[k].first;
+                const unsigned int ib = m_neighborPairs[k].second;
+                PairForce& pf = m_pairForces[k];
+                const Deriv u = p1[ib]-p1[ia];
+                const Real d2 = u.norm2();
+                pf.active = (d2 < dmax2);
+                if (!pf.active) continue;
+                Real d, forceIntensity;
+                params.compute(d2, d, forceIntensity, pf.df);
+                pf.force = u*(forceIntensity/d);
+
+                // Add damping
+                pf.force += (v1[ib]-v1[ia])*damp;
+            }
+        };
+
+        simulation::TaskScheduler* taskScheduler = d_parallelForces.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+        simulation::parallelForRange(taskScheduler, 0, nbPairs, lennardjones::minPairsPerTask, computePairs);
+
+        // accumulated in the order of the pairs, whatever the number of threads
+        for (std::size_t k=0; k<nbPairs; k++)
+        {
+            const PairForce& pf = m_pairForces[k];
+            if (!pf.active) continue;
+            DForce df;
+            df.a = m_neighborPairs[k].first;
+            df.b = m_neighborPairs[k].second;
+            df.df = pf.df;
+            this->dforces.push_back(df);
+            f1[df.a]+=pf.force;
+            f1[df.b]-=pf.force;
+        }
+        d_f.endEdit();
+        return;
+    }
+
     for (unsigned int ib=1; ib<p1.size(); ib++)
     {
         const Coord pb = p1[ib];
@@ -99,44 +331,17 @@ void LennardJonesForceField<DataTypes>::addForce(const core::MechanicalParams* /
             const Deriv u = pb-pa;
             const Real d2 = u.norm2();
             if (d2 >= dmax2) continue;
-            const Real d = (Real)sqrt(d2);
-
-            Real fa ;
-            if(aInit.getValue()!=0)
-                fa = a*alpha.getValue()*(1.f/d2);
-            else
-                fa = a*alpha.getValue()*(Real)pow(d,-alpha.getValue()-1);
-
-            Real forceIntensity;
-            const Real fb = b*beta.getValue()*(Real)pow(d,-beta.getValue()-1);
-
-            if(beta.getValue() > 0)
-                forceIntensity = fa - fb;
-
-            else
-                forceIntensity = fa;
 
+            Real d, forceIntensity;
             DForce df;
             df.a = ia;
             df.b = ib;
-            if (forceIntensity > fmax.getValue())
-            {
-                forceIntensity = fmax.getValue();
-                df.df = 0;
-            }
-            else
-            {
-                if(beta.getValue() > 0)
-                    df.df = ((-alpha.getValue()-1)*fa - (-beta.getValue()-1)*fb)/(d*d2);
-                else
-                    df.df = ((-alpha.getValue()-1)*fa)/(d*d2);
-
-            }
+            params.compute(d2, d, forceIntensity, df.df);
             this->dforces.push_back(df);
             Deriv force = u*(forceIntensity/d);
 
             // Add damping
-            force += (v1[ib]-v1[ia])*damping.getValue();
+            force += (v1[ib]-v1[ia])*damp;
 
             f1[ia]+=force;
             f1[ib]-=force;
@@ -34,6 +34,8 @@
 #include <sofa/helper/map.h>
 #include <sofa/core/topology/BaseMeshTopology.h>
 
+#include <functional>
+
 
 namespace sofa::component::topology
 {
@@ -114,6 +116,12 @@ public:
     /// if specific mass information should be outputed
     Data< bool >         d_printMass; ///< Boolean to print the mass
     Data< std::map < std::string, sofa::helper::vector<double> > > f_graph; ///< Graph of the controlled potential
+    /// if the mass-vector products should use the threads of the TaskScheduler
+    Data< bool >         d_parallelComputation;
+    /// maximum number of iterations of the consistent mass solve in accFromF
+    Data< unsigned int > d_accFromFIterations;
+    /// relative residual of the consistent mass solve in accFromF
+    Data< Real >         d_accFromFTolerance;
 
     /// Link to be set to the topology container in the component graph.
     SingleLink<MeshMatrixMass<DataTypes, TMassType>, sofa::core::topology::BaseMeshTopology, BaseLink::FLAG_STOREPATH | BaseLink::FLAG_STRONGLINK> l_topology;
@@ -209,7 +217,8 @@ public:
     // -- Mass interface
     void addMDx(const core::MechanicalParams*, DataVecDeriv& f, const DataVecDeriv& dx, SReal factor) override;
 
-    void accFromF(const core::MechanicalParams*, DataVecDeriv& a, const DataVecDeriv& f) override; // This function can't be used as it use M^-1
+    /// With a consistent mass, M a = f is solved by a Jacobi-preconditioned conjugate gradient.
+    void accFromF(const core::MechanicalParams*, DataVecDeriv& a, const DataVecDeriv& f) override;
 
     void addForce(const core::MechanicalParams*, DataVecDeriv& f, const DataVecCoord& x, const DataVecDeriv& v) override;
 
@@ -415,6 +424,24 @@ protected:
     EdgeMassHandler* m_edgeMassHandler;
 
     sofa::core::topology::BaseMeshTopology* m_topology;
+
+    /// @name Assembled mass matrix
+    /// @{
+    /// Rebuild the CSR mass matrix if the vertex or edge masses or the topology changed
+    void updateMassMatrix();
+    /// res += factor * M dx on the rows [begin,end), with the assembled mass matrix
+    void multMassMatrix(VecDeriv& res, const VecDeriv& dx, Real factor, std::size_t begin, std::size_t end) const;
+    /// apply f on contiguous ranges of [0,n), with the threads of the TaskScheduler if d_parallelComputation is set
+    void forEachRange(std::size_t n, const std::function<void(std::size_t,std::size_t)>& f);
+
+    /// Non-zero entries of each row: the vertex mass first, then the edge masses in the order of the edges (CSR layout)
+    helper::vector<Index> m_massRowBegin;
+    helper::vector<Index> m_massColumns;
+    helper::vector<MassType> m_massValues;
+    int m_massVertexCounter;
+    int m_massEdgeCounter;
+    int m_massTopologyRevision;
+    /// @}
 };
 
 #if  !defined(SOFA_COMPONENT_MASS_MESHMATRIXMASS_CPP)
@@ -38,11 +38,22 @@
 #include <SofaBaseTopology/HexahedronSetGeometryAlgorithms.h>
 #include <sofa/simulation/AnimateEndEvent.h>
 #include <sofa/core/behavior/MultiMatrixAccessor.h>
+#include <sofa/simulation/ParallelForRange.h>
+
+#include <cmath>
 
 namespace sofa::component::mass
 {
 using namespace sofa::core::topology;
 
+namespace meshmatrixmass
+{
+
+/// Minimum number of vertices handled by each task of the parallel computations
+constexpr std::size_t minElementsPerTask = 1024;
+
+} // namespace meshmatrixmass
+
 template <class DataTypes, class MassType>
 MeshMatrixMass<DataTypes, MassType>::MeshMatrixMass()
     : d_vertexMass( initData(&d_vertexMass, "vertexMass", "Specify a vector giving the mass of each vertex. \n"
@@ -60,11 +71,17 @@ MeshMatrixMass<DataTypes, MassType>::MeshMatrixMass()
     , d_lumping( initData(&d_lumping, false, "lumping","boolean if you need to use a lumped mass matrix") )
     , d_printMass( initData(&d_printMass, false, "printMass","boolean if you want to check the mass conservation") )
     , f_graph( initData(&f_graph,"graph","Graph of the controlled potential") )
+    , d_parallelComputation( initData(&d_parallelComputation, false, "parallelComputation", "compute the mass-vector products with the threads of the TaskScheduler") )
+    , d_accFromFIterations( initData(&d_accFromFIterations, (unsigned int)50, "accFromFIterations", "maximum number of iterations of the consistent mass solve in accFromF (not lumped)") )
+    , d_accFromFTolerance( initData(&d_accFromFTolerance, Real(1e-10), "accFromFTolerance", "relative residual stopping the consistent mass solve in accFromF (not lumped)") )
     , l_topology(initLink("topology", "link to the topology container"))
     , m_massTopologyType(TopologyElementType::UNKNOWN)
     , m_vertexMassHandler(nullptr)
     , m_edgeMassHandler(nullptr)
     , m_topology(nullptr)
+    , m_massVertexCounter(-1)
+    , m_massEdgeCounter(-1)
+    , m_massTopologyRevision(-1)
 {
     f_graph.setWidget("graph");
 
@@ -935,6 +952,9 @@ void MeshMatrixMass<DataTypes, MassType>::init()
 
     //Function for GPU-CUDA version only
     this->copyVertexMass();
+
+    if (d_parallelComputation.getValue())
+        simulation::initTaskScheduler();
 }
 
 
@@ -1784,63 +1804,136 @@ void MeshMatrixMass<DataTypes, MassType>::clear()
 }
 
 
-// -- Mass interface
+// -- Assembled mass matrix
 template <class DataTypes, class MassType>
-void MeshMatrixMass<DataTypes, MassType>::addMDx(const core::MechanicalParams*, DataVecDeriv& vres, const DataVecDeriv& vdx, SReal factor)
+void MeshMatrixMass<DataTypes, MassType>::updateMassMatrix()
 {
     const MassVector &vertexMass= d_vertexMassInfo.getValue();
     const MassVector &edgeMass= d_edgeMassInfo.getValue();
+    const size_t nbPoints = vertexMass.size();
+    const size_t nbEdges = std::min<size_t>(m_topology->getNbEdges(), edgeMass.size());
+
+    if (m_massVertexCounter == d_vertexMassInfo.getCounter()
+        && m_massEdgeCounter == d_edgeMassInfo.getCounter()
+        && m_massTopologyRevision == m_topology->getRevision()
+        && m_massRowBegin.size() == nbPoints+1
+        && m_massValues.size() == nbPoints+2*nbEdges)
+        return;
 
-    helper::WriteAccessor< DataVecDeriv > res = vres;
-    helper::ReadAccessor< DataVecDeriv > dx = vdx;
-
-    SReal massTotal = 0.0;
+    m_massVertexCounter = d_vertexMassInfo.getCounter();
+    m_massEdgeCounter = d_edgeMassInfo.getCounter();
+    m_massTopologyRevision = m_topology->getRevision();
 
-    //using a lumped matrix (default)-----
-    if(d_lumping.getValue())
+    // count the entries of each row: the diagonal plus one per edge around the vertex
+    m_massRowBegin.assign(nbPoints+1, 0);
+    for (size_t i=0; i<nbPoints; i++)
+        m_massRowBegin[i+1] = 1;
+    for (size_t j=0; j<nbEdges; ++j)
     {
-        for (size_t i=0; i<dx.size(); i++)
-        {
-            res[i] += dx[i] * vertexMass[i] * m_massLumpingCoeff * Real(factor);
-            massTotal += vertexMass[i]*m_massLumpingCoeff * Real(factor);
-        }
+        const auto& e = m_topology->getEdge(j);
+        ++m_massRowBegin[e[0]+1];
+        ++m_massRowBegin[e[1]+1];
+    }
+    for (size_t i=0; i<nbPoints; i++)
+        m_massRowBegin[i+1] += m_massRowBegin[i];
 
+    // fill the rows in the order of the edges, as the edge loop of the non assembled product
+    m_massColumns.resize(m_massRowBegin[nbPoints]);
+    m_massValues.resize(m_massRowBegin[nbPoints]);
+    helper::vector<Index> next(m_massRowBegin.begin(), m_massRowBegin.end()-1);
+    for (size_t i=0; i<nbPoints; i++)
+    {
+        m_massColumns[next[i]] = Index(i);
+        m_massValues[next[i]++] = vertexMass[i];
     }
-    //using a sparse matrix---------------
-    else
+    for (size_t j=0; j<nbEdges; ++j)
     {
-        size_t nbEdges=m_topology->getNbEdges();
-        size_t v0,v1;
+        const Index v0 = m_topology->getEdge(j)[0];
+        const Index v1 = m_topology->getEdge(j)[1];
+        m_massColumns[next[v0]] = v1;
+        m_massValues[next[v0]++] = edgeMass[j];
+        m_massColumns[next[v1]] = v0;
+        m_massValues[next[v1]++] = edgeMass[j];
+    }
+}
 
-        for (unsigned int i=0; i<dx.size(); i++)
-        {
-            res[i] += dx[i] * vertexMass[i] * Real(factor);
-            massTotal += vertexMass[i] * Real(factor);
-        }
 
-        Real tempMass=0.0;
+template <class DataTypes, class MassType>
+void MeshMatrixMass<DataTypes, MassType>::multMassMatrix(VecDeriv& res, const VecDeriv& dx, Real factor, std::size_t begin, std::size_t end) const
+{
+    for (size_t i=begin; i<end; i++)
+    {
+        Index k = m_massRowBegin[i];
+        const Index rowEnd = m_massRowBegin[i+1];
+        Deriv r = res[i] + dx[i] * m_massValues[k] * factor;
+        for (++k; k<rowEnd; ++k)
+            r += dx[m_massColumns[k]] * (m_massValues[k] * factor);
+        res[i] = r;
+    }
+}
 
-        for (unsigned int j=0; j<nbEdges; ++j)
-        {
-            tempMass = edgeMass[j] * Real(factor);
 
-            v0=m_topology->getEdge(j)[0];
-            v1=m_topology->getEdge(j)[1];
+template <class DataTypes, class MassType>
+void MeshMatrixMass<DataTypes, MassType>::forEachRange(std::size_t n, const std::function<void(std::size_t,std::size_t)>& f)
+{
+    simulation::TaskScheduler* taskScheduler = d_parallelComputation.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    simulation::parallelForRange(taskScheduler, 0, n, meshmatrixmass::minElementsPerTask, f);
+}
 
-            res[v0] += dx[v1] * tempMass;
-            res[v1] += dx[v0] * tempMass;
 
-            massTotal += 2*edgeMass[j] * Real(factor);
-        }
-    }
+// -- Mass interface
+template <class DataTypes, class MassType>
+void MeshMatrixMass<DataTypes, MassType>::addMDx(const core::MechanicalParams*, DataVecDeriv& vres, const DataVecDeriv& vdx, SReal factor)
+{
+    const MassVector &vertexMass= d_vertexMassInfo.getValue();
+
+    helper::WriteAccessor< DataVecDeriv > vecRes = vres;
+    helper::ReadAccessor< DataVecDeriv > vecDx = vdx;
+    VecDeriv& res = vecRes.wref();
+    const VecDeriv& dx = vecDx.ref();
 
-    if(d_printMass.getValue() && (this->getContext()->getTime()==0.0))
+    //using a lumped matrix (default)-----
+    if(d_lumping.getValue())
     {
-        msg_info() <<"Total Mass = "<<massTotal;
+        forEachRange(dx.size(), [&](std::size_t begin, std::size_t end)
+        {
+            for (size_t i=begin; i<end; i++)
+                res[i] += dx[i] * vertexMass[i] * m_massLumpingCoeff * Real(factor);
+        });
+    }
+    //using a sparse matrix---------------
+    else
+    {
+        // the rows add the same terms in the same order as a loop on the vertices then on the edges
+        updateMassMatrix();
+        forEachRange(std::min(dx.size(), m_massRowBegin.size()-1), [&](std::size_t begin, std::size_t end)
+        {
+            multMassMatrix(res, dx, Real(factor), begin, end);
+        });
     }
 
     if(d_printMass.getValue())
     {
+        SReal massTotal = 0.0;
+        if(d_lumping.getValue())
+        {
+            for (size_t i=0; i<dx.size(); i++)
+                massTotal += vertexMass[i]*m_massLumpingCoeff * Real(factor);
+        }
+        else
+        {
+            const MassVector &edgeMass= d_edgeMassInfo.getValue();
+            for (size_t i=0; i<dx.size(); i++)
+                massTotal += vertexMass[i] * Real(factor);
+            for (size_t j=0; j<m_topology->getNbEdges(); ++j)
+                massTotal += 2*edgeMass[j] * Real(factor);
+        }
+
+        if(this->getContext()->getTime()==0.0)
+        {
+            msg_info() <<"Total Mass = "<<massTotal;
+        }
+
         std::map < std::string, sofa::helper::vector<double> >& graph = *f_graph.beginEdit();
         sofa::helper::vector<double>& graph_error = graph["Mass variations"];
         graph_error.push_back(massTotal+0.000001);
@@ -1854,21 +1947,120 @@ template <class DataTypes, class MassType>
 void MeshMatrixMass<DataTypes, MassType>::accFromF(const core::MechanicalParams* mparams, DataVecDeriv& a, const DataVecDeriv& f)
 {
     SOFA_UNUSED(mparams);
-    if( !d_lumping.getValue() )
+
+    helper::WriteAccessor< DataVecDeriv > _a = a;
+    const VecDeriv& _f = f.getValue();
+    const MassVector &vertexMass= d_vertexMassInfo.getValue();
+
+    if( d_lumping.getValue() )
     {
-        msg_error() << "the method 'accFromF' can't be used with MeshMatrixMass as this SPARSE mass matrix can't be inversed easily. "
+        forEachRange(vertexMass.size(), [&](std::size_t begin, std::size_t end)
+        {
+            for (size_t i=begin; i<end; i++)
+                _a[i] = _f[i] / ( vertexMass[i] * m_massLumpingCoeff);
+        });
+        return;
+    }
+
+    // The consistent mass built on quads or hexahedra is singular (resp. indefinite):
+    // the checkerboard modes of the elements have a null (resp. negative) mass.
+    if (m_massTopologyType == TopologyElementType::QUAD || m_massTopologyType == TopologyElementType::HEXAHEDRON)
+    {
+        msg_error() << "the method 'accFromF' can't be used with a consistent MeshMatrixMass on quads or hexahedra, as this mass matrix is not invertible. "
                     << "Please proceed to mass lumping or use a DiagonalMass (both are equivalent).";
         return;
     }
 
-    helper::WriteAccessor< DataVecDeriv > _a = a;
-    const VecDeriv& _f = f.getValue();
-    const MassVector &vertexMass= d_vertexMassInfo.getValue();
+    // Solve M a = f by a conjugate gradient preconditioned by the diagonal of M,
+    // starting from the lumped-like guess diag(M)^-1 f.
+    updateMassMatrix();
+    const size_t n = std::min(_f.size(), m_massRowBegin.size()-1);
+    _a.resize(_f.size());
+
+    VecDeriv r(n), z(n), p(n), q(n);
+    Real rr0 = 0;
+    for (size_t i=0; i<n; i++)
+    {
+        _a[i] = _f[i] / m_massValues[m_massRowBegin[i]];
+        rr0 += _f[i] * _f[i];
+    }
+    if (rr0 == 0)
+        return;
+
+    forEachRange(n, [&](std::size_t begin, std::size_t end)
+    {
+        for (size_t i=begin; i<end; i++)
+            r[i] = _f[i];
+        multMassMatrix(r, _a.wref(), Real(-1), begin, end);
+        for (size_t i=begin; i<end; i++)
+        {
+            z[i] = r[i] / m_massValues[m_massRowBegin[i]];
+            p[i] = z[i];
+        }
+    });
 
-    for (unsigned int i=0; i<vertexMass.size(); i++)
+    Real rz = 0, rr = 0;
+    for (size_t i=0; i<n; i++)
     {
-        _a[i] = _f[i] / ( vertexMass[i] * m_massLumpingCoeff);
+        rz += r[i] * z[i];
+        rr += r[i] * r[i];
     }
+
+    const Real tolerance2 = d_accFromFTolerance.getValue() * d_accFromFTolerance.getValue() * rr0;
+    const unsigned int maxIterations = d_accFromFIterations.getValue();
+    unsigned int nbIterations = 0;
+    while (rr > tolerance2 && nbIterations < maxIterations)
+    {
+        forEachRange(n, [&](std::size_t begin, std::size_t end)
+        {
+            for (size_t i=begin; i<end; i++)
+                q[i] = Deriv();
+            multMassMatrix(q, p, Real(1), begin, end);
+        });
+
+        Real pq = 0;
+        for (size_t i=0; i<n; i++)
+            pq += p[i] * q[i];
+        if (pq <= 0)
+        {
+            msg_error() << "accFromF: the mass matrix is not positive definite, the acceleration is not converged.";
+            break;
+        }
+
+        const Real alpha = rz / pq;
+        forEachRange(n, [&](std::size_t begin, std::size_t end)
+        {
+            for (size_t i=begin; i<end; i++)
+            {
+                _a[i] += p[i] * alpha;
+                r[i] -= q[i] * alpha;
+                z[i] = r[i] / m_massValues[m_massRowBegin[i]];
+            }
+        });
+
+        const Real rzOld = rz;
+        rz = 0;
+        rr = 0;
+        for (size_t i=0; i<n; i++)
+        {
+            rz += r[i] * z[i];
+            rr += r[i] * r[i];
+        }
+
+        const Real beta = rz / rzOld;
+        forEachRange(n, [&](std::size_t begin, std::size_t end)
+        {
+            for (size_t i=begin; i<end; i++)
+                p[i] = z[i] + p[i] * beta;
+        });
+        ++nbIterations;
+    }
+
+    msg_info() << "accFromF: " << nbIterations << " iterations, relative residual " << std::sqrt(rr / rr0);
+    msg_warning_when(rr > tolerance2 && nbIterations == maxIterations)
+            << "accFromF: the consistent mass solve stopped after accFromFIterations = " << maxIterations
+            << " iterations with a relative residual of " << std::sqrt(rr / rr0) << " (accFromFTolerance = " << d_accFromFTolerance.getValue()
+            << "), the acceleration is not converged. Increase accFromFIterations or use mass lumping.";
 }
 
 
@@ -0,0 +1,101 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+
+#include <SofaMiscMapping/ReducedBasisMapping.h>
+
+#include <SofaBaseMechanics_test/MappingTestCreation.h>
+
+namespace sofa {
+namespace {
+
+
+/**  Test suite for ReducedBasisMapping.
+  */
+template <typename ReducedBasisMapping>
+struct ReducedBasisMappingTest : public sofa::mapping_test::Mapping_test<ReducedBasisMapping>
+{
+    typedef typename ReducedBasisMapping::In InDataTypes;
+    typedef typename InDataTypes::VecCoord InVecCoord;
+    typedef typename InDataTypes::Coord InCoord;
+
+    typedef typename ReducedBasisMapping::Out OutDataTypes;
+    typedef typename OutDataTypes::VecCoord OutVecCoord;
+    typedef typename OutDataTypes::VecDeriv OutVecDeriv;
+    typedef typename OutDataTypes::Coord OutCoord;
+    typedef typename OutDataTypes::Deriv OutDeriv;
+
+
+    bool test()
+    {
+        ReducedBasisMapping* map = static_cast<ReducedBasisMapping*>( this->mapping );
+
+        // 2 modes of a 3-node mesh, only the nodes 2 and 0 are mapped
+        OutVecDeriv basis(6);
+        basis[0] = OutDeriv(1,0,0);
+        basis[1] = OutDeriv(0,1,0);
+        basis[2] = OutDeriv(0,0,1);
+        basis[3] = OutDeriv(0,2,0);
+        basis[4] = OutDeriv(1,1,1);
+        basis[5] = OutDeriv(-1,0,3);
+        map->d_basis.setValue(basis);
+        map->d_indices.setValue({2,0});
+
+        // reduced coordinates
+        InVecCoord qinit(2), q(2);
+        q[0][0] = 0.5;
+        q[1][0] = -2;
+
+        // rest positions of the mapped nodes
+        OutVecCoord xinit(2);
+        xinit[0] = OutCoord(1,2,3);
+        xinit[1] = OutCoord(-1,0,4);
+
+        // expected child positions
+        OutVecCoord expectedoutcoord(2);
+        expectedoutcoord[0] = xinit[0] + basis[2]*q[0][0] + basis[5]*q[1][0];
+        expectedoutcoord[1] = xinit[1] + basis[0]*q[0][0] + basis[3]*q[1][0];
+
+        return this->runTest( qinit, xinit, q, expectedoutcoord );
+    }
+
+};
+
+
+// Define the list of types to instanciate.
+using ::testing::Types;
+typedef Types<
+component::mapping::ReducedBasisMapping<defaulttype::Vec1Types,defaulttype::Vec3Types>
+> DataTypes; // the types to instanciate.
+
+// Test suite for all the instanciations
+TYPED_TEST_SUITE( ReducedBasisMappingTest, DataTypes );
+
+// test case
+TYPED_TEST( ReducedBasisMappingTest , test )
+{
+    ASSERT_TRUE(this->test());
+}
+
+
+
+} // namespace
+} // namespace sofa
@@ -0,0 +1,116 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+
+#include <SofaMiscMapping/config.h>
+
+#include <sofa/core/Mapping.h>
+#include <SofaEigen2Solver/EigenSparseMatrix.h>
+
+
+namespace sofa::component::mapping
+{
+
+/**
+    Maps reduced coordinates (the amplitudes of a set of modes) to the positions
+    of a full-resolution mesh:  x_i = x0_i + sum_k q_k basis_k[i]
+
+    The modes are typically computed offline by a Proper Orthogonal Decomposition
+    of simulation snapshots (see ProperOrthogonalDecomposition in SofaMiscFem).
+    Only the rows of the basis listed in "indices" are mapped, so that several
+    children (a hyper-reduced sample of the mesh, the loaded nodes, the visual
+    mesh...) can share the same reduced coordinates.
+
+    The mapping is linear: its Jacobian is the (sampled) basis, assembled once.
+*/
+template <class TIn, class TOut>
+class ReducedBasisMapping : public core::Mapping<TIn, TOut>
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE2(ReducedBasisMapping,TIn,TOut), SOFA_TEMPLATE2(core::Mapping,TIn,TOut));
+
+    typedef core::Mapping<TIn, TOut> Inherit;
+    typedef TIn In;
+    typedef TOut Out;
+    typedef typename Out::VecCoord OutVecCoord;
+    typedef typename Out::VecDeriv OutVecDeriv;
+    typedef typename Out::Coord OutCoord;
+    typedef typename Out::Deriv OutDeriv;
+    typedef typename Out::MatrixDeriv OutMatrixDeriv;
+    typedef typename Out::Real Real;
+    typedef typename In::Deriv InDeriv;
+    typedef typename In::MatrixDeriv InMatrixDeriv;
+    typedef typename In::Coord InCoord;
+    typedef typename In::VecCoord InVecCoord;
+    typedef typename In::VecDeriv InVecDeriv;
+    typedef linearsolver::EigenSparseMatrix<TIn,TOut>   SparseMatrixEigen;
+
+    Data< OutVecDeriv > d_basis; ///< modes of the full mesh, stored one after the other (mode k of node i at k*nbNodes+i)
+    Data< helper::vector<unsigned> > d_indices; ///< nodes of the full mesh mapped to the output points (all nodes if empty)
+    Data< OutVecCoord > d_restPosition; ///< output positions for null reduced coordinates (the output rest positions if empty)
+
+    void init() override;
+    void reinit() override;
+
+    using Inherit::apply;
+
+    void apply(const core::MechanicalParams *mparams, Data<OutVecCoord>& out, const Data<InVecCoord>& in) override;
+
+    void applyJ(const core::MechanicalParams *mparams, Data<OutVecDeriv>& out, const Data<InVecDeriv>& in) override;
+
+    void applyJT(const core::MechanicalParams *mparams, Data<InVecDeriv>& out, const Data<OutVecDeriv>& in) override;
+
+    void applyJT(const core::ConstraintParams *cparams, Data<InMatrixDeriv>& out, const Data<OutMatrixDeriv>& in) override;
+
+    void applyDJT(const core::MechanicalParams* /*mparams*/, core::MultiVecDerivId /*parentForce*/, core::ConstMultiVecDerivId /*childForce*/ ) override {}
+
+    const sofa::defaulttype::BaseMatrix* getJ() override;
+    virtual const helper::vector<sofa::defaulttype::BaseMatrix*>* getJs() override;
+
+    const defaulttype::BaseMatrix* getK() override { return nullptr; }
+
+protected:
+    ReducedBasisMapping();
+    virtual ~ReducedBasisMapping();
+
+    /// Check the sizes and assemble the Jacobian from the basis rows of the mapped nodes
+    void updateJacobian();
+
+    /// Mode k of the node mapped to the output point i
+    const OutDeriv& mode(std::size_t k, std::size_t i) const { return d_basis.getValue()[k*m_nbNodes + m_nodes[i]]; }
+
+    SparseMatrixEigen jacobian;                             ///< Jacobian of the mapping
+    helper::vector<defaulttype::BaseMatrix*> baseMatrices;  ///< Jacobian of the mapping, in a vector
+
+    std::size_t m_nbModes;              ///< number of reduced coordinates
+    std::size_t m_nbNodes;              ///< number of nodes of the full mesh
+    helper::vector<unsigned> m_nodes;   ///< node of the full mesh of each output point
+};
+
+
+
+
+#if  !defined(SOFA_COMPONENT_MAPPING_REDUCEDBASISMAPPING_CPP)
+extern template class SOFA_SOFAMISCMAPPING_API ReducedBasisMapping< defaulttype::Vec1Types, defaulttype::Vec3Types >;
+#endif
+
+} // namespace sofa::component::mapping
@@ -0,0 +1,217 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#pragma once
+
+#include "ReducedBasisMapping.h"
+#include <sofa/core/MechanicalParams.h>
+#include <sofa/core/ConstraintParams.h>
+#include <sofa/core/behavior/MechanicalState.h>
+
+namespace sofa::component::mapping
+{
+
+template <class TIn, class TOut>
+ReducedBasisMapping<TIn, TOut>::ReducedBasisMapping()
+    : Inherit()
+    , d_basis(initData(&d_basis, "basis", "modes of the full mesh, stored one after the other (mode k of node i at k*nbNodes+i)"))
+    , d_indices(initData(&d_indices, "indices", "nodes of the full mesh mapped to the output points (all nodes if empty)"))
+    , d_restPosition(initData(&d_restPosition, "restPosition", "output positions for null reduced coordinates (the output rest positions if empty)"))
+    , m_nbModes(0)
+    , m_nbNodes(0)
+{
+}
+
+template <class TIn, class TOut>
+ReducedBasisMapping<TIn, TOut>::~ReducedBasisMapping()
+{
+}
+
+
+template <class TIn, class TOut>
+void ReducedBasisMapping<TIn, TOut>::init()
+{
+    baseMatrices.resize( 1 );
+    baseMatrices[0] = &jacobian;
+
+    if( d_restPosition.getValue().empty() && this->toModel )
+        d_restPosition.setValue( this->toModel->read(core::ConstVecCoordId::restPosition())->getValue() );
+
+    updateJacobian();
+
+    this->Inherit::init();
+}
+
+template <class TIn, class TOut>
+void ReducedBasisMapping<TIn, TOut>::reinit()
+{
+    updateJacobian();
+
+    this->Inherit::reinit();
+}
+
+
+template <class TIn, class TOut>
+void ReducedBasisMapping<TIn, TOut>::updateJacobian()
+{
+    const OutVecDeriv& basis = d_basis.getValue();
+    const helper::vector<unsigned>& indices = d_indices.getValue();
+
+    m_nbModes = this->fromModel ? this->fromModel->getSize() : 0;
+    m_nbNodes = 0;
+    m_nodes.clear();
+    jacobian.resize(0,0);
+
+    if( m_nbModes == 0 || basis.size() % m_nbModes )
+    {
+        msg_error() << "The basis size (" << basis.size() << ") is not a multiple of the number of reduced coordinates (" << m_nbModes << ")";
+        this->d_componentState.setValue(core::objectmodel::ComponentState::Invalid);
+        return;
+    }
+    m_nbNodes = basis.size() / m_nbModes;
+
+    if( indices.empty() )
+    {
+        m_nodes.resize(m_nbNodes);
+        for( unsigned i=0 ; i<m_nbNodes ; ++i )
+            m_nodes[i] = i;
+    }
+    else
+    {
+        for( unsigned i : indices )
+        {
+            if( i >= m_nbNodes )
+            {
+                msg_error() << "Index " << i << " out of the " << m_nbNodes << " nodes of the basis";
+                this->d_componentState.setValue(core::objectmodel::ComponentState::Invalid);
+                return;
+            }
+        }
+        m_nodes = indices;
+    }
+
+    const std::size_t size = m_nodes.size();
+    if( d_restPosition.getValue().size() != size )
+    {
+        msg_error() << "The rest positions (" << d_restPosition.getValue().size() << ") do not match the " << size << " mapped nodes";
+        this->d_componentState.setValue(core::objectmodel::ComponentState::Invalid);
+        return;
+    }
+
+    // J = the basis rows of the mapped nodes, one scalar row per coordinate
+    jacobian.resizeBlocks( size, m_nbModes );
+    jacobian.reserve( size * Out::deriv_total_size * m_nbModes );
+    for( std::size_t i=0 ; i<size ; ++i )
+    {
+        for( std::size_t c=0 ; c<Out::deriv_total_size ; ++c )
+        {
+            const std::size_t row = i*Out::deriv_total_size + c;
+            jacobian.beginRow(row);
+            for( std::size_t k=0 ; k<m_nbModes ; ++k )
+                jacobian.insertBack( row, k, mode(k,i)[c] );
+        }
+    }
+    jacobian.compress();
+
+    this->d_componentState.setValue(core::objectmodel::ComponentState::Valid);
+}
+
+
+template <class TIn, class TOut>
+void ReducedBasisMapping<TIn, TOut>::apply(const core::MechanicalParams * /*mparams*/ , Data<OutVecCoord>& dOut, const Data<InVecCoord>& dIn)
+{
+    if( this->d_componentState.getValue() != core::objectmodel::ComponentState::Valid )
+        return;
+
+    helper::WriteOnlyAccessor< Data<OutVecCoord> >  out = dOut;
+    helper::ReadAccessor< Data<InVecCoord> >  in = dIn;
+    const OutVecCoord& restPosition = d_restPosition.getValue();
+
+    const std::size_t size = m_nodes.size();
+    this->getToModel()->resize( size );
+
+    for( std::size_t i=0 ; i<size ; ++i )
+    {
+        OutCoord x = restPosition[i];
+        for( std::size_t k=0 ; k<m_nbModes ; ++k )
+            x += mode(k,i) * in[k][0];
+        out[i] = x;
+    }
+}
+
+
+template <class TIn, class TOut>
+void ReducedBasisMapping<TIn, TOut>::applyJ(const core::MechanicalParams * /*mparams*/ , Data<OutVecDeriv>& dOut, const Data<InVecDeriv>& dIn)
+{
+    if( jacobian.rowSize() )
+        jacobian.mult(dOut,dIn);
+}
+
+template <class TIn, class TOut>
+void ReducedBasisMapping<TIn, TOut>::applyJT(const core::MechanicalParams * /*mparams*/ , Data<InVecDeriv>& dIn, const Data<OutVecDeriv>& dOut)
+{
+    if( jacobian.rowSize() )
+        jacobian.addMultTranspose(dIn,dOut);
+}
+
+template <class TIn, class TOut>
+void ReducedBasisMapping<TIn, TOut>::applyJT(const core::ConstraintParams* /*cparams*/, Data<InMatrixDeriv>& dIn, const Data<OutMatrixDeriv>& dOut)
+{
+    if( this->d_componentState.getValue() != core::objectmodel::ComponentState::Valid )
+        return;
+
+    InMatrixDeriv& in = *dIn.beginEdit();
+    const OutMatrixDeriv& out = dOut.getValue();
+
+    for( typename OutMatrixDeriv::RowConstIterator rowIt = out.begin() ; rowIt != out.end() ; ++rowIt )
+    {
+        if( rowIt.begin() == rowIt.end() )
+            continue;
+
+        // every reduced coordinate sees every output point
+        typename InMatrixDeriv::RowIterator o = in.writeLine(rowIt.index());
+        for( std::size_t k=0 ; k<m_nbModes ; ++k )
+        {
+            Real v = 0;
+            for( typename OutMatrixDeriv::ColConstIterator colIt = rowIt.begin() ; colIt != rowIt.end() ; ++colIt )
+                v += mode(k,colIt.index()) * colIt.val();
+            o.addCol( k, InDeriv(v) );
+        }
+    }
+
+    dIn.endEdit();
+}
+
+
+template <class TIn, class TOut>
+const sofa::defaulttype::BaseMatrix* ReducedBasisMapping<TIn, TOut>::getJ()
+{
+    return &jacobian;
+}
+
+template <class TIn, class TOut>
+const helper::vector<sofa::defaulttype::BaseMatrix*>* ReducedBasisMapping<TIn, TOut>::getJs()
+{
+    return &baseMatrices;
+}
+
+
+} // namespace sofa::component::mapping
@@ -68,11 +68,16 @@ OglModel::OglModel()
     , blendEquation( initData(&blendEquation, "blendEquation", "if alpha blending is enabled this specifies how source and destination colors are combined") )
     , sourceFactor( initData(&sourceFactor, "sfactor", "if alpha blending is enabled this specifies how the red, green, blue, and alpha source blending factors are computed") )
     , destFactor( initData(&destFactor, "dfactor", "if alpha blending is enabled this specifies how the red, green, blue, and alpha destination blending factors are computed") )
+    , d_persistentMapping( initData(&d_persistentMapping, false, "persistentMapping", "Stream the vertex data through a persistently mapped, triple buffered vertex buffer, writing only the modified parts (requires GL_ARB_buffer_storage)") )
     , tex(nullptr)
     , vbo(0), iboEdges(0), iboTriangles(0), iboQuads(0)
     , VBOGenDone(false), initDone(false), useEdges(false), useTriangles(false), useQuads(false), canUsePatches(false)
     , oldVerticesSize(0), oldNormalsSize(0), oldTexCoordsSize(0), oldTangentsSize(0), oldBitangentsSize(0), oldEdgesSize(0), oldTrianglesSize(0), oldQuadsSize(0)
+    , usePersistentMapping(false), streamPtr(nullptr), streamSegmentSize(0), streamSegment(0)
+    , oldTexCoordsCounter(-1), oldTangentsCounter(-1), oldBitangentsCounter(-1), oldEdgesCounter(-1), oldTrianglesCounter(-1), oldQuadsCounter(-1)
 {
+    std::fill(std::begin(streamFences), std::end(streamFences), nullptr);
+    std::fill(std::begin(streamAttributeOffsets), std::end(streamAttributeOffsets), 0);
 
     textures.clear();
 
@@ -111,6 +116,10 @@ OglModel::~OglModel()
     // graphics memory leaks after destroying the GLContext
     // even if the vbos destruction is claimed with the following
     // lines...
+    if (usePersistentMapping)
+    {
+        releaseStreamBuffer();
+    }
     if( vbo > 0 )
     {
         glDeleteBuffers(1,&vbo);
@@ -191,7 +200,7 @@ void OglModel::drawGroup(int ig, bool transparent)
         glEnable(GL_TEXTURE_2D);
 
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	    uintptr_t pt = (vertices.size()*sizeof(vertices[0]))
+	    uintptr_t pt = vertexBufferOffset() + (vertices.size()*sizeof(vertices[0]))
                     + (vnormals.size()*sizeof(vnormals[0]));
         glTexCoordPointer(2, GL_FLOAT, 0, reinterpret_cast<void*>(pt));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
@@ -356,6 +365,28 @@ void copyVector(const InType& src, OutType& dst)
     }
 }
 
+/// Same as copyVector, and return the range [first,last) of the elements of dst which were modified
+template<class InType, class OutType>
+std::pair<size_t, size_t> copyModifiedVector(const InType& src, OutType& dst)
+{
+    size_t first = src.size(), last = 0;
+    for (size_t i = 0; i < src.size(); ++i)
+    {
+        typename OutType::value_type v;
+        v.set(src[i]);
+        bool modified = false;
+        for (size_t c = 0; c < v.size(); ++c)
+            modified |= (v[c] != dst[i][c]);
+        if (modified)
+        {
+            dst[i] = v;
+            first = std::min(first, i);
+            last = i+1;
+        }
+    }
+    return { std::min(first, last), last };
+}
+
 void OglModel::internalDraw(const core::visual::VisualParams* vparams, bool transparent)
 {
     if (!vparams->displayFlags().getShowVisualModels())
@@ -391,11 +422,12 @@ void OglModel::internalDraw(const core::visual::VisualParams* vparams, bool tran
 
     GLulong vertexArrayByteSize = vertices.size() * vertexdatasize;
     GLulong normalArrayByteSize = vnormals.size() * normaldatasize;
+    const uintptr_t bufferOffset = vertexBufferOffset();
 
     //// Update the vertex buffers.
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glVertexPointer(3, datatype, 0, nullptr);
-    glNormalPointer(datatype, 0, reinterpret_cast<void*>(vertexArrayByteSize));
+    glVertexPointer(3, datatype, 0, reinterpret_cast<void*>(bufferOffset));
+    glNormalPointer(datatype, 0, reinterpret_cast<void*>(bufferOffset + vertexArrayByteSize));
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 
@@ -412,7 +444,7 @@ void OglModel::internalDraw(const core::visual::VisualParams* vparams, bool tran
 
         size_t textureArrayByteSize = vtexcoords.size()*sizeof(vtexcoords[0]);
         glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glTexCoordPointer(2, GL_FLOAT, 0, reinterpret_cast<void*>(vertexArrayByteSize + normalArrayByteSize ));
+        glTexCoordPointer(2, GL_FLOAT, 0, reinterpret_cast<void*>(bufferOffset + vertexArrayByteSize + normalArrayByteSize ));
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         glEnableClientState(GL_TEXTURE_COORD_ARRAY);
@@ -426,7 +458,7 @@ void OglModel::internalDraw(const core::visual::VisualParams* vparams, bool tran
 
             glBindBuffer(GL_ARRAY_BUFFER, vbo);
             glTexCoordPointer(3, GL_FLOAT, 0,
-                              reinterpret_cast<void*>(vertexArrayByteSize + normalArrayByteSize + textureArrayByteSize));
+                              reinterpret_cast<void*>(bufferOffset + vertexArrayByteSize + normalArrayByteSize + textureArrayByteSize));
             glBindBuffer(GL_ARRAY_BUFFER, 0);
 
             glClientActiveTexture(GL_TEXTURE2);
@@ -434,7 +466,7 @@ void OglModel::internalDraw(const core::visual::VisualParams* vparams, bool tran
 
             glBindBuffer(GL_ARRAY_BUFFER, vbo);
             glTexCoordPointer(3, GL_FLOAT, 0,
-                              reinterpret_cast<void*>(vertexArrayByteSize + normalArrayByteSize
+                              reinterpret_cast<void*>(bufferOffset + vertexArrayByteSize + normalArrayByteSize
                               + textureArrayByteSize + tangentArrayByteSize));
             glBindBuffer(GL_ARRAY_BUFFER, 0);
 
@@ -575,6 +607,14 @@ void OglModel::internalDraw(const core::visual::VisualParams* vparams, bool tran
     if (vparams->displayFlags().getShowWireFrame())
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
+    if (usePersistentMapping)
+    {
+        // the segment can be written again once the GPU has executed this draw
+        if (streamFences[streamSegment])
+            glDeleteSync(streamFences[streamSegment]);
+        streamFences[streamSegment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
     if (vparams->displayFlags().getShowNormals())
     {
         glColor3f (1.0, 1.0, 1.0);
@@ -688,6 +728,18 @@ void OglModel::initVisual()
         msg_warning() << "OglModel : VBO is not supported by your GPU" ;
     }
 
+    usePersistentMapping = false;
+    if (d_persistentMapping.getValue())
+    {
+#if defined(GLEW_ARB_buffer_storage) && defined(GLEW_ARB_sync)
+        usePersistentMapping = vboAvailable && GLEW_ARB_buffer_storage && GLEW_ARB_sync;
+#endif
+        if (!usePersistentMapping)
+        {
+            msg_warning() << "GL_ARB_buffer_storage not supported by your graphics card and/or OpenGL driver, persistentMapping is ignored." ;
+        }
+    }
+
     if (primitiveType.getValue().getSelectedId() == 1 && !GLEW_EXT_geometry_shader4)
     {
         msg_warning() << "GL_EXT_geometry_shader4 not supported by your graphics card and/or OpenGL driver." ;
@@ -769,6 +821,12 @@ void OglModel::createQuadsIndicesBuffer()
 
 void OglModel::initVertexBuffer()
 {
+    if (usePersistentMapping)
+    {
+        initStreamBuffer();
+        return;
+    }
+
     size_t positionsBufferSize, normalsBufferSize;
     size_t textureCoordsBufferSize = 0, tangentsBufferSize = 0, bitangentsBufferSize = 0;
     const VecCoord& vertices = this->getVertices();
@@ -841,6 +899,11 @@ void OglModel::initQuadsIndicesBuffer()
 
 void OglModel::updateVertexBuffer()
 {
+    if (usePersistentMapping)
+    {
+        updateStreamBuffer();
+        return;
+    }
 
     const VecCoord& vertices = this->getVertices();
     const VecCoord& vnormals = this->getVnormals();
@@ -918,6 +981,153 @@ void OglModel::updateVertexBuffer()
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+void OglModel::initStreamBuffer()
+{
+    const VecCoord& vertices = this->getVertices();
+    const VecCoord& vnormals = this->getVnormals();
+    const VecTexCoord& vtexcoords= this->getVtexcoords();
+    const VecCoord& vtangents= this->getVtangents();
+    const VecCoord& vbitangents= this->getVbitangents();
+    const bool useTexCoords = (tex || putOnlyTexCoords.getValue() || !textures.empty());
+    const bool hasTangents = useTexCoords && vtangents.size() && vbitangents.size();
+
+    // same layout as initVertexBuffer, repeated in each segment
+    const size_t attributeSizes[nbStreamAttributes] = {
+        vertices.size()*sizeof(Vec3f),
+        vnormals.size()*sizeof(Vec3f),
+        useTexCoords ? vtexcoords.size() * sizeof(vtexcoords[0]) : 0,
+        hasTangents ? vtangents.size() * sizeof(vtangents[0]) : 0,
+        hasTangents ? vbitangents.size() * sizeof(vbitangents[0]) : 0
+    };
+    size_t totalSize = 0;
+    for (size_t a = 0; a < nbStreamAttributes; ++a)
+    {
+        streamAttributeOffsets[a] = totalSize;
+        totalSize += attributeSizes[a];
+    }
+    streamSegmentSize = std::max<size_t>(256, (totalSize + 255) / 256 * 256);
+
+    // buffer storage is immutable, so the buffer is recreated each time its size changes
+    releaseStreamBuffer();
+    glGenBuffers(1, &vbo);
+#if defined(GLEW_ARB_buffer_storage)
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(GL_ARRAY_BUFFER, GLsizeiptr(nbStreamSegments * streamSegmentSize), nullptr, flags);
+    streamPtr = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, GLsizeiptr(nbStreamSegments * streamSegmentSize), flags));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+
+    if (!streamPtr)
+    {
+        msg_warning() << "Unable to map the vertex buffer persistently, persistentMapping is ignored." ;
+        glDeleteBuffers(1, &vbo);
+        glGenBuffers(1, &vbo);
+        usePersistentMapping = false;
+        initVertexBuffer();
+        return;
+    }
+
+    verticesTmpBuffer.resize( vertices.size() );
+    normalsTmpBuffer.resize( vnormals.size() );
+    copyVector(vertices, verticesTmpBuffer);
+    copyVector(vnormals, normalsTmpBuffer);
+    oldTexCoordsCounter = m_vtexcoords.getCounter();
+    oldTangentsCounter = m_vtangents.getCounter();
+    oldBitangentsCounter = m_vbitangents.getCounter();
+
+    for (size_t s = 0; s < nbStreamSegments; ++s)
+        for (size_t a = 0; a < nbStreamAttributes; ++a)
+            streamDirtyRanges[s][a] = { 0, attributeSizes[a] };
+    streamSegment = nbStreamSegments - 1;
+
+    updateStreamBuffer();
+}
+
+void OglModel::updateStreamBuffer()
+{
+    const VecCoord& vertices = this->getVertices();
+    const VecCoord& vnormals = this->getVnormals();
+    const VecTexCoord& vtexcoords= this->getVtexcoords();
+    const VecCoord& vtangents= this->getVtangents();
+    const VecCoord& vbitangents= this->getVbitangents();
+    const bool useTexCoords = (tex || putOnlyTexCoords.getValue() || !textures.empty());
+    const bool hasTangents = useTexCoords && vtangents.size() && vbitangents.size();
+
+    // bytes of each attribute modified since the last update
+    ByteRange modified[nbStreamAttributes];
+    const auto positionsRange = copyModifiedVector(vertices, verticesTmpBuffer);
+    modified[0] = { positionsRange.first * sizeof(Vec3f), positionsRange.second * sizeof(Vec3f) };
+    const auto normalsRange = copyModifiedVector(vnormals, normalsTmpBuffer);
+    modified[1] = { normalsRange.first * sizeof(Vec3f), normalsRange.second * sizeof(Vec3f) };
+    if (useTexCoords && oldTexCoordsCounter != m_vtexcoords.getCounter())
+        modified[2] = { 0, vtexcoords.size() * sizeof(vtexcoords[0]) };
+    if (hasTangents && oldTangentsCounter != m_vtangents.getCounter())
+        modified[3] = { 0, vtangents.size() * sizeof(vtangents[0]) };
+    if (hasTangents && oldBitangentsCounter != m_vbitangents.getCounter())
+        modified[4] = { 0, vbitangents.size() * sizeof(vbitangents[0]) };
+    oldTexCoordsCounter = m_vtexcoords.getCounter();
+    oldTangentsCounter = m_vtangents.getCounter();
+    oldBitangentsCounter = m_vbitangents.getCounter();
+
+    bool upToDate = true;
+    for (size_t s = 0; s < nbStreamSegments; ++s)
+        for (size_t a = 0; a < nbStreamAttributes; ++a)
+            streamDirtyRanges[s][a].add(modified[a]);
+    for (size_t a = 0; a < nbStreamAttributes; ++a)
+        upToDate &= streamDirtyRanges[streamSegment][a].empty();
+    if (upToDate)
+        return;
+
+    // wait for the GPU to finish reading the next segment, then write what changed since it was last written
+    const size_t next = (streamSegment + 1) % nbStreamSegments;
+    if (streamFences[next])
+    {
+        GLenum status;
+        do
+        {
+            status = glClientWaitSync(streamFences[next], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+        }
+        while (status == GL_TIMEOUT_EXPIRED);
+        glDeleteSync(streamFences[next]);
+        streamFences[next] = nullptr;
+    }
+
+    const char* attributes[nbStreamAttributes] = {
+        reinterpret_cast<const char*>(verticesTmpBuffer.data()),
+        reinterpret_cast<const char*>(normalsTmpBuffer.data()),
+        reinterpret_cast<const char*>(vtexcoords.data()),
+        reinterpret_cast<const char*>(vtangents.data()),
+        reinterpret_cast<const char*>(vbitangents.data())
+    };
+    char* segment = streamPtr + next * streamSegmentSize;
+    for (size_t a = 0; a < nbStreamAttributes; ++a)
+    {
+        ByteRange& range = streamDirtyRanges[next][a];
+        if (!range.empty())
+            std::memcpy(segment + streamAttributeOffsets[a] + range.begin, attributes[a] + range.begin, range.end - range.begin);
+        range = ByteRange();
+    }
+    streamSegment = next;
+}
+
+void OglModel::releaseStreamBuffer()
+{
+    for (GLsync& fence : streamFences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    // deleting the buffer also unmaps it
+    if (vbo > 0)
+    {
+        glDeleteBuffers(1, &vbo);
+        vbo = 0;
+    }
+    streamPtr = nullptr;
+}
+
 void OglModel::updateEdgesIndicesBuffer()
 {
     const VecVisualEdge& edges = this->getEdges();
@@ -984,29 +1194,36 @@ void OglModel::updateBuffers()
 
             //Indices
             //Edges
+            // with persistentMapping, the indices are only uploaded when they were modified
             if(useEdges)
+            {
                 if(oldEdgesSize != edges.size())
                     initEdgesIndicesBuffer();
-                else
+                else if (!usePersistentMapping || oldEdgesCounter != m_edges.getCounter())
                     updateEdgesIndicesBuffer();
+            }
             else if (edges.size() > 0)
                 createEdgesIndicesBuffer();
 
             //Triangles
             if(useTriangles)
+            {
                 if(oldTrianglesSize != triangles.size())
                     initTrianglesIndicesBuffer();
-                else
+                else if (!usePersistentMapping || oldTrianglesCounter != m_triangles.getCounter())
                     updateTrianglesIndicesBuffer();
+            }
             else if (triangles.size() > 0)
                 createTrianglesIndicesBuffer();
 
             //Quads
             if (useQuads)
+            {
                 if(oldQuadsSize != quads.size())
                     initQuadsIndicesBuffer();
-                else
+                else if (!usePersistentMapping || oldQuadsCounter != m_quads.getCounter())
                     updateQuadsIndicesBuffer();
+            }
             else if (quads.size() > 0)
                 createQuadsIndicesBuffer();
         }
@@ -1018,6 +1235,9 @@ void OglModel::updateBuffers()
         oldEdgesSize = edges.size();
         oldTrianglesSize = triangles.size();
         oldQuadsSize = quads.size();
+        oldEdgesCounter = m_edges.getCounter();
+        oldTrianglesCounter = m_triangles.getCounter();
+        oldQuadsCounter = m_quads.getCounter();
     }
 }
 
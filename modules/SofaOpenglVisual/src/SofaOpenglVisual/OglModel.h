@@ -25,6 +25,7 @@
 
 #include <vector>
 #include <string>
+#include <algorithm>
 #include <sofa/gl/template.h>
 #include <sofa/gl/Texture.h>
 #include <sofa/helper/OptionsGroup.h>
@@ -83,11 +84,43 @@ protected:
     Data<sofa::helper::OptionsGroup> destFactor; ///< if alpha blending is enabled this specifies how the red, green, blue, and alpha destination blending factors are computed
     GLenum blendEq, sfactor, dfactor;
 
+    Data<bool> d_persistentMapping; ///< Stream the vertex data through a persistently mapped, triple buffered vertex buffer (requires GL_ARB_buffer_storage)
+
     sofa::gl::Texture *tex; //this texture is used only if a texture name is specified in the scn
     GLuint vbo, iboEdges, iboTriangles, iboQuads;
     bool VBOGenDone, initDone, useEdges, useTriangles, useQuads, canUsePatches;
     size_t oldVerticesSize, oldNormalsSize, oldTexCoordsSize, oldTangentsSize, oldBitangentsSize, oldEdgesSize, oldTrianglesSize, oldQuadsSize;
 
+    /// Range [begin,end) of bytes of a vertex attribute
+    struct ByteRange
+    {
+        size_t begin = 0;
+        size_t end = 0;
+
+        bool empty() const { return begin >= end; }
+        void add(const ByteRange& r)
+        {
+            if (r.empty()) return;
+            if (empty()) *this = r;
+            else { begin = std::min(begin, r.begin); end = std::max(end, r.end); }
+        }
+    };
+
+    /// Persistently mapped vertex buffer (see d_persistentMapping).
+    /// vbo is split in nbStreamSegments segments, each one holding all the vertex attributes. The vertex data
+    /// is written to the segment following the one used by the previous draw, once the fence placed after
+    /// the last draw using it is signaled.
+    static constexpr size_t nbStreamSegments = 3;
+    static constexpr size_t nbStreamAttributes = 5; // positions, normals, texture coordinates, tangents, bitangents
+    bool usePersistentMapping; ///< True if d_persistentMapping is set and supported by the OpenGL driver
+    char* streamPtr; ///< Mapped storage of vbo
+    size_t streamSegmentSize;
+    size_t streamSegment; ///< Segment holding the latest vertex data
+    size_t streamAttributeOffsets[nbStreamAttributes]; ///< Offset of each attribute in a segment
+    GLsync streamFences[nbStreamSegments]; ///< Placed after the last draw reading each segment
+    ByteRange streamDirtyRanges[nbStreamSegments][nbStreamAttributes]; ///< Bytes of each attribute which are outdated in each segment
+    int oldTexCoordsCounter, oldTangentsCounter, oldBitangentsCounter, oldEdgesCounter, oldTrianglesCounter, oldQuadsCounter;
+
     /// These two buffers are used to convert the data field to float type before being sent to
     /// opengl
     std::vector<sofa::defaulttype::Vec3f> verticesTmpBuffer;
@@ -151,6 +184,14 @@ public:
     void updateEdgesIndicesBuffer();
     void updateTrianglesIndicesBuffer();
     void updateQuadsIndicesBuffer();
+
+protected:
+    /// Offset of the latest vertex data in vbo
+    size_t vertexBufferOffset() const { return usePersistentMapping ? streamSegment * streamSegmentSize : 0; }
+
+    void initStreamBuffer();
+    void updateStreamBuffer();
+    void releaseStreamBuffer();
 };
 
 typedef sofa::defaulttype::Vec<3,GLfloat> GLVec3f;
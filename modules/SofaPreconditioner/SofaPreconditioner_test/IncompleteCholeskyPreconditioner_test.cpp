@@ -0,0 +1,204 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaPreconditioner/IncompleteCholeskyPreconditioner.h>
+#include <SofaPreconditioner/IncompleteCholeskyPreconditioner.inl>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest;
+
+#include <cmath>
+#include <functional>
+
+namespace
+{
+
+using namespace sofa::component::linearsolver;
+
+using Matrix = CompressedRowSparseMatrix<double>;
+using Vector = FullVector<double>;
+using Preconditioner = IncompleteCholeskyPreconditioner<Matrix, Vector>;
+
+class IncompleteCholeskyPreconditioner_test : public BaseTest
+{
+public:
+    /// Laplacian of a regular grid of nx*ny nodes (5-point stencil), shifted to be positive definite
+    static void laplacian(Matrix& M, int nx, int ny)
+    {
+        const int n = nx*ny;
+        M.resize(n, n);
+        for (int y=0; y<ny; ++y)
+        {
+            for (int x=0; x<nx; ++x)
+            {
+                const int i = x + nx*y;
+                M.add(i, i, 4.01);
+                if (x > 0)    M.add(i, i-1, -1.0);
+                if (x < nx-1) M.add(i, i+1, -1.0);
+                if (y > 0)    M.add(i, i-nx, -1.0);
+                if (y < ny-1) M.add(i, i+nx, -1.0);
+            }
+        }
+        M.compress();
+    }
+
+    static double dot(const Vector& a, const Vector& b)
+    {
+        double r = 0;
+        for (Vector::Index i=0; i<a.size(); ++i)
+            r += a[i]*b[i];
+        return r;
+    }
+
+    /// Preconditioned conjugate gradient, returns the number of iterations to reduce the residual by the tolerance
+    static int pcg(const Matrix& M, const Vector& b, Vector& x, const std::function<void(Vector&, Vector&)>& precond,
+                   double tolerance = 1e-8, int maxIterations = 10000)
+    {
+        const Vector::Index n = b.size();
+        Vector r(n), z(n), p(n), q(n);
+        x.resize(n);
+        x.clear();
+        for (Vector::Index i=0; i<n; ++i)
+            r[i] = b[i];
+
+        const double bNorm = std::sqrt(dot(b, b));
+        precond(z, r);
+        for (Vector::Index i=0; i<n; ++i)
+            p[i] = z[i];
+        double rz = dot(r, z);
+
+        int it = 0;
+        while (it < maxIterations && std::sqrt(dot(r, r)) > tolerance*bNorm)
+        {
+            M.mul(q, p);
+            const double alpha = rz / dot(p, q);
+            for (Vector::Index i=0; i<n; ++i)
+            {
+                x[i] += alpha*p[i];
+                r[i] -= alpha*q[i];
+            }
+            precond(z, r);
+            const double rzNew = dot(r, z);
+            for (Vector::Index i=0; i<n; ++i)
+                p[i] = z[i] + (rzNew/rz)*p[i];
+            rz = rzNew;
+            ++it;
+        }
+        return it;
+    }
+
+    static void ones(Vector& b, Vector::Index n)
+    {
+        b.resize(n);
+        for (Vector::Index i=0; i<n; ++i)
+            b[i] = 1.0 + 0.5*std::sin(double(i));
+    }
+
+    static int solveWithPreconditioner(Preconditioner* preconditioner, Matrix& M, const Vector& b, Vector& x)
+    {
+        preconditioner->init();
+        preconditioner->invert(M);
+        return pcg(M, b, x, [preconditioner, &M](Vector& z, Vector& r) { preconditioner->solve(M, z, r); });
+    }
+
+    static double residual(const Matrix& M, const Vector& b, const Vector& x)
+    {
+        Vector r(b.size());
+        M.mul(r, x);
+        for (Vector::Index i=0; i<b.size(); ++i)
+            r[i] -= b[i];
+        return std::sqrt(dot(r, r) / dot(b, b));
+    }
+};
+
+TEST_F(IncompleteCholeskyPreconditioner_test, exactOnTridiagonal)
+{
+    // the pattern of the Cholesky factor of a tridiagonal matrix has no fill-in: IC(0) is the exact factorization
+    Matrix M;
+    laplacian(M, 200, 1);
+    Vector b;
+    ones(b, 200);
+
+    auto preconditioner = sofa::core::objectmodel::New<Preconditioner>();
+    preconditioner->init();
+    preconditioner->invert(M);
+
+    Vector x(200);
+    preconditioner->solve(M, x, b);
+    EXPECT_LT(residual(M, b, x), 1e-12);
+}
+
+TEST_F(IncompleteCholeskyPreconditioner_test, reduceIterations)
+{
+    Matrix M;
+    laplacian(M, 40, 40);
+    Vector b;
+    ones(b, M.rowSize());
+
+    Vector xCG;
+    const int nbIterationsCG = pcg(M, b, xCG, [](Vector& z, Vector& r) { z = r; });
+    EXPECT_LT(residual(M, b, xCG), 1e-7);
+
+    auto ic0 = sofa::core::objectmodel::New<Preconditioner>();
+    Vector xIC0;
+    const int nbIterationsIC0 = solveWithPreconditioner(ic0.get(), M, b, xIC0);
+    EXPECT_LT(residual(M, b, xIC0), 1e-7);
+
+    auto ic2 = sofa::core::objectmodel::New<Preconditioner>();
+    ic2->d_fillLevel.setValue(2);
+    Vector xIC2;
+    const int nbIterationsIC2 = solveWithPreconditioner(ic2.get(), M, b, xIC2);
+    EXPECT_LT(residual(M, b, xIC2), 1e-7);
+
+    // IC(0) on the 5-point Laplacian roughly halves the number of iterations, more fill-in reduces it further
+    EXPECT_LT(2*nbIterationsIC0, nbIterationsCG + 10);
+    EXPECT_LT(nbIterationsIC2, nbIterationsIC0);
+}
+
+TEST_F(IncompleteCholeskyPreconditioner_test, multithreading)
+{
+    Matrix M;
+    laplacian(M, 40, 40);
+    Vector b;
+    ones(b, M.rowSize());
+
+    auto sequential = sofa::core::objectmodel::New<Preconditioner>();
+    sequential->init();
+    sequential->invert(M);
+    Vector xSequential(b.size());
+    sequential->solve(M, xSequential, b);
+
+    sofa::simulation::TaskScheduler::getInstance()->init(4);
+    auto parallel = sofa::core::objectmodel::New<Preconditioner>();
+    parallel->d_multithreading.setValue(true);
+    parallel->d_minLevelSize.setValue(1);
+    parallel->init();
+    parallel->invert(M);
+    Vector xParallel(b.size());
+    parallel->solve(M, xParallel, b);
+    sofa::simulation::TaskScheduler::getInstance()->stop();
+
+    for (Vector::Index i=0; i<b.size(); ++i)
+        EXPECT_DOUBLE_EQ(xParallel[i], xSequential[i]);
+}
+
+} // namespace
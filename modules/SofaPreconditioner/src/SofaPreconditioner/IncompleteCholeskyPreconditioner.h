@@ -0,0 +1,113 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_LINEARSOLVER_INCOMPLETECHOLESKYPRECONDITIONER_H
+#define SOFA_COMPONENT_LINEARSOLVER_INCOMPLETECHOLESKYPRECONDITIONER_H
+#include <SofaPreconditioner/config.h>
+
+#include <sofa/core/behavior/LinearSolver.h>
+#include <SofaBaseLinearSolver/MatrixLinearSolver.h>
+#include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
+#include <SofaBaseLinearSolver/FullVector.h>
+#include <sofa/helper/vector.h>
+
+#include <functional>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace linearsolver
+{
+
+/// Linear system preconditioner based on an incomplete Cholesky factorization IC(k) of a symmetric positive definite matrix.
+///
+/// The matrix is approximated by $A \approx L L^T$ where $L$ is restricted to the sparsity pattern of the lower part of $A$,
+/// extended with the fill-in entries of level lower or equal to k. The symbolic analysis (pattern and level schedules) is
+/// only recomputed when the pattern of the matrix changes, so that only the numerical factorization is done at each step.
+/// Rows of a same level do not depend on each other: the factorization and both triangular solves can process them in parallel.
+template<class TMatrix, class TVector, class TThreadManager = NoThreadManager>
+class IncompleteCholeskyPreconditioner : public sofa::component::linearsolver::MatrixLinearSolver<TMatrix,TVector,TThreadManager>
+{
+public:
+    SOFA_CLASS(SOFA_TEMPLATE3(IncompleteCholeskyPreconditioner,TMatrix,TVector,TThreadManager),SOFA_TEMPLATE3(sofa::component::linearsolver::MatrixLinearSolver,TMatrix,TVector,TThreadManager));
+
+    typedef TMatrix Matrix;
+    typedef TVector Vector;
+    typedef typename Matrix::Index Index;
+    typedef TThreadManager ThreadManager;
+    typedef sofa::component::linearsolver::MatrixLinearSolver<TMatrix,TVector,TThreadManager> Inherit;
+
+    Data<int> d_fillLevel; ///< Maximum level of fill-in kept in the factorization (0 keeps the pattern of the matrix)
+    Data<bool> d_multithreading; ///< Process the independent rows of each level in parallel
+    Data<int> d_minLevelSize; ///< Minimum number of rows in a level to process it in parallel
+protected:
+    IncompleteCholeskyPreconditioner();
+public:
+    void init() override;
+    void solve (Matrix& M, Vector& x, Vector& b) override;
+    void invert(Matrix& M) override;
+
+    MatrixInvertData * createInvertData() override
+    {
+        return new IncompleteCholeskyInvertData();
+    }
+
+protected :
+
+    class IncompleteCholeskyInvertData : public MatrixInvertData
+    {
+    public :
+        /// pattern of the matrix used for the last symbolic analysis
+        typename Matrix::VecIndex rowIndex, rowBegin, colsIndex;
+
+        /// lower factor L, stored by rows with sorted columns, the diagonal being the last entry of each row
+        helper::vector<Index> lRowBegin, lColsIndex;
+        helper::vector<double> lValues;
+        /// scalar position of each entry of L in the values of the matrix (-1 for fill-in)
+        helper::vector<Index> lSource;
+
+        /// upper factor L^T, stored by rows as indices in the entries of L (diagonal excluded)
+        helper::vector<Index> uRowBegin, uColsIndex, uEntry;
+
+        /// rows sorted by level for the forward and backward substitutions
+        helper::vector<Index> fwdRows, fwdLevelBegin;
+        helper::vector<Index> bwdRows, bwdLevelBegin;
+    };
+
+    bool patternChanged(IncompleteCholeskyInvertData* data, const Matrix& M) const;
+    void symbolicFactorization(IncompleteCholeskyInvertData* data, const Matrix& M);
+    /// Compute the row i of L, returns false if the pivot was not positive and had to be replaced
+    bool numericFactorizationRow(IncompleteCholeskyInvertData* data, const Matrix& M, Index i) const;
+
+    /// Apply f on each row of each level, the levels being processed in sequence
+    void forEachLevel(const helper::vector<Index>& rows, const helper::vector<Index>& levelBegin, const std::function<void(Index)>& f);
+};
+
+} // namespace linearsolver
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
@@ -0,0 +1,353 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#ifndef SOFA_COMPONENT_LINEARSOLVER_INCOMPLETECHOLESKYPRECONDITIONER_INL
+#define SOFA_COMPONENT_LINEARSOLVER_INCOMPLETECHOLESKYPRECONDITIONER_INL
+#include <SofaPreconditioner/IncompleteCholeskyPreconditioner.h>
+#include <sofa/simulation/ParallelForRange.h>
+#include <sofa/helper/AdvancedTimer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <map>
+
+namespace sofa
+{
+
+namespace component
+{
+
+namespace linearsolver
+{
+
+namespace incompletecholesky
+{
+
+/// Sort the rows by level, given the level of each row
+template<class Index>
+void sortByLevel(const helper::vector<Index>& level, helper::vector<Index>& rows, helper::vector<Index>& levelBegin)
+{
+    const Index n = Index(level.size());
+    Index nbLevels = 0;
+    for (Index i=0; i<n; ++i)
+        nbLevels = std::max(nbLevels, level[i]+1);
+
+    levelBegin.assign(nbLevels+1, 0);
+    for (Index i=0; i<n; ++i)
+        ++levelBegin[level[i]+1];
+    for (Index l=0; l<nbLevels; ++l)
+        levelBegin[l+1] += levelBegin[l];
+
+    rows.resize(n);
+    helper::vector<Index> pos(levelBegin.begin(), levelBegin.end()-1);
+    for (Index i=0; i<n; ++i)
+        rows[pos[level[i]]++] = i;
+}
+
+} // namespace incompletecholesky
+
+template<class TMatrix, class TVector, class TThreadManager>
+IncompleteCholeskyPreconditioner<TMatrix,TVector,TThreadManager>::IncompleteCholeskyPreconditioner()
+    : d_fillLevel( initData(&d_fillLevel,0,"fillLevel","Maximum level of fill-in kept in the factorization (0 keeps the pattern of the matrix)") )
+    , d_multithreading( initData(&d_multithreading,false,"multithreading","Process the independent rows of each level in parallel") )
+    , d_minLevelSize( initData(&d_minLevelSize,256,"minLevelSize","Minimum number of rows in a level to process it in parallel") )
+{
+}
+
+template<class TMatrix, class TVector, class TThreadManager>
+void IncompleteCholeskyPreconditioner<TMatrix,TVector,TThreadManager>::init()
+{
+    Inherit::init();
+    if (d_fillLevel.getValue() < 0)
+    {
+        msg_warning() << "Negative fillLevel, using 0 instead.";
+        d_fillLevel.setValue(0);
+    }
+    if (d_multithreading.getValue())
+        simulation::initTaskScheduler();
+}
+
+template<class TMatrix, class TVector, class TThreadManager>
+void IncompleteCholeskyPreconditioner<TMatrix,TVector,TThreadManager>::forEachLevel(const helper::vector<Index>& rows, const helper::vector<Index>& levelBegin, const std::function<void(Index)>& f)
+{
+    const Index nbLevels = Index(levelBegin.size()) - 1;
+    simulation::TaskScheduler* taskScheduler = d_multithreading.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    const Index minLevelSize = std::max(1, d_minLevelSize.getValue());
+
+    for (Index l=0; l<nbLevels; ++l)
+    {
+        const Index begin = levelBegin[l];
+        const Index end = levelBegin[l+1];
+        simulation::parallelForRange(end - begin < minLevelSize ? nullptr : taskScheduler, begin, end, 1,
+            [&rows, &f](std::size_t rangeBegin, std::size_t rangeEnd)
+        {
+            for (std::size_t r=rangeBegin; r<rangeEnd; ++r)
+                f(rows[r]);
+        });
+    }
+}
+
+template<class TMatrix, class TVector, class TThreadManager>
+bool IncompleteCholeskyPreconditioner<TMatrix,TVector,TThreadManager>::patternChanged(IncompleteCholeskyInvertData* data, const Matrix& M) const
+{
+    return data->lRowBegin.size() != std::size_t(M.rowSize()+1)
+        || data->rowIndex != M.getRowIndex()
+        || data->rowBegin != M.getRowBegin()
+        || data->colsIndex != M.getColsIndex();
+}
+
+template<class TMatrix, class TVector, class TThreadManager>
+void IncompleteCholeskyPreconditioner<TMatrix,TVector,TThreadManager>::symbolicFactorization(IncompleteCholeskyInvertData* data, const Matrix& M)
+{
+    enum { NL = Matrix::NL, NC = Matrix::NC };
+    const Index n = M.rowSize();
+    const typename Matrix::VecIndex& rowIndex = M.getRowIndex();
+    const typename Matrix::VecIndex& rowBegin = M.getRowBegin();
+    const typename Matrix::VecIndex& colsIndex = M.getColsIndex();
+
+    data->rowIndex = rowIndex;
+    data->rowBegin = rowBegin;
+    data->colsIndex = colsIndex;
+
+    // lower part of the matrix, by scalar rows: column -> scalar position in the values of the matrix
+    helper::vector< std::map<Index,Index> > source(n);
+    for (std::size_t xi = 0; xi < rowIndex.size(); ++xi)
+    {
+        const Index bi = rowIndex[xi];
+        for (Index k = Index(rowBegin[xi]); k < Index(rowBegin[xi+1]); ++k)
+        {
+            const Index bj = colsIndex[k];
+            if (bj*NC > bi*NL + NL-1) break;
+            for (Index li = 0; li < NL; ++li)
+            {
+                const Index i = bi*NL + li;
+                if (i >= n) break;
+                for (Index lj = 0; lj < NC; ++lj)
+                {
+                    const Index j = bj*NC + lj;
+                    if (j > i) break;
+                    source[i][j] = k*NL*NC + li*NC + lj;
+                }
+            }
+        }
+    }
+
+    // level of fill symbolic factorization
+    const int fillLevel = d_fillLevel.getValue();
+    helper::vector< helper::vector< std::pair<Index,int> > > lCols(n); // rows of each column of L, with their level
+    data->lRowBegin.resize(n+1);
+    data->lColsIndex.clear();
+    data->lSource.clear();
+    for (Index i = 0; i < n; ++i)
+    {
+        std::map<Index,int> row;
+        for (const auto& e : source[i])
+            row[e.first] = 0;
+        row[i] = 0; // the diagonal is always kept
+
+        if (fillLevel > 0)
+        {
+            // entries inserted during the loop have a column greater than k, they are visited later on
+            for (auto it = row.begin(); it->first < i; ++it)
+            {
+                const Index k = it->first;
+                const int levelIK = it->second;
+                if (levelIK >= fillLevel) continue;
+                for (const auto& c : lCols[k])
+                {
+                    const int level = levelIK + c.second + 1;
+                    if (level > fillLevel) continue;
+                    auto inserted = row.insert(std::make_pair(c.first, level));
+                    if (!inserted.second && inserted.first->second > level)
+                        inserted.first->second = level;
+                }
+            }
+        }
+
+        data->lRowBegin[i] = Index(data->lColsIndex.size());
+        for (const auto& e : row)
+        {
+            const Index j = e.first;
+            auto src = source[i].find(j);
+            data->lColsIndex.push_back(j);
+            data->lSource.push_back(src != source[i].end() ? src->second : -1);
+            if (j < i)
+                lCols[j].push_back(std::make_pair(i, e.second));
+        }
+    }
+    data->lRowBegin[n] = Index(data->lColsIndex.size());
+    data->lValues.resize(data->lColsIndex.size());
+
+    // transposed pattern and levels of the forward substitution
+    helper::vector<Index> level(n, 0);
+    data->uRowBegin.assign(n+1, 0);
+    for (Index i = 0; i < n; ++i)
+    {
+        for (Index p = data->lRowBegin[i]; p < data->lRowBegin[i+1]-1; ++p)
+        {
+            const Index j = data->lColsIndex[p];
+            ++data->uRowBegin[j+1];
+            level[i] = std::max(level[i], level[j]+1);
+        }
+    }
+    incompletecholesky::sortByLevel(level, data->fwdRows, data->fwdLevelBegin);
+
+    for (Index i = 0; i < n; ++i)
+        data->uRowBegin[i+1] += data->uRowBegin[i];
+    data->uColsIndex.resize(data->uRowBegin[n]);
+    data->uEntry.resize(data->uRowBegin[n]);
+    helper::vector<Index> pos(data->uRowBegin.begin(), data->uRowBegin.end()-1);
+    for (Index i = 0; i < n; ++i)
+    {
+        for (Index p = data->lRowBegin[i]; p < data->lRowBegin[i+1]-1; ++p)
+        {
+            const Index q = pos[data->lColsIndex[p]]++;
+            data->uColsIndex[q] = i;
+            data->uEntry[q] = p;
+        }
+    }
+
+    // levels of the backward substitution
+    level.assign(n, 0);
+    for (Index i = n-1; i >= 0; --i)
+        for (Index q = data->uRowBegin[i]; q < data->uRowBegin[i+1]; ++q)
+            level[i] = std::max(level[i], level[data->uColsIndex[q]]+1);
+    incompletecholesky::sortByLevel(level, data->bwdRows, data->bwdLevelBegin);
+
+    msg_info() << "Symbolic factorization: " << n << " rows, " << data->lColsIndex.size() << " entries in L ("
+               << (std::count_if(data->lSource.begin(), data->lSource.end(), [](Index s){ return s < 0; }))
+               << " fill-in), " << (data->fwdLevelBegin.size()-1) << " forward and " << (data->bwdLevelBegin.size()-1) << " backward levels";
+}
+
+template<class TMatrix, class TVector, class TThreadManager>
+bool IncompleteCholeskyPreconditioner<TMatrix,TVector,TThreadManager>::numericFactorizationRow(IncompleteCholeskyInvertData* data, const Matrix& M, Index i) const
+{
+    enum { NL = Matrix::NL, NC = Matrix::NC };
+    typedef typename Matrix::traits traits;
+    const typename Matrix::VecBloc& colsValue = M.getColsValue();
+    const helper::vector<Index>& lColsIndex = data->lColsIndex;
+    helper::vector<double>& lValues = data->lValues;
+
+    auto matrixValue = [&](Index p) -> double
+    {
+        const Index s = data->lSource[p];
+        if (s < 0) return 0.0;
+        const Index r = s % (NL*NC);
+        return (double)traits::v(colsValue[s / (NL*NC)], r / NC, r % NC);
+    };
+
+    const Index begin = data->lRowBegin[i];
+    const Index diag = data->lRowBegin[i+1]-1;
+    double sumSq = 0.0;
+    for (Index p = begin; p < diag; ++p)
+    {
+        const Index j = lColsIndex[p];
+        double s = matrixValue(p);
+        // sparse dot product of the rows i and j on the columns lower than j
+        Index q1 = begin;
+        Index q2 = data->lRowBegin[j];
+        const Index diagJ = data->lRowBegin[j+1]-1;
+        while (q1 < p && q2 < diagJ)
+        {
+            const Index c1 = lColsIndex[q1];
+            const Index c2 = lColsIndex[q2];
+            if (c1 == c2) s -= lValues[q1++] * lValues[q2++];
+            else if (c1 < c2) ++q1;
+            else ++q2;
+        }
+        lValues[p] = s / lValues[diagJ];
+        sumSq += lValues[p] * lValues[p];
+    }
+
+    const double a = matrixValue(diag);
+    const double pivot = a - sumSq;
+    if (pivot > 0)
+    {
+        lValues[diag] = std::sqrt(pivot);
+        return true;
+    }
+    // breakdown of the incomplete factorization: fall back to the diagonal of the matrix
+    lValues[diag] = (a != 0) ? std::sqrt(std::fabs(a)) : 1.0;
+    return false;
+}
+
+template<class TMatrix, class TVector, class TThreadManager>
+void IncompleteCholeskyPreconditioner<TMatrix,TVector,TThreadManager>::invert(Matrix& M)
+{
+    IncompleteCholeskyInvertData * data = (IncompleteCholeskyInvertData *) this->getMatrixInvertData(&M);
+
+    M.compress();
+    if (patternChanged(data, M))
+    {
+        sofa::helper::ScopedAdvancedTimer timer("IncompleteCholeskySymbolic");
+        symbolicFactorization(data, M);
+    }
+
+    sofa::helper::ScopedAdvancedTimer timer("IncompleteCholeskyNumeric");
+    std::atomic<unsigned int> nbBadPivots(0);
+    forEachLevel(data->fwdRows, data->fwdLevelBegin, [&](Index i)
+    {
+        if (!numericFactorizationRow(data, M, i))
+            ++nbBadPivots;
+    });
+
+    if (nbBadPivots > 0)
+        msg_warning() << nbBadPivots << " non positive pivots replaced by the diagonal of the matrix, the matrix may not be positive definite.";
+}
+
+// solve L * L^T * z = r
+template<class TMatrix, class TVector, class TThreadManager>
+void IncompleteCholeskyPreconditioner<TMatrix,TVector,TThreadManager>::solve (Matrix& M, Vector& z, Vector& r)
+{
+    IncompleteCholeskyInvertData * data = (IncompleteCholeskyInvertData *) this->getMatrixInvertData(&M);
+    const helper::vector<Index>& lRowBegin = data->lRowBegin;
+    const helper::vector<Index>& lColsIndex = data->lColsIndex;
+    const helper::vector<double>& lValues = data->lValues;
+
+    //Solve L * t = r
+    forEachLevel(data->fwdRows, data->fwdLevelBegin, [&](Index i)
+    {
+        const Index diag = lRowBegin[i+1]-1;
+        double temp = r[i];
+        for (Index p = lRowBegin[i]; p < diag; ++p)
+            temp -= lValues[p] * z[lColsIndex[p]];
+        z[i] = temp / lValues[diag];
+    });
+
+    //Solve L^T * z = t
+    // we can reuse z because all values that we read are updated
+    forEachLevel(data->bwdRows, data->bwdLevelBegin, [&](Index i)
+    {
+        double temp = z[i];
+        for (Index q = data->uRowBegin[i]; q < data->uRowBegin[i+1]; ++q)
+            temp -= lValues[data->uEntry[q]] * z[data->uColsIndex[q]];
+        z[i] = temp / lValues[lRowBegin[i+1]-1];
+    });
+}
+
+} // namespace linearsolver
+
+} // namespace component
+
+} // namespace sofa
+
+#endif
@@ -0,0 +1,148 @@
+/******************************************************************************
+*                 SOFA, Simulation Open-Framework Architecture                *
+*                    (c) 2006 INRIA, USTL, UJF, CNRS, MGH                     *
+*                                                                             *
+* This program is free software; you can redistribute it and/or modify it     *
+* under the terms of the GNU Lesser General Public License as published by    *
+* the Free Software Foundation; either version 2.1 of the License, or (at     *
+* your option) any later version.                                             *
+*                                                                             *
+* This program is distributed in the hope that it will be useful, but WITHOUT *
+* ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or       *
+* FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public License *
+* for more details.                                                           *
+*                                                                             *
+* You should have received a copy of the GNU Lesser General Public License    *
+* along with this program. If not, see <http://www.gnu.org/licenses/>.        *
+*******************************************************************************
+* Authors: The SOFA Team and external contributors (see Authors.txt)          *
+*                                                                             *
+* Contact information: contact@sofa-framework.org                             *
+******************************************************************************/
+#include <SofaSparseSolver/SparseLDLSolver.h>
+#include <SofaBaseLinearSolver/FullMatrix.h>
+#include <SofaBaseLinearSolver/SparseMatrix.h>
+#include <sofa/simulation/TaskScheduler.h>
+
+#include <sofa/testing/BaseTest.h>
+using sofa::testing::BaseTest;
+
+namespace
+{
+
+using namespace sofa::component::linearsolver;
+using Matrix = CompressedRowSparseMatrix<double>;
+using Vector = FullVector<double>;
+using Solver = SparseLDLSolver<Matrix, Vector>;
+
+struct SparseLDLSolver_test : public BaseTest
+{
+    void onTearDown() override
+    {
+        sofa::simulation::TaskScheduler::getInstance()->stop();
+    }
+
+    /// Laplacian of a n x n grid, shifted to be positive definite. Its fill-reducing ordering is not the identity.
+    static void gridLaplacian(Matrix& M, int n)
+    {
+        M.resize(n*n, n*n);
+        for (int y=0; y<n; ++y)
+            for (int x=0; x<n; ++x)
+            {
+                const int i = x + n*y;
+                M.add(i, i, 4.5);
+                if (x > 0)   M.add(i, i-1, -1.0);
+                if (x < n-1) M.add(i, i+1, -1.0);
+                if (y > 0)   M.add(i, i-n, -1.0);
+                if (y < n-1) M.add(i, i+n, -1.0);
+            }
+        M.compress();
+    }
+
+    /// Pseudo-random constraint lines of a few non-zeros, the line skip being empty
+    static void constraintLines(SparseMatrix<double>& J, int nbLines, int n, int skip)
+    {
+        J.resize(nbLines, n);
+        unsigned int seed = 12345;
+        const auto next = [&seed]() { seed = seed * 1103515245u + 12345u; return (seed >> 8); };
+        for (int l=0; l<nbLines; ++l)
+        {
+            if (l == skip) continue;
+            for (int k=0; k<3; ++k)
+                J.add(l, int(next() % n), 1.0 + double(next() % 100) / 50.0);
+        }
+    }
+
+    /// J.A^-1.J^T computed line by line with the solve of the factorization
+    static void denseProduct(Solver* solver, Matrix& M, const SparseMatrix<double>& J, double fact, FullMatrix<double>& result)
+    {
+        const int nbLines = J.rowSize();
+        const int n = M.rowSize();
+        result.resize(nbLines, nbLines);
+        Vector b(n), x(n);
+        for (int l=0; l<nbLines; ++l)
+        {
+            for (int i=0; i<n; ++i) b[i] = J.element(l, i);
+            solver->solve(M, x, b);
+            for (int k=0; k<nbLines; ++k)
+            {
+                double acc = 0;
+                for (int i=0; i<n; ++i) acc += J.element(k, i) * x[i];
+                result.set(k, l, fact * acc);
+            }
+        }
+    }
+
+    static void checkProduct(bool parallel)
+    {
+        Matrix M;
+        gridLaplacian(M, 12);
+
+        auto solver = sofa::core::objectmodel::New<Solver>();
+        solver->d_parallelInverseProduct.setValue(parallel);
+        solver->init();
+        solver->invert(M);
+
+        const auto* data = static_cast<Solver::InvertData*>(solver->getMatrixInvertData(&M));
+        int nbPermuted = 0;
+        for (int i=0; i<data->n; ++i)
+            if (data->invperm[i] != i) ++nbPermuted;
+        ASSERT_GT(nbPermuted, 0);
+
+        // several products with the same factorization, the number of lines growing and shrinking
+        for (int nbLines : { 30, 60, 10 })
+        {
+            SparseMatrix<double> J;
+            constraintLines(J, nbLines, M.rowSize(), nbLines / 3);
+
+            FullMatrix<double> result, expected;
+            result.resize(nbLines, nbLines);
+            ASSERT_TRUE(solver->addJMInvJtLocal(&M, &result, &J, 0.5));
+            denseProduct(solver.get(), M, J, 0.5, expected);
+
+            double maxValue = 0;
+            for (int i=0; i<nbLines; ++i)
+                for (int j=0; j<nbLines; ++j)
+                    maxValue = std::max(maxValue, std::abs(expected.element(i, j)));
+            ASSERT_GT(maxValue, 0);
+
+            for (int i=0; i<nbLines; ++i)
+                for (int j=0; j<nbLines; ++j)
+                    EXPECT_NEAR(result.element(i, j), expected.element(i, j), 1e-12 * maxValue)
+                        << "nbLines " << nbLines << " (" << i << ", " << j << ")";
+        }
+    }
+};
+
+TEST_F(SparseLDLSolver_test, inverseProduct)
+{
+    checkProduct(false);
+}
+
+TEST_F(SparseLDLSolver_test, parallelInverseProduct)
+{
+    sofa::simulation::TaskScheduler::getInstance()->init(4);
+    checkProduct(true);
+}
+
+} // namespace
@@ -30,6 +30,7 @@
 #include <SofaBaseLinearSolver/CompressedRowSparseMatrix.h>
 #include <sofa/helper/map.h>
 #include <cmath>
+#include <functional>
 #include <SofaSparseSolver/SparseLDLSolverImpl.h>
 #include <sofa/defaulttype/BaseMatrix.h>
 #include <sofa/core/objectmodel/DataFileName.h>
@@ -58,14 +59,19 @@ public :
     typedef typename Inherit::JMatrixType JMatrixType;
     typedef SparseLDLImplInvertData<helper::vector<int>, helper::vector<Real> > InvertData;
 
+    void init() override;
     void solve (Matrix& M, Vector& x, Vector& b) override;
     void invert(Matrix& M) override;
+
+    /// Computes J.A^-1.J^T for all the lines of J at once: each line is solved on the reach of its non-zeros in the
+    /// elimination tree only, and the products only involve these reaches.
     bool addJMInvJtLocal(TMatrix * M, ResMatrixType * result,const JMatrixType * J, double fact) override;
     int numStep;
 
     Data<bool> f_saveMatrixToFile;      ///< save matrix to a text file (can be very slow, as full matrix is stored)
     sofa::core::objectmodel::DataFileName d_filename;   ///< file where this matrix will be saved
     Data<int> d_precision;      ///< number of digits used to save system's matrix, default is 6
+    Data<bool> d_parallelInverseProduct; ///< Solve the lines of J and compute the blocks of J.A^-1.J^T in parallel
 
     MatrixInvertData * createInvertData() override {
         return new InvertData();
@@ -74,7 +80,12 @@ public :
 protected :
     SparseLDLSolver();
 
-    FullMatrix<Real> Jminv,Jdense;
+    /// Process the lines [0,nbLines) of J, concurrently if d_parallelInverseProduct is set, f being called on contiguous ranges
+    void forEachLine(int nbLines, const std::function<void(int,int)>& f);
+
+    FullMatrix<Real> Jdense;
+    helper::vector< helper::vector<int> > Jreach; ///< for each line of J, the sorted non-zero columns of L^-1.J^T
+    helper::vector<Real> JMinvJtBuffer; ///< upper triangle of J.A^-1.J^T, kept between the calls to avoid reallocating nbLines^2 values
     sofa::component::linearsolver::CompressedRowSparseMatrix<Real> Mfiltered;
 };
 
@@ -31,6 +31,8 @@
 #include <cmath>
 #include <sofa/helper/system/thread/CTime.h>
 #include <SofaBaseLinearSolver/CompressedRowSparseMatrix.inl>
+#include <sofa/simulation/ParallelForRange.h>
+#include <algorithm>
 #include <fstream>
 #include <iomanip>      // std::setprecision
 #include <string>
@@ -47,8 +49,17 @@ SparseLDLSolver<TMatrix,TVector,TThreadManager>::SparseLDLSolver()
     , f_saveMatrixToFile( initData(&f_saveMatrixToFile, false, "savingMatrixToFile", "save matrix to a text file (can be very slow, as full matrix is stored"))
     , d_filename( initData(&d_filename, std::string("MatrixInLDL_%04d.txt"),"savingFilename", "Name of file where system matrix (mass, stiffness and damping) will be stored."))
     , d_precision( initData(&d_precision, 6, "savingPrecision", "Number of digits used to store system's matrix. Default is 6."))
+    , d_parallelInverseProduct( initData(&d_parallelInverseProduct, false, "parallelInverseProduct", "Solve the lines of J and compute the blocks of J.A^-1.J^T in parallel"))
 {}
 
+template<class TMatrix, class TVector, class TThreadManager>
+void SparseLDLSolver<TMatrix,TVector,TThreadManager>::init()
+{
+    Inherit::init();
+    if (d_parallelInverseProduct.getValue())
+        simulation::initTaskScheduler();
+}
+
 template<class TMatrix, class TVector, class TThreadManager>
 void SparseLDLSolver<TMatrix,TVector,TThreadManager>::solve (Matrix& M, Vector& z, Vector& r) {
     Inherit::solve_cpu(&z[0],&r[0],(InvertData *) this->getMatrixInvertData(&M));
@@ -91,16 +102,34 @@ void SparseLDLSolver<TMatrix,TVector,TThreadManager>::invert(Matrix& M) {
     numStep++;
 }
 
-/// Default implementation of Multiply the inverse of the system matrix by the transpose of the given matrix, and multiply the result with the given matrix J
+template<class TMatrix, class TVector, class TThreadManager>
+void SparseLDLSolver<TMatrix,TVector,TThreadManager>::forEachLine(int nbLines, const std::function<void(int,int)>& f)
+{
+    simulation::TaskScheduler* taskScheduler = d_parallelInverseProduct.getValue() ? simulation::TaskScheduler::getInstance() : nullptr;
+    simulation::parallelForRange(taskScheduler, 0, std::size_t(nbLines), 1, [&f](std::size_t begin, std::size_t end)
+    {
+        f(int(begin), int(end));
+    });
+}
+
+/// Multiply the inverse of the system matrix by the transpose of the given matrix, and multiply the result with the given matrix J
 template<class TMatrix, class TVector, class TThreadManager>
 bool SparseLDLSolver<TMatrix,TVector,TThreadManager>::addJMInvJtLocal(TMatrix * M, ResMatrixType * result,const JMatrixType * J, double fact) {
     if (J->rowSize()==0) return true;
 
     InvertData * data = (InvertData *) this->getMatrixInvertData(M);
+    const int nbLines = J->rowSize();
+    const int * parent = data->Parent.data();
+    const int * L_colptr = data->L_colptr.data();
+    const int * L_rowind = data->L_rowind.data();
+    const Real * L_values = data->L_values.data();
+    const Real * invD = data->invD.data();
 
     Jdense.clear();
-    Jdense.resize(J->rowSize(),data->n);
-    Jminv.resize(J->rowSize(),data->n);
+    Jdense.resize(nbLines,data->n);
+    Jreach.resize(nbLines);
+
+    for (int l=0; l<nbLines; l++) Jreach[l].clear();
 
     for (typename SparseMatrix<Real>::LineConstIterator jit = J->begin() , jitend = J->end(); jit != jitend; ++jit) {
         int l = jit->first;
@@ -110,40 +139,70 @@ bool SparseLDLSolver<TMatrix,TVector,TThreadManager>::addJMInvJtLocal(TMatrix *
             double val = it->second;
 
             line[col] = val;
+            Jreach[l].push_back(col);
         }
     }
 
-    //Solve the lower triangular system
-    for (unsigned c=0;c<(unsigned)J->rowSize();c++) {
-        Real * line = Jdense[c];
-
-        for (int j=0; j<data->n; j++) {
-            for (int p = data->LT_colptr[j] ; p<data->LT_colptr[j+1] ; p++) {
-                int col = data->LT_rowind[p];
-                double val = data->LT_values[p];
-                line[j] -= val * line[col];
+    //Solve the lower triangular system, one right hand side per line of J.
+    //The non-zeros of L^-1.b are the ancestors of the non-zeros of b in the elimination tree, which are
+    //processed in increasing order as the parent of a column is always after it.
+    forEachLine(nbLines, [&](int begin, int end) {
+        helper::vector<int> visited(data->n, -1);
+        helper::vector<int> reach;
+        for (int c=begin; c<end; c++) {
+            if (Jreach[c].empty()) continue;
+
+            reach.clear();
+            for (int k : Jreach[c]) {
+                for (int i=k; i!=-1 && visited[i]!=c; i=parent[i]) {
+                    visited[i] = c;
+                    reach.push_back(i);
+                }
+            }
+            std::sort(reach.begin(), reach.end());
+
+            Real * line = Jdense[c];
+            for (int j : reach) {
+                const Real xj = line[j];
+                if (xj == 0) continue;
+                for (int p = L_colptr[j] ; p<L_colptr[j+1] ; p++) {
+                    line[L_rowind[p]] -= L_values[p] * xj;
+                }
             }
+            Jreach[c].swap(reach);
         }
-    }
-
-    //apply diagonal
-    for (unsigned j=0; j<(unsigned)J->rowSize(); j++) {
-        Real * lineD = Jdense[j];
-        Real * lineM = Jminv[j];
-        for (unsigned i=0;i<(unsigned)J->colSize();i++) {
-            lineM[i] = lineD[i] * data->invD[i];
+    });
+
+    //apply diagonal and compute the upper triangular part of J.A^-1.J^T
+    helper::vector<Real>& JMinvJt = JMinvJtBuffer;
+    JMinvJt.assign(std::size_t(nbLines) * nbLines, (Real)0);
+    forEachLine(nbLines, [&](int begin, int end) {
+        helper::vector<Real> lineM(data->n);
+        for (int j=begin; j<end; j++) {
+            const helper::vector<int>& reach = Jreach[j];
+            if (reach.empty()) continue;
+
+            const Real * lineD = Jdense[j];
+            for (int k : reach) lineM[k] = lineD[k] * invD[k];
+
+            for (int i=j; i<nbLines; i++) {
+                if (Jreach[i].empty()) continue;
+                const Real * lineI = Jdense[i];
+
+                double acc = 0.0;
+                for (int k : reach) {
+                    acc += lineM[k] * lineI[k];
+                }
+                JMinvJt[std::size_t(j) * nbLines + i] = acc;
+            }
         }
-    }
+    });
 
-    for (unsigned j=0; j<(unsigned)J->rowSize(); j++) {
-        Real * lineJ = Jminv[j];
-        for (unsigned i=j;i<(unsigned)J->rowSize();i++) {
-            Real * lineI = Jdense[i];
-
-            double acc = 0.0;
-            for (unsigned k=0;k<(unsigned)J->colSize();k++) {
-                acc += lineJ[k] * lineI[k];
-            }
+    for (int j=0; j<nbLines; j++) {
+        if (Jreach[j].empty()) continue;
+        for (int i=j; i<nbLines; i++) {
+            if (Jreach[i].empty()) continue;
+            const double acc = JMinvJt[std::size_t(j) * nbLines + i];
             result->add(j,i,acc*fact);
             if(i!=j) result->add(i,j,acc*fact);
         }